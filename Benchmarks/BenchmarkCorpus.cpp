@@ -0,0 +1,275 @@
+#include "BenchmarkCorpus.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <numbers>
+#include <string>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace KryneTools::BenchmarkCorpus
+{
+    namespace
+    {
+        constexpr f32 kTerrainSize = 100.f;
+        constexpr f32 kTwoPi = 2.f * std::numbers::pi_v<f32>;
+
+        u32 Mix(u32 _x, u32 _y, u32 _seed)
+        {
+            u32 h = _x * 0x8da6b343u ^ _y * 0xd8163841u ^ _seed * 0xcb1ab31fu;
+            h ^= h >> 16;
+            h *= 0x7feb352du;
+            h ^= h >> 15;
+            h *= 0x846ca68bu;
+            return h ^ (h >> 16);
+        }
+
+        /// Height and its gradient at normalized coordinates.
+        f32 GetHeight(f32 _u, f32 _v, f32& _du, f32& _dv)
+        {
+            const f32 a = kTwoPi * 3.f * _u;
+            const f32 b = kTwoPi * 2.f * _v;
+            const f32 c = kTwoPi * 17.f * (_u + _v);
+            _du = 8.f * kTwoPi * 3.f * std::cos(a) * std::cos(b) + 0.5f * kTwoPi * 17.f * std::cos(c);
+            _dv = -8.f * kTwoPi * 2.f * std::sin(a) * std::sin(b) + 0.5f * kTwoPi * 17.f * std::cos(c);
+            return 8.f * std::sin(a) * std::cos(b) + 0.5f * std::sin(c);
+        }
+
+        std::filesystem::path CreateDirectory()
+        {
+#if defined(_WIN32)
+            const int pid = _getpid();
+#else
+            const int pid = int(getpid());
+#endif
+            std::filesystem::path directory = std::filesystem::temp_directory_path() / FormatString("kryne-bench-%d", pid);
+            std::filesystem::remove_all(directory);
+            std::filesystem::create_directories(directory);
+            return directory;
+        }
+
+        struct CorpusDirectory
+        {
+            std::filesystem::path m_path = CreateDirectory();
+
+            ~CorpusDirectory()
+            {
+                std::error_code error;
+                std::filesystem::remove_all(m_path, error);
+            }
+        };
+
+        template <class T>
+        void Append(std::vector<u8>& _buffer, const std::vector<T>& _values)
+        {
+            const u64 offset = _buffer.size();
+            _buffer.resize(offset + _values.size() * sizeof(T));
+            std::memcpy(_buffer.data() + offset, _values.data(), _values.size() * sizeof(T));
+        }
+    }
+
+    JobSystem& GetJobSystem()
+    {
+        static JobSystem jobSystem;
+        return jobSystem;
+    }
+
+    const std::filesystem::path& GetDirectory()
+    {
+        static const CorpusDirectory directory;
+        return directory.m_path;
+    }
+
+    Terrain MakeTerrain(u32 _resolution)
+    {
+        Terrain terrain;
+        const u32 side = _resolution + 1;
+        terrain.m_positions.reserve(u64(side) * side);
+        terrain.m_normals.reserve(u64(side) * side);
+        terrain.m_uvs.reserve(u64(side) * side);
+        for (u32 z = 0; z < side; z++)
+        {
+            for (u32 x = 0; x < side; x++)
+            {
+                const f32 u = f32(x) / f32(_resolution);
+                const f32 v = f32(z) / f32(_resolution);
+                f32 du = 0.f;
+                f32 dv = 0.f;
+                const f32 height = GetHeight(u, v, du, dv);
+                terrain.m_positions.push_back({ u * kTerrainSize, height, v * kTerrainSize });
+                terrain.m_normals.push_back(Normalize({ -du / kTerrainSize, 1.f, -dv / kTerrainSize }));
+                terrain.m_uvs.push_back({ u, v });
+            }
+        }
+
+        terrain.m_indices.reserve(u64(_resolution) * _resolution * 6);
+        for (u32 z = 0; z < _resolution; z++)
+        {
+            for (u32 x = 0; x < _resolution; x++)
+            {
+                const u32 i = z * side + x;
+                terrain.m_indices.insert(terrain.m_indices.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+            }
+        }
+        return terrain;
+    }
+
+    std::filesystem::path WriteTerrainGltf(u32 _resolution)
+    {
+        const std::filesystem::path path = GetDirectory() / FormatString("terrain%u.gltf", _resolution);
+        if (std::filesystem::exists(path))
+        {
+            return path;
+        }
+
+        const Terrain terrain = MakeTerrain(_resolution);
+        Aabb bounds;
+        for (const Float3& position: terrain.m_positions)
+        {
+            bounds.Expand(position);
+        }
+
+        std::vector<u8> buffer;
+        Append(buffer, terrain.m_positions);
+        Append(buffer, terrain.m_normals);
+        Append(buffer, terrain.m_uvs);
+        Append(buffer, terrain.m_indices);
+
+        const u64 vertexCount = terrain.m_positions.size();
+        const u64 normalOffset = vertexCount * sizeof(Float3);
+        const u64 uvOffset = normalOffset * 2;
+        const u64 indexOffset = uvOffset + vertexCount * sizeof(Float2);
+        const std::string binName = path.stem().string() + ".bin";
+        FileSystem::WriteFile(GetDirectory() / binName, buffer);
+
+        const std::string json = FormatString(
+            R"({"asset":{"version":"2.0"},)"
+            R"("buffers":[{"uri":"%s","byteLength":%llu}],)"
+            R"("bufferViews":[{"buffer":0,"byteOffset":0,"byteLength":%llu},{"buffer":0,"byteOffset":%llu,"byteLength":%llu},)"
+            R"({"buffer":0,"byteOffset":%llu,"byteLength":%llu},{"buffer":0,"byteOffset":%llu,"byteLength":%llu}],)"
+            R"("accessors":[{"bufferView":0,"componentType":5126,"count":%llu,"type":"VEC3","min":[%.9g,%.9g,%.9g],"max":[%.9g,%.9g,%.9g]},)"
+            R"({"bufferView":1,"componentType":5126,"count":%llu,"type":"VEC3"},)"
+            R"({"bufferView":2,"componentType":5126,"count":%llu,"type":"VEC2"},)"
+            R"({"bufferView":3,"componentType":5125,"count":%llu,"type":"SCALAR"}],)"
+            R"("meshes":[{"name":"Terrain","primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":3}]}]})",
+            binName.c_str(),
+            static_cast<unsigned long long>(buffer.size()),
+            static_cast<unsigned long long>(normalOffset),
+            static_cast<unsigned long long>(normalOffset),
+            static_cast<unsigned long long>(normalOffset),
+            static_cast<unsigned long long>(uvOffset),
+            static_cast<unsigned long long>(indexOffset - uvOffset),
+            static_cast<unsigned long long>(indexOffset),
+            static_cast<unsigned long long>(buffer.size() - indexOffset),
+            static_cast<unsigned long long>(vertexCount),
+            bounds.m_min.x, bounds.m_min.y, bounds.m_min.z,
+            bounds.m_max.x, bounds.m_max.y, bounds.m_max.z,
+            static_cast<unsigned long long>(vertexCount),
+            static_cast<unsigned long long>(vertexCount),
+            static_cast<unsigned long long>(terrain.m_indices.size()));
+        FileSystem::WriteFile(path, { reinterpret_cast<const u8*>(json.data()), json.size() });
+        return path;
+    }
+
+    std::vector<Aabb> MakeInstanceBounds(u32 _count)
+    {
+        // Props gathered around 256 district centers, a tenth of them large buildings.
+        constexpr u32 kDistrictCount = 256;
+        constexpr f32 kLevelSize = 4096.f;
+        const auto unit = [](u32 _hash) { return f32(_hash >> 8) / f32(1u << 24); };
+
+        std::vector<Aabb> bounds(_count);
+        for (u32 i = 0; i < _count; i++)
+        {
+            const u32 district = Mix(i, 0, 1) % kDistrictCount;
+            const Float3 center {
+                kLevelSize * unit(Mix(district, 0, 2)) + 200.f * (unit(Mix(i, 1, 3)) - 0.5f),
+                4.f * unit(Mix(i, 2, 3)),
+                kLevelSize * unit(Mix(district, 1, 2)) + 200.f * (unit(Mix(i, 3, 3)) - 0.5f),
+            };
+            const f32 size = Mix(i, 4, 3) % 10 == 0 ? 10.f + 30.f * unit(Mix(i, 5, 3)) : 0.25f + 2.f * unit(Mix(i, 6, 3));
+            const Float3 halfExtent { size, size * (0.5f + unit(Mix(i, 7, 3))), size };
+            bounds[i].m_min = center - halfExtent;
+            bounds[i].m_max = center + halfExtent;
+        }
+        return bounds;
+    }
+
+    Image MakeImage(u32 _width, u32 _height)
+    {
+        Image image;
+        image.Allocate(_width, _height);
+        for (u32 y = 0; y < _height; y++)
+        {
+            for (u32 x = 0; x < _width; x++)
+            {
+                const f32 u = f32(x) / f32(_width);
+                const f32 v = f32(y) / f32(_height);
+                const u32 noise = Mix(x, y, 1);
+                // Tiles with mortar lines, over a diagonal gradient.
+                const bool mortar = (x % 64) < 3 || (y % 32) < 3;
+                const u32 tile = Mix(x / 64 + (y / 32 % 2) * 32, y / 32, 2);
+                u8* pixel = image.GetPixel(x, y);
+                for (u32 c = 0; c < 3; c++)
+                {
+                    const f32 base = mortar ? 90.f : 120.f + f32((tile >> (c * 8)) & 63) + 60.f * (u + v) * 0.5f;
+                    const f32 value = base + f32((noise >> (c * 8)) & 15) - 7.5f;
+                    pixel[c] = u8(std::clamp(value, 0.f, 255.f));
+                }
+                pixel[3] = u8(255.f * (0.5f + 0.5f * std::sin(kTwoPi * u * 2.f) * std::cos(kTwoPi * v)));
+            }
+        }
+        return image;
+    }
+
+    std::vector<PackInput> WritePackInputs(u32 _count, u64 _size)
+    {
+        static constexpr const char* kWords[] = { "mesh", "texture", "shader", "material", "level", "asset", "cook",
+            "pack", "vertex", "index", "mip", "brick", "\"name\": ", "\"path\": ", "{\n    ", "\n},\n" };
+
+        std::vector<PackInput> inputs;
+        std::vector<u8> data;
+        for (u32 i = 0; i < _count; i++)
+        {
+            data.clear();
+            data.reserve(_size);
+            u32 state = i;
+            if (i % 2 == 0)
+            {
+                // Records of small structured values, like vertex or table data.
+                while (data.size() < _size)
+                {
+                    state = Mix(state, i, 3);
+                    const u8 record[8] = { u8(data.size() >> 3), 0, u8(state & 7), 0x3f, u8(state >> 8), u8(state >> 16), 0, 0 };
+                    data.insert(data.end(), std::begin(record), std::end(record));
+                }
+            }
+            else
+            {
+                while (data.size() < _size)
+                {
+                    state = Mix(state, i, 4);
+                    const char* word = kWords[state % std::size(kWords)];
+                    data.insert(data.end(), word, word + std::strlen(word));
+                    data.push_back(u8('a' + (state >> 8) % 26));
+                }
+            }
+            data.resize(_size);
+
+            PackInput& input = inputs.emplace_back();
+            input.m_name = FormatString("corpus/file%02u.bin", i);
+            input.m_path = GetDirectory() / FormatString("pack/file%02u.bin", i);
+            FileSystem::CreateParentDirectories(input.m_path);
+            FileSystem::WriteFile(input.m_path, data);
+        }
+        return inputs;
+    }
+}
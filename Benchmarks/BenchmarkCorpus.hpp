@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "KryneTools/Common/Math.hpp"
+#include "KryneTools/Pack/PackBuilder.hpp"
+#include "KryneTools/Texture/Image.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+}
+
+/**
+ * @brief Fixed corpus of the benchmarks, generated procedurally so results compare across machines and commits.
+ *
+ * @details
+ * Every generator is deterministic, and files are written once per run under a temporary directory removed on exit.
+ */
+namespace KryneTools::BenchmarkCorpus
+{
+    struct Terrain
+    {
+        std::vector<Float3> m_positions;
+        std::vector<Float3> m_normals;
+        std::vector<Float2> m_uvs;
+        std::vector<u32> m_indices;
+    };
+
+    /// Shared by every benchmark, with one worker per hardware thread.
+    [[nodiscard]] JobSystem& GetJobSystem();
+
+    [[nodiscard]] const std::filesystem::path& GetDirectory();
+
+    /// Heightfield of `_resolution` x `_resolution` quads, two triangles each, with rolling hills and ridges.
+    [[nodiscard]] Terrain MakeTerrain(u32 _resolution);
+
+    /// `MakeTerrain()` written as a `.gltf` with an external `.bin` buffer. Returns the `.gltf` path.
+    [[nodiscard]] std::filesystem::path WriteTerrainGltf(u32 _resolution);
+
+    /// World bounds of `_count` level instances, props clustered in districts among larger buildings.
+    [[nodiscard]] std::vector<Aabb> MakeInstanceBounds(u32 _count);
+
+    /// Albedo-like image: smooth gradients, sharp edges and fine noise, with a varying alpha.
+    [[nodiscard]] Image MakeImage(u32 _width, u32 _height);
+
+    /**
+     * @brief Writes `_count` files of `_size` bytes, half structured binary and half text, compressing about 1.6:1
+     * with LZ4 overall.
+     */
+    [[nodiscard]] std::vector<PackInput> WritePackInputs(u32 _count, u64 _size);
+}
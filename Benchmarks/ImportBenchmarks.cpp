@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "BenchmarkCorpus.hpp"
+#include "KryneTools/Import/GltfAccessor.hpp"
+#include "KryneTools/Import/GltfImporter.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    /// Full import of a terrain (decode, LODs, optimization, meshlets and write), in source bytes per second.
+    void BM_ImportGltf(benchmark::State& _state)
+    {
+        ImportSettings settings;
+        settings.m_input = BenchmarkCorpus::WriteTerrainGltf(u32(_state.range(0)));
+        settings.m_outputDirectory = BenchmarkCorpus::GetDirectory() / "import";
+        settings.m_generateLods = _state.range(1) != 0;
+        const u64 inputSize = std::filesystem::file_size(settings.m_input)
+            + std::filesystem::file_size(std::filesystem::path(settings.m_input).replace_extension(".bin"));
+
+        ImportResult result;
+        for (auto _: _state)
+        {
+            result = ImportGltf(BenchmarkCorpus::GetJobSystem(), settings);
+        }
+        _state.SetBytesProcessed(s64(_state.iterations() * inputSize));
+        _state.counters["triangles"] = f64(result.m_triangleCount);
+    }
+
+    /// Decode of every vertex and index accessor of a terrain to mesh streams, single threaded, in source bytes per second.
+    void BM_DecodeAccessors(benchmark::State& _state)
+    {
+        const Gltf::Document document = Gltf::Document::Load(BenchmarkCorpus::WriteTerrainGltf(u32(_state.range(0))));
+        const std::vector<Gltf::Accessor>& accessors = document.GetAccessors();
+        std::vector<f32> floats(u64(accessors[0].m_count) * 4);
+        std::vector<u32> indices(accessors[3].m_count);
+
+        u64 inputSize = 0;
+        for (const Gltf::Accessor& accessor: accessors)
+        {
+            inputSize += u64(accessor.m_count) * GetComponentCount(accessor.m_type) * GetComponentSize(accessor.m_componentType);
+        }
+
+        for (auto _: _state)
+        {
+            Gltf::DecodeFloats(document, accessors[0], floats.data(), 3, 0, accessors[0].m_count);
+            Gltf::DecodeFloats(document, accessors[1], floats.data(), 3, 0, accessors[1].m_count);
+            Gltf::DecodeFloats(document, accessors[2], floats.data(), 2, 0, accessors[2].m_count);
+            Gltf::DecodeIntegers(document, accessors[3], indices.data(), 1, 0, accessors[3].m_count);
+            benchmark::DoNotOptimize(floats.data());
+            benchmark::DoNotOptimize(indices.data());
+        }
+        _state.SetBytesProcessed(s64(_state.iterations() * inputSize));
+    }
+}
+
+BENCHMARK(BM_ImportGltf)
+    ->ArgNames({ "resolution", "lods" })
+    ->Args({ 256, 0 })
+    ->Args({ 256, 1 })
+    ->Args({ 512, 1 })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_DecodeAccessors)
+    ->ArgNames({ "resolution" })
+    ->Arg(512)
+    ->Unit(benchmark::kMillisecond);
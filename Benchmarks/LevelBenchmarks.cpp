@@ -0,0 +1,30 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchmarkCorpus.hpp"
+#include "KryneTools/Level/LevelBvh.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    /// Binned SAH build over level instance bounds, in instances per second.
+    void BM_BuildBvh(benchmark::State& _state)
+    {
+        const std::vector<Aabb> bounds = BenchmarkCorpus::MakeInstanceBounds(u32(_state.range(0)));
+        Bvh bvh;
+        for (auto _: _state)
+        {
+            bvh = BuildBvh(BenchmarkCorpus::GetJobSystem(), bounds, {});
+        }
+        _state.counters["instances/s"] = benchmark::Counter(f64(bounds.size()), benchmark::Counter::kIsIterationInvariantRate);
+        _state.counters["sah_cost"] = f64(bvh.m_cost);
+        _state.counters["depth"] = f64(bvh.m_depth);
+    }
+}
+
+BENCHMARK(BM_BuildBvh)
+    ->ArgName("instances")
+    ->Arg(1 << 16)
+    ->Arg(1 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
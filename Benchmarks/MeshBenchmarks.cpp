@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchmarkCorpus.hpp"
+#include "KryneTools/Mesh/MeshData.hpp"
+#include "KryneTools/Mesh/MeshOptimizer.hpp"
+#include "KryneTools/Mesh/MeshSimplifier.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    /// Halves a terrain in one `SimplifyTriangles()` call, in source triangles per second. Single threaded.
+    void BM_SimplifyTriangles(benchmark::State& _state)
+    {
+        const BenchmarkCorpus::Terrain terrain = BenchmarkCorpus::MakeTerrain(u32(_state.range(0)));
+        const u32 targetIndexCount = u32(terrain.m_indices.size() / 2);
+        std::vector<u32> output;
+        for (auto _: _state)
+        {
+            benchmark::DoNotOptimize(SimplifyTriangles(terrain.m_indices, terrain.m_positions, targetIndexCount, 1.f, output));
+        }
+        _state.counters["triangles/s"] = benchmark::Counter(
+            f64(terrain.m_indices.size() / 3), benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    /**
+     * Runs the optimization stage on a terrain in generation order, in triangles per second, and reports its ACMR and
+     * ATVR before and after on the 16 entries FIFO of `kDefaultAnalysisCacheSize`.
+     */
+    void BM_OptimizeMesh(benchmark::State& _state)
+    {
+        const BenchmarkCorpus::Terrain terrain = BenchmarkCorpus::MakeTerrain(u32(_state.range(0)));
+        MeshData source;
+        source.m_attributeMask = AttributeBit(VertexAttribute::Position) | AttributeBit(VertexAttribute::Normal) | AttributeBit(VertexAttribute::TexCoord0);
+        source.m_vertexCount = u32(terrain.m_positions.size());
+        source.m_positions = terrain.m_positions;
+        source.m_normals = terrain.m_normals;
+        source.m_texCoords[0] = terrain.m_uvs;
+        source.m_indices = terrain.m_indices;
+        Submesh& submesh = source.m_submeshes.emplace_back();
+        submesh.m_vertexCount = source.m_vertexCount;
+        submesh.m_indexCount = u32(source.m_indices.size());
+        submesh.m_materialIndex = MeshData::kNoMaterial;
+
+        MeshOptimizationReport report;
+        for (auto _: _state)
+        {
+            _state.PauseTiming();
+            MeshData mesh = source;
+            _state.ResumeTiming();
+            report = OptimizeMesh(BenchmarkCorpus::GetJobSystem(), mesh);
+            benchmark::DoNotOptimize(mesh.m_indices.data());
+        }
+        _state.counters["triangles/s"] = benchmark::Counter(
+            f64(terrain.m_indices.size() / 3), benchmark::Counter::kIsIterationInvariantRate);
+        _state.counters["acmr_before"] = report.m_before.GetAcmr();
+        _state.counters["acmr_after"] = report.m_after.GetAcmr();
+        _state.counters["atvr_before"] = report.m_before.GetAtvr();
+        _state.counters["atvr_after"] = report.m_after.GetAtvr();
+    }
+}
+
+BENCHMARK(BM_SimplifyTriangles)
+    ->ArgName("resolution")
+    ->Arg(128)
+    ->Arg(512)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_OptimizeMesh)
+    ->ArgName("resolution")
+    ->Arg(128)
+    ->Arg(512)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchmarkCorpus.hpp"
+#include "KryneTools/Pack/PackBuilder.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    constexpr u32 kPackInputCount = 32;
+    constexpr u64 kPackInputSize = 2ull << 20;
+
+    /// Packs 64 MiB of files, in input bytes per second.
+    void BM_BuildPack(benchmark::State& _state, CompressionMethod _compression, bool _highCompression)
+    {
+        static const std::vector<PackInput> inputs = BenchmarkCorpus::WritePackInputs(kPackInputCount, kPackInputSize);
+        PackSettings settings;
+        settings.m_compression = _compression;
+        settings.m_highCompression = _highCompression;
+        const std::filesystem::path output = BenchmarkCorpus::GetDirectory() / "corpus.kpak";
+
+        PackStatistics statistics;
+        for (auto _: _state)
+        {
+            statistics = BuildPack(BenchmarkCorpus::GetJobSystem(), output, inputs, settings);
+        }
+        _state.SetBytesProcessed(s64(_state.iterations() * statistics.m_inputSize));
+        _state.counters["ratio"] = f64(statistics.m_inputSize) / f64(std::max<u64>(statistics.m_storedSize, 1));
+    }
+}
+
+BENCHMARK_CAPTURE(BM_BuildPack, none, CompressionMethod::None, false)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_BuildPack, lz4, CompressionMethod::Lz4, false)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_BuildPack, lz4_high, CompressionMethod::Lz4, true)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+
+#include "BenchmarkCorpus.hpp"
+#include "KryneTools/Texture/TextureCompressor.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    constexpr u32 kImageSize = 1024;
+
+    /// Block compresses one 1024x1024 mip, in megapixels per second.
+    void BM_CompressTexture(benchmark::State& _state, TextureFormat _format, EncodeQuality _quality)
+    {
+        const Image image = BenchmarkCorpus::MakeImage(kImageSize, kImageSize);
+        CompressionSettings settings;
+        settings.m_format = _format;
+        settings.m_quality = _quality;
+        for (auto _: _state)
+        {
+            benchmark::DoNotOptimize(CompressTexture(BenchmarkCorpus::GetJobSystem(), { &image, 1 }, settings));
+        }
+        _state.counters["Mpixels/s"] = benchmark::Counter(
+            f64(kImageSize) * kImageSize * 1e-6, benchmark::Counter::kIsIterationInvariantRate);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_CompressTexture, bc1, TextureFormat::Bc1, EncodeQuality::Fast)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompressTexture, bc3, TextureFormat::Bc3, EncodeQuality::Fast)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompressTexture, bc4, TextureFormat::Bc4, EncodeQuality::Fast)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompressTexture, bc5, TextureFormat::Bc5, EncodeQuality::Fast)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompressTexture, bc7, TextureFormat::Bc7, EncodeQuality::Fast)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompressTexture, bc7_high, TextureFormat::Bc7, EncodeQuality::High)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompressTexture, astc4x4, TextureFormat::Astc4x4, EncodeQuality::Fast)->Unit(benchmark::kMillisecond)->UseRealTime();
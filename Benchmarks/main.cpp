@@ -0,0 +1,40 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "KryneTools/Common/Log.hpp"
+
+/**
+ * Runs the stage benchmarks on the procedural corpus. Unless `--benchmark_out` is given, results are also written as
+ * JSON to `bench_output.txt`, for `compare.py` from Google Benchmark to diff between commits.
+ */
+int main(int _argc, char** _argv)
+{
+    std::vector<char*> arguments(_argv, _argv + _argc);
+    std::string output = "--benchmark_out=bench_output.txt";
+    std::string format = "--benchmark_out_format=json";
+    bool hasOutput = false;
+    for (int i = 1; i < _argc; i++)
+    {
+        hasOutput |= std::strncmp(_argv[i], "--benchmark_out=", 16) == 0;
+    }
+    if (!hasOutput)
+    {
+        arguments.push_back(output.data());
+        arguments.push_back(format.data());
+    }
+
+    int argumentCount = int(arguments.size());
+    benchmark::Initialize(&argumentCount, arguments.data());
+    if (benchmark::ReportUnrecognizedArguments(argumentCount, arguments.data()))
+    {
+        return 1;
+    }
+
+    KryneTools::Log::SetLevel(KryneTools::Log::Level::Warning);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
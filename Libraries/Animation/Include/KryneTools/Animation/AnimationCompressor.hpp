@@ -0,0 +1,69 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class JobSystem;
+
+    struct AnimationSettings
+    {
+        std::filesystem::path m_input;
+        /// Defaults to the directory of the input.
+        std::filesystem::path m_outputDirectory;
+        /// Samples per second of the compressed clips.
+        f32 m_sampleRate = 30.f;
+        /// Maximum object space error of any bone, in scene units.
+        f32 m_maxError = 0.0001f;
+        /// Distance from the bones of the points the error is measured on, the size of the skinned geometry around them.
+        f32 m_shellDistance = 0.03f;
+        /// Skin defining the skeleton, defaults to the first skin, then to every node when the asset has none.
+        std::optional<u32> m_skin;
+        /// Optional artifact cache, looked up before compressing and filled after.
+        ContentCache* m_cache = nullptr;
+    };
+
+    struct ClipResult
+    {
+        std::filesystem::path m_output;
+        std::string m_name;
+        u32 m_boneCount = 0;
+        u32 m_sampleCount = 0;
+        /// Size of the clip as 32 bits floats quaternions, translations and scales.
+        u64 m_rawSize = 0;
+        u64 m_size = 0;
+        /// Largest object space error measured on the written clip, 0 when restored from the cache.
+        f32 m_maxError = 0.f;
+        /// Track counts per `AnimationFormat::TrackEncoding`.
+        u32 m_trackCounts[4] = {};
+    };
+
+    struct AnimationResult
+    {
+        std::vector<ClipResult> m_clips;
+        /// The clips were restored from the cache, their statistics read back from the files.
+        bool m_cacheHit = false;
+    };
+
+    /**
+     * @brief Compresses the animations of a glTF 2.0 asset to `.kanim` clips, one job per animation.
+     *
+     * @details
+     * Channels are resampled at `m_sampleRate` into the local transforms of the skeleton, bones missing a channel
+     * keeping their rest pose. Each track is then stored with the cheapest encoding keeping the error under
+     * `m_maxError`: at the identity, constant, or quantized with a per track bit rate. Bit rates are chosen bone after
+     * bone from the roots, measuring the object space error of shell points around each bone, so the error
+     * accumulated along a hierarchy is bounded rather than the local error of each track.
+     *
+     * Clips are named after the input and the animation, `<stem>.kanim` when the asset has a single animation. With a
+     * cache, the clips of an asset are one artifact, keyed on the asset and its buffers, the settings and the tools
+     * build ID.
+     */
+    AnimationResult CompressAnimations(JobSystem& _jobSystem, const AnimationSettings& _settings);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine compressed animation clips (`.kanim`).
+ *
+ * A clip holds the local transforms of a skeleton, sampled at a uniform rate. Each bone has a rotation, a translation
+ * and a scale track, in that order. Tracks that never move are stored once in their record (or not at all when at the
+ * identity), the others are quantized to a per track bit rate within their value range.
+ *
+ * Animated values are stored frame-major: frame `i` is a bit stream of `Header::m_frameSize` bytes with the values of
+ * every animated track at sample `i`, so sampling a pose between two samples reads two contiguous frames. Track values
+ * start at `TrackRecord::m_bitOffset` in the stream, 3 components of `TrackRecord::m_bits` bits each, least
+ * significant bit first. The frame data is followed by 8 padding bytes, so decoders may read 64 bits at any offset.
+ *
+ * Rotations are unit quaternions stored as `xyz` with a positive `w`, which is reconstructed. Decoders should
+ * interpolate them along the shortest arc.
+ *
+ * All values are little-endian.
+ */
+namespace KryneTools::AnimationFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'A', 'N', 'M');
+    constexpr u16 kVersion = 1;
+    constexpr u32 kTracksPerBone = 3;
+
+    enum class TrackEncoding: u8
+    {
+        /// The identity: no rotation, no translation or unit scale. Nothing is stored.
+        Default = 0,
+        /// A single value, in `TrackRecord::m_min`.
+        Constant = 1,
+        /// `m_min + m_extent * value / (2^m_bits - 1)`, per component.
+        Quantized = 2,
+        /// 32 bits floats.
+        Raw = 3,
+    };
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u32 m_boneCount;
+        u32 m_sampleCount;
+        f32 m_sampleRate;
+        /// `(m_sampleCount - 1) / m_sampleRate`, in seconds.
+        f32 m_duration;
+        /// Bytes per frame, a multiple of 4. 0 when no track is animated.
+        u32 m_frameSize;
+        u32 m_reserved;
+        /// `BoneRecord[m_boneCount]`, parents before their children.
+        u64 m_bonesOffset;
+        /// `TrackRecord[m_boneCount * kTracksPerBone]`.
+        u64 m_tracksOffset;
+        /// Bone names, see `StringTableHeader`.
+        u64 m_namesOffset;
+        /// `u8[m_sampleCount][m_frameSize]`.
+        u64 m_framesOffset;
+        u64 m_fileSize;
+    };
+    static_assert(sizeof(Header) == 72);
+
+    struct BoneRecord
+    {
+        /// Index of the parent bone, `~0u` for roots.
+        u32 m_parent;
+        /// glTF node of the bone, for binding.
+        u32 m_node;
+    };
+    static_assert(sizeof(BoneRecord) == 8);
+
+    struct TrackRecord
+    {
+        TrackEncoding m_encoding;
+        /// Bits per component of quantized tracks, 32 for raw ones.
+        u8 m_bits;
+        u16 m_reserved;
+        u32 m_bitOffset;
+        f32 m_min[3];
+        f32 m_extent[3];
+    };
+    static_assert(sizeof(TrackRecord) == 32);
+
+    /// Header of a string table, followed by `m_count + 1` u32 offsets then the character data.
+    struct StringTableHeader
+    {
+        u32 m_count;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "KryneTools/Animation/AnimationFormat.hpp"
+#include "KryneTools/Common/Math.hpp"
+
+namespace KryneTools
+{
+    /// Local transform of a bone.
+    struct BoneTransform
+    {
+        /// Unit quaternion (x, y, z, w).
+        Float4 m_rotation { 0.f, 0.f, 0.f, 1.f };
+        Float3 m_translation {};
+        Float3 m_scale { 1.f, 1.f, 1.f };
+    };
+
+    /**
+     * @brief Samples a compressed clip in place, as the runtime does.
+     *
+     * @details
+     * Views the clip bytes, which must outlive the reader. Poses between two samples are interpolated from two
+     * contiguous frames: rotations along the shortest arc (normalized lerp), translations and scales linearly.
+     */
+    class ClipReader
+    {
+    public:
+        /// Validates the header and the table ranges, throws an `Error` on failure.
+        [[nodiscard]] static ClipReader Open(std::span<const u8> _data);
+
+        [[nodiscard]] const AnimationFormat::Header& GetHeader() const { return *m_header; }
+        [[nodiscard]] u32 GetBoneCount() const { return m_header->m_boneCount; }
+        [[nodiscard]] u32 GetSampleCount() const { return m_header->m_sampleCount; }
+        [[nodiscard]] f32 GetDuration() const { return m_header->m_duration; }
+        [[nodiscard]] const AnimationFormat::BoneRecord& GetBone(u32 _bone) const { return m_bones[_bone]; }
+        [[nodiscard]] std::string_view GetBoneName(u32 _bone) const;
+        /// `_track` is one of the `kTracksPerBone` tracks of the bone: rotation, translation, scale.
+        [[nodiscard]] const AnimationFormat::TrackRecord& GetTrack(u32 _bone, u32 _track) const { return m_tracks[_bone * AnimationFormat::kTracksPerBone + _track]; }
+
+        /// Local transforms of every bone at sample `_sample`.
+        void DecodeFrame(u32 _sample, std::span<BoneTransform> _pose) const;
+        /// Local transforms of every bone at `_time` seconds, clamped to the clip.
+        void SamplePose(f32 _time, std::span<BoneTransform> _pose) const;
+
+    private:
+        const AnimationFormat::Header* m_header = nullptr;
+        const AnimationFormat::BoneRecord* m_bones = nullptr;
+        const AnimationFormat::TrackRecord* m_tracks = nullptr;
+        const u32* m_nameOffsets = nullptr;
+        const char* m_names = nullptr;
+        const u8* m_frames = nullptr;
+    };
+}
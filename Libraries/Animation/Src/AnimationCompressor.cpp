@@ -0,0 +1,988 @@
+#include "KryneTools/Animation/AnimationCompressor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "KryneTools/Animation/AnimationFormat.hpp"
+#include "KryneTools/Animation/ClipReader.hpp"
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Import/GltfAccessor.hpp"
+#include "KryneTools/Import/GltfDocument.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "TrackCodec.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        using AnimationFormat::TrackEncoding;
+        using AnimationFormat::TrackRecord;
+
+        /// Row-major 3x4 affine transform. Errors are measured in double precision, so they are the ones of the clip.
+        using Affine = std::array<std::array<f64, 4>, 3>;
+
+        enum Track: u32
+        {
+            kRotation = 0,
+            kTranslation = 1,
+            kScale = 2,
+        };
+
+        constexpr Float3 kIdentityValues[AnimationFormat::kTracksPerBone] = { { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } };
+
+        struct Candidate
+        {
+            TrackEncoding m_encoding;
+            u8 m_bits;
+        };
+
+        /// Encodings from the cheapest to the most precise. Bit rates are per component.
+        constexpr Candidate kCandidates[] = {
+            { TrackEncoding::Default, 0 },
+            { TrackEncoding::Constant, 0 },
+            { TrackEncoding::Quantized, 3 },
+            { TrackEncoding::Quantized, 4 },
+            { TrackEncoding::Quantized, 5 },
+            { TrackEncoding::Quantized, 6 },
+            { TrackEncoding::Quantized, 7 },
+            { TrackEncoding::Quantized, 8 },
+            { TrackEncoding::Quantized, 9 },
+            { TrackEncoding::Quantized, 10 },
+            { TrackEncoding::Quantized, 11 },
+            { TrackEncoding::Quantized, 12 },
+            { TrackEncoding::Quantized, 13 },
+            { TrackEncoding::Quantized, 14 },
+            { TrackEncoding::Quantized, 15 },
+            { TrackEncoding::Quantized, 16 },
+            { TrackEncoding::Quantized, 18 },
+            { TrackEncoding::Quantized, 20 },
+            { TrackEncoding::Quantized, 23 },
+            { TrackEncoding::Raw, 32 },
+        };
+        constexpr u32 kCandidateCount = std::size(kCandidates);
+        constexpr u32 kFirstQuantized = 2;
+        constexpr u32 kRaw = kCandidateCount - 1;
+
+        /// Share of the error budget of a bone its static tracks may use, the rest goes to the animated ones.
+        constexpr f64 kStaticErrorShare = 0.25;
+
+        std::string SanitizeFileName(std::string_view _name)
+        {
+            std::string result;
+            for (const char c: _name)
+            {
+                const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+                result += valid ? c : '_';
+            }
+            return result;
+        }
+
+        Affine MakeLocal(const Float4& _rotation, const Float3& _translation, const Float3& _scale)
+        {
+            const f64 x = _rotation.x;
+            const f64 y = _rotation.y;
+            const f64 z = _rotation.z;
+            const f64 w = _rotation.w;
+            return {{
+                { (1.0 - 2.0 * (y * y + z * z)) * _scale.x, 2.0 * (x * y - z * w) * _scale.y, 2.0 * (x * z + y * w) * _scale.z, _translation.x },
+                { 2.0 * (x * y + z * w) * _scale.x, (1.0 - 2.0 * (x * x + z * z)) * _scale.y, 2.0 * (y * z - x * w) * _scale.z, _translation.y },
+                { 2.0 * (x * z - y * w) * _scale.x, 2.0 * (y * z + x * w) * _scale.y, (1.0 - 2.0 * (x * x + y * y)) * _scale.z, _translation.z },
+            }};
+        }
+
+        Affine Multiply(const Affine& _parent, const Affine& _local)
+        {
+            Affine result {};
+            for (u32 r = 0; r < 3; r++)
+            {
+                for (u32 c = 0; c < 4; c++)
+                {
+                    f64 value = c == 3 ? _parent[r][3] : 0.0;
+                    for (u32 k = 0; k < 3; k++)
+                    {
+                        value += _parent[r][k] * _local[k][c];
+                    }
+                    result[r][c] = value;
+                }
+            }
+            return result;
+        }
+
+        /// Largest distance between the bone origin and its shell points `(d, 0, 0)`, `(0, d, 0)`, `(0, 0, d)` as transformed by both.
+        f64 ShellError(const Affine& _reference, const Affine& _lossy, f64 _shellDistance)
+        {
+            f64 origin[3];
+            for (u32 r = 0; r < 3; r++)
+            {
+                origin[r] = _reference[r][3] - _lossy[r][3];
+            }
+            f64 error = origin[0] * origin[0] + origin[1] * origin[1] + origin[2] * origin[2];
+            for (u32 k = 0; k < 3; k++)
+            {
+                f64 squared = 0.0;
+                for (u32 r = 0; r < 3; r++)
+                {
+                    const f64 delta = origin[r] + (_reference[r][k] - _lossy[r][k]) * _shellDistance;
+                    squared += delta * delta;
+                }
+                error = std::max(error, squared);
+            }
+            return std::sqrt(error);
+        }
+
+        /// Stored components of a track, `xyz` of rotations.
+        Float3 GetTrackValue(const BoneTransform& _transform, u32 _track)
+        {
+            if (_track == kRotation)
+            {
+                return { _transform.m_rotation.x, _transform.m_rotation.y, _transform.m_rotation.z };
+            }
+            return _track == kTranslation ? _transform.m_translation : _transform.m_scale;
+        }
+
+        u32 Quantize(const TrackRecord& _track, u32 _component, f32 _value)
+        {
+            const u32 maxValue = u32((u64(1) << _track.m_bits) - 1);
+            if (_track.m_extent[_component] <= 0.f)
+            {
+                return 0;
+            }
+            const f32 normalized = std::clamp((_value - _track.m_min[_component]) / _track.m_extent[_component], 0.f, 1.f);
+            return std::min(maxValue, u32(std::lround(f64(normalized) * maxValue)));
+        }
+
+        /// A value as the clip will decode it.
+        Float3 RoundTrip(const TrackRecord& _track, const Float3& _value, const Float3& _identity)
+        {
+            switch (_track.m_encoding)
+            {
+                case TrackEncoding::Quantized:
+                    return {
+                        TrackCodec::Dequantize(_track, 0, Quantize(_track, 0, _value.x)),
+                        TrackCodec::Dequantize(_track, 1, Quantize(_track, 1, _value.y)),
+                        TrackCodec::Dequantize(_track, 2, Quantize(_track, 2, _value.z)),
+                    };
+                case TrackEncoding::Raw:
+                    return _value;
+                case TrackEncoding::Constant:
+                    return { _track.m_min[0], _track.m_min[1], _track.m_min[2] };
+                default:
+                    return _identity;
+            }
+        }
+
+        void WriteBits(u8* _frame, u32 _bitOffset, u32 _bits, u32 _value)
+        {
+            u64 word;
+            std::memcpy(&word, _frame + _bitOffset / 8, sizeof(word));
+            const u64 mask = ((u64(1) << _bits) - 1) << (_bitOffset % 8);
+            word = (word & ~mask) | ((u64(_value) << (_bitOffset % 8)) & mask);
+            std::memcpy(_frame + _bitOffset / 8, &word, sizeof(word));
+        }
+
+        struct Skeleton
+        {
+            std::vector<u32> m_nodes;
+            std::vector<u32> m_parents;
+            std::vector<std::string> m_names;
+        };
+
+        /// Joints of the skin ordered parent first, each parented to its nearest ancestor among them.
+        Skeleton BuildSkeleton(const Gltf::Document& _document, std::optional<u32> _skin)
+        {
+            const auto& nodes = _document.GetNodes();
+            const auto& skins = _document.GetSkins();
+            KT_VERIFY(!_skin || *_skin < skins.size(), "Skin %u does not exist, the asset has %zu", *_skin, skins.size());
+
+            std::vector<u32> nodeParents(nodes.size(), ~0u);
+            for (u32 i = 0; i < nodes.size(); i++)
+            {
+                for (const u32 child: nodes[i].m_children)
+                {
+                    nodeParents[child] = i;
+                }
+            }
+
+            // Preorder of the node forest, so ancestors always come first.
+            std::vector<u32> preorder(nodes.size(), ~0u);
+            u32 next = 0;
+            std::vector<u32> stack;
+            for (u32 i = 0; i < nodes.size(); i++)
+            {
+                if (nodeParents[i] != ~0u)
+                {
+                    continue;
+                }
+                stack.push_back(i);
+                while (!stack.empty())
+                {
+                    const u32 node = stack.back();
+                    stack.pop_back();
+                    if (preorder[node] != ~0u)
+                    {
+                        continue;
+                    }
+                    preorder[node] = next++;
+                    for (auto it = nodes[node].m_children.rbegin(); it != nodes[node].m_children.rend(); ++it)
+                    {
+                        stack.push_back(*it);
+                    }
+                }
+            }
+
+            Skeleton skeleton;
+            if (_skin || !skins.empty())
+            {
+                skeleton.m_nodes = skins[_skin.value_or(0)].m_joints;
+            }
+            else
+            {
+                for (u32 i = 0; i < nodes.size(); i++)
+                {
+                    skeleton.m_nodes.push_back(i);
+                }
+            }
+            const std::unordered_set<u32> unique(skeleton.m_nodes.begin(), skeleton.m_nodes.end());
+            KT_VERIFY(unique.size() == skeleton.m_nodes.size(), "Skin lists a joint twice");
+            for (const u32 node: skeleton.m_nodes)
+            {
+                KT_VERIFY(preorder[node] != ~0u, "Joint node %u is part of a cycle", node);
+            }
+            std::sort(skeleton.m_nodes.begin(), skeleton.m_nodes.end(), [&](u32 _a, u32 _b) { return preorder[_a] < preorder[_b]; });
+
+            std::unordered_map<u32, u32> bones;
+            for (u32 i = 0; i < skeleton.m_nodes.size(); i++)
+            {
+                bones[skeleton.m_nodes[i]] = i;
+            }
+            for (const u32 node: skeleton.m_nodes)
+            {
+                u32 parent = nodeParents[node];
+                while (parent != ~0u && !bones.contains(parent))
+                {
+                    parent = nodeParents[parent];
+                }
+                skeleton.m_parents.push_back(parent == ~0u ? ~0u : bones[parent]);
+                skeleton.m_names.push_back(nodes[node].m_name);
+            }
+            return skeleton;
+        }
+
+        /// Resamples a channel at the clip rate into `_samples[s * _boneCount + _bone]`.
+        void SampleChannel(
+            const Gltf::Document& _document,
+            const Gltf::AnimationSampler& _sampler,
+            Gltf::AnimationPath _path,
+            u32 _bone,
+            u32 _boneCount,
+            f32 _sampleRate,
+            std::span<BoneTransform> _samples)
+        {
+            const Gltf::Accessor& input = _document.GetAccessors()[_sampler.m_input];
+            const Gltf::Accessor& output = _document.GetAccessors()[_sampler.m_output];
+            const u32 keyCount = input.m_count;
+            if (keyCount == 0)
+            {
+                return;
+            }
+            const u32 components = _path == Gltf::AnimationPath::Rotation ? 4 : 3;
+            const bool cubic = _sampler.m_interpolation == Gltf::Interpolation::CubicSpline;
+            const u32 valueCount = cubic ? keyCount * 3 : keyCount;
+
+            std::vector<f32> times(keyCount);
+            Gltf::DecodeFloats(_document, input, times.data(), 1, 0, keyCount);
+            std::vector<f32> values(u64(valueCount) * components);
+            Gltf::DecodeFloats(_document, output, values.data(), components, 0, valueCount);
+
+            // Cubic splines store (in-tangent, value, out-tangent) per key.
+            const auto value = [&](u32 _key, u32 _c) { return values[(u64(_key) * (cubic ? 3 : 1) + (cubic ? 1 : 0)) * components + _c]; };
+            const auto tangent = [&](u32 _key, u32 _which, u32 _c) { return values[(u64(_key) * 3 + _which) * components + _c]; };
+
+            const u32 sampleCount = u32(_samples.size() / _boneCount);
+            for (u32 s = 0; s < sampleCount; s++)
+            {
+                const f32 time = f32(s) / _sampleRate;
+                const u32 key = u32(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+                f32 result[4];
+                if (key == 0 || key == keyCount)
+                {
+                    for (u32 c = 0; c < components; c++)
+                    {
+                        result[c] = value(key == 0 ? 0 : keyCount - 1, c);
+                    }
+                }
+                else
+                {
+                    const u32 k0 = key - 1;
+                    const f32 delta = times[key] - times[k0];
+                    const f32 t = delta > 0.f ? (time - times[k0]) / delta : 0.f;
+                    if (_sampler.m_interpolation == Gltf::Interpolation::Step)
+                    {
+                        for (u32 c = 0; c < components; c++)
+                        {
+                            result[c] = value(k0, c);
+                        }
+                    }
+                    else if (cubic)
+                    {
+                        const f32 t2 = t * t;
+                        const f32 t3 = t2 * t;
+                        for (u32 c = 0; c < components; c++)
+                        {
+                            result[c] = (2.f * t3 - 3.f * t2 + 1.f) * value(k0, c)
+                                + (t3 - 2.f * t2 + t) * delta * tangent(k0, 2, c)
+                                + (-2.f * t3 + 3.f * t2) * value(key, c)
+                                + (t3 - t2) * delta * tangent(key, 0, c);
+                        }
+                    }
+                    else if (_path == Gltf::AnimationPath::Rotation)
+                    {
+                        // Spherical interpolation along the shortest arc, linear when the keys are close.
+                        f32 cosine = 0.f;
+                        for (u32 c = 0; c < 4; c++)
+                        {
+                            cosine += value(k0, c) * value(key, c);
+                        }
+                        const f32 sign = cosine < 0.f ? -1.f : 1.f;
+                        cosine = std::abs(cosine);
+                        f32 w0 = 1.f - t;
+                        f32 w1 = t;
+                        if (cosine < 0.9995f)
+                        {
+                            const f32 angle = std::acos(cosine);
+                            const f32 sine = std::sin(angle);
+                            w0 = std::sin((1.f - t) * angle) / sine;
+                            w1 = std::sin(t * angle) / sine;
+                        }
+                        for (u32 c = 0; c < 4; c++)
+                        {
+                            result[c] = w0 * value(k0, c) + w1 * sign * value(key, c);
+                        }
+                    }
+                    else
+                    {
+                        for (u32 c = 0; c < components; c++)
+                        {
+                            result[c] = value(k0, c) + (value(key, c) - value(k0, c)) * t;
+                        }
+                    }
+                }
+
+                BoneTransform& transform = _samples[u64(s) * _boneCount + _bone];
+                switch (_path)
+                {
+                    case Gltf::AnimationPath::Rotation:
+                        transform.m_rotation = { result[0], result[1], result[2], result[3] };
+                        break;
+                    case Gltf::AnimationPath::Translation:
+                        transform.m_translation = { result[0], result[1], result[2] };
+                        break;
+                    default:
+                        transform.m_scale = { result[0], result[1], result[2] };
+                        break;
+                }
+            }
+        }
+
+        /// Normalizes the sampled rotations and moves them to the positive `w` hemisphere the clips store.
+        void CanonicalizeRotations(std::span<BoneTransform> _samples)
+        {
+            for (BoneTransform& transform: _samples)
+            {
+                Float4& q = transform.m_rotation;
+                const f32 length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+                const f32 scale = length > 0.f ? (q.w < 0.f ? -1.f : 1.f) / length : 0.f;
+                q = length > 0.f ? Float4 { q.x * scale, q.y * scale, q.z * scale, q.w * scale } : Float4 { 0.f, 0.f, 0.f, 1.f };
+            }
+        }
+
+        /**
+         * Chooses the encoding of every track. Bones are processed parent first: the error of a bone is measured
+         * against the lossy transforms of its already encoded ancestors, so it includes theirs.
+         *
+         * The error of a bone moves its whole subtree, so it is measured on a shell reaching its farthest descendant,
+         * and the bound is split along the chains: a bone may use the share of the bound given by its depth over the
+         * depth of its deepest leaf, which gets all of it. When a bone cannot meet its target even stored raw, its
+         * nearest lossy ancestor is made more precise and the bone tried again.
+         */
+        class ClipEncoder
+        {
+        public:
+            ClipEncoder(const Skeleton& _skeleton, std::span<const BoneTransform> _samples, const AnimationSettings& _settings)
+                : m_skeleton(_skeleton)
+                , m_samples(_samples)
+                , m_boneCount(u32(_skeleton.m_nodes.size()))
+                , m_sampleCount(u32(_samples.size() / std::max<size_t>(1, _skeleton.m_nodes.size())))
+                , m_choices(u64(m_boneCount) * AnimationFormat::kTracksPerBone, kRaw)
+                , m_tracks(u64(m_boneCount) * AnimationFormat::kTracksPerBone)
+                , m_shells(m_boneCount, 0.0)
+                , m_targets(m_boneCount)
+                , m_reference(_samples.size())
+                , m_lossy(_samples.size())
+            {
+                for (u32 s = 0; s < m_sampleCount; s++)
+                {
+                    for (u32 b = 0; b < m_boneCount; b++)
+                    {
+                        const BoneTransform& local = m_samples[Index(s, b)];
+                        const Affine transform = MakeLocal(local.m_rotation, local.m_translation, local.m_scale);
+                        const u32 parent = m_skeleton.m_parents[b];
+                        m_reference[Index(s, b)] = parent == ~0u ? transform : Multiply(m_reference[Index(s, parent)], transform);
+
+                        // Extends the shell of every ancestor to the bone.
+                        for (u32 a = parent; a != ~0u; a = m_skeleton.m_parents[a])
+                        {
+                            f64 squared = 0.0;
+                            for (u32 r = 0; r < 3; r++)
+                            {
+                                const f64 delta = m_reference[Index(s, b)][r][3] - m_reference[Index(s, a)][r][3];
+                                squared += delta * delta;
+                            }
+                            m_shells[a] = std::max(m_shells[a], std::sqrt(squared));
+                        }
+                    }
+                }
+
+                std::vector<u32> depths(m_boneCount, 0);
+                std::vector<u32> heights(m_boneCount, 0);
+                for (u32 b = 0; b < m_boneCount; b++)
+                {
+                    const u32 parent = m_skeleton.m_parents[b];
+                    depths[b] = parent == ~0u ? 0 : depths[parent] + 1;
+                    m_shells[b] += _settings.m_shellDistance;
+                }
+                for (u32 b = m_boneCount; b-- > 0;)
+                {
+                    const u32 parent = m_skeleton.m_parents[b];
+                    if (parent != ~0u)
+                    {
+                        heights[parent] = std::max(heights[parent], heights[b] + 1);
+                    }
+                }
+                for (u32 b = 0; b < m_boneCount; b++)
+                {
+                    m_targets[b] = f64(_settings.m_maxError) * f64(depths[b] + 1) / f64(depths[b] + heights[b] + 1);
+                }
+            }
+
+            void Run()
+            {
+                for (u32 b = 0; b < m_boneCount; b++)
+                {
+                    while (!SearchBone(b))
+                    {
+                        u32 ancestor = m_skeleton.m_parents[b];
+                        while (ancestor != ~0u && IsRaw(ancestor))
+                        {
+                            ancestor = m_skeleton.m_parents[ancestor];
+                        }
+                        if (ancestor == ~0u)
+                        {
+                            // Only float rounding is left, nothing can do better.
+                            SetRaw(b);
+                            break;
+                        }
+                        Refine(ancestor);
+                        for (u32 i = ancestor; i < b; i++)
+                        {
+                            UpdateLossy(i);
+                        }
+                    }
+                    UpdateLossy(b);
+                }
+            }
+
+            [[nodiscard]] const TrackRecord& GetTrack(u32 _bone, u32 _track) const { return m_tracks[_bone * AnimationFormat::kTracksPerBone + _track]; }
+
+        private:
+            const Skeleton& m_skeleton;
+            std::span<const BoneTransform> m_samples;
+            u32 m_boneCount;
+            u32 m_sampleCount;
+            std::vector<u32> m_choices;
+            std::vector<TrackRecord> m_tracks;
+            /// Distance the error of each bone is measured at, reaching its farthest descendant.
+            std::vector<f64> m_shells;
+            /// Error each bone may reach, ancestors included.
+            std::vector<f64> m_targets;
+            /// Object space transforms, of the source samples and as decoded from the chosen encodings.
+            std::vector<Affine> m_reference;
+            std::vector<Affine> m_lossy;
+
+            [[nodiscard]] u64 Index(u32 _sample, u32 _bone) const { return u64(_sample) * m_boneCount + _bone; }
+
+            [[nodiscard]] bool IsRaw(u32 _bone) const
+            {
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    if (m_choices[_bone * AnimationFormat::kTracksPerBone + t] != kRaw)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            void Choose(u32 _bone, u32 _track, u32 _candidate)
+            {
+                const u32 index = _bone * AnimationFormat::kTracksPerBone + _track;
+                m_choices[index] = _candidate;
+
+                TrackRecord& record = m_tracks[index];
+                record = {};
+                record.m_encoding = kCandidates[_candidate].m_encoding;
+                record.m_bits = kCandidates[_candidate].m_bits;
+                if (record.m_encoding == TrackEncoding::Constant || record.m_encoding == TrackEncoding::Quantized)
+                {
+                    Float3 min { FLT_MAX, FLT_MAX, FLT_MAX };
+                    Float3 max { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+                    for (u32 s = 0; s < m_sampleCount; s++)
+                    {
+                        const Float3 value = GetTrackValue(m_samples[Index(s, _bone)], _track);
+                        min = Min(min, value);
+                        max = Max(max, value);
+                    }
+                    for (u32 c = 0; c < 3; c++)
+                    {
+                        const f32 extent = max[c] - min[c];
+                        record.m_min[c] = record.m_encoding == TrackEncoding::Constant ? min[c] + extent * 0.5f : min[c];
+                        record.m_extent[c] = record.m_encoding == TrackEncoding::Constant ? 0.f : extent;
+                    }
+                }
+            }
+
+            void SetRaw(u32 _bone)
+            {
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    Choose(_bone, t, kRaw);
+                }
+            }
+
+            /// Moves the first lossy track of the bone, rotations first as they have the longest lever, to the next candidate.
+            void Refine(u32 _bone)
+            {
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    const u32 choice = m_choices[_bone * AnimationFormat::kTracksPerBone + t];
+                    if (choice != kRaw)
+                    {
+                        Choose(_bone, t, choice + 1);
+                        return;
+                    }
+                }
+            }
+
+            [[nodiscard]] Affine DecodeLocal(u32 _sample, u32 _bone) const
+            {
+                const BoneTransform& source = m_samples[Index(_sample, _bone)];
+                Float3 values[AnimationFormat::kTracksPerBone];
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    values[t] = RoundTrip(GetTrack(_bone, t), GetTrackValue(source, t), kIdentityValues[t]);
+                }
+                // Raw rotations keep their source `w`, the decoded one only differs by float rounding.
+                const Float4 rotation = GetTrack(_bone, kRotation).m_encoding == TrackEncoding::Raw
+                    ? source.m_rotation
+                    : TrackCodec::ReconstructRotation(values[kRotation]);
+                return MakeLocal(rotation, values[kTranslation], values[kScale]);
+            }
+
+            /// Error of the bone with its current encodings, stopping early once above `_limit`.
+            [[nodiscard]] f64 MeasureError(u32 _bone, f64 _limit) const
+            {
+                const u32 parent = m_skeleton.m_parents[_bone];
+                f64 error = 0.0;
+                for (u32 s = 0; s < m_sampleCount && error <= _limit; s++)
+                {
+                    const Affine local = DecodeLocal(s, _bone);
+                    const Affine lossy = parent == ~0u ? local : Multiply(m_lossy[Index(s, parent)], local);
+                    error = std::max(error, ShellError(m_reference[Index(s, _bone)], lossy, m_shells[_bone]));
+                }
+                return error;
+            }
+
+            void UpdateLossy(u32 _bone)
+            {
+                const u32 parent = m_skeleton.m_parents[_bone];
+                for (u32 s = 0; s < m_sampleCount; s++)
+                {
+                    const Affine local = DecodeLocal(s, _bone);
+                    m_lossy[Index(s, _bone)] = parent == ~0u ? local : Multiply(m_lossy[Index(s, parent)], local);
+                }
+            }
+
+            /// Finds the cheapest encodings of the bone, tracks that never move first, then the animated ones.
+            bool SearchBone(u32 _bone)
+            {
+                // The error inherited from the ancestors, what the bone adds is spread over its tracks.
+                SetRaw(_bone);
+                const f64 target = m_targets[_bone];
+                const f64 inherited = MeasureError(_bone, target);
+                if (inherited > target)
+                {
+                    return false;
+                }
+                const f64 budget = target - inherited;
+
+                std::vector<u32> animated;
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    bool found = false;
+                    for (u32 candidate = 0; candidate < kFirstQuantized && !found; candidate++)
+                    {
+                        Choose(_bone, t, candidate);
+                        const f64 limit = inherited + budget * kStaticErrorShare;
+                        found = MeasureError(_bone, limit) <= limit;
+                    }
+                    if (!found)
+                    {
+                        Choose(_bone, t, kRaw);
+                        animated.push_back(t);
+                    }
+                }
+
+                // Animated tracks share the rest of the budget, each one using its part on top of the previous ones.
+                const f64 staticError = MeasureError(_bone, target);
+                for (size_t i = 0; i < animated.size(); i++)
+                {
+                    const f64 limit = staticError + (target - staticError) * f64(i + 1) / f64(animated.size());
+                    for (u32 candidate = kFirstQuantized; candidate < kRaw; candidate++)
+                    {
+                        Choose(_bone, animated[i], candidate);
+                        if (MeasureError(_bone, limit) <= limit)
+                        {
+                            break;
+                        }
+                        Choose(_bone, animated[i], kRaw);
+                    }
+                }
+                if (MeasureError(_bone, target) <= target)
+                {
+                    return true;
+                }
+                SetRaw(_bone);
+                return true;
+            }
+        };
+
+        std::vector<u8> WriteClip(const Skeleton& _skeleton, const ClipEncoder& _encoder, std::span<const BoneTransform> _samples, u32 _sampleCount, f32 _sampleRate)
+        {
+            const u32 boneCount = u32(_skeleton.m_nodes.size());
+
+            std::vector<TrackRecord> tracks;
+            u32 bitCount = 0;
+            for (u32 b = 0; b < boneCount; b++)
+            {
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    TrackRecord track = _encoder.GetTrack(b, t);
+                    if (track.m_encoding == TrackEncoding::Quantized || track.m_encoding == TrackEncoding::Raw)
+                    {
+                        track.m_bitOffset = bitCount;
+                        bitCount += 3 * track.m_bits;
+                    }
+                    tracks.push_back(track);
+                }
+            }
+
+            AnimationFormat::Header header {};
+            header.m_magic = AnimationFormat::kMagic;
+            header.m_version = AnimationFormat::kVersion;
+            header.m_headerSize = sizeof(header);
+            header.m_boneCount = boneCount;
+            header.m_sampleCount = _sampleCount;
+            header.m_sampleRate = _sampleRate;
+            header.m_duration = f32(_sampleCount - 1) / _sampleRate;
+            header.m_frameSize = (bitCount + 31) / 32 * 4;
+            header.m_bonesOffset = sizeof(header);
+            header.m_tracksOffset = header.m_bonesOffset + u64(boneCount) * sizeof(AnimationFormat::BoneRecord);
+            header.m_namesOffset = header.m_tracksOffset + tracks.size() * sizeof(TrackRecord);
+
+            std::vector<u32> nameOffsets { 0 };
+            std::string characters;
+            for (const std::string& name: _skeleton.m_names)
+            {
+                characters += name;
+                nameOffsets.push_back(u32(characters.size()));
+            }
+            const u64 namesSize = sizeof(AnimationFormat::StringTableHeader) + nameOffsets.size() * sizeof(u32) + characters.size();
+            header.m_framesOffset = (header.m_namesOffset + namesSize + 7) / 8 * 8;
+            header.m_fileSize = header.m_framesOffset + u64(_sampleCount) * header.m_frameSize + sizeof(u64);
+
+            std::vector<u8> data(header.m_fileSize, 0);
+            std::memcpy(data.data(), &header, sizeof(header));
+            for (u32 b = 0; b < boneCount; b++)
+            {
+                const AnimationFormat::BoneRecord bone { _skeleton.m_parents[b], _skeleton.m_nodes[b] };
+                std::memcpy(data.data() + header.m_bonesOffset + b * sizeof(bone), &bone, sizeof(bone));
+            }
+            std::memcpy(data.data() + header.m_tracksOffset, tracks.data(), tracks.size() * sizeof(TrackRecord));
+            const AnimationFormat::StringTableHeader names { boneCount };
+            u8* namesData = data.data() + header.m_namesOffset;
+            std::memcpy(namesData, &names, sizeof(names));
+            std::memcpy(namesData + sizeof(names), nameOffsets.data(), nameOffsets.size() * sizeof(u32));
+            std::memcpy(namesData + sizeof(names) + nameOffsets.size() * sizeof(u32), characters.data(), characters.size());
+
+            for (u32 s = 0; s < _sampleCount; s++)
+            {
+                u8* frame = data.data() + header.m_framesOffset + u64(s) * header.m_frameSize;
+                for (u32 b = 0; b < boneCount; b++)
+                {
+                    for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                    {
+                        const TrackRecord& track = tracks[b * AnimationFormat::kTracksPerBone + t];
+                        const Float3 value = GetTrackValue(_samples[u64(s) * boneCount + b], t);
+                        for (u32 c = 0; c < 3; c++)
+                        {
+                            if (track.m_encoding == TrackEncoding::Quantized)
+                            {
+                                WriteBits(frame, track.m_bitOffset + c * track.m_bits, track.m_bits, Quantize(track, c, value[c]));
+                            }
+                            else if (track.m_encoding == TrackEncoding::Raw)
+                            {
+                                u32 bits;
+                                const f32 component = value[c];
+                                std::memcpy(&bits, &component, sizeof(bits));
+                                WriteBits(frame, track.m_bitOffset + c * 32, 32, bits);
+                            }
+                        }
+                    }
+                }
+            }
+            return data;
+        }
+
+        /// Largest object space error of the written clip, decoded as the runtime does.
+        f32 MeasureClipError(std::span<const u8> _clip, const Skeleton& _skeleton, std::span<const BoneTransform> _samples, f32 _shellDistance)
+        {
+            const ClipReader reader = ClipReader::Open(_clip);
+            const u32 boneCount = reader.GetBoneCount();
+            std::vector<BoneTransform> pose(boneCount);
+            std::vector<Affine> reference(boneCount);
+            std::vector<Affine> lossy(boneCount);
+            f64 error = 0.0;
+            for (u32 s = 0; s < reader.GetSampleCount(); s++)
+            {
+                reader.DecodeFrame(s, pose);
+                for (u32 b = 0; b < boneCount; b++)
+                {
+                    const BoneTransform& source = _samples[u64(s) * boneCount + b];
+                    const Affine sourceLocal = MakeLocal(source.m_rotation, source.m_translation, source.m_scale);
+                    const Affine lossyLocal = MakeLocal(pose[b].m_rotation, pose[b].m_translation, pose[b].m_scale);
+                    const u32 parent = _skeleton.m_parents[b];
+                    reference[b] = parent == ~0u ? sourceLocal : Multiply(reference[parent], sourceLocal);
+                    lossy[b] = parent == ~0u ? lossyLocal : Multiply(lossy[parent], lossyLocal);
+                    error = std::max(error, ShellError(reference[b], lossy[b], _shellDistance));
+                }
+            }
+            return f32(error);
+        }
+
+        ClipResult CompressAnimation(
+            const Gltf::Document& _document,
+            const Skeleton& _skeleton,
+            const Gltf::Animation& _animation,
+            const std::filesystem::path& _output,
+            const AnimationSettings& _settings)
+        {
+            KT_TRACE_ZONE_DETAIL("CompressAnimation", _animation.m_name);
+
+            const u32 boneCount = u32(_skeleton.m_nodes.size());
+            std::unordered_map<u32, u32> bones;
+            for (u32 b = 0; b < boneCount; b++)
+            {
+                bones[_skeleton.m_nodes[b]] = b;
+            }
+
+            f32 duration = 0.f;
+            for (const Gltf::AnimationChannel& channel: _animation.m_channels)
+            {
+                const Gltf::Accessor& input = _document.GetAccessors()[_animation.m_samplers[channel.m_sampler].m_input];
+                if (input.m_count > 0)
+                {
+                    f32 last;
+                    Gltf::DecodeFloats(_document, input, &last, 1, input.m_count - 1, input.m_count);
+                    duration = std::max(duration, last);
+                }
+            }
+            const u32 sampleCount = u32(std::lround(f64(duration) * _settings.m_sampleRate)) + 1;
+
+            // Bones start from their rest pose, channels overwrite what they animate.
+            std::vector<BoneTransform> samples(u64(sampleCount) * boneCount);
+            for (u32 b = 0; b < boneCount; b++)
+            {
+                const Gltf::Node& node = _document.GetNodes()[_skeleton.m_nodes[b]];
+                BoneTransform rest;
+                rest.m_rotation = { node.m_rotation[0], node.m_rotation[1], node.m_rotation[2], node.m_rotation[3] };
+                rest.m_translation = { node.m_translation[0], node.m_translation[1], node.m_translation[2] };
+                rest.m_scale = { node.m_scale[0], node.m_scale[1], node.m_scale[2] };
+                for (u32 s = 0; s < sampleCount; s++)
+                {
+                    samples[u64(s) * boneCount + b] = rest;
+                }
+            }
+            for (const Gltf::AnimationChannel& channel: _animation.m_channels)
+            {
+                const auto bone = channel.m_node ? bones.find(*channel.m_node) : bones.end();
+                if (bone == bones.end() || channel.m_path == Gltf::AnimationPath::Weights)
+                {
+                    continue;
+                }
+                SampleChannel(_document, _animation.m_samplers[channel.m_sampler], channel.m_path, bone->second, boneCount, _settings.m_sampleRate, samples);
+            }
+            CanonicalizeRotations(samples);
+
+            ClipEncoder encoder(_skeleton, samples, _settings);
+            encoder.Run();
+            const std::vector<u8> clip = WriteClip(_skeleton, encoder, samples, sampleCount, _settings.m_sampleRate);
+
+            ClipResult result;
+            result.m_output = _output;
+            result.m_name = _animation.m_name;
+            result.m_boneCount = boneCount;
+            result.m_sampleCount = sampleCount;
+            result.m_rawSize = u64(boneCount) * sampleCount * (sizeof(Float4) + 2 * sizeof(Float3));
+            result.m_size = clip.size();
+            result.m_maxError = MeasureClipError(clip, _skeleton, samples, _settings.m_shellDistance);
+            for (u32 b = 0; b < boneCount; b++)
+            {
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    result.m_trackCounts[u32(encoder.GetTrack(b, t).m_encoding)]++;
+                }
+            }
+            if (result.m_maxError > _settings.m_maxError)
+            {
+                Log::Warning(
+                    "'%s': error %.3g exceeds the bound %.3g, float precision is the limit",
+                    _output.string().c_str(),
+                    f64(result.m_maxError),
+                    f64(_settings.m_maxError));
+            }
+
+            FileSystem::WriteFile(_output, clip);
+            return result;
+        }
+
+        CacheKey MakeCacheKey(JobSystem& _jobSystem, const Gltf::Document& _document, const AnimationSettings& _settings, std::span<const std::filesystem::path> _paths)
+        {
+            CacheKeyBuilder builder("kryne-anim");
+            builder.AddU64(AnimationFormat::kVersion);
+            builder.AddU64(std::bit_cast<u32>(_settings.m_sampleRate));
+            builder.AddU64(std::bit_cast<u32>(_settings.m_maxError));
+            builder.AddU64(std::bit_cast<u32>(_settings.m_shellDistance));
+            builder.AddU64(_settings.m_skin.has_value() ? u64(*_settings.m_skin) : ~0ull);
+            builder.AddFile(_jobSystem, _settings.m_input);
+            for (const std::filesystem::path& path: _document.GetExternalBufferPaths())
+            {
+                builder.AddFile(_jobSystem, path);
+            }
+            // File names derive from the input and animation names, which are not part of the content.
+            for (const std::filesystem::path& path: _paths)
+            {
+                builder.AddString(path.filename().generic_string());
+            }
+            return builder.Build();
+        }
+
+        /// Statistics of a restored clip, from its file. The error of the clip is not stored.
+        ClipResult ReadRestoredClip(const std::filesystem::path& _output, const std::string& _name)
+        {
+            const std::vector<u8> data = FileSystem::ReadFile(_output);
+            const ClipReader reader = ClipReader::Open(data);
+            ClipResult result;
+            result.m_output = _output;
+            result.m_name = _name;
+            result.m_boneCount = reader.GetBoneCount();
+            result.m_sampleCount = reader.GetSampleCount();
+            result.m_rawSize = u64(result.m_boneCount) * result.m_sampleCount * (sizeof(Float4) + 2 * sizeof(Float3));
+            result.m_size = data.size();
+            for (u32 b = 0; b < result.m_boneCount; b++)
+            {
+                for (u32 t = 0; t < AnimationFormat::kTracksPerBone; t++)
+                {
+                    result.m_trackCounts[u32(reader.GetTrack(b, t).m_encoding)]++;
+                }
+            }
+            return result;
+        }
+    }
+
+    AnimationResult CompressAnimations(JobSystem& _jobSystem, const AnimationSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("CompressAnimations", _settings.m_input.string());
+        KT_VERIFY(_settings.m_sampleRate > 0.f, "Sample rate must be positive");
+        KT_VERIFY(_settings.m_maxError > 0.f, "Error bound must be positive");
+
+        const Gltf::Document document = Gltf::Document::Load(_settings.m_input);
+        const Skeleton skeleton = BuildSkeleton(document, _settings.m_skin);
+        const auto& animations = document.GetAnimations();
+
+        const std::filesystem::path directory = _settings.m_outputDirectory.empty()
+            ? _settings.m_input.parent_path()
+            : _settings.m_outputDirectory;
+        const std::string stem = _settings.m_input.stem().string();
+
+        std::vector<std::filesystem::path> outputs;
+        std::unordered_set<std::string> usedNames;
+        for (size_t i = 0; i < animations.size(); i++)
+        {
+            std::string name = animations.size() == 1 ? stem : stem + "_" + SanitizeFileName(animations[i].m_name);
+            if (animations.size() > 1 && animations[i].m_name.empty())
+            {
+                name += FormatString("animation%zu", i);
+            }
+            if (!usedNames.insert(name).second)
+            {
+                name += FormatString("_%zu", i);
+                usedNames.insert(name);
+            }
+            outputs.push_back(directory / (name + ".kanim"));
+        }
+        const std::filesystem::path outputDirectory = directory.empty() ? std::filesystem::path(".") : directory;
+
+        AnimationResult result;
+        result.m_clips.resize(animations.size());
+        CacheKey cacheKey;
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            cacheKey = MakeCacheKey(_jobSystem, document, _settings, outputs);
+            if (_settings.m_cache->Restore(cacheKey, outputDirectory))
+            {
+                Log::Verbose("%s: restored from cache (%s)", _settings.m_input.string().c_str(), cacheKey.ToString().c_str());
+                for (size_t i = 0; i < animations.size(); i++)
+                {
+                    result.m_clips[i] = ReadRestoredClip(outputs[i], animations[i].m_name);
+                }
+                result.m_cacheHit = true;
+                return result;
+            }
+        }
+
+        JobGroup group;
+        for (size_t i = 0; i < animations.size(); i++)
+        {
+            _jobSystem.Spawn(group, [&, i]
+            {
+                result.m_clips[i] = CompressAnimation(document, skeleton, animations[i], outputs[i], _settings);
+            });
+        }
+        _jobSystem.Wait(group);
+
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            _settings.m_cache->Store(cacheKey, outputDirectory, outputs);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,153 @@
+#include "KryneTools/Animation/ClipReader.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#include "KryneTools/Common/Error.hpp"
+#include "TrackCodec.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr Float3 kIdentityRotation { 0.f, 0.f, 0.f };
+        constexpr Float3 kIdentityTranslation { 0.f, 0.f, 0.f };
+        constexpr Float3 kIdentityScale { 1.f, 1.f, 1.f };
+
+        void CheckRange(std::span<const u8> _file, u64 _offset, u64 _size, const char* _what)
+        {
+            KT_VERIFY(_offset % 4 == 0, "Clip %s table is misaligned", _what);
+            KT_VERIFY(_offset <= _file.size() && _size <= _file.size() - _offset, "Clip %s table is out of bounds", _what);
+        }
+
+        Float3 Lerp(const Float3& _a, const Float3& _b, f32 _t)
+        {
+            return _a + (_b - _a) * _t;
+        }
+
+        Float4 Nlerp(const Float4& _a, const Float4& _b, f32 _t)
+        {
+            // Shortest arc: flip the second quaternion into the hemisphere of the first.
+            const f32 sign = _a.x * _b.x + _a.y * _b.y + _a.z * _b.z + _a.w * _b.w < 0.f ? -1.f : 1.f;
+            const Float4 q {
+                _a.x + (_b.x * sign - _a.x) * _t,
+                _a.y + (_b.y * sign - _a.y) * _t,
+                _a.z + (_b.z * sign - _a.z) * _t,
+                _a.w + (_b.w * sign - _a.w) * _t,
+            };
+            const f32 length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+            return length > 0.f ? Float4 { q.x / length, q.y / length, q.z / length, q.w / length } : Float4 { 0.f, 0.f, 0.f, 1.f };
+        }
+    }
+
+    ClipReader ClipReader::Open(std::span<const u8> _data)
+    {
+        KT_VERIFY(_data.size() >= sizeof(AnimationFormat::Header), "Truncated clip header");
+        KT_VERIFY(reinterpret_cast<uintptr_t>(_data.data()) % alignof(AnimationFormat::Header) == 0, "Clip data is misaligned");
+        const AnimationFormat::Header& header = *reinterpret_cast<const AnimationFormat::Header*>(_data.data());
+        KT_VERIFY(header.m_magic == AnimationFormat::kMagic, "Not an animation clip");
+        KT_VERIFY(header.m_version == AnimationFormat::kVersion, "Unsupported clip version %u", header.m_version);
+        KT_VERIFY(header.m_headerSize >= sizeof(AnimationFormat::Header), "Truncated clip header");
+        KT_VERIFY(header.m_fileSize <= _data.size(), "Truncated clip, %llu bytes expected", static_cast<unsigned long long>(header.m_fileSize));
+        KT_VERIFY(header.m_sampleCount > 0, "Clip has no samples");
+        KT_VERIFY(header.m_frameSize % 4 == 0, "Clip frame size is not a multiple of 4");
+        const std::span<const u8> file = _data.first(header.m_fileSize);
+
+        ClipReader reader;
+        reader.m_header = &header;
+
+        CheckRange(file, header.m_bonesOffset, u64(header.m_boneCount) * sizeof(AnimationFormat::BoneRecord), "bone");
+        reader.m_bones = reinterpret_cast<const AnimationFormat::BoneRecord*>(file.data() + header.m_bonesOffset);
+        for (u32 i = 0; i < header.m_boneCount; i++)
+        {
+            const u32 parent = reader.m_bones[i].m_parent;
+            KT_VERIFY(parent == ~0u || parent < i, "Bone %u is listed before its parent", i);
+        }
+
+        // Every animated value must lie in the frame, including the bits of its last component.
+        const u64 frameBits = u64(header.m_frameSize) * 8;
+        CheckRange(file, header.m_tracksOffset, u64(header.m_boneCount) * AnimationFormat::kTracksPerBone * sizeof(AnimationFormat::TrackRecord), "track");
+        reader.m_tracks = reinterpret_cast<const AnimationFormat::TrackRecord*>(file.data() + header.m_tracksOffset);
+        for (u32 i = 0; i < header.m_boneCount * AnimationFormat::kTracksPerBone; i++)
+        {
+            const AnimationFormat::TrackRecord& track = reader.m_tracks[i];
+            switch (track.m_encoding)
+            {
+                case AnimationFormat::TrackEncoding::Default:
+                case AnimationFormat::TrackEncoding::Constant:
+                    break;
+                case AnimationFormat::TrackEncoding::Quantized:
+                case AnimationFormat::TrackEncoding::Raw:
+                    KT_VERIFY(
+                        track.m_encoding == AnimationFormat::TrackEncoding::Raw ? track.m_bits == 32 : track.m_bits > 0 && track.m_bits < 32,
+                        "Track %u has an invalid bit rate %u",
+                        i,
+                        track.m_bits);
+                    KT_VERIFY(u64(track.m_bitOffset) + 3ull * track.m_bits <= frameBits, "Track %u is out of its frame", i);
+                    break;
+                default:
+                    ThrowError("Track %u has an unknown encoding %u", i, u32(track.m_encoding));
+            }
+        }
+
+        CheckRange(file, header.m_namesOffset, sizeof(AnimationFormat::StringTableHeader), "name");
+        const auto& names = *reinterpret_cast<const AnimationFormat::StringTableHeader*>(file.data() + header.m_namesOffset);
+        KT_VERIFY(names.m_count == header.m_boneCount, "Clip has %u bone names for %u bones", names.m_count, header.m_boneCount);
+        const u64 offsetsOffset = header.m_namesOffset + sizeof(AnimationFormat::StringTableHeader);
+        CheckRange(file, offsetsOffset, (u64(names.m_count) + 1) * sizeof(u32), "name");
+        reader.m_nameOffsets = reinterpret_cast<const u32*>(file.data() + offsetsOffset);
+        const u64 charactersOffset = offsetsOffset + (u64(names.m_count) + 1) * sizeof(u32);
+        for (u32 i = 0; i < names.m_count; i++)
+        {
+            KT_VERIFY(reader.m_nameOffsets[i] <= reader.m_nameOffsets[i + 1], "Bone name %u is out of order", i);
+        }
+        KT_VERIFY(charactersOffset + reader.m_nameOffsets[names.m_count] <= file.size(), "Clip name table is out of bounds");
+        reader.m_names = reinterpret_cast<const char*>(file.data() + charactersOffset);
+
+        CheckRange(file, header.m_framesOffset, u64(header.m_sampleCount) * header.m_frameSize + sizeof(u64), "frame");
+        reader.m_frames = file.data() + header.m_framesOffset;
+        return reader;
+    }
+
+    std::string_view ClipReader::GetBoneName(u32 _bone) const
+    {
+        return { m_names + m_nameOffsets[_bone], m_nameOffsets[_bone + 1] - m_nameOffsets[_bone] };
+    }
+
+    void ClipReader::DecodeFrame(u32 _sample, std::span<BoneTransform> _pose) const
+    {
+        const u8* frame = m_frames + u64(std::min(_sample, m_header->m_sampleCount - 1)) * m_header->m_frameSize;
+        for (u32 i = 0; i < m_header->m_boneCount && i < _pose.size(); i++)
+        {
+            const AnimationFormat::TrackRecord* tracks = m_tracks + i * AnimationFormat::kTracksPerBone;
+            _pose[i].m_rotation = TrackCodec::ReconstructRotation(TrackCodec::DecodeTrack(tracks[0], frame, kIdentityRotation));
+            _pose[i].m_translation = TrackCodec::DecodeTrack(tracks[1], frame, kIdentityTranslation);
+            _pose[i].m_scale = TrackCodec::DecodeTrack(tracks[2], frame, kIdentityScale);
+        }
+    }
+
+    void ClipReader::SamplePose(f32 _time, std::span<BoneTransform> _pose) const
+    {
+        const f32 position = std::clamp(_time * m_header->m_sampleRate, 0.f, f32(m_header->m_sampleCount - 1));
+        const u32 sample = std::min(u32(position), m_header->m_sampleCount - 1);
+        const f32 t = position - f32(sample);
+        const u8* frames[2] = {
+            m_frames + u64(sample) * m_header->m_frameSize,
+            m_frames + u64(std::min(sample + 1, m_header->m_sampleCount - 1)) * m_header->m_frameSize,
+        };
+        for (u32 i = 0; i < m_header->m_boneCount && i < _pose.size(); i++)
+        {
+            const AnimationFormat::TrackRecord* tracks = m_tracks + i * AnimationFormat::kTracksPerBone;
+            const Float4 rotations[2] = {
+                TrackCodec::ReconstructRotation(TrackCodec::DecodeTrack(tracks[0], frames[0], kIdentityRotation)),
+                TrackCodec::ReconstructRotation(TrackCodec::DecodeTrack(tracks[0], frames[1], kIdentityRotation)),
+            };
+            _pose[i].m_rotation = Nlerp(rotations[0], rotations[1], t);
+            _pose[i].m_translation = Lerp(
+                TrackCodec::DecodeTrack(tracks[1], frames[0], kIdentityTranslation),
+                TrackCodec::DecodeTrack(tracks[1], frames[1], kIdentityTranslation),
+                t);
+            _pose[i].m_scale = Lerp(TrackCodec::DecodeTrack(tracks[2], frames[0], kIdentityScale), TrackCodec::DecodeTrack(tracks[2], frames[1], kIdentityScale), t);
+        }
+    }
+}
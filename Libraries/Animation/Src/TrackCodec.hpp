@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+
+#include "KryneTools/Animation/AnimationFormat.hpp"
+#include "KryneTools/Common/Math.hpp"
+
+/// Track value decoding shared by the compressor, which measures its error on the exact decoded values, and readers.
+namespace KryneTools::TrackCodec
+{
+    [[nodiscard]] inline u32 ReadBits(const u8* _frame, u32 _bitOffset, u32 _bits)
+    {
+        u64 word;
+        std::memcpy(&word, _frame + _bitOffset / 8, sizeof(word));
+        return u32((word >> (_bitOffset % 8)) & ((u64(1) << _bits) - 1));
+    }
+
+    [[nodiscard]] inline f32 Dequantize(const AnimationFormat::TrackRecord& _track, u32 _component, u32 _value)
+    {
+        return _track.m_min[_component] + _track.m_extent[_component] * (f32(_value) / f32((u64(1) << _track.m_bits) - 1));
+    }
+
+    /// Completes stored `xyz` with a positive `w`, normalizing away the quantization error.
+    [[nodiscard]] inline Float4 ReconstructRotation(const Float3& _xyz)
+    {
+        const f32 w = std::sqrt(std::max(0.f, 1.f - Dot(_xyz, _xyz)));
+        const f32 length = std::sqrt(Dot(_xyz, _xyz) + w * w);
+        const f32 scale = length > 0.f ? 1.f / length : 0.f;
+        return { _xyz.x * scale, _xyz.y * scale, _xyz.z * scale, length > 0.f ? w * scale : 1.f };
+    }
+
+    /// Value of a track at a frame, `xyz` of rotations. `_identity` is the value of default tracks.
+    [[nodiscard]] inline Float3 DecodeTrack(const AnimationFormat::TrackRecord& _track, const u8* _frame, const Float3& _identity)
+    {
+        f32 values[3];
+        for (u32 c = 0; c < 3; c++)
+        {
+            switch (_track.m_encoding)
+            {
+                case AnimationFormat::TrackEncoding::Constant:
+                    values[c] = _track.m_min[c];
+                    break;
+                case AnimationFormat::TrackEncoding::Quantized:
+                    values[c] = Dequantize(_track, c, ReadBits(_frame, _track.m_bitOffset + c * _track.m_bits, _track.m_bits));
+                    break;
+                case AnimationFormat::TrackEncoding::Raw:
+                    {
+                        const u32 bits = ReadBits(_frame, _track.m_bitOffset + c * 32, 32);
+                        std::memcpy(&values[c], &bits, sizeof(bits));
+                    }
+                    break;
+                default:
+                    values[c] = _identity[c];
+                    break;
+            }
+        }
+        return { values[0], values[1], values[2] };
+    }
+}
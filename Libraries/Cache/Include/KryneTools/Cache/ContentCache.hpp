@@ -0,0 +1,108 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "KryneTools/Common/Hash.hpp"
+
+namespace KryneTools
+{
+    class CommandLine;
+    class JobSystem;
+
+    struct CacheKey
+    {
+        u64 m_value = 0;
+
+        [[nodiscard]] std::string ToString() const;
+        bool operator==(const CacheKey&) const = default;
+    };
+
+    /**
+     * @brief Accumulates everything a cooked artifact depends on into a cache key.
+     *
+     * @details
+     * Every key starts with the tool name and the tools build ID, so a new build never reuses artifacts of another.
+     * Each added element is length-prefixed, which keeps `("ab", "c")` and `("a", "bc")` distinct.
+     */
+    class CacheKeyBuilder
+    {
+    public:
+        explicit CacheKeyBuilder(std::string_view _toolName);
+
+        CacheKeyBuilder& AddString(std::string_view _value);
+        CacheKeyBuilder& AddU64(u64 _value);
+        CacheKeyBuilder& AddBytes(std::span<const u8> _data);
+        /// Hashes large inputs in parallel on the job system.
+        CacheKeyBuilder& AddBytes(JobSystem& _jobSystem, std::span<const u8> _data);
+        /// Adds the content of a file, not its path or timestamps.
+        CacheKeyBuilder& AddFile(JobSystem& _jobSystem, const std::filesystem::path& _path);
+
+        [[nodiscard]] CacheKey Build() const { return { m_hasher.Finalize() }; }
+
+    private:
+        Hasher64 m_hasher;
+    };
+
+    struct ContentCacheSettings
+    {
+        bool m_enabled = true;
+        /// Local cache root. Empty to use the platform user cache directory.
+        std::filesystem::path m_localDirectory;
+        /// Optional shared (usually network) cache root, looked up after the local one.
+        std::filesystem::path m_sharedDirectory;
+        /// Publish newly cooked artifacts to the shared cache, on top of the local one.
+        bool m_writeShared = false;
+
+        /**
+         * @brief Registers the common `--cache-dir`, `--shared-cache-dir`, `--write-shared-cache` and `--no-cache`
+         * options. Defaults come from `KRYNE_CACHE_DIR`, `KRYNE_SHARED_CACHE_DIR` and `KRYNE_CACHE=0`.
+         */
+        void RegisterOptions(CommandLine& _commandLine);
+
+        /// Applies the values parsed by the options registered with `RegisterOptions()`.
+        void ResolveOptions();
+
+    private:
+        std::string m_localOption;
+        std::string m_sharedOption;
+        bool m_disableOption = false;
+    };
+
+    /**
+     * @brief Content-addressed cache of cooked artifacts, shared by every tool.
+     *
+     * @details
+     * An artifact is the set of files a tool produced for one key, stored as a single blob named after the key. Blobs
+     * are written atomically (temporary file and rename) and checksummed, so concurrent tools and machines can share a
+     * cache directory without locking: a corrupted or partial blob is just a miss.
+     *
+     * Hits from the shared cache are copied to the local one.
+     */
+    class ContentCache
+    {
+    public:
+        explicit ContentCache(ContentCacheSettings _settings);
+
+        [[nodiscard]] bool IsEnabled() const { return m_settings.m_enabled; }
+
+        /**
+         * @brief Extracts the artifact files to `_outputDirectory`.
+         * @param _restoredFiles Receives the paths of the restored files, on success.
+         * @return `false` on a miss.
+         */
+        bool Restore(const CacheKey& _key, const std::filesystem::path& _outputDirectory, std::vector<std::filesystem::path>* _restoredFiles = nullptr);
+
+        /// Stores the files (which must live under `_outputDirectory`) as the artifact of `_key`.
+        void Store(const CacheKey& _key, const std::filesystem::path& _outputDirectory, std::span<const std::filesystem::path> _files);
+
+    private:
+        ContentCacheSettings m_settings;
+
+        [[nodiscard]] static std::filesystem::path GetBlobPath(const std::filesystem::path& _root, const CacheKey& _key);
+        static bool Extract(const std::filesystem::path& _blobPath, const CacheKey& _key, const std::filesystem::path& _outputDirectory, std::vector<std::filesystem::path>* _restoredFiles);
+    };
+}
@@ -0,0 +1,384 @@
+#include "KryneTools/Cache/ContentCache.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/BuildId.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kBlobMagic = MakeFourCC('K', 'C', 'A', 'C');
+        constexpr u32 kBlobVersion = 1;
+        constexpr u64 kBlobDataAlignment = 16;
+
+        struct BlobHeader
+        {
+            u32 m_magic;
+            u32 m_version;
+            u64 m_key;
+            u32 m_fileCount;
+            u32 m_reserved;
+            /// XXH64 of every byte following the header.
+            u64 m_payloadHash;
+            u64 m_payloadSize;
+        };
+
+        struct BlobEntry
+        {
+            u64 m_offset;
+            u64 m_size;
+            u32 m_nameOffset;
+            u32 m_nameSize;
+        };
+
+        std::filesystem::path GetDefaultLocalDirectory()
+        {
+#if defined(_WIN32)
+            if (const char* localAppData = std::getenv("LOCALAPPDATA"))
+            {
+                return std::filesystem::path(localAppData) / "Kryne" / "Cache";
+            }
+#else
+            if (const char* xdgCache = std::getenv("XDG_CACHE_HOME"); xdgCache != nullptr && xdgCache[0] != '\0')
+            {
+                return std::filesystem::path(xdgCache) / "kryne";
+            }
+            if (const char* home = std::getenv("HOME"))
+            {
+                return std::filesystem::path(home) / ".cache" / "kryne";
+            }
+#endif
+            return std::filesystem::temp_directory_path() / "kryne-cache";
+        }
+
+        bool IsSafeRelativeName(std::string_view _name)
+        {
+            if (_name.empty() || _name.front() == '/' || _name.find(':') != std::string_view::npos)
+            {
+                return false;
+            }
+            const std::filesystem::path path(_name);
+            for (const auto& component: path)
+            {
+                if (component == "..")
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Copies a file through its mapping, the destination appearing atomically.
+        void CopyFileAtomically(const std::filesystem::path& _from, const std::filesystem::path& _to)
+        {
+            const MappedFile source = MappedFile::Open(_from);
+            FileSystem::WriteFile(_to, source.GetData());
+        }
+
+        /// Streams a file into the writer, feeding the hasher along the way.
+        void AppendFile(FileWriter& _writer, Hasher64& _hasher, const std::filesystem::path& _path, u64 _expectedSize)
+        {
+            const MappedFile source = MappedFile::Open(_path);
+            KT_VERIFY(source.GetSize() == _expectedSize, "'%s' changed while being cached", _path.string().c_str());
+
+            // Bounded slices, releasing them once written, keep large artifacts from inflating the resident set.
+            constexpr u64 kSliceSize = 16ull << 20;
+            const std::span<const u8> data = source.GetData();
+            for (u64 offset = 0; offset < data.size(); offset += kSliceSize)
+            {
+                const std::span<const u8> slice = data.subspan(offset, std::min(kSliceSize, data.size() - offset));
+                _hasher.Update(slice);
+                _writer.Write(slice.data(), slice.size());
+                source.Release(slice);
+            }
+        }
+    }
+
+    std::string CacheKey::ToString() const
+    {
+        return FormatString("%016llx", static_cast<unsigned long long>(m_value));
+    }
+
+    CacheKeyBuilder::CacheKeyBuilder(std::string_view _toolName)
+    {
+        AddString(_toolName);
+        AddString(GetBuildId());
+    }
+
+    CacheKeyBuilder& CacheKeyBuilder::AddString(std::string_view _value)
+    {
+        m_hasher.UpdatePod(u64(_value.size()));
+        m_hasher.Update(_value);
+        return *this;
+    }
+
+    CacheKeyBuilder& CacheKeyBuilder::AddU64(u64 _value)
+    {
+        m_hasher.UpdatePod(_value);
+        return *this;
+    }
+
+    CacheKeyBuilder& CacheKeyBuilder::AddBytes(std::span<const u8> _data)
+    {
+        m_hasher.UpdatePod(u64(_data.size()));
+        m_hasher.UpdatePod(Hash64(_data));
+        return *this;
+    }
+
+    CacheKeyBuilder& CacheKeyBuilder::AddBytes(JobSystem& _jobSystem, std::span<const u8> _data)
+    {
+        m_hasher.UpdatePod(u64(_data.size()));
+        m_hasher.UpdatePod(HashParallel(_jobSystem, _data));
+        return *this;
+    }
+
+    CacheKeyBuilder& CacheKeyBuilder::AddFile(JobSystem& _jobSystem, const std::filesystem::path& _path)
+    {
+        const MappedFile file = MappedFile::Open(_path);
+        return AddBytes(_jobSystem, file.GetData());
+    }
+
+    void ContentCacheSettings::RegisterOptions(CommandLine& _commandLine)
+    {
+        if (const char* local = std::getenv("KRYNE_CACHE_DIR"))
+        {
+            m_localOption = local;
+        }
+        if (const char* shared = std::getenv("KRYNE_SHARED_CACHE_DIR"))
+        {
+            m_sharedOption = shared;
+        }
+        if (const char* enabled = std::getenv("KRYNE_CACHE"))
+        {
+            m_disableOption = std::strcmp(enabled, "0") == 0;
+        }
+
+        _commandLine.AddOption("cache-dir", "Local artifact cache directory (KRYNE_CACHE_DIR)", &m_localOption);
+        _commandLine.AddOption("shared-cache-dir", "Shared artifact cache directory (KRYNE_SHARED_CACHE_DIR)", &m_sharedOption);
+        _commandLine.AddFlag("write-shared-cache", "Publish cooked artifacts to the shared cache", &m_writeShared);
+        _commandLine.AddFlag("no-cache", "Disable the artifact cache (KRYNE_CACHE=0)", &m_disableOption);
+    }
+
+    void ContentCacheSettings::ResolveOptions()
+    {
+        m_enabled = !m_disableOption;
+        m_localDirectory = m_localOption;
+        m_sharedDirectory = m_sharedOption;
+    }
+
+    ContentCache::ContentCache(ContentCacheSettings _settings)
+        : m_settings(std::move(_settings))
+    {
+        if (m_settings.m_localDirectory.empty())
+        {
+            m_settings.m_localDirectory = GetDefaultLocalDirectory();
+        }
+    }
+
+    std::filesystem::path ContentCache::GetBlobPath(const std::filesystem::path& _root, const CacheKey& _key)
+    {
+        // Two levels fan-out keeps directories small on filesystems that do not like large ones.
+        const std::string name = _key.ToString();
+        return _root / name.substr(0, 2) / (name + ".kca");
+    }
+
+    bool ContentCache::Restore(
+        const CacheKey& _key,
+        const std::filesystem::path& _outputDirectory,
+        std::vector<std::filesystem::path>* _restoredFiles)
+    {
+        KT_TRACE_ZONE_DETAIL("ContentCache::Restore", _outputDirectory.string());
+        if (!m_settings.m_enabled)
+        {
+            return false;
+        }
+
+        std::error_code error;
+        const std::filesystem::path localPath = GetBlobPath(m_settings.m_localDirectory, _key);
+        if (std::filesystem::exists(localPath, error) && Extract(localPath, _key, _outputDirectory, _restoredFiles))
+        {
+            return true;
+        }
+
+        if (m_settings.m_sharedDirectory.empty())
+        {
+            return false;
+        }
+
+        const std::filesystem::path sharedPath = GetBlobPath(m_settings.m_sharedDirectory, _key);
+        if (!std::filesystem::exists(sharedPath, error))
+        {
+            return false;
+        }
+
+        try
+        {
+            // Pull to the local cache first: the network copy is read once, and the next lookup stays local.
+            CopyFileAtomically(sharedPath, localPath);
+        }
+        catch (const Error& exception)
+        {
+            Log::Warning("Unable to fetch %s from the shared cache: %s", _key.ToString().c_str(), exception.what());
+            return Extract(sharedPath, _key, _outputDirectory, _restoredFiles);
+        }
+        return Extract(localPath, _key, _outputDirectory, _restoredFiles);
+    }
+
+    bool ContentCache::Extract(
+        const std::filesystem::path& _blobPath,
+        const CacheKey& _key,
+        const std::filesystem::path& _outputDirectory,
+        std::vector<std::filesystem::path>* _restoredFiles)
+    {
+        try
+        {
+            const MappedFile blob = MappedFile::Open(_blobPath);
+            const std::span<const u8> data = blob.GetData();
+
+            BlobHeader header;
+            KT_VERIFY(data.size() >= sizeof(header), "truncated header");
+            std::memcpy(&header, data.data(), sizeof(header));
+            KT_VERIFY(header.m_magic == kBlobMagic && header.m_version == kBlobVersion, "unknown blob format");
+            KT_VERIFY(header.m_key == _key.m_value, "key mismatch");
+            KT_VERIFY(header.m_payloadSize == data.size() - sizeof(header), "truncated payload");
+
+            const std::span<const u8> payload = data.subspan(sizeof(header));
+            KT_VERIFY(Hash64(payload) == header.m_payloadHash, "checksum mismatch");
+
+            const u64 tableSize = u64(header.m_fileCount) * sizeof(BlobEntry);
+            KT_VERIFY(tableSize <= payload.size(), "truncated file table");
+
+            std::vector<FileSystem::FileWrite> writes;
+            writes.reserve(header.m_fileCount);
+            for (u32 i = 0; i < header.m_fileCount; i++)
+            {
+                BlobEntry entry;
+                std::memcpy(&entry, payload.data() + i * sizeof(BlobEntry), sizeof(entry));
+                KT_VERIFY(
+                    u64(entry.m_nameOffset) + entry.m_nameSize <= payload.size() && entry.m_offset + entry.m_size <= payload.size(),
+                    "entry out of range");
+
+                const std::string_view name(reinterpret_cast<const char*>(payload.data()) + entry.m_nameOffset, entry.m_nameSize);
+                KT_VERIFY(IsSafeRelativeName(name), "invalid entry name");
+
+                writes.push_back({ _outputDirectory / std::filesystem::path(name), payload.subspan(entry.m_offset, entry.m_size) });
+            }
+            // Every entry is validated first, so a corrupt blob restores nothing.
+            FileSystem::WriteFiles(writes);
+
+            if (_restoredFiles != nullptr)
+            {
+                _restoredFiles->clear();
+                for (FileSystem::FileWrite& write: writes)
+                {
+                    _restoredFiles->push_back(std::move(write.m_path));
+                }
+            }
+            return true;
+        }
+        catch (const Error& exception)
+        {
+            Log::Warning("Ignoring cache blob '%s': %s", _blobPath.string().c_str(), exception.what());
+            return false;
+        }
+    }
+
+    void ContentCache::Store(
+        const CacheKey& _key,
+        const std::filesystem::path& _outputDirectory,
+        std::span<const std::filesystem::path> _files)
+    {
+        KT_TRACE_ZONE_DETAIL("ContentCache::Store", _outputDirectory.string());
+        if (!m_settings.m_enabled)
+        {
+            return;
+        }
+
+        const std::filesystem::path localPath = GetBlobPath(m_settings.m_localDirectory, _key);
+        try
+        {
+            std::vector<BlobEntry> entries(_files.size());
+            std::string names;
+            u64 offset = sizeof(BlobEntry) * _files.size();
+            for (size_t i = 0; i < _files.size(); i++)
+            {
+                const std::string name = std::filesystem::relative(_files[i], _outputDirectory).generic_string();
+                KT_VERIFY(IsSafeRelativeName(name), "'%s' is not under the output directory", _files[i].string().c_str());
+                entries[i].m_nameOffset = u32(offset + names.size());
+                entries[i].m_nameSize = u32(name.size());
+                entries[i].m_size = std::filesystem::file_size(_files[i]);
+                names += name;
+            }
+
+            offset = AlignUp(offset + names.size(), kBlobDataAlignment);
+            for (BlobEntry& entry: entries)
+            {
+                entry.m_offset = offset;
+                offset = AlignUp(offset + entry.m_size, kBlobDataAlignment);
+            }
+
+            FileWriter writer(localPath);
+            Hasher64 hasher;
+            BlobHeader header {};
+            writer.WritePod(header);
+
+            const auto writeHashed = [&](const void* _data, u64 _size)
+            {
+                hasher.Update(_data, _size);
+                writer.Write(_data, _size);
+            };
+            const auto alignHashed = [&]
+            {
+                static constexpr u8 kZeros[kBlobDataAlignment] {};
+                writeHashed(kZeros, AlignUp(writer.Tell() - sizeof(header), kBlobDataAlignment) - (writer.Tell() - sizeof(header)));
+            };
+
+            writeHashed(entries.data(), entries.size() * sizeof(BlobEntry));
+            writeHashed(names.data(), names.size());
+            for (size_t i = 0; i < _files.size(); i++)
+            {
+                alignHashed();
+                AppendFile(writer, hasher, _files[i], entries[i].m_size);
+            }
+            alignHashed();
+
+            header.m_magic = kBlobMagic;
+            header.m_version = kBlobVersion;
+            header.m_key = _key.m_value;
+            header.m_fileCount = u32(_files.size());
+            header.m_payloadSize = writer.Tell() - sizeof(header);
+            header.m_payloadHash = hasher.Finalize();
+            writer.Seek(0);
+            writer.WritePod(header);
+            writer.Commit();
+        }
+        catch (const std::exception& exception)
+        {
+            // The cache is an accelerator: failing to fill it must never fail the cook.
+            Log::Warning("Unable to cache artifact %s: %s", _key.ToString().c_str(), exception.what());
+            return;
+        }
+
+        if (m_settings.m_writeShared && !m_settings.m_sharedDirectory.empty())
+        {
+            try
+            {
+                CopyFileAtomically(localPath, GetBlobPath(m_settings.m_sharedDirectory, _key));
+            }
+            catch (const Error& exception)
+            {
+                Log::Warning("Unable to publish %s to the shared cache: %s", _key.ToString().c_str(), exception.what());
+            }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Bump allocator for transient data, released all at once.
+     *
+     * @details
+     * Memory comes from large blocks and each allocation only moves a cursor. `Restore()` rewinds to a marker,
+     * releasing everything allocated since; its blocks are kept for the next allocations, so a long cook reaches a
+     * steady footprint instead of fragmenting the heap. Destructors are never run: only trivially destructible types
+     * belong in an arena, or containers releasing their elements themselves, such as `ArenaVector`.
+     *
+     * Not thread-safe, every thread uses its own (see `GetScratchArena()`).
+     */
+    class Arena
+    {
+    public:
+        struct Marker
+        {
+            u32 m_block = 0;
+            u64 m_offset = 0;
+        };
+
+        static constexpr u64 kDefaultBlockSize = u64(1) << 20;
+
+        explicit Arena(u64 _blockSize = kDefaultBlockSize);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /// Never returns null, throws `std::bad_alloc` like `new`.
+        [[nodiscard]] void* Allocate(u64 _size, u64 _alignment);
+
+        /// Uninitialized storage for `_count` elements.
+        template <class T>
+        [[nodiscard]] std::span<T> AllocateArray(u64 _count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "Arena memory is released without running destructors");
+            return { static_cast<T*>(Allocate(_count * sizeof(T), alignof(T))), _count };
+        }
+
+        [[nodiscard]] Marker GetMarker() const { return { m_current, m_offset }; }
+        /// Releases every allocation done since `_marker` was taken. Markers must be restored in reverse order.
+        void Restore(Marker _marker);
+
+        /// Frees blocks, last ones first, until at most `_size` bytes stay reserved. Only releases unused blocks.
+        void Trim(u64 _size);
+
+        /// Bytes handed out, counting alignment padding and the unused ends of skipped blocks.
+        [[nodiscard]] u64 GetUsedSize() const;
+        [[nodiscard]] u64 GetPeakUsedSize() const { return m_peakUsedSize; }
+        /// Restarts the peak from the current usage, to measure a scope, and returns the previous one.
+        u64 ResetPeakUsedSize();
+        /// Ends such a measure, `_previousPeak` being what `ResetPeakUsedSize()` returned.
+        void MergePeakUsedSize(u64 _previousPeak);
+        [[nodiscard]] u64 GetReservedSize() const { return m_reservedSize; }
+
+    private:
+        struct Block
+        {
+            u8* m_data;
+            u64 m_size;
+        };
+
+        u64 m_blockSize;
+        std::vector<Block> m_blocks;
+        u32 m_current = 0;
+        u64 m_offset = 0;
+        /// Sum of the sizes of the blocks before `m_current`.
+        u64 m_previousBlocksSize = 0;
+        u64 m_reservedSize = 0;
+        u64 m_peakUsedSize = 0;
+    };
+
+    /**
+     * @brief Scratch arena of the calling thread.
+     *
+     * @details
+     * `JobSystem` rewinds it after every job, so a job can use it for its transient buffers with nothing to release;
+     * functions called many times by one job should still release theirs with a `ScratchScope`.
+     */
+    [[nodiscard]] Arena& GetScratchArena();
+
+    /// Rewinds the scratch arena of the thread when leaving the scope, releasing what was allocated within.
+    class ScratchScope
+    {
+    public:
+        ScratchScope()
+            : m_arena(GetScratchArena())
+            , m_marker(m_arena.GetMarker())
+        {}
+        ~ScratchScope() { m_arena.Restore(m_marker); }
+
+        ScratchScope(const ScratchScope&) = delete;
+        ScratchScope& operator=(const ScratchScope&) = delete;
+
+        [[nodiscard]] Arena& GetArena() const { return m_arena; }
+
+    private:
+        Arena& m_arena;
+        Arena::Marker m_marker;
+    };
+
+    /**
+     * @brief Standard allocator over an arena, for containers of transient data.
+     * @details Deallocation is a no-op: memory returns to the arena when it is rewound. Containers must not outlive
+     * the scope they were allocated in, nor grow while a nested scope is open (their new storage would be released
+     * with it), nor from another thread than the one owning the arena.
+     */
+    template <class T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        ArenaAllocator(Arena& _arena) noexcept : m_arena(&_arena) {}
+        ArenaAllocator(const ScratchScope& _scope) noexcept : m_arena(&_scope.GetArena()) {}
+        template <class U>
+        ArenaAllocator(const ArenaAllocator<U>& _other) noexcept : m_arena(_other.GetArena()) {}
+
+        [[nodiscard]] T* allocate(size_t _count) { return static_cast<T*>(m_arena->Allocate(_count * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) noexcept {}
+
+        [[nodiscard]] Arena* GetArena() const { return m_arena; }
+
+        template <class U>
+        bool operator==(const ArenaAllocator<U>& _other) const { return m_arena == _other.GetArena(); }
+
+    private:
+        Arena* m_arena;
+    };
+
+    template <class T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
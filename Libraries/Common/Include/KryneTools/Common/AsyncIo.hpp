@@ -0,0 +1,134 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    enum class IoBackend: u8
+    {
+        /// Transfers run on the calling thread as they are queued, where no asynchronous backend is available.
+        Synchronous,
+        IoUring,
+        Iocp,
+    };
+
+    [[nodiscard]] const char* GetIoBackendName(IoBackend _backend);
+
+    enum class IoOpenMode: u8
+    {
+        Read,
+        /// Creates the file, or truncates it.
+        Write,
+        /// Writes to an existing file, keeping its content.
+        Update,
+    };
+
+    /// Offset, size and memory alignment of unbuffered transfers, enough for every common device.
+    inline constexpr u64 kIoAlignment = 4096;
+    /// Largest single transfer, callers split larger ones.
+    inline constexpr u64 kMaxIoTransferSize = u64(1) << 30;
+
+    struct IoBufferDeleter
+    {
+        void operator()(u8* _buffer) const;
+    };
+
+    /// Buffer aligned to `kIoAlignment`, usable for unbuffered transfers.
+    using IoBuffer = std::unique_ptr<u8[], IoBufferDeleter>;
+
+    [[nodiscard]] IoBuffer AllocateIoBuffer(u64 _size);
+
+    /// File handle for positional transfers, blocking or through an `IoQueue`.
+    class IoFile
+    {
+    public:
+        IoFile() = default;
+        ~IoFile();
+
+        IoFile(IoFile&& _other) noexcept;
+        IoFile& operator=(IoFile&& _other) noexcept;
+
+        IoFile(const IoFile&) = delete;
+        IoFile& operator=(const IoFile&) = delete;
+
+        /**
+         * @brief Opens a file, throws an `Error` on failure.
+         * @param _unbuffered Bypasses the page cache (`O_DIRECT`, `FILE_FLAG_NO_BUFFERING`), so transfer offsets,
+         * sizes and buffers must be aligned to `kIoAlignment`. Falls back to buffered IO where the filesystem refuses
+         * it, see `IsUnbuffered()`.
+         */
+        [[nodiscard]] static IoFile Open(const std::filesystem::path& _path, IoOpenMode _mode, bool _unbuffered = false);
+
+        [[nodiscard]] bool IsOpen() const;
+        [[nodiscard]] bool IsUnbuffered() const { return m_unbuffered; }
+        [[nodiscard]] u64 GetSize() const;
+
+        /// Blocking transfers, at most `kMaxIoTransferSize`. Throw an `Error` on failure or end of file.
+        void ReadAt(u64 _offset, std::span<u8> _buffer) const;
+        void WriteAt(u64 _offset, std::span<const u8> _data) const;
+
+        void Truncate(u64 _size) const;
+        void Close();
+
+    private:
+        friend class IoQueue;
+
+        /// Kept for error messages.
+        std::filesystem::path m_path;
+#if defined(_WIN32)
+        void* m_handle = nullptr;
+#else
+        int m_descriptor = -1;
+#endif
+        bool m_unbuffered = false;
+    };
+
+    /**
+     * @brief Queue of asynchronous positional reads and writes, on io_uring (Linux) or an IO completion port
+     * (Windows).
+     *
+     * @details
+     * On io_uring, transfers are queued then submitted together by the next wait, so a batch costs one system call.
+     * With IOCP they start when queued. At most
+     * `GetDepth()` transfers are in flight: callers wait for one before queuing more. Short transfers are resubmitted
+     * for the rest, and failures throw an `Error` from the wait that reaps them. Where no asynchronous backend is
+     * available (old kernels, sandboxes), transfers run when queued and throw from there.
+     *
+     * Not thread safe. Buffers must stay valid until their transfer completed, which the destructor waits for.
+     */
+    class IoQueue
+    {
+    public:
+        explicit IoQueue(u32 _depth = 32);
+        ~IoQueue();
+
+        IoQueue(const IoQueue&) = delete;
+        IoQueue& operator=(const IoQueue&) = delete;
+
+        [[nodiscard]] IoBackend GetBackend() const;
+        [[nodiscard]] u32 GetDepth() const { return m_depth; }
+        [[nodiscard]] u32 GetPendingCount() const { return m_pendingCount; }
+
+        /// @param _tag Returned by the `WaitOne()` reaping this transfer, e.g. to recycle its buffer.
+        void Read(const IoFile& _file, u64 _offset, std::span<u8> _buffer, u64 _tag = 0);
+        void Write(const IoFile& _file, u64 _offset, std::span<const u8> _data, u64 _tag = 0);
+
+        /// Submits the queued transfers and waits for any pending one to complete, returning its tag.
+        u64 WaitOne();
+        void WaitAll();
+
+    private:
+        struct Backend;
+
+        void Queue(const IoFile& _file, u64 _offset, u8* _buffer, u64 _size, bool _write, u64 _tag);
+        void Issue(u32 _slotIndex);
+
+        std::unique_ptr<Backend> m_backend;
+        u32 m_depth = 0;
+        u32 m_pendingCount = 0;
+    };
+}
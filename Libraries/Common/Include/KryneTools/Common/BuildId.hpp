@@ -0,0 +1,12 @@
+#pragma once
+
+namespace KryneTools
+{
+    /**
+     * @brief Identifier of the tools build: version, git revision and local changes digest.
+     *
+     * @details
+     * Part of every content cache key, so artifacts cooked by a different build of the tools are never reused.
+     */
+    const char* GetBuildId();
+}
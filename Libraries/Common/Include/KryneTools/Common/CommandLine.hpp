@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Minimal declarative command line parser shared by the tools.
+     *
+     * @details
+     * Options are bound to caller-owned variables, which keep their value when the option is absent, so defaults
+     * are simply the initial values. Both `--name value` and `--name=value` are accepted.
+     */
+    class CommandLine
+    {
+    public:
+        CommandLine(std::string_view _toolName, std::string_view _usage);
+
+        void AddFlag(std::string_view _name, std::string_view _help, bool* _value);
+        void AddOption(std::string_view _name, std::string_view _help, std::string* _value);
+        void AddOption(std::string_view _name, std::string_view _help, u32* _value);
+        void AddOption(std::string_view _name, std::string_view _help, f32* _value);
+        /// Repeatable option, every occurrence is appended.
+        void AddOption(std::string_view _name, std::string_view _help, std::vector<std::string>* _values);
+
+        /**
+         * @brief Parses the arguments, printing the usage on `--help` or on invalid input.
+         * @return `false` if the tool should exit. `GetExitCode()` then returns the code to exit with.
+         */
+        [[nodiscard]] bool Parse(int _argc, const char* const* _argv);
+
+        [[nodiscard]] const std::vector<std::string>& GetPositionals() const { return m_positionals; }
+        [[nodiscard]] int GetExitCode() const { return m_exitCode; }
+
+        void PrintUsage() const;
+
+    private:
+        enum class Kind
+        {
+            Flag,
+            String,
+            StringList,
+            U32,
+            F32,
+        };
+
+        struct Option
+        {
+            std::string m_name;
+            std::string m_help;
+            Kind m_kind;
+            void* m_value;
+        };
+
+        std::string m_toolName;
+        std::string m_usage;
+        std::vector<Option> m_options;
+        std::vector<std::string> m_positionals;
+        int m_exitCode = 0;
+
+        void AddOptionInternal(std::string_view _name, std::string_view _help, Kind _kind, void* _value);
+        [[nodiscard]] bool AssignValue(const Option& _option, std::string_view _value);
+    };
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /// Instruction set levels vectorized kernels are dispatched on.
+    enum class SimdLevel: u8
+    {
+        Scalar,
+        Sse42,
+        Avx2,
+        Neon,
+    };
+
+    [[nodiscard]] const char* GetSimdLevelName(SimdLevel _level);
+
+    /// Whether the running CPU and OS support the level.
+    [[nodiscard]] bool IsSimdLevelSupported(SimdLevel _level);
+
+    /**
+     * @brief Level kernels should use: the best supported one, unless forced with the `KRYNE_SIMD` environment
+     * variable (`scalar`, `sse4.2`, `avx2` or `neon`), e.g. to compare kernels against the scalar reference.
+     */
+    [[nodiscard]] SimdLevel GetSimdLevel();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define KT_PRINTF_FORMAT(formatIndex, argsIndex) __attribute__((format(printf, formatIndex, argsIndex)))
+#else
+#   define KT_PRINTF_FORMAT(formatIndex, argsIndex)
+#endif
+
+namespace KryneTools
+{
+    /**
+     * @brief Error raised by tool stages.
+     *
+     * @details
+     * Tools report unrecoverable problems (malformed inputs, I/O failures) by throwing this type. Jobs forward it to
+     * the waiting thread, and the tool entry point turns it into a diagnostic and a non-zero exit code.
+     */
+    class Error: public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /// Formats the message printf-style and throws it as an `Error`.
+    [[noreturn]] void ThrowError(const char* _format, ...) KT_PRINTF_FORMAT(1, 2);
+
+    /// printf-style formatting into a `std::string`.
+    std::string FormatString(const char* _format, ...) KT_PRINTF_FORMAT(1, 2);
+}
+
+#define KT_VERIFY(condition, ...) do { if (!(condition)) { ::KryneTools::ThrowError(__VA_ARGS__); } } while (false)
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "KryneTools/Common/AsyncIo.hpp"
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools::FileSystem
+{
+    /// Reads the whole file, throws an `Error` on failure. Large files are read in concurrent chunks.
+    [[nodiscard]] std::vector<u8> ReadFile(const std::filesystem::path& _path);
+
+    /**
+     * @brief Writes the whole file atomically.
+     *
+     * @details
+     * Data goes to a temporary sibling first, which is then renamed over the destination, so concurrent readers never
+     * observe a partially written file.
+     */
+    void WriteFile(const std::filesystem::path& _path, std::span<const u8> _data);
+
+    struct FileWrite
+    {
+        std::filesystem::path m_path;
+        std::span<const u8> m_data;
+    };
+
+    /**
+     * @brief Writes many files atomically, like `WriteFile()`, with their transfers in flight together.
+     *
+     * @details
+     * Meant for restoring many outputs at once, where one blocking write per file leaves the disk idle between
+     * system calls. Parent directories are created. On failure the files not renamed yet are discarded.
+     */
+    void WriteFiles(std::span<const FileWrite> _files);
+
+    /// Creates the parent directories of `_path` if needed.
+    void CreateParentDirectories(const std::filesystem::path& _path);
+}
+
+namespace KryneTools
+{
+    /**
+     * @brief Buffered sequential binary writer, with seek-back support to patch headers once the payload is known.
+     *
+     * @details
+     * The output is written to a temporary sibling file and only renamed to its destination by `Commit()`, so an
+     * interrupted tool never leaves a truncated file behind.
+     *
+     * Data is staged in aligned buffers written asynchronously through an `IoQueue` while the next one fills, and
+     * files fitting in one buffer cost a single write. Writes before the already flushed part, after a `Seek()`, are
+     * kept and applied by `Commit()`.
+     */
+    class FileWriter
+    {
+    public:
+        /// @param _unbuffered Bypasses the page cache, for large outputs not read back by the tool, like archives.
+        explicit FileWriter(std::filesystem::path _path, bool _unbuffered = false);
+        ~FileWriter();
+
+        FileWriter(const FileWriter&) = delete;
+        FileWriter& operator=(const FileWriter&) = delete;
+
+        void Write(const void* _data, u64 _size);
+
+        template <class T>
+        void WritePod(const T& _value)
+        {
+            Write(&_value, sizeof(T));
+        }
+
+        template <class T>
+        void WriteSpan(std::span<const T> _values)
+        {
+            Write(_values.data(), _values.size_bytes());
+        }
+
+        /// Pads with zeros up to the next multiple of `_alignment`.
+        void Align(u64 _alignment);
+
+        [[nodiscard]] u64 Tell() const { return m_position; }
+        /// Moves to `_position`, at most the current size of the output.
+        void Seek(u64 _position);
+
+        /// Flushes and moves the file to its destination. Without a commit, the destructor discards the output.
+        void Commit();
+
+    private:
+        static constexpr u32 kBufferCount = 4;
+        static constexpr u64 kBufferSize = u64(1) << 20;
+
+        void FlushBuffer();
+
+        std::filesystem::path m_path;
+        std::filesystem::path m_temporaryPath;
+        IoFile m_file;
+        /// Created with the first full buffer, small files never need one.
+        std::unique_ptr<IoQueue> m_queue;
+        IoBuffer m_buffers[kBufferCount];
+        bool m_inFlight[kBufferCount] {};
+        u32 m_current = 0;
+        /// File offset of the current buffer, everything before it is flushed or in flight.
+        u64 m_flushed = 0;
+        u64 m_position = 0;
+        u64 m_size = 0;
+        std::vector<std::pair<u64, std::vector<u8>>> m_patches;
+        bool m_committed = false;
+    };
+}
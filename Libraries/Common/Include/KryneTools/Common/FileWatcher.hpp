@@ -0,0 +1,46 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Reports the files changed in a set of directories, not recursively.
+     *
+     * @details
+     * Uses inotify on Linux and `ReadDirectoryChangesW` on Windows. Elsewhere, including macOS where FSEvents would
+     * need a run loop, the directories are polled for modification times. Files count as changed once written and
+     * closed, created, renamed over, or deleted, so editors saving through a temporary file are reported once. When
+     * the system drops notifications (inotify queue or Windows buffer overflow), every file of the affected directories
+     * is reported after a warning, so nothing is missed but deletions.
+     *
+     * Not thread safe.
+     */
+    class FileWatcher
+    {
+    public:
+        /// Throws an `Error` if a directory can not be watched.
+        explicit FileWatcher(std::span<const std::filesystem::path> _directories);
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        /**
+         * @brief Waits for changes, then returns the changed paths once none arrived for `_settleSeconds`.
+         * @details Saves touching several files, or one file several times, are gathered in one call. Returns nothing
+         * after `_timeoutSeconds` without changes, a negative timeout waiting for good.
+         */
+        [[nodiscard]] std::vector<std::filesystem::path> Wait(f64 _timeoutSeconds = -1.0, f64 _settleSeconds = 0.05);
+
+    private:
+        struct Backend;
+
+        std::unique_ptr<Backend> m_backend;
+    };
+}
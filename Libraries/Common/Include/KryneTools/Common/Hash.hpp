@@ -0,0 +1,54 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    /**
+     * @brief Streaming XXH64 hasher.
+     *
+     * @details
+     * Produces the reference XXH64 digest, whatever the way the input is split across `Update()` calls.
+     */
+    class Hasher64
+    {
+    public:
+        explicit Hasher64(u64 _seed = 0);
+
+        void Update(const void* _data, u64 _size);
+        void Update(std::span<const u8> _data) { Update(_data.data(), _data.size()); }
+        void Update(std::string_view _string) { Update(_string.data(), _string.size()); }
+
+        template <class T>
+        void UpdatePod(const T& _value)
+        {
+            Update(&_value, sizeof(T));
+        }
+
+        [[nodiscard]] u64 Finalize() const;
+
+    private:
+        u64 m_accumulators[4];
+        u64 m_seed;
+        u64 m_totalSize = 0;
+        u8 m_buffer[32];
+        u32 m_bufferSize = 0;
+    };
+
+    [[nodiscard]] u64 Hash64(const void* _data, u64 _size, u64 _seed = 0);
+    [[nodiscard]] inline u64 Hash64(std::span<const u8> _data, u64 _seed = 0) { return Hash64(_data.data(), _data.size(), _seed); }
+
+    /**
+     * @brief Content hash of large buffers, computed in parallel.
+     *
+     * @details
+     * The data is split in fixed-size chunks hashed as independent jobs, and the result is the XXH64 of the chunk
+     * digests. The value only depends on the data, never on the worker count.
+     */
+    [[nodiscard]] u64 HashParallel(JobSystem& _jobSystem, std::span<const u8> _data);
+}
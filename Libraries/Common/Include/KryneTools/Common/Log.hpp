@@ -0,0 +1,24 @@
+#pragma once
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools::Log
+{
+    enum class Level
+    {
+        Verbose,
+        Info,
+        Warning,
+        Error,
+    };
+
+    /// Messages below this level are dropped. Defaults to `Level::Info`.
+    void SetLevel(Level _level);
+    [[nodiscard]] bool IsEnabled(Level _level);
+
+    /// Thread-safe line logging: every call outputs exactly one line, never interleaved with other threads.
+    void Verbose(const char* _format, ...) KT_PRINTF_FORMAT(1, 2);
+    void Info(const char* _format, ...) KT_PRINTF_FORMAT(1, 2);
+    void Warning(const char* _format, ...) KT_PRINTF_FORMAT(1, 2);
+    void Error(const char* _format, ...) KT_PRINTF_FORMAT(1, 2);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Read-only memory mapping of a whole file.
+     *
+     * @details
+     * Used to read large inputs in place: parsers hand out views into the mapping instead of copying to intermediate
+     * buffers, and the pages only count toward the resident set while they are actually being read.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(MappedFile&& _other) noexcept;
+        MappedFile& operator=(MappedFile&& _other) noexcept;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// Maps the file, throws an `Error` on failure. Empty files give an empty, valid mapping.
+        [[nodiscard]] static MappedFile Open(const std::filesystem::path& _path);
+
+        [[nodiscard]] std::span<const u8> GetData() const { return { m_data, m_size }; }
+        [[nodiscard]] u64 GetSize() const { return m_size; }
+
+        /**
+         * @brief Hints that a range of the mapping has been consumed.
+         *
+         * @details
+         * Drops the pages fully covered by the range from the process resident set. This is purely an optimization:
+         * the data stays valid, and reading it again faults it back in (usually straight from the page cache).
+         */
+        void Release(std::span<const u8> _range) const;
+
+    private:
+        const u8* m_data = nullptr;
+        u64 m_size = 0;
+#if defined(_WIN32)
+        void* m_fileHandle = nullptr;
+        void* m_mappingHandle = nullptr;
+#endif
+
+        void Close();
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    struct Float2
+    {
+        f32 x = 0.f;
+        f32 y = 0.f;
+    };
+
+    struct Float3
+    {
+        f32 x = 0.f;
+        f32 y = 0.f;
+        f32 z = 0.f;
+
+        constexpr Float3 operator+(const Float3& _o) const { return { x + _o.x, y + _o.y, z + _o.z }; }
+        constexpr Float3 operator-(const Float3& _o) const { return { x - _o.x, y - _o.y, z - _o.z }; }
+        constexpr Float3 operator*(f32 _s) const { return { x * _s, y * _s, z * _s }; }
+        constexpr Float3 operator-() const { return { -x, -y, -z }; }
+        Float3& operator+=(const Float3& _o) { x += _o.x; y += _o.y; z += _o.z; return *this; }
+        [[nodiscard]] constexpr f32 operator[](u32 _i) const { return _i == 0 ? x : (_i == 1 ? y : z); }
+    };
+
+    struct Float4
+    {
+        f32 x = 0.f;
+        f32 y = 0.f;
+        f32 z = 0.f;
+        f32 w = 0.f;
+    };
+
+    constexpr f32 Dot(const Float3& _a, const Float3& _b)
+    {
+        return _a.x * _b.x + _a.y * _b.y + _a.z * _b.z;
+    }
+
+    constexpr Float3 Cross(const Float3& _a, const Float3& _b)
+    {
+        return { _a.y * _b.z - _a.z * _b.y, _a.z * _b.x - _a.x * _b.z, _a.x * _b.y - _a.y * _b.x };
+    }
+
+    inline f32 Length(const Float3& _v)
+    {
+        return std::sqrt(Dot(_v, _v));
+    }
+
+    inline Float3 Normalize(const Float3& _v)
+    {
+        const f32 length = Length(_v);
+        return length > 0.f ? _v * (1.f / length) : Float3 {};
+    }
+
+    constexpr Float3 Min(const Float3& _a, const Float3& _b)
+    {
+        return { std::min(_a.x, _b.x), std::min(_a.y, _b.y), std::min(_a.z, _b.z) };
+    }
+
+    constexpr Float3 Max(const Float3& _a, const Float3& _b)
+    {
+        return { std::max(_a.x, _b.x), std::max(_a.y, _b.y), std::max(_a.z, _b.z) };
+    }
+
+    struct Aabb
+    {
+        Float3 m_min { FLT_MAX, FLT_MAX, FLT_MAX };
+        Float3 m_max { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void Expand(const Float3& _point)
+        {
+            m_min = Min(m_min, _point);
+            m_max = Max(m_max, _point);
+        }
+
+        void Expand(const Aabb& _other)
+        {
+            m_min = Min(m_min, _other.m_min);
+            m_max = Max(m_max, _other.m_max);
+        }
+
+        [[nodiscard]] bool IsValid() const { return m_min.x <= m_max.x; }
+        [[nodiscard]] Float3 GetCenter() const { return (m_min + m_max) * 0.5f; }
+        [[nodiscard]] Float3 GetExtent() const { return m_max - m_min; }
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /// Memory used by a scope, such as a task graph task and every job it forked.
+    struct MemoryStatistics
+    {
+        /// Heap allocations, 0 when the tools are built without `KRYNE_TOOLS_MEMORY_TRACKING`.
+        u64 m_allocationCount = 0;
+        u64 m_allocatedBytes = 0;
+        /// Highest heap growth since the scope started: what it allocated and had not freed yet, outputs included.
+        u64 m_peakHeapBytes = 0;
+        /// Highest scratch arena usage of one of its jobs.
+        u64 m_peakArenaBytes = 0;
+    };
+
+    /**
+     * @brief Heap and scratch arena accounting of the tools, attributed to the scope allocating.
+     *
+     * @details
+     * When built with `KRYNE_TOOLS_MEMORY_TRACKING`, the global `operator new` and `operator delete` are replaced to
+     * count the allocations of the calling thread into its current `Counters`. Jobs run with the counters of the thread
+     * that spawned them, so a task accounts for every job it forks. Frees are attributed to the scope freeing, by their
+     * allocator size: a buffer a task hands to a dependent counts in its own peak, and comes off the dependent's heap.
+     * Outside of any scope an allocation only costs a thread-local load and a branch.
+     */
+    namespace Memory
+    {
+        class Counters
+        {
+        public:
+            void RecordAllocation(u64 _size)
+            {
+                m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+                m_allocatedBytes.fetch_add(_size, std::memory_order_relaxed);
+                const s64 heap = m_heapBytes.fetch_add(s64(_size), std::memory_order_relaxed) + s64(_size);
+                s64 peak = m_peakHeapBytes.load(std::memory_order_relaxed);
+                while (heap > peak && !m_peakHeapBytes.compare_exchange_weak(peak, heap, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            void RecordFree(u64 _size)
+            {
+                m_heapBytes.fetch_sub(s64(_size), std::memory_order_relaxed);
+            }
+
+            void RecordArenaPeak(u64 _size)
+            {
+                u64 peak = m_peakArenaBytes.load(std::memory_order_relaxed);
+                while (_size > peak && !m_peakArenaBytes.compare_exchange_weak(peak, _size, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            [[nodiscard]] MemoryStatistics GetStatistics() const;
+
+        private:
+            std::atomic<u64> m_allocationCount { 0 };
+            std::atomic<u64> m_allocatedBytes { 0 };
+            std::atomic<s64> m_heapBytes { 0 };
+            std::atomic<s64> m_peakHeapBytes { 0 };
+            std::atomic<u64> m_peakArenaBytes { 0 };
+        };
+
+        /// Counters of the calling thread, null outside of any scope.
+        [[nodiscard]] Counters* GetCurrentCounters();
+
+        /**
+         * @brief Makes counters current on the calling thread until the end of the scope, and records the scratch
+         * arena peak reached meanwhile, over what was in use when the scope started.
+         * @details Scopes nest: the previous counters are current again once the inner scope ends.
+         */
+        class Scope
+        {
+        public:
+            /// @param _counters Null to leave allocations unaccounted, as outside of any scope.
+            explicit Scope(Counters* _counters);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Counters* m_counters;
+            Counters* m_previous;
+            u64 m_arenaStart = 0;
+            u64 m_previousArenaPeak = 0;
+        };
+
+        struct ResidentSize
+        {
+            u64 m_currentBytes = 0;
+            /// Highest resident size of the process so far.
+            u64 m_peakBytes = 0;
+        };
+
+        /// Resident set of the process, zeros where the platform does not report it.
+        [[nodiscard]] ResidentSize GetResidentSize();
+
+        /// Physical memory of the machine, 0 if unknown.
+        [[nodiscard]] u64 GetPhysicalMemorySize();
+
+        [[nodiscard]] constexpr bool IsTrackingAllocations()
+        {
+            return KRYNE_TOOLS_MEMORY_TRACKING != 0;
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+namespace KryneTools
+{
+    struct ProcessResult
+    {
+        /// Exit code, or -1 if the process could not be started or did not exit normally.
+        int m_exitCode = -1;
+        /// Standard output and error, interleaved.
+        std::string m_output;
+    };
+
+    /**
+     * @brief Runs a program to completion and captures its output.
+     *
+     * @details
+     * `_arguments[0]` is the program, looked up in `PATH` when it has no directory. Arguments are passed as is, never
+     * through a shell. Safe to call from several jobs at once.
+     */
+    [[nodiscard]] ProcessResult RunProcess(std::span<const std::string> _arguments);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <functional>
+
+namespace KryneTools
+{
+    /**
+     * @brief Common tool entry point wrapper.
+     *
+     * @details
+     * Runs `_main`, turning any escaping exception into an error message prefixed with the tool name.
+     * @return The exit code returned by `_main`, or 1 if it threw.
+     */
+    int RunTool(const char* _toolName, const std::function<int()>& _main);
+}
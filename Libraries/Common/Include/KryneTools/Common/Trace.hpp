@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "KryneTools/Common/Types.hpp"
+
+#if defined(KRYNE_TOOLS_HAS_TRACY)
+#include <tracy/Tracy.hpp>
+#endif
+
+namespace KryneTools
+{
+    class CommandLine;
+
+    /**
+     * @brief Scoped timeline zones of the tools, recorded to a Chrome trace and, when built with Tracy, streamed live.
+     *
+     * @details
+     * Zones are opened with `KT_TRACE_ZONE()` and closed at the end of the scope. Outside of a `TraceSession` a zone
+     * costs a relaxed load and a branch, and building with `KRYNE_TOOLS_TRACING=OFF` compiles them out entirely.
+     * Recorded zones are per thread complete events, viewable in `chrome://tracing` or https://ui.perfetto.dev.
+     * Counters, such as the resident size sampled by `TaskGraph`, are drawn as graphs along the threads.
+     */
+    namespace Trace
+    {
+        /// Set by `TraceSession` while it records.
+        extern std::atomic<bool> g_recording;
+
+        [[nodiscard]] inline bool IsRecording()
+        {
+            return g_recording.load(std::memory_order_relaxed);
+        }
+
+        /// Names the calling thread in the trace. The name is copied.
+        void SetThreadName(std::string_view _name);
+
+        /// Samples a process-wide counter, drawn as a graph above the threads. `_name` must be a static string.
+        void RecordCounter(const char* _name, f64 _value);
+
+        /// Adds an argument to the innermost zone the calling thread has open, e.g. what the zone measured.
+        void AddZoneArgument(const char* _name, u64 _value);
+
+        class Zone
+        {
+        public:
+            /// @param _name Static string, only its pointer is kept.
+            explicit Zone(const char* _name)
+            {
+                if (IsRecording())
+                {
+                    Begin(_name, {});
+                }
+            }
+
+            /// @param _detail Copied, shown as the zone argument, e.g. the asset a stage works on.
+            Zone(const char* _name, std::string_view _detail)
+            {
+                if (IsRecording())
+                {
+                    Begin(_name, _detail);
+                }
+            }
+
+            /// @param _detail Returns the detail, called only while recording: building it may cost more than the zone.
+            template <class DetailFunction> requires std::invocable<DetailFunction&>
+            Zone(const char* _name, DetailFunction&& _detail)
+            {
+                if (IsRecording())
+                {
+                    Begin(_name, std::string_view(_detail()));
+                }
+            }
+
+#if defined(KRYNE_TOOLS_HAS_TRACY)
+            /// Also sets the detail as the text of `_tracyZone`, calling `_detail` once if Tracy or the session records.
+            template <class DetailFunction> requires std::invocable<DetailFunction&>
+            Zone(const char* _name, DetailFunction&& _detail, tracy::ScopedZone* _tracyZone)
+            {
+                const bool recording = IsRecording();
+                if (recording || TracyIsConnected)
+                {
+                    const auto& detail = _detail();
+                    const std::string_view text(detail);
+                    _tracyZone->Text(text.data(), text.size());
+                    if (recording)
+                    {
+                        Begin(_name, text);
+                    }
+                }
+            }
+#endif
+
+            ~Zone()
+            {
+                if (m_name != nullptr)
+                {
+                    End();
+                }
+            }
+
+            Zone(const Zone&) = delete;
+            Zone& operator=(const Zone&) = delete;
+
+        private:
+            void Begin(const char* _name, std::string_view _detail);
+            void End();
+
+            const char* m_name = nullptr;
+            std::string m_detail;
+            /// JSON members added by `AddZoneArgument()`.
+            std::string m_arguments;
+            u64 m_start = 0;
+            Zone* m_parent = nullptr;
+
+            friend void AddZoneArgument(const char* _name, u64 _value);
+        };
+    }
+
+    struct TraceSettings
+    {
+        /// Chrome trace JSON written when the session ends. Empty to not record.
+        std::filesystem::path m_output;
+
+        /// Registers the common `--trace` option, defaulting to `KRYNE_TRACE`.
+        void RegisterOptions(CommandLine& _commandLine);
+
+        /// Applies the value parsed by the option registered with `RegisterOptions()`.
+        void ResolveOptions();
+
+    private:
+        std::string m_outputOption;
+    };
+
+    /**
+     * @brief Records the zones of every thread from construction to destruction, then writes them.
+     *
+     * @details
+     * Meant to outlive the job system of the tool, so every worker zone is closed when the trace is written. Does
+     * nothing without an output, and only warns when tracing is compiled out. Write failures are logged, not thrown.
+     */
+    class TraceSession
+    {
+    public:
+        explicit TraceSession(const TraceSettings& _settings);
+        ~TraceSession();
+
+        TraceSession(const TraceSession&) = delete;
+        TraceSession& operator=(const TraceSession&) = delete;
+
+    private:
+        std::filesystem::path m_output;
+    };
+}
+
+#define KT_TRACE_CONCAT_INNER(a, b) a##b
+#define KT_TRACE_CONCAT(a, b) KT_TRACE_CONCAT_INNER(a, b)
+
+#if defined(KRYNE_TOOLS_HAS_TRACY)
+#define KT_TRACE_TRACY_ZONE(name) ZoneScopedN(name)
+/// Trailing `Zone` argument, for it to also set the detail of the Tracy zone.
+#define KT_TRACE_TRACY_ZONE_ARGUMENT , &___tracy_scoped_zone
+#else
+#define KT_TRACE_TRACY_ZONE(name)
+#define KT_TRACE_TRACY_ZONE_ARGUMENT
+#endif
+
+#if KRYNE_TOOLS_TRACING
+/// Opens a zone until the end of the scope. `name` must be a string literal.
+#define KT_TRACE_ZONE(name) \
+    KT_TRACE_TRACY_ZONE(name); \
+    const ::KryneTools::Trace::Zone KT_TRACE_CONCAT(ktTraceZone, __LINE__)(name)
+/**
+ * Opens a zone with a detail string, e.g. the path of the processed asset. `detail` is evaluated at most once, and
+ * only while recording, so it may build a string: nothing is spent on it otherwise.
+ */
+#define KT_TRACE_ZONE_DETAIL(name, detail) \
+    KT_TRACE_TRACY_ZONE(name); \
+    const ::KryneTools::Trace::Zone KT_TRACE_CONCAT(ktTraceZone, __LINE__)( \
+        name, [&]() -> decltype(auto) { return (detail); } KT_TRACE_TRACY_ZONE_ARGUMENT)
+#else
+#define KT_TRACE_ZONE(name) static_assert(true)
+#define KT_TRACE_ZONE_DETAIL(name, detail) static_assert(true)
+#endif
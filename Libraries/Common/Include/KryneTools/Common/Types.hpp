@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace KryneTools
+{
+    using u8 = uint8_t;
+    using u16 = uint16_t;
+    using u32 = uint32_t;
+    using u64 = uint64_t;
+
+    using s8 = int8_t;
+    using s16 = int16_t;
+    using s32 = int32_t;
+    using s64 = int64_t;
+
+    using f32 = float;
+    using f64 = double;
+
+    /// Rounds `value` up to the next multiple of `alignment`, which must be a power of two.
+    constexpr u64 AlignUp(u64 value, u64 alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    /// Builds a little-endian four character code, as used by every file magic of the tools.
+    constexpr u32 MakeFourCC(char a, char b, char c, char d)
+    {
+        return u32(u8(a)) | (u32(u8(b)) << 8) | (u32(u8(c)) << 16) | (u32(u8(d)) << 24);
+    }
+}
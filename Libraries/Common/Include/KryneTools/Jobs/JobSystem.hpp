@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+#include "KryneTools/Jobs/WorkStealingDeque.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    namespace Memory
+    {
+        class Counters;
+    }
+
+    /**
+     * @brief Completion tracker for a set of jobs.
+     *
+     * @details
+     * The first exception thrown by a job of the group is kept and rethrown by `JobSystem::Wait()`. Jobs of a failed
+     * group still run, but can poll `HasFailed()` to bail out early.
+     */
+    class JobGroup
+    {
+    public:
+        JobGroup() = default;
+        JobGroup(const JobGroup&) = delete;
+        JobGroup& operator=(const JobGroup&) = delete;
+
+        [[nodiscard]] bool IsDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+        [[nodiscard]] bool HasFailed() const { return m_failed.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<u32> m_pending { 0 };
+        std::atomic<bool> m_failed { false };
+        std::mutex m_exceptionMutex;
+        std::exception_ptr m_exception;
+
+        friend class JobSystem;
+    };
+
+    /**
+     * @brief Work-stealing job pool shared by every tool stage.
+     *
+     * @details
+     * Each worker owns a Chase-Lev deque: jobs spawned from a worker go to its own deque and idle workers steal from
+     * the others. Jobs spawned from any other thread go through a shared injection queue.
+     *
+     * `Wait()` never blocks a worker while there is work available: the waiting thread keeps executing jobs until its
+     * group completes. This makes nested parallelism (a primitive job waiting on its accessor decode jobs) safe, with no
+     * risk of starving the pool.
+     *
+     * Jobs run with the memory counters of the thread spawning them (see `Memory::Scope`), so whatever forks them
+     * accounts for their allocations.
+     */
+    class JobSystem
+    {
+    public:
+        using JobFunction = std::function<void()>;
+
+        /// @param _workerCount Number of worker threads, 0 to use one per hardware thread.
+        explicit JobSystem(u32 _workerCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        [[nodiscard]] u32 GetWorkerCount() const { return u32(m_workers.size()); }
+
+        void Spawn(JobGroup& _group, JobFunction _function);
+
+        /// Executes pending jobs until the group is done, then rethrows its first exception if any.
+        void Wait(JobGroup& _group);
+
+        /**
+         * @brief Adds work running outside of the job system to a group, such as a network request, until a matching
+         * `EndExternal()` from any thread. `Wait()` keeps executing jobs meanwhile, as for any pending job.
+         */
+        void BeginExternal(JobGroup& _group);
+        void EndExternal(JobGroup& _group);
+
+        /**
+         * @brief Splits `[0, _count)` in ranges of at least `_grainSize` elements, runs `_function(begin, end)` on each
+         * and waits for completion.
+         */
+        template <class Function>
+        void ParallelFor(u64 _count, u64 _grainSize, Function&& _function)
+        {
+            if (_count == 0)
+            {
+                return;
+            }
+
+            // Over-split a bit compared to the worker count, so stealing can balance uneven ranges.
+            const u64 targetChunks = u64(GetWorkerCount()) * 4;
+            const u64 chunkSize = std::max<u64>(std::max<u64>(_grainSize, 1), (_count + targetChunks - 1) / targetChunks);
+            if (chunkSize >= _count)
+            {
+                _function(u64(0), _count);
+                return;
+            }
+
+            JobGroup group;
+            for (u64 begin = 0; begin < _count; begin += chunkSize)
+            {
+                const u64 end = std::min(_count, begin + chunkSize);
+                Spawn(group, [&_function, begin, end] { _function(begin, end); });
+            }
+            Wait(group);
+        }
+
+        /// Index of the calling worker in `[0, GetWorkerCount())`, or -1 on a non-worker thread.
+        [[nodiscard]] static s32 GetCurrentWorkerIndex();
+
+    private:
+        struct Job
+        {
+            JobFunction m_function;
+            JobGroup* m_group;
+            /// Of the spawning thread, the job accounts its memory to the same scope.
+            Memory::Counters* m_counters;
+        };
+
+        struct Worker
+        {
+            WorkStealingDeque<Job*> m_deque;
+            std::thread m_thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+
+        std::mutex m_injectionMutex;
+        std::deque<Job*> m_injectionQueue;
+
+        std::mutex m_sleepMutex;
+        std::condition_variable m_sleepCondition;
+        std::atomic<u32> m_queuedJobs { 0 };
+        std::atomic<u32> m_sleepingThreads { 0 };
+        std::atomic<bool> m_stopping { false };
+
+        void WorkerMain(u32 _index);
+        [[nodiscard]] Job* FindJob(s32 _workerIndex, u32& _stealSeed);
+        void Execute(Job* _job);
+        void Complete(JobGroup& _group);
+        void WakeSleepers();
+        void SleepUntilWork(const JobGroup* _group);
+    };
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Common/Memory.hpp"
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    enum class TaskStatus: u8
+    {
+        Pending,
+        Done,
+        Failed,
+        /// Not run, as one of its dependencies failed or was skipped.
+        Skipped,
+    };
+
+    struct TaskRecord
+    {
+        std::string m_name;
+        TaskStatus m_status = TaskStatus::Pending;
+        /// Exception message of failed tasks, name of the failed dependency of skipped ones.
+        std::string m_error;
+        /// Times relative to the start of `TaskGraph::Run()`.
+        f64 m_startSeconds = 0.0;
+        f64 m_endSeconds = 0.0;
+        /// Of the task and every job it forked.
+        MemoryStatistics m_memory;
+        /// Resident size of the process when the task finished.
+        u64 m_residentBytes = 0;
+    };
+
+    struct TaskGraphStatistics
+    {
+        u32 m_doneCount = 0;
+        u32 m_failedCount = 0;
+        u32 m_skippedCount = 0;
+        f64 m_seconds = 0.0;
+        /// Longest dependency chain, summing the measured durations of its tasks: the best possible `m_seconds`.
+        f64 m_criticalPathSeconds = 0.0;
+        /// Time spent in tasks over the time of the run, at most the worker count.
+        f64 m_parallelism = 0.0;
+        /// Highest resident size of the process, sampled as tasks finish.
+        u64 m_peakResidentBytes = 0;
+        /// Ready tasks that had to wait for memory at least once, as they did not fit the budget.
+        u32 m_memoryDeferredCount = 0;
+    };
+
+    /**
+     * @brief Dependency graph of coarse tasks, run on a shared job system as soon as their dependencies are done.
+     *
+     * @details
+     * Tasks are scheduled by critical path: among ready tasks, the one heading the longest chain of estimated costs
+     * goes first, so long chains start early and short independent tasks fill the gaps. By default no more tasks than
+     * workers are in flight, the others wait in the ready queue rather than in the job deques where their priority
+     * would be lost. Tasks may fork jobs and wait on them as usual, idle workers pick those up.
+     *
+     * A throwing task fails alone: its dependents are skipped, every other task still runs, and the failures are
+     * reported in the task records rather than rethrown.
+     *
+     * Each task accounts for the memory of its jobs (see `Memory::Counters`), reported in its record and as arguments
+     * of its trace zone. With a memory budget, a ready task only starts if the estimates of the tasks in flight and
+     * its own fit, so large tasks (a few 8K textures) do not all decode at once on a many-core machine; smaller ready
+     * tasks go first meanwhile. A task estimated over the whole budget still runs, alone.
+     */
+    class TaskGraph
+    {
+    public:
+        using TaskFunction = std::function<void()>;
+
+        /// @param _cost Estimated duration, in any unit shared by every task of the graph.
+        u32 AddTask(std::string _name, f64 _cost, TaskFunction _function);
+
+        /// `_task` only starts once `_dependency` is done.
+        void AddDependency(u32 _task, u32 _dependency);
+
+        /**
+         * @brief Heap the task is expected to need at its peak, weighed against the memory budget of `Run()`.
+         * @details Once the task ran, the largest of the estimate and its measured peak is used.
+         */
+        void SetMemoryEstimate(u32 _task, u64 _bytes);
+
+        [[nodiscard]] u32 GetTaskCount() const { return u32(m_tasks.size()); }
+        [[nodiscard]] const TaskRecord& GetRecord(u32 _task) const { return m_tasks[_task].m_record; }
+
+        /**
+         * @brief Runs every task and waits for completion. Throws an `Error` if the dependencies have a cycle.
+         * @param _maxInFlight Tasks running at once, 0 for the worker count. Tasks mostly waiting on external work,
+         * such as remote jobs, warrant more.
+         * @param _memoryBudget Bytes the memory estimates of the tasks in flight may add up to, 0 for no limit.
+         */
+        TaskGraphStatistics Run(JobSystem& _jobSystem, u32 _maxInFlight = 0, u64 _memoryBudget = 0);
+
+        /**
+         * @brief Runs `_tasks` and every task depending on them, as `Run()` does, for incremental rebuilds.
+         * @details The other tasks keep their records from previous runs. Selected tasks depending on one that is not
+         * done are skipped. Statistics only cover the selected tasks.
+         */
+        TaskGraphStatistics Run(JobSystem& _jobSystem, std::span<const u32> _tasks, u32 _maxInFlight = 0, u64 _memoryBudget = 0);
+
+        /// `_tasks` and their transitive dependents, in increasing order.
+        [[nodiscard]] std::vector<u32> CollectDependents(std::span<const u32> _tasks) const;
+
+    private:
+        struct Task
+        {
+            TaskRecord m_record;
+            f64 m_cost = 0.0;
+            u64 m_memoryEstimate = 0;
+            TaskFunction m_function;
+            std::vector<u32> m_dependencies;
+            std::vector<u32> m_dependents;
+        };
+
+        std::vector<Task> m_tasks;
+
+        TaskGraphStatistics RunSelected(JobSystem& _jobSystem, const std::vector<bool>& _selected, u32 _maxInFlight, u64 _memoryBudget);
+    };
+}
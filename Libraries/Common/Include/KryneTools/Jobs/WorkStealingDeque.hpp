@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Chase-Lev work-stealing deque.
+     *
+     * @details
+     * The owner thread pushes and pops at the bottom (LIFO, cache-warm), any other thread steals from the top (FIFO,
+     * oldest and usually largest work first). Memory orderings follow Lê et al., "Correct and Efficient Work-Stealing
+     * for Weak Memory Models" (PPoPP 2013).
+     *
+     * The ring buffer grows on demand. Retired buffers are kept alive until the deque is destroyed, as a concurrent
+     * thief may still be reading from them; growth is geometric so this costs at most the size of the live buffer.
+     *
+     * @tparam T A trivially copyable type, usually a pointer.
+     */
+    template <class T>
+    class WorkStealingDeque
+    {
+    public:
+        explicit WorkStealingDeque(u64 _initialCapacity = 1024)
+        {
+            auto buffer = std::make_unique<Buffer>(_initialCapacity);
+            m_buffer.store(buffer.get(), std::memory_order_relaxed);
+            m_buffers.push_back(std::move(buffer));
+        }
+
+        /// Owner thread only.
+        void Push(T _value)
+        {
+            const s64 bottom = m_bottom.load(std::memory_order_relaxed);
+            const s64 top = m_top.load(std::memory_order_acquire);
+            Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+
+            if (bottom - top > s64(buffer->m_capacity) - 1)
+            {
+                buffer = Grow(buffer, bottom, top);
+            }
+
+            buffer->Store(bottom, _value);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        /// Owner thread only.
+        bool Pop(T& _value)
+        {
+            const s64 bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            s64 top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                // Empty, restore the canonical state.
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            _value = buffer->Load(bottom);
+            if (top == bottom)
+            {
+                // Last element, race against thieves for it.
+                const bool won = m_top.compare_exchange_strong(
+                    top,
+                    top + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /// Any thread.
+        bool Steal(T& _value)
+        {
+            s64 top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const s64 bottom = m_bottom.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+            {
+                return false;
+            }
+
+            Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+            const T value = buffer->Load(top);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return false;
+            }
+            _value = value;
+            return true;
+        }
+
+        /// Approximate, for heuristics only.
+        [[nodiscard]] bool IsEmpty() const
+        {
+            return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Buffer
+        {
+            explicit Buffer(u64 _capacity)
+                : m_capacity(_capacity)
+                , m_mask(_capacity - 1)
+                , m_elements(std::make_unique<std::atomic<T>[]>(_capacity))
+            {}
+
+            void Store(s64 _index, T _value)
+            {
+                m_elements[u64(_index) & m_mask].store(_value, std::memory_order_relaxed);
+            }
+
+            T Load(s64 _index) const
+            {
+                return m_elements[u64(_index) & m_mask].load(std::memory_order_relaxed);
+            }
+
+            u64 m_capacity;
+            u64 m_mask;
+            std::unique_ptr<std::atomic<T>[]> m_elements;
+        };
+
+        alignas(64) std::atomic<s64> m_top { 0 };
+        alignas(64) std::atomic<s64> m_bottom { 0 };
+        alignas(64) std::atomic<Buffer*> m_buffer { nullptr };
+        std::vector<std::unique_ptr<Buffer>> m_buffers;
+
+        Buffer* Grow(Buffer* _buffer, s64 _bottom, s64 _top)
+        {
+            auto grown = std::make_unique<Buffer>(_buffer->m_capacity * 2);
+            for (s64 i = _top; i < _bottom; i++)
+            {
+                grown->Store(i, _buffer->Load(i));
+            }
+            Buffer* result = grown.get();
+            m_buffers.push_back(std::move(grown));
+            m_buffer.store(result, std::memory_order_release);
+            return result;
+        }
+    };
+}
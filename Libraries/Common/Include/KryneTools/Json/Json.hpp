@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Immutable JSON document node.
+     *
+     * @details
+     * Lookups never throw: missing members and out of range indices resolve to a shared null value, and typed
+     * accessors return the provided default on type mismatch. This keeps format readers (glTF, manifests) terse, as
+     * they validate the fields they actually require explicitly.
+     *
+     * Object members keep their document order.
+     */
+    class JsonValue
+    {
+    public:
+        enum class Type: u8
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        using Array = std::vector<JsonValue>;
+        using Object = std::vector<std::pair<std::string, JsonValue>>;
+
+        JsonValue() = default;
+
+        /// Parses a complete document. Throws an `Error` with the line and column of the first syntax error.
+        [[nodiscard]] static JsonValue Parse(std::string_view _text);
+
+        [[nodiscard]] Type GetType() const { return Type(m_value.index()); }
+        [[nodiscard]] bool IsNull() const { return GetType() == Type::Null; }
+        [[nodiscard]] bool IsNumber() const { return GetType() == Type::Number; }
+        [[nodiscard]] bool IsString() const { return GetType() == Type::String; }
+        [[nodiscard]] bool IsArray() const { return GetType() == Type::Array; }
+        [[nodiscard]] bool IsObject() const { return GetType() == Type::Object; }
+
+        [[nodiscard]] bool AsBool(bool _default = false) const;
+        [[nodiscard]] f64 AsNumber(f64 _default = 0.0) const;
+        [[nodiscard]] u32 AsU32(u32 _default = 0) const;
+        [[nodiscard]] u64 AsU64(u64 _default = 0) const;
+        [[nodiscard]] std::string_view AsString(std::string_view _default = {}) const;
+        [[nodiscard]] const Array& AsArray() const;
+        [[nodiscard]] const Object& AsObject() const;
+
+        /// Number of elements for arrays, of members for objects, 0 otherwise.
+        [[nodiscard]] size_t Size() const;
+
+        [[nodiscard]] bool Contains(std::string_view _key) const;
+        [[nodiscard]] const JsonValue& operator[](std::string_view _key) const;
+        [[nodiscard]] const JsonValue& operator[](size_t _index) const;
+
+    private:
+        std::variant<std::monostate, bool, f64, std::string, Array, Object> m_value;
+
+        friend class JsonParser;
+    };
+}
@@ -0,0 +1,125 @@
+#include "KryneTools/Common/Arena.hpp"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Blocks are cache line aligned, an allocation never shares a line with the block header of another.
+        constexpr std::align_val_t kBlockAlignment { 64 };
+    }
+
+    Arena::Arena(u64 _blockSize)
+        : m_blockSize(std::max<u64>(_blockSize, 4096))
+    {}
+
+    Arena::~Arena()
+    {
+        for (const Block& block: m_blocks)
+        {
+            ::operator delete(block.m_data, kBlockAlignment);
+        }
+    }
+
+    void* Arena::Allocate(u64 _size, u64 _alignment)
+    {
+        while (true)
+        {
+            if (m_current < m_blocks.size())
+            {
+                Block& block = m_blocks[m_current];
+                const u64 offset = AlignUp(m_offset, _alignment);
+                if (offset + _size <= block.m_size)
+                {
+                    m_offset = offset + _size;
+                    m_peakUsedSize = std::max(m_peakUsedSize, m_previousBlocksSize + m_offset);
+                    return block.m_data + offset;
+                }
+                if (m_current + 1 < m_blocks.size() && m_blocks[m_current + 1].m_size >= _size + _alignment)
+                {
+                    m_previousBlocksSize += block.m_size;
+                    m_current++;
+                    m_offset = 0;
+                    continue;
+                }
+                if (m_offset == 0 && block.m_size < _size + _alignment)
+                {
+                    // An unused block too small for the request, replaced rather than left as a gap.
+                    m_reservedSize -= block.m_size;
+                    ::operator delete(block.m_data, kBlockAlignment);
+                    m_blocks.erase(m_blocks.begin() + m_current);
+                    continue;
+                }
+            }
+
+            // Blocks after the current one are unused and too small, they make room for one at least as large as
+            // everything reserved so far: a job reaches its peak in a few blocks, then reuses them on every rewind.
+            const u64 size = std::max({ m_blockSize, AlignUp(_size + _alignment, 4096), m_reservedSize });
+            while (m_blocks.size() > u64(m_current) + 1)
+            {
+                m_reservedSize -= m_blocks.back().m_size;
+                ::operator delete(m_blocks.back().m_data, kBlockAlignment);
+                m_blocks.pop_back();
+            }
+            const Block block { static_cast<u8*>(::operator new(size, kBlockAlignment)), size };
+            const u32 index = m_current < m_blocks.size() ? m_current + 1 : m_current;
+            if (index > m_current)
+            {
+                m_previousBlocksSize += m_blocks[m_current].m_size;
+            }
+            m_blocks.insert(m_blocks.begin() + index, block);
+            m_reservedSize += size;
+            m_current = index;
+            m_offset = 0;
+        }
+    }
+
+    void Arena::Restore(Marker _marker)
+    {
+        KT_VERIFY(_marker.m_block < m_current || (_marker.m_block == m_current && _marker.m_offset <= m_offset), "Arena markers restored out of order");
+        while (m_current > _marker.m_block)
+        {
+            m_current--;
+            m_previousBlocksSize -= m_blocks[m_current].m_size;
+        }
+        m_offset = _marker.m_offset;
+    }
+
+    void Arena::Trim(u64 _size)
+    {
+        // The current block is in use unless the arena is empty.
+        const u32 firstUnused = m_offset == 0 ? m_current : m_current + 1;
+        while (m_reservedSize > _size && m_blocks.size() > firstUnused)
+        {
+            m_reservedSize -= m_blocks.back().m_size;
+            ::operator delete(m_blocks.back().m_data, kBlockAlignment);
+            m_blocks.pop_back();
+        }
+    }
+
+    u64 Arena::GetUsedSize() const
+    {
+        return m_previousBlocksSize + m_offset;
+    }
+
+    u64 Arena::ResetPeakUsedSize()
+    {
+        return std::exchange(m_peakUsedSize, GetUsedSize());
+    }
+
+    void Arena::MergePeakUsedSize(u64 _previousPeak)
+    {
+        m_peakUsedSize = std::max(m_peakUsedSize, _previousPeak);
+    }
+
+    Arena& GetScratchArena()
+    {
+        thread_local Arena arena;
+        return arena;
+    }
+}
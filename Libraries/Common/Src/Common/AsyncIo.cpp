@@ -0,0 +1,739 @@
+#include "KryneTools/Common/AsyncIo.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <cerrno>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <sys/uio.h>
+#   include <unistd.h>
+#   if defined(__linux__)
+#       include <linux/io_uring.h>
+#       include <sys/mman.h>
+#       include <sys/syscall.h>
+#       if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#           define KT_IO_URING 1
+#       endif
+#   endif
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+        std::string GetSystemErrorMessage(int _code)
+        {
+            return std::system_category().message(_code);
+        }
+
+        void LogBackendFallback(const char* _backend, int _code)
+        {
+            static std::atomic<bool> logged { false };
+            if (!logged.exchange(true, std::memory_order_relaxed))
+            {
+                Log::Verbose("%s is unavailable (%s), file transfers are synchronous", _backend, GetSystemErrorMessage(_code).c_str());
+            }
+        }
+
+#if defined(_WIN32)
+        int GetLastSystemError()
+        {
+            return int(GetLastError());
+        }
+
+        /// Blocking transfer on an overlapped handle. The low bit of the event keeps it off any completion port.
+        DWORD TransferAt(void* _handle, u64 _offset, void* _buffer, u64 _size, bool _write)
+        {
+            HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            KT_VERIFY(event != nullptr, "Unable to create an event: %s", GetSystemErrorMessage(GetLastSystemError()).c_str());
+
+            OVERLAPPED overlapped {};
+            overlapped.Offset = DWORD(_offset);
+            overlapped.OffsetHigh = DWORD(_offset >> 32);
+            overlapped.hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<uintptr_t>(event) | 1);
+
+            const BOOL started = _write
+                ? ::WriteFile(_handle, _buffer, DWORD(_size), nullptr, &overlapped)
+                : ::ReadFile(_handle, _buffer, DWORD(_size), nullptr, &overlapped);
+            DWORD transferred = 0;
+            BOOL succeeded = started;
+            if (started || GetLastError() == ERROR_IO_PENDING)
+            {
+                succeeded = GetOverlappedResult(_handle, &overlapped, &transferred, TRUE);
+            }
+            const DWORD code = succeeded ? ERROR_SUCCESS : GetLastError();
+            CloseHandle(event);
+            SetLastError(code);
+            return succeeded ? transferred : 0;
+        }
+#endif
+    }
+
+    const char* GetIoBackendName(IoBackend _backend)
+    {
+        switch (_backend)
+        {
+        case IoBackend::Synchronous:
+            return "synchronous";
+        case IoBackend::IoUring:
+            return "io_uring";
+        case IoBackend::Iocp:
+            return "IOCP";
+        }
+        return "unknown";
+    }
+
+    void IoBufferDeleter::operator()(u8* _buffer) const
+    {
+        ::operator delete[](_buffer, std::align_val_t { kIoAlignment });
+    }
+
+    IoBuffer AllocateIoBuffer(u64 _size)
+    {
+        return IoBuffer(static_cast<u8*>(::operator new[](AlignUp(_size, kIoAlignment), std::align_val_t { kIoAlignment })));
+    }
+
+    IoFile::~IoFile()
+    {
+        Close();
+    }
+
+    IoFile::IoFile(IoFile&& _other) noexcept
+        : m_path(std::move(_other.m_path))
+#if defined(_WIN32)
+        , m_handle(std::exchange(_other.m_handle, nullptr))
+#else
+        , m_descriptor(std::exchange(_other.m_descriptor, -1))
+#endif
+        , m_unbuffered(std::exchange(_other.m_unbuffered, false))
+    {}
+
+    IoFile& IoFile::operator=(IoFile&& _other) noexcept
+    {
+        if (this != &_other)
+        {
+            Close();
+            m_path = std::move(_other.m_path);
+#if defined(_WIN32)
+            m_handle = std::exchange(_other.m_handle, nullptr);
+#else
+            m_descriptor = std::exchange(_other.m_descriptor, -1);
+#endif
+            m_unbuffered = std::exchange(_other.m_unbuffered, false);
+        }
+        return *this;
+    }
+
+    IoFile IoFile::Open(const std::filesystem::path& _path, IoOpenMode _mode, bool _unbuffered)
+    {
+        IoFile file;
+        file.m_path = _path;
+        const char* purpose = _mode == IoOpenMode::Read ? "reading" : "writing";
+
+#if defined(_WIN32)
+        const DWORD access = _mode == IoOpenMode::Read ? GENERIC_READ : GENERIC_WRITE;
+        const DWORD share = _mode == IoOpenMode::Read
+            ? FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE
+            : FILE_SHARE_READ | FILE_SHARE_DELETE;
+        const DWORD disposition = _mode == IoOpenMode::Write ? CREATE_ALWAYS : OPEN_EXISTING;
+        const DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED
+            | (_mode == IoOpenMode::Read ? FILE_FLAG_SEQUENTIAL_SCAN : 0);
+
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        if (_unbuffered)
+        {
+            handle = CreateFileW(_path.c_str(), access, share, nullptr, disposition, flags | FILE_FLAG_NO_BUFFERING, nullptr);
+            file.m_unbuffered = handle != INVALID_HANDLE_VALUE;
+        }
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            handle = CreateFileW(_path.c_str(), access, share, nullptr, disposition, flags, nullptr);
+        }
+        KT_VERIFY(handle != INVALID_HANDLE_VALUE, "Unable to open '%s' for %s", _path.string().c_str(), purpose);
+        file.m_handle = handle;
+#else
+        int flags = O_CLOEXEC;
+        switch (_mode)
+        {
+        case IoOpenMode::Read:
+            flags |= O_RDONLY;
+            break;
+        case IoOpenMode::Write:
+            flags |= O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+        case IoOpenMode::Update:
+            flags |= O_WRONLY;
+            break;
+        }
+
+        int descriptor = -1;
+#   if defined(O_DIRECT)
+        if (_unbuffered)
+        {
+            // Filesystems without direct IO (tmpfs, some network mounts) refuse the flag with EINVAL.
+            descriptor = open(_path.c_str(), flags | O_DIRECT, 0666);
+            file.m_unbuffered = descriptor >= 0;
+        }
+#   endif
+        if (descriptor < 0)
+        {
+            descriptor = open(_path.c_str(), flags, 0666);
+        }
+        KT_VERIFY(descriptor >= 0, "Unable to open '%s' for %s", _path.string().c_str(), purpose);
+        file.m_descriptor = descriptor;
+#endif
+        return file;
+    }
+
+    bool IoFile::IsOpen() const
+    {
+#if defined(_WIN32)
+        return m_handle != nullptr;
+#else
+        return m_descriptor >= 0;
+#endif
+    }
+
+    u64 IoFile::GetSize() const
+    {
+#if defined(_WIN32)
+        LARGE_INTEGER size {};
+        KT_VERIFY(GetFileSizeEx(m_handle, &size), "Unable to query the size of '%s'", m_path.string().c_str());
+        return u64(size.QuadPart);
+#else
+        struct stat status {};
+        KT_VERIFY(fstat(m_descriptor, &status) == 0, "Unable to query the size of '%s'", m_path.string().c_str());
+        return u64(status.st_size);
+#endif
+    }
+
+    void IoFile::ReadAt(u64 _offset, std::span<u8> _buffer) const
+    {
+        KT_VERIFY(_buffer.size() <= kMaxIoTransferSize, "Read of %llu bytes is too large", static_cast<unsigned long long>(_buffer.size()));
+        u64 done = 0;
+        while (done < _buffer.size())
+        {
+#if defined(_WIN32)
+            const DWORD read = TransferAt(m_handle, _offset + done, _buffer.data() + done, _buffer.size() - done, false);
+            if (read == 0)
+            {
+                const DWORD code = GetLastError();
+                ThrowError(
+                    "Unable to read '%s': %s",
+                    m_path.string().c_str(),
+                    code == ERROR_SUCCESS || code == ERROR_HANDLE_EOF ? "unexpected end of file" : GetSystemErrorMessage(int(code)).c_str());
+            }
+#else
+            const ssize_t read = pread(m_descriptor, _buffer.data() + done, _buffer.size() - done, off_t(_offset + done));
+            if (read < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (read <= 0)
+            {
+                ThrowError(
+                    "Unable to read '%s': %s",
+                    m_path.string().c_str(),
+                    read == 0 ? "unexpected end of file" : GetSystemErrorMessage(errno).c_str());
+            }
+#endif
+            done += u64(read);
+        }
+    }
+
+    void IoFile::WriteAt(u64 _offset, std::span<const u8> _data) const
+    {
+        KT_VERIFY(_data.size() <= kMaxIoTransferSize, "Write of %llu bytes is too large", static_cast<unsigned long long>(_data.size()));
+        u64 done = 0;
+        while (done < _data.size())
+        {
+#if defined(_WIN32)
+            const DWORD written = TransferAt(m_handle, _offset + done, const_cast<u8*>(_data.data() + done), _data.size() - done, true);
+            KT_VERIFY(written > 0, "Unable to write to '%s': %s", m_path.string().c_str(), GetSystemErrorMessage(GetLastSystemError()).c_str());
+#else
+            const ssize_t written = pwrite(m_descriptor, _data.data() + done, _data.size() - done, off_t(_offset + done));
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            KT_VERIFY(written > 0, "Unable to write to '%s': %s", m_path.string().c_str(), GetSystemErrorMessage(errno).c_str());
+#endif
+            done += u64(written);
+        }
+    }
+
+    void IoFile::Truncate(u64 _size) const
+    {
+#if defined(_WIN32)
+        FILE_END_OF_FILE_INFO info {};
+        info.EndOfFile.QuadPart = LONGLONG(_size);
+        const bool succeeded = SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &info, sizeof(info));
+#else
+        const bool succeeded = ftruncate(m_descriptor, off_t(_size)) == 0;
+#endif
+        KT_VERIFY(succeeded, "Unable to resize '%s'", m_path.string().c_str());
+    }
+
+    void IoFile::Close()
+    {
+#if defined(_WIN32)
+        if (m_handle != nullptr)
+        {
+            CloseHandle(m_handle);
+            m_handle = nullptr;
+        }
+#else
+        if (m_descriptor >= 0)
+        {
+            close(m_descriptor);
+            m_descriptor = -1;
+        }
+#endif
+        m_unbuffered = false;
+    }
+
+    struct IoQueue::Backend
+    {
+        struct Slot
+        {
+            const IoFile* m_file = nullptr;
+            u64 m_tag = 0;
+            u64 m_offset = 0;
+            u8* m_buffer = nullptr;
+            u64 m_remaining = 0;
+            bool m_write = false;
+#if defined(_WIN32)
+            OVERLAPPED m_overlapped {};
+#elif defined(KT_IO_URING)
+            iovec m_iovec {};
+#endif
+        };
+
+        IoBackend m_kind = IoBackend::Synchronous;
+        std::vector<Slot> m_slots;
+        std::vector<u32> m_freeSlots;
+        /// Tags of the transfers done by the synchronous fallback, reaped in order.
+        std::deque<u64> m_completed;
+
+#if defined(_WIN32)
+        HANDLE m_port = nullptr;
+        std::vector<HANDLE> m_associatedHandles;
+#elif defined(KT_IO_URING)
+        int m_ring = -1;
+        io_uring_params m_params {};
+        void* m_submissionRing = nullptr;
+        size_t m_submissionRingSize = 0;
+        void* m_completionRing = nullptr;
+        size_t m_completionRingSize = 0;
+        io_uring_sqe* m_entries = nullptr;
+        size_t m_entriesSize = 0;
+        u32* m_submissionTail = nullptr;
+        u32* m_submissionMask = nullptr;
+        u32* m_submissionArray = nullptr;
+        u32* m_completionHead = nullptr;
+        u32* m_completionTail = nullptr;
+        u32* m_completionMask = nullptr;
+        io_uring_cqe* m_completions = nullptr;
+        u32 m_unsubmitted = 0;
+
+        template <class T>
+        static T* AtOffset(void* _ring, u32 _offset)
+        {
+            return reinterpret_cast<T*>(static_cast<u8*>(_ring) + _offset);
+        }
+
+        bool SetupRing(u32 _depth)
+        {
+            const long ring = syscall(__NR_io_uring_setup, _depth, &m_params);
+            if (ring < 0)
+            {
+                LogBackendFallback("io_uring", errno);
+                return false;
+            }
+            m_ring = int(ring);
+
+            m_submissionRingSize = m_params.sq_off.array + m_params.sq_entries * sizeof(u32);
+            m_completionRingSize = m_params.cq_off.cqes + m_params.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMapping = (m_params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMapping)
+            {
+                m_submissionRingSize = std::max(m_submissionRingSize, m_completionRingSize);
+            }
+
+            m_submissionRing = mmap(nullptr, m_submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+            if (m_submissionRing == MAP_FAILED)
+            {
+                m_submissionRing = nullptr;
+                return false;
+            }
+            if (singleMapping)
+            {
+                m_completionRing = m_submissionRing;
+            }
+            else
+            {
+                m_completionRing = mmap(nullptr, m_completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING);
+                if (m_completionRing == MAP_FAILED)
+                {
+                    m_completionRing = nullptr;
+                    return false;
+                }
+            }
+            m_entriesSize = m_params.sq_entries * sizeof(io_uring_sqe);
+            void* entries = mmap(nullptr, m_entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+            if (entries == MAP_FAILED)
+            {
+                return false;
+            }
+            m_entries = static_cast<io_uring_sqe*>(entries);
+
+            m_submissionTail = AtOffset<u32>(m_submissionRing, m_params.sq_off.tail);
+            m_submissionMask = AtOffset<u32>(m_submissionRing, m_params.sq_off.ring_mask);
+            m_submissionArray = AtOffset<u32>(m_submissionRing, m_params.sq_off.array);
+            m_completionHead = AtOffset<u32>(m_completionRing, m_params.cq_off.head);
+            m_completionTail = AtOffset<u32>(m_completionRing, m_params.cq_off.tail);
+            m_completionMask = AtOffset<u32>(m_completionRing, m_params.cq_off.ring_mask);
+            m_completions = AtOffset<io_uring_cqe>(m_completionRing, m_params.cq_off.cqes);
+            return true;
+        }
+
+        void DestroyRing()
+        {
+            if (m_entries != nullptr)
+            {
+                munmap(m_entries, m_entriesSize);
+            }
+            if (m_completionRing != nullptr && m_completionRing != m_submissionRing)
+            {
+                munmap(m_completionRing, m_completionRingSize);
+            }
+            if (m_submissionRing != nullptr)
+            {
+                munmap(m_submissionRing, m_submissionRingSize);
+            }
+            if (m_ring >= 0)
+            {
+                close(m_ring);
+            }
+            *this = {};
+        }
+
+        /// Only this thread produces submissions, the kernel reads the tail once released.
+        void Push(u32 _slotIndex)
+        {
+            Slot& slot = m_slots[_slotIndex];
+            slot.m_iovec = { slot.m_buffer, size_t(slot.m_remaining) };
+
+            const u32 tail = *m_submissionTail;
+            const u32 index = tail & *m_submissionMask;
+            io_uring_sqe& entry = m_entries[index];
+            std::memset(&entry, 0, sizeof(entry));
+            entry.opcode = slot.m_write ? IORING_OP_WRITEV : IORING_OP_READV;
+            entry.fd = slot.m_file->m_descriptor;
+            entry.off = slot.m_offset;
+            entry.addr = reinterpret_cast<u64>(&slot.m_iovec);
+            entry.len = 1;
+            entry.user_data = _slotIndex;
+            m_submissionArray[index] = index;
+            std::atomic_ref(*m_submissionTail).store(tail + 1, std::memory_order_release);
+            m_unsubmitted++;
+        }
+
+        /// Submits the pushed entries, and waits for `_minCompletions`.
+        void Enter(u32 _minCompletions)
+        {
+            while (true)
+            {
+                const long result = syscall(
+                    __NR_io_uring_enter,
+                    m_ring,
+                    m_unsubmitted,
+                    _minCompletions,
+                    _minCompletions > 0 ? IORING_ENTER_GETEVENTS : 0u,
+                    nullptr,
+                    size_t(0));
+                if (result >= 0)
+                {
+                    m_unsubmitted -= u32(result);
+                    if (m_unsubmitted == 0 || _minCompletions > 0)
+                    {
+                        return;
+                    }
+                }
+                else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    ThrowError("Unable to submit file transfers: %s", GetSystemErrorMessage(errno).c_str());
+                }
+            }
+        }
+
+        bool PopCompletion(u32& _slotIndex, s64& _result)
+        {
+            const u32 head = *m_completionHead;
+            if (head == std::atomic_ref(*m_completionTail).load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            const io_uring_cqe& completion = m_completions[head & *m_completionMask];
+            _slotIndex = u32(completion.user_data);
+            _result = completion.res;
+            std::atomic_ref(*m_completionHead).store(head + 1, std::memory_order_release);
+            return true;
+        }
+#endif
+    };
+
+    IoQueue::IoQueue(u32 _depth)
+        : m_backend(std::make_unique<Backend>())
+        , m_depth(std::max(_depth, 1u))
+    {
+#if defined(_WIN32)
+        m_backend->m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        if (m_backend->m_port != nullptr)
+        {
+            m_backend->m_kind = IoBackend::Iocp;
+        }
+        else
+        {
+            LogBackendFallback("IOCP", GetLastSystemError());
+        }
+#elif defined(KT_IO_URING)
+        if (m_backend->SetupRing(m_depth))
+        {
+            m_backend->m_kind = IoBackend::IoUring;
+        }
+        else
+        {
+            m_backend->DestroyRing();
+        }
+#endif
+        m_backend->m_slots.resize(m_depth);
+        m_backend->m_freeSlots.reserve(m_depth);
+        for (u32 i = m_depth; i > 0; i--)
+        {
+            m_backend->m_freeSlots.push_back(i - 1);
+        }
+    }
+
+    IoQueue::~IoQueue()
+    {
+        while (m_pendingCount > 0)
+        {
+            try
+            {
+                WaitOne();
+            }
+            catch (const std::exception&)
+            {
+                // The owner is already unwinding from an error, or discarding the output.
+            }
+        }
+#if defined(_WIN32)
+        if (m_backend->m_port != nullptr)
+        {
+            CloseHandle(m_backend->m_port);
+        }
+#elif defined(KT_IO_URING)
+        m_backend->DestroyRing();
+#endif
+    }
+
+    IoBackend IoQueue::GetBackend() const
+    {
+        return m_backend->m_kind;
+    }
+
+    void IoQueue::Read(const IoFile& _file, u64 _offset, std::span<u8> _buffer, u64 _tag)
+    {
+        Queue(_file, _offset, _buffer.data(), _buffer.size(), false, _tag);
+    }
+
+    void IoQueue::Write(const IoFile& _file, u64 _offset, std::span<const u8> _data, u64 _tag)
+    {
+        // The buffer is only read from, the slot is shared with reads.
+        Queue(_file, _offset, const_cast<u8*>(_data.data()), _data.size(), true, _tag);
+    }
+
+    void IoQueue::Queue(const IoFile& _file, u64 _offset, u8* _buffer, u64 _size, bool _write, u64 _tag)
+    {
+        KT_VERIFY(m_pendingCount < m_depth, "IO queue is full, wait for a transfer first");
+        KT_VERIFY(_size <= kMaxIoTransferSize, "Transfer of %llu bytes is too large", static_cast<unsigned long long>(_size));
+        Backend& backend = *m_backend;
+
+        if (backend.m_kind == IoBackend::Synchronous)
+        {
+            if (_write)
+            {
+                _file.WriteAt(_offset, { _buffer, _size });
+            }
+            else
+            {
+                _file.ReadAt(_offset, { _buffer, _size });
+            }
+            backend.m_completed.push_back(_tag);
+            m_pendingCount++;
+            return;
+        }
+
+        const u32 slotIndex = backend.m_freeSlots.back();
+        Backend::Slot& slot = backend.m_slots[slotIndex];
+        slot.m_file = &_file;
+        slot.m_tag = _tag;
+        slot.m_offset = _offset;
+        slot.m_buffer = _buffer;
+        slot.m_remaining = _size;
+        slot.m_write = _write;
+
+#if defined(_WIN32)
+        bool associated = false;
+        for (HANDLE handle: backend.m_associatedHandles)
+        {
+            associated |= handle == _file.m_handle;
+        }
+        if (!associated)
+        {
+            KT_VERIFY(
+                CreateIoCompletionPort(_file.m_handle, backend.m_port, 0, 0) != nullptr,
+                "Unable to queue transfers on '%s': %s",
+                _file.m_path.string().c_str(),
+                GetSystemErrorMessage(GetLastSystemError()).c_str());
+            backend.m_associatedHandles.push_back(_file.m_handle);
+        }
+#endif
+
+        Issue(slotIndex);
+        backend.m_freeSlots.pop_back();
+        m_pendingCount++;
+    }
+
+    void IoQueue::Issue(u32 _slotIndex)
+    {
+#if defined(_WIN32)
+        Backend::Slot& slot = m_backend->m_slots[_slotIndex];
+        slot.m_overlapped = {};
+        slot.m_overlapped.Offset = DWORD(slot.m_offset);
+        slot.m_overlapped.OffsetHigh = DWORD(slot.m_offset >> 32);
+        const BOOL started = slot.m_write
+            ? ::WriteFile(slot.m_file->m_handle, slot.m_buffer, DWORD(slot.m_remaining), nullptr, &slot.m_overlapped)
+            : ::ReadFile(slot.m_file->m_handle, slot.m_buffer, DWORD(slot.m_remaining), nullptr, &slot.m_overlapped);
+        // Transfers completing right away still post to the port.
+        KT_VERIFY(
+            started || GetLastError() == ERROR_IO_PENDING,
+            "Unable to %s '%s': %s",
+            slot.m_write ? "write to" : "read",
+            slot.m_file->m_path.string().c_str(),
+            GetSystemErrorMessage(GetLastSystemError()).c_str());
+#elif defined(KT_IO_URING)
+        m_backend->Push(_slotIndex);
+#else
+        (void)_slotIndex;
+#endif
+    }
+
+    u64 IoQueue::WaitOne()
+    {
+        KT_VERIFY(m_pendingCount > 0, "No pending file transfer to wait for");
+        Backend& backend = *m_backend;
+
+        if (backend.m_kind == IoBackend::Synchronous)
+        {
+            const u64 tag = backend.m_completed.front();
+            backend.m_completed.pop_front();
+            m_pendingCount--;
+            return tag;
+        }
+
+        while (true)
+        {
+            u32 slotIndex = 0;
+            s64 result = 0;
+#if defined(_WIN32)
+            DWORD transferred = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* overlapped = nullptr;
+            BOOL succeeded = FALSE;
+            {
+                KT_TRACE_ZONE("IoQueue::Wait");
+                succeeded = GetQueuedCompletionStatus(backend.m_port, &transferred, &key, &overlapped, INFINITE);
+            }
+            if (overlapped == nullptr)
+            {
+                // The port itself failed, nothing will complete anymore.
+                m_pendingCount = 0;
+                ThrowError("Unable to wait for file transfers: %s", GetSystemErrorMessage(GetLastSystemError()).c_str());
+            }
+            const auto* slotAddress = reinterpret_cast<const u8*>(overlapped) - offsetof(Backend::Slot, m_overlapped);
+            slotIndex = u32(reinterpret_cast<const Backend::Slot*>(slotAddress) - backend.m_slots.data());
+            const DWORD code = succeeded ? ERROR_SUCCESS : GetLastError();
+            result = succeeded ? s64(transferred) : code == ERROR_HANDLE_EOF ? 0 : -s64(code);
+#elif defined(KT_IO_URING)
+            while (!backend.PopCompletion(slotIndex, result))
+            {
+                KT_TRACE_ZONE("IoQueue::Wait");
+                try
+                {
+                    backend.Enter(1);
+                }
+                catch (const Error&)
+                {
+                    m_pendingCount = 0;
+                    throw;
+                }
+            }
+            if (backend.m_unsubmitted > 0)
+            {
+                backend.Enter(0);
+            }
+#endif
+
+            Backend::Slot& slot = backend.m_slots[slotIndex];
+            if (result > 0 && u64(result) < slot.m_remaining)
+            {
+                // Short transfer, the rest is resubmitted in place.
+                slot.m_offset += u64(result);
+                slot.m_buffer += result;
+                slot.m_remaining -= u64(result);
+                Issue(slotIndex);
+                continue;
+            }
+
+            const u64 tag = slot.m_tag;
+            const IoFile* file = slot.m_file;
+            const bool write = slot.m_write;
+            backend.m_freeSlots.push_back(slotIndex);
+            m_pendingCount--;
+            if (result <= 0 && slot.m_remaining > 0)
+            {
+                ThrowError(
+                    write ? "Unable to write to '%s': %s" : "Unable to read '%s': %s",
+                    file->m_path.string().c_str(),
+                    result == 0 ? "unexpected end of file" : GetSystemErrorMessage(int(-result)).c_str());
+            }
+            return tag;
+        }
+    }
+
+    void IoQueue::WaitAll()
+    {
+        while (m_pendingCount > 0)
+        {
+            WaitOne();
+        }
+    }
+}
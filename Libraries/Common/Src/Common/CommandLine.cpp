@@ -0,0 +1,184 @@
+#include "KryneTools/Common/CommandLine.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+
+namespace KryneTools
+{
+    CommandLine::CommandLine(std::string_view _toolName, std::string_view _usage)
+        : m_toolName(_toolName)
+        , m_usage(_usage)
+    {}
+
+    void CommandLine::AddFlag(std::string_view _name, std::string_view _help, bool* _value)
+    {
+        AddOptionInternal(_name, _help, Kind::Flag, _value);
+    }
+
+    void CommandLine::AddOption(std::string_view _name, std::string_view _help, std::string* _value)
+    {
+        AddOptionInternal(_name, _help, Kind::String, _value);
+    }
+
+    void CommandLine::AddOption(std::string_view _name, std::string_view _help, u32* _value)
+    {
+        AddOptionInternal(_name, _help, Kind::U32, _value);
+    }
+
+    void CommandLine::AddOption(std::string_view _name, std::string_view _help, f32* _value)
+    {
+        AddOptionInternal(_name, _help, Kind::F32, _value);
+    }
+
+    void CommandLine::AddOption(std::string_view _name, std::string_view _help, std::vector<std::string>* _values)
+    {
+        AddOptionInternal(_name, _help, Kind::StringList, _values);
+    }
+
+    void CommandLine::AddOptionInternal(std::string_view _name, std::string_view _help, Kind _kind, void* _value)
+    {
+        m_options.push_back({ std::string(_name), std::string(_help), _kind, _value });
+    }
+
+    bool CommandLine::Parse(int _argc, const char* const* _argv)
+    {
+        bool positionalOnly = false;
+        for (int i = 1; i < _argc; i++)
+        {
+            const std::string_view argument = _argv[i];
+
+            if (positionalOnly || argument.size() < 2 || argument[0] != '-')
+            {
+                m_positionals.emplace_back(argument);
+                continue;
+            }
+
+            if (argument == "--")
+            {
+                positionalOnly = true;
+                continue;
+            }
+
+            if (argument == "-h" || argument == "--help")
+            {
+                PrintUsage();
+                m_exitCode = 0;
+                return false;
+            }
+
+            std::string_view name = argument.substr(argument[1] == '-' ? 2 : 1);
+            std::string_view inlineValue;
+            bool hasInlineValue = false;
+            if (const size_t equal = name.find('='); equal != std::string_view::npos)
+            {
+                inlineValue = name.substr(equal + 1);
+                name = name.substr(0, equal);
+                hasInlineValue = true;
+            }
+
+            const Option* option = nullptr;
+            for (const Option& candidate: m_options)
+            {
+                if (candidate.m_name == name)
+                {
+                    option = &candidate;
+                    break;
+                }
+            }
+
+            if (option == nullptr)
+            {
+                std::fprintf(stderr, "%s: unknown option '%.*s'\n", m_toolName.c_str(), int(argument.size()), argument.data());
+                m_exitCode = 2;
+                return false;
+            }
+
+            if (option->m_kind == Kind::Flag)
+            {
+                *static_cast<bool*>(option->m_value) = !hasInlineValue || (inlineValue != "0" && inlineValue != "false");
+                continue;
+            }
+
+            if (!hasInlineValue)
+            {
+                if (i + 1 >= _argc)
+                {
+                    std::fprintf(stderr, "%s: option '--%s' expects a value\n", m_toolName.c_str(), option->m_name.c_str());
+                    m_exitCode = 2;
+                    return false;
+                }
+                inlineValue = _argv[++i];
+            }
+
+            if (!AssignValue(*option, inlineValue))
+            {
+                std::fprintf(
+                    stderr,
+                    "%s: invalid value '%.*s' for option '--%s'\n",
+                    m_toolName.c_str(),
+                    int(inlineValue.size()),
+                    inlineValue.data(),
+                    option->m_name.c_str());
+                m_exitCode = 2;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool CommandLine::AssignValue(const Option& _option, std::string_view _value)
+    {
+        switch (_option.m_kind)
+        {
+            case Kind::String:
+                *static_cast<std::string*>(_option.m_value) = _value;
+                return true;
+            case Kind::StringList:
+                static_cast<std::vector<std::string>*>(_option.m_value)->emplace_back(_value);
+                return true;
+            case Kind::U32:
+            {
+                u32 result;
+                const auto [end, error] = std::from_chars(_value.data(), _value.data() + _value.size(), result);
+                if (error != std::errc() || end != _value.data() + _value.size())
+                {
+                    return false;
+                }
+                *static_cast<u32*>(_option.m_value) = result;
+                return true;
+            }
+            case Kind::F32:
+            {
+                // from_chars for floating points is not available on every standard library we target.
+                const std::string copy(_value);
+                char* end = nullptr;
+                const float result = std::strtof(copy.c_str(), &end);
+                if (end != copy.c_str() + copy.size())
+                {
+                    return false;
+                }
+                *static_cast<f32*>(_option.m_value) = result;
+                return true;
+            }
+            case Kind::Flag:
+                break;
+        }
+        return false;
+    }
+
+    void CommandLine::PrintUsage() const
+    {
+        std::printf("usage: %s %s\n\noptions:\n", m_toolName.c_str(), m_usage.c_str());
+        std::printf("  %-28s %s\n", "-h, --help", "Show this help");
+        for (const Option& option: m_options)
+        {
+            std::string name = "--" + option.m_name;
+            if (option.m_kind != Kind::Flag)
+            {
+                name += " <value>";
+            }
+            std::printf("  %-28s %s\n", name.c_str(), option.m_help.c_str());
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include "KryneTools/Common/CpuFeatures.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "KryneTools/Common/Log.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#   define KT_CPU_X86 1
+#endif
+
+#if defined(KT_CPU_X86) && defined(_MSC_VER)
+#   include <immintrin.h>
+#   include <intrin.h>
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+#if defined(KT_CPU_X86) && defined(_MSC_VER)
+        bool HasX86Feature(SimdLevel _level)
+        {
+            int registers[4];
+            __cpuid(registers, 1);
+            const bool sse42 = (registers[2] & (1 << 20)) != 0;
+            if (_level == SimdLevel::Sse42)
+            {
+                return sse42;
+            }
+
+            // AVX state must be enabled by the OS as well, not only reported by the CPU.
+            const bool osxsave = (registers[2] & (1 << 27)) != 0;
+            const bool avx = (registers[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            {
+                return false;
+            }
+            __cpuidex(registers, 7, 0);
+            return (registers[1] & (1 << 5)) != 0;
+        }
+#elif defined(KT_CPU_X86)
+        bool HasX86Feature(SimdLevel _level)
+        {
+            // Also checks the OS saves the AVX state.
+            return _level == SimdLevel::Sse42 ? __builtin_cpu_supports("sse4.2") : __builtin_cpu_supports("avx2");
+        }
+#endif
+
+        SimdLevel DetectSimdLevel()
+        {
+            SimdLevel best = SimdLevel::Scalar;
+            for (const SimdLevel level: { SimdLevel::Sse42, SimdLevel::Avx2, SimdLevel::Neon })
+            {
+                if (IsSimdLevelSupported(level))
+                {
+                    best = level;
+                }
+            }
+
+            const char* forced = std::getenv("KRYNE_SIMD");
+            if (forced == nullptr || forced[0] == '\0')
+            {
+                return best;
+            }
+            for (const SimdLevel level: { SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2, SimdLevel::Neon })
+            {
+                if (std::strcmp(forced, GetSimdLevelName(level)) == 0)
+                {
+                    if (IsSimdLevelSupported(level))
+                    {
+                        return level;
+                    }
+                    Log::Warning("KRYNE_SIMD=%s is not supported by this CPU, using %s", forced, GetSimdLevelName(best));
+                    return best;
+                }
+            }
+            Log::Warning("Unknown KRYNE_SIMD value '%s', using %s", forced, GetSimdLevelName(best));
+            return best;
+        }
+    }
+
+    const char* GetSimdLevelName(SimdLevel _level)
+    {
+        switch (_level)
+        {
+            case SimdLevel::Scalar: return "scalar";
+            case SimdLevel::Sse42: return "sse4.2";
+            case SimdLevel::Avx2: return "avx2";
+            case SimdLevel::Neon: return "neon";
+        }
+        return "unknown";
+    }
+
+    bool IsSimdLevelSupported(SimdLevel _level)
+    {
+        switch (_level)
+        {
+            case SimdLevel::Scalar:
+                return true;
+            case SimdLevel::Sse42:
+            case SimdLevel::Avx2:
+#if defined(KT_CPU_X86)
+                return HasX86Feature(_level);
+#else
+                return false;
+#endif
+            case SimdLevel::Neon:
+                // Part of the AArch64 baseline.
+#if defined(__aarch64__) || defined(_M_ARM64)
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    SimdLevel GetSimdLevel()
+    {
+        static const SimdLevel level = DetectSimdLevel();
+        return level;
+    }
+}
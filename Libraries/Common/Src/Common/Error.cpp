@@ -0,0 +1,45 @@
+#include "KryneTools/Common/Error.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace KryneTools
+{
+    namespace
+    {
+        std::string FormatStringV(const char* _format, va_list _args)
+        {
+            va_list argsCopy;
+            va_copy(argsCopy, _args);
+            const int size = std::vsnprintf(nullptr, 0, _format, argsCopy);
+            va_end(argsCopy);
+
+            if (size <= 0)
+            {
+                return {};
+            }
+
+            std::string result(size_t(size), '\0');
+            std::vsnprintf(result.data(), result.size() + 1, _format, _args);
+            return result;
+        }
+    }
+
+    void ThrowError(const char* _format, ...)
+    {
+        va_list args;
+        va_start(args, _format);
+        std::string message = FormatStringV(_format, args);
+        va_end(args);
+        throw Error(message);
+    }
+
+    std::string FormatString(const char* _format, ...)
+    {
+        va_list args;
+        va_start(args, _format);
+        std::string result = FormatStringV(_format, args);
+        va_end(args);
+        return result;
+    }
+}
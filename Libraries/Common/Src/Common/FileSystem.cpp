@@ -0,0 +1,283 @@
+#include "KryneTools/Common/FileSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <system_error>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Files up to this size are read with one blocking call.
+        constexpr u64 kReadChunkSize = u64(4) << 20;
+        constexpr u32 kReadQueueDepth = 8;
+        /// Files opened at once by `WriteFiles()`.
+        constexpr size_t kWriteBatchSize = 64;
+        constexpr u32 kWriteQueueDepth = 32;
+
+        std::filesystem::path MakeTemporarySibling(const std::filesystem::path& _path)
+        {
+            // Unique per process and per call, so parallel jobs writing next to each other never collide.
+            static std::atomic<u32> counter { 0 };
+            std::filesystem::path result = _path;
+            result += FormatString(".tmp%u", counter.fetch_add(1, std::memory_order_relaxed));
+            return result;
+        }
+
+        void RenameOver(const std::filesystem::path& _from, const std::filesystem::path& _to)
+        {
+            std::error_code error;
+            std::filesystem::rename(_from, _to, error);
+            if (error)
+            {
+                std::filesystem::remove(_from, error);
+                ThrowError("Unable to move '%s' to its destination", _to.string().c_str());
+            }
+        }
+    }
+
+    std::vector<u8> FileSystem::ReadFile(const std::filesystem::path& _path)
+    {
+        KT_TRACE_ZONE_DETAIL("ReadFile", _path.string());
+        const IoFile file = IoFile::Open(_path, IoOpenMode::Read);
+        std::vector<u8> data(file.GetSize());
+        if (data.size() <= kReadChunkSize)
+        {
+            if (!data.empty())
+            {
+                file.ReadAt(0, data);
+            }
+            return data;
+        }
+
+        IoQueue queue(kReadQueueDepth);
+        for (u64 offset = 0; offset < data.size(); offset += kReadChunkSize)
+        {
+            if (queue.GetPendingCount() == queue.GetDepth())
+            {
+                queue.WaitOne();
+            }
+            queue.Read(file, offset, { data.data() + offset, std::min<u64>(kReadChunkSize, data.size() - offset) });
+        }
+        queue.WaitAll();
+        return data;
+    }
+
+    void FileSystem::WriteFile(const std::filesystem::path& _path, std::span<const u8> _data)
+    {
+        KT_TRACE_ZONE_DETAIL("WriteFile", _path.string());
+        FileWriter writer(_path);
+        writer.Write(_data.data(), _data.size());
+        writer.Commit();
+    }
+
+    void FileSystem::WriteFiles(std::span<const FileWrite> _files)
+    {
+        KT_TRACE_ZONE("WriteFiles");
+        std::vector<std::filesystem::path> temporaryPaths;
+        std::vector<IoFile> files;
+        for (size_t begin = 0; begin < _files.size(); begin += kWriteBatchSize)
+        {
+            const std::span<const FileWrite> batch = _files.subspan(begin, std::min(kWriteBatchSize, _files.size() - begin));
+            temporaryPaths.clear();
+            // Queued transfers point to their file, which must not move.
+            files.clear();
+            files.reserve(batch.size());
+
+            size_t renamed = 0;
+            try
+            {
+                {
+                    IoQueue queue(kWriteQueueDepth);
+                    for (const FileWrite& write: batch)
+                    {
+                        CreateParentDirectories(write.m_path);
+                        temporaryPaths.push_back(MakeTemporarySibling(write.m_path));
+                        const IoFile& file = files.emplace_back(IoFile::Open(temporaryPaths.back(), IoOpenMode::Write));
+                        for (u64 offset = 0; offset < write.m_data.size(); offset += kMaxIoTransferSize)
+                        {
+                            if (queue.GetPendingCount() == queue.GetDepth())
+                            {
+                                queue.WaitOne();
+                            }
+                            queue.Write(file, offset, write.m_data.subspan(offset, std::min(kMaxIoTransferSize, write.m_data.size() - offset)));
+                        }
+                    }
+                    queue.WaitAll();
+                }
+                files.clear();
+                for (; renamed < batch.size(); renamed++)
+                {
+                    RenameOver(temporaryPaths[renamed], batch[renamed].m_path);
+                }
+            }
+            catch (...)
+            {
+                // The queue waited for its transfers when unwinding, the files can go.
+                files.clear();
+                for (size_t i = renamed; i < temporaryPaths.size(); i++)
+                {
+                    std::error_code error;
+                    std::filesystem::remove(temporaryPaths[i], error);
+                }
+                throw;
+            }
+        }
+    }
+
+    void FileSystem::CreateParentDirectories(const std::filesystem::path& _path)
+    {
+        const std::filesystem::path parent = _path.parent_path();
+        if (parent.empty())
+        {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(parent, error);
+        KT_VERIFY(!error, "Unable to create directory '%s'", parent.string().c_str());
+    }
+
+    FileWriter::FileWriter(std::filesystem::path _path, bool _unbuffered)
+        : m_path(std::move(_path))
+        , m_temporaryPath(MakeTemporarySibling(m_path))
+    {
+        FileSystem::CreateParentDirectories(m_path);
+        m_file = IoFile::Open(m_temporaryPath, IoOpenMode::Write, _unbuffered);
+        m_buffers[0] = AllocateIoBuffer(kBufferSize);
+    }
+
+    FileWriter::~FileWriter()
+    {
+        if (!m_committed)
+        {
+            m_queue.reset();
+            m_file.Close();
+            std::error_code error;
+            std::filesystem::remove(m_temporaryPath, error);
+        }
+    }
+
+    void FileWriter::Write(const void* _data, u64 _size)
+    {
+        const u8* bytes = static_cast<const u8*>(_data);
+        while (_size > 0)
+        {
+            u64 chunk = 0;
+            if (m_position < m_flushed)
+            {
+                chunk = std::min(_size, m_flushed - m_position);
+                if (!m_patches.empty() && m_patches.back().first + m_patches.back().second.size() == m_position)
+                {
+                    m_patches.back().second.insert(m_patches.back().second.end(), bytes, bytes + chunk);
+                }
+                else
+                {
+                    m_patches.emplace_back(m_position, std::vector<u8>(bytes, bytes + chunk));
+                }
+            }
+            else
+            {
+                const u64 offset = m_position - m_flushed;
+                chunk = std::min(_size, kBufferSize - offset);
+                std::memcpy(m_buffers[m_current].get() + offset, bytes, chunk);
+            }
+
+            bytes += chunk;
+            _size -= chunk;
+            m_position += chunk;
+            m_size = std::max(m_size, m_position);
+            if (m_position == m_flushed + kBufferSize)
+            {
+                FlushBuffer();
+            }
+        }
+    }
+
+    void FileWriter::FlushBuffer()
+    {
+        if (m_queue == nullptr)
+        {
+            m_queue = std::make_unique<IoQueue>(kBufferCount);
+        }
+        m_queue->Write(m_file, m_flushed, { m_buffers[m_current].get(), kBufferSize }, m_current);
+        m_inFlight[m_current] = true;
+        m_flushed += kBufferSize;
+
+        m_current = (m_current + 1) % kBufferCount;
+        if (m_buffers[m_current] == nullptr)
+        {
+            m_buffers[m_current] = AllocateIoBuffer(kBufferSize);
+        }
+        while (m_inFlight[m_current])
+        {
+            m_inFlight[m_queue->WaitOne()] = false;
+        }
+    }
+
+    void FileWriter::Align(u64 _alignment)
+    {
+        static constexpr u8 kZeros[256] {};
+        u64 padding = AlignUp(m_position, _alignment) - m_position;
+        while (padding > 0)
+        {
+            const u64 chunk = padding < sizeof(kZeros) ? padding : sizeof(kZeros);
+            Write(kZeros, chunk);
+            padding -= chunk;
+        }
+    }
+
+    void FileWriter::Seek(u64 _position)
+    {
+        KT_VERIFY(_position <= m_size, "Unable to seek past the end of '%s'", m_path.string().c_str());
+        m_position = _position;
+    }
+
+    void FileWriter::Commit()
+    {
+        KT_TRACE_ZONE("FileWriter::Commit");
+        const u64 tail = m_size - m_flushed;
+        // Unbuffered transfers are whole blocks, the padding is truncated once written.
+        const u64 tailSize = m_file.IsUnbuffered() ? AlignUp(tail, kIoAlignment) : tail;
+        if (tail > 0)
+        {
+            u8* buffer = m_buffers[m_current].get();
+            std::memset(buffer + tail, 0, tailSize - tail);
+            if (m_queue != nullptr)
+            {
+                m_queue->Write(m_file, m_flushed, { buffer, tailSize });
+            }
+            else
+            {
+                m_file.WriteAt(m_flushed, { buffer, tailSize });
+            }
+        }
+        if (m_queue != nullptr)
+        {
+            m_queue->WaitAll();
+            m_queue.reset();
+        }
+
+        if (m_file.IsUnbuffered() && (!m_patches.empty() || tailSize != tail))
+        {
+            m_file.Close();
+            m_file = IoFile::Open(m_temporaryPath, IoOpenMode::Update);
+        }
+        for (const auto& [offset, data]: m_patches)
+        {
+            m_file.WriteAt(offset, data);
+        }
+        if (tailSize != tail)
+        {
+            m_file.Truncate(m_size);
+        }
+        m_file.Close();
+
+        m_committed = true;
+        RenameOver(m_temporaryPath, m_path);
+    }
+}
@@ -0,0 +1,330 @@
+#include "KryneTools/Common/FileWatcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <cerrno>
+#   include <poll.h>
+#   include <sys/inotify.h>
+#   include <unistd.h>
+#   include <unordered_map>
+#else
+#   include <map>
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+        std::string GetSystemErrorMessage(int _code)
+        {
+            return std::system_category().message(_code);
+        }
+
+        /// The system dropped events of `_directory`: every file in it may have changed.
+        [[maybe_unused]] void InsertAllFiles(const std::filesystem::path& _directory, std::set<std::filesystem::path>& _changes)
+        {
+            Log::Warning("Change notifications of '%s' overflowed, reporting all of its files", _directory.string().c_str());
+            std::error_code error;
+            for (const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator(_directory, error))
+            {
+                if (entry.is_regular_file(error))
+                {
+                    _changes.insert(entry.path());
+                }
+            }
+        }
+    }
+
+#if defined(_WIN32)
+    struct FileWatcher::Backend
+    {
+        struct Directory
+        {
+            std::filesystem::path m_path;
+            HANDLE m_handle = INVALID_HANDLE_VALUE;
+            HANDLE m_event = nullptr;
+            OVERLAPPED m_overlapped {};
+            alignas(DWORD) u8 m_buffer[16384];
+        };
+
+        std::vector<std::unique_ptr<Directory>> m_directories;
+
+        ~Backend()
+        {
+            for (const std::unique_ptr<Directory>& directory: m_directories)
+            {
+                if (directory->m_handle != INVALID_HANDLE_VALUE)
+                {
+                    CancelIoEx(directory->m_handle, &directory->m_overlapped);
+                    DWORD transferred = 0;
+                    GetOverlappedResult(directory->m_handle, &directory->m_overlapped, &transferred, TRUE);
+                    CloseHandle(directory->m_handle);
+                }
+                if (directory->m_event != nullptr)
+                {
+                    CloseHandle(directory->m_event);
+                }
+            }
+        }
+
+        void Add(const std::filesystem::path& _path)
+        {
+            KT_VERIFY(m_directories.size() < MAXIMUM_WAIT_OBJECTS, "Unable to watch more than %u directories", u32(MAXIMUM_WAIT_OBJECTS));
+            Directory& directory = *m_directories.emplace_back(std::make_unique<Directory>());
+            directory.m_path = _path;
+            directory.m_handle = CreateFileW(
+                _path.c_str(),
+                FILE_LIST_DIRECTORY,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                nullptr);
+            KT_VERIFY(directory.m_handle != INVALID_HANDLE_VALUE, "Unable to watch '%s': %s", _path.string().c_str(), GetSystemErrorMessage(int(GetLastError())).c_str());
+            directory.m_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            KT_VERIFY(directory.m_event != nullptr, "Unable to create an event: %s", GetSystemErrorMessage(int(GetLastError())).c_str());
+            Issue(directory);
+        }
+
+        void Issue(Directory& _directory)
+        {
+            _directory.m_overlapped = {};
+            _directory.m_overlapped.hEvent = _directory.m_event;
+            const BOOL issued = ReadDirectoryChangesW(
+                _directory.m_handle,
+                _directory.m_buffer,
+                sizeof(_directory.m_buffer),
+                FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                nullptr,
+                &_directory.m_overlapped,
+                nullptr);
+            KT_VERIFY(issued, "Unable to watch '%s': %s", _directory.m_path.string().c_str(), GetSystemErrorMessage(int(GetLastError())).c_str());
+        }
+
+        bool Poll(f64 _timeoutSeconds, std::set<std::filesystem::path>& _changes)
+        {
+            std::vector<HANDLE> events;
+            for (const std::unique_ptr<Directory>& directory: m_directories)
+            {
+                events.push_back(directory->m_event);
+            }
+            const DWORD timeout = _timeoutSeconds < 0.0 ? INFINITE : DWORD(_timeoutSeconds * 1000.0);
+            const DWORD signaled = WaitForMultipleObjects(DWORD(events.size()), events.data(), FALSE, timeout);
+            if (signaled < WAIT_OBJECT_0 || signaled >= WAIT_OBJECT_0 + events.size())
+            {
+                return false;
+            }
+
+            Directory& directory = *m_directories[signaled - WAIT_OBJECT_0];
+            DWORD transferred = 0;
+            const BOOL succeeded = GetOverlappedResult(directory.m_handle, &directory.m_overlapped, &transferred, FALSE);
+            ResetEvent(directory.m_event);
+            bool changed = false;
+            // No bytes means the notification buffer overflowed, the changes are lost.
+            if (succeeded && transferred == 0)
+            {
+                InsertAllFiles(directory.m_path, _changes);
+                changed = true;
+            }
+            else if (succeeded)
+            {
+                const u8* entry = directory.m_buffer;
+                while (true)
+                {
+                    const auto* information = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+                    if (information->Action != FILE_ACTION_RENAMED_OLD_NAME)
+                    {
+                        _changes.insert(directory.m_path / std::wstring(information->FileName, information->FileNameLength / sizeof(WCHAR)));
+                        changed = true;
+                    }
+                    if (information->NextEntryOffset == 0)
+                    {
+                        break;
+                    }
+                    entry += information->NextEntryOffset;
+                }
+            }
+            Issue(directory);
+            return changed;
+        }
+    };
+#elif defined(__linux__)
+    struct FileWatcher::Backend
+    {
+        int m_descriptor = -1;
+        std::unordered_map<int, std::filesystem::path> m_directories;
+
+        Backend()
+        {
+            m_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            KT_VERIFY(m_descriptor >= 0, "Unable to create an inotify instance: %s", GetSystemErrorMessage(errno).c_str());
+        }
+
+        ~Backend()
+        {
+            close(m_descriptor);
+        }
+
+        void Add(const std::filesystem::path& _path)
+        {
+            const int watch = inotify_add_watch(m_descriptor, _path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
+            KT_VERIFY(watch >= 0, "Unable to watch '%s': %s", _path.string().c_str(), GetSystemErrorMessage(errno).c_str());
+            m_directories[watch] = _path;
+        }
+
+        bool Poll(f64 _timeoutSeconds, std::set<std::filesystem::path>& _changes)
+        {
+            pollfd descriptor { m_descriptor, POLLIN, 0 };
+            const int timeout = _timeoutSeconds < 0.0 ? -1 : int(_timeoutSeconds * 1000.0);
+            if (poll(&descriptor, 1, timeout) <= 0)
+            {
+                return false;
+            }
+
+            bool changed = false;
+            bool overflowed = false;
+            alignas(inotify_event) char buffer[16384];
+            while (true)
+            {
+                const ssize_t size = read(m_descriptor, buffer, sizeof(buffer));
+                if (size <= 0)
+                {
+                    break;
+                }
+                for (ssize_t offset = 0; offset < size;)
+                {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    // Sent with no watch once the kernel queue is full, the events past it are lost.
+                    overflowed |= (event->mask & IN_Q_OVERFLOW) != 0;
+                    const auto directory = m_directories.find(event->wd);
+                    if (event->len > 0 && directory != m_directories.end())
+                    {
+                        _changes.insert(directory->second / event->name);
+                        changed = true;
+                    }
+                    offset += ssize_t(sizeof(inotify_event) + event->len);
+                }
+            }
+            if (overflowed)
+            {
+                for (const auto& [watch, directory]: m_directories)
+                {
+                    InsertAllFiles(directory, _changes);
+                }
+                changed = true;
+            }
+            return changed;
+        }
+    };
+#else
+    struct FileWatcher::Backend
+    {
+        using Times = std::map<std::filesystem::path, std::filesystem::file_time_type>;
+
+        static constexpr f64 kPollSeconds = 0.1;
+
+        std::vector<std::filesystem::path> m_directories;
+        Times m_times;
+
+        void Add(const std::filesystem::path& _path)
+        {
+            KT_VERIFY(std::filesystem::is_directory(_path), "Unable to watch '%s': not a directory", _path.string().c_str());
+            m_directories.push_back(_path);
+            Scan(m_times);
+        }
+
+        void Scan(Times& _times) const
+        {
+            _times.clear();
+            for (const std::filesystem::path& directory: m_directories)
+            {
+                std::error_code error;
+                for (const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator(directory, error))
+                {
+                    if (entry.is_regular_file(error))
+                    {
+                        _times[entry.path()] = entry.last_write_time(error);
+                    }
+                }
+            }
+        }
+
+        bool Poll(f64 _timeoutSeconds, std::set<std::filesystem::path>& _changes)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            while (true)
+            {
+                const f64 elapsed = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+                if (_timeoutSeconds >= 0.0 && elapsed >= _timeoutSeconds)
+                {
+                    return false;
+                }
+                const f64 delay = _timeoutSeconds < 0.0 ? kPollSeconds : std::min(kPollSeconds, _timeoutSeconds - elapsed);
+                std::this_thread::sleep_for(std::chrono::duration<f64>(delay));
+
+                Times times;
+                Scan(times);
+                bool changed = false;
+                for (const auto& [path, time]: times)
+                {
+                    const auto previous = m_times.find(path);
+                    if (previous == m_times.end() || previous->second != time)
+                    {
+                        _changes.insert(path);
+                        changed = true;
+                    }
+                }
+                for (const auto& [path, time]: m_times)
+                {
+                    if (!times.contains(path))
+                    {
+                        _changes.insert(path);
+                        changed = true;
+                    }
+                }
+                m_times = std::move(times);
+                if (changed)
+                {
+                    return true;
+                }
+            }
+        }
+    };
+#endif
+
+    FileWatcher::FileWatcher(std::span<const std::filesystem::path> _directories)
+        : m_backend(std::make_unique<Backend>())
+    {
+        for (const std::filesystem::path& directory: _directories)
+        {
+            m_backend->Add(directory);
+        }
+    }
+
+    FileWatcher::~FileWatcher() = default;
+
+    std::vector<std::filesystem::path> FileWatcher::Wait(f64 _timeoutSeconds, f64 _settleSeconds)
+    {
+        std::set<std::filesystem::path> changes;
+        if (!m_backend->Poll(_timeoutSeconds, changes))
+        {
+            return {};
+        }
+        while (m_backend->Poll(_settleSeconds, changes))
+        {
+        }
+        return { changes.begin(), changes.end() };
+    }
+}
@@ -0,0 +1,195 @@
+#include "KryneTools/Common/Hash.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u64 kPrime1 = 0x9E3779B185EBCA87ull;
+        constexpr u64 kPrime2 = 0xC2B2AE3D27D4EB4Full;
+        constexpr u64 kPrime3 = 0x165667B19E3779F9ull;
+        constexpr u64 kPrime4 = 0x85EBCA77C2B2AE63ull;
+        constexpr u64 kPrime5 = 0x27D4EB2F165667C5ull;
+
+        /// Chunk size of `HashParallel()`. Part of the hash definition, changing it changes every digest.
+        constexpr u64 kParallelChunkSize = 8ull << 20;
+
+        constexpr u64 RotateLeft(u64 _value, u32 _amount)
+        {
+            return (_value << _amount) | (_value >> (64 - _amount));
+        }
+
+        u64 Read64(const u8* _data)
+        {
+            u64 value;
+            std::memcpy(&value, _data, sizeof(value));
+            return value;
+        }
+
+        u32 Read32(const u8* _data)
+        {
+            u32 value;
+            std::memcpy(&value, _data, sizeof(value));
+            return value;
+        }
+
+        constexpr u64 Round(u64 _accumulator, u64 _input)
+        {
+            _accumulator += _input * kPrime2;
+            _accumulator = RotateLeft(_accumulator, 31);
+            return _accumulator * kPrime1;
+        }
+
+        constexpr u64 MergeRound(u64 _accumulator, u64 _value)
+        {
+            _accumulator ^= Round(0, _value);
+            return _accumulator * kPrime1 + kPrime4;
+        }
+    }
+
+    Hasher64::Hasher64(u64 _seed)
+        : m_accumulators {
+            _seed + kPrime1 + kPrime2,
+            _seed + kPrime2,
+            _seed,
+            _seed - kPrime1,
+        }
+        , m_seed(_seed)
+    {}
+
+    void Hasher64::Update(const void* _data, u64 _size)
+    {
+        const u8* input = static_cast<const u8*>(_data);
+        m_totalSize += _size;
+
+        if (m_bufferSize + _size < sizeof(m_buffer))
+        {
+            if (_size > 0)
+            {
+                std::memcpy(m_buffer + m_bufferSize, input, _size);
+            }
+            m_bufferSize += u32(_size);
+            return;
+        }
+
+        if (m_bufferSize > 0)
+        {
+            const u32 fill = u32(sizeof(m_buffer)) - m_bufferSize;
+            std::memcpy(m_buffer + m_bufferSize, input, fill);
+            for (u32 lane = 0; lane < 4; lane++)
+            {
+                m_accumulators[lane] = Round(m_accumulators[lane], Read64(m_buffer + lane * 8));
+            }
+            input += fill;
+            _size -= fill;
+            m_bufferSize = 0;
+        }
+
+        u64 a0 = m_accumulators[0];
+        u64 a1 = m_accumulators[1];
+        u64 a2 = m_accumulators[2];
+        u64 a3 = m_accumulators[3];
+        while (_size >= 32)
+        {
+            a0 = Round(a0, Read64(input));
+            a1 = Round(a1, Read64(input + 8));
+            a2 = Round(a2, Read64(input + 16));
+            a3 = Round(a3, Read64(input + 24));
+            input += 32;
+            _size -= 32;
+        }
+        m_accumulators[0] = a0;
+        m_accumulators[1] = a1;
+        m_accumulators[2] = a2;
+        m_accumulators[3] = a3;
+
+        if (_size > 0)
+        {
+            std::memcpy(m_buffer, input, _size);
+            m_bufferSize = u32(_size);
+        }
+    }
+
+    u64 Hasher64::Finalize() const
+    {
+        u64 hash;
+        if (m_totalSize >= 32)
+        {
+            hash = RotateLeft(m_accumulators[0], 1)
+                + RotateLeft(m_accumulators[1], 7)
+                + RotateLeft(m_accumulators[2], 12)
+                + RotateLeft(m_accumulators[3], 18);
+            for (const u64 accumulator: m_accumulators)
+            {
+                hash = MergeRound(hash, accumulator);
+            }
+        }
+        else
+        {
+            hash = m_seed + kPrime5;
+        }
+        hash += m_totalSize;
+
+        const u8* input = m_buffer;
+        u32 remaining = m_bufferSize;
+        while (remaining >= 8)
+        {
+            hash ^= Round(0, Read64(input));
+            hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+            input += 8;
+            remaining -= 8;
+        }
+        if (remaining >= 4)
+        {
+            hash ^= u64(Read32(input)) * kPrime1;
+            hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+            input += 4;
+            remaining -= 4;
+        }
+        while (remaining > 0)
+        {
+            hash ^= u64(*input) * kPrime5;
+            hash = RotateLeft(hash, 11) * kPrime1;
+            input++;
+            remaining--;
+        }
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    u64 Hash64(const void* _data, u64 _size, u64 _seed)
+    {
+        Hasher64 hasher(_seed);
+        hasher.Update(_data, _size);
+        return hasher.Finalize();
+    }
+
+    u64 HashParallel(JobSystem& _jobSystem, std::span<const u8> _data)
+    {
+        const u64 chunkCount = (_data.size() + kParallelChunkSize - 1) / kParallelChunkSize;
+        std::vector<u64> digests(chunkCount);
+
+        _jobSystem.ParallelFor(chunkCount, 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 chunk = _begin; chunk < _end; chunk++)
+            {
+                const u64 offset = chunk * kParallelChunkSize;
+                digests[chunk] = Hash64(_data.subspan(offset, std::min<u64>(kParallelChunkSize, _data.size() - offset)));
+            }
+        });
+
+        Hasher64 hasher;
+        hasher.UpdatePod(u64(_data.size()));
+        hasher.Update(digests.data(), digests.size() * sizeof(u64));
+        return hasher.Finalize();
+    }
+}
@@ -0,0 +1,64 @@
+#include "KryneTools/Common/Log.hpp"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+
+namespace KryneTools::Log
+{
+    namespace
+    {
+        std::atomic<Level> g_level { Level::Info };
+        std::mutex g_outputMutex;
+
+        void Output(Level _level, const char* _format, va_list _args)
+        {
+            if (!IsEnabled(_level))
+            {
+                return;
+            }
+
+            char buffer[2048];
+            std::vsnprintf(buffer, sizeof(buffer), _format, _args);
+
+            FILE* stream = _level >= Level::Warning ? stderr : stdout;
+            const char* prefix = "";
+            switch (_level)
+            {
+                case Level::Warning: prefix = "warning: "; break;
+                case Level::Error: prefix = "error: "; break;
+                default: break;
+            }
+
+            const std::lock_guard lock(g_outputMutex);
+            std::fprintf(stream, "%s%s\n", prefix, buffer);
+        }
+    }
+
+    void SetLevel(Level _level)
+    {
+        g_level.store(_level, std::memory_order_relaxed);
+    }
+
+    bool IsEnabled(Level _level)
+    {
+        return _level >= g_level.load(std::memory_order_relaxed);
+    }
+
+#define KT_LOG_IMPLEMENTATION(function, level)  \
+    void function(const char* _format, ...)     \
+    {                                           \
+        va_list args;                           \
+        va_start(args, _format);                \
+        Output(level, _format, args);           \
+        va_end(args);                           \
+    }
+
+    KT_LOG_IMPLEMENTATION(Verbose, Level::Verbose)
+    KT_LOG_IMPLEMENTATION(Info, Level::Info)
+    KT_LOG_IMPLEMENTATION(Warning, Level::Warning)
+    KT_LOG_IMPLEMENTATION(Error, Level::Error)
+
+#undef KT_LOG_IMPLEMENTATION
+}
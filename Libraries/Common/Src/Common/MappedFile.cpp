@@ -0,0 +1,159 @@
+#include "KryneTools/Common/MappedFile.hpp"
+
+#include <utility>
+
+#include "KryneTools/Common/Error.hpp"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace KryneTools
+{
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& _other) noexcept
+        : m_data(std::exchange(_other.m_data, nullptr))
+        , m_size(std::exchange(_other.m_size, 0))
+#if defined(_WIN32)
+        , m_fileHandle(std::exchange(_other.m_fileHandle, nullptr))
+        , m_mappingHandle(std::exchange(_other.m_mappingHandle, nullptr))
+#endif
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& _other) noexcept
+    {
+        if (this != &_other)
+        {
+            Close();
+            m_data = std::exchange(_other.m_data, nullptr);
+            m_size = std::exchange(_other.m_size, 0);
+#if defined(_WIN32)
+            m_fileHandle = std::exchange(_other.m_fileHandle, nullptr);
+            m_mappingHandle = std::exchange(_other.m_mappingHandle, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+#if defined(_WIN32)
+    MappedFile MappedFile::Open(const std::filesystem::path& _path)
+    {
+        MappedFile file;
+        HANDLE handle = CreateFileW(
+            _path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        KT_VERIFY(handle != INVALID_HANDLE_VALUE, "Unable to open '%s' for reading", _path.string().c_str());
+        file.m_fileHandle = handle;
+
+        LARGE_INTEGER size;
+        KT_VERIFY(GetFileSizeEx(handle, &size), "Unable to query the size of '%s'", _path.string().c_str());
+        file.m_size = u64(size.QuadPart);
+        if (file.m_size == 0)
+        {
+            return file;
+        }
+
+        file.m_mappingHandle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        KT_VERIFY(file.m_mappingHandle != nullptr, "Unable to map '%s'", _path.string().c_str());
+        file.m_data = static_cast<const u8*>(MapViewOfFile(file.m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        KT_VERIFY(file.m_data != nullptr, "Unable to map '%s'", _path.string().c_str());
+        return file;
+    }
+
+    void MappedFile::Release(std::span<const u8> _range) const
+    {
+        // Unlocking pages that are not locked is the documented way to trim them from the working set.
+        if (!_range.empty())
+        {
+            VirtualUnlock(const_cast<u8*>(_range.data()), _range.size());
+        }
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mappingHandle != nullptr)
+        {
+            CloseHandle(m_mappingHandle);
+        }
+        if (m_fileHandle != nullptr)
+        {
+            CloseHandle(m_fileHandle);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_mappingHandle = nullptr;
+        m_fileHandle = nullptr;
+    }
+#else
+    MappedFile MappedFile::Open(const std::filesystem::path& _path)
+    {
+        MappedFile file;
+        const int descriptor = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+        KT_VERIFY(descriptor >= 0, "Unable to open '%s' for reading", _path.string().c_str());
+
+        struct stat status {};
+        if (fstat(descriptor, &status) != 0)
+        {
+            close(descriptor);
+            ThrowError("Unable to query the size of '%s'", _path.string().c_str());
+        }
+
+        file.m_size = u64(status.st_size);
+        if (file.m_size > 0)
+        {
+            void* data = mmap(nullptr, file.m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (data == MAP_FAILED)
+            {
+                close(descriptor);
+                ThrowError("Unable to map '%s'", _path.string().c_str());
+            }
+            file.m_data = static_cast<const u8*>(data);
+        }
+
+        // The mapping keeps its own reference to the file.
+        close(descriptor);
+        return file;
+    }
+
+    void MappedFile::Release(std::span<const u8> _range) const
+    {
+        static const u64 pageSize = u64(sysconf(_SC_PAGESIZE));
+
+        // Only drop pages entirely within the range, neighbours may still be in use by other readers.
+        const u64 begin = AlignUp(reinterpret_cast<uintptr_t>(_range.data()), pageSize);
+        const u64 end = (reinterpret_cast<uintptr_t>(_range.data()) + _range.size()) & ~(pageSize - 1);
+        if (begin < end)
+        {
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+        }
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_data != nullptr)
+        {
+            munmap(const_cast<u8*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+}
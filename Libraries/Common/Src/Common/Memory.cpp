@@ -0,0 +1,228 @@
+#include "KryneTools/Common/Memory.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "KryneTools/Common/Arena.hpp"
+
+#if defined(_WIN32)
+#   include <malloc.h>
+#   include <windows.h>
+#   include <psapi.h>
+#elif defined(__APPLE__)
+#   include <mach/mach.h>
+#   include <malloc/malloc.h>
+#   include <unistd.h>
+#else
+#   include <malloc.h>
+#   include <unistd.h>
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+        // Constant initialized, so the replaced allocator can read it from any thread at any time.
+        thread_local Memory::Counters* t_counters = nullptr;
+    }
+
+    MemoryStatistics Memory::Counters::GetStatistics() const
+    {
+        MemoryStatistics statistics;
+        statistics.m_allocationCount = m_allocationCount.load(std::memory_order_relaxed);
+        statistics.m_allocatedBytes = m_allocatedBytes.load(std::memory_order_relaxed);
+        statistics.m_peakHeapBytes = u64(std::max<s64>(m_peakHeapBytes.load(std::memory_order_relaxed), 0));
+        statistics.m_peakArenaBytes = m_peakArenaBytes.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    Memory::Counters* Memory::GetCurrentCounters()
+    {
+        return t_counters;
+    }
+
+    Memory::Scope::Scope(Counters* _counters)
+        : m_counters(_counters)
+        , m_previous(t_counters)
+    {
+        t_counters = _counters;
+        if (m_counters != nullptr)
+        {
+            Arena& scratch = GetScratchArena();
+            m_arenaStart = scratch.GetUsedSize();
+            m_previousArenaPeak = scratch.ResetPeakUsedSize();
+        }
+    }
+
+    Memory::Scope::~Scope()
+    {
+        if (m_counters != nullptr)
+        {
+            Arena& scratch = GetScratchArena();
+            m_counters->RecordArenaPeak(scratch.GetPeakUsedSize() - m_arenaStart);
+            scratch.MergePeakUsedSize(m_previousArenaPeak);
+        }
+        t_counters = m_previous;
+    }
+
+    Memory::ResidentSize Memory::GetResidentSize()
+    {
+        ResidentSize size;
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters {};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            size.m_currentBytes = counters.WorkingSetSize;
+            size.m_peakBytes = counters.PeakWorkingSetSize;
+        }
+#elif defined(__APPLE__)
+        mach_task_basic_info_data_t info {};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        {
+            size.m_currentBytes = info.resident_size;
+            size.m_peakBytes = info.resident_size_max;
+        }
+#else
+        // Reported in kB. Read with stdio, which does not allocate once the stream buffer exists.
+        if (FILE* file = std::fopen("/proc/self/status", "r"))
+        {
+            char line[128];
+            unsigned long long value = 0;
+            while (std::fgets(line, sizeof(line), file) != nullptr)
+            {
+                if (std::sscanf(line, "VmRSS: %llu", &value) == 1)
+                {
+                    size.m_currentBytes = u64(value) << 10;
+                }
+                else if (std::sscanf(line, "VmHWM: %llu", &value) == 1)
+                {
+                    size.m_peakBytes = u64(value) << 10;
+                }
+            }
+            std::fclose(file);
+        }
+#endif
+        return size;
+    }
+
+    u64 Memory::GetPhysicalMemorySize()
+    {
+#if defined(_WIN32)
+        MEMORYSTATUSEX status {};
+        status.dwLength = sizeof(status);
+        return GlobalMemoryStatusEx(&status) ? u64(status.ullTotalPhys) : 0;
+#else
+        const long pages = sysconf(_SC_PHYS_PAGES);
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        return pages > 0 && pageSize > 0 ? u64(pages) * u64(pageSize) : 0;
+#endif
+    }
+}
+
+#if KRYNE_TOOLS_MEMORY_TRACKING
+
+// Every other form of the global operators (arrays, nothrow, sized deletes) forwards to these by default.
+namespace
+{
+    /// Frees do not know what they release, both sides use the size the allocator actually reserved instead.
+    std::size_t GetAllocationSize(void* _pointer, [[maybe_unused]] std::size_t _alignment)
+    {
+#if defined(_WIN32)
+        return _alignment != 0 ? _aligned_msize(_pointer, _alignment, 0) : _msize(_pointer);
+#elif defined(__APPLE__)
+        return malloc_size(_pointer);
+#else
+        return malloc_usable_size(_pointer);
+#endif
+    }
+
+    void* TryAllocate(std::size_t _size, std::size_t _alignment)
+    {
+#if defined(_WIN32)
+        return _alignment != 0 ? _aligned_malloc(_size, _alignment) : std::malloc(_size);
+#else
+        if (_alignment == 0)
+        {
+            return std::malloc(_size);
+        }
+        void* pointer = nullptr;
+        return posix_memalign(&pointer, std::max(_alignment, sizeof(void*)), _size) == 0 ? pointer : nullptr;
+#endif
+    }
+
+    void* Allocate(std::size_t _size, std::size_t _alignment)
+    {
+        _size = std::max<std::size_t>(_size, 1);
+        void* pointer = TryAllocate(_size, _alignment);
+        while (pointer == nullptr)
+        {
+            const std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+            pointer = TryAllocate(_size, _alignment);
+        }
+        if (KryneTools::Memory::Counters* counters = KryneTools::t_counters)
+        {
+            counters->RecordAllocation(GetAllocationSize(pointer, _alignment));
+        }
+        return pointer;
+    }
+
+    void Free(void* _pointer, std::size_t _alignment)
+    {
+        if (_pointer == nullptr)
+        {
+            return;
+        }
+        if (KryneTools::Memory::Counters* counters = KryneTools::t_counters)
+        {
+            counters->RecordFree(GetAllocationSize(_pointer, _alignment));
+        }
+#if defined(_WIN32)
+        if (_alignment != 0)
+        {
+            _aligned_free(_pointer);
+            return;
+        }
+#endif
+        std::free(_pointer);
+    }
+}
+
+void* operator new(std::size_t _size)
+{
+    return Allocate(_size, 0);
+}
+
+void* operator new(std::size_t _size, std::align_val_t _alignment)
+{
+    return Allocate(_size, std::size_t(_alignment));
+}
+
+void operator delete(void* _pointer) noexcept
+{
+    Free(_pointer, 0);
+}
+
+void operator delete(void* _pointer, std::size_t) noexcept
+{
+    Free(_pointer, 0);
+}
+
+void operator delete(void* _pointer, std::align_val_t _alignment) noexcept
+{
+    Free(_pointer, std::size_t(_alignment));
+}
+
+void operator delete(void* _pointer, std::size_t, std::align_val_t _alignment) noexcept
+{
+    Free(_pointer, std::size_t(_alignment));
+}
+
+#endif
@@ -0,0 +1,189 @@
+#include "KryneTools/Common/Process.hpp"
+
+#include <cerrno>
+#include <mutex>
+#include <vector>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <spawn.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace KryneTools
+{
+#if defined(_WIN32)
+    namespace
+    {
+        /// Quotes an argument following the `CommandLineToArgvW` rules.
+        void AppendQuotedArgument(std::wstring& _commandLine, const std::wstring& _argument)
+        {
+            if (!_commandLine.empty())
+            {
+                _commandLine += L' ';
+            }
+            if (!_argument.empty() && _argument.find_first_of(L" \t\n\v\"") == std::wstring::npos)
+            {
+                _commandLine += _argument;
+                return;
+            }
+            _commandLine += L'"';
+            for (size_t i = 0; ; i++)
+            {
+                size_t backslashCount = 0;
+                while (i < _argument.size() && _argument[i] == L'\\')
+                {
+                    i++;
+                    backslashCount++;
+                }
+                if (i == _argument.size())
+                {
+                    _commandLine.append(backslashCount * 2, L'\\');
+                    break;
+                }
+                if (_argument[i] == L'"')
+                {
+                    _commandLine.append(backslashCount * 2 + 1, L'\\');
+                }
+                else
+                {
+                    _commandLine.append(backslashCount, L'\\');
+                }
+                _commandLine += _argument[i];
+            }
+            _commandLine += L'"';
+        }
+    }
+
+    ProcessResult RunProcess(std::span<const std::string> _arguments)
+    {
+        KT_TRACE_ZONE_DETAIL("RunProcess", _arguments.empty() ? std::string_view() : std::string_view(_arguments[0]));
+        KT_VERIFY(!_arguments.empty(), "No program to run");
+        std::wstring commandLine;
+        for (const std::string& argument: _arguments)
+        {
+            const int length = MultiByteToWideChar(CP_UTF8, 0, argument.data(), int(argument.size()), nullptr, 0);
+            std::wstring wide(size_t(length), L'\0');
+            MultiByteToWideChar(CP_UTF8, 0, argument.data(), int(argument.size()), wide.data(), length);
+            AppendQuotedArgument(commandLine, wide);
+        }
+
+        // Every inheritable handle goes to every child created meanwhile, so a concurrent child would keep the write
+        // end of this pipe open and the read loop would wait for it. Pipe creation and process creation are serialized.
+        static std::mutex creationMutex;
+        std::unique_lock lock(creationMutex);
+
+        SECURITY_ATTRIBUTES attributes { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+        HANDLE readPipe = nullptr;
+        HANDLE writePipe = nullptr;
+        KT_VERIFY(CreatePipe(&readPipe, &writePipe, &attributes, 0), "Unable to create a pipe");
+        SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOW startupInfo {};
+        startupInfo.cb = sizeof(startupInfo);
+        startupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        startupInfo.hStdOutput = writePipe;
+        startupInfo.hStdError = writePipe;
+        PROCESS_INFORMATION processInfo {};
+        const BOOL created = CreateProcessW(nullptr, commandLine.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &startupInfo, &processInfo);
+        CloseHandle(writePipe);
+        lock.unlock();
+
+        ProcessResult result;
+        if (!created)
+        {
+            CloseHandle(readPipe);
+            result.m_output = FormatString("Unable to start '%s'", _arguments[0].c_str());
+            return result;
+        }
+
+        char buffer[4096];
+        DWORD readSize = 0;
+        while (ReadFile(readPipe, buffer, sizeof(buffer), &readSize, nullptr) && readSize > 0)
+        {
+            result.m_output.append(buffer, readSize);
+        }
+        CloseHandle(readPipe);
+
+        WaitForSingleObject(processInfo.hProcess, INFINITE);
+        DWORD exitCode = 0;
+        GetExitCodeProcess(processInfo.hProcess, &exitCode);
+        result.m_exitCode = int(exitCode);
+        CloseHandle(processInfo.hProcess);
+        CloseHandle(processInfo.hThread);
+        return result;
+    }
+#else
+    ProcessResult RunProcess(std::span<const std::string> _arguments)
+    {
+        KT_TRACE_ZONE_DETAIL("RunProcess", _arguments.empty() ? std::string_view() : std::string_view(_arguments[0]));
+        KT_VERIFY(!_arguments.empty(), "No program to run");
+        std::vector<char*> argv;
+        for (const std::string& argument: _arguments)
+        {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        // Close on exec, so children spawned concurrently by other jobs do not inherit the write end and keep it open.
+        int pipeDescriptors[2];
+#if defined(__linux__)
+        KT_VERIFY(pipe2(pipeDescriptors, O_CLOEXEC) == 0, "Unable to create a pipe");
+#else
+        KT_VERIFY(pipe(pipeDescriptors) == 0, "Unable to create a pipe");
+        fcntl(pipeDescriptors[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipeDescriptors[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipeDescriptors[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, pipeDescriptors[1], STDERR_FILENO);
+
+        pid_t pid = 0;
+        const int spawnResult = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(pipeDescriptors[1]);
+
+        ProcessResult result;
+        if (spawnResult != 0)
+        {
+            close(pipeDescriptors[0]);
+            result.m_output = FormatString("Unable to start '%s'", _arguments[0].c_str());
+            return result;
+        }
+
+        char buffer[4096];
+        ssize_t readSize = 0;
+        while ((readSize = read(pipeDescriptors[0], buffer, sizeof(buffer))) != 0)
+        {
+            if (readSize < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            result.m_output.append(buffer, size_t(readSize));
+        }
+        close(pipeDescriptors[0]);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+        result.m_exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        return result;
+    }
+#endif
+}
@@ -0,0 +1,24 @@
+#include "KryneTools/Common/Tool.hpp"
+
+#include <cstdio>
+#include <exception>
+
+namespace KryneTools
+{
+    int RunTool(const char* _toolName, const std::function<int()>& _main)
+    {
+        try
+        {
+            return _main();
+        }
+        catch (const std::exception& exception)
+        {
+            std::fprintf(stderr, "%s: error: %s\n", _toolName, exception.what());
+        }
+        catch (...)
+        {
+            std::fprintf(stderr, "%s: error: unknown exception\n", _toolName);
+        }
+        return 1;
+    }
+}
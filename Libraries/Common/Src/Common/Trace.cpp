@@ -0,0 +1,265 @@
+#include "KryneTools/Common/Trace.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+
+namespace KryneTools
+{
+    std::atomic<bool> Trace::g_recording = false;
+
+    namespace
+    {
+        struct Event
+        {
+            const char* m_name;
+            std::string m_detail;
+            std::string m_arguments;
+            u64 m_start;
+            /// 0 for counter samples.
+            u64 m_end;
+        };
+
+        /// Zones of one thread. Only contended when a session starts or ends.
+        struct ThreadBuffer
+        {
+            std::mutex m_mutex;
+            u32 m_id = 0;
+            std::string m_name;
+            std::vector<Event> m_events;
+        };
+
+        /// Buffers are never freed, as they may be used by threads that outlive a session.
+        struct Registry
+        {
+            std::mutex m_mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> m_threads;
+            u64 m_origin = 0;
+        };
+
+        thread_local ThreadBuffer* t_buffer = nullptr;
+        /// Innermost recording zone of the thread.
+        thread_local Trace::Zone* t_zone = nullptr;
+
+        Registry& GetRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        ThreadBuffer& GetThreadBuffer()
+        {
+            if (t_buffer == nullptr)
+            {
+                Registry& registry = GetRegistry();
+                const std::lock_guard lock(registry.m_mutex);
+                ThreadBuffer& buffer = *registry.m_threads.emplace_back(std::make_unique<ThreadBuffer>());
+                buffer.m_id = u32(registry.m_threads.size());
+                t_buffer = &buffer;
+            }
+            return *t_buffer;
+        }
+
+        u64 GetTime()
+        {
+            return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void AppendJsonString(std::string& _output, std::string_view _text)
+        {
+            _output += '"';
+            for (const char c: _text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    _output += '\\';
+                    _output += c;
+                }
+                else if (u8(c) < 0x20)
+                {
+                    _output += FormatString("\\u%04x", u32(c));
+                }
+                else
+                {
+                    _output += c;
+                }
+            }
+            _output += '"';
+        }
+    }
+
+    void Trace::SetThreadName(std::string_view _name)
+    {
+#if defined(KRYNE_TOOLS_HAS_TRACY)
+        tracy::SetThreadName(std::string(_name).c_str());
+#endif
+        ThreadBuffer& buffer = GetThreadBuffer();
+        const std::lock_guard lock(buffer.m_mutex);
+        buffer.m_name = _name;
+    }
+
+    void Trace::RecordCounter(const char* _name, f64 _value)
+    {
+        if (!IsRecording())
+        {
+            return;
+        }
+        const u64 time = GetTime();
+        ThreadBuffer& buffer = GetThreadBuffer();
+        const std::lock_guard lock(buffer.m_mutex);
+        buffer.m_events.push_back({ _name, {}, FormatString("\"value\":%.6g", _value), time, 0 });
+    }
+
+    void Trace::AddZoneArgument(const char* _name, u64 _value)
+    {
+        if (t_zone == nullptr || !IsRecording())
+        {
+            return;
+        }
+        std::string& arguments = t_zone->m_arguments;
+        arguments += arguments.empty() ? "" : ",";
+        AppendJsonString(arguments, _name);
+        arguments += FormatString(":%llu", static_cast<unsigned long long>(_value));
+    }
+
+    void Trace::Zone::Begin(const char* _name, std::string_view _detail)
+    {
+        m_name = _name;
+        m_detail = _detail;
+        m_start = GetTime();
+        m_parent = t_zone;
+        t_zone = this;
+    }
+
+    void Trace::Zone::End()
+    {
+        const u64 end = GetTime();
+        t_zone = m_parent;
+        // Zones still open when the session ended are dropped, rather than leaking into the next one.
+        if (!IsRecording())
+        {
+            return;
+        }
+        ThreadBuffer& buffer = GetThreadBuffer();
+        const std::lock_guard lock(buffer.m_mutex);
+        buffer.m_events.push_back({ m_name, std::move(m_detail), std::move(m_arguments), m_start, end });
+    }
+
+    void TraceSettings::RegisterOptions(CommandLine& _commandLine)
+    {
+        if (const char* output = std::getenv("KRYNE_TRACE"))
+        {
+            m_outputOption = output;
+        }
+        _commandLine.AddOption("trace", "Write a Chrome trace of every job, stage and I/O call to this file (KRYNE_TRACE)", &m_outputOption);
+    }
+
+    void TraceSettings::ResolveOptions()
+    {
+        m_output = m_outputOption;
+    }
+
+    TraceSession::TraceSession(const TraceSettings& _settings)
+        : m_output(_settings.m_output)
+    {
+        if (m_output.empty())
+        {
+            return;
+        }
+#if !KRYNE_TOOLS_TRACING
+        Log::Warning("Tracing is compiled out (KRYNE_TOOLS_TRACING=OFF), %s will not be written", m_output.string().c_str());
+        m_output.clear();
+#else
+        if (t_buffer == nullptr || t_buffer->m_name.empty())
+        {
+            Trace::SetThreadName("Main");
+        }
+
+        Registry& registry = GetRegistry();
+        const std::lock_guard lock(registry.m_mutex);
+        for (const std::unique_ptr<ThreadBuffer>& buffer: registry.m_threads)
+        {
+            const std::lock_guard bufferLock(buffer->m_mutex);
+            buffer->m_events.clear();
+        }
+        registry.m_origin = GetTime();
+        Trace::g_recording.store(true);
+#endif
+    }
+
+    TraceSession::~TraceSession()
+    {
+        if (m_output.empty())
+        {
+            return;
+        }
+        Trace::g_recording.store(false);
+
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        u64 eventCount = 0;
+        {
+            Registry& registry = GetRegistry();
+            const std::lock_guard lock(registry.m_mutex);
+            for (const std::unique_ptr<ThreadBuffer>& buffer: registry.m_threads)
+            {
+                const std::lock_guard bufferLock(buffer->m_mutex);
+                if (!buffer->m_name.empty())
+                {
+                    json += FormatString("{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", buffer->m_id);
+                    AppendJsonString(json, buffer->m_name);
+                    json += "}},\n";
+                }
+                for (const Event& event: buffer->m_events)
+                {
+                    if (event.m_end == 0)
+                    {
+                        json += FormatString("{\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"name\":", f64(event.m_start - registry.m_origin) * 1e-3);
+                        AppendJsonString(json, event.m_name);
+                        json += ",\"args\":{" + event.m_arguments + "}},\n";
+                        continue;
+                    }
+                    json += FormatString(
+                        "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                        buffer->m_id,
+                        f64(event.m_start - registry.m_origin) * 1e-3,
+                        f64(event.m_end - event.m_start) * 1e-3);
+                    AppendJsonString(json, event.m_name);
+                    if (!event.m_detail.empty() || !event.m_arguments.empty())
+                    {
+                        json += ",\"args\":{";
+                        if (!event.m_detail.empty())
+                        {
+                            json += "\"detail\":";
+                            AppendJsonString(json, event.m_detail);
+                            json += event.m_arguments.empty() ? "" : ",";
+                        }
+                        json += event.m_arguments + '}';
+                    }
+                    json += "},\n";
+                }
+                eventCount += buffer->m_events.size();
+                buffer->m_events = {};
+            }
+        }
+        // The process name goes last, closing the array after the trailing comma of the other events.
+        json += "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"kryne\"}}\n]}\n";
+
+        try
+        {
+            FileSystem::CreateParentDirectories(m_output);
+            FileSystem::WriteFile(m_output, { reinterpret_cast<const u8*>(json.data()), json.size() });
+            Log::Info("Wrote %llu trace zones to %s", static_cast<unsigned long long>(eventCount), m_output.string().c_str());
+        }
+        catch (const std::exception& exception)
+        {
+            Log::Error("Could not write the trace: %s", exception.what());
+        }
+    }
+}
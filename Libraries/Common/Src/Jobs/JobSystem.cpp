@@ -0,0 +1,275 @@
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+#include <utility>
+
+#include "KryneTools/Common/Arena.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Memory.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        thread_local const JobSystem* t_currentSystem = nullptr;
+        thread_local s32 t_workerIndex = -1;
+
+        // Scratch memory a thread keeps between its top-level jobs. Larger peaks, such as the buffers of a huge mesh,
+        // go back to the heap once their job is done, so the footprint follows the working set.
+        constexpr u64 kRetainedScratchSize = u64(64) << 20;
+
+        // Number of failed job searches before a thread goes to sleep. Spinning a little avoids paying for a
+        // futex round-trip between two quickly spawned jobs.
+        constexpr u32 kSpinCount = 64;
+    }
+
+    JobSystem::JobSystem(u32 _workerCount)
+    {
+        if (_workerCount == 0)
+        {
+            _workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_workers.reserve(_workerCount);
+        for (u32 i = 0; i < _workerCount; i++)
+        {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+
+        // Threads are started once every deque exists, as they immediately start stealing from each other.
+        for (u32 i = 0; i < _workerCount; i++)
+        {
+            m_workers[i]->m_thread = std::thread([this, i] { WorkerMain(i); });
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            const std::lock_guard lock(m_sleepMutex);
+            m_stopping.store(true);
+        }
+        m_sleepCondition.notify_all();
+
+        for (auto& worker: m_workers)
+        {
+            worker->m_thread.join();
+        }
+    }
+
+    void JobSystem::Spawn(JobGroup& _group, JobFunction _function)
+    {
+        _group.m_pending.fetch_add(1, std::memory_order_relaxed);
+        Job* job = new Job { std::move(_function), &_group, Memory::GetCurrentCounters() };
+
+        m_queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+        if (t_currentSystem == this)
+        {
+            m_workers[t_workerIndex]->m_deque.Push(job);
+        }
+        else
+        {
+            const std::lock_guard lock(m_injectionMutex);
+            m_injectionQueue.push_back(job);
+        }
+        WakeSleepers();
+    }
+
+    void JobSystem::Wait(JobGroup& _group)
+    {
+        KT_TRACE_ZONE("Wait");
+        const s32 workerIndex = t_currentSystem == this ? t_workerIndex : -1;
+        u32 stealSeed = u32(reinterpret_cast<uintptr_t>(&_group) >> 4);
+        u32 failedSearches = 0;
+
+        while (!_group.IsDone())
+        {
+            if (Job* job = FindJob(workerIndex, stealSeed))
+            {
+                Execute(job);
+                failedSearches = 0;
+            }
+            else if (++failedSearches < kSpinCount)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                SleepUntilWork(&_group);
+                failedSearches = 0;
+            }
+        }
+
+        if (_group.m_failed.load(std::memory_order_acquire))
+        {
+            std::exception_ptr exception;
+            {
+                const std::lock_guard lock(_group.m_exceptionMutex);
+                exception = std::exchange(_group.m_exception, nullptr);
+            }
+            _group.m_failed.store(false, std::memory_order_relaxed);
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
+    s32 JobSystem::GetCurrentWorkerIndex()
+    {
+        return t_workerIndex;
+    }
+
+    void JobSystem::WorkerMain(u32 _index)
+    {
+        t_currentSystem = this;
+        t_workerIndex = s32(_index);
+        Trace::SetThreadName(FormatString("Worker %u", _index));
+
+        u32 stealSeed = _index * 0x9E3779B9u + 1;
+        u32 failedSearches = 0;
+        while (!m_stopping.load(std::memory_order_relaxed))
+        {
+            if (Job* job = FindJob(s32(_index), stealSeed))
+            {
+                Execute(job);
+                failedSearches = 0;
+            }
+            else if (++failedSearches < kSpinCount)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                SleepUntilWork(nullptr);
+                failedSearches = 0;
+            }
+        }
+
+        t_currentSystem = nullptr;
+        t_workerIndex = -1;
+    }
+
+    JobSystem::Job* JobSystem::FindJob(s32 _workerIndex, u32& _stealSeed)
+    {
+        Job* job = nullptr;
+
+        if (_workerIndex >= 0 && m_workers[_workerIndex]->m_deque.Pop(job))
+        {
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+
+        {
+            const std::lock_guard lock(m_injectionMutex);
+            if (!m_injectionQueue.empty())
+            {
+                job = m_injectionQueue.front();
+                m_injectionQueue.pop_front();
+                m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // Random victim start, then sweep, so thieves spread out instead of all hammering worker 0.
+        const u32 workerCount = u32(m_workers.size());
+        _stealSeed ^= _stealSeed << 13;
+        _stealSeed ^= _stealSeed >> 17;
+        _stealSeed ^= _stealSeed << 5;
+        const u32 start = _stealSeed % workerCount;
+        for (u32 i = 0; i < workerCount; i++)
+        {
+            const u32 victim = (start + i) % workerCount;
+            if (s32(victim) == _workerIndex)
+            {
+                continue;
+            }
+            if (m_workers[victim]->m_deque.Steal(job))
+            {
+                m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void JobSystem::Execute(Job* _job)
+    {
+        JobGroup* group = _job->m_group;
+        // Whatever the job left in the scratch arena is released with it. Jobs executed while waiting nest on the
+        // same thread, so markers are always restored in order.
+        Arena& scratch = GetScratchArena();
+        const Arena::Marker marker = scratch.GetMarker();
+        try
+        {
+            const Memory::Scope memoryScope(_job->m_counters);
+            KT_TRACE_ZONE("Job");
+            _job->m_function();
+        }
+        catch (...)
+        {
+            const std::lock_guard lock(group->m_exceptionMutex);
+            if (!group->m_exception)
+            {
+                group->m_exception = std::current_exception();
+            }
+            group->m_failed.store(true, std::memory_order_release);
+        }
+        delete _job;
+        scratch.Restore(marker);
+        if (scratch.GetUsedSize() == 0)
+        {
+            scratch.Trim(kRetainedScratchSize);
+        }
+        Complete(*group);
+    }
+
+    void JobSystem::BeginExternal(JobGroup& _group)
+    {
+        _group.m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void JobSystem::EndExternal(JobGroup& _group)
+    {
+        Complete(_group);
+    }
+
+    void JobSystem::Complete(JobGroup& _group)
+    {
+        if (_group.m_pending.fetch_sub(1, std::memory_order_seq_cst) == 1)
+        {
+            // A waiter of this group might be sleeping.
+            if (m_sleepingThreads.load(std::memory_order_seq_cst) > 0)
+            {
+                const std::lock_guard lock(m_sleepMutex);
+                m_sleepCondition.notify_all();
+            }
+        }
+    }
+
+    void JobSystem::WakeSleepers()
+    {
+        if (m_sleepingThreads.load(std::memory_order_seq_cst) > 0)
+        {
+            const std::lock_guard lock(m_sleepMutex);
+            // Waiters and workers share the condition, so a single notification could be consumed by a waiter whose
+            // group is not done yet, which would go back to sleep without running anything.
+            m_sleepCondition.notify_all();
+        }
+    }
+
+    void JobSystem::SleepUntilWork(const JobGroup* _group)
+    {
+        std::unique_lock lock(m_sleepMutex);
+        m_sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the sleeper count reads of the notifiers: either they see this thread as sleeping, or the
+        // predicate below sees their update.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_sleepCondition.wait(lock, [this, _group] {
+            return m_stopping.load(std::memory_order_relaxed)
+                || m_queuedJobs.load(std::memory_order_seq_cst) > 0
+                || (_group != nullptr && _group->IsDone());
+        });
+        m_sleepingThreads.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,352 @@
+#include "KryneTools/Jobs/TaskGraph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Memory.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        struct ReadyTask
+        {
+            /// Estimated cost of the longest chain starting with the task.
+            f64 m_priority;
+            u32 m_index;
+
+            bool operator<(const ReadyTask& _other) const
+            {
+                // Declaration order breaks ties, for a deterministic schedule on one worker.
+                return m_priority != _other.m_priority ? m_priority < _other.m_priority : m_index > _other.m_index;
+            }
+        };
+    }
+
+    u32 TaskGraph::AddTask(std::string _name, f64 _cost, TaskFunction _function)
+    {
+        Task& task = m_tasks.emplace_back();
+        task.m_record.m_name = std::move(_name);
+        task.m_cost = std::max(_cost, 0.0);
+        task.m_function = std::move(_function);
+        return u32(m_tasks.size() - 1);
+    }
+
+    void TaskGraph::AddDependency(u32 _task, u32 _dependency)
+    {
+        KT_VERIFY(_task < m_tasks.size() && _dependency < m_tasks.size(), "Invalid task dependency %u -> %u", _task, _dependency);
+        KT_VERIFY(_task != _dependency, "Task '%s' depends on itself", m_tasks[_task].m_record.m_name.c_str());
+        m_tasks[_task].m_dependencies.push_back(_dependency);
+        m_tasks[_dependency].m_dependents.push_back(_task);
+    }
+
+    void TaskGraph::SetMemoryEstimate(u32 _task, u64 _bytes)
+    {
+        KT_VERIFY(_task < m_tasks.size(), "Invalid task %u", _task);
+        m_tasks[_task].m_memoryEstimate = _bytes;
+    }
+
+    TaskGraphStatistics TaskGraph::Run(JobSystem& _jobSystem, u32 _maxInFlight, u64 _memoryBudget)
+    {
+        return RunSelected(_jobSystem, std::vector<bool>(m_tasks.size(), true), _maxInFlight, _memoryBudget);
+    }
+
+    TaskGraphStatistics TaskGraph::Run(JobSystem& _jobSystem, std::span<const u32> _tasks, u32 _maxInFlight, u64 _memoryBudget)
+    {
+        std::vector<bool> selected(m_tasks.size(), false);
+        for (u32 task: CollectDependents(_tasks))
+        {
+            selected[task] = true;
+        }
+        return RunSelected(_jobSystem, selected, _maxInFlight, _memoryBudget);
+    }
+
+    std::vector<u32> TaskGraph::CollectDependents(std::span<const u32> _tasks) const
+    {
+        std::vector<bool> visited(m_tasks.size(), false);
+        std::vector<u32> stack;
+        for (u32 task: _tasks)
+        {
+            KT_VERIFY(task < m_tasks.size(), "Invalid task %u", task);
+            stack.push_back(task);
+        }
+        while (!stack.empty())
+        {
+            const u32 current = stack.back();
+            stack.pop_back();
+            if (visited[current])
+            {
+                continue;
+            }
+            visited[current] = true;
+            stack.insert(stack.end(), m_tasks[current].m_dependents.begin(), m_tasks[current].m_dependents.end());
+        }
+
+        std::vector<u32> tasks;
+        for (u32 i = 0; i < visited.size(); i++)
+        {
+            if (visited[i])
+            {
+                tasks.push_back(i);
+            }
+        }
+        return tasks;
+    }
+
+    TaskGraphStatistics TaskGraph::RunSelected(JobSystem& _jobSystem, const std::vector<bool>& _selected, u32 _maxInFlight, u64 _memoryBudget)
+    {
+        const size_t taskCount = m_tasks.size();
+
+        // Kahn's algorithm, the order is then used backwards to propagate the chain costs.
+        std::vector<u32> remaining(taskCount);
+        std::vector<u32> order;
+        order.reserve(taskCount);
+        for (size_t i = 0; i < taskCount; i++)
+        {
+            remaining[i] = u32(m_tasks[i].m_dependencies.size());
+            if (remaining[i] == 0)
+            {
+                order.push_back(u32(i));
+            }
+        }
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            for (u32 dependent: m_tasks[order[i]].m_dependents)
+            {
+                if (--remaining[dependent] == 0)
+                {
+                    order.push_back(dependent);
+                }
+            }
+        }
+        if (order.size() != taskCount)
+        {
+            for (size_t i = 0; i < taskCount; i++)
+            {
+                if (remaining[i] != 0)
+                {
+                    ThrowError("Task '%s' is part of a dependency cycle", m_tasks[i].m_record.m_name.c_str());
+                }
+            }
+        }
+
+        std::vector<f64> priorities(taskCount);
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            f64 chain = 0.0;
+            for (u32 dependent: m_tasks[*it].m_dependents)
+            {
+                chain = std::max(chain, priorities[dependent]);
+            }
+            priorities[*it] = m_tasks[*it].m_cost + chain;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto elapsed = [start] { return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count(); };
+
+        const u32 maxInFlight = _maxInFlight == 0 ? _jobSystem.GetWorkerCount() : _maxInFlight;
+        std::mutex mutex;
+        u32 inFlight = 0;
+        u64 inFlightMemory = 0;
+        u64 peakResidentBytes = 0;
+        std::vector<bool> deferred(taskCount, false);
+        JobGroup group;
+
+        const auto skipDependents = [&](u32 _task)
+        {
+            std::vector<u32> stack = { _task };
+            while (!stack.empty())
+            {
+                const u32 current = stack.back();
+                stack.pop_back();
+                for (u32 dependent: m_tasks[current].m_dependents)
+                {
+                    TaskRecord& record = m_tasks[dependent].m_record;
+                    if (record.m_status == TaskStatus::Pending)
+                    {
+                        record.m_status = TaskStatus::Skipped;
+                        record.m_error = m_tasks[_task].m_record.m_name;
+                        stack.push_back(dependent);
+                    }
+                }
+            }
+        };
+
+        // Selected tasks only wait on selected dependencies, the others are done, or the task is skipped.
+        for (size_t i = 0; i < taskCount; i++)
+        {
+            if (_selected[i])
+            {
+                m_tasks[i].m_record.m_status = TaskStatus::Pending;
+                m_tasks[i].m_record.m_error.clear();
+            }
+        }
+        std::priority_queue<ReadyTask> ready;
+        for (size_t i = 0; i < taskCount; i++)
+        {
+            Task& task = m_tasks[i];
+            if (!_selected[i] || task.m_record.m_status != TaskStatus::Pending)
+            {
+                continue;
+            }
+            remaining[i] = 0;
+            for (u32 dependency: task.m_dependencies)
+            {
+                const TaskRecord& record = m_tasks[dependency].m_record;
+                if (_selected[dependency])
+                {
+                    remaining[i]++;
+                }
+                else if (record.m_status != TaskStatus::Done && task.m_record.m_status == TaskStatus::Pending)
+                {
+                    task.m_record.m_status = TaskStatus::Skipped;
+                    task.m_record.m_error = record.m_name;
+                    skipDependents(u32(i));
+                }
+            }
+        }
+        for (size_t i = 0; i < taskCount; i++)
+        {
+            if (_selected[i] && m_tasks[i].m_record.m_status == TaskStatus::Pending && remaining[i] == 0)
+            {
+                ready.push({ priorities[i], u32(i) });
+            }
+        }
+
+        // Called with the mutex held. Jobs spawned from a finishing task go to the deque of its worker, which picks
+        // them next, so a chain tends to stay on one worker.
+        std::function<void()> dispatch = [&]
+        {
+            std::vector<ReadyTask> waiting;
+            while (inFlight < maxInFlight && !ready.empty())
+            {
+                const ReadyTask next = ready.top();
+                const u32 index = next.m_index;
+                ready.pop();
+                const Task& candidate = m_tasks[index];
+                const u64 memory = _memoryBudget != 0 ? std::max(candidate.m_memoryEstimate, candidate.m_record.m_memory.m_peakHeapBytes) : 0;
+                if (_memoryBudget != 0 && inFlight > 0 && inFlightMemory + memory > _memoryBudget)
+                {
+                    // Keeps its priority for when memory is released, smaller tasks behind it may still fit.
+                    waiting.push_back(next);
+                    deferred[index] = true;
+                    continue;
+                }
+                inFlight++;
+                inFlightMemory += memory;
+                if (memory != 0)
+                {
+                    Trace::RecordCounter("Budgeted MiB", f64(inFlightMemory) / f64(1 << 20));
+                }
+                _jobSystem.Spawn(group, [&, index, memory]
+                {
+                    Task& task = m_tasks[index];
+                    task.m_record.m_startSeconds = elapsed();
+                    std::string error;
+                    bool failed = false;
+                    Memory::Counters counters;
+                    try
+                    {
+                        KT_TRACE_ZONE_DETAIL("Task", task.m_record.m_name);
+                        {
+                            const Memory::Scope memoryScope(&counters);
+                            task.m_function();
+                        }
+                        const MemoryStatistics memoryStatistics = counters.GetStatistics();
+                        Trace::AddZoneArgument("allocations", memoryStatistics.m_allocationCount);
+                        Trace::AddZoneArgument("allocated bytes", memoryStatistics.m_allocatedBytes);
+                        Trace::AddZoneArgument("peak heap bytes", memoryStatistics.m_peakHeapBytes);
+                        Trace::AddZoneArgument("peak arena bytes", memoryStatistics.m_peakArenaBytes);
+                    }
+                    catch (const std::exception& _exception)
+                    {
+                        failed = true;
+                        error = _exception.what();
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                        error = "Unknown exception";
+                    }
+                    task.m_record.m_endSeconds = elapsed();
+                    task.m_record.m_memory = counters.GetStatistics();
+                    task.m_record.m_residentBytes = Memory::GetResidentSize().m_currentBytes;
+                    Trace::RecordCounter("Resident MiB", f64(task.m_record.m_residentBytes) / f64(1 << 20));
+
+                    const std::lock_guard lock(mutex);
+                    inFlight--;
+                    inFlightMemory -= memory;
+                    if (memory != 0)
+                    {
+                        Trace::RecordCounter("Budgeted MiB", f64(inFlightMemory) / f64(1 << 20));
+                    }
+                    peakResidentBytes = std::max(peakResidentBytes, task.m_record.m_residentBytes);
+                    task.m_record.m_status = failed ? TaskStatus::Failed : TaskStatus::Done;
+                    task.m_record.m_error = std::move(error);
+                    if (failed)
+                    {
+                        skipDependents(index);
+                    }
+                    else
+                    {
+                        for (u32 dependent: task.m_dependents)
+                        {
+                            if (--remaining[dependent] == 0 && m_tasks[dependent].m_record.m_status == TaskStatus::Pending)
+                            {
+                                ready.push({ priorities[dependent], dependent });
+                            }
+                        }
+                    }
+                    dispatch();
+                });
+            }
+            for (const ReadyTask& task: waiting)
+            {
+                ready.push(task);
+            }
+        };
+
+        {
+            const std::lock_guard lock(mutex);
+            dispatch();
+        }
+        _jobSystem.Wait(group);
+
+        TaskGraphStatistics statistics;
+        statistics.m_seconds = elapsed();
+        statistics.m_peakResidentBytes = peakResidentBytes;
+        statistics.m_memoryDeferredCount = u32(std::count(deferred.begin(), deferred.end(), true));
+        std::vector<f64> chainSeconds(taskCount);
+        f64 busySeconds = 0.0;
+        for (u32 index: order)
+        {
+            if (!_selected[index])
+            {
+                continue;
+            }
+            const TaskRecord& record = m_tasks[index].m_record;
+            const f64 duration = record.m_status == TaskStatus::Skipped ? 0.0 : record.m_endSeconds - record.m_startSeconds;
+            f64 chain = 0.0;
+            for (u32 dependency: m_tasks[index].m_dependencies)
+            {
+                chain = std::max(chain, chainSeconds[dependency]);
+            }
+            chainSeconds[index] = chain + duration;
+            statistics.m_criticalPathSeconds = std::max(statistics.m_criticalPathSeconds, chainSeconds[index]);
+            busySeconds += duration;
+
+            statistics.m_doneCount += record.m_status == TaskStatus::Done ? 1 : 0;
+            statistics.m_failedCount += record.m_status == TaskStatus::Failed ? 1 : 0;
+            statistics.m_skippedCount += record.m_status == TaskStatus::Skipped ? 1 : 0;
+        }
+        statistics.m_parallelism = statistics.m_seconds > 0.0 ? busySeconds / statistics.m_seconds : 0.0;
+        return statistics;
+    }
+}
@@ -0,0 +1,455 @@
+#include "KryneTools/Json/Json.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        const JsonValue g_null {};
+        const JsonValue::Array g_emptyArray {};
+        const JsonValue::Object g_emptyObject {};
+
+        // Guards the recursive descent against stack exhaustion on hostile inputs.
+        constexpr u32 kMaxDepth = 512;
+    }
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(std::string_view _text)
+            : m_text(_text)
+        {}
+
+        JsonValue ParseDocument()
+        {
+            JsonValue result = ParseValue(0);
+            SkipWhitespace();
+            if (m_position != m_text.size())
+            {
+                Fail("unexpected trailing characters");
+            }
+            return result;
+        }
+
+    private:
+        std::string_view m_text;
+        size_t m_position = 0;
+
+        [[noreturn]] void Fail(const char* _reason) const
+        {
+            u32 line = 1;
+            u32 column = 1;
+            for (size_t i = 0; i < m_position && i < m_text.size(); i++)
+            {
+                if (m_text[i] == '\n')
+                {
+                    line++;
+                    column = 1;
+                }
+                else
+                {
+                    column++;
+                }
+            }
+            ThrowError("JSON parse error at %u:%u: %s", line, column, _reason);
+        }
+
+        void SkipWhitespace()
+        {
+            while (m_position < m_text.size())
+            {
+                const char c = m_text[m_position];
+                if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+                {
+                    break;
+                }
+                m_position++;
+            }
+        }
+
+        [[nodiscard]] char Peek() const
+        {
+            return m_position < m_text.size() ? m_text[m_position] : '\0';
+        }
+
+        void Expect(char _c)
+        {
+            if (Peek() != _c)
+            {
+                char message[] = "expected ' '";
+                message[10] = _c;
+                Fail(message);
+            }
+            m_position++;
+        }
+
+        bool ConsumeLiteral(std::string_view _literal)
+        {
+            if (m_text.substr(m_position, _literal.size()) == _literal)
+            {
+                m_position += _literal.size();
+                return true;
+            }
+            return false;
+        }
+
+        JsonValue ParseValue(u32 _depth)
+        {
+            if (_depth > kMaxDepth)
+            {
+                Fail("document nested too deeply");
+            }
+
+            SkipWhitespace();
+            JsonValue result;
+            switch (Peek())
+            {
+                case '{':
+                    result.m_value = ParseObject(_depth);
+                    break;
+                case '[':
+                    result.m_value = ParseArray(_depth);
+                    break;
+                case '"':
+                    result.m_value = ParseString();
+                    break;
+                case 't':
+                    if (!ConsumeLiteral("true"))
+                    {
+                        Fail("invalid literal");
+                    }
+                    result.m_value = true;
+                    break;
+                case 'f':
+                    if (!ConsumeLiteral("false"))
+                    {
+                        Fail("invalid literal");
+                    }
+                    result.m_value = false;
+                    break;
+                case 'n':
+                    if (!ConsumeLiteral("null"))
+                    {
+                        Fail("invalid literal");
+                    }
+                    break;
+                default:
+                    result.m_value = ParseNumber();
+                    break;
+            }
+            return result;
+        }
+
+        JsonValue::Object ParseObject(u32 _depth)
+        {
+            Expect('{');
+            JsonValue::Object object;
+            SkipWhitespace();
+            if (Peek() == '}')
+            {
+                m_position++;
+                return object;
+            }
+
+            while (true)
+            {
+                SkipWhitespace();
+                std::string key = ParseString();
+                SkipWhitespace();
+                Expect(':');
+                object.emplace_back(std::move(key), ParseValue(_depth + 1));
+                SkipWhitespace();
+                if (Peek() == ',')
+                {
+                    m_position++;
+                    continue;
+                }
+                Expect('}');
+                return object;
+            }
+        }
+
+        JsonValue::Array ParseArray(u32 _depth)
+        {
+            Expect('[');
+            JsonValue::Array array;
+            SkipWhitespace();
+            if (Peek() == ']')
+            {
+                m_position++;
+                return array;
+            }
+
+            while (true)
+            {
+                array.push_back(ParseValue(_depth + 1));
+                SkipWhitespace();
+                if (Peek() == ',')
+                {
+                    m_position++;
+                    continue;
+                }
+                Expect(']');
+                return array;
+            }
+        }
+
+        u32 ParseHex4()
+        {
+            if (m_position + 4 > m_text.size())
+            {
+                Fail("truncated unicode escape");
+            }
+            u32 value = 0;
+            for (u32 i = 0; i < 4; i++)
+            {
+                const char c = m_text[m_position++];
+                value <<= 4;
+                if (c >= '0' && c <= '9') value |= u32(c - '0');
+                else if (c >= 'a' && c <= 'f') value |= u32(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F') value |= u32(c - 'A' + 10);
+                else Fail("invalid unicode escape");
+            }
+            return value;
+        }
+
+        static void AppendUtf8(std::string& _output, u32 _codePoint)
+        {
+            if (_codePoint < 0x80)
+            {
+                _output += char(_codePoint);
+            }
+            else if (_codePoint < 0x800)
+            {
+                _output += char(0xC0 | (_codePoint >> 6));
+                _output += char(0x80 | (_codePoint & 0x3F));
+            }
+            else if (_codePoint < 0x10000)
+            {
+                _output += char(0xE0 | (_codePoint >> 12));
+                _output += char(0x80 | ((_codePoint >> 6) & 0x3F));
+                _output += char(0x80 | (_codePoint & 0x3F));
+            }
+            else
+            {
+                _output += char(0xF0 | (_codePoint >> 18));
+                _output += char(0x80 | ((_codePoint >> 12) & 0x3F));
+                _output += char(0x80 | ((_codePoint >> 6) & 0x3F));
+                _output += char(0x80 | (_codePoint & 0x3F));
+            }
+        }
+
+        std::string ParseString()
+        {
+            Expect('"');
+            std::string result;
+            while (true)
+            {
+                if (m_position >= m_text.size())
+                {
+                    Fail("unterminated string");
+                }
+
+                // Copy unescaped runs in one go, escapes are rare in asset files.
+                const size_t runStart = m_position;
+                while (m_position < m_text.size() && m_text[m_position] != '"' && m_text[m_position] != '\\')
+                {
+                    if (u8(m_text[m_position]) < 0x20)
+                    {
+                        Fail("control character in string");
+                    }
+                    m_position++;
+                }
+                result.append(m_text.substr(runStart, m_position - runStart));
+
+                if (m_position >= m_text.size())
+                {
+                    Fail("unterminated string");
+                }
+
+                if (m_text[m_position++] == '"')
+                {
+                    return result;
+                }
+
+                if (m_position >= m_text.size())
+                {
+                    Fail("unterminated escape");
+                }
+                const char escape = m_text[m_position++];
+                switch (escape)
+                {
+                    case '"': result += '"'; break;
+                    case '\\': result += '\\'; break;
+                    case '/': result += '/'; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'n': result += '\n'; break;
+                    case 'r': result += '\r'; break;
+                    case 't': result += '\t'; break;
+                    case 'u':
+                    {
+                        u32 codePoint = ParseHex4();
+                        if (codePoint >= 0xD800 && codePoint < 0xDC00)
+                        {
+                            if (!ConsumeLiteral("\\u"))
+                            {
+                                Fail("unpaired surrogate");
+                            }
+                            const u32 low = ParseHex4();
+                            if (low < 0xDC00 || low >= 0xE000)
+                            {
+                                Fail("invalid surrogate pair");
+                            }
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        AppendUtf8(result, codePoint);
+                        break;
+                    }
+                    default:
+                        Fail("invalid escape sequence");
+                }
+            }
+        }
+
+        f64 ParseNumber()
+        {
+            const size_t start = m_position;
+            if (Peek() == '-')
+            {
+                m_position++;
+            }
+            while (m_position < m_text.size())
+            {
+                const char c = m_text[m_position];
+                if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+                {
+                    m_position++;
+                    continue;
+                }
+                break;
+            }
+
+            if (m_position == start)
+            {
+                Fail("unexpected character");
+            }
+
+            // strtod requires a terminated buffer, numbers are short enough for a stack copy.
+            char buffer[128];
+            const size_t length = m_position - start;
+            if (length >= sizeof(buffer))
+            {
+                Fail("number literal too long");
+            }
+            m_text.copy(buffer, length, start);
+            buffer[length] = '\0';
+
+            char* end = nullptr;
+            const f64 value = std::strtod(buffer, &end);
+            if (end != buffer + length)
+            {
+                Fail("invalid number");
+            }
+            return value;
+        }
+    };
+
+    JsonValue JsonValue::Parse(std::string_view _text)
+    {
+        return JsonParser(_text).ParseDocument();
+    }
+
+    bool JsonValue::AsBool(bool _default) const
+    {
+        const bool* value = std::get_if<bool>(&m_value);
+        return value != nullptr ? *value : _default;
+    }
+
+    f64 JsonValue::AsNumber(f64 _default) const
+    {
+        const f64* value = std::get_if<f64>(&m_value);
+        return value != nullptr ? *value : _default;
+    }
+
+    u32 JsonValue::AsU32(u32 _default) const
+    {
+        const f64* value = std::get_if<f64>(&m_value);
+        if (value == nullptr || !(*value >= 0.0) || *value > f64(UINT32_MAX) || std::floor(*value) != *value)
+        {
+            return _default;
+        }
+        return u32(*value);
+    }
+
+    u64 JsonValue::AsU64(u64 _default) const
+    {
+        const f64* value = std::get_if<f64>(&m_value);
+        if (value == nullptr || !(*value >= 0.0) || *value >= 18446744073709551616.0 || std::floor(*value) != *value)
+        {
+            return _default;
+        }
+        return u64(*value);
+    }
+
+    std::string_view JsonValue::AsString(std::string_view _default) const
+    {
+        const std::string* value = std::get_if<std::string>(&m_value);
+        return value != nullptr ? std::string_view(*value) : _default;
+    }
+
+    const JsonValue::Array& JsonValue::AsArray() const
+    {
+        const Array* value = std::get_if<Array>(&m_value);
+        return value != nullptr ? *value : g_emptyArray;
+    }
+
+    const JsonValue::Object& JsonValue::AsObject() const
+    {
+        const Object* value = std::get_if<Object>(&m_value);
+        return value != nullptr ? *value : g_emptyObject;
+    }
+
+    size_t JsonValue::Size() const
+    {
+        if (const Array* array = std::get_if<Array>(&m_value))
+        {
+            return array->size();
+        }
+        if (const Object* object = std::get_if<Object>(&m_value))
+        {
+            return object->size();
+        }
+        return 0;
+    }
+
+    bool JsonValue::Contains(std::string_view _key) const
+    {
+        return &(*this)[_key] != &g_null;
+    }
+
+    const JsonValue& JsonValue::operator[](std::string_view _key) const
+    {
+        if (const Object* object = std::get_if<Object>(&m_value))
+        {
+            for (const auto& [key, value]: *object)
+            {
+                if (key == _key)
+                {
+                    return value;
+                }
+            }
+        }
+        return g_null;
+    }
+
+    const JsonValue& JsonValue::operator[](size_t _index) const
+    {
+        const Array* array = std::get_if<Array>(&m_value);
+        return array != nullptr && _index < array->size() ? (*array)[_index] : g_null;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "KryneTools/Cook/CookManifest.hpp"
+#include "KryneTools/Jobs/TaskGraph.hpp"
+#include "KryneTools/Pack/PackBuilder.hpp"
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class CookCoordinator;
+    class JobSystem;
+
+    struct CookSettings
+    {
+        /// Loose outputs, in `meshes`, `materials`, `textures` and `shaders` subdirectories.
+        std::filesystem::path m_outputDirectory;
+        /// Archive of every output, named relative to the output directory. No archive is written when empty.
+        std::filesystem::path m_packPath;
+        PackSettings m_pack;
+        /// Searched after the shader manifest include directories.
+        std::vector<std::filesystem::path> m_includeDirectories;
+        ShaderCompilerSettings m_compiler;
+        /// Optional artifact cache, shared by every stage.
+        ContentCache* m_cache = nullptr;
+        /// Optional, offers texture cooks and shader compiles missing from the cache to its remote workers.
+        CookCoordinator* m_coordinator = nullptr;
+        /// Estimated heap of the tasks in flight, 0 for no limit (see `TaskGraph::Run()`).
+        u64 m_memoryBudget = 0;
+    };
+
+    /// One asset of the cook, a node of its dependency graph.
+    struct CookAssetRecord
+    {
+        TaskRecord m_task;
+        /// Estimated cost used for the critical path.
+        f64 m_cost = 0.0;
+        std::vector<std::filesystem::path> m_outputs;
+        bool m_cacheHit = false;
+        /// Some of the work ran on a remote worker.
+        bool m_remote = false;
+    };
+
+    struct CookResult
+    {
+        std::vector<CookAssetRecord> m_assets;
+        TaskGraphStatistics m_schedule;
+        /// Written only when every asset cooked.
+        PackStatistics m_pack;
+    };
+
+    /**
+     * @brief Cooks every asset of a manifest as a single dependency graph, on one job system.
+     *
+     * @details
+     * Each shader, texture, material and glTF asset is a task. A material depends on its shaders, whose permutations
+     * it resolves, and on its textures; a mesh depends on the materials its submeshes name. Tasks start as soon as
+     * their dependencies are done, longest estimated chain first (see `TaskGraph`), so stages overlap instead of
+     * running as serial passes, and the cook takes about as long as its longest chain. Tasks fork their usual jobs,
+     * which fill the pool between them.
+     *
+     * Textures and meshes are given memory estimates from their source sizes, and with a memory budget they only
+     * start once the tasks in flight leave room for them: a batch of 8K textures decodes a few at a time.
+     *
+     * With a coordinator, texture cooks and shader compiles missing from the cache are offered to its workers, and as
+     * many more tasks as there are remote slots are kept in flight; work no worker takes still runs locally.
+     *
+     * Outputs are added to the archive as their task finishes, through a `PackWriter`. A failed asset fails alone:
+     * its dependents are skipped, everything else still cooks, and the archive is only kept if nothing failed.
+     * Throws an `Error` only for problems found while building the graph, such as unknown references.
+     */
+    CookResult CookAssets(JobSystem& _jobSystem, const CookManifest& _manifest, const CookSettings& _settings);
+
+    /**
+     * @brief The dependency graph of `CookAssets()`, kept resident to recook only what changed sources affect.
+     *
+     * @details
+     * The graph, the parsed manifests and the glTF dependency scans are built once. `Recook()` maps changed files to
+     * the tasks reading them (shader sources and include directories, texture images, glTF assets and their buffers)
+     * and runs those and their dependents only, so a texture edit recooks the texture and its materials. Edits of the
+     * shader or material manifests change the graph itself: `RequiresRebuild()` reports them, callers then build a new
+     * session, whose unchanged assets come back from the cache.
+     *
+     * The archive, if any, is only written by `Cook()`. `Recook()` updates the loose outputs.
+     */
+    class CookSession
+    {
+    public:
+        /// Throws an `Error` for problems found while building the graph, such as unknown references.
+        CookSession(JobSystem& _jobSystem, const CookManifest& _manifest, const CookSettings& _settings);
+        ~CookSession();
+
+        CookSession(const CookSession&) = delete;
+        CookSession& operator=(const CookSession&) = delete;
+
+        /// Cooks every asset.
+        CookResult Cook();
+
+        /// Recooks the assets depending on `_changedFiles`. The result only holds the assets that ran.
+        CookResult Recook(std::span<const std::filesystem::path> _changedFiles);
+
+        /// A manifest of the session is among the changed files.
+        [[nodiscard]] bool RequiresRebuild(std::span<const std::filesystem::path> _changedFiles) const;
+
+        /// Directories holding every source and manifest of the session, to watch.
+        [[nodiscard]] std::vector<std::filesystem::path> GetSourceDirectories() const;
+
+        [[nodiscard]] const std::filesystem::path& GetOutputDirectory() const;
+
+    private:
+        struct State;
+
+        std::unique_ptr<State> m_state;
+    };
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "KryneTools/Texture/BlockCompression.hpp"
+
+namespace KryneTools
+{
+    /// Cook options of a source image, see `TextureCookSettings`.
+    struct CookTextureDescription
+    {
+        /// Resolved against the manifest directory.
+        std::filesystem::path m_source;
+        TextureFormat m_format = TextureFormat::Bc7;
+        EncodeQuality m_quality = EncodeQuality::Fast;
+        bool m_srgb = true;
+        bool m_normalMap = false;
+        bool m_generateMips = true;
+    };
+
+    /// Every asset of a cook, paths resolved against the manifest directory.
+    struct CookManifest
+    {
+        /// Shader and material manifests, empty when the project has none.
+        std::filesystem::path m_shaderManifest;
+        std::filesystem::path m_materialManifest;
+        /// Textures with explicit options. Those only referenced by materials use the defaults.
+        std::vector<CookTextureDescription> m_textures;
+        /// glTF assets.
+        std::vector<std::filesystem::path> m_meshes;
+    };
+
+    /**
+     * @brief Loads a JSON cook manifest, the list of sources `kryne-cook` builds.
+     *
+     * @details
+     * ```json
+     * {
+     *     "shaders": "shaders/manifest.json",
+     *     "materials": "materials.json",
+     *     "textures": [
+     *         { "source": "textures/rock_normal.png", "format": "bc5", "normal_map": true },
+     *         { "source": "textures/sky.png", "quality": "high", "mips": false }
+     *     ],
+     *     "meshes": ["meshes/rock.glb", "meshes/level01.gltf"]
+     * }
+     * ```
+     * Texture keys are `format`, `quality` (`fast` or `high`), `srgb` (defaults to true, false for normal maps),
+     * `normal_map` and `mips`. Throws an `Error` on malformed manifests.
+     */
+    [[nodiscard]] CookManifest LoadCookManifest(const std::filesystem::path& _path);
+}
@@ -0,0 +1,468 @@
+#include "KryneTools/Cook/AssetCooker.hpp"
+
+#include <map>
+#include <optional>
+#include <set>
+#include <system_error>
+#include <unordered_map>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Distributed/CookCoordinator.hpp"
+#include "KryneTools/Import/GltfDocument.hpp"
+#include "KryneTools/Import/GltfImporter.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Pipeline/MaterialManifest.hpp"
+#include "KryneTools/Pipeline/MaterialWriter.hpp"
+#include "KryneTools/Shader/ShaderCooker.hpp"
+#include "KryneTools/Shader/ShaderReader.hpp"
+#include "KryneTools/Texture/Image.hpp"
+#include "KryneTools/Texture/TextureCooker.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        // Rough costs of each stage, in seconds on one worker. Only their ratios matter to the schedule, so they are
+        // estimates from the source sizes rather than measurements.
+        constexpr f64 kMeshSecondsPerByte = 3e-7;
+        constexpr f64 kTextureSecondsPerByte = 2e-7;
+        constexpr f64 kShaderSecondsPerPermutation = 0.05;
+        constexpr f64 kMaterialSeconds = 1e-3;
+
+        // Peak heap of the stages, also from the source sizes, for the memory budget. A texture cook holds the decoded
+        // image, its mip chain and the encoded blocks, about 7 bytes per source texel; a mesh import its decoded
+        // streams, their optimized copies and the meshlets, about 10 times its glTF buffers. Both constants round these
+        // up by a fifth, for the scratch arenas and the output buffers: an estimate that is too low overcommits the
+        // budget, one that is too high only runs a few tasks less at once.
+        constexpr u64 kTextureBytesPerTexel = 8;
+        constexpr u64 kMeshBytesPerSourceByte = 12;
+
+        u64 GetFileSize(const std::filesystem::path& _path)
+        {
+            std::error_code error;
+            const u64 size = std::filesystem::file_size(_path, error);
+            return error ? 0 : size;
+        }
+
+        /// Materials and the manifest texture list may spell the same source differently.
+        std::filesystem::path GetSourceKey(const std::filesystem::path& _path)
+        {
+            std::error_code error;
+            const std::filesystem::path absolute = std::filesystem::absolute(_path).lexically_normal();
+            std::filesystem::path key = std::filesystem::weakly_canonical(absolute, error);
+            return error ? absolute : key;
+        }
+
+        std::string GetPackName(const std::filesystem::path& _output, const std::filesystem::path& _root)
+        {
+            return _output.lexically_relative(_root).generic_string();
+        }
+
+        struct ShaderNode
+        {
+            u32 m_task = 0;
+            std::filesystem::path m_output;
+        };
+
+        struct TextureNode
+        {
+            u32 m_task = 0;
+            CookTextureDescription m_description;
+            std::filesystem::path m_output;
+        };
+    }
+
+    struct CookSession::State
+    {
+        JobSystem& m_jobSystem;
+        CookManifest m_manifest;
+        CookSettings m_settings;
+        std::filesystem::path m_root;
+        std::filesystem::path m_scratchRoot;
+
+        TaskGraph m_graph;
+        std::vector<CookAssetRecord> m_assets;
+        /// Only open during `Cook()`.
+        std::optional<PackWriter> m_pack;
+
+        ShaderManifest m_shaderManifest;
+        std::unordered_map<std::string, ShaderNode> m_shaders;
+        MaterialManifest m_materialManifest;
+        /// Listed textures first, then those only named by materials, with the default options.
+        std::vector<TextureNode> m_textures;
+        std::map<std::filesystem::path, u32> m_textureIndices;
+        std::unordered_map<std::string, u32> m_materials;
+
+        /// Tasks reading each source file, by `GetSourceKey()`.
+        std::map<std::filesystem::path, std::vector<u32>> m_sourceTasks;
+        /// Shaders recook when anything in an include directory changes, as their includes are not tracked.
+        std::set<std::filesystem::path> m_includeDirectories;
+        std::vector<u32> m_shaderTasks;
+        std::set<std::filesystem::path> m_manifests;
+
+        State(JobSystem& _jobSystem, const CookManifest& _manifest, const CookSettings& _settings);
+
+        u32 AddTask(std::string _name, f64 _cost, TaskGraph::TaskFunction _function);
+        /// Streams the outputs of a finished task to the archive, from the task itself.
+        void AddOutputs(u32 _task, std::vector<std::filesystem::path> _outputs, bool _cacheHit, bool _remote);
+        void AddSource(const std::filesystem::path& _source, u32 _task);
+        u32 FindTexture(const CookTextureDescription& _description);
+        void RemoveScratch() const;
+    };
+
+    CookSession::State::State(JobSystem& _jobSystem, const CookManifest& _manifest, const CookSettings& _settings)
+        : m_jobSystem(_jobSystem)
+        , m_manifest(_manifest)
+        , m_settings(_settings)
+        , m_root(_settings.m_outputDirectory)
+        , m_scratchRoot(_settings.m_compiler.m_scratchDirectory.empty() ? m_root / ".kryne-cook" : _settings.m_compiler.m_scratchDirectory)
+    {
+        KT_TRACE_ZONE("BuildCookGraph");
+
+        // Shaders are cooked one at a time through a manifest of one, so materials only wait on the shaders they use.
+        if (!m_manifest.m_shaderManifest.empty())
+        {
+            m_shaderManifest = LoadShaderManifest(m_manifest.m_shaderManifest);
+            m_manifests.insert(GetSourceKey(m_manifest.m_shaderManifest));
+        }
+        for (const std::filesystem::path& directory: m_shaderManifest.m_includeDirectories)
+        {
+            m_includeDirectories.insert(GetSourceKey(directory));
+        }
+        for (const std::filesystem::path& directory: m_settings.m_includeDirectories)
+        {
+            m_includeDirectories.insert(GetSourceKey(directory));
+        }
+        for (const ShaderDescription& shader: m_shaderManifest.m_shaders)
+        {
+            ShaderNode node { m_graph.GetTaskCount(), m_root / "shaders" / (shader.m_name + ".kshd") };
+            AddTask("shader " + shader.m_name, kShaderSecondsPerPermutation * f64(shader.GetPermutationCount()), [&, task = node.m_task]
+            {
+                ShaderManifest single;
+                single.m_shaders = { shader };
+                single.m_includeDirectories = m_shaderManifest.m_includeDirectories;
+
+                ShaderCookSettings settings;
+                settings.m_outputDirectory = m_root / "shaders";
+                settings.m_includeDirectories = m_settings.m_includeDirectories;
+                settings.m_compiler = m_settings.m_compiler;
+                settings.m_compiler.m_scratchDirectory = m_scratchRoot / shader.m_name;
+                settings.m_cache = m_settings.m_cache;
+                if (m_settings.m_coordinator != nullptr)
+                {
+                    settings.m_remoteCompile = [&](const ShaderCompileRequest& _request, std::string_view _identity, const CacheKey& _key)
+                    {
+                        return m_settings.m_coordinator->CompileShader(_request, _identity, _key, m_settings.m_compiler);
+                    };
+                }
+                const ShaderCookStatistics statistics = CookShaders(m_jobSystem, single, settings);
+                AddOutputs(task, statistics.m_outputs, statistics.m_compiledCount == 0, statistics.m_remoteCount > 0);
+            });
+            AddSource(shader.m_source, node.m_task);
+            m_shaderTasks.push_back(node.m_task);
+            m_shaders.emplace(shader.m_name, std::move(node));
+        }
+
+        if (!m_manifest.m_materialManifest.empty())
+        {
+            m_materialManifest = LoadMaterialManifest(m_manifest.m_materialManifest);
+            m_manifests.insert(GetSourceKey(m_manifest.m_materialManifest));
+        }
+
+        for (const CookTextureDescription& texture: m_manifest.m_textures)
+        {
+            FindTexture(texture);
+        }
+        for (const MaterialDescription& material: m_materialManifest.m_materials)
+        {
+            for (const MaterialTextureReference& reference: material.m_textures)
+            {
+                CookTextureDescription description;
+                description.m_source = reference.m_source;
+                FindTexture(description);
+            }
+        }
+
+        std::unordered_map<std::string, std::filesystem::path> textureOutputs;
+        for (TextureNode& texture: m_textures)
+        {
+            const std::filesystem::path& source = texture.m_description.m_source;
+            texture.m_output = m_root / "textures" / source.filename().replace_extension(GetTextureContainerExtension(TextureContainer::Ktex));
+            const auto [it, inserted] = textureOutputs.try_emplace(texture.m_output.filename().string(), source);
+            KT_VERIFY(inserted, "Textures '%s' and '%s' would both cook to %s", it->second.string().c_str(), source.string().c_str(), texture.m_output.string().c_str());
+
+            texture.m_task = m_graph.GetTaskCount();
+            AddTask("texture " + source.filename().string(), kTextureSecondsPerByte * f64(GetFileSize(source)), [&, task = texture.m_task]
+            {
+                TextureCookSettings settings;
+                settings.m_input = texture.m_description.m_source;
+                settings.m_outputDirectory = m_root / "textures";
+                settings.m_format = texture.m_description.m_format;
+                settings.m_quality = texture.m_description.m_quality;
+                settings.m_srgb = texture.m_description.m_srgb;
+                settings.m_normalMap = texture.m_description.m_normalMap;
+                settings.m_generateMips = texture.m_description.m_generateMips;
+                settings.m_cache = m_settings.m_cache;
+                if (m_settings.m_coordinator != nullptr)
+                {
+                    settings.m_remoteCook = [&](const TextureCookSettings& _texture, const std::filesystem::path& _output)
+                    {
+                        return m_settings.m_coordinator->CookTexture(_texture, _output);
+                    };
+                }
+                const TextureCookResult cooked = CookTexture(m_jobSystem, settings);
+                AddOutputs(task, { cooked.m_output }, cooked.m_cacheHit, cooked.m_remote);
+            });
+            AddSource(source, texture.m_task);
+            u32 width = 0;
+            u32 height = 0;
+            if (ReadImageSize(source, width, height))
+            {
+                m_graph.SetMemoryEstimate(texture.m_task, kTextureBytesPerTexel * width * height);
+            }
+        }
+
+        for (const MaterialDescription& material: m_materialManifest.m_materials)
+        {
+            const u32 materialTask = AddTask("material " + material.m_name, kMaterialSeconds, [&, task = m_graph.GetTaskCount()]
+            {
+                CookedMaterial cooked;
+                cooked.m_manifest = &m_materialManifest;
+                cooked.m_description = &material;
+                for (const MaterialShaderReference& reference: material.m_shaders)
+                {
+                    const ShaderNode& shader = m_shaders.at(reference.m_shader);
+                    const ShaderFile file = ShaderFile::Open(shader.m_output);
+                    const u32 permutation = file.FindPermutation(reference.m_permutation);
+                    cooked.m_shaders.push_back({ GetPackName(shader.m_output, m_root), file.GetStage(), permutation, file.GetPermutationModule(permutation) });
+                }
+                for (const MaterialTextureReference& reference: material.m_textures)
+                {
+                    const TextureNode& texture = m_textures[m_textureIndices.at(GetSourceKey(reference.m_source))];
+                    cooked.m_textures.push_back({ reference.m_slot, GetPackName(texture.m_output, m_root) });
+                }
+
+                const std::filesystem::path output = m_root / "materials" / (material.m_name + ".kmat");
+                WriteMaterialFile(output, cooked);
+                AddOutputs(task, { output }, false, false);
+            });
+
+            for (const MaterialShaderReference& reference: material.m_shaders)
+            {
+                const auto it = m_shaders.find(reference.m_shader);
+                KT_VERIFY(it != m_shaders.end(), "Material '%s' uses shader '%s', which is not in the shader manifest", material.m_name.c_str(), reference.m_shader.c_str());
+                m_graph.AddDependency(materialTask, it->second.m_task);
+            }
+            for (const MaterialTextureReference& reference: material.m_textures)
+            {
+                m_graph.AddDependency(materialTask, m_textures[m_textureIndices.at(GetSourceKey(reference.m_source))].m_task);
+            }
+            KT_VERIFY(m_materials.emplace(material.m_name, materialTask).second, "Duplicate material '%s'", material.m_name.c_str());
+        }
+
+        for (const std::filesystem::path& source: m_manifest.m_meshes)
+        {
+            // Only the JSON part is needed here, the importer maps the asset again for the actual decode.
+            const Gltf::Document document = Gltf::Document::Load(source);
+            u64 size = GetFileSize(source);
+            for (const std::filesystem::path& buffer: document.GetExternalBufferPaths())
+            {
+                size += GetFileSize(buffer);
+            }
+
+            const u32 meshTask = AddTask("mesh " + source.filename().string(), kMeshSecondsPerByte * f64(size), [&, source, task = m_graph.GetTaskCount()]
+            {
+                ImportSettings settings;
+                settings.m_input = source;
+                settings.m_outputDirectory = m_root / "meshes";
+                settings.m_cache = m_settings.m_cache;
+                const ImportResult imported = ImportGltf(m_jobSystem, settings);
+                AddOutputs(task, imported.m_outputs, imported.m_cacheHit, false);
+            });
+            AddSource(source, meshTask);
+            m_graph.SetMemoryEstimate(meshTask, kMeshBytesPerSourceByte * size);
+            for (const std::filesystem::path& buffer: document.GetExternalBufferPaths())
+            {
+                AddSource(buffer, meshTask);
+            }
+
+            std::set<u32> dependencies;
+            for (const Gltf::Material& material: document.GetMaterials())
+            {
+                const auto it = m_materials.find(material.m_name);
+                if (it != m_materials.end())
+                {
+                    dependencies.insert(it->second);
+                }
+                else if (!m_materialManifest.m_materials.empty())
+                {
+                    Log::Warning("%s: material '%s' is not in the material manifest", source.string().c_str(), material.m_name.c_str());
+                }
+            }
+            for (u32 dependency: dependencies)
+            {
+                m_graph.AddDependency(meshTask, dependency);
+            }
+        }
+    }
+
+    u32 CookSession::State::AddTask(std::string _name, f64 _cost, TaskGraph::TaskFunction _function)
+    {
+        m_assets.emplace_back().m_cost = _cost;
+        return m_graph.AddTask(std::move(_name), _cost, std::move(_function));
+    }
+
+    void CookSession::State::AddOutputs(u32 _task, std::vector<std::filesystem::path> _outputs, bool _cacheHit, bool _remote)
+    {
+        if (m_pack)
+        {
+            for (const std::filesystem::path& output: _outputs)
+            {
+                m_pack->Add({ GetPackName(output, m_root), output });
+            }
+        }
+        CookAssetRecord& record = m_assets[_task];
+        record.m_outputs = std::move(_outputs);
+        record.m_cacheHit = _cacheHit;
+        record.m_remote = _remote;
+    }
+
+    void CookSession::State::AddSource(const std::filesystem::path& _source, u32 _task)
+    {
+        m_sourceTasks[GetSourceKey(_source)].push_back(_task);
+    }
+
+    u32 CookSession::State::FindTexture(const CookTextureDescription& _description)
+    {
+        // Materials and the manifest list may name a texture several times, it is cooked once.
+        const auto [it, inserted] = m_textureIndices.try_emplace(GetSourceKey(_description.m_source), u32(m_textures.size()));
+        if (inserted)
+        {
+            m_textures.push_back({ 0, _description, {} });
+        }
+        return it->second;
+    }
+
+    void CookSession::State::RemoveScratch() const
+    {
+        std::error_code error;
+        std::filesystem::remove_all(m_scratchRoot, error);
+    }
+
+    CookSession::CookSession(JobSystem& _jobSystem, const CookManifest& _manifest, const CookSettings& _settings)
+        : m_state(std::make_unique<State>(_jobSystem, _manifest, _settings))
+    {}
+
+    CookSession::~CookSession() = default;
+
+    CookResult CookSession::Cook()
+    {
+        KT_TRACE_ZONE("CookAssets");
+        State& state = *m_state;
+        if (!state.m_settings.m_packPath.empty())
+        {
+            state.m_pack.emplace(state.m_settings.m_packPath, state.m_settings.m_pack);
+        }
+
+        // Tasks waiting on a remote job leave their worker free, more of them keep the remote slots busy.
+        const u32 remoteSlots = state.m_settings.m_coordinator != nullptr ? state.m_settings.m_coordinator->GetSlotCount() : 0;
+        CookResult result;
+        result.m_schedule = state.m_graph.Run(state.m_jobSystem, state.m_jobSystem.GetWorkerCount() + remoteSlots, state.m_settings.m_memoryBudget);
+        for (u32 i = 0; i < state.m_graph.GetTaskCount(); i++)
+        {
+            state.m_assets[i].m_task = state.m_graph.GetRecord(i);
+        }
+        result.m_assets = state.m_assets;
+        if (state.m_pack && result.m_schedule.m_failedCount == 0 && result.m_schedule.m_skippedCount == 0)
+        {
+            result.m_pack = state.m_pack->Finish();
+        }
+        state.m_pack.reset();
+        state.RemoveScratch();
+        return result;
+    }
+
+    CookResult CookSession::Recook(std::span<const std::filesystem::path> _changedFiles)
+    {
+        KT_TRACE_ZONE("RecookAssets");
+        State& state = *m_state;
+        std::vector<u32> changed;
+        for (const std::filesystem::path& file: _changedFiles)
+        {
+            const std::filesystem::path key = GetSourceKey(file);
+            const auto it = state.m_sourceTasks.find(key);
+            if (it != state.m_sourceTasks.end())
+            {
+                changed.insert(changed.end(), it->second.begin(), it->second.end());
+            }
+            if (state.m_includeDirectories.contains(key.parent_path()))
+            {
+                changed.insert(changed.end(), state.m_shaderTasks.begin(), state.m_shaderTasks.end());
+            }
+        }
+
+        CookResult result;
+        if (changed.empty())
+        {
+            return result;
+        }
+        const u32 remoteSlots = state.m_settings.m_coordinator != nullptr ? state.m_settings.m_coordinator->GetSlotCount() : 0;
+        result.m_schedule = state.m_graph.Run(state.m_jobSystem, changed, state.m_jobSystem.GetWorkerCount() + remoteSlots, state.m_settings.m_memoryBudget);
+        for (u32 task: state.m_graph.CollectDependents(changed))
+        {
+            state.m_assets[task].m_task = state.m_graph.GetRecord(task);
+            result.m_assets.push_back(state.m_assets[task]);
+        }
+        state.RemoveScratch();
+        return result;
+    }
+
+    bool CookSession::RequiresRebuild(std::span<const std::filesystem::path> _changedFiles) const
+    {
+        for (const std::filesystem::path& file: _changedFiles)
+        {
+            if (m_state->m_manifests.contains(GetSourceKey(file)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::filesystem::path> CookSession::GetSourceDirectories() const
+    {
+        std::set<std::filesystem::path> directories(m_state->m_includeDirectories.begin(), m_state->m_includeDirectories.end());
+        for (const auto& [source, tasks]: m_state->m_sourceTasks)
+        {
+            directories.insert(source.parent_path());
+        }
+        for (const std::filesystem::path& manifest: m_state->m_manifests)
+        {
+            directories.insert(manifest.parent_path());
+        }
+
+        std::vector<std::filesystem::path> existing;
+        for (const std::filesystem::path& directory: directories)
+        {
+            std::error_code error;
+            if (std::filesystem::is_directory(directory, error))
+            {
+                existing.push_back(directory);
+            }
+        }
+        return existing;
+    }
+
+    const std::filesystem::path& CookSession::GetOutputDirectory() const
+    {
+        return m_state->m_root;
+    }
+
+    CookResult CookAssets(JobSystem& _jobSystem, const CookManifest& _manifest, const CookSettings& _settings)
+    {
+        CookSession session(_jobSystem, _manifest, _settings);
+        return session.Cook();
+    }
+}
@@ -0,0 +1,60 @@
+#include "KryneTools/Cook/CookManifest.hpp"
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Json/Json.hpp"
+
+namespace KryneTools
+{
+    CookManifest LoadCookManifest(const std::filesystem::path& _path)
+    {
+        const std::vector<u8> data = FileSystem::ReadFile(_path);
+        const JsonValue document = JsonValue::Parse(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+        const std::filesystem::path directory = _path.parent_path();
+        const std::string manifestName = _path.string();
+
+        CookManifest manifest;
+        if (document["shaders"].IsString())
+        {
+            manifest.m_shaderManifest = directory / document["shaders"].AsString();
+        }
+        if (document["materials"].IsString())
+        {
+            manifest.m_materialManifest = directory / document["materials"].AsString();
+        }
+
+        for (const JsonValue& entry: document["textures"].AsArray())
+        {
+            KT_VERIFY(entry["source"].IsString(), "%s: every texture needs a source", manifestName.c_str());
+            CookTextureDescription texture;
+            texture.m_source = directory / entry["source"].AsString();
+            const std::string context = manifestName + ": " + texture.m_source.filename().string();
+
+            const std::string_view formatName = entry["format"].AsString("bc7");
+            const std::optional<TextureFormat> format = ParseTextureFormat(formatName);
+            KT_VERIFY(format.has_value(), "%s: unknown texture format '%.*s'", context.c_str(), int(formatName.size()), formatName.data());
+            texture.m_format = *format;
+
+            const std::string_view quality = entry["quality"].AsString("fast");
+            KT_VERIFY(quality == "fast" || quality == "high", "%s: unknown quality '%.*s', expected fast or high", context.c_str(), int(quality.size()), quality.data());
+            texture.m_quality = quality == "high" ? EncodeQuality::High : EncodeQuality::Fast;
+
+            texture.m_normalMap = entry["normal_map"].AsBool(false);
+            texture.m_srgb = !texture.m_normalMap && entry["srgb"].AsBool(true);
+            texture.m_generateMips = entry["mips"].AsBool(true);
+            manifest.m_textures.push_back(std::move(texture));
+        }
+
+        for (const JsonValue& entry: document["meshes"].AsArray())
+        {
+            KT_VERIFY(entry.IsString(), "%s: meshes must be paths", manifestName.c_str());
+            manifest.m_meshes.push_back(directory / entry.AsString());
+        }
+
+        KT_VERIFY(
+            !manifest.m_shaderManifest.empty() || !manifest.m_materialManifest.empty() || !manifest.m_textures.empty() || !manifest.m_meshes.empty(),
+            "%s: nothing to cook",
+            manifestName.c_str());
+        return manifest;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "KryneTools/Distributed/RemoteProtocol.hpp"
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+    class TcpListener;
+    struct CacheKey;
+    struct TextureCookSettings;
+
+    struct CookCoordinatorStatistics
+    {
+        u64 m_remoteJobCount = 0;
+        /// Jobs run locally as no worker had a free slot, or as their worker disconnected or could not run them.
+        u64 m_localFallbackCount = 0;
+        /// Input bytes sent to workers, and those skipped as the worker already stored them.
+        u64 m_sentInputBytes = 0;
+        u64 m_residentInputBytes = 0;
+    };
+
+    /**
+     * @brief Accepts remote cook workers and runs leaf jobs, texture cooks and shader compiles, on them.
+     *
+     * @details
+     * Workers connect to the coordinator (see `CookWorker`), so build agents can join and leave a running cook. A
+     * worker announces its job slots and the input blobs it already stores; a job goes to the worker with a free slot
+     * holding the most bytes of its inputs, the least loaded one on ties, and only the missing inputs are sent. With no
+     * free slot, or if the worker disconnects or can not match the local output (build ID, compiler version), the job
+     * returns to its caller to run locally, so remote workers only ever add throughput.
+     *
+     * Callers block in `JobSystem::Wait()` while their job is remote, executing local jobs meanwhile. Entry points are
+     * thread-safe.
+     */
+    class CookCoordinator
+    {
+    public:
+        /// Listens on every interface, or `_address` when not empty. Throws an `Error` if the port is taken.
+        CookCoordinator(JobSystem& _jobSystem, const std::string& _address, u16 _port);
+        ~CookCoordinator();
+
+        CookCoordinator(const CookCoordinator&) = delete;
+        CookCoordinator& operator=(const CookCoordinator&) = delete;
+
+        [[nodiscard]] u16 GetPort() const;
+
+        /// Returns false if fewer than `_count` workers connected within the timeout.
+        bool WaitForWorkers(u32 _count, f64 _timeoutSeconds);
+
+        /// Job slots over the connected workers.
+        [[nodiscard]] u32 GetSlotCount() const;
+
+        /// A `TextureCookFunction`: cooks remotely and writes `_output`, or returns false to cook locally.
+        bool CookTexture(const TextureCookSettings& _settings, const std::filesystem::path& _output);
+
+        /// A `ShaderCompileFunction`, for a local compiler using `_compiler`.
+        std::optional<std::vector<u8>> CompileShader(const ShaderCompileRequest& _request, std::string_view _identity, const CacheKey& _key, const ShaderCompilerSettings& _compiler);
+
+        [[nodiscard]] CookCoordinatorStatistics GetStatistics() const;
+
+    private:
+        struct Worker;
+        struct PendingJob;
+
+        struct JobInput
+        {
+            u64 m_hash = 0;
+            std::string m_name;
+            std::vector<u8> m_data;
+        };
+
+        JobSystem& m_jobSystem;
+        std::unique_ptr<TcpListener> m_listener;
+        std::thread m_acceptThread;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workersChanged;
+        std::vector<std::shared_ptr<Worker>> m_workers;
+        u64 m_nextJobId = 0;
+        std::atomic<bool> m_stopping = false;
+
+        std::atomic<u64> m_remoteJobCount = 0;
+        std::atomic<u64> m_localFallbackCount = 0;
+        std::atomic<u64> m_sentInputBytes = 0;
+        std::atomic<u64> m_residentInputBytes = 0;
+
+        void AcceptMain();
+        void ReceiveMain(const std::shared_ptr<Worker>& _worker);
+        void Disconnect(Worker& _worker, const char* _reason);
+
+        /**
+         * @brief Runs a job remotely. Returns nothing to run it locally.
+         * @param _parameters Precede the inputs in the message.
+         * @param _requirement What the worker must match, such as the compiler identity. Workers that could not are
+         * not offered jobs of the same requirement again.
+         */
+        std::optional<std::vector<u8>> Run(RemoteProtocol::JobKind _kind, const RemoteProtocol::MessageWriter& _parameters, std::span<const JobInput> _inputs, std::string_view _requirement);
+        [[nodiscard]] std::shared_ptr<Worker> AcquireWorker(std::span<const JobInput> _inputs, std::string_view _requirement);
+    };
+}
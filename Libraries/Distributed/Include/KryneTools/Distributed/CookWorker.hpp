@@ -0,0 +1,75 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Distributed/RemoteProtocol.hpp"
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class JobSystem;
+
+    struct CookWorkerSettings
+    {
+        /// Reported to the coordinator, for its logs.
+        std::string m_name;
+        /// Job inputs received from coordinators, kept across sessions so placement can favour this worker.
+        std::filesystem::path m_storeDirectory;
+        /// The least recently used inputs are evicted past this size.
+        u64 m_storeLimit = u64(8) << 30;
+        /// Compiler executables. Every other compiler setting comes from the coordinator with each job.
+        std::string m_glslangPath = "glslangValidator";
+        std::string m_dxcPath = "dxc";
+        /// Optional local artifact cache, looked up before running a job.
+        ContentCache* m_cache = nullptr;
+    };
+
+    /**
+     * @brief Remote side of a `CookCoordinator`: runs the jobs it receives on the local job system.
+     *
+     * @details
+     * The worker announces one job slot per worker thread, so a coordinator keeps it busy without queuing work it could
+     * give to another. Inputs are stored by content hash and announced on every connection; a coordinator only sends
+     * those the worker does not already have. Jobs fail with `JobStatus::Mismatch` rather than produce an output that
+     * differs from a local one, as happens with another shader compiler version.
+     */
+    class CookWorker
+    {
+    public:
+        CookWorker(JobSystem& _jobSystem, CookWorkerSettings _settings);
+        ~CookWorker();
+
+        CookWorker(const CookWorker&) = delete;
+        CookWorker& operator=(const CookWorker&) = delete;
+
+        /**
+         * @brief Connects to a coordinator and runs its jobs until it closes the connection.
+         * @return false if the coordinator rejected the worker, e.g. for another tools build. Throws an `Error` if the
+         * connection fails or drops.
+         */
+        bool Serve(const std::string& _host, u16 _port);
+
+    private:
+        class BlobStore;
+
+        JobSystem& m_jobSystem;
+        CookWorkerSettings m_settings;
+        std::unique_ptr<BlobStore> m_store;
+        std::filesystem::path m_scratchDirectory;
+
+        std::mutex m_compilerMutex;
+        /// Keyed by the coordinator compiler settings.
+        std::map<std::string, std::unique_ptr<ShaderCompiler>> m_compilers;
+
+        [[nodiscard]] ShaderCompiler& GetCompiler(const ShaderCompilerSettings& _settings);
+        /// Runs a `Job` message, returning its `Result` message. Never throws: failures are reported to the coordinator.
+        [[nodiscard]] RemoteProtocol::MessageWriter RunJob(std::span<const u8> _job);
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class TcpListener;
+    class TcpSocket;
+
+    struct LiveAsset
+    {
+        /// Name relative to the output directory, as in the archives.
+        std::string m_name;
+        std::filesystem::path m_path;
+    };
+
+    /**
+     * @brief Pushes recooked assets to the running engines connected to it.
+     *
+     * @details
+     * Engines connect to the link and stay connected; `Publish()` sends each of them a `RemoteProtocol` `Reload`
+     * message with the content of the assets, so an engine running on another device needs no access to the output
+     * directory. Engines failing a send are dropped, they reconnect at will. Entry points are thread-safe.
+     */
+    class LiveLinkServer
+    {
+    public:
+        /// Listens on `_address`, the loopback interface for local engines. Throws an `Error` if the port is taken.
+        LiveLinkServer(const std::string& _address, u16 _port);
+        ~LiveLinkServer();
+
+        LiveLinkServer(const LiveLinkServer&) = delete;
+        LiveLinkServer& operator=(const LiveLinkServer&) = delete;
+
+        [[nodiscard]] u16 GetPort() const;
+        [[nodiscard]] u32 GetClientCount() const;
+
+        /// Sends the assets to every connected engine. Throws an `Error` if an asset can not be read.
+        void Publish(std::span<const LiveAsset> _assets);
+
+    private:
+        std::unique_ptr<TcpListener> m_listener;
+        std::thread m_acceptThread;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<TcpSocket>> m_clients;
+
+        void AcceptMain();
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class TcpSocket;
+}
+
+/**
+ * @file
+ * Messages exchanged by a cook coordinator and its remote workers over TCP.
+ *
+ * Every message is a `FrameHeader` followed by its payload, a sequence of little-endian values written by
+ * `MessageWriter`. A worker opens the connection with a `Hello` (its build ID, job slots and the hashes of the input
+ * blobs it already stores), answered by a `Welcome`; the coordinator then sends `Job` messages, each answered by one
+ * `Result`, in any order.
+ *
+ * Job inputs are content-addressed: an input the coordinator believes the worker holds is sent as its hash and size
+ * alone, and the worker answers `JobStatus::MissingInputs` if it evicted it meanwhile.
+ *
+ * The live link of `kryne-cook --watch` uses the same framing: engines connect to it and receive a `Reload` message
+ * after each recook, the count of assets then the name and content of each, named relative to the output directory.
+ */
+namespace KryneTools::RemoteProtocol
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'R', 'M', 'T');
+    constexpr u32 kVersion = 1;
+    constexpr u16 kDefaultPort = 7420;
+    constexpr u16 kDefaultLivePort = 7421;
+    /// Bounds the allocation done for a frame read from a misbehaving peer.
+    constexpr u64 kMaxMessageSize = u64(4) << 30;
+
+    enum class MessageType: u32
+    {
+        Hello,
+        Welcome,
+        Job,
+        Result,
+        /// Live link, recooked assets pushed to an engine.
+        Reload,
+    };
+
+    enum class JobKind: u8
+    {
+        /// A `CookTexture()` of the single input image.
+        Texture,
+        /// A SPIR-V compile of the single preprocessed source input.
+        Shader,
+    };
+
+    enum class JobStatus: u8
+    {
+        Ok,
+        /// The job itself failed, the message holds the error.
+        Failed,
+        /// An input sent by hash only is not in the worker store, the coordinator resends the job with every input.
+        MissingInputs,
+        /// The worker can not produce an output identical to a local one, e.g. another compiler version.
+        Mismatch,
+    };
+
+    struct FrameHeader
+    {
+        u32 m_magic;
+        MessageType m_type;
+        u64 m_size;
+    };
+    static_assert(sizeof(FrameHeader) == 16);
+
+    class MessageWriter
+    {
+    public:
+        void WriteU8(u8 _value) { m_data.push_back(_value); }
+        void WriteU32(u32 _value) { WriteRaw(&_value, sizeof(_value)); }
+        void WriteU64(u64 _value) { WriteRaw(&_value, sizeof(_value)); }
+        /// Length-prefixed.
+        void WriteString(std::string_view _value);
+        /// Length-prefixed.
+        void WriteBytes(std::span<const u8> _value);
+        void Append(const MessageWriter& _other) { WriteRaw(_other.m_data.data(), _other.m_data.size()); }
+
+        [[nodiscard]] std::span<const u8> GetData() const { return m_data; }
+
+    private:
+        std::vector<u8> m_data;
+
+        void WriteRaw(const void* _data, u64 _size);
+    };
+
+    /// Reads the values of a `MessageWriter` back, throwing an `Error` past the end of the message.
+    class MessageReader
+    {
+    public:
+        explicit MessageReader(std::span<const u8> _data) : m_data(_data) {}
+
+        u8 ReadU8();
+        u32 ReadU32();
+        u64 ReadU64();
+        std::string ReadString();
+        /// Points into the message buffer.
+        std::span<const u8> ReadBytes();
+
+    private:
+        std::span<const u8> m_data;
+        u64 m_offset = 0;
+
+        const u8* Consume(u64 _size);
+    };
+
+    void SendMessage(TcpSocket& _socket, MessageType _type, const MessageWriter& _message);
+
+    /// Returns false if the peer closed the connection between two messages.
+    bool ReceiveMessage(TcpSocket& _socket, MessageType& _type, std::vector<u8>& _payload);
+}
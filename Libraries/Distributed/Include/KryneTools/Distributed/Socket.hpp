@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /// Blocking TCP stream. Operations throw an `Error` on failure, including a peer closing mid-transfer.
+    class TcpSocket
+    {
+    public:
+        TcpSocket() = default;
+        ~TcpSocket();
+
+        TcpSocket(TcpSocket&& _other) noexcept;
+        TcpSocket& operator=(TcpSocket&& _other) noexcept;
+
+        [[nodiscard]] static TcpSocket Connect(const std::string& _host, u16 _port);
+
+        [[nodiscard]] bool IsOpen() const { return m_handle != kInvalidHandle; }
+
+        void Send(const void* _data, u64 _size);
+
+        /// Reads exactly `_size` bytes. Returns false if the peer closed the connection before the first byte.
+        bool Receive(void* _data, u64 _size);
+
+        /// Ends both directions, unblocking a thread waiting in `Receive()`. The handle stays open until destruction.
+        void Shutdown();
+
+    private:
+        friend class TcpListener;
+
+        /// A POSIX descriptor or a Winsock `SOCKET`.
+        using Handle = u64;
+        static constexpr Handle kInvalidHandle = ~Handle(0);
+
+        explicit TcpSocket(Handle _handle) : m_handle(_handle) {}
+        void Close();
+
+        Handle m_handle = kInvalidHandle;
+    };
+
+    class TcpListener
+    {
+    public:
+        TcpListener() = default;
+        ~TcpListener();
+
+        TcpListener(const TcpListener&) = delete;
+        TcpListener& operator=(const TcpListener&) = delete;
+
+        /// Listens on every interface, or `_address` when not empty. Port 0 picks a free one, see `GetPort()`.
+        [[nodiscard]] static std::unique_ptr<TcpListener> Listen(const std::string& _address, u16 _port);
+
+        [[nodiscard]] u16 GetPort() const { return m_port; }
+
+        /// Blocks until a peer connects. Returns a closed socket once `Shutdown()` was called.
+        [[nodiscard]] TcpSocket Accept();
+
+        /// Unblocks `Accept()`, for good.
+        void Shutdown();
+
+    private:
+        TcpSocket::Handle m_handle = TcpSocket::kInvalidHandle;
+        u16 m_port = 0;
+        std::atomic<bool> m_shutdown { false };
+    };
+
+    /// Splits `host:port`, the port defaulting to `_defaultPort` when omitted.
+    void ParseSocketAddress(const std::string& _address, u16 _defaultPort, std::string& _host, u16& _port);
+}
@@ -0,0 +1,398 @@
+#include "KryneTools/Distributed/CookCoordinator.hpp"
+
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/BuildId.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Distributed/Socket.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Texture/TextureCooker.hpp"
+
+namespace KryneTools
+{
+    using namespace RemoteProtocol;
+
+    struct CookCoordinator::PendingJob
+    {
+        JobGroup m_group;
+        /// Empty if the worker disconnected first.
+        std::optional<JobStatus> m_status;
+        std::string m_message;
+        std::vector<u8> m_output;
+    };
+
+    struct CookCoordinator::Worker
+    {
+        std::string m_name;
+        TcpSocket m_socket;
+        std::thread m_receiveThread;
+        /// Serializes whole messages on the socket.
+        std::mutex m_sendMutex;
+
+        // Protected by the coordinator mutex.
+        u32 m_slotCount = 0;
+        u32 m_inFlight = 0;
+        bool m_connected = true;
+        /// Inputs sent to, or announced by, the worker. Evictions are only learnt through `JobStatus::MissingInputs`.
+        std::unordered_set<u64> m_resident;
+        std::unordered_set<std::string> m_mismatches;
+        std::unordered_map<u64, PendingJob*> m_pending;
+    };
+
+    CookCoordinator::CookCoordinator(JobSystem& _jobSystem, const std::string& _address, u16 _port)
+        : m_jobSystem(_jobSystem)
+        , m_listener(TcpListener::Listen(_address, _port))
+    {
+        m_acceptThread = std::thread([this] { AcceptMain(); });
+    }
+
+    CookCoordinator::~CookCoordinator()
+    {
+        m_stopping = true;
+        m_listener->Shutdown();
+        m_acceptThread.join();
+
+        std::vector<std::shared_ptr<Worker>> workers;
+        {
+            const std::lock_guard lock(m_mutex);
+            workers = m_workers;
+        }
+        for (const std::shared_ptr<Worker>& worker: workers)
+        {
+            worker->m_socket.Shutdown();
+            worker->m_receiveThread.join();
+        }
+    }
+
+    u16 CookCoordinator::GetPort() const
+    {
+        return m_listener->GetPort();
+    }
+
+    bool CookCoordinator::WaitForWorkers(u32 _count, f64 _timeoutSeconds)
+    {
+        std::unique_lock lock(m_mutex);
+        return m_workersChanged.wait_for(lock, std::chrono::duration<f64>(_timeoutSeconds), [&]
+        {
+            u32 connected = 0;
+            for (const std::shared_ptr<Worker>& worker: m_workers)
+            {
+                connected += worker->m_connected ? 1 : 0;
+            }
+            return connected >= _count;
+        });
+    }
+
+    u32 CookCoordinator::GetSlotCount() const
+    {
+        const std::lock_guard lock(m_mutex);
+        u32 slotCount = 0;
+        for (const std::shared_ptr<Worker>& worker: m_workers)
+        {
+            slotCount += worker->m_connected ? worker->m_slotCount : 0;
+        }
+        return slotCount;
+    }
+
+    CookCoordinatorStatistics CookCoordinator::GetStatistics() const
+    {
+        return { m_remoteJobCount.load(), m_localFallbackCount.load(), m_sentInputBytes.load(), m_residentInputBytes.load() };
+    }
+
+    bool CookCoordinator::CookTexture(const TextureCookSettings& _settings, const std::filesystem::path& _output)
+    {
+        KT_TRACE_ZONE_DETAIL("RemoteCookTexture", _settings.m_input.string());
+        MessageWriter parameters;
+        parameters.WriteU8(u8(_settings.m_format));
+        parameters.WriteU8(u8(_settings.m_quality));
+        parameters.WriteU8(u8(_settings.m_container));
+        parameters.WriteU8(_settings.m_srgb ? 1 : 0);
+        parameters.WriteU8(_settings.m_normalMap ? 1 : 0);
+        parameters.WriteU8(_settings.m_generateMips ? 1 : 0);
+
+        // Named after the source, as the loader picks the decoder from the extension and the output is named after it.
+        JobInput input;
+        input.m_data = FileSystem::ReadFile(_settings.m_input);
+        input.m_hash = HashParallel(m_jobSystem, input.m_data);
+        input.m_name = _settings.m_input.filename().string();
+        std::optional<std::vector<u8>> output = Run(JobKind::Texture, parameters, std::span(&input, 1), "texture");
+        if (!output.has_value())
+        {
+            return false;
+        }
+        FileSystem::CreateParentDirectories(_output);
+        FileSystem::WriteFile(_output, *output);
+        return true;
+    }
+
+    std::optional<std::vector<u8>> CookCoordinator::CompileShader(const ShaderCompileRequest& _request, std::string_view _identity, const CacheKey& _key, const ShaderCompilerSettings& _compiler)
+    {
+        KT_TRACE_ZONE_DETAIL("RemoteCompileShader", _identity);
+        MessageWriter parameters;
+        parameters.WriteU8(u8(_request.m_language));
+        parameters.WriteU8(u8(_request.m_stage));
+        parameters.WriteString(_request.m_entryPoint);
+        parameters.WriteString(_compiler.m_targetEnvironment);
+        parameters.WriteString(_compiler.m_shaderModel);
+        parameters.WriteU8(_compiler.m_debugInfo ? 1 : 0);
+        parameters.WriteString(_identity);
+        parameters.WriteU64(_key.m_value);
+
+        JobInput input;
+        input.m_data.assign(_request.m_source.begin(), _request.m_source.end());
+        input.m_hash = HashParallel(m_jobSystem, input.m_data);
+        input.m_name = "source";
+        return Run(JobKind::Shader, parameters, std::span(&input, 1), _identity);
+    }
+
+    std::shared_ptr<CookCoordinator::Worker> CookCoordinator::AcquireWorker(std::span<const JobInput> _inputs, std::string_view _requirement)
+    {
+        // Called with the mutex held.
+        std::shared_ptr<Worker> best;
+        u64 bestResident = 0;
+        for (const std::shared_ptr<Worker>& worker: m_workers)
+        {
+            if (!worker->m_connected || worker->m_inFlight >= worker->m_slotCount || worker->m_mismatches.contains(std::string(_requirement)))
+            {
+                continue;
+            }
+            u64 resident = 0;
+            for (const JobInput& input: _inputs)
+            {
+                resident += worker->m_resident.contains(input.m_hash) ? input.m_data.size() : 0;
+            }
+            // Compares load ratios without a division.
+            const bool lessLoaded = best != nullptr && u64(worker->m_inFlight) * best->m_slotCount < u64(best->m_inFlight) * worker->m_slotCount;
+            if (best == nullptr || resident > bestResident || (resident == bestResident && lessLoaded))
+            {
+                best = worker;
+                bestResident = resident;
+            }
+        }
+        if (best != nullptr)
+        {
+            best->m_inFlight++;
+        }
+        return best;
+    }
+
+    std::optional<std::vector<u8>> CookCoordinator::Run(JobKind _kind, const MessageWriter& _parameters, std::span<const JobInput> _inputs, std::string_view _requirement)
+    {
+        // A second attempt follows an evicted input, resending every input, or a mismatch, on another worker.
+        for (u32 attempt = 0; attempt < 2; attempt++)
+        {
+            PendingJob pending;
+            MessageWriter message;
+            std::shared_ptr<Worker> worker;
+            {
+                const std::lock_guard lock(m_mutex);
+                worker = AcquireWorker(_inputs, _requirement);
+                if (worker == nullptr)
+                {
+                    break;
+                }
+
+                const u64 id = m_nextJobId++;
+                message.WriteU64(id);
+                message.WriteU8(u8(_kind));
+                message.Append(_parameters);
+                message.WriteU32(u32(_inputs.size()));
+                for (const JobInput& input: _inputs)
+                {
+                    const bool attach = attempt > 0 || !worker->m_resident.contains(input.m_hash);
+                    message.WriteU64(input.m_hash);
+                    message.WriteString(input.m_name);
+                    message.WriteU8(attach ? 1 : 0);
+                    if (attach)
+                    {
+                        message.WriteBytes(input.m_data);
+                        worker->m_resident.insert(input.m_hash);
+                    }
+                    (attach ? m_sentInputBytes : m_residentInputBytes) += input.m_data.size();
+                }
+                m_jobSystem.BeginExternal(pending.m_group);
+                worker->m_pending.emplace(id, &pending);
+            }
+
+            try
+            {
+                const std::lock_guard lock(worker->m_sendMutex);
+                SendMessage(worker->m_socket, MessageType::Job, message);
+            }
+            catch (const Error& exception)
+            {
+                Disconnect(*worker, exception.what());
+            }
+            m_jobSystem.Wait(pending.m_group);
+
+            {
+                const std::lock_guard lock(m_mutex);
+                worker->m_inFlight--;
+                if (pending.m_status == JobStatus::MissingInputs)
+                {
+                    worker->m_resident.clear();
+                }
+                else if (pending.m_status == JobStatus::Mismatch && worker->m_mismatches.emplace(_requirement).second)
+                {
+                    Log::Warning("%s can not run %s jobs: %s", worker->m_name.c_str(), _kind == JobKind::Shader ? "shader" : "texture", pending.m_message.c_str());
+                }
+            }
+            m_workersChanged.notify_all();
+
+            if (!pending.m_status.has_value())
+            {
+                break;
+            }
+            switch (*pending.m_status)
+            {
+            case JobStatus::Ok:
+                m_remoteJobCount++;
+                return std::move(pending.m_output);
+            case JobStatus::Failed:
+                ThrowError("%s (on %s)", pending.m_message.c_str(), worker->m_name.c_str());
+            case JobStatus::Mismatch:
+            case JobStatus::MissingInputs:
+                break;
+            }
+        }
+        m_localFallbackCount++;
+        return std::nullopt;
+    }
+
+    void CookCoordinator::Disconnect(Worker& _worker, const char* _reason)
+    {
+        std::unordered_map<u64, PendingJob*> pending;
+        {
+            const std::lock_guard lock(m_mutex);
+            if (!_worker.m_connected)
+            {
+                return;
+            }
+            _worker.m_connected = false;
+            pending.swap(_worker.m_pending);
+        }
+        if (!m_stopping)
+        {
+            Log::Warning("Worker %s disconnected: %s", _worker.m_name.c_str(), _reason);
+        }
+        _worker.m_socket.Shutdown();
+        for (const auto& [id, job]: pending)
+        {
+            m_jobSystem.EndExternal(job->m_group);
+        }
+        m_workersChanged.notify_all();
+    }
+
+    void CookCoordinator::AcceptMain()
+    {
+        u32 connectionIndex = 0;
+        while (true)
+        {
+            TcpSocket socket = m_listener->Accept();
+            if (!socket.IsOpen())
+            {
+                return;
+            }
+            connectionIndex++;
+
+            try
+            {
+                MessageType type;
+                std::vector<u8> payload;
+                KT_VERIFY(ReceiveMessage(socket, type, payload) && type == MessageType::Hello, "Expected a hello message");
+                MessageReader reader(payload);
+                const u32 version = reader.ReadU32();
+                const std::string buildId = reader.ReadString();
+                const u32 slotCount = reader.ReadU32();
+                std::string name = reader.ReadString();
+
+                // Outputs must be identical to local ones, or cache keys would lie.
+                std::string rejection;
+                if (version != kVersion)
+                {
+                    rejection = FormatString("protocol version %u, the coordinator uses %u", version, kVersion);
+                }
+                else if (buildId != GetBuildId())
+                {
+                    rejection = FormatString("tools build '%s', the coordinator runs '%s'", buildId.c_str(), GetBuildId());
+                }
+                MessageWriter welcome;
+                welcome.WriteU8(rejection.empty() ? 1 : 0);
+                welcome.WriteString(rejection);
+                SendMessage(socket, MessageType::Welcome, welcome);
+                if (!rejection.empty())
+                {
+                    Log::Warning("Rejected worker %s: %s", name.c_str(), rejection.c_str());
+                    continue;
+                }
+
+                auto worker = std::make_shared<Worker>();
+                worker->m_name = name.empty() ? FormatString("worker %u", connectionIndex) : std::move(name);
+                worker->m_socket = std::move(socket);
+                worker->m_slotCount = std::max(slotCount, 1u);
+                const u32 residentCount = reader.ReadU32();
+                for (u32 i = 0; i < residentCount; i++)
+                {
+                    worker->m_resident.insert(reader.ReadU64());
+                }
+                Log::Info("Worker %s connected: %u slots, %u stored inputs", worker->m_name.c_str(), worker->m_slotCount, residentCount);
+
+                const std::lock_guard lock(m_mutex);
+                worker->m_receiveThread = std::thread([this, worker] { ReceiveMain(worker); });
+                m_workers.push_back(std::move(worker));
+            }
+            catch (const Error& exception)
+            {
+                Log::Warning("Failed worker handshake: %s", exception.what());
+                continue;
+            }
+            m_workersChanged.notify_all();
+        }
+    }
+
+    void CookCoordinator::ReceiveMain(const std::shared_ptr<Worker>& _worker)
+    {
+        const char* reason = "connection closed";
+        std::string error;
+        try
+        {
+            MessageType type;
+            std::vector<u8> payload;
+            while (ReceiveMessage(_worker->m_socket, type, payload))
+            {
+                KT_VERIFY(type == MessageType::Result, "Unexpected message type %u", u32(type));
+                MessageReader reader(payload);
+                const u64 id = reader.ReadU64();
+                const JobStatus status = JobStatus(reader.ReadU8());
+                std::string message = reader.ReadString();
+                const std::span<const u8> output = reader.ReadBytes();
+
+                PendingJob* pending = nullptr;
+                {
+                    const std::lock_guard lock(m_mutex);
+                    const auto it = _worker->m_pending.find(id);
+                    KT_VERIFY(it != _worker->m_pending.end(), "Result of unknown job %llu", static_cast<unsigned long long>(id));
+                    pending = it->second;
+                    _worker->m_pending.erase(it);
+                }
+                pending->m_status = status;
+                pending->m_message = std::move(message);
+                pending->m_output.assign(output.begin(), output.end());
+                m_jobSystem.EndExternal(pending->m_group);
+            }
+        }
+        catch (const Error& exception)
+        {
+            error = exception.what();
+            reason = error.c_str();
+        }
+        Disconnect(*_worker, reason);
+    }
+}
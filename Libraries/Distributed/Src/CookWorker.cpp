@@ -0,0 +1,379 @@
+#include "KryneTools/Distributed/CookWorker.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/BuildId.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Distributed/Socket.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Texture/TextureCooker.hpp"
+
+namespace KryneTools
+{
+    using namespace RemoteProtocol;
+
+    namespace
+    {
+        struct JobFailure
+        {
+            JobStatus m_status;
+            std::string m_message;
+        };
+
+        std::string GetBlobName(u64 _hash)
+        {
+            return FormatString("%016llx", static_cast<unsigned long long>(_hash));
+        }
+    }
+
+    /// Input blobs named after their hash, evicted least recently used first. Thread-safe.
+    class CookWorker::BlobStore
+    {
+    public:
+        BlobStore(std::filesystem::path _directory, u64 _limit)
+            : m_directory(std::move(_directory))
+            , m_limit(_limit)
+        {
+            std::filesystem::create_directories(m_directory);
+            for (const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator(m_directory))
+            {
+                const std::string name = entry.path().filename().string();
+                u64 hash = 0;
+                const auto [end, error] = std::from_chars(name.data(), name.data() + name.size(), hash, 16);
+                if (entry.is_regular_file() && name.size() == 16 && error == std::errc() && end == name.data() + name.size())
+                {
+                    m_hashes.push_back(hash);
+                    m_size += entry.file_size();
+                }
+            }
+        }
+
+        [[nodiscard]] std::vector<u64> GetHashes() const
+        {
+            const std::lock_guard lock(m_mutex);
+            return m_hashes;
+        }
+
+        /// Returns nothing if the blob was evicted.
+        [[nodiscard]] std::optional<std::vector<u8>> Read(u64 _hash)
+        {
+            const std::filesystem::path path = m_directory / GetBlobName(_hash);
+            std::error_code error;
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+            if (error)
+            {
+                return std::nullopt;
+            }
+            try
+            {
+                return FileSystem::ReadFile(path);
+            }
+            catch (const Error&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        void Write(u64 _hash, std::span<const u8> _data)
+        {
+            FileSystem::WriteFile(m_directory / GetBlobName(_hash), _data);
+            const std::lock_guard lock(m_mutex);
+            m_hashes.push_back(_hash);
+            m_size += _data.size();
+            if (m_size > m_limit)
+            {
+                Trim();
+            }
+        }
+
+    private:
+        std::filesystem::path m_directory;
+        u64 m_limit = 0;
+        mutable std::mutex m_mutex;
+        std::vector<u64> m_hashes;
+        u64 m_size = 0;
+
+        void Trim()
+        {
+            struct Blob
+            {
+                std::filesystem::file_time_type m_time;
+                std::filesystem::path m_path;
+                u64 m_size;
+            };
+            std::vector<Blob> blobs;
+            std::error_code error;
+            for (const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator(m_directory, error))
+            {
+                if (entry.is_regular_file(error) && entry.path().filename().string().size() == 16)
+                {
+                    blobs.push_back({ entry.last_write_time(error), entry.path(), entry.file_size(error) });
+                }
+            }
+            std::sort(blobs.begin(), blobs.end(), [](const Blob& _a, const Blob& _b) { return _a.m_time < _b.m_time; });
+
+            // Down to three quarters of the limit, so eviction does not run on every write.
+            m_size = 0;
+            for (const Blob& blob: blobs)
+            {
+                m_size += blob.m_size;
+            }
+            m_hashes.clear();
+            for (const Blob& blob: blobs)
+            {
+                if (m_size > m_limit / 4 * 3 && std::filesystem::remove(blob.m_path, error))
+                {
+                    m_size -= blob.m_size;
+                    continue;
+                }
+                u64 hash = 0;
+                const std::string name = blob.m_path.filename().string();
+                std::from_chars(name.data(), name.data() + name.size(), hash, 16);
+                m_hashes.push_back(hash);
+            }
+        }
+    };
+
+    CookWorker::CookWorker(JobSystem& _jobSystem, CookWorkerSettings _settings)
+        : m_jobSystem(_jobSystem)
+        , m_settings(std::move(_settings))
+        , m_store(std::make_unique<BlobStore>(m_settings.m_storeDirectory / "inputs", m_settings.m_storeLimit))
+        , m_scratchDirectory(m_settings.m_storeDirectory / "scratch")
+    {
+        std::error_code error;
+        std::filesystem::remove_all(m_scratchDirectory, error);
+    }
+
+    CookWorker::~CookWorker() = default;
+
+    bool CookWorker::Serve(const std::string& _host, u16 _port)
+    {
+        TcpSocket socket = TcpSocket::Connect(_host, _port);
+
+        MessageWriter hello;
+        hello.WriteU32(kVersion);
+        hello.WriteString(GetBuildId());
+        hello.WriteU32(m_jobSystem.GetWorkerCount());
+        hello.WriteString(m_settings.m_name);
+        const std::vector<u64> hashes = m_store->GetHashes();
+        hello.WriteU32(u32(hashes.size()));
+        for (u64 hash: hashes)
+        {
+            hello.WriteU64(hash);
+        }
+        SendMessage(socket, MessageType::Hello, hello);
+
+        MessageType type;
+        std::vector<u8> payload;
+        KT_VERIFY(ReceiveMessage(socket, type, payload) && type == MessageType::Welcome, "Expected a welcome message from %s:%u", _host.c_str(), u32(_port));
+        MessageReader welcome(payload);
+        if (welcome.ReadU8() == 0)
+        {
+            Log::Error("Rejected by the coordinator %s:%u: %s", _host.c_str(), u32(_port), welcome.ReadString().c_str());
+            return false;
+        }
+        Log::Info("Connected to %s:%u, %u slots", _host.c_str(), u32(_port), m_jobSystem.GetWorkerCount());
+
+        // Jobs run concurrently and answer as they finish, the coordinator matches results by job ID.
+        std::mutex sendMutex;
+        JobGroup group;
+        u64 jobCount = 0;
+        std::exception_ptr exception;
+        try
+        {
+            while (ReceiveMessage(socket, type, payload))
+            {
+                KT_VERIFY(type == MessageType::Job, "Unexpected message type %u", u32(type));
+                jobCount++;
+                m_jobSystem.Spawn(group, [&, job = std::move(payload)]
+                {
+                    const MessageWriter result = RunJob(job);
+                    try
+                    {
+                        const std::lock_guard lock(sendMutex);
+                        SendMessage(socket, MessageType::Result, result);
+                    }
+                    catch (const Error& _exception)
+                    {
+                        // The receive loop sees the same failure.
+                        Log::Verbose("Unable to send a result: %s", _exception.what());
+                    }
+                });
+                payload = {};
+            }
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+            socket.Shutdown();
+        }
+        m_jobSystem.Wait(group);
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+        Log::Info("Coordinator closed the connection after %llu jobs", static_cast<unsigned long long>(jobCount));
+        return true;
+    }
+
+    ShaderCompiler& CookWorker::GetCompiler(const ShaderCompilerSettings& _settings)
+    {
+        const std::string key = FormatString("%s|%s|%d", _settings.m_targetEnvironment.c_str(), _settings.m_shaderModel.c_str(), _settings.m_debugInfo ? 1 : 0);
+        const std::lock_guard lock(m_compilerMutex);
+        std::unique_ptr<ShaderCompiler>& compiler = m_compilers[key];
+        if (compiler == nullptr)
+        {
+            ShaderCompilerSettings settings = _settings;
+            settings.m_glslangPath = m_settings.m_glslangPath;
+            settings.m_dxcPath = m_settings.m_dxcPath;
+            settings.m_scratchDirectory = m_scratchDirectory / "compiler";
+            compiler = std::make_unique<ShaderCompiler>(std::move(settings));
+        }
+        return *compiler;
+    }
+
+    MessageWriter CookWorker::RunJob(std::span<const u8> _job)
+    {
+        KT_TRACE_ZONE("RunRemoteJob");
+        MessageReader reader(_job);
+        u64 id = ~u64(0);
+        JobStatus status = JobStatus::Ok;
+        std::string message;
+        std::vector<u8> output;
+        std::filesystem::path directory;
+        try
+        {
+            id = reader.ReadU64();
+            const JobKind kind = JobKind(reader.ReadU8());
+            directory = m_scratchDirectory / GetBlobName(id);
+
+            // Only one kind of parameters precedes the inputs.
+            TextureCookSettings texture;
+            ShaderCompileRequest shader;
+            ShaderCompilerSettings compilerSettings;
+            std::string identity;
+            CacheKey key;
+            if (kind == JobKind::Texture)
+            {
+                texture.m_format = TextureFormat(reader.ReadU8());
+                texture.m_quality = EncodeQuality(reader.ReadU8());
+                texture.m_container = TextureContainer(reader.ReadU8());
+                texture.m_srgb = reader.ReadU8() != 0;
+                texture.m_normalMap = reader.ReadU8() != 0;
+                texture.m_generateMips = reader.ReadU8() != 0;
+            }
+            else if (kind == JobKind::Shader)
+            {
+                shader.m_language = ShaderLanguage(reader.ReadU8());
+                shader.m_stage = ShaderStage(reader.ReadU8());
+                shader.m_entryPoint = reader.ReadString();
+                compilerSettings.m_targetEnvironment = reader.ReadString();
+                compilerSettings.m_shaderModel = reader.ReadString();
+                compilerSettings.m_debugInfo = reader.ReadU8() != 0;
+                identity = reader.ReadString();
+                key.m_value = reader.ReadU64();
+            }
+            else
+            {
+                throw JobFailure { JobStatus::Mismatch, FormatString("unknown job kind %u", u32(kind)) };
+            }
+
+            const u32 inputCount = reader.ReadU32();
+            KT_VERIFY(inputCount == 1, "Expected a single job input, got %u", inputCount);
+            const u64 hash = reader.ReadU64();
+            const std::string name = reader.ReadString();
+            std::vector<u8> input;
+            if (reader.ReadU8() != 0)
+            {
+                const std::span<const u8> data = reader.ReadBytes();
+                KT_VERIFY(HashParallel(m_jobSystem, data) == hash, "Corrupted job input %s", name.c_str());
+                m_store->Write(hash, data);
+                input.assign(data.begin(), data.end());
+            }
+            else if (std::optional<std::vector<u8>> stored = m_store->Read(hash))
+            {
+                input = std::move(*stored);
+            }
+            else
+            {
+                throw JobFailure { JobStatus::MissingInputs, name };
+            }
+
+            if (kind == JobKind::Texture)
+            {
+                // The name only keeps its file name, a coordinator can not write outside of the scratch directory.
+                texture.m_input = directory / "input" / std::filesystem::path(name).filename();
+                texture.m_outputDirectory = directory;
+                texture.m_cache = m_settings.m_cache;
+                FileSystem::CreateParentDirectories(texture.m_input);
+                FileSystem::WriteFile(texture.m_input, input);
+                const TextureCookResult result = CookTexture(m_jobSystem, texture);
+                output = FileSystem::ReadFile(result.m_output);
+                Log::Verbose("Cooked %s%s", name.c_str(), result.m_cacheHit ? " (cache)" : "");
+            }
+            else
+            {
+                ShaderCompiler& compiler = GetCompiler(compilerSettings);
+                std::string localIdentity;
+                try
+                {
+                    localIdentity = compiler.GetIdentity(shader.m_language);
+                }
+                catch (const Error& exception)
+                {
+                    // A worker lacking the compiler is not a failure of the shader.
+                    throw JobFailure { JobStatus::Mismatch, exception.what() };
+                }
+                if (localIdentity != identity)
+                {
+                    throw JobFailure { JobStatus::Mismatch, FormatString("compiler identity '%s', expected '%s'", localIdentity.c_str(), identity.c_str()) };
+                }
+
+                // Same artifact layout as `CookShaders()`, so the cache can be shared with local cooks.
+                const std::filesystem::path moduleDirectory = directory / key.ToString();
+                const std::filesystem::path module = moduleDirectory / "module.spv";
+                const bool useCache = m_settings.m_cache != nullptr && m_settings.m_cache->IsEnabled();
+                if (!useCache || !m_settings.m_cache->Restore(key, moduleDirectory))
+                {
+                    shader.m_source = std::string_view(reinterpret_cast<const char*>(input.data()), input.size());
+                    compiler.Compile(shader, module);
+                    if (useCache)
+                    {
+                        m_settings.m_cache->Store(key, moduleDirectory, std::span(&module, 1));
+                    }
+                }
+                output = FileSystem::ReadFile(module);
+                Log::Verbose("Compiled %s", key.ToString().c_str());
+            }
+        }
+        catch (const JobFailure& failure)
+        {
+            status = failure.m_status;
+            message = failure.m_message;
+        }
+        catch (const std::exception& exception)
+        {
+            status = JobStatus::Failed;
+            message = exception.what();
+        }
+        if (!directory.empty())
+        {
+            std::error_code error;
+            std::filesystem::remove_all(directory, error);
+        }
+
+        MessageWriter result;
+        result.WriteU64(id);
+        result.WriteU8(u8(status));
+        result.WriteString(message);
+        result.WriteBytes(output);
+        return result;
+    }
+}
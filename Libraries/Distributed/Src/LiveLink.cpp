@@ -0,0 +1,81 @@
+#include "KryneTools/Distributed/LiveLink.hpp"
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Distributed/RemoteProtocol.hpp"
+#include "KryneTools/Distributed/Socket.hpp"
+
+namespace KryneTools
+{
+    LiveLinkServer::LiveLinkServer(const std::string& _address, u16 _port)
+        : m_listener(TcpListener::Listen(_address, _port))
+    {
+        m_acceptThread = std::thread([this] { AcceptMain(); });
+    }
+
+    LiveLinkServer::~LiveLinkServer()
+    {
+        m_listener->Shutdown();
+        m_acceptThread.join();
+    }
+
+    u16 LiveLinkServer::GetPort() const
+    {
+        return m_listener->GetPort();
+    }
+
+    u32 LiveLinkServer::GetClientCount() const
+    {
+        const std::lock_guard lock(m_mutex);
+        return u32(m_clients.size());
+    }
+
+    void LiveLinkServer::Publish(std::span<const LiveAsset> _assets)
+    {
+        KT_TRACE_ZONE("LiveLinkPublish");
+        if (_assets.empty() || GetClientCount() == 0)
+        {
+            return;
+        }
+
+        RemoteProtocol::MessageWriter message;
+        message.WriteU32(u32(_assets.size()));
+        for (const LiveAsset& asset: _assets)
+        {
+            message.WriteString(asset.m_name);
+            message.WriteBytes(FileSystem::ReadFile(asset.m_path));
+        }
+
+        const std::lock_guard lock(m_mutex);
+        for (auto it = m_clients.begin(); it != m_clients.end();)
+        {
+            try
+            {
+                RemoteProtocol::SendMessage(**it, RemoteProtocol::MessageType::Reload, message);
+                ++it;
+            }
+            catch (const Error& exception)
+            {
+                Log::Verbose("Live link engine dropped: %s", exception.what());
+                it = m_clients.erase(it);
+            }
+        }
+    }
+
+    void LiveLinkServer::AcceptMain()
+    {
+        while (true)
+        {
+            TcpSocket socket = m_listener->Accept();
+            if (!socket.IsOpen())
+            {
+                return;
+            }
+            Log::Info("Engine connected to the live link");
+            const std::lock_guard lock(m_mutex);
+            m_clients.push_back(std::make_unique<TcpSocket>(std::move(socket)));
+        }
+    }
+}
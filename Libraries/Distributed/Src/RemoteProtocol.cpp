@@ -0,0 +1,89 @@
+#include "KryneTools/Distributed/RemoteProtocol.hpp"
+
+#include <cstring>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Distributed/Socket.hpp"
+
+namespace KryneTools::RemoteProtocol
+{
+    void MessageWriter::WriteString(std::string_view _value)
+    {
+        WriteU64(_value.size());
+        WriteRaw(_value.data(), _value.size());
+    }
+
+    void MessageWriter::WriteBytes(std::span<const u8> _value)
+    {
+        WriteU64(_value.size());
+        WriteRaw(_value.data(), _value.size());
+    }
+
+    void MessageWriter::WriteRaw(const void* _data, u64 _size)
+    {
+        const u8* data = static_cast<const u8*>(_data);
+        m_data.insert(m_data.end(), data, data + _size);
+    }
+
+    u8 MessageReader::ReadU8()
+    {
+        return *Consume(1);
+    }
+
+    u32 MessageReader::ReadU32()
+    {
+        u32 value;
+        std::memcpy(&value, Consume(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    u64 MessageReader::ReadU64()
+    {
+        u64 value;
+        std::memcpy(&value, Consume(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    std::string MessageReader::ReadString()
+    {
+        const u64 size = ReadU64();
+        const u8* data = Consume(size);
+        return std::string(reinterpret_cast<const char*>(data), size);
+    }
+
+    std::span<const u8> MessageReader::ReadBytes()
+    {
+        const u64 size = ReadU64();
+        return { Consume(size), size };
+    }
+
+    const u8* MessageReader::Consume(u64 _size)
+    {
+        KT_VERIFY(_size <= m_data.size() - m_offset, "Truncated remote message");
+        const u8* data = m_data.data() + m_offset;
+        m_offset += _size;
+        return data;
+    }
+
+    void SendMessage(TcpSocket& _socket, MessageType _type, const MessageWriter& _message)
+    {
+        const FrameHeader header { kMagic, _type, _message.GetData().size() };
+        _socket.Send(&header, sizeof(header));
+        _socket.Send(_message.GetData().data(), _message.GetData().size());
+    }
+
+    bool ReceiveMessage(TcpSocket& _socket, MessageType& _type, std::vector<u8>& _payload)
+    {
+        FrameHeader header;
+        if (!_socket.Receive(&header, sizeof(header)))
+        {
+            return false;
+        }
+        KT_VERIFY(header.m_magic == kMagic, "Invalid remote message, the peer is not a kryne-cook of this protocol");
+        KT_VERIFY(header.m_size <= kMaxMessageSize, "Remote message of %llu bytes, over the limit", static_cast<unsigned long long>(header.m_size));
+        _type = header.m_type;
+        _payload.resize(header.m_size);
+        KT_VERIFY(header.m_size == 0 || _socket.Receive(_payload.data(), header.m_size), "Connection lost");
+        return true;
+    }
+}
@@ -0,0 +1,298 @@
+#include "KryneTools/Distributed/Socket.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+#include "KryneTools/Common/Error.hpp"
+
+#if defined(_WIN32)
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#else
+#   include <netdb.h>
+#   include <netinet/in.h>
+#   include <netinet/tcp.h>
+#   include <sys/socket.h>
+#   include <unistd.h>
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+#if defined(_WIN32)
+        using NativeHandle = SOCKET;
+        constexpr NativeHandle kNativeInvalid = INVALID_SOCKET;
+
+        void InitializeSockets()
+        {
+            static const bool initialized = []
+            {
+                WSADATA data;
+                KT_VERIFY(WSAStartup(MAKEWORD(2, 2), &data) == 0, "Unable to initialize Winsock");
+                return true;
+            }();
+            (void)initialized;
+        }
+
+        void CloseNative(NativeHandle _handle)
+        {
+            closesocket(_handle);
+        }
+
+        int GetLastSocketError()
+        {
+            return WSAGetLastError();
+        }
+#else
+        using NativeHandle = int;
+        constexpr NativeHandle kNativeInvalid = -1;
+
+        void InitializeSockets() {}
+
+        void CloseNative(NativeHandle _handle)
+        {
+            close(_handle);
+        }
+
+        int GetLastSocketError()
+        {
+            return errno;
+        }
+#endif
+
+        // MSG_NOSIGNAL where available, a closed peer must be an error rather than a SIGPIPE.
+#if defined(MSG_NOSIGNAL)
+        constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int kSendFlags = 0;
+#endif
+
+        NativeHandle ToNative(u64 _handle)
+        {
+            return _handle == ~u64(0) ? kNativeInvalid : NativeHandle(_handle);
+        }
+
+        u64 FromNative(NativeHandle _handle)
+        {
+            return _handle == kNativeInvalid ? ~u64(0) : u64(_handle);
+        }
+
+        void ConfigureStream(NativeHandle _handle)
+        {
+            // Messages are written whole, Nagle would only delay the small ones.
+            const int enable = 1;
+            setsockopt(_handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable));
+#if defined(SO_NOSIGPIPE)
+            setsockopt(_handle, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+        }
+
+        struct AddressList
+        {
+            addrinfo* m_list = nullptr;
+            ~AddressList() { if (m_list != nullptr) { freeaddrinfo(m_list); } }
+        };
+    }
+
+    TcpSocket::~TcpSocket()
+    {
+        Close();
+    }
+
+    TcpSocket::TcpSocket(TcpSocket&& _other) noexcept
+        : m_handle(std::exchange(_other.m_handle, kInvalidHandle))
+    {}
+
+    TcpSocket& TcpSocket::operator=(TcpSocket&& _other) noexcept
+    {
+        if (this != &_other)
+        {
+            Close();
+            m_handle = std::exchange(_other.m_handle, kInvalidHandle);
+        }
+        return *this;
+    }
+
+    TcpSocket TcpSocket::Connect(const std::string& _host, u16 _port)
+    {
+        InitializeSockets();
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        AddressList addresses;
+        const std::string port = std::to_string(_port);
+        const int result = getaddrinfo(_host.c_str(), port.c_str(), &hints, &addresses.m_list);
+        KT_VERIFY(result == 0, "Unable to resolve '%s': %s", _host.c_str(), gai_strerror(result));
+
+        for (const addrinfo* address = addresses.m_list; address != nullptr; address = address->ai_next)
+        {
+            const NativeHandle handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (handle == kNativeInvalid)
+            {
+                continue;
+            }
+            if (connect(handle, address->ai_addr, int(address->ai_addrlen)) == 0)
+            {
+                ConfigureStream(handle);
+                return TcpSocket(FromNative(handle));
+            }
+            CloseNative(handle);
+        }
+        ThrowError("Unable to connect to %s:%u (error %d)", _host.c_str(), u32(_port), GetLastSocketError());
+    }
+
+    void TcpSocket::Send(const void* _data, u64 _size)
+    {
+        const char* data = static_cast<const char*>(_data);
+        while (_size > 0)
+        {
+            const int chunk = int(std::min<u64>(_size, 1u << 30));
+            const auto sent = send(ToNative(m_handle), data, chunk, kSendFlags);
+            KT_VERIFY(sent > 0, "Socket send failed (error %d)", GetLastSocketError());
+            data += sent;
+            _size -= u64(sent);
+        }
+    }
+
+    bool TcpSocket::Receive(void* _data, u64 _size)
+    {
+        char* data = static_cast<char*>(_data);
+        u64 received = 0;
+        while (received < _size)
+        {
+            const int chunk = int(std::min<u64>(_size - received, 1u << 30));
+            const auto count = recv(ToNative(m_handle), data + received, chunk, 0);
+            if (count == 0 && received == 0)
+            {
+                return false;
+            }
+            KT_VERIFY(count > 0, "Connection lost (error %d)", count == 0 ? 0 : GetLastSocketError());
+            received += u64(count);
+        }
+        return true;
+    }
+
+    void TcpSocket::Shutdown()
+    {
+        if (IsOpen())
+        {
+#if defined(_WIN32)
+            shutdown(ToNative(m_handle), SD_BOTH);
+#else
+            shutdown(ToNative(m_handle), SHUT_RDWR);
+#endif
+        }
+    }
+
+    void TcpSocket::Close()
+    {
+        if (IsOpen())
+        {
+            CloseNative(ToNative(m_handle));
+            m_handle = kInvalidHandle;
+        }
+    }
+
+    TcpListener::~TcpListener()
+    {
+        Shutdown();
+        if (m_handle != TcpSocket::kInvalidHandle)
+        {
+            CloseNative(ToNative(m_handle));
+        }
+    }
+
+    std::unique_ptr<TcpListener> TcpListener::Listen(const std::string& _address, u16 _port)
+    {
+        InitializeSockets();
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        hints.ai_flags = AI_PASSIVE;
+        AddressList addresses;
+        const std::string port = std::to_string(_port);
+        const int result = getaddrinfo(_address.empty() ? nullptr : _address.c_str(), port.c_str(), &hints, &addresses.m_list);
+        KT_VERIFY(result == 0, "Unable to resolve '%s': %s", _address.c_str(), gai_strerror(result));
+
+        for (const addrinfo* address = addresses.m_list; address != nullptr; address = address->ai_next)
+        {
+            const NativeHandle handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (handle == kNativeInvalid)
+            {
+                continue;
+            }
+            const int enable = 1;
+            setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&enable), sizeof(enable));
+            if (bind(handle, address->ai_addr, int(address->ai_addrlen)) != 0 || listen(handle, SOMAXCONN) != 0)
+            {
+                CloseNative(handle);
+                continue;
+            }
+
+            sockaddr_storage bound {};
+            socklen_t boundSize = sizeof(bound);
+            getsockname(handle, reinterpret_cast<sockaddr*>(&bound), &boundSize);
+            auto listener = std::make_unique<TcpListener>();
+            listener->m_handle = FromNative(handle);
+            listener->m_port = bound.ss_family == AF_INET6
+                ? ntohs(reinterpret_cast<const sockaddr_in6*>(&bound)->sin6_port)
+                : ntohs(reinterpret_cast<const sockaddr_in*>(&bound)->sin_port);
+            return listener;
+        }
+        ThrowError("Unable to listen on %s:%u (error %d)", _address.empty() ? "*" : _address.c_str(), u32(_port), GetLastSocketError());
+    }
+
+    TcpSocket TcpListener::Accept()
+    {
+        while (!m_shutdown.load())
+        {
+            const NativeHandle handle = accept(ToNative(m_handle), nullptr, nullptr);
+            if (handle != kNativeInvalid)
+            {
+                if (m_shutdown.load())
+                {
+                    CloseNative(handle);
+                    break;
+                }
+                ConfigureStream(handle);
+                return TcpSocket(FromNative(handle));
+            }
+        }
+        return {};
+    }
+
+    void TcpListener::Shutdown()
+    {
+        if (!m_shutdown.exchange(true) && m_handle != TcpSocket::kInvalidHandle)
+        {
+            // Wakes a blocked `accept()` on every platform, closing is only done by the destructor.
+#if defined(_WIN32)
+            shutdown(ToNative(m_handle), SD_BOTH);
+            closesocket(ToNative(m_handle));
+            m_handle = TcpSocket::kInvalidHandle;
+#else
+            shutdown(ToNative(m_handle), SHUT_RDWR);
+#endif
+        }
+    }
+
+    void ParseSocketAddress(const std::string& _address, u16 _defaultPort, std::string& _host, u16& _port)
+    {
+        const size_t colon = _address.rfind(':');
+        if (colon == std::string::npos || _address.find(']', colon) != std::string::npos)
+        {
+            _host = _address;
+            _port = _defaultPort;
+            return;
+        }
+        _host = _address.substr(0, colon);
+        const char* begin = _address.data() + colon + 1;
+        const char* end = _address.data() + _address.size();
+        const auto [last, error] = std::from_chars(begin, end, _port);
+        KT_VERIFY(error == std::errc() && last == end, "Invalid port in '%s'", _address.c_str());
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "KryneTools/Import/GltfDocument.hpp"
+
+namespace KryneTools::Gltf
+{
+    /**
+     * @brief Decodes elements `[_begin, _end)` of an accessor to floats, applying glTF normalization rules.
+     *
+     * @details
+     * Each element is written to `_output + (i - _begin) * _outputComponents`. Components missing from the accessor are
+     * set to 1, which gives opaque alpha to RGB colors. Sparse substitution is applied.
+     */
+    void DecodeFloats(const Document& _document, const Accessor& _accessor, f32* _output, u32 _outputComponents, u32 _begin, u32 _end);
+
+    /// Same as `DecodeFloats()` for integral accessors (indices, joints). Missing components are set to 0.
+    void DecodeIntegers(const Document& _document, const Accessor& _accessor, u32* _output, u32 _outputComponents, u32 _begin, u32 _end);
+    void DecodeIntegers(const Document& _document, const Accessor& _accessor, u16* _output, u32 _outputComponents, u32 _begin, u32 _end);
+}
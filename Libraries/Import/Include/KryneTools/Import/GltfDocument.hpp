@@ -0,0 +1,249 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Types.hpp"
+#include "KryneTools/Json/Json.hpp"
+
+namespace KryneTools::Gltf
+{
+    enum class ComponentType: u32
+    {
+        Byte = 5120,
+        UnsignedByte = 5121,
+        Short = 5122,
+        UnsignedShort = 5123,
+        UnsignedInt = 5125,
+        Float = 5126,
+    };
+
+    enum class AccessorType: u8
+    {
+        Scalar,
+        Vec2,
+        Vec3,
+        Vec4,
+        Mat2,
+        Mat3,
+        Mat4,
+    };
+
+    enum class PrimitiveMode: u32
+    {
+        Points = 0,
+        Lines = 1,
+        LineLoop = 2,
+        LineStrip = 3,
+        Triangles = 4,
+        TriangleStrip = 5,
+        TriangleFan = 6,
+    };
+
+    [[nodiscard]] u32 GetComponentSize(ComponentType _type);
+    [[nodiscard]] u32 GetComponentCount(AccessorType _type);
+
+    struct Buffer
+    {
+        /// Mapping of external `.bin` buffers.
+        MappedFile m_mapping;
+        /// Decoded storage of embedded (data URI) buffers.
+        std::vector<u8> m_storage;
+        /// Points into the mapping, the storage or the GLB binary chunk.
+        std::span<const u8> m_data;
+        /// Buffer is the binary chunk of the (mapped) GLB file.
+        bool m_isBinaryChunk = false;
+    };
+
+    struct BufferView
+    {
+        u32 m_buffer = 0;
+        u64 m_byteOffset = 0;
+        u64 m_byteLength = 0;
+        /// 0 when tightly packed.
+        u32 m_byteStride = 0;
+    };
+
+    struct SparseStorage
+    {
+        u32 m_count = 0;
+        u32 m_indicesBufferView = 0;
+        u64 m_indicesByteOffset = 0;
+        ComponentType m_indicesComponentType = ComponentType::UnsignedInt;
+        u32 m_valuesBufferView = 0;
+        u64 m_valuesByteOffset = 0;
+    };
+
+    struct Accessor
+    {
+        /// Absent buffer views mean the accessor is zero-initialized, usually before sparse substitution.
+        std::optional<u32> m_bufferView;
+        u64 m_byteOffset = 0;
+        ComponentType m_componentType = ComponentType::Float;
+        bool m_normalized = false;
+        u32 m_count = 0;
+        AccessorType m_type = AccessorType::Scalar;
+        std::optional<SparseStorage> m_sparse;
+        /// Per component bounds, empty when the asset omits them (they are required for positions).
+        std::vector<f32> m_min;
+        std::vector<f32> m_max;
+    };
+
+    struct Primitive
+    {
+        std::vector<std::pair<std::string, u32>> m_attributes;
+        std::optional<u32> m_indices;
+        std::optional<u32> m_material;
+        PrimitiveMode m_mode = PrimitiveMode::Triangles;
+
+        [[nodiscard]] std::optional<u32> FindAttribute(std::string_view _name) const;
+    };
+
+    struct Mesh
+    {
+        std::string m_name;
+        std::vector<Primitive> m_primitives;
+    };
+
+    struct Material
+    {
+        std::string m_name;
+    };
+
+    struct Node
+    {
+        std::string m_name;
+        std::optional<u32> m_mesh;
+        std::vector<u32> m_children;
+        /// Transform relative to the parent, column-major. `translation`, `rotation` and `scale` are composed into it.
+        std::array<f32, 16> m_matrix { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+        /// Rest pose, decomposed from the matrix when the node has one.
+        std::array<f32, 3> m_translation { 0.f, 0.f, 0.f };
+        /// Unit quaternion (x, y, z, w).
+        std::array<f32, 4> m_rotation { 0.f, 0.f, 0.f, 1.f };
+        std::array<f32, 3> m_scale { 1.f, 1.f, 1.f };
+    };
+
+    struct Skin
+    {
+        std::string m_name;
+        std::vector<u32> m_joints;
+    };
+
+    enum class AnimationPath: u8
+    {
+        Translation,
+        Rotation,
+        Scale,
+        Weights,
+    };
+
+    enum class Interpolation: u8
+    {
+        Linear,
+        Step,
+        CubicSpline,
+    };
+
+    struct AnimationSampler
+    {
+        /// Key times accessor, in seconds.
+        u32 m_input = 0;
+        /// Key values accessor. Cubic splines store an in-tangent, the value then an out-tangent per key.
+        u32 m_output = 0;
+        Interpolation m_interpolation = Interpolation::Linear;
+    };
+
+    struct AnimationChannel
+    {
+        u32 m_sampler = 0;
+        /// Channels without a target node are ignored by the tools.
+        std::optional<u32> m_node;
+        AnimationPath m_path = AnimationPath::Translation;
+    };
+
+    struct Animation
+    {
+        std::string m_name;
+        std::vector<AnimationSampler> m_samplers;
+        std::vector<AnimationChannel> m_channels;
+    };
+
+    struct Scene
+    {
+        std::string m_name;
+        std::vector<u32> m_nodes;
+    };
+
+    /**
+     * @brief Parsed glTF 2.0 asset, either `.gltf` (with external or embedded buffers) or `.glb`.
+     *
+     * @details
+     * Only the parts needed by the tools are extracted from the JSON, which stays available for the others.
+     * Loading validates every buffer view and accessor range, so accessor decoding can read buffers unchecked.
+     *
+     * The asset and its external buffers are memory mapped, and buffers are never copied: accessors are decoded
+     * straight from the mapping. Documents are therefore move-only.
+     */
+    class Document
+    {
+    public:
+        [[nodiscard]] static Document Load(const std::filesystem::path& _path);
+
+        [[nodiscard]] const JsonValue& GetJson() const { return m_json; }
+        [[nodiscard]] const std::vector<Buffer>& GetBuffers() const { return m_buffers; }
+        [[nodiscard]] const std::vector<BufferView>& GetBufferViews() const { return m_bufferViews; }
+        [[nodiscard]] const std::vector<Accessor>& GetAccessors() const { return m_accessors; }
+        [[nodiscard]] const std::vector<Mesh>& GetMeshes() const { return m_meshes; }
+        [[nodiscard]] const std::vector<Material>& GetMaterials() const { return m_materials; }
+        [[nodiscard]] const std::vector<Node>& GetNodes() const { return m_nodes; }
+        [[nodiscard]] const std::vector<Scene>& GetScenes() const { return m_scenes; }
+        [[nodiscard]] const std::vector<Skin>& GetSkins() const { return m_skins; }
+        [[nodiscard]] const std::vector<Animation>& GetAnimations() const { return m_animations; }
+        /// The `scene` of the asset, if any.
+        [[nodiscard]] std::optional<u32> GetDefaultScene() const { return m_defaultScene; }
+
+        /// Paths of the external files referenced by the asset, resolved relative to it.
+        [[nodiscard]] const std::vector<std::filesystem::path>& GetExternalBufferPaths() const { return m_externalBufferPaths; }
+
+        /// Bytes of the view referenced by `_bufferView`, starting at `_byteOffset`.
+        [[nodiscard]] const u8* GetViewData(u32 _bufferView, u64 _byteOffset) const;
+
+        /// Lets the OS reclaim the mapped pages holding elements `[_begin, _end)` of the accessor, once decoded.
+        void ReleaseAccessorRange(const Accessor& _accessor, u32 _begin, u32 _end) const;
+
+    private:
+        std::filesystem::path m_path;
+        MappedFile m_file;
+        JsonValue m_json;
+
+        std::vector<Buffer> m_buffers;
+        std::vector<BufferView> m_bufferViews;
+        std::vector<Accessor> m_accessors;
+        std::vector<Mesh> m_meshes;
+        std::vector<Material> m_materials;
+        std::vector<Node> m_nodes;
+        std::vector<Scene> m_scenes;
+        std::optional<u32> m_defaultScene;
+        std::vector<Skin> m_skins;
+        std::vector<Animation> m_animations;
+        std::vector<std::filesystem::path> m_externalBufferPaths;
+
+        void ParseGlb(std::span<const u8>& _jsonChunk, std::span<const u8>& _binaryChunk) const;
+        void LoadBuffers(std::span<const u8> _binaryChunk);
+        void ParseBufferViews();
+        void ParseAccessors();
+        void ParseMeshes();
+        void ParseMaterials();
+        void ParseNodes();
+        void ParseScenes();
+        void ParseSkins();
+        void ParseAnimations();
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Mesh/MeshletBuilder.hpp"
+#include "KryneTools/Mesh/MeshOptimizer.hpp"
+#include "KryneTools/Mesh/MeshSimplifier.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class JobSystem;
+
+    namespace Gltf
+    {
+        class Document;
+    }
+
+    /// Fewest triangles per brick of streamed meshes, smaller bricks would lock most of their vertices on borders.
+    constexpr u32 kMinBrickTriangleCount = 16 * 1024;
+
+    struct ImportSettings
+    {
+        std::filesystem::path m_input;
+        /// Defaults to the directory of the input when empty.
+        std::filesystem::path m_outputDirectory;
+        /// Simplifies every submesh into a LOD chain, stored after the source indices.
+        bool m_generateLods = true;
+        LodSettings m_lodSettings;
+        /// Runs the vertex cache, overdraw and vertex fetch optimization stage on every mesh.
+        bool m_optimize = true;
+        /// Splits the (optimized) meshes in meshlets for the mesh shader and GPU culling paths.
+        bool m_buildMeshlets = true;
+        MeshletSettings m_meshletSettings;
+        /// Packs vertex attributes, see `MeshWriteSettings::m_quantizeAttributes`.
+        bool m_quantize = true;
+        /// Meshes estimated to need more memory than this, in bytes, are streamed by bricks. 0 never streams.
+        u64 m_memoryLimit = 0;
+        /// Triangles per brick of streamed meshes, at most. Lowered so a brick fits in the memory limit, but never below
+        /// `kMinBrickTriangleCount`, which smaller values are raised to.
+        u32 m_brickTriangleCount = 1u << 20;
+        /// Optional artifact cache, looked up before importing and filled after.
+        ContentCache* m_cache = nullptr;
+        /// Optimization reports are wanted: only the optimizer computes them, so the cache is filled but not looked up.
+        bool m_collectReports = false;
+    };
+
+    struct ImportResult
+    {
+        std::vector<std::filesystem::path> m_outputs;
+        /// Optimization statistics of each output. Empty on cache hits, which `m_collectReports` prevents, or when
+        /// not optimizing.
+        std::vector<MeshOptimizationReport> m_optimizationReports;
+        u64 m_vertexCount = 0;
+        /// Source triangles, simplified levels excluded.
+        u64 m_triangleCount = 0;
+        /// The outputs were restored from the cache.
+        bool m_cacheHit = false;
+    };
+
+    /**
+     * @brief Imports every mesh of a glTF 2.0 asset to the runtime mesh format, one `.kmesh` file per glTF mesh.
+     *
+     * @details
+     * Each mesh is a job, which forks one job per primitive, which forks one job per accessor decode. Vertex and index
+     * ranges of every primitive are computed beforehand, so decode jobs write straight to their final location in the
+     * mesh streams, with no merge step.
+     *
+     * Primitives become submeshes. Point and line primitives are skipped, strips and fans are converted to lists.
+     * The meshes then go through `GenerateLods()`, `OptimizeMesh()` and `BuildMeshlets()`, unless disabled. Meshlets
+     * are only built for level 0.
+     *
+     * With a memory limit, meshes it cannot hold are streamed instead: their triangles are partitioned in octree bricks
+     * (see `BrickOctree`) through passes over accessor ranges, and each brick is imported to its own
+     * `<mesh>_b<index>.kmesh`, with its open borders locked while simplifying so neighbouring levels stay crack free.
+     * Only bricks in flight are decoded, their count is bounded by the limit.
+     *
+     * With a cache, the key covers the content of the asset and of its external buffers, the output file names and the
+     * tools build ID. On a hit the outputs are restored without decoding anything.
+     */
+    ImportResult ImportGltf(JobSystem& _jobSystem, const ImportSettings& _settings);
+
+    /// File names of the `.kmesh` output of each glTF mesh, as `ImportGltf()` writes them when not streaming.
+    [[nodiscard]] std::vector<std::string> GetMeshOutputNames(const Gltf::Document& _document, const std::filesystem::path& _input);
+}
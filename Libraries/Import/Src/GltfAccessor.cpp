@@ -0,0 +1,290 @@
+#include "KryneTools/Import/GltfAccessor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools::Gltf
+{
+    namespace
+    {
+        template <class Visitor>
+        decltype(auto) VisitComponentType(ComponentType _type, Visitor&& _visitor)
+        {
+            switch (_type)
+            {
+                case ComponentType::Byte: return _visitor.template operator()<s8>();
+                case ComponentType::UnsignedByte: return _visitor.template operator()<u8>();
+                case ComponentType::Short: return _visitor.template operator()<s16>();
+                case ComponentType::UnsignedShort: return _visitor.template operator()<u16>();
+                case ComponentType::UnsignedInt: return _visitor.template operator()<u32>();
+                case ComponentType::Float: return _visitor.template operator()<f32>();
+            }
+            ThrowError("Unknown accessor component type %u", u32(_type));
+        }
+
+        template <class Component>
+        Component LoadComponent(const u8* _data)
+        {
+            // Strided views give no alignment guarantee.
+            Component value;
+            std::memcpy(&value, _data, sizeof(Component));
+            return value;
+        }
+
+        template <class Output, class Component>
+        Output ConvertComponent(Component _value, bool _normalized)
+        {
+            if constexpr (std::is_floating_point_v<Output>)
+            {
+                if constexpr (std::is_floating_point_v<Component>)
+                {
+                    return Output(_value);
+                }
+                else if (_normalized)
+                {
+                    // glTF 2.0 specification, "Animations" and "Meshes" normalization equations.
+                    constexpr f32 kScale = f32(std::numeric_limits<Component>::max());
+                    return std::max(f32(_value) / kScale, -1.f);
+                }
+                else
+                {
+                    return Output(_value);
+                }
+            }
+            else
+            {
+                return Output(_value);
+            }
+        }
+
+        template <class Output>
+        constexpr Output kMissingComponent = std::is_floating_point_v<Output> ? Output(1) : Output(0);
+
+        template <class Component, class Output>
+        void DecodeElement(const u8* _element, u32 _components, bool _normalized, Output* _output, u32 _outputComponents)
+        {
+            const u32 copied = std::min(_components, _outputComponents);
+            for (u32 c = 0; c < copied; c++)
+            {
+                _output[c] = ConvertComponent<Output>(LoadComponent<Component>(_element + c * sizeof(Component)), _normalized);
+            }
+            for (u32 c = copied; c < _outputComponents; c++)
+            {
+                _output[c] = kMissingComponent<Output>;
+            }
+        }
+
+        template <ComponentType Type>
+        struct ComponentOf;
+        template <> struct ComponentOf<ComponentType::Byte> { using Type = s8; };
+        template <> struct ComponentOf<ComponentType::UnsignedByte> { using Type = u8; };
+        template <> struct ComponentOf<ComponentType::Short> { using Type = s16; };
+        template <> struct ComponentOf<ComponentType::UnsignedShort> { using Type = u16; };
+        template <> struct ComponentOf<ComponentType::UnsignedInt> { using Type = u32; };
+        template <> struct ComponentOf<ComponentType::Float> { using Type = f32; };
+
+        /// An accessor element as stored, and the number of components it decodes to.
+        struct ElementLayout
+        {
+            ComponentType m_componentType;
+            u32 m_components;
+            bool m_normalized;
+            u32 m_outputComponents;
+
+            bool operator==(const ElementLayout&) const = default;
+        };
+
+        /**
+         * Layouts of the vertex and index streams assets use in practice, each decoded by its own codec with every
+         * per component decision made at compile time. Other layouts take the generic path.
+         */
+        constexpr ElementLayout kElementLayouts[] = {
+            // Positions, normals, tangents, colors, weights and texture coordinates.
+            { ComponentType::Float, 3, false, 3 },
+            { ComponentType::Float, 4, false, 4 },
+            { ComponentType::Float, 2, false, 2 },
+            // RGB colors, given an opaque alpha.
+            { ComponentType::Float, 3, false, 4 },
+            // Normalized texture coordinates, colors and weights.
+            { ComponentType::UnsignedByte, 2, true, 2 },
+            { ComponentType::UnsignedShort, 2, true, 2 },
+            { ComponentType::UnsignedByte, 4, true, 4 },
+            { ComponentType::UnsignedShort, 4, true, 4 },
+            // Quantized positions and normals (KHR_mesh_quantization).
+            { ComponentType::Short, 3, true, 3 },
+            { ComponentType::Byte, 3, true, 3 },
+            // Joints.
+            { ComponentType::UnsignedByte, 4, false, 4 },
+            { ComponentType::UnsignedShort, 4, false, 4 },
+            // Indices.
+            { ComponentType::UnsignedByte, 1, false, 1 },
+            { ComponentType::UnsignedShort, 1, false, 1 },
+            { ComponentType::UnsignedInt, 1, false, 1 },
+        };
+
+        /// Decodes `_count` elements of `Layout`, `_stride` bytes apart unless `Packed`, where they are contiguous.
+        template <ElementLayout Layout, bool Packed, class Output>
+        void DecodeElements(const u8* _elements, u64 _stride, u64 _count, Output* _output)
+        {
+            using Component = typename ComponentOf<Layout.m_componentType>::Type;
+            constexpr u32 kCopied = std::min(Layout.m_components, Layout.m_outputComponents);
+            const u64 stride = Packed ? u64(Layout.m_components) * sizeof(Component) : _stride;
+            for (u64 i = 0; i < _count; i++)
+            {
+                const u8* element = _elements + stride * i;
+                Output* output = _output + i * Layout.m_outputComponents;
+                for (u32 c = 0; c < kCopied; c++)
+                {
+                    output[c] = ConvertComponent<Output>(LoadComponent<Component>(element + c * sizeof(Component)), Layout.m_normalized);
+                }
+                for (u32 c = kCopied; c < Layout.m_outputComponents; c++)
+                {
+                    output[c] = kMissingComponent<Output>;
+                }
+            }
+        }
+
+        template <class Output>
+        using ElementDecoder = void (*)(const u8* _elements, u64 _stride, u64 _count, Output* _output);
+
+        /// Codec of `_layout`, null when it is not one of `kElementLayouts`.
+        template <class Output, size_t... Indices>
+        ElementDecoder<Output> FindElementDecoder(const ElementLayout& _layout, bool _packed, std::index_sequence<Indices...>)
+        {
+            ElementDecoder<Output> decoder = nullptr;
+            ((decoder = decoder == nullptr && kElementLayouts[Indices] == _layout
+                ? _packed ? &DecodeElements<kElementLayouts[Indices], true, Output> : &DecodeElements<kElementLayouts[Indices], false, Output>
+                : decoder), ...);
+            return decoder;
+        }
+
+        template <class Output>
+        void Decode(
+            const Document& _document,
+            const Accessor& _accessor,
+            Output* _output,
+            u32 _outputComponents,
+            u32 _begin,
+            u32 _end)
+        {
+            KT_VERIFY(_end <= _accessor.m_count && _begin <= _end, "Accessor decode range out of bounds");
+            KT_VERIFY(_accessor.m_type <= AccessorType::Vec4, "Matrix accessors are not supported for vertex data");
+
+            const u32 components = GetComponentCount(_accessor.m_type);
+            const u32 elementSize = GetComponentSize(_accessor.m_componentType) * components;
+
+            VisitComponentType(_accessor.m_componentType, [&]<class Component>()
+            {
+                if (_accessor.m_bufferView.has_value())
+                {
+                    const BufferView& view = _document.GetBufferViews()[*_accessor.m_bufferView];
+                    const u64 stride = view.m_byteStride != 0 ? view.m_byteStride : elementSize;
+                    const u8* base = _document.GetViewData(*_accessor.m_bufferView, _accessor.m_byteOffset);
+
+                    // Selected once per range rather than per element, so each layout gets an unrolled loop.
+                    const ElementLayout layout { _accessor.m_componentType, components, _accessor.m_normalized, _outputComponents };
+                    const ElementDecoder<Output> decoder = FindElementDecoder<Output>(layout, stride == elementSize, std::make_index_sequence<std::size(kElementLayouts)>());
+                    if (decoder != nullptr)
+                    {
+                        decoder(base + stride * _begin, stride, _end - _begin, _output);
+                    }
+                    else
+                    {
+                        for (u32 i = _begin; i < _end; i++)
+                        {
+                            DecodeElement<Component>(
+                                base + stride * i,
+                                components,
+                                _accessor.m_normalized,
+                                _output + u64(i - _begin) * _outputComponents,
+                                _outputComponents);
+                        }
+                    }
+                }
+                else
+                {
+                    const u8 zeros[16 * sizeof(f32)] {};
+                    for (u32 i = _begin; i < _end; i++)
+                    {
+                        DecodeElement<Component>(
+                            zeros,
+                            components,
+                            _accessor.m_normalized,
+                            _output + u64(i - _begin) * _outputComponents,
+                            _outputComponents);
+                    }
+                }
+
+                if (!_accessor.m_sparse.has_value())
+                {
+                    return;
+                }
+
+                const SparseStorage& sparse = *_accessor.m_sparse;
+                const u8* indices = _document.GetViewData(sparse.m_indicesBufferView, sparse.m_indicesByteOffset);
+                const u8* values = _document.GetViewData(sparse.m_valuesBufferView, sparse.m_valuesByteOffset);
+                const u32 indexSize = GetComponentSize(sparse.m_indicesComponentType);
+
+                const auto readIndex = [&](u32 _k)
+                {
+                    return VisitComponentType(sparse.m_indicesComponentType, [&]<class IndexType>()
+                    {
+                        return u32(LoadComponent<IndexType>(indices + u64(_k) * indexSize));
+                    });
+                };
+
+                // Sparse indices are strictly increasing, bisect to the first one of the range.
+                u32 low = 0;
+                u32 high = sparse.m_count;
+                while (low < high)
+                {
+                    const u32 middle = low + (high - low) / 2;
+                    if (readIndex(middle) < _begin)
+                    {
+                        low = middle + 1;
+                    }
+                    else
+                    {
+                        high = middle;
+                    }
+                }
+
+                for (u32 k = low; k < sparse.m_count; k++)
+                {
+                    const u32 index = readIndex(k);
+                    if (index >= _end)
+                    {
+                        break;
+                    }
+                    DecodeElement<Component>(
+                        values + u64(k) * elementSize,
+                        components,
+                        _accessor.m_normalized,
+                        _output + u64(index - _begin) * _outputComponents,
+                        _outputComponents);
+                }
+            });
+        }
+    }
+
+    void DecodeFloats(const Document& _document, const Accessor& _accessor, f32* _output, u32 _outputComponents, u32 _begin, u32 _end)
+    {
+        Decode(_document, _accessor, _output, _outputComponents, _begin, _end);
+    }
+
+    void DecodeIntegers(const Document& _document, const Accessor& _accessor, u32* _output, u32 _outputComponents, u32 _begin, u32 _end)
+    {
+        Decode(_document, _accessor, _output, _outputComponents, _begin, _end);
+    }
+
+    void DecodeIntegers(const Document& _document, const Accessor& _accessor, u16* _output, u32 _outputComponents, u32 _begin, u32 _end)
+    {
+        Decode(_document, _accessor, _output, _outputComponents, _begin, _end);
+    }
+}
@@ -0,0 +1,619 @@
+#include "KryneTools/Import/GltfDocument.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools::Gltf
+{
+    namespace
+    {
+        constexpr u32 kGlbMagic = MakeFourCC('g', 'l', 'T', 'F');
+        constexpr u32 kGlbJsonChunk = MakeFourCC('J', 'S', 'O', 'N');
+        constexpr u32 kGlbBinaryChunk = MakeFourCC('B', 'I', 'N', '\0');
+
+        u32 ReadU32(std::span<const u8> _data, u64 _offset)
+        {
+            u32 value;
+            std::memcpy(&value, _data.data() + _offset, sizeof(value));
+            return value;
+        }
+
+        std::vector<u8> DecodeBase64(std::string_view _text)
+        {
+            static constexpr auto kTable = []
+            {
+                std::array<s8, 256> table {};
+                table.fill(-1);
+                constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                for (s8 i = 0; i < 64; i++)
+                {
+                    table[u8(kAlphabet[i])] = i;
+                }
+                return table;
+            }();
+
+            std::vector<u8> result;
+            result.reserve(_text.size() / 4 * 3);
+
+            u32 accumulator = 0;
+            u32 bits = 0;
+            for (const char c: _text)
+            {
+                if (c == '=')
+                {
+                    break;
+                }
+                const s8 value = kTable[u8(c)];
+                KT_VERIFY(value >= 0, "Invalid character in base64 data URI");
+                accumulator = (accumulator << 6) | u32(value);
+                bits += 6;
+                if (bits >= 8)
+                {
+                    bits -= 8;
+                    result.push_back(u8(accumulator >> bits));
+                }
+            }
+            return result;
+        }
+
+        std::string DecodeUri(std::string_view _uri)
+        {
+            std::string result;
+            result.reserve(_uri.size());
+            for (size_t i = 0; i < _uri.size(); i++)
+            {
+                if (_uri[i] == '%' && i + 2 < _uri.size())
+                {
+                    const std::string hex(_uri.substr(i + 1, 2));
+                    result += char(std::strtoul(hex.c_str(), nullptr, 16));
+                    i += 2;
+                }
+                else
+                {
+                    result += _uri[i];
+                }
+            }
+            return result;
+        }
+
+        AccessorType ParseAccessorType(std::string_view _type)
+        {
+            if (_type == "SCALAR") return AccessorType::Scalar;
+            if (_type == "VEC2") return AccessorType::Vec2;
+            if (_type == "VEC3") return AccessorType::Vec3;
+            if (_type == "VEC4") return AccessorType::Vec4;
+            if (_type == "MAT2") return AccessorType::Mat2;
+            if (_type == "MAT3") return AccessorType::Mat3;
+            if (_type == "MAT4") return AccessorType::Mat4;
+            ThrowError("Unknown accessor type '%.*s'", int(_type.size()), _type.data());
+        }
+
+        ComponentType ParseComponentType(const JsonValue& _value)
+        {
+            const u32 type = _value.AsU32();
+            switch (ComponentType(type))
+            {
+                case ComponentType::Byte:
+                case ComponentType::UnsignedByte:
+                case ComponentType::Short:
+                case ComponentType::UnsignedShort:
+                case ComponentType::UnsignedInt:
+                case ComponentType::Float:
+                    return ComponentType(type);
+            }
+            ThrowError("Unknown accessor component type %u", type);
+        }
+
+        std::optional<u32> ParseOptionalIndex(const JsonValue& _value, size_t _count, const char* _what)
+        {
+            if (_value.IsNull())
+            {
+                return std::nullopt;
+            }
+            const u32 index = _value.AsU32(~0u);
+            KT_VERIFY(index < _count, "Invalid %s index", _what);
+            return index;
+        }
+
+        /// Fills the TRS of a node from its matrix, which must not have shear.
+        void DecomposeMatrix(Node& _node)
+        {
+            const std::array<f32, 16>& m = _node.m_matrix;
+            f64 columns[3][3];
+            for (u32 c = 0; c < 3; c++)
+            {
+                _node.m_translation[c] = m[12 + c];
+                const f64 length = std::sqrt(f64(m[c * 4]) * m[c * 4] + f64(m[c * 4 + 1]) * m[c * 4 + 1] + f64(m[c * 4 + 2]) * m[c * 4 + 2]);
+                _node.m_scale[c] = f32(length);
+                for (u32 r = 0; r < 3; r++)
+                {
+                    columns[c][r] = length > 0.0 ? m[c * 4 + r] / length : (r == c ? 1.0 : 0.0);
+                }
+            }
+            // Mirrors flip the first axis, so the rest is a rotation.
+            const f64 determinant = columns[0][0] * (columns[1][1] * columns[2][2] - columns[2][1] * columns[1][2])
+                - columns[1][0] * (columns[0][1] * columns[2][2] - columns[2][1] * columns[0][2])
+                + columns[2][0] * (columns[0][1] * columns[1][2] - columns[1][1] * columns[0][2]);
+            if (determinant < 0.0)
+            {
+                _node.m_scale[0] = -_node.m_scale[0];
+                for (u32 r = 0; r < 3; r++)
+                {
+                    columns[0][r] = -columns[0][r];
+                }
+            }
+
+            // Rotation matrix element (row, column) is columns[column][row].
+            const f64 trace = columns[0][0] + columns[1][1] + columns[2][2];
+            f64 q[4];
+            if (trace > 0.0)
+            {
+                const f64 s = 2.0 * std::sqrt(trace + 1.0);
+                q[3] = 0.25 * s;
+                q[0] = (columns[1][2] - columns[2][1]) / s;
+                q[1] = (columns[2][0] - columns[0][2]) / s;
+                q[2] = (columns[0][1] - columns[1][0]) / s;
+            }
+            else if (columns[0][0] > columns[1][1] && columns[0][0] > columns[2][2])
+            {
+                const f64 s = 2.0 * std::sqrt(1.0 + columns[0][0] - columns[1][1] - columns[2][2]);
+                q[3] = (columns[1][2] - columns[2][1]) / s;
+                q[0] = 0.25 * s;
+                q[1] = (columns[1][0] + columns[0][1]) / s;
+                q[2] = (columns[2][0] + columns[0][2]) / s;
+            }
+            else if (columns[1][1] > columns[2][2])
+            {
+                const f64 s = 2.0 * std::sqrt(1.0 + columns[1][1] - columns[0][0] - columns[2][2]);
+                q[3] = (columns[2][0] - columns[0][2]) / s;
+                q[0] = (columns[1][0] + columns[0][1]) / s;
+                q[1] = 0.25 * s;
+                q[2] = (columns[2][1] + columns[1][2]) / s;
+            }
+            else
+            {
+                const f64 s = 2.0 * std::sqrt(1.0 + columns[2][2] - columns[0][0] - columns[1][1]);
+                q[3] = (columns[0][1] - columns[1][0]) / s;
+                q[0] = (columns[2][0] + columns[0][2]) / s;
+                q[1] = (columns[2][1] + columns[1][2]) / s;
+                q[2] = 0.25 * s;
+            }
+            for (u32 c = 0; c < 4; c++)
+            {
+                _node.m_rotation[c] = f32(q[c]);
+            }
+        }
+
+        u32 ParseIndex(const JsonValue& _value, size_t _count, const char* _what)
+        {
+            const u32 index = _value.AsU32(~0u);
+            KT_VERIFY(index < _count, "Invalid %s index", _what);
+            return index;
+        }
+    }
+
+    u32 GetComponentSize(ComponentType _type)
+    {
+        switch (_type)
+        {
+            case ComponentType::Byte:
+            case ComponentType::UnsignedByte:
+                return 1;
+            case ComponentType::Short:
+            case ComponentType::UnsignedShort:
+                return 2;
+            case ComponentType::UnsignedInt:
+            case ComponentType::Float:
+                return 4;
+        }
+        return 0;
+    }
+
+    u32 GetComponentCount(AccessorType _type)
+    {
+        constexpr u32 kCounts[] = { 1, 2, 3, 4, 4, 9, 16 };
+        return kCounts[u32(_type)];
+    }
+
+    std::optional<u32> Primitive::FindAttribute(std::string_view _name) const
+    {
+        for (const auto& [name, accessor]: m_attributes)
+        {
+            if (name == _name)
+            {
+                return accessor;
+            }
+        }
+        return std::nullopt;
+    }
+
+    Document Document::Load(const std::filesystem::path& _path)
+    {
+        Document document;
+        document.m_path = _path;
+        document.m_file = MappedFile::Open(_path);
+
+        std::span<const u8> jsonChunk = document.m_file.GetData();
+        std::span<const u8> binaryChunk;
+        if (jsonChunk.size() >= 4 && ReadU32(jsonChunk, 0) == kGlbMagic)
+        {
+            document.ParseGlb(jsonChunk, binaryChunk);
+        }
+
+        document.m_json = JsonValue::Parse(std::string_view(reinterpret_cast<const char*>(jsonChunk.data()), jsonChunk.size()));
+
+        const std::string_view version = document.m_json["asset"]["version"].AsString();
+        KT_VERIFY(version.starts_with("2."), "'%s' is not a glTF 2.x asset", _path.string().c_str());
+
+        document.LoadBuffers(binaryChunk);
+        document.ParseBufferViews();
+        document.ParseAccessors();
+        document.ParseMaterials();
+        document.ParseMeshes();
+        document.ParseNodes();
+        document.ParseScenes();
+        document.ParseSkins();
+        document.ParseAnimations();
+        return document;
+    }
+
+    const u8* Document::GetViewData(u32 _bufferView, u64 _byteOffset) const
+    {
+        const BufferView& view = m_bufferViews[_bufferView];
+        return m_buffers[view.m_buffer].m_data.data() + view.m_byteOffset + _byteOffset;
+    }
+
+    void Document::ReleaseAccessorRange(const Accessor& _accessor, u32 _begin, u32 _end) const
+    {
+        if (!_accessor.m_bufferView.has_value() || _begin >= _end)
+        {
+            return;
+        }
+
+        const BufferView& view = m_bufferViews[*_accessor.m_bufferView];
+        const Buffer& buffer = m_buffers[view.m_buffer];
+        const MappedFile& source = buffer.m_isBinaryChunk ? m_file : buffer.m_mapping;
+        if (!buffer.m_isBinaryChunk && buffer.m_mapping.GetSize() == 0)
+        {
+            // Embedded buffer, nothing to reclaim.
+            return;
+        }
+
+        const u64 elementSize = u64(GetComponentSize(_accessor.m_componentType)) * GetComponentCount(_accessor.m_type);
+        const u64 stride = view.m_byteStride != 0 ? view.m_byteStride : elementSize;
+        const u8* begin = GetViewData(*_accessor.m_bufferView, _accessor.m_byteOffset + stride * _begin);
+        const u64 size = stride * (_end - _begin - 1) + elementSize;
+        source.Release({ begin, size });
+    }
+
+    void Document::ParseGlb(std::span<const u8>& _jsonChunk, std::span<const u8>& _binaryChunk) const
+    {
+        const std::span<const u8> file = m_file.GetData();
+        KT_VERIFY(file.size() >= 20, "Truncated GLB header");
+        KT_VERIFY(ReadU32(file, 4) == 2, "Unsupported GLB container version %u", ReadU32(file, 4));
+
+        const u64 totalLength = std::min<u64>(ReadU32(file, 8), file.size());
+        _jsonChunk = {};
+        u64 offset = 12;
+        while (offset + 8 <= totalLength)
+        {
+            const u64 chunkLength = ReadU32(file, offset);
+            const u32 chunkType = ReadU32(file, offset + 4);
+            offset += 8;
+            KT_VERIFY(offset + chunkLength <= totalLength, "Truncated GLB chunk");
+
+            const std::span<const u8> chunk = file.subspan(offset, chunkLength);
+            if (chunkType == kGlbJsonChunk && _jsonChunk.empty())
+            {
+                _jsonChunk = chunk;
+            }
+            else if (chunkType == kGlbBinaryChunk && _binaryChunk.empty())
+            {
+                _binaryChunk = chunk;
+            }
+            offset += AlignUp(chunkLength, 4);
+        }
+        KT_VERIFY(!_jsonChunk.empty(), "GLB file without JSON chunk");
+    }
+
+    void Document::LoadBuffers(std::span<const u8> _binaryChunk)
+    {
+        const JsonValue::Array& buffers = m_json["buffers"].AsArray();
+        m_buffers.resize(buffers.size());
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            const JsonValue& json = buffers[i];
+            Buffer& buffer = m_buffers[i];
+            const u64 byteLength = json["byteLength"].AsU64();
+
+            if (!json.Contains("uri"))
+            {
+                KT_VERIFY(i == 0 && !_binaryChunk.empty(), "Buffer %zu has no uri and no GLB binary chunk", i);
+                buffer.m_data = _binaryChunk;
+                buffer.m_isBinaryChunk = true;
+            }
+            else
+            {
+                const std::string_view uri = json["uri"].AsString();
+                if (uri.starts_with("data:"))
+                {
+                    const size_t comma = uri.find(',');
+                    KT_VERIFY(
+                        comma != std::string_view::npos && uri.substr(0, comma).ends_with(";base64"),
+                        "Only base64 data URIs are supported");
+                    buffer.m_storage = DecodeBase64(uri.substr(comma + 1));
+                    buffer.m_data = buffer.m_storage;
+                }
+                else
+                {
+                    std::filesystem::path path = m_path.parent_path() / std::filesystem::u8path(DecodeUri(uri));
+                    buffer.m_mapping = MappedFile::Open(path);
+                    buffer.m_data = buffer.m_mapping.GetData();
+                    m_externalBufferPaths.push_back(std::move(path));
+                }
+            }
+
+            KT_VERIFY(buffer.m_data.size() >= byteLength, "Buffer %zu is smaller than its declared length", i);
+            buffer.m_data = buffer.m_data.first(byteLength);
+        }
+    }
+
+    void Document::ParseBufferViews()
+    {
+        const JsonValue::Array& views = m_json["bufferViews"].AsArray();
+        m_bufferViews.reserve(views.size());
+        for (const JsonValue& json: views)
+        {
+            BufferView& view = m_bufferViews.emplace_back();
+            view.m_buffer = json["buffer"].AsU32(~0u);
+            view.m_byteOffset = json["byteOffset"].AsU64();
+            view.m_byteLength = json["byteLength"].AsU64();
+            view.m_byteStride = json["byteStride"].AsU32();
+
+            KT_VERIFY(view.m_buffer < m_buffers.size(), "Buffer view references an invalid buffer");
+            KT_VERIFY(
+                view.m_byteOffset + view.m_byteLength <= m_buffers[view.m_buffer].m_data.size(),
+                "Buffer view %zu is out of its buffer range",
+                m_bufferViews.size() - 1);
+        }
+    }
+
+    void Document::ParseAccessors()
+    {
+        const JsonValue::Array& accessors = m_json["accessors"].AsArray();
+        m_accessors.reserve(accessors.size());
+        for (const JsonValue& json: accessors)
+        {
+            const size_t index = m_accessors.size();
+            Accessor& accessor = m_accessors.emplace_back();
+            accessor.m_bufferView = ParseOptionalIndex(json["bufferView"], m_bufferViews.size(), "buffer view");
+            accessor.m_byteOffset = json["byteOffset"].AsU64();
+            accessor.m_componentType = ParseComponentType(json["componentType"]);
+            accessor.m_normalized = json["normalized"].AsBool();
+            accessor.m_count = json["count"].AsU32();
+            accessor.m_type = ParseAccessorType(json["type"].AsString());
+            for (const JsonValue& value: json["min"].AsArray())
+            {
+                accessor.m_min.push_back(f32(value.AsNumber()));
+            }
+            for (const JsonValue& value: json["max"].AsArray())
+            {
+                accessor.m_max.push_back(f32(value.AsNumber()));
+            }
+
+            const u64 elementSize = u64(GetComponentSize(accessor.m_componentType)) * GetComponentCount(accessor.m_type);
+            if (accessor.m_bufferView.has_value() && accessor.m_count > 0)
+            {
+                const BufferView& view = m_bufferViews[*accessor.m_bufferView];
+                const u64 stride = view.m_byteStride != 0 ? view.m_byteStride : elementSize;
+                const u64 lastByte = accessor.m_byteOffset + stride * (accessor.m_count - 1) + elementSize;
+                KT_VERIFY(lastByte <= view.m_byteLength, "Accessor %zu is out of its buffer view range", index);
+            }
+
+            const JsonValue& sparse = json["sparse"];
+            if (sparse.IsObject())
+            {
+                SparseStorage& storage = accessor.m_sparse.emplace();
+                storage.m_count = sparse["count"].AsU32();
+                storage.m_indicesBufferView = sparse["indices"]["bufferView"].AsU32(~0u);
+                storage.m_indicesByteOffset = sparse["indices"]["byteOffset"].AsU64();
+                storage.m_indicesComponentType = ParseComponentType(sparse["indices"]["componentType"]);
+                storage.m_valuesBufferView = sparse["values"]["bufferView"].AsU32(~0u);
+                storage.m_valuesByteOffset = sparse["values"]["byteOffset"].AsU64();
+
+                KT_VERIFY(
+                    storage.m_indicesBufferView < m_bufferViews.size() && storage.m_valuesBufferView < m_bufferViews.size(),
+                    "Accessor %zu has invalid sparse buffer views",
+                    index);
+                const u64 indicesEnd = storage.m_indicesByteOffset
+                    + u64(storage.m_count) * GetComponentSize(storage.m_indicesComponentType);
+                const u64 valuesEnd = storage.m_valuesByteOffset + u64(storage.m_count) * elementSize;
+                KT_VERIFY(
+                    indicesEnd <= m_bufferViews[storage.m_indicesBufferView].m_byteLength
+                        && valuesEnd <= m_bufferViews[storage.m_valuesBufferView].m_byteLength,
+                    "Accessor %zu sparse storage is out of its buffer view range",
+                    index);
+            }
+        }
+    }
+
+    void Document::ParseMaterials()
+    {
+        for (const JsonValue& json: m_json["materials"].AsArray())
+        {
+            m_materials.push_back({ std::string(json["name"].AsString()) });
+        }
+    }
+
+    void Document::ParseMeshes()
+    {
+        for (const JsonValue& json: m_json["meshes"].AsArray())
+        {
+            Mesh& mesh = m_meshes.emplace_back();
+            mesh.m_name = json["name"].AsString();
+
+            for (const JsonValue& primitiveJson: json["primitives"].AsArray())
+            {
+                Primitive& primitive = mesh.m_primitives.emplace_back();
+                for (const auto& [name, accessor]: primitiveJson["attributes"].AsObject())
+                {
+                    const u32 index = accessor.AsU32(~0u);
+                    KT_VERIFY(index < m_accessors.size(), "Attribute '%s' references an invalid accessor", name.c_str());
+                    primitive.m_attributes.emplace_back(name, index);
+                }
+                primitive.m_indices = ParseOptionalIndex(primitiveJson["indices"], m_accessors.size(), "indices accessor");
+                primitive.m_material = ParseOptionalIndex(primitiveJson["material"], m_materials.size(), "material");
+                primitive.m_mode = PrimitiveMode(primitiveJson["mode"].AsU32(u32(PrimitiveMode::Triangles)));
+            }
+        }
+    }
+
+    void Document::ParseNodes()
+    {
+        const JsonValue::Array& nodes = m_json["nodes"].AsArray();
+        for (const JsonValue& json: nodes)
+        {
+            Node& node = m_nodes.emplace_back();
+            node.m_name = json["name"].AsString();
+            node.m_mesh = ParseOptionalIndex(json["mesh"], m_meshes.size(), "node mesh");
+            for (const JsonValue& child: json["children"].AsArray())
+            {
+                node.m_children.push_back(ParseIndex(child, nodes.size(), "child node"));
+            }
+
+            if (json.Contains("matrix"))
+            {
+                KT_VERIFY(json["matrix"].Size() == 16, "Node '%s': matrix needs 16 elements", node.m_name.c_str());
+                for (u32 i = 0; i < 16; i++)
+                {
+                    node.m_matrix[i] = f32(json["matrix"][i].AsNumber());
+                }
+                DecomposeMatrix(node);
+                continue;
+            }
+
+            const JsonValue& translation = json["translation"];
+            const JsonValue& rotation = json["rotation"];
+            const JsonValue& scale = json["scale"];
+            for (u32 c = 0; c < 3; c++)
+            {
+                node.m_translation[c] = f32(translation[c].AsNumber(0.0));
+                node.m_scale[c] = f32(scale[c].AsNumber(1.0));
+            }
+            for (u32 c = 0; c < 4; c++)
+            {
+                node.m_rotation[c] = f32(rotation[c].AsNumber(c == 3 ? 1.0 : 0.0));
+            }
+
+            // M = T * R * S, with a unit quaternion (x, y, z, w).
+            const f64 x = node.m_rotation[0];
+            const f64 y = node.m_rotation[1];
+            const f64 z = node.m_rotation[2];
+            const f64 w = node.m_rotation[3];
+            const f64 basis[3][3] = {
+                { 1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + z * w), 2.0 * (x * z - y * w) },
+                { 2.0 * (x * y - z * w), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + x * w) },
+                { 2.0 * (x * z + y * w), 2.0 * (y * z - x * w), 1.0 - 2.0 * (x * x + y * y) },
+            };
+            for (u32 column = 0; column < 3; column++)
+            {
+                for (u32 row = 0; row < 3; row++)
+                {
+                    node.m_matrix[column * 4 + row] = f32(basis[column][row] * node.m_scale[column]);
+                }
+                node.m_matrix[12 + column] = node.m_translation[column];
+            }
+        }
+    }
+
+    void Document::ParseScenes()
+    {
+        for (const JsonValue& json: m_json["scenes"].AsArray())
+        {
+            Scene& scene = m_scenes.emplace_back();
+            scene.m_name = json["name"].AsString();
+            for (const JsonValue& node: json["nodes"].AsArray())
+            {
+                scene.m_nodes.push_back(ParseIndex(node, m_nodes.size(), "scene node"));
+            }
+        }
+        m_defaultScene = ParseOptionalIndex(m_json["scene"], m_scenes.size(), "default scene");
+    }
+
+    void Document::ParseSkins()
+    {
+        for (const JsonValue& json: m_json["skins"].AsArray())
+        {
+            Skin& skin = m_skins.emplace_back();
+            skin.m_name = json["name"].AsString();
+            for (const JsonValue& joint: json["joints"].AsArray())
+            {
+                skin.m_joints.push_back(ParseIndex(joint, m_nodes.size(), "skin joint"));
+            }
+        }
+    }
+
+    void Document::ParseAnimations()
+    {
+        for (const JsonValue& json: m_json["animations"].AsArray())
+        {
+            Animation& animation = m_animations.emplace_back();
+            animation.m_name = json["name"].AsString();
+            for (const JsonValue& samplerJson: json["samplers"].AsArray())
+            {
+                AnimationSampler& sampler = animation.m_samplers.emplace_back();
+                sampler.m_input = ParseIndex(samplerJson["input"], m_accessors.size(), "animation input accessor");
+                sampler.m_output = ParseIndex(samplerJson["output"], m_accessors.size(), "animation output accessor");
+                const std::string_view interpolation = samplerJson["interpolation"].AsString("LINEAR");
+                if (interpolation == "STEP")
+                {
+                    sampler.m_interpolation = Interpolation::Step;
+                }
+                else if (interpolation == "CUBICSPLINE")
+                {
+                    sampler.m_interpolation = Interpolation::CubicSpline;
+                }
+                else
+                {
+                    KT_VERIFY(interpolation == "LINEAR", "Unknown animation interpolation '%.*s'", int(interpolation.size()), interpolation.data());
+                }
+
+                const u32 keyCount = m_accessors[sampler.m_input].m_count;
+                KT_VERIFY(m_accessors[sampler.m_input].m_type == AccessorType::Scalar, "Animation '%s': key times must be scalars", animation.m_name.c_str());
+                KT_VERIFY(
+                    u64(m_accessors[sampler.m_output].m_count) >= u64(keyCount) * (sampler.m_interpolation == Interpolation::CubicSpline ? 3 : 1),
+                    "Animation '%s': fewer values than keys",
+                    animation.m_name.c_str());
+            }
+            for (const JsonValue& channelJson: json["channels"].AsArray())
+            {
+                AnimationChannel& channel = animation.m_channels.emplace_back();
+                channel.m_sampler = ParseIndex(channelJson["sampler"], animation.m_samplers.size(), "animation sampler");
+                const JsonValue& target = channelJson["target"];
+                channel.m_node = ParseOptionalIndex(target["node"], m_nodes.size(), "animation target node");
+                const std::string_view path = target["path"].AsString();
+                if (path == "translation")
+                {
+                    channel.m_path = AnimationPath::Translation;
+                }
+                else if (path == "rotation")
+                {
+                    channel.m_path = AnimationPath::Rotation;
+                }
+                else if (path == "scale")
+                {
+                    channel.m_path = AnimationPath::Scale;
+                }
+                else
+                {
+                    KT_VERIFY(path == "weights", "Unknown animation target path '%.*s'", int(path.size()), path.data());
+                    channel.m_path = AnimationPath::Weights;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,1097 @@
+#include "KryneTools/Import/GltfImporter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Arena.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Import/GltfAccessor.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Jobs/TaskGraph.hpp"
+#include "KryneTools/Mesh/BrickOctree.hpp"
+#include "KryneTools/Mesh/MeshData.hpp"
+#include "KryneTools/Mesh/MeshFormat.hpp"
+#include "KryneTools/Mesh/MeshWriter.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        static_assert(sizeof(Float2) == 2 * sizeof(f32) && sizeof(Float3) == 3 * sizeof(f32) && sizeof(Float4) == 4 * sizeof(f32));
+
+        /// Elements per decode job on large accessors. Small enough to balance, large enough to amortize the spawn.
+        constexpr u32 kDecodeGrainSize = 32 * 1024;
+        /// Triangles per job of the passes over streamed meshes.
+        constexpr u64 kStreamGrainSize = 256 * 1024;
+
+        /// Rough peak memory of the in-core import, per vertex and per triangle: the streams, indices and LOD chains,
+        /// plus the scratch buffers of the simplifier, optimizer and meshlet builder. Only used to pick the meshes to
+        /// stream and to size their bricks.
+        constexpr u64 kInCoreBytesPerVertex = 160;
+        constexpr u64 kInCoreBytesPerTriangle = 128;
+        /// Vertices per triangle of a brick: closed surfaces have about 1/2, and the cuts duplicate their vertices.
+        constexpr f64 kBrickVerticesPerTriangle = 0.6;
+
+        struct AttributeBinding
+        {
+            const char* m_name;
+            VertexAttribute m_attribute;
+        };
+
+        constexpr AttributeBinding kAttributeBindings[] = {
+            { "POSITION", VertexAttribute::Position },
+            { "NORMAL", VertexAttribute::Normal },
+            { "TANGENT", VertexAttribute::Tangent },
+            { "TEXCOORD_0", VertexAttribute::TexCoord0 },
+            { "TEXCOORD_1", VertexAttribute::TexCoord1 },
+            { "COLOR_0", VertexAttribute::Color0 },
+            { "JOINTS_0", VertexAttribute::Joints0 },
+            { "WEIGHTS_0", VertexAttribute::Weights0 },
+        };
+
+        struct PrimitivePlan
+        {
+            const Gltf::Primitive* m_primitive;
+            u32 m_submesh;
+            u32 m_sourceIndexCount;
+        };
+
+        u32 GetTriangleListIndexCount(Gltf::PrimitiveMode _mode, u32 _sourceCount)
+        {
+            if (_mode == Gltf::PrimitiveMode::Triangles)
+            {
+                return _sourceCount - _sourceCount % 3;
+            }
+            return _sourceCount >= 3 ? (_sourceCount - 2) * 3 : 0;
+        }
+
+        std::string SanitizeFileName(std::string_view _name)
+        {
+            std::string result;
+            for (const char c: _name)
+            {
+                const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+                result += valid ? c : '_';
+            }
+            return result;
+        }
+
+        /// Computes the layout of the mesh: attribute set, submesh ranges and material slots. Allocates nothing.
+        std::vector<PrimitivePlan> PlanMesh(const Gltf::Document& _document, const Gltf::Mesh& _source, MeshData& _mesh)
+        {
+            std::vector<PrimitivePlan> plans;
+            std::unordered_map<u32, u32> materialSlots;
+            u32 vertexCount = 0;
+            u32 indexCount = 0;
+
+            for (const Gltf::Primitive& primitive: _source.m_primitives)
+            {
+                const Gltf::PrimitiveMode mode = primitive.m_mode;
+                if (mode != Gltf::PrimitiveMode::Triangles
+                    && mode != Gltf::PrimitiveMode::TriangleStrip
+                    && mode != Gltf::PrimitiveMode::TriangleFan)
+                {
+                    Log::Warning("Mesh '%s': skipping non-triangle primitive (mode %u)", _source.m_name.c_str(), u32(mode));
+                    continue;
+                }
+
+                const std::optional<u32> position = primitive.FindAttribute("POSITION");
+                if (!position.has_value())
+                {
+                    Log::Warning("Mesh '%s': skipping primitive without positions", _source.m_name.c_str());
+                    continue;
+                }
+
+                const u32 primitiveVertexCount = _document.GetAccessors()[*position].m_count;
+                for (const AttributeBinding& binding: kAttributeBindings)
+                {
+                    if (const std::optional<u32> accessor = primitive.FindAttribute(binding.m_name))
+                    {
+                        KT_VERIFY(
+                            _document.GetAccessors()[*accessor].m_count == primitiveVertexCount,
+                            "Mesh '%s': attribute %s count does not match the vertex count",
+                            _source.m_name.c_str(),
+                            binding.m_name);
+                        _mesh.m_attributeMask |= AttributeBit(binding.m_attribute);
+                    }
+                }
+
+                const u32 sourceIndexCount = primitive.m_indices.has_value()
+                    ? _document.GetAccessors()[*primitive.m_indices].m_count
+                    : primitiveVertexCount;
+                const u32 primitiveIndexCount = GetTriangleListIndexCount(mode, sourceIndexCount);
+                KT_VERIFY(
+                    u64(vertexCount) + primitiveVertexCount <= UINT32_MAX && u64(indexCount) + primitiveIndexCount <= UINT32_MAX,
+                    "Mesh '%s' is too large for 32 bits indexing",
+                    _source.m_name.c_str());
+
+                Submesh& submesh = _mesh.m_submeshes.emplace_back();
+                submesh.m_vertexOffset = vertexCount;
+                submesh.m_vertexCount = primitiveVertexCount;
+                submesh.m_indexOffset = indexCount;
+                submesh.m_indexCount = primitiveIndexCount;
+                submesh.m_materialIndex = MeshData::kNoMaterial;
+
+                if (primitive.m_material.has_value())
+                {
+                    const auto [it, inserted] = materialSlots.try_emplace(*primitive.m_material, u32(_mesh.m_materialNames.size()));
+                    if (inserted)
+                    {
+                        _mesh.m_materialNames.push_back(_document.GetMaterials()[*primitive.m_material].m_name);
+                    }
+                    submesh.m_materialIndex = it->second;
+                }
+
+                plans.push_back({ &primitive, u32(_mesh.m_submeshes.size() - 1), sourceIndexCount });
+                vertexCount += primitiveVertexCount;
+                indexCount += primitiveIndexCount;
+            }
+
+            _mesh.m_vertexCount = vertexCount;
+            return plans;
+        }
+
+        template <class T>
+        void FillStream(std::vector<T>& _stream, const Submesh& _submesh, const T& _value)
+        {
+            std::fill_n(_stream.begin() + _submesh.m_vertexOffset, _submesh.m_vertexCount, _value);
+        }
+
+        /// Decodes elements `[_begin, _end)` of an attribute accessor to its stream, at mesh vertex `_first` on.
+        void DecodeAttributeRange(
+            const Gltf::Document& _document,
+            const Gltf::Accessor& _accessor,
+            VertexAttribute _attribute,
+            u64 _first,
+            u32 _begin,
+            u32 _end,
+            MeshData& _mesh)
+        {
+            switch (_attribute)
+            {
+                case VertexAttribute::Position:
+                    Gltf::DecodeFloats(_document, _accessor, &_mesh.m_positions[_first].x, 3, _begin, _end);
+                    break;
+                case VertexAttribute::Normal:
+                    Gltf::DecodeFloats(_document, _accessor, &_mesh.m_normals[_first].x, 3, _begin, _end);
+                    break;
+                case VertexAttribute::Tangent:
+                    Gltf::DecodeFloats(_document, _accessor, &_mesh.m_tangents[_first].x, 4, _begin, _end);
+                    break;
+                case VertexAttribute::TexCoord0:
+                case VertexAttribute::TexCoord1:
+                {
+                    auto& stream = _mesh.m_texCoords[_attribute == VertexAttribute::TexCoord0 ? 0 : 1];
+                    Gltf::DecodeFloats(_document, _accessor, &stream[_first].x, 2, _begin, _end);
+                    break;
+                }
+                case VertexAttribute::Color0:
+                    Gltf::DecodeFloats(_document, _accessor, &_mesh.m_colors[_first].x, 4, _begin, _end);
+                    break;
+                case VertexAttribute::Joints0:
+                    Gltf::DecodeIntegers(_document, _accessor, _mesh.m_joints[_first].data(), 4, _begin, _end);
+                    break;
+                case VertexAttribute::Weights0:
+                    Gltf::DecodeFloats(_document, _accessor, &_mesh.m_weights[_first].x, 4, _begin, _end);
+                    break;
+                case VertexAttribute::Count:
+                    break;
+            }
+        }
+
+        void DecodeStream(
+            JobSystem& _jobSystem,
+            const Gltf::Document& _document,
+            const Gltf::Accessor& _accessor,
+            const Submesh& _submesh,
+            VertexAttribute _attribute,
+            MeshData& _mesh)
+        {
+            _jobSystem.ParallelFor(_submesh.m_vertexCount, kDecodeGrainSize, [&](u64 _begin, u64 _end)
+            {
+                const u32 begin = u32(_begin);
+                const u32 end = u32(_end);
+                DecodeAttributeRange(_document, _accessor, _attribute, u64(_submesh.m_vertexOffset) + begin, begin, end, _mesh);
+
+                // Decoded data now lives in the output streams, the source pages are no longer needed. Views shared
+                // by interleaved attributes are simply faulted back from the page cache by the other decoders.
+                _document.ReleaseAccessorRange(_accessor, begin, end);
+            });
+        }
+
+        void FillDefaultStream(VertexAttribute _attribute, const Submesh& _submesh, MeshData& _mesh)
+        {
+            switch (_attribute)
+            {
+                case VertexAttribute::Position: FillStream(_mesh.m_positions, _submesh, {}); break;
+                case VertexAttribute::Normal: FillStream(_mesh.m_normals, _submesh, { 0.f, 0.f, 1.f }); break;
+                case VertexAttribute::Tangent: FillStream(_mesh.m_tangents, _submesh, { 1.f, 0.f, 0.f, 1.f }); break;
+                case VertexAttribute::TexCoord0: FillStream(_mesh.m_texCoords[0], _submesh, {}); break;
+                case VertexAttribute::TexCoord1: FillStream(_mesh.m_texCoords[1], _submesh, {}); break;
+                case VertexAttribute::Color0: FillStream(_mesh.m_colors, _submesh, { 1.f, 1.f, 1.f, 1.f }); break;
+                case VertexAttribute::Joints0: FillStream(_mesh.m_joints, _submesh, {}); break;
+                case VertexAttribute::Weights0: FillStream(_mesh.m_weights, _submesh, { 1.f, 0.f, 0.f, 0.f }); break;
+                case VertexAttribute::Count: break;
+            }
+        }
+
+        void DecodeIndices(
+            const Gltf::Document& _document,
+            const PrimitivePlan& _plan,
+            const Submesh& _submesh,
+            const char* _meshName,
+            MeshData& _mesh)
+        {
+            const Gltf::Primitive& primitive = *_plan.m_primitive;
+            u32* output = _mesh.m_indices.data() + _submesh.m_indexOffset;
+
+            const ScratchScope scratch;
+            const bool isList = primitive.m_mode == Gltf::PrimitiveMode::Triangles;
+            u32* sourceIndices = isList ? output : scratch.GetArena().AllocateArray<u32>(_plan.m_sourceIndexCount).data();
+
+            // Lists are decoded in place, trailing incomplete triangles being dropped.
+            const u32 decodedCount = isList ? _submesh.m_indexCount : _plan.m_sourceIndexCount;
+            if (primitive.m_indices.has_value())
+            {
+                const Gltf::Accessor& accessor = _document.GetAccessors()[*primitive.m_indices];
+                Gltf::DecodeIntegers(_document, accessor, sourceIndices, 1, 0, decodedCount);
+                _document.ReleaseAccessorRange(accessor, 0, decodedCount);
+
+                const u32 maxIndex = decodedCount > 0 ? *std::max_element(sourceIndices, sourceIndices + decodedCount) : 0;
+                KT_VERIFY(
+                    decodedCount == 0 || maxIndex < _submesh.m_vertexCount,
+                    "Mesh '%s': index %u is out of the vertex range",
+                    _meshName,
+                    maxIndex);
+            }
+            else
+            {
+                for (u32 i = 0; i < decodedCount; i++)
+                {
+                    sourceIndices[i] = i;
+                }
+            }
+
+            if (primitive.m_mode == Gltf::PrimitiveMode::TriangleStrip)
+            {
+                for (u32 i = 0; i + 2 < _plan.m_sourceIndexCount; i++)
+                {
+                    // Every other triangle of a strip has its winding flipped.
+                    const bool odd = (i & 1) != 0;
+                    output[i * 3 + 0] = sourceIndices[i + (odd ? 1 : 0)];
+                    output[i * 3 + 1] = sourceIndices[i + (odd ? 0 : 1)];
+                    output[i * 3 + 2] = sourceIndices[i + 2];
+                }
+            }
+            else if (primitive.m_mode == Gltf::PrimitiveMode::TriangleFan)
+            {
+                for (u32 i = 0; i + 2 < _plan.m_sourceIndexCount; i++)
+                {
+                    output[i * 3 + 0] = sourceIndices[i + 1];
+                    output[i * 3 + 1] = sourceIndices[i + 2];
+                    output[i * 3 + 2] = sourceIndices[0];
+                }
+            }
+        }
+
+        void ImportPrimitive(JobSystem& _jobSystem, const Gltf::Document& _document, const PrimitivePlan& _plan, const char* _meshName, MeshData& _mesh)
+        {
+            const Submesh& submesh = _mesh.m_submeshes[_plan.m_submesh];
+
+            JobGroup group;
+            for (const AttributeBinding& binding: kAttributeBindings)
+            {
+                if (!_mesh.HasAttribute(binding.m_attribute))
+                {
+                    continue;
+                }
+
+                const std::optional<u32> accessor = _plan.m_primitive->FindAttribute(binding.m_name);
+                if (accessor.has_value())
+                {
+                    const Gltf::Accessor& source = _document.GetAccessors()[*accessor];
+                    _jobSystem.Spawn(group, [&, attribute = binding.m_attribute]
+                    {
+                        DecodeStream(_jobSystem, _document, source, submesh, attribute, _mesh);
+                    });
+                }
+                else
+                {
+                    // Union of the primitive attribute sets, give neutral values to the primitives lacking one.
+                    _jobSystem.Spawn(group, [&, attribute = binding.m_attribute]
+                    {
+                        FillDefaultStream(attribute, submesh, _mesh);
+                    });
+                }
+            }
+
+            _jobSystem.Spawn(group, [&]
+            {
+                DecodeIndices(_document, _plan, submesh, _meshName, _mesh);
+            });
+            _jobSystem.Wait(group);
+
+            Aabb bounds;
+            for (u32 i = 0; i < submesh.m_vertexCount; i++)
+            {
+                bounds.Expand(_mesh.m_positions[submesh.m_vertexOffset + i]);
+            }
+            _mesh.m_submeshes[_plan.m_submesh].m_bounds = bounds;
+        }
+
+        /// Decodes a planned mesh.
+        void ImportMesh(JobSystem& _jobSystem, const Gltf::Document& _document, std::span<const PrimitivePlan> _plans, MeshData& _mesh)
+        {
+            KT_TRACE_ZONE_DETAIL("ImportMesh", _mesh.m_name);
+            const Submesh& last = _mesh.m_submeshes.back();
+            _mesh.m_indices.resize(last.m_indexOffset + last.m_indexCount);
+            _mesh.AllocateStreams();
+
+            JobGroup group;
+            for (const PrimitivePlan& plan: _plans)
+            {
+                _jobSystem.Spawn(group, [&]
+                {
+                    ImportPrimitive(_jobSystem, _document, plan, _mesh.m_name.c_str(), _mesh);
+                });
+            }
+            _jobSystem.Wait(group);
+
+            for (const Submesh& submesh: _mesh.m_submeshes)
+            {
+                if (submesh.m_bounds.IsValid())
+                {
+                    _mesh.m_bounds.Expand(submesh.m_bounds);
+                }
+            }
+        }
+
+        /// Runs the enabled processing stages on a decoded mesh, then writes it.
+        void ProcessMesh(
+            JobSystem& _jobSystem,
+            const ImportSettings& _settings,
+            const LodSettings& _lodSettings,
+            const std::filesystem::path& _path,
+            const Aabb& _quantizationBounds,
+            MeshData& _mesh,
+            MeshOptimizationReport& _report)
+        {
+            KT_TRACE_ZONE_DETAIL("ProcessMesh", _path.string());
+            const u64 sourceIndexCount = _mesh.m_indices.size();
+            if (_settings.m_generateLods)
+            {
+                GenerateLods(_jobSystem, _mesh, _lodSettings);
+                Log::Verbose(
+                    "%s: %zu LODs, %llu -> %llu triangles",
+                    _path.string().c_str(),
+                    _mesh.m_lods.size(),
+                    static_cast<unsigned long long>(sourceIndexCount / 3),
+                    static_cast<unsigned long long>((_mesh.m_indices.size() - sourceIndexCount) / 3));
+            }
+            if (_settings.m_optimize)
+            {
+                _report = OptimizeMesh(_jobSystem, _mesh);
+                Log::Verbose(
+                    "%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                    _path.string().c_str(),
+                    _report.m_before.GetAcmr(),
+                    _report.m_after.GetAcmr(),
+                    _report.m_before.GetAtvr(),
+                    _report.m_after.GetAtvr());
+            }
+            if (_settings.m_buildMeshlets)
+            {
+                BuildMeshlets(_jobSystem, _mesh, _settings.m_meshletSettings);
+                Log::Verbose("%s: %zu meshlets", _path.string().c_str(), _mesh.m_meshlets.m_meshlets.size());
+            }
+
+            MeshWriteSettings writeSettings;
+            writeSettings.m_quantizeAttributes = _settings.m_quantize;
+            writeSettings.m_quantizationBounds = _quantizationBounds;
+            WriteMesh(_path, _mesh, writeSettings);
+            Log::Verbose(
+                "%s: %u vertices, %llu triangles, %zu submeshes",
+                _path.string().c_str(),
+                _mesh.m_vertexCount,
+                static_cast<unsigned long long>(sourceIndexCount / 3),
+                _mesh.m_submeshes.size());
+        }
+
+        /// Outputs of one glTF mesh: its `.kmesh`, or one per brick when streamed.
+        struct MeshOutputs
+        {
+            std::vector<std::filesystem::path> m_paths;
+            std::vector<MeshOptimizationReport> m_reports;
+            u64 m_vertexCount = 0;
+            u64 m_triangleCount = 0;
+        };
+
+        u64 EstimateInCoreSize(u64 _vertexCount, u64 _triangleCount)
+        {
+            return _vertexCount * kInCoreBytesPerVertex + _triangleCount * kInCoreBytesPerTriangle;
+        }
+
+        u32 GetTriangleCount(const Submesh& _submesh)
+        {
+            return _submesh.m_indexCount / 3;
+        }
+
+        /**
+         * @brief Decodes triangles `[_begin, _end)` of a primitive as a list, with the windings of `DecodeIndices()`.
+         * @details Only the source indices of the range are read, and released once decoded.
+         */
+        void DecodeTriangles(
+            const Gltf::Document& _document,
+            const PrimitivePlan& _plan,
+            const Submesh& _submesh,
+            const char* _meshName,
+            u32 _begin,
+            u32 _end,
+            u32* _output)
+        {
+            const Gltf::Primitive& primitive = *_plan.m_primitive;
+            const bool isList = primitive.m_mode == Gltf::PrimitiveMode::Triangles;
+            const bool isFan = primitive.m_mode == Gltf::PrimitiveMode::TriangleFan;
+
+            // Triangle i of a strip reads source indices [i, i + 2], of a fan 0 and [i + 1, i + 2].
+            const u32 first = isList ? _begin * 3 : _begin + (isFan ? 1 : 0);
+            const u32 last = isList ? _end * 3 : _end + 2;
+
+            const ScratchScope scratch;
+            u32* source = isList ? _output : scratch.GetArena().AllocateArray<u32>(last - first).data();
+            u32 center = 0;
+            if (primitive.m_indices.has_value())
+            {
+                const Gltf::Accessor& accessor = _document.GetAccessors()[*primitive.m_indices];
+                Gltf::DecodeIntegers(_document, accessor, source, 1, first, last);
+                if (isFan)
+                {
+                    Gltf::DecodeIntegers(_document, accessor, &center, 1, 0, 1);
+                }
+                _document.ReleaseAccessorRange(accessor, first, last);
+
+                const u32 maxIndex = std::max(center, last > first ? *std::max_element(source, source + (last - first)) : 0);
+                KT_VERIFY(maxIndex < _submesh.m_vertexCount, "Mesh '%s': index %u is out of the vertex range", _meshName, maxIndex);
+            }
+            else
+            {
+                std::iota(source, source + (last - first), first);
+            }
+
+            if (primitive.m_mode == Gltf::PrimitiveMode::TriangleStrip)
+            {
+                for (u32 i = _begin; i < _end; i++)
+                {
+                    const bool odd = (i & 1) != 0;
+                    u32* triangle = _output + u64(i - _begin) * 3;
+                    triangle[0] = source[i - first + (odd ? 1 : 0)];
+                    triangle[1] = source[i - first + (odd ? 0 : 1)];
+                    triangle[2] = source[i - first + 2];
+                }
+            }
+            else if (isFan)
+            {
+                for (u32 i = _begin; i < _end; i++)
+                {
+                    u32* triangle = _output + u64(i - _begin) * 3;
+                    triangle[0] = source[i + 1 - first];
+                    triangle[1] = source[i + 2 - first];
+                    triangle[2] = center;
+                }
+            }
+        }
+
+        /**
+         * @brief Positions of a primitive, decoded on demand by chunks of which the last few are kept.
+         * @details Index scans of large meshes mostly reference nearby vertices, so few chunks are decoded twice.
+         */
+        class PositionCache
+        {
+        public:
+            PositionCache(const Gltf::Document& _document, const Gltf::Accessor& _accessor, const ScratchScope& _scratch)
+                : m_document(_document)
+                , m_accessor(_accessor)
+                , m_positions(_scratch.GetArena().AllocateArray<Float3>(u64(kChunkSize) * kSlotCount).data())
+            {
+                m_chunks.fill(kInvalidChunk);
+            }
+
+            const Float3& Get(u32 _vertex)
+            {
+                const u32 chunk = _vertex / kChunkSize;
+                if (m_chunks[m_last] != chunk)
+                {
+                    const auto found = std::find(m_chunks.begin(), m_chunks.end(), chunk);
+                    if (found != m_chunks.end())
+                    {
+                        m_last = u32(found - m_chunks.begin());
+                    }
+                    else
+                    {
+                        m_last = m_next;
+                        m_next = (m_next + 1) % kSlotCount;
+                        m_chunks[m_last] = chunk;
+                        const u32 begin = chunk * kChunkSize;
+                        const u32 end = std::min(m_accessor.m_count, begin + kChunkSize);
+                        Gltf::DecodeFloats(m_document, m_accessor, &m_positions[u64(m_last) * kChunkSize].x, 3, begin, end);
+                        m_document.ReleaseAccessorRange(m_accessor, begin, end);
+                    }
+                }
+                return m_positions[u64(m_last) * kChunkSize + _vertex % kChunkSize];
+            }
+
+        private:
+            static constexpr u32 kChunkSize = 16 * 1024;
+            static constexpr u32 kSlotCount = 8;
+            static constexpr u32 kInvalidChunk = ~0u;
+
+            const Gltf::Document& m_document;
+            const Gltf::Accessor& m_accessor;
+            Float3* m_positions;
+            std::array<u32, kSlotCount> m_chunks {};
+            u32 m_last = 0;
+            u32 m_next = 0;
+        };
+
+        /**
+         * @brief Calls `_function(plan, indices, positions)` on ranges of triangles of every primitive, as jobs.
+         * @details `indices` holds three vertex indices per triangle, `positions` resolves them.
+         */
+        template <class Function>
+        void ForEachTriangleRange(JobSystem& _jobSystem, const Gltf::Document& _document, std::span<const PrimitivePlan> _plans, const MeshData& _layout, Function&& _function)
+        {
+            JobGroup group;
+            for (u32 p = 0; p < _plans.size(); p++)
+            {
+                const Submesh& submesh = _layout.m_submeshes[_plans[p].m_submesh];
+                const Gltf::Accessor& positions = _document.GetAccessors()[*_plans[p].m_primitive->FindAttribute("POSITION")];
+                _jobSystem.Spawn(group, [&, p]
+                {
+                    _jobSystem.ParallelFor(GetTriangleCount(submesh), kStreamGrainSize, [&](u64 _begin, u64 _end)
+                    {
+                        const ScratchScope scratch;
+                        PositionCache cache(_document, positions, scratch);
+                        const std::span<u32> indices = scratch.GetArena().AllocateArray<u32>((_end - _begin) * 3);
+                        DecodeTriangles(_document, _plans[p], submesh, _layout.m_name.c_str(), u32(_begin), u32(_end), indices.data());
+                        _function(p, std::span<const u32>(indices), cache);
+                    });
+                });
+            }
+            _jobSystem.Wait(group);
+        }
+
+        /// Triangle of a streamed mesh, with the plan of its primitive and primitive relative indices.
+        struct BrickTriangle
+        {
+            u32 m_plan;
+            std::array<u32, 3> m_indices;
+
+            bool operator<(const BrickTriangle& _other) const
+            {
+                return m_plan != _other.m_plan ? m_plan < _other.m_plan : m_indices < _other.m_indices;
+            }
+        };
+
+        /// Triangles of a streamed mesh on disk, grouped by brick. Removed on destruction.
+        class SpillFile
+        {
+        public:
+            explicit SpillFile(std::filesystem::path _path)
+                : m_path(std::move(_path))
+            {
+                FileSystem::CreateParentDirectories(m_path);
+                m_file = std::fopen(m_path.string().c_str(), "w+b");
+                KT_VERIFY(m_file != nullptr, "Failed to create '%s'", m_path.string().c_str());
+            }
+
+            ~SpillFile()
+            {
+                std::fclose(m_file);
+                std::error_code error;
+                std::filesystem::remove(m_path, error);
+            }
+
+            SpillFile(const SpillFile&) = delete;
+            SpillFile& operator=(const SpillFile&) = delete;
+
+            void Write(u64 _offset, std::span<const BrickTriangle> _triangles)
+            {
+                const std::lock_guard lock(m_mutex);
+                Seek(_offset);
+                KT_VERIFY(
+                    std::fwrite(_triangles.data(), sizeof(BrickTriangle), _triangles.size(), m_file) == _triangles.size(),
+                    "Failed to write '%s'",
+                    m_path.string().c_str());
+            }
+
+            void Read(u64 _offset, std::span<BrickTriangle> _triangles)
+            {
+                const std::lock_guard lock(m_mutex);
+                Seek(_offset);
+                KT_VERIFY(
+                    std::fread(_triangles.data(), sizeof(BrickTriangle), _triangles.size(), m_file) == _triangles.size(),
+                    "Failed to read '%s'",
+                    m_path.string().c_str());
+            }
+
+        private:
+            void Seek(u64 _offset)
+            {
+#if defined(_WIN32)
+                const int result = _fseeki64(m_file, s64(_offset), SEEK_SET);
+#else
+                const int result = fseeko(m_file, off_t(_offset), SEEK_SET);
+#endif
+                KT_VERIFY(result == 0, "Failed to seek in '%s'", m_path.string().c_str());
+            }
+
+            std::filesystem::path m_path;
+            FILE* m_file = nullptr;
+            std::mutex m_mutex;
+        };
+
+        /**
+         * @brief Decodes the vertices and triangles of one brick to a mesh, one submesh per primitive it covers.
+         * @param _triangles Triangles of the brick, sorted.
+         */
+        MeshData GatherBrick(const Gltf::Document& _document, std::span<const PrimitivePlan> _plans, const MeshData& _layout, std::span<const BrickTriangle> _triangles)
+        {
+            MeshData brick;
+            brick.m_attributeMask = _layout.m_attributeMask;
+            brick.m_materialNames = _layout.m_materialNames;
+
+            const ScratchScope scratch;
+            struct Range
+            {
+                u32 m_plan;
+                std::span<const BrickTriangle> m_triangles;
+                std::span<u32> m_vertices;
+            };
+            ArenaVector<Range> ranges(scratch);
+            for (size_t begin = 0; begin < _triangles.size();)
+            {
+                size_t end = begin;
+                while (end < _triangles.size() && _triangles[end].m_plan == _triangles[begin].m_plan)
+                {
+                    end++;
+                }
+                ranges.push_back({ _triangles[begin].m_plan, _triangles.subspan(begin, end - begin), {} });
+                begin = end;
+            }
+
+            for (Range& range: ranges)
+            {
+                const std::span<u32> vertices = scratch.GetArena().AllocateArray<u32>(range.m_triangles.size() * 3);
+                for (size_t t = 0; t < range.m_triangles.size(); t++)
+                {
+                    std::copy_n(range.m_triangles[t].m_indices.begin(), 3, vertices.begin() + t * 3);
+                }
+                std::sort(vertices.begin(), vertices.end());
+                range.m_vertices = vertices.first(size_t(std::unique(vertices.begin(), vertices.end()) - vertices.begin()));
+
+                Submesh& submesh = brick.m_submeshes.emplace_back();
+                submesh.m_vertexOffset = brick.m_vertexCount;
+                submesh.m_vertexCount = u32(range.m_vertices.size());
+                submesh.m_indexOffset = u32(brick.m_indices.size());
+                submesh.m_indexCount = u32(range.m_triangles.size() * 3);
+                submesh.m_materialIndex = _layout.m_submeshes[_plans[range.m_plan].m_submesh].m_materialIndex;
+                brick.m_vertexCount += submesh.m_vertexCount;
+                for (const BrickTriangle& triangle: range.m_triangles)
+                {
+                    for (const u32 index: triangle.m_indices)
+                    {
+                        const u32 local = u32(std::lower_bound(range.m_vertices.begin(), range.m_vertices.end(), index) - range.m_vertices.begin());
+                        brick.m_indices.push_back(local);
+                    }
+                }
+            }
+            brick.AllocateStreams();
+
+            for (size_t r = 0; r < ranges.size(); r++)
+            {
+                const Range& range = ranges[r];
+                const PrimitivePlan& plan = _plans[range.m_plan];
+                Submesh& submesh = brick.m_submeshes[r];
+                for (const AttributeBinding& binding: kAttributeBindings)
+                {
+                    if (!brick.HasAttribute(binding.m_attribute))
+                    {
+                        continue;
+                    }
+                    const std::optional<u32> accessor = plan.m_primitive->FindAttribute(binding.m_name);
+                    if (!accessor.has_value())
+                    {
+                        FillDefaultStream(binding.m_attribute, submesh, brick);
+                        continue;
+                    }
+
+                    // Vertices are sorted, consecutive ones decode as one range.
+                    const Gltf::Accessor& source = _document.GetAccessors()[*accessor];
+                    for (size_t begin = 0; begin < range.m_vertices.size();)
+                    {
+                        size_t end = begin + 1;
+                        while (end < range.m_vertices.size() && range.m_vertices[end] == range.m_vertices[end - 1] + 1)
+                        {
+                            end++;
+                        }
+                        DecodeAttributeRange(_document, source, binding.m_attribute, submesh.m_vertexOffset + begin, range.m_vertices[begin], range.m_vertices[end - 1] + 1, brick);
+                        begin = end;
+                    }
+                    _document.ReleaseAccessorRange(source, range.m_vertices.front(), range.m_vertices.back() + 1);
+                }
+
+                for (u32 v = 0; v < submesh.m_vertexCount; v++)
+                {
+                    submesh.m_bounds.Expand(brick.m_positions[submesh.m_vertexOffset + v]);
+                }
+                brick.m_bounds.Expand(submesh.m_bounds);
+            }
+            return brick;
+        }
+
+        /**
+         * @brief Imports a mesh too large for the memory limit out-of-core, as one output per octree brick.
+         *
+         * @details
+         * The mesh is never decoded whole: a first pass over the positions computes the bounds, a second counts the
+         * triangles of every octree cell, which sizes the bricks, and a third writes every triangle to its brick on
+         * disk. Each brick is then decoded and processed as a mesh of its own, with borders locked so simplified
+         * levels of neighbouring bricks still match, and as many bricks in flight as the memory limit allows.
+         */
+        void ImportMeshBricks(
+            JobSystem& _jobSystem,
+            const Gltf::Document& _document,
+            std::span<const PrimitivePlan> _plans,
+            const MeshData& _layout,
+            const ImportSettings& _settings,
+            const std::filesystem::path& _path,
+            MeshOutputs& _outputs)
+        {
+            KT_TRACE_ZONE_DETAIL("ImportMeshBricks", _layout.m_name);
+            const f64 bytesPerTriangle = f64(kInCoreBytesPerTriangle) + kBrickVerticesPerTriangle * f64(kInCoreBytesPerVertex);
+            const u64 brickTriangleCount = std::clamp<u64>(u64(f64(_settings.m_memoryLimit) / bytesPerTriangle), kMinBrickTriangleCount, std::max(_settings.m_brickTriangleCount, kMinBrickTriangleCount));
+
+            std::mutex mutex;
+            Aabb bounds;
+            ForEachTriangleRange(_jobSystem, _document, _plans, _layout, [&](u32, std::span<const u32> _indices, PositionCache& _positions)
+            {
+                Aabb rangeBounds;
+                for (const u32 index: _indices)
+                {
+                    rangeBounds.Expand(_positions.Get(index));
+                }
+                const std::lock_guard lock(mutex);
+                bounds.Expand(rangeBounds);
+            });
+
+            BrickOctree octree(bounds);
+            ForEachTriangleRange(_jobSystem, _document, _plans, _layout, [&](u32, std::span<const u32> _indices, PositionCache& _positions)
+            {
+                for (size_t i = 0; i < _indices.size(); i += 3)
+                {
+                    octree.CountTriangle(_positions.Get(_indices[i]), _positions.Get(_indices[i + 1]), _positions.Get(_indices[i + 2]));
+                }
+            });
+            octree.Build(brickTriangleCount);
+            const std::vector<BrickOctree::Brick>& bricks = octree.GetBricks();
+
+            std::vector<u64> brickOffsets(bricks.size() + 1, 0);
+            for (size_t b = 0; b < bricks.size(); b++)
+            {
+                brickOffsets[b + 1] = brickOffsets[b] + bricks[b].m_triangleCount;
+            }
+            std::vector<std::atomic<u64>> cursors(bricks.size());
+
+            SpillFile spill(_path.parent_path() / FormatString(".%s.bricks", _path.stem().string().c_str()));
+            ForEachTriangleRange(_jobSystem, _document, _plans, _layout, [&](u32 _plan, std::span<const u32> _indices, PositionCache& _positions)
+            {
+                const ScratchScope scratch;
+                const u32 triangleCount = u32(_indices.size() / 3);
+                const std::span<u32> triangleBricks = scratch.GetArena().AllocateArray<u32>(triangleCount);
+                ArenaVector<u32> counts(bricks.size() + 1, 0, scratch);
+                for (u32 t = 0; t < triangleCount; t++)
+                {
+                    triangleBricks[t] = octree.FindBrick(_positions.Get(_indices[t * 3]), _positions.Get(_indices[t * 3 + 1]), _positions.Get(_indices[t * 3 + 2]));
+                    counts[triangleBricks[t] + 1]++;
+                }
+                std::partial_sum(counts.begin(), counts.end(), counts.begin());
+
+                // Counting sort by brick, then one write per brick the range covers.
+                const std::span<BrickTriangle> sorted = scratch.GetArena().AllocateArray<BrickTriangle>(triangleCount);
+                ArenaVector<u32> cursor(counts.begin(), counts.end() - 1, scratch);
+                for (u32 t = 0; t < triangleCount; t++)
+                {
+                    sorted[cursor[triangleBricks[t]]++] = { _plan, { _indices[t * 3], _indices[t * 3 + 1], _indices[t * 3 + 2] } };
+                }
+                for (size_t b = 0; b < bricks.size(); b++)
+                {
+                    const u32 count = counts[b + 1] - counts[b];
+                    if (count != 0)
+                    {
+                        const u64 slot = brickOffsets[b] + cursors[b].fetch_add(count);
+                        spill.Write(slot * sizeof(BrickTriangle), sorted.subspan(counts[b], count));
+                    }
+                }
+            });
+
+            const f32 meshExtent = [&]
+            {
+                const Float3 extent = bounds.GetExtent();
+                return std::max(extent.x, std::max(extent.y, extent.z));
+            }();
+            const u64 brickSize = EstimateInCoreSize(u64(f64(brickTriangleCount) * kBrickVerticesPerTriangle), brickTriangleCount);
+            const u32 maxInFlight = u32(std::clamp<u64>(_settings.m_memoryLimit / std::max<u64>(brickSize, 1), 1, _jobSystem.GetWorkerCount()));
+            Log::Verbose(
+                "%s: streaming %llu triangles as %zu bricks of at most %llu, %u in flight",
+                _path.string().c_str(),
+                static_cast<unsigned long long>(brickOffsets.back()),
+                bricks.size(),
+                static_cast<unsigned long long>(brickTriangleCount),
+                maxInFlight);
+
+            _outputs.m_paths.resize(bricks.size());
+            _outputs.m_reports.resize(bricks.size());
+            std::atomic<u64> vertexCount = 0;
+            TaskGraph graph;
+            for (u32 b = 0; b < bricks.size(); b++)
+            {
+                _outputs.m_paths[b] = _path.parent_path() / FormatString("%s_b%u.kmesh", _path.stem().string().c_str(), b);
+                graph.AddTask(FormatString("brick %u", b), f64(bricks[b].m_triangleCount), [&, b]
+                {
+                    MeshData brick = [&]
+                    {
+                        const ScratchScope scratch;
+                        const std::span<BrickTriangle> triangles = scratch.GetArena().AllocateArray<BrickTriangle>(bricks[b].m_triangleCount);
+                        spill.Read(brickOffsets[b] * sizeof(BrickTriangle), triangles);
+                        // Ranges were written in completion order, sorting makes the output deterministic.
+                        std::sort(triangles.begin(), triangles.end());
+                        return GatherBrick(_document, _plans, _layout, triangles);
+                    }();
+                    brick.m_name = FormatString("%s_b%u", _layout.m_name.c_str(), b);
+
+                    // The error budget is relative to the submesh extent, scale it so every brick gets the absolute
+                    // deviation the whole mesh would.
+                    LodSettings lodSettings = _settings.m_lodSettings;
+                    lodSettings.m_lockBorders = true;
+                    const Float3 brickExtent = brick.m_bounds.GetExtent();
+                    const f32 brickMaxExtent = std::max(brickExtent.x, std::max(brickExtent.y, brickExtent.z));
+                    if (brickMaxExtent > 0.f)
+                    {
+                        lodSettings.m_maxError *= meshExtent / brickMaxExtent;
+                    }
+
+                    // Positions are quantized in the frame of the whole mesh, as they would in-core.
+                    ProcessMesh(_jobSystem, _settings, lodSettings, _outputs.m_paths[b], bounds, brick, _outputs.m_reports[b]);
+                    vertexCount += brick.m_vertexCount;
+                });
+            }
+
+            graph.Run(_jobSystem, maxInFlight);
+            for (u32 b = 0; b < graph.GetTaskCount(); b++)
+            {
+                const TaskRecord& record = graph.GetRecord(b);
+                KT_VERIFY(record.m_status == TaskStatus::Done, "Mesh '%s', %s: %s", _layout.m_name.c_str(), record.m_name.c_str(), record.m_error.c_str());
+            }
+            _outputs.m_vertexCount = vertexCount.load();
+            _outputs.m_triangleCount = brickOffsets.back();
+        }
+
+        std::vector<std::filesystem::path> MakeOutputPaths(const Gltf::Document& _document, const ImportSettings& _settings)
+        {
+            const std::filesystem::path directory = _settings.m_outputDirectory.empty()
+                ? _settings.m_input.parent_path()
+                : _settings.m_outputDirectory;
+
+            std::vector<std::filesystem::path> paths;
+            for (const std::string& name: GetMeshOutputNames(_document, _settings.m_input))
+            {
+                paths.push_back(directory / name);
+            }
+            return paths;
+        }
+
+        CacheKey MakeCacheKey(JobSystem& _jobSystem, const Gltf::Document& _document, const ImportSettings& _settings, std::span<const std::filesystem::path> _paths)
+        {
+            CacheKeyBuilder builder("kryne-import");
+            builder.AddU64(MeshFormat::kVersion);
+            builder.AddU64(_settings.m_optimize ? 1 : 0);
+            builder.AddU64(_settings.m_buildMeshlets ? 1 : 0);
+            builder.AddU64(_settings.m_meshletSettings.m_maxVertices);
+            builder.AddU64(_settings.m_meshletSettings.m_maxTriangles);
+            builder.AddU64(_settings.m_quantize ? 1 : 0);
+            builder.AddU64(_settings.m_generateLods ? 1 : 0);
+            builder.AddU64(_settings.m_lodSettings.m_levelCount);
+            builder.AddU64(std::bit_cast<u32>(_settings.m_lodSettings.m_triangleRatio));
+            builder.AddU64(std::bit_cast<u32>(_settings.m_lodSettings.m_maxError));
+            builder.AddU64(_settings.m_memoryLimit);
+            // Counts under the minimum all give the same bricks.
+            builder.AddU64(std::max(_settings.m_brickTriangleCount, kMinBrickTriangleCount));
+            builder.AddFile(_jobSystem, _settings.m_input);
+            for (const std::filesystem::path& path: _document.GetExternalBufferPaths())
+            {
+                builder.AddFile(_jobSystem, path);
+            }
+            // File names derive from the input name, which is not part of its content.
+            for (const std::filesystem::path& path: _paths)
+            {
+                builder.AddString(path.filename().generic_string());
+            }
+            return builder.Build();
+        }
+
+        /// Fills the statistics of restored outputs from their headers.
+        void ReadRestoredStatistics(ImportResult& _result)
+        {
+            for (const std::filesystem::path& path: _result.m_outputs)
+            {
+                const MappedFile file = MappedFile::Open(path);
+                MeshFormat::Header header;
+                KT_VERIFY(file.GetSize() >= sizeof(header), "'%s': truncated mesh header", path.string().c_str());
+                std::memcpy(&header, file.GetData().data(), sizeof(header));
+                _result.m_vertexCount += header.m_vertexCount;
+
+                // The index count covers the simplified levels too, count the submesh ones.
+                const std::span<const u8> data = file.GetData();
+                KT_VERIFY(
+                    header.m_sectionTableOffset + u64(header.m_sectionCount) * sizeof(MeshFormat::SectionEntry) <= data.size(),
+                    "'%s': truncated section table",
+                    path.string().c_str());
+                for (u32 s = 0; s < header.m_sectionCount; s++)
+                {
+                    MeshFormat::SectionEntry entry;
+                    std::memcpy(&entry, data.data() + header.m_sectionTableOffset + s * sizeof(entry), sizeof(entry));
+                    if (entry.m_type != MeshFormat::SectionType::Submeshes)
+                    {
+                        continue;
+                    }
+                    KT_VERIFY(entry.m_offset + entry.m_size <= data.size(), "'%s': truncated submesh section", path.string().c_str());
+                    for (u64 offset = 0; offset + sizeof(MeshFormat::SubmeshRecord) <= entry.m_size; offset += sizeof(MeshFormat::SubmeshRecord))
+                    {
+                        MeshFormat::SubmeshRecord record;
+                        std::memcpy(&record, data.data() + entry.m_offset + offset, sizeof(record));
+                        _result.m_triangleCount += record.m_indexCount / 3;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> GetMeshOutputNames(const Gltf::Document& _document, const std::filesystem::path& _input)
+    {
+        const std::string stem = _input.stem().string();
+        const auto& meshes = _document.GetMeshes();
+
+        std::vector<std::string> names;
+        std::unordered_set<std::string> usedNames;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            std::string name = meshes.size() == 1 ? stem : stem + "_" + SanitizeFileName(meshes[i].m_name);
+            if (meshes.size() > 1 && meshes[i].m_name.empty())
+            {
+                name += FormatString("mesh%zu", i);
+            }
+            if (!usedNames.insert(name).second)
+            {
+                name += FormatString("_%zu", i);
+                usedNames.insert(name);
+            }
+            names.push_back(name + ".kmesh");
+        }
+        return names;
+    }
+
+    ImportResult ImportGltf(JobSystem& _jobSystem, const ImportSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("ImportGltf", _settings.m_input.string());
+        const Gltf::Document document = Gltf::Document::Load(_settings.m_input);
+        const auto& meshes = document.GetMeshes();
+        const std::vector<std::filesystem::path> paths = MakeOutputPaths(document, _settings);
+        std::filesystem::path outputDirectory = paths.empty() ? std::filesystem::path() : paths.front().parent_path();
+        if (outputDirectory.empty())
+        {
+            outputDirectory = ".";
+        }
+
+        CacheKey cacheKey;
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            cacheKey = MakeCacheKey(_jobSystem, document, _settings, paths);
+
+            ImportResult result;
+            if (!_settings.m_collectReports && _settings.m_cache->Restore(cacheKey, outputDirectory, &result.m_outputs))
+            {
+                Log::Verbose("%s: restored from cache (%s)", _settings.m_input.string().c_str(), cacheKey.ToString().c_str());
+                ReadRestoredStatistics(result);
+                result.m_cacheHit = true;
+                return result;
+            }
+        }
+
+        std::vector<MeshOutputs> outputs(meshes.size());
+        JobGroup group;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            _jobSystem.Spawn(group, [&, i]
+            {
+                MeshData mesh;
+                mesh.m_name = meshes[i].m_name;
+                const std::vector<PrimitivePlan> plans = PlanMesh(document, meshes[i], mesh);
+                if (mesh.m_submeshes.empty())
+                {
+                    Log::Warning("Mesh '%s' has no triangle primitive, skipped", meshes[i].m_name.c_str());
+                    return;
+                }
+
+                u64 sourceTriangleCount = 0;
+                for (const Submesh& submesh: mesh.m_submeshes)
+                {
+                    sourceTriangleCount += GetTriangleCount(submesh);
+                }
+                if (_settings.m_memoryLimit != 0 && EstimateInCoreSize(mesh.m_vertexCount, sourceTriangleCount) > _settings.m_memoryLimit)
+                {
+                    ImportMeshBricks(_jobSystem, document, plans, mesh, _settings, paths[i], outputs[i]);
+                    return;
+                }
+
+                ImportMesh(_jobSystem, document, plans, mesh);
+                MeshOptimizationReport& report = outputs[i].m_reports.emplace_back();
+                ProcessMesh(_jobSystem, _settings, _settings.m_lodSettings, paths[i], {}, mesh, report);
+                outputs[i].m_paths.push_back(paths[i]);
+                outputs[i].m_vertexCount = mesh.m_vertexCount;
+                outputs[i].m_triangleCount = sourceTriangleCount;
+            });
+        }
+        _jobSystem.Wait(group);
+
+        ImportResult result;
+        for (const MeshOutputs& mesh: outputs)
+        {
+            result.m_outputs.insert(result.m_outputs.end(), mesh.m_paths.begin(), mesh.m_paths.end());
+            if (_settings.m_optimize)
+            {
+                result.m_optimizationReports.insert(result.m_optimizationReports.end(), mesh.m_reports.begin(), mesh.m_reports.end());
+            }
+            result.m_vertexCount += mesh.m_vertexCount;
+            result.m_triangleCount += mesh.m_triangleCount;
+        }
+
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            _settings.m_cache->Store(cacheKey, outputDirectory, result.m_outputs);
+        }
+        return result;
+    }
+}
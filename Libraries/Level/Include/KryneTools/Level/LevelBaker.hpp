@@ -0,0 +1,69 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "KryneTools/Level/LevelBvh.hpp"
+#include "KryneTools/Level/LevelFormat.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class JobSystem;
+
+    struct LevelSettings
+    {
+        std::filesystem::path m_input;
+        /// Defaults to the input with the `.klvl` extension.
+        std::filesystem::path m_output;
+        /// Directory of the `.kmesh` files relative to the level, prepended to their names. Empty when side by side.
+        std::string m_meshDirectory;
+        /// glTF scene to bake, defaults to the `scene` of the asset, then to the first one.
+        std::optional<u32> m_scene;
+        BvhSettings m_bvhSettings;
+        /// Optional artifact cache, looked up before baking and filled after.
+        ContentCache* m_cache = nullptr;
+    };
+
+    struct LevelResult
+    {
+        std::filesystem::path m_output;
+        u32 m_instanceCount = 0;
+        u32 m_meshCount = 0;
+        u32 m_materialCount = 0;
+        u32 m_bvhNodeCount = 0;
+        /// 0 when restored from the cache, like `m_bvhCost`.
+        u32 m_bvhDepth = 0;
+        /// See `Bvh::m_cost`.
+        f32 m_bvhCost = 0.f;
+        u64 m_size = 0;
+        /// The level was restored from the cache, its counts read back from the file.
+        bool m_cacheHit = false;
+    };
+
+    /**
+     * @brief Bakes a glTF 2.0 scene to the load-in-place level format.
+     *
+     * @details
+     * The node hierarchy is walked from the scene roots, composing world transforms, and every node referencing a
+     * mesh becomes an instance. World bounds come from the position accessor bounds of the mesh, decoded when the
+     * asset omits them. Meshes are referenced by the names `ImportGltf()` gives their `.kmesh` files, and their
+     * material slots are mapped to the level materials in the order the importer assigns them. Meshes without
+     * triangle primitives are not imported, their instances are skipped.
+     *
+     * Instances are reordered by `BuildBvh()` so each leaf references a contiguous range. With a cache, the key
+     * covers the asset and its buffers, which bounds may be decoded from, the settings and the tools build ID.
+     */
+    LevelResult BakeLevel(JobSystem& _jobSystem, const LevelSettings& _settings);
+
+    /**
+     * @brief Validates a level mapped in memory, as a runtime loader would, and returns its header.
+     *
+     * @details
+     * Checks the header, that every array lies in `_data` and is aligned, and that index arrays are in range.
+     * Throws an `Error` on the first violation. `_data` must be `LevelFormat::kAlignment` aligned.
+     */
+    [[nodiscard]] const LevelFormat::Header& OpenLevel(std::span<const u8> _data);
+}
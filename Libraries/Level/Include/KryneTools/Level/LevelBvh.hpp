@@ -0,0 +1,44 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "KryneTools/Common/Math.hpp"
+#include "KryneTools/Level/LevelFormat.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    struct BvhSettings
+    {
+        /// Instances per leaf, at most.
+        u32 m_maxLeafSize = 4;
+    };
+
+    struct Bvh
+    {
+        /// Depth-first, see `LevelFormat::BvhNode`.
+        std::vector<LevelFormat::BvhNode> m_nodes;
+        /// Input index of each leaf slot: leaves reference ranges of this array.
+        std::vector<u32> m_order;
+        /// Levels below the root, 0 for a single leaf.
+        u32 m_depth = 0;
+        /// Surface area heuristic cost, in instance tests per query reaching the root.
+        f32 m_cost = 0.f;
+    };
+
+    /**
+     * @brief Builds a bounding volume hierarchy over instance bounds, with the binned surface area heuristic.
+     *
+     * @details
+     * Centroids of each node are binned in 16 slices along their longest axis, and the node is split at the bin
+     * boundary of lowest SAH cost. Nodes over the leaf size are always split, smaller ones only when the SAH favours
+     * it. Past 48 levels, or when all centroids of a node coincide, nodes are split at their median instead, which
+     * bounds the depth of skewed scenes and keeps stacked instances within the leaf size.
+     *
+     * Splits are forked as jobs, and the root levels bin their instances in parallel. The tree is then flattened depth
+     * first. Empty inputs give an empty hierarchy.
+     */
+    [[nodiscard]] Bvh BuildBvh(JobSystem& _jobSystem, std::span<const Aabb> _bounds, const BvhSettings& _settings);
+}
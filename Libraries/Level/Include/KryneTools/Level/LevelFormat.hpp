@@ -0,0 +1,114 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine baked levels (`.klvl`).
+ *
+ * A level is loaded in place: the runtime maps the file, checks the header and uses the arrays directly. Every array
+ * and string is located by an offset relative to the address of the field referencing it, so the mapping can sit at
+ * any address and nothing is patched on load. Arrays start on `kAlignment` boundaries.
+ *
+ * The scene hierarchy is flattened: instances are the nodes referencing a mesh, with their world transform, stored as
+ * parallel arrays in the order of the BVH leaves.
+ *
+ * All values are little-endian.
+ */
+namespace KryneTools::LevelFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'L', 'V', 'L');
+    constexpr u16 kVersion = 1;
+    constexpr u64 kAlignment = 16;
+
+    /// `m_count` elements at `m_offset` bytes from this field.
+    template <class T>
+    struct RelativeArray
+    {
+        u32 m_offset;
+        u32 m_count;
+
+        [[nodiscard]] const T* GetData() const { return reinterpret_cast<const T*>(reinterpret_cast<const u8*>(this) + m_offset); }
+        [[nodiscard]] std::span<const T> GetSpan() const { return { GetData(), m_count }; }
+    };
+    static_assert(sizeof(RelativeArray<u32>) == 8);
+
+    /// `m_size` characters at `m_offset` bytes from this field, not null terminated.
+    struct RelativeString
+    {
+        u32 m_offset;
+        u32 m_size;
+
+        [[nodiscard]] std::string_view Get() const { return { reinterpret_cast<const char*>(this) + m_offset, m_size }; }
+    };
+    static_assert(sizeof(RelativeString) == 8);
+
+    /// Row-major affine world transform, the implicit last row is `0 0 0 1`.
+    struct Transform
+    {
+        f32 m_rows[3][4];
+    };
+    static_assert(sizeof(Transform) == 48);
+
+    struct Bounds
+    {
+        f32 m_min[3];
+        f32 m_max[3];
+    };
+    static_assert(sizeof(Bounds) == 24);
+
+    struct MeshRecord
+    {
+        /// `.kmesh` file, relative to the level file, with `/` separators.
+        RelativeString m_path;
+        /// Range of `Header::m_meshMaterials` mapping each material slot of the mesh to a level material.
+        u32 m_firstMaterial;
+        u32 m_materialCount;
+    };
+    static_assert(sizeof(MeshRecord) == 16);
+
+    /**
+     * @brief BVH node, in depth-first order from the root.
+     *
+     * @details
+     * Interior nodes have a `m_count` of 0: their first child is the next node and the second one is at index
+     * `m_offset`. Leaves reference `m_count` instances starting at index `m_offset`.
+     */
+    struct BvhNode
+    {
+        f32 m_boundsMin[3];
+        u32 m_offset;
+        f32 m_boundsMax[3];
+        u32 m_count;
+    };
+    static_assert(sizeof(BvhNode) == 32);
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u64 m_fileSize;
+        f32 m_boundsMin[3];
+        f32 m_boundsMax[3];
+        /// Instance arrays, all of the same count.
+        RelativeArray<Transform> m_transforms;
+        /// World space bounds.
+        RelativeArray<Bounds> m_bounds;
+        /// Index in `m_meshes`.
+        RelativeArray<u32> m_instanceMeshes;
+        /// Index of the source node of the scene, for gameplay lookups.
+        RelativeArray<u32> m_instanceNodes;
+        RelativeArray<MeshRecord> m_meshes;
+        /// Index in `m_materials`.
+        RelativeArray<u32> m_meshMaterials;
+        /// Material names.
+        RelativeArray<RelativeString> m_materials;
+        /// Empty for levels without instances.
+        RelativeArray<BvhNode> m_bvhNodes;
+    };
+    static_assert(sizeof(Header) == 104);
+}
@@ -0,0 +1,529 @@
+#include "KryneTools/Level/LevelBaker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Import/GltfAccessor.hpp"
+#include "KryneTools/Import/GltfDocument.hpp"
+#include "KryneTools/Import/GltfImporter.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Row-major 3x4 affine transform, composed in double precision so deep hierarchies do not drift.
+        using Affine = std::array<std::array<f64, 4>, 3>;
+
+        constexpr Affine kIdentity {{ { 1.0, 0.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0, 0.0 }, { 0.0, 0.0, 1.0, 0.0 } }};
+
+        Affine Compose(const Affine& _parent, const std::array<f32, 16>& _local)
+        {
+            Affine result {};
+            for (u32 r = 0; r < 3; r++)
+            {
+                for (u32 c = 0; c < 4; c++)
+                {
+                    f64 value = c == 3 ? _parent[r][3] : 0.0;
+                    for (u32 k = 0; k < 3; k++)
+                    {
+                        value += _parent[r][k] * f64(_local[c * 4 + k]);
+                    }
+                    result[r][c] = value;
+                }
+            }
+            return result;
+        }
+
+        Aabb TransformBounds(const Affine& _transform, const Aabb& _bounds)
+        {
+            // Meshes without vertices are a point at their origin.
+            const Float3 center = _bounds.IsValid() ? _bounds.GetCenter() : Float3 {};
+            const Float3 halfExtent = _bounds.IsValid() ? _bounds.GetExtent() * 0.5f : Float3 {};
+            f64 min[3];
+            f64 max[3];
+            for (u32 r = 0; r < 3; r++)
+            {
+                f64 worldCenter = _transform[r][3];
+                f64 worldHalfExtent = 0.0;
+                for (u32 k = 0; k < 3; k++)
+                {
+                    worldCenter += _transform[r][k] * center[k];
+                    worldHalfExtent += std::abs(_transform[r][k]) * halfExtent[k];
+                }
+                min[r] = worldCenter - worldHalfExtent;
+                max[r] = worldCenter + worldHalfExtent;
+            }
+            return { { f32(min[0]), f32(min[1]), f32(min[2]) }, { f32(max[0]), f32(max[1]), f32(max[2]) } };
+        }
+
+        struct MeshInfo
+        {
+            Aabb m_bounds;
+            /// glTF material of each slot of the imported mesh.
+            std::vector<u32> m_materialSlots;
+            /// The importer writes a `.kmesh` for it.
+            bool m_imported = false;
+        };
+
+        /// Mirrors the primitive filtering and material slot assignment of the importer.
+        MeshInfo AnalyzeMesh(const Gltf::Document& _document, const Gltf::Mesh& _mesh)
+        {
+            MeshInfo info;
+            for (const Gltf::Primitive& primitive: _mesh.m_primitives)
+            {
+                const Gltf::PrimitiveMode mode = primitive.m_mode;
+                const std::optional<u32> position = primitive.FindAttribute("POSITION");
+                if ((mode != Gltf::PrimitiveMode::Triangles && mode != Gltf::PrimitiveMode::TriangleStrip && mode != Gltf::PrimitiveMode::TriangleFan)
+                    || !position.has_value())
+                {
+                    continue;
+                }
+                info.m_imported = true;
+
+                if (primitive.m_material.has_value()
+                    && std::find(info.m_materialSlots.begin(), info.m_materialSlots.end(), *primitive.m_material) == info.m_materialSlots.end())
+                {
+                    info.m_materialSlots.push_back(*primitive.m_material);
+                }
+
+                // Float accessor bounds can be used as is, others store raw values and are decoded instead.
+                const Gltf::Accessor& accessor = _document.GetAccessors()[*position];
+                if (accessor.m_componentType == Gltf::ComponentType::Float && accessor.m_min.size() >= 3 && accessor.m_max.size() >= 3)
+                {
+                    info.m_bounds.Expand(Float3 { accessor.m_min[0], accessor.m_min[1], accessor.m_min[2] });
+                    info.m_bounds.Expand(Float3 { accessor.m_max[0], accessor.m_max[1], accessor.m_max[2] });
+                    continue;
+                }
+                constexpr u32 kChunkSize = 1u << 16;
+                std::vector<Float3> positions(std::min(kChunkSize, accessor.m_count));
+                for (u32 begin = 0; begin < accessor.m_count; begin += kChunkSize)
+                {
+                    const u32 end = std::min(accessor.m_count, begin + kChunkSize);
+                    Gltf::DecodeFloats(_document, accessor, &positions[0].x, 3, begin, end);
+                    for (u32 i = 0; i < end - begin; i++)
+                    {
+                        info.m_bounds.Expand(positions[i]);
+                    }
+                }
+            }
+            return info;
+        }
+
+        std::vector<u32> FindRootNodes(const Gltf::Document& _document, const LevelSettings& _settings)
+        {
+            const auto& scenes = _document.GetScenes();
+            std::optional<u32> scene = _settings.m_scene.has_value() ? _settings.m_scene : _document.GetDefaultScene();
+            if (_settings.m_scene.has_value())
+            {
+                KT_VERIFY(*_settings.m_scene < scenes.size(), "Scene %u does not exist, the asset has %zu", *_settings.m_scene, scenes.size());
+            }
+            if (!scene.has_value() && !scenes.empty())
+            {
+                scene = 0;
+            }
+            if (scene.has_value())
+            {
+                return scenes[*scene].m_nodes;
+            }
+
+            // Assets without scenes: every node nobody parents is a root.
+            const auto& nodes = _document.GetNodes();
+            std::vector<bool> isChild(nodes.size(), false);
+            for (const Gltf::Node& node: nodes)
+            {
+                for (const u32 child: node.m_children)
+                {
+                    isChild[child] = true;
+                }
+            }
+            std::vector<u32> roots;
+            for (u32 i = 0; i < nodes.size(); i++)
+            {
+                if (!isChild[i])
+                {
+                    roots.push_back(i);
+                }
+            }
+            return roots;
+        }
+
+        /// Appends the arrays of a level to a single buffer, and links them with relative offsets.
+        class LevelWriter
+        {
+        public:
+            LevelWriter()
+                : m_data(sizeof(LevelFormat::Header))
+            {}
+
+            template <class T>
+            [[nodiscard]] u64 Append(std::span<const T> _elements)
+            {
+                m_data.resize((m_data.size() + LevelFormat::kAlignment - 1) & ~(LevelFormat::kAlignment - 1));
+                const u64 offset = m_data.size();
+                m_data.resize(offset + _elements.size_bytes());
+                if (!_elements.empty())
+                {
+                    std::memcpy(m_data.data() + offset, _elements.data(), _elements.size_bytes());
+                }
+                return offset;
+            }
+
+            [[nodiscard]] u64 AppendString(std::string_view _string)
+            {
+                const u64 offset = m_data.size();
+                m_data.insert(m_data.end(), _string.begin(), _string.end());
+                return offset;
+            }
+
+            /// Points the `RelativeArray` or `RelativeString` at `_fieldOffset` to `_count` elements at `_targetOffset`.
+            void Link(u64 _fieldOffset, u64 _targetOffset, u64 _count)
+            {
+                const u32 link[2] = { u32(_targetOffset - _fieldOffset), u32(_count) };
+                std::memcpy(m_data.data() + _fieldOffset, link, sizeof(link));
+            }
+
+            [[nodiscard]] std::vector<u8>& GetData() { return m_data; }
+
+        private:
+            std::vector<u8> m_data;
+        };
+
+        template <class T>
+        const T* CheckArray(std::span<const u8> _file, const LevelFormat::RelativeArray<T>& _array, const char* _what)
+        {
+            const u64 fieldOffset = u64(reinterpret_cast<const u8*>(&_array) - _file.data());
+            const u64 offset = fieldOffset + _array.m_offset;
+            KT_VERIFY(
+                offset <= _file.size() && u64(_array.m_count) * sizeof(T) <= _file.size() - offset,
+                "Level %s array is out of bounds",
+                _what);
+            KT_VERIFY(offset % alignof(T) == 0, "Level %s array is misaligned", _what);
+            return _array.GetData();
+        }
+
+        void CheckString(std::span<const u8> _file, const LevelFormat::RelativeString& _string, const char* _what)
+        {
+            const u64 offset = u64(reinterpret_cast<const u8*>(&_string) - _file.data()) + _string.m_offset;
+            KT_VERIFY(offset <= _file.size() && _string.m_size <= _file.size() - offset, "Level %s string is out of bounds", _what);
+        }
+
+        CacheKey MakeCacheKey(JobSystem& _jobSystem, const Gltf::Document& _document, const LevelSettings& _settings, const std::filesystem::path& _output)
+        {
+            CacheKeyBuilder builder("kryne-level");
+            builder.AddU64(LevelFormat::kVersion);
+            builder.AddString(_settings.m_meshDirectory);
+            builder.AddU64(_settings.m_scene.has_value() ? u64(*_settings.m_scene) : ~0ull);
+            builder.AddU64(_settings.m_bvhSettings.m_maxLeafSize);
+            builder.AddFile(_jobSystem, _settings.m_input);
+            for (const std::filesystem::path& path: _document.GetExternalBufferPaths())
+            {
+                builder.AddFile(_jobSystem, path);
+            }
+            // Mesh names derive from the input name, which is not part of its content.
+            builder.AddString(_settings.m_input.filename().generic_string());
+            builder.AddString(_output.filename().generic_string());
+            return builder.Build();
+        }
+
+        /// Fills the counts of a restored level from its header. The BVH depth and cost are not stored.
+        void ReadRestoredStatistics(LevelResult& _result)
+        {
+            const MappedFile file = MappedFile::Open(_result.m_output);
+            const LevelFormat::Header& header = OpenLevel(file.GetData());
+            _result.m_instanceCount = header.m_transforms.m_count;
+            _result.m_meshCount = header.m_meshes.m_count;
+            _result.m_materialCount = header.m_materials.m_count;
+            _result.m_bvhNodeCount = header.m_bvhNodes.m_count;
+            _result.m_size = header.m_fileSize;
+            _result.m_cacheHit = true;
+        }
+    }
+
+    LevelResult BakeLevel(JobSystem& _jobSystem, const LevelSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("BakeLevel", _settings.m_input.string());
+        const Gltf::Document document = Gltf::Document::Load(_settings.m_input);
+        const auto& nodes = document.GetNodes();
+        const auto& meshes = document.GetMeshes();
+
+        LevelResult result;
+        result.m_output = _settings.m_output.empty() ? std::filesystem::path(_settings.m_input).replace_extension(".klvl") : _settings.m_output;
+        const std::filesystem::path outputDirectory = result.m_output.has_parent_path() ? result.m_output.parent_path() : std::filesystem::path(".");
+
+        CacheKey cacheKey;
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            cacheKey = MakeCacheKey(_jobSystem, document, _settings, result.m_output);
+            if (_settings.m_cache->Restore(cacheKey, outputDirectory))
+            {
+                Log::Verbose("%s: restored from cache (%s)", _settings.m_input.string().c_str(), cacheKey.ToString().c_str());
+                ReadRestoredStatistics(result);
+                return result;
+            }
+        }
+
+        // Flatten the hierarchy, depth first from the roots.
+        struct Instance
+        {
+            u32 m_node;
+            u32 m_mesh;
+            Affine m_transform;
+        };
+        std::vector<Instance> instances;
+        {
+            KT_TRACE_ZONE("FlattenHierarchy");
+            std::vector<bool> visited(nodes.size(), false);
+            std::vector<std::pair<u32, Affine>> stack;
+            const std::vector<u32> roots = FindRootNodes(document, _settings);
+            for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+            {
+                stack.emplace_back(*it, kIdentity);
+            }
+            while (!stack.empty())
+            {
+                const auto [index, parent] = stack.back();
+                stack.pop_back();
+                KT_VERIFY(!visited[index], "Node %u is reached twice, the node hierarchy must be a tree", index);
+                visited[index] = true;
+
+                const Gltf::Node& node = nodes[index];
+                const Affine world = Compose(parent, node.m_matrix);
+                if (node.m_mesh.has_value())
+                {
+                    instances.push_back({ index, *node.m_mesh, world });
+                }
+                for (auto it = node.m_children.rbegin(); it != node.m_children.rend(); ++it)
+                {
+                    stack.emplace_back(*it, world);
+                }
+            }
+        }
+
+        // Only the meshes referenced by the scene are analyzed, they may need decoding.
+        std::vector<u32> referencedMeshes;
+        std::vector<u32> meshSlots(meshes.size(), ~0u);
+        for (const Instance& instance: instances)
+        {
+            if (meshSlots[instance.m_mesh] == ~0u)
+            {
+                meshSlots[instance.m_mesh] = u32(referencedMeshes.size());
+                referencedMeshes.push_back(instance.m_mesh);
+            }
+        }
+        std::vector<MeshInfo> meshInfos(referencedMeshes.size());
+        _jobSystem.ParallelFor(referencedMeshes.size(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 i = _begin; i < _end; i++)
+            {
+                meshInfos[i] = AnalyzeMesh(document, meshes[referencedMeshes[i]]);
+            }
+        });
+
+        // Level meshes are the imported ones, in first reference order.
+        const std::vector<std::string> meshNames = GetMeshOutputNames(document, _settings.m_input);
+        std::vector<u32> levelMeshes(referencedMeshes.size(), ~0u);
+        std::vector<u32> levelMeshSources;
+        for (u32 i = 0; i < referencedMeshes.size(); i++)
+        {
+            if (meshInfos[i].m_imported)
+            {
+                levelMeshes[i] = u32(levelMeshSources.size());
+                levelMeshSources.push_back(i);
+            }
+            else
+            {
+                Log::Warning("Mesh '%s' has no triangle primitive, its instances are skipped", meshes[referencedMeshes[i]].m_name.c_str());
+            }
+        }
+        std::erase_if(instances, [&](const Instance& _instance) { return levelMeshes[meshSlots[_instance.m_mesh]] == ~0u; });
+
+        std::vector<Aabb> worldBounds(instances.size());
+        _jobSystem.ParallelFor(instances.size(), 1024, [&](u64 _begin, u64 _end)
+        {
+            for (u64 i = _begin; i < _end; i++)
+            {
+                worldBounds[i] = TransformBounds(instances[i].m_transform, meshInfos[meshSlots[instances[i].m_mesh]].m_bounds);
+            }
+        });
+        const Bvh bvh = BuildBvh(_jobSystem, worldBounds, _settings.m_bvhSettings);
+
+        // Instance arrays, in BVH leaf order.
+        KT_TRACE_ZONE("WriteLevel");
+        std::vector<LevelFormat::Transform> transforms(instances.size());
+        std::vector<LevelFormat::Bounds> bounds(instances.size());
+        std::vector<u32> instanceMeshes(instances.size());
+        std::vector<u32> instanceNodes(instances.size());
+        Aabb levelBounds;
+        for (u32 i = 0; i < instances.size(); i++)
+        {
+            const Instance& instance = instances[bvh.m_order[i]];
+            const Aabb& instanceBounds = worldBounds[bvh.m_order[i]];
+            for (u32 r = 0; r < 3; r++)
+            {
+                for (u32 c = 0; c < 4; c++)
+                {
+                    transforms[i].m_rows[r][c] = f32(instance.m_transform[r][c]);
+                }
+                bounds[i].m_min[r] = instanceBounds.m_min[r];
+                bounds[i].m_max[r] = instanceBounds.m_max[r];
+            }
+            instanceMeshes[i] = levelMeshes[meshSlots[instance.m_mesh]];
+            instanceNodes[i] = instance.m_node;
+            levelBounds.Expand(instanceBounds);
+        }
+
+        std::vector<LevelFormat::MeshRecord> meshRecords(levelMeshSources.size());
+        std::vector<u32> meshMaterials;
+        for (u32 i = 0; i < levelMeshSources.size(); i++)
+        {
+            const MeshInfo& info = meshInfos[levelMeshSources[i]];
+            meshRecords[i].m_firstMaterial = u32(meshMaterials.size());
+            meshRecords[i].m_materialCount = u32(info.m_materialSlots.size());
+            meshMaterials.insert(meshMaterials.end(), info.m_materialSlots.begin(), info.m_materialSlots.end());
+        }
+        const u32 materialCount = u32(document.GetMaterials().size());
+        const std::vector<LevelFormat::RelativeString> materialNames(materialCount);
+
+        LevelWriter writer;
+        const u64 transformsOffset = writer.Append(std::span<const LevelFormat::Transform>(transforms));
+        const u64 boundsOffset = writer.Append(std::span<const LevelFormat::Bounds>(bounds));
+        const u64 instanceMeshesOffset = writer.Append(std::span<const u32>(instanceMeshes));
+        const u64 instanceNodesOffset = writer.Append(std::span<const u32>(instanceNodes));
+        const u64 meshesOffset = writer.Append(std::span<const LevelFormat::MeshRecord>(meshRecords));
+        const u64 meshMaterialsOffset = writer.Append(std::span<const u32>(meshMaterials));
+        const u64 materialsOffset = writer.Append(std::span<const LevelFormat::RelativeString>(materialNames));
+        const u64 bvhNodesOffset = writer.Append(std::span<const LevelFormat::BvhNode>(bvh.m_nodes));
+
+        // Strings go last, so every link points forward.
+        for (u32 i = 0; i < levelMeshSources.size(); i++)
+        {
+            std::string path = meshNames[referencedMeshes[levelMeshSources[i]]];
+            if (!_settings.m_meshDirectory.empty())
+            {
+                path = (std::filesystem::path(_settings.m_meshDirectory) / path).generic_string();
+            }
+            const u64 fieldOffset = meshesOffset + i * sizeof(LevelFormat::MeshRecord) + offsetof(LevelFormat::MeshRecord, m_path);
+            writer.Link(fieldOffset, writer.AppendString(path), path.size());
+        }
+        for (u32 i = 0; i < materialCount; i++)
+        {
+            const std::string& name = document.GetMaterials()[i].m_name;
+            writer.Link(materialsOffset + i * sizeof(LevelFormat::RelativeString), writer.AppendString(name), name.size());
+        }
+
+        std::vector<u8>& data = writer.GetData();
+        KT_VERIFY(data.size() <= UINT32_MAX, "'%s': level exceeds 4 GiB", _settings.m_input.string().c_str());
+        LevelFormat::Header header {};
+        header.m_magic = LevelFormat::kMagic;
+        header.m_version = LevelFormat::kVersion;
+        header.m_headerSize = sizeof(LevelFormat::Header);
+        header.m_fileSize = data.size();
+        for (u32 c = 0; c < 3; c++)
+        {
+            header.m_boundsMin[c] = levelBounds.IsValid() ? levelBounds.m_min[c] : 0.f;
+            header.m_boundsMax[c] = levelBounds.IsValid() ? levelBounds.m_max[c] : 0.f;
+        }
+        std::memcpy(data.data(), &header, sizeof(header));
+        writer.Link(offsetof(LevelFormat::Header, m_transforms), transformsOffset, instances.size());
+        writer.Link(offsetof(LevelFormat::Header, m_bounds), boundsOffset, instances.size());
+        writer.Link(offsetof(LevelFormat::Header, m_instanceMeshes), instanceMeshesOffset, instances.size());
+        writer.Link(offsetof(LevelFormat::Header, m_instanceNodes), instanceNodesOffset, instances.size());
+        writer.Link(offsetof(LevelFormat::Header, m_meshes), meshesOffset, meshRecords.size());
+        writer.Link(offsetof(LevelFormat::Header, m_meshMaterials), meshMaterialsOffset, meshMaterials.size());
+        writer.Link(offsetof(LevelFormat::Header, m_materials), materialsOffset, materialCount);
+        writer.Link(offsetof(LevelFormat::Header, m_bvhNodes), bvhNodesOffset, bvh.m_nodes.size());
+
+        FileSystem::CreateParentDirectories(result.m_output);
+        FileSystem::WriteFile(result.m_output, data);
+
+        result.m_instanceCount = u32(instances.size());
+        result.m_meshCount = u32(meshRecords.size());
+        result.m_materialCount = materialCount;
+        result.m_bvhNodeCount = u32(bvh.m_nodes.size());
+        result.m_bvhDepth = bvh.m_depth;
+        result.m_bvhCost = bvh.m_cost;
+        result.m_size = data.size();
+
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            _settings.m_cache->Store(cacheKey, outputDirectory, std::span(&result.m_output, 1));
+        }
+        return result;
+    }
+
+    const LevelFormat::Header& OpenLevel(std::span<const u8> _data)
+    {
+        KT_VERIFY(_data.size() >= sizeof(LevelFormat::Header), "Truncated level header");
+        KT_VERIFY(reinterpret_cast<uintptr_t>(_data.data()) % LevelFormat::kAlignment == 0, "Level data is misaligned");
+        const LevelFormat::Header& header = *reinterpret_cast<const LevelFormat::Header*>(_data.data());
+        KT_VERIFY(header.m_magic == LevelFormat::kMagic, "Not a level file");
+        KT_VERIFY(header.m_version == LevelFormat::kVersion, "Unsupported level version %u", header.m_version);
+        KT_VERIFY(header.m_headerSize >= sizeof(LevelFormat::Header), "Truncated level header");
+        KT_VERIFY(header.m_fileSize <= _data.size(), "Truncated level, %llu bytes expected", static_cast<unsigned long long>(header.m_fileSize));
+        const std::span<const u8> file = _data.first(header.m_fileSize);
+
+        const u32 instanceCount = header.m_transforms.m_count;
+        KT_VERIFY(
+            header.m_bounds.m_count == instanceCount && header.m_instanceMeshes.m_count == instanceCount && header.m_instanceNodes.m_count == instanceCount,
+            "Level instance arrays differ in size");
+        CheckArray(file, header.m_transforms, "transform");
+        CheckArray(file, header.m_bounds, "bounds");
+
+        const u32 meshCount = header.m_meshes.m_count;
+        const u32* instanceMeshes = CheckArray(file, header.m_instanceMeshes, "instance mesh");
+        for (u32 i = 0; i < instanceCount; i++)
+        {
+            KT_VERIFY(instanceMeshes[i] < meshCount, "Instance %u references mesh %u of %u", i, instanceMeshes[i], meshCount);
+        }
+        CheckArray(file, header.m_instanceNodes, "instance node");
+
+        const LevelFormat::MeshRecord* meshes = CheckArray(file, header.m_meshes, "mesh");
+        for (u32 i = 0; i < meshCount; i++)
+        {
+            CheckString(file, meshes[i].m_path, "mesh path");
+            KT_VERIFY(
+                u64(meshes[i].m_firstMaterial) + meshes[i].m_materialCount <= header.m_meshMaterials.m_count,
+                "Mesh %u material slots are out of bounds",
+                i);
+        }
+
+        const u32 materialCount = header.m_materials.m_count;
+        const u32* meshMaterials = CheckArray(file, header.m_meshMaterials, "mesh material");
+        for (u32 i = 0; i < header.m_meshMaterials.m_count; i++)
+        {
+            KT_VERIFY(meshMaterials[i] < materialCount, "Material slot %u references material %u of %u", i, meshMaterials[i], materialCount);
+        }
+        const LevelFormat::RelativeString* materials = CheckArray(file, header.m_materials, "material");
+        for (u32 i = 0; i < materialCount; i++)
+        {
+            CheckString(file, materials[i], "material name");
+        }
+
+        const u32 nodeCount = header.m_bvhNodes.m_count;
+        KT_VERIFY((nodeCount == 0) == (instanceCount == 0), "Level BVH does not match its instances");
+        const LevelFormat::BvhNode* nodes = CheckArray(file, header.m_bvhNodes, "BVH node");
+        for (u32 i = 0; i < nodeCount; i++)
+        {
+            if (nodes[i].m_count == 0)
+            {
+                KT_VERIFY(i + 1 < nodeCount && nodes[i].m_offset > i + 1 && nodes[i].m_offset < nodeCount, "BVH node %u has invalid children", i);
+            }
+            else
+            {
+                KT_VERIFY(u64(nodes[i].m_offset) + nodes[i].m_count <= instanceCount, "BVH leaf %u is out of bounds", i);
+            }
+        }
+        return header;
+    }
+}
@@ -0,0 +1,322 @@
+#include "KryneTools/Level/LevelBvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kBinCount = 16;
+        /// Cost of visiting a node, relative to testing one instance.
+        constexpr f32 kTraversalCost = 2.f;
+        /// Subtrees of fewer instances are built on the thread that split them.
+        constexpr u32 kMinJobInstances = 1024;
+        /// Nodes of more instances bin them in parallel.
+        constexpr u32 kMinParallelBinInstances = 1u << 16;
+        /// From this depth on, nodes are split at their median instead, bounding the depth of skewed distributions.
+        constexpr u32 kMaxSahDepth = 48;
+
+        f32 GetSurfaceArea(const Aabb& _bounds)
+        {
+            if (!_bounds.IsValid())
+            {
+                return 0.f;
+            }
+            const Float3 extent = _bounds.GetExtent();
+            return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+        }
+
+        /// Node of the build tree, flattened depth first once complete.
+        struct BuildNode
+        {
+            Aabb m_bounds;
+            u32 m_begin = 0;
+            u32 m_count = 0;
+            /// Build node indices, `~0u` for leaves.
+            u32 m_children[2] = { ~0u, ~0u };
+        };
+
+        struct Bin
+        {
+            Aabb m_bounds;
+            Aabb m_centroidBounds;
+            u32 m_count = 0;
+        };
+
+        using Bins = std::array<Bin, kBinCount>;
+
+        class BvhBuilder
+        {
+        public:
+            BvhBuilder(JobSystem& _jobSystem, std::span<const Aabb> _bounds, const BvhSettings& _settings, std::vector<u32>& _order)
+                : m_jobSystem(_jobSystem)
+                , m_bounds(_bounds)
+                , m_maxLeafSize(_settings.m_maxLeafSize)
+                , m_order(_order)
+                , m_nodes(2 * _bounds.size())
+            {
+                m_centroids.reserve(_bounds.size());
+                for (const Aabb& bounds: _bounds)
+                {
+                    m_centroids.push_back(bounds.GetCenter());
+                }
+            }
+
+            void BuildRoot()
+            {
+                BuildNode& root = m_nodes[AllocateNode()];
+                root.m_begin = 0;
+                root.m_count = u32(m_bounds.size());
+                for (u32 i = 0; i < root.m_count; i++)
+                {
+                    root.m_bounds.Expand(m_bounds[i]);
+                }
+                Aabb centroidBounds;
+                for (const Float3& centroid: m_centroids)
+                {
+                    centroidBounds.Expand(centroid);
+                }
+                Split(0, centroidBounds, 0);
+            }
+
+            void Flatten(Bvh& _bvh) const
+            {
+                _bvh.m_nodes.reserve(m_nodeCount.load());
+                FlattenNode(_bvh, 0, 0);
+            }
+
+        private:
+            JobSystem& m_jobSystem;
+            std::span<const Aabb> m_bounds;
+            std::vector<Float3> m_centroids;
+            u32 m_maxLeafSize;
+            std::vector<u32>& m_order;
+            /// Binary trees over n leaves have at most 2n - 1 nodes, so allocating never reallocates.
+            std::vector<BuildNode> m_nodes;
+            std::atomic<u32> m_nodeCount = 0;
+
+            u32 AllocateNode()
+            {
+                return m_nodeCount.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void BinRange(u32 _begin, u32 _end, u32 _axis, f32 _origin, f32 _scale, Bins& _bins) const
+            {
+                for (u32 i = _begin; i < _end; i++)
+                {
+                    const u32 instance = m_order[i];
+                    const u32 bin = std::min(kBinCount - 1, u32((m_centroids[instance][_axis] - _origin) * _scale));
+                    _bins[bin].m_bounds.Expand(m_bounds[instance]);
+                    _bins[bin].m_centroidBounds.Expand(m_centroids[instance]);
+                    _bins[bin].m_count++;
+                }
+            }
+
+            /// Splits a node in two halves along the longest centroid axis.
+            u32 SplitMedian(const BuildNode& _node, u32 _axis, Aabb (&_childBounds)[2], Aabb (&_childCentroidBounds)[2]) const
+            {
+                u32* begin = m_order.data() + _node.m_begin;
+                const u32 leftCount = _node.m_count / 2;
+                std::nth_element(begin, begin + leftCount, begin + _node.m_count, [&](u32 _a, u32 _b)
+                {
+                    return m_centroids[_a][_axis] < m_centroids[_b][_axis];
+                });
+                for (u32 i = 0; i < _node.m_count; i++)
+                {
+                    _childBounds[i < leftCount ? 0 : 1].Expand(m_bounds[begin[i]]);
+                    _childCentroidBounds[i < leftCount ? 0 : 1].Expand(m_centroids[begin[i]]);
+                }
+                return leftCount;
+            }
+
+            /// Splits a node along the best binned SAH plane of its centroids, or leaves it a leaf.
+            void Split(u32 _nodeIndex, const Aabb& _centroidBounds, u32 _depth)
+            {
+                BuildNode& node = m_nodes[_nodeIndex];
+                const Float3 extent = _centroidBounds.GetExtent();
+                const u32 axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+                if (node.m_count <= 1)
+                {
+                    return;
+                }
+
+                // Coincident centroids can not be binned, halving the count is the only way to bound the leaf size.
+                Aabb childBounds[2];
+                Aabb childCentroidBounds[2];
+                if (_depth >= kMaxSahDepth || extent[axis] <= 0.f)
+                {
+                    if (node.m_count > m_maxLeafSize)
+                    {
+                        SplitChildren(_nodeIndex, SplitMedian(node, axis, childBounds, childCentroidBounds), childBounds, childCentroidBounds, _depth);
+                    }
+                    return;
+                }
+
+                const f32 origin = _centroidBounds.m_min[axis];
+                const f32 scale = f32(kBinCount) / extent[axis];
+                Bins bins {};
+                if (node.m_count >= kMinParallelBinInstances)
+                {
+                    std::mutex mutex;
+                    m_jobSystem.ParallelFor(node.m_count, kMinParallelBinInstances / 4, [&](u64 _begin, u64 _end)
+                    {
+                        Bins local {};
+                        BinRange(node.m_begin + u32(_begin), node.m_begin + u32(_end), axis, origin, scale, local);
+                        const std::lock_guard lock(mutex);
+                        for (u32 b = 0; b < kBinCount; b++)
+                        {
+                            bins[b].m_bounds.Expand(local[b].m_bounds);
+                            bins[b].m_centroidBounds.Expand(local[b].m_centroidBounds);
+                            bins[b].m_count += local[b].m_count;
+                        }
+                    });
+                }
+                else
+                {
+                    BinRange(node.m_begin, node.m_begin + node.m_count, axis, origin, scale, bins);
+                }
+
+                // Sweep from the right then from the left, evaluating the cost of splitting after each bin.
+                f32 rightCosts[kBinCount] {};
+                Aabb accumulated;
+                u32 count = 0;
+                for (u32 b = kBinCount - 1; b > 0; b--)
+                {
+                    accumulated.Expand(bins[b].m_bounds);
+                    count += bins[b].m_count;
+                    rightCosts[b] = GetSurfaceArea(accumulated) * f32(count);
+                }
+                u32 bestSplit = 0;
+                f32 bestCost = FLT_MAX;
+                accumulated = {};
+                count = 0;
+                for (u32 b = 0; b + 1 < kBinCount; b++)
+                {
+                    accumulated.Expand(bins[b].m_bounds);
+                    count += bins[b].m_count;
+                    const f32 cost = GetSurfaceArea(accumulated) * f32(count) + rightCosts[b + 1];
+                    if (count > 0 && count < node.m_count && cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestSplit = b + 1;
+                    }
+                }
+
+                const f32 area = GetSurfaceArea(node.m_bounds);
+                const f32 splitCost = kTraversalCost + (area > 0.f ? bestCost / area : 0.f);
+                if (bestSplit == 0 || (node.m_count <= m_maxLeafSize && splitCost >= f32(node.m_count)))
+                {
+                    return;
+                }
+
+                u32* begin = m_order.data() + node.m_begin;
+                u32* middle = std::partition(begin, begin + node.m_count, [&](u32 _instance)
+                {
+                    return std::min(kBinCount - 1, u32((m_centroids[_instance][axis] - origin) * scale)) < bestSplit;
+                });
+
+                // Bins already hold the bounds of both sides.
+                for (u32 b = 0; b < kBinCount; b++)
+                {
+                    childBounds[b < bestSplit ? 0 : 1].Expand(bins[b].m_bounds);
+                    childCentroidBounds[b < bestSplit ? 0 : 1].Expand(bins[b].m_centroidBounds);
+                }
+                SplitChildren(_nodeIndex, u32(middle - begin), childBounds, childCentroidBounds, _depth);
+            }
+
+            void SplitChildren(u32 _nodeIndex, u32 _leftCount, const Aabb (&_childBounds)[2], const Aabb (&_childCentroidBounds)[2], u32 _depth)
+            {
+                BuildNode& node = m_nodes[_nodeIndex];
+                const u32 childBegins[2] = { node.m_begin, node.m_begin + _leftCount };
+                const u32 childCounts[2] = { _leftCount, node.m_count - _leftCount };
+                for (u32 c = 0; c < 2; c++)
+                {
+                    const u32 childIndex = AllocateNode();
+                    BuildNode& child = m_nodes[childIndex];
+                    child.m_bounds = _childBounds[c];
+                    child.m_begin = childBegins[c];
+                    child.m_count = childCounts[c];
+                    node.m_children[c] = childIndex;
+                }
+
+                // The larger side is forked, the smaller one continues here.
+                const u32 forked = childCounts[0] >= childCounts[1] ? 0 : 1;
+                if (childCounts[forked] >= kMinJobInstances)
+                {
+                    JobGroup group;
+                    m_jobSystem.Spawn(group, [this, &node, &_childCentroidBounds, forked, _depth]
+                    {
+                        Split(node.m_children[forked], _childCentroidBounds[forked], _depth + 1);
+                    });
+                    Split(node.m_children[1 - forked], _childCentroidBounds[1 - forked], _depth + 1);
+                    m_jobSystem.Wait(group);
+                }
+                else
+                {
+                    Split(node.m_children[0], _childCentroidBounds[0], _depth + 1);
+                    Split(node.m_children[1], _childCentroidBounds[1], _depth + 1);
+                }
+            }
+
+            void FlattenNode(Bvh& _bvh, u32 _nodeIndex, u32 _depth) const
+            {
+                const BuildNode& node = m_nodes[_nodeIndex];
+                const u32 outputIndex = u32(_bvh.m_nodes.size());
+                _bvh.m_nodes.emplace_back();
+                _bvh.m_depth = std::max(_bvh.m_depth, _depth);
+
+                u32 offset = node.m_begin;
+                u32 count = node.m_count;
+                if (node.m_children[0] != ~0u)
+                {
+                    FlattenNode(_bvh, node.m_children[0], _depth + 1);
+                    offset = u32(_bvh.m_nodes.size());
+                    count = 0;
+                    FlattenNode(_bvh, node.m_children[1], _depth + 1);
+                }
+
+                LevelFormat::BvhNode& output = _bvh.m_nodes[outputIndex];
+                for (u32 c = 0; c < 3; c++)
+                {
+                    output.m_boundsMin[c] = node.m_bounds.m_min[c];
+                    output.m_boundsMax[c] = node.m_bounds.m_max[c];
+                }
+                output.m_offset = offset;
+                output.m_count = count;
+
+                // Expected cost of a ray or frustum query reaching the root, as the SAH models it.
+                const f32 rootArea = GetSurfaceArea(m_nodes[0].m_bounds);
+                const f32 probability = rootArea > 0.f ? GetSurfaceArea(node.m_bounds) / rootArea : 1.f;
+                _bvh.m_cost += probability * (count == 0 ? kTraversalCost : f32(count));
+            }
+        };
+    }
+
+    Bvh BuildBvh(JobSystem& _jobSystem, std::span<const Aabb> _bounds, const BvhSettings& _settings)
+    {
+        KT_TRACE_ZONE("BuildBvh");
+        KT_VERIFY(_settings.m_maxLeafSize > 0, "BVH leaves must hold at least one instance");
+        KT_VERIFY(_bounds.size() < UINT32_MAX / 2, "Too many instances for a BVH");
+
+        Bvh bvh;
+        if (_bounds.empty())
+        {
+            return bvh;
+        }
+        bvh.m_order.resize(_bounds.size());
+        std::iota(bvh.m_order.begin(), bvh.m_order.end(), 0u);
+
+        BvhBuilder builder(_jobSystem, _bounds, _settings, bvh.m_order);
+        builder.BuildRoot();
+        builder.Flatten(bvh);
+        return bvh;
+    }
+}
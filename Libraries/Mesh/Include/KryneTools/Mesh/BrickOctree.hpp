@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include "KryneTools/Common/Math.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Octree partition of a triangle set into bricks of bounded triangle count, for out-of-core processing.
+     *
+     * @details
+     * Built from two streaming passes over the triangles, so they never need to be in memory at once. The first pass
+     * counts triangle centroids on a uniform grid over a cube enclosing the bounds (`CountTriangle()`), then `Build()`
+     * subdivides the octree of the grid until every node holds at most the brick budget. Leaves are bricks, sibling
+     * leaves sharing one while they fit in the budget. The second pass maps each triangle to its brick (`FindBrick()`). The memory used is that of the grid,
+     * about 9 MiB at the default depth.
+     *
+     * Grid cells are the smallest bricks: a single cell holding more triangles than the budget stays over it.
+     * Bricks are numbered in octree (Morton) order, so consecutive bricks are neighbours.
+     */
+    class BrickOctree
+    {
+    public:
+        struct Brick
+        {
+            /// Bounds of its octree nodes, not of its triangles.
+            Aabb m_bounds {};
+            u64 m_triangleCount = 0;
+        };
+
+        /// 128 cells along each axis.
+        static constexpr u32 kDefaultDepth = 7;
+
+        explicit BrickOctree(const Aabb& _bounds, u32 _depth = kDefaultDepth);
+
+        /// Thread-safe, may be called concurrently until `Build()`.
+        void CountTriangle(const Float3& _p0, const Float3& _p1, const Float3& _p2);
+
+        void Build(u64 _maxTriangles);
+
+        /// Brick of a counted triangle. Only valid after `Build()`, and for the exact positions that were counted.
+        [[nodiscard]] u32 FindBrick(const Float3& _p0, const Float3& _p1, const Float3& _p2) const;
+
+        [[nodiscard]] const std::vector<Brick>& GetBricks() const { return m_bricks; }
+
+    private:
+        [[nodiscard]] u32 GetCell(const Float3& _p0, const Float3& _p1, const Float3& _p2) const;
+        [[nodiscard]] u32 GetCount(u32 _depth, u32 _x, u32 _y, u32 _z) const;
+        /// Splits an octree node over budget.
+        void Subdivide(u32 _depth, u32 _x, u32 _y, u32 _z, u64 _maxTriangles);
+        void AddToBrick(u32 _brick, u32 _depth, u32 _x, u32 _y, u32 _z);
+
+        Float3 m_origin {};
+        f32 m_size = 0.f;
+        f32 m_cellScale = 0.f;
+        u32 m_depth;
+        /// Triangle counts of every octree level, coarsest first. Released by `Build()`.
+        std::vector<std::vector<u32>> m_levels;
+        /// Brick of every grid cell, filled by `Build()`.
+        std::vector<u32> m_cellBricks;
+        std::vector<Brick> m_bricks;
+    };
+}
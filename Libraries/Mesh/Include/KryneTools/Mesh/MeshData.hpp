@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Common/Math.hpp"
+
+namespace KryneTools
+{
+    enum class VertexAttribute: u8
+    {
+        Position,
+        Normal,
+        Tangent,
+        TexCoord0,
+        TexCoord1,
+        Color0,
+        Joints0,
+        Weights0,
+        Count,
+    };
+
+    constexpr u32 AttributeBit(VertexAttribute _attribute)
+    {
+        return 1u << u32(_attribute);
+    }
+
+    /// Draw range of a mesh. Indices are relative to `m_vertexOffset`.
+    struct Submesh
+    {
+        u32 m_vertexOffset = 0;
+        u32 m_vertexCount = 0;
+        u32 m_indexOffset = 0;
+        u32 m_indexCount = 0;
+        u32 m_materialIndex = 0;
+        u32 m_meshletOffset = 0;
+        u32 m_meshletCount = 0;
+        /// Simplified levels of the submesh in `MeshData::m_lods`, finest first. The submesh itself is level 0.
+        u32 m_lodOffset = 0;
+        u32 m_lodCount = 0;
+        Aabb m_bounds {};
+    };
+
+    /// Index range of a simplified level, drawing a subset of the submesh vertices.
+    struct SubmeshLod
+    {
+        u32 m_indexOffset = 0;
+        u32 m_indexCount = 0;
+        /// Geometric deviation from level 0 (upper bound), in mesh units.
+        f32 m_error = 0.f;
+    };
+
+    struct Meshlet
+    {
+        /// First entry of the meshlet in `MeshletData::m_vertices`.
+        u32 m_vertexOffset = 0;
+        /// First byte of the meshlet in `MeshletData::m_triangles`, 4 bytes aligned.
+        u32 m_triangleOffset = 0;
+        u16 m_vertexCount = 0;
+        u16 m_triangleCount = 0;
+    };
+
+    /**
+     * @brief Meshlets of a mesh, stored as flat arrays indexed by meshlet.
+     *
+     * @details
+     * Meshlets of a submesh are contiguous, `Submesh::m_meshletOffset` and `m_meshletCount` locate them.
+     */
+    struct MeshletData
+    {
+        u32 m_maxVertices = 0;
+        u32 m_maxTriangles = 0;
+
+        std::vector<Meshlet> m_meshlets;
+        /// Bounding sphere of each meshlet: center and radius.
+        std::vector<Float4> m_spheres;
+        /**
+         * Normal cone of each meshlet: axis and cutoff. The meshlet is backfacing from `camera` when
+         * `dot(center - camera, axis) >= cutoff * length(center - camera) + radius`. A cutoff of 1 never culls.
+         */
+        std::vector<Float4> m_cones;
+        /// Mesh vertex index of every meshlet vertex.
+        std::vector<u32> m_vertices;
+        /// Three meshlet-local vertex indices per triangle.
+        std::vector<u8> m_triangles;
+
+        [[nodiscard]] bool IsEmpty() const { return m_meshlets.empty(); }
+    };
+
+    /**
+     * @brief In-memory mesh, as produced by importers and consumed by the processing stages and the writer.
+     *
+     * @details
+     * Attributes are stored as separate full precision streams (SoA), every present stream holds `m_vertexCount`
+     * elements. Submeshes own disjoint vertex and index ranges.
+     */
+    struct MeshData
+    {
+        static constexpr u32 kNoMaterial = ~0u;
+
+        std::string m_name;
+        u32 m_attributeMask = 0;
+        u32 m_vertexCount = 0;
+
+        std::vector<Float3> m_positions;
+        std::vector<Float3> m_normals;
+        std::vector<Float4> m_tangents;
+        std::array<std::vector<Float2>, 2> m_texCoords;
+        std::vector<Float4> m_colors;
+        std::vector<std::array<u16, 4>> m_joints;
+        std::vector<Float4> m_weights;
+
+        std::vector<u32> m_indices;
+        std::vector<Submesh> m_submeshes;
+        /// Empty unless built by `GenerateLods()`. Their indices follow those of every level 0 in `m_indices`.
+        std::vector<SubmeshLod> m_lods;
+        std::vector<std::string> m_materialNames;
+        /// Empty unless built by `BuildMeshlets()`.
+        MeshletData m_meshlets;
+        Aabb m_bounds {};
+
+        [[nodiscard]] bool HasAttribute(VertexAttribute _attribute) const
+        {
+            return (m_attributeMask & AttributeBit(_attribute)) != 0;
+        }
+
+        /// Allocates every stream flagged in `m_attributeMask` for `m_vertexCount` vertices.
+        void AllocateStreams();
+
+        /// Calls `_function(attribute, stream)` on every vertex stream, present or not.
+        template <class Function>
+        void VisitStreams(Function&& _function)
+        {
+            _function(VertexAttribute::Position, m_positions);
+            _function(VertexAttribute::Normal, m_normals);
+            _function(VertexAttribute::Tangent, m_tangents);
+            _function(VertexAttribute::TexCoord0, m_texCoords[0]);
+            _function(VertexAttribute::TexCoord1, m_texCoords[1]);
+            _function(VertexAttribute::Color0, m_colors);
+            _function(VertexAttribute::Joints0, m_joints);
+            _function(VertexAttribute::Weights0, m_weights);
+        }
+    };
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine runtime mesh files (`.kmesh`).
+ *
+ * A file is a fixed header followed by 16 bytes aligned sections and a section table, located by
+ * `Header::m_sectionTableOffset`. Every section is a flat array the runtime can upload or reference in place. Unknown
+ * section types must be ignored by readers, which is how the format gets extended without breaking older loaders.
+ *
+ * All values are little-endian.
+ */
+namespace KryneTools::MeshFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'M', 'S', 'H');
+    constexpr u16 kVersion = 1;
+    constexpr u64 kSectionAlignment = 16;
+
+    enum class SectionType: u32
+    {
+        Positions = 0,
+        Normals = 1,
+        Tangents = 2,
+        TexCoord0 = 3,
+        TexCoord1 = 4,
+        Color0 = 5,
+        Joints0 = 6,
+        Weights0 = 7,
+        Indices = 16,
+        Submeshes = 17,
+        /// String table (see `StringTableHeader`) of the material slot names, indexed by `SubmeshRecord::m_material`.
+        MaterialNames = 18,
+        /// String table with a single entry.
+        Name = 19,
+        /// Every meshlet array in a single block, see `MeshletSectionHeader`.
+        Meshlets = 20,
+        /// A `PositionQuantizationRecord`, present when positions are `SNorm16x4`.
+        PositionQuantization = 21,
+        /// `LodRecord` array, sorted by submesh then from the finest level. Their indices follow those of the submeshes.
+        Lods = 22,
+    };
+
+    enum class ElementFormat: u32
+    {
+        Float32x2 = 0,
+        Float32x3 = 1,
+        Float32x4 = 2,
+        UInt16x4 = 3,
+        /// Mesh relative positions, decoded with the `PositionQuantization` section. `w` is 0.
+        SNorm16x4 = 4,
+        /// Octahedral encoded unit vectors.
+        OctahedralSNorm16x2 = 5,
+        Float16x2 = 6,
+        /// `xyz` snorm10 and a 2 bits snorm `w`, from the low bits up.
+        SNorm10x3_2 = 7,
+        UInt16 = 16,
+        UInt32 = 17,
+        /// Section is an array of records, or has a structured layout described by its type.
+        Structured = 32,
+    };
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u32 m_vertexCount;
+        u32 m_indexCount;
+        u32 m_submeshCount;
+        u32 m_sectionCount;
+        u64 m_sectionTableOffset;
+        f32 m_boundsMin[3];
+        f32 m_boundsMax[3];
+    };
+    static_assert(sizeof(Header) == 56);
+
+    struct SectionEntry
+    {
+        SectionType m_type;
+        ElementFormat m_format;
+        u64 m_offset;
+        u64 m_size;
+    };
+    static_assert(sizeof(SectionEntry) == 24);
+
+    struct SubmeshRecord
+    {
+        u32 m_vertexOffset;
+        u32 m_vertexCount;
+        u32 m_indexOffset;
+        u32 m_indexCount;
+        /// Index in the `MaterialNames` table, `~0u` if the submesh has no material.
+        u32 m_material;
+        f32 m_boundsMin[3];
+        f32 m_boundsMax[3];
+    };
+    static_assert(sizeof(SubmeshRecord) == 44);
+
+    /// Simplified level of a submesh, drawn with the vertex range of the submesh.
+    struct LodRecord
+    {
+        u32 m_submesh;
+        u32 m_indexOffset;
+        u32 m_indexCount;
+        /// Geometric deviation from the submesh, in mesh units.
+        f32 m_error;
+    };
+    static_assert(sizeof(LodRecord) == 16);
+
+    /// `position = snorm / 32767 * m_scale + m_offset`, per component.
+    struct PositionQuantizationRecord
+    {
+        f32 m_offset[3];
+        f32 m_scale[3];
+    };
+
+    /// Header of a string table section, followed by `m_count + 1` u32 offsets then the character data.
+    struct StringTableHeader
+    {
+        u32 m_count;
+    };
+
+    /**
+     * @brief Header of the `Meshlets` section.
+     *
+     * @details
+     * Array offsets are relative to the section start and 16 bytes aligned, so the whole section can be uploaded as a
+     * single buffer and bound with offsets. Arrays, in order:
+     * - `MeshletRange[m_submeshCount]`, the meshlets of each submesh.
+     * - `MeshletRecord[m_meshletCount]`.
+     * - `f32[4][m_meshletCount]` bounding spheres: center, radius.
+     * - `f32[4][m_meshletCount]` normal cones: axis, cutoff (see `MeshletData::m_cones`).
+     * - `u32[m_vertexCount]` mesh vertex indices, absolute (submesh vertex offset included).
+     * - `u8[m_triangleByteCount]` meshlet-local triangle indices, each meshlet starting 4 bytes aligned.
+     */
+    struct MeshletSectionHeader
+    {
+        u32 m_meshletCount;
+        u32 m_vertexCount;
+        u32 m_triangleByteCount;
+        u16 m_maxVertices;
+        u16 m_maxTriangles;
+        u32 m_submeshCount;
+        u32 m_rangesOffset;
+        u32 m_meshletsOffset;
+        u32 m_spheresOffset;
+        u32 m_conesOffset;
+        u32 m_verticesOffset;
+        u32 m_trianglesOffset;
+        u32 m_reserved;
+    };
+    static_assert(sizeof(MeshletSectionHeader) == 48);
+
+    struct MeshletRange
+    {
+        u32 m_offset;
+        u32 m_count;
+    };
+
+    struct MeshletRecord
+    {
+        u32 m_vertexOffset;
+        u32 m_triangleOffset;
+        u16 m_vertexCount;
+        u16 m_triangleCount;
+    };
+    static_assert(sizeof(MeshletRecord) == 12);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <span>
+
+#include "KryneTools/Common/Math.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+    struct MeshData;
+
+    /// Post-transform cache efficiency of an index buffer, on a simulated FIFO cache.
+    struct VertexCacheStatistics
+    {
+        u64 m_triangleCount = 0;
+        /// Distinct vertices referenced by the indices.
+        u64 m_vertexCount = 0;
+        /// Vertex shader invocations, i.e. cache misses.
+        u64 m_transformedCount = 0;
+
+        /// Average cache miss ratio: transformed vertices per triangle, 0.5 at best on regular grids, 3 at worst.
+        [[nodiscard]] f64 GetAcmr() const { return m_triangleCount != 0 ? f64(m_transformedCount) / f64(m_triangleCount) : 0.0; }
+        /// Average transform to vertex ratio: transformed vertices per distinct vertex, 1 at best.
+        [[nodiscard]] f64 GetAtvr() const { return m_vertexCount != 0 ? f64(m_transformedCount) / f64(m_vertexCount) : 0.0; }
+
+        VertexCacheStatistics& operator+=(const VertexCacheStatistics& _other);
+    };
+
+    /// FIFO size used for reporting, in the range of current desktop GPUs.
+    constexpr u32 kDefaultAnalysisCacheSize = 16;
+
+    [[nodiscard]] VertexCacheStatistics AnalyzeVertexCache(std::span<const u32> _indices, u32 _vertexCount, u32 _cacheSize = kDefaultAnalysisCacheSize);
+
+    /**
+     * @brief Reorders triangles for the post-transform vertex cache, with Tom Forsyth's linear-speed algorithm.
+     *
+     * @details
+     * Runs in linear time on a 32 entries LRU cache model, which behaves well on the FIFO caches of actual hardware
+     * of any size, as the order does not tune for a single one.
+     */
+    void OptimizeVertexCache(std::span<u32> _indices, u32 _vertexCount);
+
+    /**
+     * @brief Reorders clusters of triangles so those facing outwards are drawn first, reducing overdraw.
+     *
+     * @details
+     * Follows Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw": indices must already
+     * be cache optimized. They are split in clusters at the points where the cache restarts from cold, and is
+     * allowed to split further as long as the ACMR stays within `_threshold` of the original one. Clusters are then
+     * sorted by how much they face away from the mesh center.
+     */
+    void OptimizeOverdraw(std::span<u32> _indices, std::span<const Float3> _positions, f32 _threshold);
+
+    /**
+     * @brief Builds the vertex permutation laying vertices out in the order indices first reference them.
+     * @param _remap Receives the new index of every vertex. Unreferenced vertices go last, in their original order.
+     */
+    void BuildVertexFetchRemap(std::span<const u32> _indices, std::span<u32> _remap);
+
+    struct MeshOptimizationSettings
+    {
+        /// ACMR degradation allowed to the overdraw pass, 1 to only keep the cold cache cluster boundaries.
+        f32 m_overdrawThreshold = 1.05f;
+    };
+
+    struct MeshOptimizationReport
+    {
+        VertexCacheStatistics m_before;
+        VertexCacheStatistics m_after;
+    };
+
+    /**
+     * @brief Optimizes every submesh for vertex cache, overdraw and vertex fetch, in that order.
+     *
+     * @details
+     * Only triangle and vertex orders change: the optimized mesh renders the same image. Simplified levels are
+     * optimized for vertex cache and overdraw too, the vertex order follows level 0. Submeshes are independent jobs.
+     */
+    MeshOptimizationReport OptimizeMesh(JobSystem& _jobSystem, MeshData& _mesh, const MeshOptimizationSettings& _settings = {});
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "KryneTools/Common/Math.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+    struct MeshData;
+
+    /**
+     * @brief Simplifies a triangle list with quadric error metric edge collapses, keeping a subset of its vertices.
+     *
+     * @details
+     * Follows Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", without moving vertices, so
+     * the result indexes the same vertex buffer. Vertices sharing a position under different indices are attribute
+     * seams (UV and normal splits): their sides only collapse together, along the seam, so no crack opens. Open borders
+     * only collapse along themselves and get extra edge quadrics to keep their shape. More tangled configurations are
+     * locked in place.
+     *
+     * Vertices with identical attributes should share one index beforehand, otherwise they read as seams.
+     *
+     * @param _positions Every vertex `_indices` may reference.
+     * @param _targetIndexCount Collapses stop once the output has at most this many indices.
+     * @param _maxError Deviation collapses stop at, relative to the largest extent of `_positions`.
+     * @param _lockBorders Keeps every open border vertex instead of collapsing along borders, so meshes cut from one
+     * surface still match along their cuts.
+     * @return The deviation reached, relative to the largest extent of `_positions`.
+     */
+    f32 SimplifyTriangles(
+        std::span<const u32> _indices,
+        std::span<const Float3> _positions,
+        u32 _targetIndexCount,
+        f32 _maxError,
+        std::vector<u32>& _output,
+        bool _lockBorders = false);
+
+    struct LodSettings
+    {
+        /// Simplified levels generated on top of the source, at most.
+        u32 m_levelCount = 4;
+        /// Triangle count target of each level, relative to the previous one.
+        f32 m_triangleRatio = 0.5f;
+        /// Deviation from the source no level may exceed, relative to the submesh extent.
+        f32 m_maxError = 0.05f;
+        /// See `SimplifyTriangles()`. Set on bricks of streamed meshes, whose cuts must stay crack free.
+        bool m_lockBorders = false;
+    };
+
+    /**
+     * @brief Generates the LOD chain of every submesh into `MeshData::m_lods`, with `SimplifyTriangles()`.
+     *
+     * @details
+     * Each level is simplified from the previous one, and errors are accumulated along the chain. The chain ends early
+     * when a level would not remove at least a tenth of the triangles, usually because the error budget ran out or
+     * everything left is locked.
+     *
+     * Submeshes are independent jobs. Meant to run before `OptimizeMesh()`, which reorders every level.
+     */
+    void GenerateLods(JobSystem& _jobSystem, MeshData& _mesh, const LodSettings& _settings = {});
+}
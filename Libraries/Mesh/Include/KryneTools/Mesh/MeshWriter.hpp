@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+
+#include "KryneTools/Mesh/MeshData.hpp"
+
+namespace KryneTools
+{
+    struct MeshWriteSettings
+    {
+        /**
+         * Packs positions to mesh relative snorm16, normals to octahedral snorm16, tangents to 10-10-10-2 and texture
+         * coordinates to half floats, about 2.3 times smaller than full precision on a typical mesh.
+         */
+        bool m_quantizeAttributes = false;
+        /**
+         * Frame positions are quantized in, the mesh bounds when invalid (the default). Meshes cut from one surface
+         * share the frame of the whole, so the vertices of their cuts decode to the same positions.
+         */
+        Aabb m_quantizationBounds {};
+    };
+
+    /**
+     * @brief Serializes a mesh to the runtime format described in `MeshFormat.hpp`.
+     *
+     * @details
+     * Indices are narrowed to 16 bits when every submesh fits, as they are relative to the submesh vertex offset.
+     */
+    void WriteMesh(const std::filesystem::path& _path, const MeshData& _mesh, const MeshWriteSettings& _settings = {});
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+    struct MeshData;
+
+    struct MeshletSettings
+    {
+        /// Mesh shader output limits. 64/124 lets the triangle indices of a meshlet fill whole 4 bytes words.
+        u32 m_maxVertices = 64;
+        u32 m_maxTriangles = 124;
+    };
+
+    /**
+     * @brief Splits every submesh in meshlets, with bounding spheres and normal cones, into `MeshData::m_meshlets`.
+     *
+     * @details
+     * Meshlets grow greedily from a seed triangle, adding the neighbouring triangle needing the fewest new vertices
+     * then the closest one, which keeps them compact for culling. Triangles are consumed in index order whenever a
+     * meshlet runs out of neighbours, so the input is best optimized for the vertex cache first.
+     *
+     * Submeshes are independent jobs.
+     */
+    void BuildMeshlets(JobSystem& _jobSystem, MeshData& _mesh, const MeshletSettings& _settings = {});
+}
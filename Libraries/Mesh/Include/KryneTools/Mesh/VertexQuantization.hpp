@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "KryneTools/Common/CpuFeatures.hpp"
+#include "KryneTools/Common/Math.hpp"
+
+namespace KryneTools
+{
+    /// Mesh relative position encoding: `position = snorm / 32767 * m_scale + m_offset`, per component.
+    struct PositionQuantization
+    {
+        Float3 m_offset;
+        Float3 m_scale;
+    };
+
+    /// Encoding mapping `_bounds` to the full snorm16 range.
+    [[nodiscard]] PositionQuantization ComputePositionQuantization(const Aabb& _bounds);
+
+    /**
+     * @brief Vertex attribute packing kernels of one SIMD level.
+     *
+     * @details
+     * Every level produces bit-identical output to the scalar reference, NaNs and denormals included: all of them
+     * round to nearest even and clamp with the same operand order. Kernels take arrays of `_count` elements.
+     */
+    struct QuantizationKernels
+    {
+        /// `xyz` floats to `xyzw` snorm16, `w` being 0. `_offset` and `_inverseScale` are `xyz` too.
+        void (*m_quantizePositions)(const f32* _positions, u64 _count, const f32* _offset, const f32* _inverseScale, s16* _output);
+        /// Unit `xyz` normals to octahedral `uv` snorm16.
+        void (*m_encodeOctahedral)(const f32* _normals, u64 _count, s16* _output);
+        /// Floats to IEEE half floats.
+        void (*m_packHalves)(const f32* _values, u64 _count, u16* _output);
+        /// `xyzw` tangents to snorm 10-10-10-2, the bitangent sign in the 2 bits of `w`.
+        void (*m_packTangents)(const f32* _tangents, u64 _count, u32* _output);
+    };
+
+    /// Kernels of `_level`, which must be supported by the running CPU.
+    [[nodiscard]] const QuantizationKernels& GetQuantizationKernels(SimdLevel _level);
+    /// Kernels of `GetSimdLevel()`.
+    [[nodiscard]] const QuantizationKernels& GetQuantizationKernels();
+
+    void QuantizePositions(std::span<const Float3> _positions, const PositionQuantization& _quantization, std::span<std::array<s16, 4>> _output);
+    void EncodeOctahedral(std::span<const Float3> _normals, std::span<std::array<s16, 2>> _output);
+    void PackHalves(std::span<const Float2> _values, std::span<std::array<u16, 2>> _output);
+    void PackTangents(std::span<const Float4> _tangents, std::span<u32> _output);
+}
@@ -0,0 +1,166 @@
+#include "KryneTools/Mesh/BrickOctree.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kNoBrick = ~0u;
+
+        u32 GetCellCoordinate(f32 _position, u32 _resolution)
+        {
+            // Negative, NaN and out of range coordinates all clamp to the grid.
+            if (!(_position >= 0.f))
+            {
+                return 0;
+            }
+            return _position < f32(_resolution) ? std::min(u32(_position), _resolution - 1) : _resolution - 1;
+        }
+    }
+
+    BrickOctree::BrickOctree(const Aabb& _bounds, u32 _depth)
+        : m_depth(_depth)
+    {
+        KT_VERIFY(_depth <= 10, "Brick octree depth %u is too large", _depth);
+
+        if (_bounds.IsValid())
+        {
+            const Float3 extent = _bounds.GetExtent();
+            m_origin = _bounds.m_min;
+            m_size = std::max(extent.x, std::max(extent.y, extent.z));
+        }
+        m_cellScale = m_size > 0.f ? f32(1u << _depth) / m_size : 0.f;
+
+        m_levels.resize(_depth + 1);
+        for (u32 d = 0; d <= _depth; d++)
+        {
+            m_levels[d].assign(size_t(1) << (3 * d), 0);
+        }
+    }
+
+    u32 BrickOctree::GetCell(const Float3& _p0, const Float3& _p1, const Float3& _p2) const
+    {
+        const Float3 centroid = (_p0 + _p1 + _p2) * (1.f / 3.f);
+        const Float3 cell = (centroid - m_origin) * m_cellScale;
+        const u32 resolution = 1u << m_depth;
+        const u32 x = GetCellCoordinate(cell.x, resolution);
+        const u32 y = GetCellCoordinate(cell.y, resolution);
+        const u32 z = GetCellCoordinate(cell.z, resolution);
+        return (z << (2 * m_depth)) | (y << m_depth) | x;
+    }
+
+    void BrickOctree::CountTriangle(const Float3& _p0, const Float3& _p1, const Float3& _p2)
+    {
+        std::atomic_ref<u32>(m_levels[m_depth][GetCell(_p0, _p1, _p2)]).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void BrickOctree::Build(u64 _maxTriangles)
+    {
+        for (u32 d = m_depth; d > 0; d--)
+        {
+            const u32 resolution = 1u << d;
+            const std::vector<u32>& fine = m_levels[d];
+            std::vector<u32>& coarse = m_levels[d - 1];
+            for (u32 z = 0; z < resolution; z++)
+            {
+                for (u32 y = 0; y < resolution; y++)
+                {
+                    for (u32 x = 0; x < resolution; x++)
+                    {
+                        const u32 count = fine[(size_t(z) << (2 * d)) | (size_t(y) << d) | x];
+                        u32& parent = coarse[(size_t(z >> 1) << (2 * (d - 1))) | (size_t(y >> 1) << (d - 1)) | (x >> 1)];
+                        KT_VERIFY(u64(parent) + count <= UINT32_MAX, "Too many triangles for a brick octree");
+                        parent += count;
+                    }
+                }
+            }
+        }
+
+        m_bricks.clear();
+        m_cellBricks.assign(m_levels[m_depth].size(), kNoBrick);
+        const u64 maxTriangles = std::max<u64>(_maxTriangles, 1);
+        const u32 count = GetCount(0, 0, 0, 0);
+        if (count > maxTriangles && m_depth > 0)
+        {
+            Subdivide(0, 0, 0, 0, maxTriangles);
+        }
+        else if (count != 0)
+        {
+            m_bricks.emplace_back();
+            AddToBrick(0, 0, 0, 0, 0);
+        }
+        m_levels.clear();
+    }
+
+    void BrickOctree::Subdivide(u32 _depth, u32 _x, u32 _y, u32 _z, u64 _maxTriangles)
+    {
+        // Children small enough become bricks, consecutive ones sharing a brick while they fit, so sparse regions
+        // give a few full bricks rather than many tiny ones.
+        u32 open = kNoBrick;
+        for (u32 child = 0; child < 8; child++)
+        {
+            const u32 depth = _depth + 1;
+            const u32 x = _x * 2 + (child & 1);
+            const u32 y = _y * 2 + ((child >> 1) & 1);
+            const u32 z = _z * 2 + (child >> 2);
+            const u32 count = GetCount(depth, x, y, z);
+            if (count == 0)
+            {
+                continue;
+            }
+            if (count > _maxTriangles && depth < m_depth)
+            {
+                open = kNoBrick;
+                Subdivide(depth, x, y, z, _maxTriangles);
+                continue;
+            }
+
+            if (open == kNoBrick || m_bricks[open].m_triangleCount + count > _maxTriangles)
+            {
+                open = u32(m_bricks.size());
+                m_bricks.emplace_back();
+            }
+            AddToBrick(open, depth, x, y, z);
+        }
+    }
+
+    u32 BrickOctree::GetCount(u32 _depth, u32 _x, u32 _y, u32 _z) const
+    {
+        return m_levels[_depth][(size_t(_z) << (2 * _depth)) | (size_t(_y) << _depth) | _x];
+    }
+
+    void BrickOctree::AddToBrick(u32 _brick, u32 _depth, u32 _x, u32 _y, u32 _z)
+    {
+        const f32 nodeSize = m_size / f32(1u << _depth);
+        Aabb bounds;
+        bounds.m_min = m_origin + Float3 { f32(_x), f32(_y), f32(_z) } * nodeSize;
+        bounds.m_max = bounds.m_min + Float3 { nodeSize, nodeSize, nodeSize };
+
+        Brick& brick = m_bricks[_brick];
+        brick.m_triangleCount += GetCount(_depth, _x, _y, _z);
+        brick.m_bounds.Expand(bounds);
+
+        const u32 span = 1u << (m_depth - _depth);
+        for (u32 z = _z * span; z < (_z + 1) * span; z++)
+        {
+            for (u32 y = _y * span; y < (_y + 1) * span; y++)
+            {
+                for (u32 x = _x * span; x < (_x + 1) * span; x++)
+                {
+                    m_cellBricks[(size_t(z) << (2 * m_depth)) | (size_t(y) << m_depth) | x] = _brick;
+                }
+            }
+        }
+    }
+
+    u32 BrickOctree::FindBrick(const Float3& _p0, const Float3& _p1, const Float3& _p2) const
+    {
+        const u32 brick = m_cellBricks[GetCell(_p0, _p1, _p2)];
+        KT_VERIFY(brick != kNoBrick, "Triangle outside of every brick, its positions changed since it was counted");
+        return brick;
+    }
+}
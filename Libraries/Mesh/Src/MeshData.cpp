@@ -0,0 +1,15 @@
+#include "KryneTools/Mesh/MeshData.hpp"
+
+namespace KryneTools
+{
+    void MeshData::AllocateStreams()
+    {
+        VisitStreams([this](VertexAttribute _attribute, auto& _stream)
+        {
+            if (HasAttribute(_attribute))
+            {
+                _stream.resize(m_vertexCount);
+            }
+        });
+    }
+}
@@ -0,0 +1,472 @@
+#include "KryneTools/Mesh/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "KryneTools/Common/Arena.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Mesh/MeshData.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kInvalidIndex = ~0u;
+
+        /// Forsyth's LRU cache model and score constants, as published.
+        constexpr u32 kCacheSize = 32;
+        constexpr f32 kCacheDecayPower = 1.5f;
+        constexpr f32 kLastTriangleScore = 0.75f;
+        constexpr f32 kValenceBoostScale = 2.0f;
+        constexpr f32 kValenceBoostPower = 0.5f;
+        constexpr u32 kValenceTableSize = 64;
+
+        /// Cache used to find the overdraw cluster boundaries, matching the reporting one.
+        constexpr u32 kClusterCacheSize = kDefaultAnalysisCacheSize;
+
+        struct ScoreTables
+        {
+            f32 m_cache[kCacheSize];
+            f32 m_valence[kValenceTableSize];
+
+            ScoreTables()
+            {
+                for (u32 i = 0; i < kCacheSize; i++)
+                {
+                    // The three vertices of the last triangle get a fixed score, so it is not directly reused.
+                    m_cache[i] = i < 3
+                        ? kLastTriangleScore
+                        : std::pow(1.0f - f32(i - 3) / f32(kCacheSize - 3), kCacheDecayPower);
+                }
+                m_valence[0] = 0.0f;
+                for (u32 i = 1; i < kValenceTableSize; i++)
+                {
+                    m_valence[i] = kValenceBoostScale * std::pow(f32(i), -kValenceBoostPower);
+                }
+            }
+
+            [[nodiscard]] f32 GetScore(u32 _cachePosition, u32 _liveTriangles) const
+            {
+                if (_liveTriangles == 0)
+                {
+                    return -1.0f;
+                }
+                const f32 cacheScore = _cachePosition < kCacheSize ? m_cache[_cachePosition] : 0.0f;
+                const f32 valenceScore = _liveTriangles < kValenceTableSize
+                    ? m_valence[_liveTriangles]
+                    : kValenceBoostScale * std::pow(f32(_liveTriangles), -kValenceBoostPower);
+                return cacheScore + valenceScore;
+            }
+        };
+
+        const ScoreTables g_scoreTables;
+
+        /// FIFO cache simulation, the reset being free thanks to timestamps.
+        class FifoCache
+        {
+        public:
+            FifoCache(u32 _vertexCount, u32 _cacheSize, const ScratchScope& _scratch)
+                : m_timestamps(_vertexCount, 0, _scratch)
+                , m_cacheSize(_cacheSize)
+                , m_time(_cacheSize + 1)
+            {}
+
+            /// @return `true` on a miss.
+            bool Access(u32 _vertex)
+            {
+                if (m_time - m_timestamps[_vertex] > m_cacheSize)
+                {
+                    m_timestamps[_vertex] = m_time++;
+                    return true;
+                }
+                return false;
+            }
+
+            void Reset() { m_time += m_cacheSize + 1; }
+
+        private:
+            ArenaVector<u32> m_timestamps;
+            u32 m_cacheSize;
+            u32 m_time;
+        };
+
+        template <class T>
+        void PermuteRange(std::vector<T>& _stream, u32 _offset, std::span<const u32> _remap)
+        {
+            if (_stream.empty())
+            {
+                return;
+            }
+            const ScratchScope scratch;
+            const std::span<T> permuted = scratch.GetArena().AllocateArray<T>(_remap.size());
+            for (size_t i = 0; i < _remap.size(); i++)
+            {
+                permuted[_remap[i]] = _stream[_offset + i];
+            }
+            std::copy(permuted.begin(), permuted.end(), _stream.begin() + _offset);
+        }
+    }
+
+    VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& _other)
+    {
+        m_triangleCount += _other.m_triangleCount;
+        m_vertexCount += _other.m_vertexCount;
+        m_transformedCount += _other.m_transformedCount;
+        return *this;
+    }
+
+    VertexCacheStatistics AnalyzeVertexCache(std::span<const u32> _indices, u32 _vertexCount, u32 _cacheSize)
+    {
+        VertexCacheStatistics statistics;
+        statistics.m_triangleCount = _indices.size() / 3;
+
+        const ScratchScope scratch;
+        FifoCache cache(_vertexCount, _cacheSize, scratch);
+        ArenaVector<u8> referenced(_vertexCount, 0, scratch);
+        for (const u32 index: _indices)
+        {
+            statistics.m_transformedCount += cache.Access(index) ? 1 : 0;
+            statistics.m_vertexCount += referenced[index] == 0 ? 1 : 0;
+            referenced[index] = 1;
+        }
+        return statistics;
+    }
+
+    void OptimizeVertexCache(std::span<u32> _indices, u32 _vertexCount)
+    {
+        const u32 triangleCount = u32(_indices.size() / 3);
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // Vertex to triangle adjacency, the live triangles of a vertex staying at the front of its range.
+        const ScratchScope scratch;
+        ArenaVector<u32> liveTriangles(_vertexCount, 0, scratch);
+        for (const u32 index: _indices)
+        {
+            liveTriangles[index]++;
+        }
+        ArenaVector<u32> adjacencyOffsets(_vertexCount + 1, 0, scratch);
+        std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+        ArenaVector<u32> adjacency(_indices.size(), scratch);
+        {
+            ArenaVector<u32> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1, scratch);
+            for (u32 i = 0; i < _indices.size(); i++)
+            {
+                adjacency[cursors[_indices[i]]++] = i / 3;
+            }
+        }
+
+        ArenaVector<u32> cachePositions(_vertexCount, kInvalidIndex, scratch);
+        ArenaVector<f32> vertexScores(_vertexCount, scratch);
+        for (u32 v = 0; v < _vertexCount; v++)
+        {
+            vertexScores[v] = g_scoreTables.GetScore(kInvalidIndex, liveTriangles[v]);
+        }
+
+        ArenaVector<f32> triangleScores(triangleCount, scratch);
+        ArenaVector<u8> emitted(triangleCount, 0, scratch);
+        u32 bestTriangle = 0;
+        for (u32 t = 0; t < triangleCount; t++)
+        {
+            triangleScores[t] = vertexScores[_indices[t * 3]] + vertexScores[_indices[t * 3 + 1]] + vertexScores[_indices[t * 3 + 2]];
+            if (triangleScores[t] > triangleScores[bestTriangle])
+            {
+                bestTriangle = t;
+            }
+        }
+
+        ArenaVector<u32> output(scratch);
+        output.reserve(_indices.size());
+
+        u32 cache[kCacheSize + 3];
+        u32 cacheCount = 0;
+        u32 scanCursor = 0;
+
+        for (u32 emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            if (bestTriangle == kInvalidIndex)
+            {
+                // Nothing left around the cache: restart from the next triangle in input order, keeping linear time.
+                while (emitted[scanCursor] != 0)
+                {
+                    scanCursor++;
+                }
+                bestTriangle = scanCursor;
+            }
+
+            const u32 triangle[3] = { _indices[bestTriangle * 3], _indices[bestTriangle * 3 + 1], _indices[bestTriangle * 3 + 2] };
+            output.insert(output.end(), std::begin(triangle), std::end(triangle));
+            emitted[bestTriangle] = 1;
+
+            for (const u32 vertex: triangle)
+            {
+                u32* begin = adjacency.data() + adjacencyOffsets[vertex];
+                u32* end = begin + liveTriangles[vertex];
+                u32* found = std::find(begin, end, bestTriangle);
+                std::swap(*found, *(end - 1));
+                liveTriangles[vertex]--;
+            }
+
+            // Move the triangle vertices to the front of the LRU, the others shift back.
+            u32 newCache[kCacheSize + 3];
+            u32 newCount = 0;
+            for (const u32 vertex: triangle)
+            {
+                if (std::find(newCache, newCache + newCount, vertex) == newCache + newCount)
+                {
+                    newCache[newCount++] = vertex;
+                }
+            }
+            for (u32 i = 0; i < cacheCount; i++)
+            {
+                if (std::find(newCache, newCache + newCount, cache[i]) == newCache + newCount)
+                {
+                    newCache[newCount++] = cache[i];
+                }
+            }
+
+            for (u32 i = 0; i < newCount; i++)
+            {
+                const u32 vertex = newCache[i];
+                cachePositions[vertex] = i < kCacheSize ? i : kInvalidIndex;
+                vertexScores[vertex] = g_scoreTables.GetScore(cachePositions[vertex], liveTriangles[vertex]);
+            }
+
+            // Only triangles around the touched vertices changed score, the best next one is among them.
+            bestTriangle = kInvalidIndex;
+            f32 bestScore = -1.0f;
+            for (u32 i = 0; i < newCount; i++)
+            {
+                const u32 vertex = newCache[i];
+                for (u32 j = 0; j < liveTriangles[vertex]; j++)
+                {
+                    const u32 t = adjacency[adjacencyOffsets[vertex] + j];
+                    triangleScores[t] = vertexScores[_indices[t * 3]] + vertexScores[_indices[t * 3 + 1]] + vertexScores[_indices[t * 3 + 2]];
+                    if (triangleScores[t] > bestScore)
+                    {
+                        bestScore = triangleScores[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            cacheCount = std::min(newCount, kCacheSize);
+            std::copy(newCache, newCache + cacheCount, cache);
+        }
+
+        std::copy(output.begin(), output.end(), _indices.begin());
+    }
+
+    void OptimizeOverdraw(std::span<u32> _indices, std::span<const Float3> _positions, f32 _threshold)
+    {
+        const u32 triangleCount = u32(_indices.size() / 3);
+        if (triangleCount == 0)
+        {
+            return;
+        }
+        const u32 vertexCount = u32(_positions.size());
+
+        // Hard boundaries: triangles missing the cache on all their vertices, where reordering costs nothing.
+        const ScratchScope scratch;
+        ArenaVector<u32> hardClusters(scratch);
+        {
+            FifoCache cache(vertexCount, kClusterCacheSize, scratch);
+            for (u32 t = 0; t < triangleCount; t++)
+            {
+                u32 misses = 0;
+                for (u32 k = 0; k < 3; k++)
+                {
+                    misses += cache.Access(_indices[t * 3 + k]) ? 1 : 0;
+                }
+                if (t == 0 || misses == 3)
+                {
+                    hardClusters.push_back(t);
+                }
+            }
+            hardClusters.push_back(triangleCount);
+        }
+
+        // Soft boundaries: restart from a cold cache wherever the running ACMR allows it within the threshold.
+        ArenaVector<u32> clusters(scratch);
+        {
+            FifoCache cache(vertexCount, kClusterCacheSize, scratch);
+            for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+            {
+                const u32 begin = hardClusters[c];
+                const u32 end = hardClusters[c + 1];
+
+                cache.Reset();
+                u32 clusterMisses = 0;
+                for (u32 i = begin * 3; i < end * 3; i++)
+                {
+                    clusterMisses += cache.Access(_indices[i]) ? 1 : 0;
+                }
+                const f32 maxAcmr = _threshold * f32(clusterMisses) / f32(end - begin);
+
+                cache.Reset();
+                clusters.push_back(begin);
+                u32 runningMisses = 0;
+                u32 runningTriangles = 0;
+                for (u32 t = begin; t < end; t++)
+                {
+                    for (u32 k = 0; k < 3; k++)
+                    {
+                        runningMisses += cache.Access(_indices[t * 3 + k]) ? 1 : 0;
+                    }
+                    runningTriangles++;
+                    if (t + 1 < end && f32(runningMisses) <= maxAcmr * f32(runningTriangles))
+                    {
+                        clusters.push_back(t + 1);
+                        cache.Reset();
+                        runningMisses = 0;
+                        runningTriangles = 0;
+                    }
+                }
+            }
+            clusters.push_back(triangleCount);
+        }
+
+        const u32 clusterCount = u32(clusters.size() - 1);
+        ArenaVector<Float3> centroids(clusterCount, scratch);
+        ArenaVector<Float3> normals(clusterCount, scratch);
+        Float3 meshCentroid {};
+        f32 meshArea = 0.0f;
+        for (u32 c = 0; c < clusterCount; c++)
+        {
+            Float3 centroid {};
+            Float3 normal {};
+            f32 area = 0.0f;
+            for (u32 t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const Float3& p0 = _positions[_indices[t * 3]];
+                const Float3& p1 = _positions[_indices[t * 3 + 1]];
+                const Float3& p2 = _positions[_indices[t * 3 + 2]];
+                const Float3 cross = Cross(p1 - p0, p2 - p0);
+                const f32 triangleArea = Length(cross);
+                centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += cross;
+                area += triangleArea;
+            }
+            meshCentroid += centroid;
+            meshArea += area;
+            centroids[c] = area > 0.0f ? centroid * (1.0f / area) : centroid;
+            normals[c] = normal;
+        }
+        if (meshArea > 0.0f)
+        {
+            meshCentroid = meshCentroid * (1.0f / meshArea);
+        }
+
+        ArenaVector<f32> keys(clusterCount, scratch);
+        for (u32 c = 0; c < clusterCount; c++)
+        {
+            const f32 length = Length(normals[c]);
+            keys[c] = length > 0.0f ? Dot(centroids[c] - meshCentroid, normals[c]) / length : 0.0f;
+        }
+
+        ArenaVector<u32> order(clusterCount, scratch);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](u32 _a, u32 _b) { return keys[_a] > keys[_b]; });
+
+        ArenaVector<u32> sorted(scratch);
+        sorted.reserve(_indices.size());
+        for (const u32 c: order)
+        {
+            sorted.insert(sorted.end(), _indices.begin() + clusters[c] * 3, _indices.begin() + clusters[c + 1] * 3);
+        }
+        std::copy(sorted.begin(), sorted.end(), _indices.begin());
+    }
+
+    void BuildVertexFetchRemap(std::span<const u32> _indices, std::span<u32> _remap)
+    {
+        std::fill(_remap.begin(), _remap.end(), kInvalidIndex);
+
+        u32 next = 0;
+        for (const u32 index: _indices)
+        {
+            if (_remap[index] == kInvalidIndex)
+            {
+                _remap[index] = next++;
+            }
+        }
+        for (u32& remap: _remap)
+        {
+            if (remap == kInvalidIndex)
+            {
+                remap = next++;
+            }
+        }
+    }
+
+    MeshOptimizationReport OptimizeMesh(JobSystem& _jobSystem, MeshData& _mesh, const MeshOptimizationSettings& _settings)
+    {
+        KT_TRACE_ZONE("OptimizeMesh");
+        std::vector<MeshOptimizationReport> reports(_mesh.m_submeshes.size());
+
+        _jobSystem.ParallelFor(_mesh.m_submeshes.size(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 s = _begin; s < _end; s++)
+            {
+                const Submesh& submesh = _mesh.m_submeshes[s];
+                const std::span<u32> indices(_mesh.m_indices.data() + submesh.m_indexOffset, submesh.m_indexCount);
+
+                reports[s].m_before = AnalyzeVertexCache(indices, submesh.m_vertexCount);
+
+                OptimizeVertexCache(indices, submesh.m_vertexCount);
+                if (_mesh.HasAttribute(VertexAttribute::Position))
+                {
+                    const std::span<const Float3> positions(_mesh.m_positions.data() + submesh.m_vertexOffset, submesh.m_vertexCount);
+                    OptimizeOverdraw(indices, positions, _settings.m_overdrawThreshold);
+                }
+
+                // Simplified levels draw subsets of the vertices, laid out for level 0.
+                for (u32 l = 0; l < submesh.m_lodCount; l++)
+                {
+                    const SubmeshLod& lod = _mesh.m_lods[submesh.m_lodOffset + l];
+                    const std::span<u32> lodIndices(_mesh.m_indices.data() + lod.m_indexOffset, lod.m_indexCount);
+                    OptimizeVertexCache(lodIndices, submesh.m_vertexCount);
+                    if (_mesh.HasAttribute(VertexAttribute::Position))
+                    {
+                        const std::span<const Float3> positions(_mesh.m_positions.data() + submesh.m_vertexOffset, submesh.m_vertexCount);
+                        OptimizeOverdraw(lodIndices, positions, _settings.m_overdrawThreshold);
+                    }
+                }
+
+                const ScratchScope scratch;
+                const std::span<u32> remap = scratch.GetArena().AllocateArray<u32>(submesh.m_vertexCount);
+                BuildVertexFetchRemap(indices, remap);
+                for (u32& index: indices)
+                {
+                    index = remap[index];
+                }
+                for (u32 l = 0; l < submesh.m_lodCount; l++)
+                {
+                    const SubmeshLod& lod = _mesh.m_lods[submesh.m_lodOffset + l];
+                    for (u32& index: std::span(_mesh.m_indices.data() + lod.m_indexOffset, lod.m_indexCount))
+                    {
+                        index = remap[index];
+                    }
+                }
+                _mesh.VisitStreams([&](VertexAttribute, auto& _stream)
+                {
+                    PermuteRange(_stream, submesh.m_vertexOffset, remap);
+                });
+
+                reports[s].m_after = AnalyzeVertexCache(indices, submesh.m_vertexCount);
+            }
+        });
+
+        MeshOptimizationReport report;
+        for (const MeshOptimizationReport& submeshReport: reports)
+        {
+            report.m_before += submeshReport.m_before;
+            report.m_after += submeshReport.m_after;
+        }
+        return report;
+    }
+}
@@ -0,0 +1,886 @@
+#include "KryneTools/Mesh/MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <numeric>
+
+#include "KryneTools/Common/Arena.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Mesh/MeshData.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kInvalidIndex = ~0u;
+        /// Open edge slot of a vertex with several open edges in the same direction.
+        constexpr u32 kManyEdges = ~0u - 1;
+
+        /// Open edges are weighted up so borders keep their outline. Seams only need a hint, their collapses are
+        /// already constrained.
+        constexpr f32 kBorderEdgeWeight = 10.f;
+        constexpr f32 kSeamEdgeWeight = 1.f;
+
+        constexpr u32 kSortBucketCount = 1u << 16;
+
+        /// A level must remove at least this fraction of the previous level triangles to be kept.
+        constexpr f64 kMinLodReduction = 0.1;
+
+        enum class VertexKind: u8
+        {
+            Manifold,
+            /// On an open border, with exactly one border edge in and one out.
+            Border,
+            /// One of the two sides of an attribute seam, each with one seam edge in and one out.
+            Seam,
+            /// Anything else: corners, non-manifold fans, seams meeting borders...
+            Locked,
+            Count,
+        };
+
+        constexpr u32 kKindCount = u32(VertexKind::Count);
+
+        /// Whether a vertex of the row kind may collapse onto a vertex of the column kind.
+        constexpr bool kCanCollapse[kKindCount][kKindCount] = {
+            { true, true, true, true },
+            { false, true, false, false },
+            { false, false, true, false },
+            { false, false, false, false },
+        };
+
+        /// Whether an edge between the two kinds is always found in both directions, so only needs to be seen once.
+        constexpr bool kHasOpposite[kKindCount][kKindCount] = {
+            { true, true, true, true },
+            { true, false, true, false },
+            { true, true, true, true },
+            { true, false, true, false },
+        };
+
+        inline bool IsSingleEdge(u32 _vertex)
+        {
+            return _vertex != kInvalidIndex && _vertex != kManyEdges;
+        }
+
+        inline bool IsOpenKind(VertexKind _kind)
+        {
+            return _kind == VertexKind::Border || _kind == VertexKind::Seam;
+        }
+
+        /// Sum of squared distances to a set of weighted planes, as a symmetric 4x4 matrix.
+        struct Quadric
+        {
+            f32 m_a00 = 0.f;
+            f32 m_a11 = 0.f;
+            f32 m_a22 = 0.f;
+            f32 m_a10 = 0.f;
+            f32 m_a20 = 0.f;
+            f32 m_a21 = 0.f;
+            f32 m_b0 = 0.f;
+            f32 m_b1 = 0.f;
+            f32 m_b2 = 0.f;
+            f32 m_c = 0.f;
+            f32 m_weight = 0.f;
+
+            /// Plane `dot(_normal, p) + _distance = 0`.
+            static Quadric FromPlane(const Float3& _normal, f32 _distance, f32 _weight)
+            {
+                Quadric quadric;
+                quadric.m_a00 = _weight * _normal.x * _normal.x;
+                quadric.m_a11 = _weight * _normal.y * _normal.y;
+                quadric.m_a22 = _weight * _normal.z * _normal.z;
+                quadric.m_a10 = _weight * _normal.y * _normal.x;
+                quadric.m_a20 = _weight * _normal.z * _normal.x;
+                quadric.m_a21 = _weight * _normal.z * _normal.y;
+                quadric.m_b0 = _weight * _normal.x * _distance;
+                quadric.m_b1 = _weight * _normal.y * _distance;
+                quadric.m_b2 = _weight * _normal.z * _distance;
+                quadric.m_c = _weight * _distance * _distance;
+                quadric.m_weight = _weight;
+                return quadric;
+            }
+
+            /// Triangle plane, weighted by the square root of the area to scale like the edge quadrics.
+            static Quadric FromTriangle(const Float3& _p0, const Float3& _p1, const Float3& _p2)
+            {
+                const Float3 cross = Cross(_p1 - _p0, _p2 - _p0);
+                const f32 area = Length(cross);
+                const Float3 normal = Normalize(cross);
+                return FromPlane(normal, -Dot(normal, _p0), std::sqrt(area));
+            }
+
+            /// Plane through the `_p0` `_p1` edge, orthogonal to the triangle, weighted by the edge length.
+            static Quadric FromTriangleEdge(const Float3& _p0, const Float3& _p1, const Float3& _p2, f32 _weight)
+            {
+                const Float3 edge = _p1 - _p0;
+                const f32 length = Length(edge);
+                const Float3 direction = Normalize(edge);
+                const Float3 toOpposite = _p2 - _p0;
+                const Float3 normal = Normalize(toOpposite - direction * Dot(toOpposite, direction));
+                return FromPlane(normal, -Dot(normal, _p0), length * _weight);
+            }
+
+            Quadric& operator+=(const Quadric& _other)
+            {
+                m_a00 += _other.m_a00;
+                m_a11 += _other.m_a11;
+                m_a22 += _other.m_a22;
+                m_a10 += _other.m_a10;
+                m_a20 += _other.m_a20;
+                m_a21 += _other.m_a21;
+                m_b0 += _other.m_b0;
+                m_b1 += _other.m_b1;
+                m_b2 += _other.m_b2;
+                m_c += _other.m_c;
+                m_weight += _other.m_weight;
+                return *this;
+            }
+
+            /// Weighted mean squared distance of `_p` to the planes.
+            [[nodiscard]] f32 Evaluate(const Float3& _p) const
+            {
+                const f32 rx = 2.f * (m_b0 + m_a10 * _p.y) + m_a00 * _p.x;
+                const f32 ry = 2.f * (m_b1 + m_a21 * _p.z) + m_a11 * _p.y;
+                const f32 rz = 2.f * (m_b2 + m_a20 * _p.x) + m_a22 * _p.z;
+                const f32 r = m_c + rx * _p.x + ry * _p.y + rz * _p.z;
+                return m_weight > 0.f ? std::fabs(r) / m_weight : 0.f;
+            }
+        };
+
+        /// Triangle corners around each vertex, as the two other corners in winding order.
+        class Adjacency
+        {
+        public:
+            struct Corner
+            {
+                u32 m_next;
+                u32 m_prev;
+            };
+
+            explicit Adjacency(const ScratchScope& _scratch)
+                : m_offsets(_scratch)
+                , m_cursors(_scratch)
+                , m_corners(_scratch)
+            {}
+
+            /// With `_remap`, vertices and corners are those of `_remap` instead of the indices.
+            void Build(std::span<const u32> _indices, u32 _vertexCount, const u32* _remap)
+            {
+                const auto map = [_remap](u32 _index) { return _remap != nullptr ? _remap[_index] : _index; };
+
+                m_offsets.assign(_vertexCount + 1, 0);
+                for (const u32 index: _indices)
+                {
+                    m_offsets[map(index) + 1]++;
+                }
+                std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+
+                m_cursors.assign(m_offsets.begin(), m_offsets.end() - 1);
+                m_corners.resize(_indices.size());
+                for (size_t i = 0; i < _indices.size(); i += 3)
+                {
+                    const u32 a = map(_indices[i]);
+                    const u32 b = map(_indices[i + 1]);
+                    const u32 c = map(_indices[i + 2]);
+                    m_corners[m_cursors[a]++] = { b, c };
+                    m_corners[m_cursors[b]++] = { c, a };
+                    m_corners[m_cursors[c]++] = { a, b };
+                }
+            }
+
+            [[nodiscard]] std::span<const Corner> Get(u32 _vertex) const
+            {
+                return { m_corners.data() + m_offsets[_vertex], m_offsets[_vertex + 1] - m_offsets[_vertex] };
+            }
+
+            [[nodiscard]] bool HasEdge(u32 _from, u32 _to) const
+            {
+                for (const Corner& corner: Get(_from))
+                {
+                    if (corner.m_next == _to)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            ArenaVector<u32> m_offsets;
+            ArenaVector<u32> m_cursors;
+            ArenaVector<Corner> m_corners;
+        };
+
+        struct Collapse
+        {
+            u32 m_from;
+            u32 m_to;
+            /// Set while picking, before the best direction is known.
+            bool m_bidirectional;
+            f32 m_error;
+        };
+
+        class Simplifier
+        {
+        public:
+            /// Every buffer comes from `_scratch`, the simplifier must not outlive it.
+            Simplifier(std::span<const u32> _indices, std::span<const Float3> _positions, bool _lockBorders, const ScratchScope& _scratch)
+                : m_scratch(_scratch)
+                , m_vertexCount(u32(_positions.size()))
+                , m_indices(_indices.begin(), _indices.end(), _scratch)
+                , m_positions(_scratch)
+                , m_remap(_scratch)
+                , m_wedge(_scratch)
+                , m_kinds(_scratch)
+                , m_loop(_scratch)
+                , m_loopBack(_scratch)
+                , m_quadrics(_scratch)
+                , m_adjacency(_scratch)
+                , m_histogram(_scratch)
+            {
+                BuildPositionRemap(_positions);
+                NormalizePositions(_positions);
+                ClassifyVertices(_lockBorders);
+                FillQuadrics();
+            }
+
+            /// @return The squared deviation reached, relative to the extent.
+            f32 Run(u32 _targetIndexCount, f32 _maxError)
+            {
+                const f32 errorLimit = _maxError * _maxError;
+                f32 resultError = 0.f;
+
+                ArenaVector<Collapse> collapses(m_scratch);
+                ArenaVector<u32> order(m_scratch);
+                ArenaVector<u32> collapseRemap(m_vertexCount, m_scratch);
+                ArenaVector<u8> collapseLocked(m_vertexCount, m_scratch);
+
+                while (m_indices.size() > _targetIndexCount)
+                {
+                    m_adjacency.Build(m_indices, m_vertexCount, m_remap.data());
+
+                    PickCollapses(collapses);
+                    if (collapses.empty())
+                    {
+                        break;
+                    }
+                    RankCollapses(collapses);
+
+                    SortCollapses(collapses, order);
+
+                    std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+                    std::fill(collapseLocked.begin(), collapseLocked.end(), u8(0));
+
+                    const u64 triangleGoal = (m_indices.size() - _targetIndexCount) / 3;
+                    const u32 performed = PerformCollapses(collapses, order, collapseRemap, collapseLocked, triangleGoal, errorLimit, resultError);
+                    if (performed == 0)
+                    {
+                        break;
+                    }
+
+                    RemapLoops(m_loop, collapseRemap);
+                    RemapLoops(m_loopBack, collapseRemap);
+                    RemapIndices(collapseRemap);
+                }
+                return resultError;
+            }
+
+            [[nodiscard]] ArenaVector<u32>& GetIndices() { return m_indices; }
+
+        private:
+            void NormalizePositions(std::span<const Float3> _positions)
+            {
+                Aabb bounds;
+                for (const Float3& position: _positions)
+                {
+                    bounds.Expand(position);
+                }
+                const Float3 extent = bounds.IsValid() ? bounds.GetExtent() : Float3 {};
+                const f32 maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+                const f32 scale = maxExtent > 0.f ? 1.f / maxExtent : 0.f;
+
+                m_positions.resize(_positions.size());
+                for (size_t i = 0; i < _positions.size(); i++)
+                {
+                    m_positions[i] = (_positions[i] - bounds.m_min) * scale;
+                }
+            }
+
+            /// Groups the referenced vertices by position: `m_remap` to the smallest index, `m_wedge` in a ring.
+            void BuildPositionRemap(std::span<const Float3> _positions)
+            {
+                ArenaVector<u8> referenced(m_vertexCount, 0, m_scratch);
+                for (const u32 index: m_indices)
+                {
+                    referenced[index] = 1;
+                }
+
+                m_remap.resize(m_vertexCount);
+                m_wedge.resize(m_vertexCount);
+                std::iota(m_remap.begin(), m_remap.end(), 0u);
+                std::iota(m_wedge.begin(), m_wedge.end(), 0u);
+
+                // Bitwise keys, with negative zeros folded, give a strict order even with NaNs around.
+                ArenaVector<std::array<u32, 3>> keys(m_vertexCount, m_scratch);
+                ArenaVector<u32> sorted(m_scratch);
+                for (u32 v = 0; v < m_vertexCount; v++)
+                {
+                    if (referenced[v] != 0)
+                    {
+                        const Float3 position = _positions[v] + Float3 {};
+                        std::memcpy(keys[v].data(), &position, sizeof(position));
+                        sorted.push_back(v);
+                    }
+                }
+                std::sort(sorted.begin(), sorted.end(), [&](u32 _a, u32 _b)
+                {
+                    return keys[_a] < keys[_b] || (keys[_a] == keys[_b] && _a < _b);
+                });
+
+                for (size_t begin = 0; begin < sorted.size();)
+                {
+                    size_t end = begin + 1;
+                    while (end < sorted.size() && keys[sorted[end]] == keys[sorted[begin]])
+                    {
+                        end++;
+                    }
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        m_remap[sorted[i]] = sorted[begin];
+                        m_wedge[sorted[i]] = sorted[i + 1 < end ? i + 1 : begin];
+                    }
+                    begin = end;
+                }
+            }
+
+            void ClassifyVertices(bool _lockBorders)
+            {
+                // Open edges are those of the index topology: seam edges are open on both sides.
+                m_adjacency.Build(m_indices, m_vertexCount, nullptr);
+                m_loop.assign(m_vertexCount, kInvalidIndex);
+                m_loopBack.assign(m_vertexCount, kInvalidIndex);
+                for (u32 v = 0; v < m_vertexCount; v++)
+                {
+                    for (const Adjacency::Corner& corner: m_adjacency.Get(v))
+                    {
+                        const u32 target = corner.m_next;
+                        if (!m_adjacency.HasEdge(target, v))
+                        {
+                            m_loop[v] = m_loop[v] == kInvalidIndex ? target : kManyEdges;
+                            m_loopBack[target] = m_loopBack[target] == kInvalidIndex ? v : kManyEdges;
+                        }
+                    }
+                }
+
+                m_kinds.assign(m_vertexCount, VertexKind::Locked);
+                for (u32 v = 0; v < m_vertexCount; v++)
+                {
+                    if (m_remap[v] != v)
+                    {
+                        continue;
+                    }
+
+                    const u32 w = m_wedge[v];
+                    VertexKind kind = VertexKind::Locked;
+                    if (w == v)
+                    {
+                        if (m_loop[v] == kInvalidIndex && m_loopBack[v] == kInvalidIndex)
+                        {
+                            kind = VertexKind::Manifold;
+                        }
+                        else if (IsSingleEdge(m_loop[v]) && IsSingleEdge(m_loopBack[v]) && !_lockBorders)
+                        {
+                            kind = VertexKind::Border;
+                        }
+                    }
+                    else if (m_wedge[w] == v)
+                    {
+                        // Both sides must have one open edge each way, the edges of one side mirroring the other.
+                        if (IsSingleEdge(m_loop[v]) && IsSingleEdge(m_loopBack[v]) && IsSingleEdge(m_loop[w]) && IsSingleEdge(m_loopBack[w])
+                            && m_remap[m_loopBack[v]] == m_remap[m_loop[w]]
+                            && m_remap[m_loop[v]] == m_remap[m_loopBack[w]]
+                            && m_remap[m_loopBack[v]] != m_remap[m_loop[v]])
+                        {
+                            kind = VertexKind::Seam;
+                        }
+                    }
+
+                    for (u32 wedge = v;; wedge = m_wedge[wedge])
+                    {
+                        m_kinds[wedge] = kind;
+                        if (m_wedge[wedge] == v)
+                        {
+                            break;
+                        }
+                    }
+                }
+
+                for (u32 v = 0; v < m_vertexCount; v++)
+                {
+                    if (!IsOpenKind(m_kinds[v]))
+                    {
+                        m_loop[v] = kInvalidIndex;
+                        m_loopBack[v] = kInvalidIndex;
+                    }
+                }
+            }
+
+            /// Whether the `_v0` to `_v1` edge follows the open loop of any open endpoint, which two open vertices
+            /// of different loops, or connected across the surface, would not.
+            [[nodiscard]] bool FollowsLoops(u32 _v0, u32 _v1) const
+            {
+                const VertexKind k0 = m_kinds[_v0];
+                const VertexKind k1 = m_kinds[_v1];
+                if (IsOpenKind(k0) && k1 != VertexKind::Manifold && m_loop[_v0] != _v1)
+                {
+                    return false;
+                }
+                if (IsOpenKind(k1) && k0 != VertexKind::Manifold && m_loopBack[_v1] != _v0)
+                {
+                    return false;
+                }
+                return true;
+            }
+
+            void FillQuadrics()
+            {
+                m_quadrics.assign(m_vertexCount, Quadric {});
+                for (size_t i = 0; i < m_indices.size(); i += 3)
+                {
+                    const u32 i0 = m_indices[i];
+                    const u32 i1 = m_indices[i + 1];
+                    const u32 i2 = m_indices[i + 2];
+                    const Quadric quadric = Quadric::FromTriangle(m_positions[i0], m_positions[i1], m_positions[i2]);
+                    m_quadrics[m_remap[i0]] += quadric;
+                    m_quadrics[m_remap[i1]] += quadric;
+                    m_quadrics[m_remap[i2]] += quadric;
+                }
+
+                for (size_t i = 0; i < m_indices.size(); i += 3)
+                {
+                    for (u32 e = 0; e < 3; e++)
+                    {
+                        const u32 i0 = m_indices[i + e];
+                        const u32 i1 = m_indices[i + (e + 1) % 3];
+                        const u32 i2 = m_indices[i + (e + 2) % 3];
+                        const VertexKind k0 = m_kinds[i0];
+                        const VertexKind k1 = m_kinds[i1];
+
+                        // Edges from an open vertex to a locked one count too, or the corners would get no error.
+                        if (!IsOpenKind(k0) && !IsOpenKind(k1))
+                        {
+                            continue;
+                        }
+                        if ((IsOpenKind(k0) && m_loop[i0] != i1) || (IsOpenKind(k1) && m_loopBack[i1] != i0))
+                        {
+                            continue;
+                        }
+                        if (kHasOpposite[u32(k0)][u32(k1)] && m_remap[i1] > m_remap[i0])
+                        {
+                            continue;
+                        }
+
+                        const f32 weight = k0 == VertexKind::Border || k1 == VertexKind::Border ? kBorderEdgeWeight : kSeamEdgeWeight;
+                        const Quadric quadric = Quadric::FromTriangleEdge(m_positions[i0], m_positions[i1], m_positions[i2], weight);
+                        m_quadrics[m_remap[i0]] += quadric;
+                        m_quadrics[m_remap[i1]] += quadric;
+                    }
+                }
+            }
+
+            void PickCollapses(ArenaVector<Collapse>& _collapses) const
+            {
+                _collapses.clear();
+                for (size_t i = 0; i < m_indices.size(); i += 3)
+                {
+                    for (u32 e = 0; e < 3; e++)
+                    {
+                        const u32 i0 = m_indices[i + e];
+                        const u32 i1 = m_indices[i + (e + 1) % 3];
+                        // Zero length edges are left alone, they usually hold complex topology together.
+                        if (m_remap[i0] == m_remap[i1])
+                        {
+                            continue;
+                        }
+
+                        const u32 k0 = u32(m_kinds[i0]);
+                        const u32 k1 = u32(m_kinds[i1]);
+                        const bool forward = kCanCollapse[k0][k1];
+                        const bool backward = kCanCollapse[k1][k0];
+                        if (!forward && !backward)
+                        {
+                            continue;
+                        }
+                        if (kHasOpposite[k0][k1] && m_remap[i1] > m_remap[i0])
+                        {
+                            continue;
+                        }
+                        if (!FollowsLoops(i0, i1))
+                        {
+                            continue;
+                        }
+
+                        if (forward && backward)
+                        {
+                            _collapses.push_back({ i0, i1, true, 0.f });
+                        }
+                        else
+                        {
+                            _collapses.push_back(forward ? Collapse { i0, i1, false, 0.f } : Collapse { i1, i0, false, 0.f });
+                        }
+                    }
+                }
+            }
+
+            void RankCollapses(ArenaVector<Collapse>& _collapses) const
+            {
+                for (Collapse& collapse: _collapses)
+                {
+                    const f32 forward = m_quadrics[m_remap[collapse.m_from]].Evaluate(m_positions[collapse.m_to]);
+                    const f32 backward = collapse.m_bidirectional
+                        ? m_quadrics[m_remap[collapse.m_to]].Evaluate(m_positions[collapse.m_from])
+                        : FLT_MAX;
+                    if (backward < forward)
+                    {
+                        std::swap(collapse.m_from, collapse.m_to);
+                    }
+                    collapse.m_error = std::min(forward, backward);
+                }
+            }
+
+            /// Counting sort on the 16 high bits of the errors, positive floats ordering as their bits. Ties keep
+            /// the picking order.
+            void SortCollapses(std::span<const Collapse> _collapses, ArenaVector<u32>& _order)
+            {
+                const auto key = [](f32 _error) { return std::bit_cast<u32>(_error) >> 16; };
+
+                m_histogram.assign(kSortBucketCount + 1, 0);
+                for (const Collapse& collapse: _collapses)
+                {
+                    m_histogram[key(collapse.m_error) + 1]++;
+                }
+                std::partial_sum(m_histogram.begin(), m_histogram.end(), m_histogram.begin());
+
+                _order.resize(_collapses.size());
+                for (u32 c = 0; c < _collapses.size(); c++)
+                {
+                    _order[m_histogram[key(_collapses[c].m_error)]++] = c;
+                }
+            }
+
+            /// Whether moving `_r0` onto `_r1` turns any remaining triangle around `_r0` over.
+            [[nodiscard]] bool HasTriangleFlips(std::span<const u32> _collapseRemap, u32 _r0, u32 _r1) const
+            {
+                const Float3& p0 = m_positions[_r0];
+                const Float3& p1 = m_positions[_r1];
+                for (const Adjacency::Corner& corner: m_adjacency.Get(_r0))
+                {
+                    const u32 a = _collapseRemap[corner.m_next];
+                    const u32 b = _collapseRemap[corner.m_prev];
+                    // Triangles collapsing with the edge, or which already collapsed this pass.
+                    if (m_remap[a] == _r1 || m_remap[b] == _r1 || m_remap[a] == m_remap[b])
+                    {
+                        continue;
+                    }
+                    const Float3 ab = m_positions[b] - m_positions[a];
+                    const Float3 before = Cross(ab, p0 - m_positions[a]);
+                    const Float3 after = Cross(ab, p1 - m_positions[a]);
+                    if (Dot(before, after) <= 0.f)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            u32 PerformCollapses(
+                std::span<const Collapse> _collapses,
+                std::span<const u32> _order,
+                std::span<u32> _collapseRemap,
+                std::span<u8> _collapseLocked,
+                u64 _triangleGoal,
+                f32 _errorLimit,
+                f32& _resultError)
+            {
+                // Manifold collapses remove two triangles. Locked candidates will be skipped, so the pass error goal
+                // is taken a bit above the error of the last collapse needed. Past it, the pass still goes on until half
+                // the goal is reached, fewer passes doing no measurable harm to the result.
+                u64 edgeGoal = _triangleGoal / 2;
+                const f32 errorGoal = edgeGoal < _order.size() ? 1.5f * _collapses[_order[edgeGoal]].m_error : FLT_MAX;
+
+                u32 performed = 0;
+                u64 removedTriangles = 0;
+                for (const u32 c: _order)
+                {
+                    const Collapse& collapse = _collapses[c];
+                    const u32 i0 = collapse.m_from;
+                    const u32 i1 = collapse.m_to;
+                    const u32 r0 = m_remap[i0];
+                    const u32 r1 = m_remap[i1];
+
+                    if (_collapseLocked[r0] != 0 || _collapseLocked[r1] != 0)
+                    {
+                        continue;
+                    }
+                    if (collapse.m_error > _errorLimit || removedTriangles >= _triangleGoal)
+                    {
+                        break;
+                    }
+                    if (collapse.m_error > errorGoal && removedTriangles > _triangleGoal / 2)
+                    {
+                        break;
+                    }
+                    if (HasTriangleFlips(_collapseRemap, r0, r1))
+                    {
+                        // Does not count towards the goal the error limit was picked for.
+                        edgeGoal++;
+                        continue;
+                    }
+
+                    if (m_kinds[i0] == VertexKind::Seam)
+                    {
+                        // Collapse the other side along the mirrored seam edge.
+                        const u32 s0 = m_wedge[i0];
+                        const u32 s1 = m_loop[i0] == i1 ? m_loopBack[s0] : m_loop[s0];
+                        if (!IsSingleEdge(s1) || m_remap[s1] != r1)
+                        {
+                            continue;
+                        }
+                        _collapseRemap[i0] = i1;
+                        _collapseRemap[s0] = s1;
+                    }
+                    else
+                    {
+                        for (u32 wedge = i0;; wedge = m_wedge[wedge])
+                        {
+                            _collapseRemap[wedge] = i1;
+                            if (m_wedge[wedge] == i0)
+                            {
+                                break;
+                            }
+                        }
+                    }
+
+                    _collapseLocked[r0] = 1;
+                    _collapseLocked[r1] = 1;
+                    m_quadrics[r1] += m_quadrics[r0];
+
+                    removedTriangles += m_kinds[i0] == VertexKind::Border ? 1 : 2;
+                    performed++;
+                    _resultError = std::max(_resultError, collapse.m_error);
+                }
+                return performed;
+            }
+
+            static void RemapLoops(std::span<u32> _loop, std::span<const u32> _collapseRemap)
+            {
+                for (u32 v = 0; v < _loop.size(); v++)
+                {
+                    const u32 target = _loop[v];
+                    if (target != kInvalidIndex)
+                    {
+                        // A seam may collapse against the direction of the loop, which then skips the collapsed vertex.
+                        const u32 remapped = _collapseRemap[target];
+                        _loop[v] = remapped == v ? _loop[target] : remapped;
+                    }
+                }
+            }
+
+            void RemapIndices(std::span<const u32> _collapseRemap)
+            {
+                size_t write = 0;
+                for (size_t i = 0; i < m_indices.size(); i += 3)
+                {
+                    const u32 a = _collapseRemap[m_indices[i]];
+                    const u32 b = _collapseRemap[m_indices[i + 1]];
+                    const u32 c = _collapseRemap[m_indices[i + 2]];
+                    if (a != b && b != c && c != a)
+                    {
+                        m_indices[write++] = a;
+                        m_indices[write++] = b;
+                        m_indices[write++] = c;
+                    }
+                }
+                m_indices.resize(write);
+            }
+
+            const ScratchScope& m_scratch;
+            u32 m_vertexCount;
+            ArenaVector<u32> m_indices;
+            ArenaVector<Float3> m_positions;
+            ArenaVector<u32> m_remap;
+            ArenaVector<u32> m_wedge;
+            ArenaVector<VertexKind> m_kinds;
+            /// Next and previous vertex along the open edge loop, for border and seam vertices.
+            ArenaVector<u32> m_loop;
+            ArenaVector<u32> m_loopBack;
+            ArenaVector<Quadric> m_quadrics;
+            Adjacency m_adjacency;
+            ArenaVector<u32> m_histogram;
+        };
+
+        /// Maps every vertex of the submesh to the first one with the exact same attributes.
+        ArenaVector<u32> BuildAttributeRemap(MeshData& _mesh, const Submesh& _submesh, const ScratchScope& _scratch)
+        {
+            const u32 offset = _submesh.m_vertexOffset;
+            const auto equal = [&](u32 _a, u32 _b)
+            {
+                bool result = true;
+                _mesh.VisitStreams([&](VertexAttribute _attribute, const auto& _stream)
+                {
+                    if (result && _mesh.HasAttribute(_attribute))
+                    {
+                        result = std::memcmp(&_stream[offset + _a], &_stream[offset + _b], sizeof(_stream[0])) == 0;
+                    }
+                });
+                return result;
+            };
+
+            ArenaVector<u64> hashes(_submesh.m_vertexCount, _scratch);
+            for (u32 v = 0; v < _submesh.m_vertexCount; v++)
+            {
+                Hasher64 hasher;
+                _mesh.VisitStreams([&](VertexAttribute _attribute, const auto& _stream)
+                {
+                    if (_mesh.HasAttribute(_attribute))
+                    {
+                        hasher.UpdatePod(_stream[offset + v]);
+                    }
+                });
+                hashes[v] = hasher.Finalize();
+            }
+
+            ArenaVector<u32> sorted(_submesh.m_vertexCount, _scratch);
+            std::iota(sorted.begin(), sorted.end(), 0u);
+            std::sort(sorted.begin(), sorted.end(), [&](u32 _a, u32 _b)
+            {
+                return hashes[_a] < hashes[_b] || (hashes[_a] == hashes[_b] && _a < _b);
+            });
+
+            ArenaVector<u32> remap(_submesh.m_vertexCount, _scratch);
+            u32 leader = kInvalidIndex;
+            for (const u32 v: sorted)
+            {
+                // A hash collision only splits a group, which costs a seam, never a wrong merge.
+                if (leader == kInvalidIndex || hashes[leader] != hashes[v] || !equal(leader, v))
+                {
+                    leader = v;
+                }
+                remap[v] = leader;
+            }
+            return remap;
+        }
+
+        f32 GetMaxExtent(std::span<const Float3> _positions)
+        {
+            Aabb bounds;
+            for (const Float3& position: _positions)
+            {
+                bounds.Expand(position);
+            }
+            if (!bounds.IsValid())
+            {
+                return 0.f;
+            }
+            const Float3 extent = bounds.GetExtent();
+            return std::max(extent.x, std::max(extent.y, extent.z));
+        }
+    }
+
+    f32 SimplifyTriangles(
+        std::span<const u32> _indices,
+        std::span<const Float3> _positions,
+        u32 _targetIndexCount,
+        f32 _maxError,
+        std::vector<u32>& _output,
+        bool _lockBorders)
+    {
+        KT_TRACE_ZONE("SimplifyTriangles");
+        KT_VERIFY(_indices.size() % 3 == 0, "Index count %zu is not a multiple of 3", _indices.size());
+
+        if (_indices.size() <= _targetIndexCount)
+        {
+            _output.assign(_indices.begin(), _indices.end());
+            return 0.f;
+        }
+
+        const ScratchScope scratch;
+        Simplifier simplifier(_indices, _positions, _lockBorders, scratch);
+        const f32 error = simplifier.Run(_targetIndexCount, _maxError);
+        _output.assign(simplifier.GetIndices().begin(), simplifier.GetIndices().end());
+        return std::sqrt(error);
+    }
+
+    void GenerateLods(JobSystem& _jobSystem, MeshData& _mesh, const LodSettings& _settings)
+    {
+        KT_TRACE_ZONE("GenerateLods");
+        KT_VERIFY(
+            _settings.m_triangleRatio > 0.f && _settings.m_triangleRatio < 1.f,
+            "Invalid LOD triangle ratio %g, must be within ]0, 1[",
+            _settings.m_triangleRatio);
+        KT_VERIFY(_mesh.HasAttribute(VertexAttribute::Position), "Mesh '%s' has no position", _mesh.m_name.c_str());
+
+        struct SubmeshChain
+        {
+            std::vector<SubmeshLod> m_lods;
+            std::vector<u32> m_indices;
+        };
+        std::vector<SubmeshChain> chains(_mesh.m_submeshes.size());
+
+        _jobSystem.ParallelFor(_mesh.m_submeshes.size(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 s = _begin; s < _end; s++)
+            {
+                const Submesh& submesh = _mesh.m_submeshes[s];
+                const std::span<const Float3> positions(_mesh.m_positions.data() + submesh.m_vertexOffset, submesh.m_vertexCount);
+                const f32 extent = GetMaxExtent(positions);
+
+                const ScratchScope scratch;
+                const ArenaVector<u32> attributeRemap = BuildAttributeRemap(_mesh, submesh, scratch);
+                std::vector<u32> current(submesh.m_indexCount);
+                for (u32 i = 0; i < submesh.m_indexCount; i++)
+                {
+                    current[i] = attributeRemap[_mesh.m_indices[submesh.m_indexOffset + i]];
+                }
+
+                SubmeshChain& chain = chains[s];
+                f32 error = 0.f;
+                std::vector<u32> simplified;
+                for (u32 level = 0; level < _settings.m_levelCount; level++)
+                {
+                    const u32 targetIndexCount = u32(f64(current.size() / 3) * _settings.m_triangleRatio) * 3;
+                    const f32 levelError = SimplifyTriangles(current, positions, targetIndexCount, std::max(_settings.m_maxError - error, 0.f), simplified, _settings.m_lockBorders);
+                    if (simplified.empty() || f64(simplified.size()) > f64(current.size()) * (1.0 - kMinLodReduction))
+                    {
+                        break;
+                    }
+
+                    error += levelError;
+                    chain.m_lods.push_back({ u32(chain.m_indices.size()), u32(simplified.size()), error * extent });
+                    chain.m_indices.insert(chain.m_indices.end(), simplified.begin(), simplified.end());
+                    current.swap(simplified);
+                }
+            }
+        });
+
+        _mesh.m_lods.clear();
+        for (size_t s = 0; s < chains.size(); s++)
+        {
+            Submesh& submesh = _mesh.m_submeshes[s];
+            submesh.m_lodOffset = u32(_mesh.m_lods.size());
+            submesh.m_lodCount = u32(chains[s].m_lods.size());
+
+            const u32 indexOffset = u32(_mesh.m_indices.size());
+            for (SubmeshLod lod: chains[s].m_lods)
+            {
+                lod.m_indexOffset += indexOffset;
+                _mesh.m_lods.push_back(lod);
+            }
+            _mesh.m_indices.insert(_mesh.m_indices.end(), chains[s].m_indices.begin(), chains[s].m_indices.end());
+        }
+    }
+}
@@ -0,0 +1,314 @@
+#include "KryneTools/Mesh/MeshWriter.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <string>
+
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Mesh/MeshFormat.hpp"
+#include "KryneTools/Mesh/VertexQuantization.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        class SectionWriter
+        {
+        public:
+            explicit SectionWriter(FileWriter& _writer)
+                : m_writer(_writer)
+            {}
+
+            template <class T>
+            void Add(MeshFormat::SectionType _type, MeshFormat::ElementFormat _format, std::span<const T> _data)
+            {
+                Begin();
+                m_writer.WriteSpan(_data);
+                End(_type, _format);
+            }
+
+            /// Writes `_data` converted to `Narrow`, through a small bounce buffer rather than a full copy.
+            template <class Narrow, class T>
+            void AddNarrowed(MeshFormat::SectionType _type, MeshFormat::ElementFormat _format, std::span<const T> _data)
+            {
+                Begin();
+                Narrow buffer[4096];
+                for (size_t offset = 0; offset < _data.size(); offset += std::size(buffer))
+                {
+                    const size_t count = std::min(std::size(buffer), _data.size() - offset);
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        buffer[i] = Narrow(_data[offset + i]);
+                    }
+                    m_writer.Write(buffer, count * sizeof(Narrow));
+                }
+                End(_type, _format);
+            }
+
+            /// Writes `_data` packed by `_pack(input, output)` on spans, through a small bounce buffer.
+            template <class Packed, class T, class Function>
+            void AddPacked(MeshFormat::SectionType _type, MeshFormat::ElementFormat _format, std::span<const T> _data, Function&& _pack)
+            {
+                Begin();
+                Packed buffer[4096];
+                for (size_t offset = 0; offset < _data.size(); offset += std::size(buffer))
+                {
+                    const size_t count = std::min(std::size(buffer), _data.size() - offset);
+                    _pack(_data.subspan(offset, count), std::span<Packed>(buffer, count));
+                    m_writer.Write(buffer, count * sizeof(Packed));
+                }
+                End(_type, _format);
+            }
+
+            void AddStringTable(MeshFormat::SectionType _type, std::span<const std::string> _strings)
+            {
+                Begin();
+                m_writer.WritePod(MeshFormat::StringTableHeader { u32(_strings.size()) });
+                u32 offset = 0;
+                for (const std::string& string: _strings)
+                {
+                    m_writer.WritePod(offset);
+                    offset += u32(string.size());
+                }
+                m_writer.WritePod(offset);
+                for (const std::string& string: _strings)
+                {
+                    m_writer.Write(string.data(), string.size());
+                }
+                End(_type, MeshFormat::ElementFormat::Structured);
+            }
+
+            void AddMeshlets(const MeshletData& _meshlets, std::span<const Submesh> _submeshes)
+            {
+                Begin();
+
+                MeshFormat::MeshletSectionHeader header {};
+                header.m_meshletCount = u32(_meshlets.m_meshlets.size());
+                header.m_vertexCount = u32(_meshlets.m_vertices.size());
+                header.m_triangleByteCount = u32(_meshlets.m_triangles.size());
+                header.m_maxVertices = u16(_meshlets.m_maxVertices);
+                header.m_maxTriangles = u16(_meshlets.m_maxTriangles);
+                header.m_submeshCount = u32(_submeshes.size());
+                m_writer.WritePod(header);
+
+                const auto beginArray = [this]
+                {
+                    m_writer.Align(MeshFormat::kSectionAlignment);
+                    return u32(m_writer.Tell() - m_sectionStart);
+                };
+
+                header.m_rangesOffset = beginArray();
+                for (const Submesh& submesh: _submeshes)
+                {
+                    m_writer.WritePod(MeshFormat::MeshletRange { submesh.m_meshletOffset, submesh.m_meshletCount });
+                }
+
+                header.m_meshletsOffset = beginArray();
+                for (const Meshlet& meshlet: _meshlets.m_meshlets)
+                {
+                    m_writer.WritePod(MeshFormat::MeshletRecord { meshlet.m_vertexOffset, meshlet.m_triangleOffset, meshlet.m_vertexCount, meshlet.m_triangleCount });
+                }
+
+                header.m_spheresOffset = beginArray();
+                m_writer.WriteSpan(std::span(_meshlets.m_spheres));
+                header.m_conesOffset = beginArray();
+                m_writer.WriteSpan(std::span(_meshlets.m_cones));
+                header.m_verticesOffset = beginArray();
+                m_writer.WriteSpan(std::span(_meshlets.m_vertices));
+                header.m_trianglesOffset = beginArray();
+                m_writer.WriteSpan(std::span(_meshlets.m_triangles));
+
+                const u64 end = m_writer.Tell();
+                m_writer.Seek(m_sectionStart);
+                m_writer.WritePod(header);
+                m_writer.Seek(end);
+
+                End(MeshFormat::SectionType::Meshlets, MeshFormat::ElementFormat::Structured);
+            }
+
+            void WriteTable()
+            {
+                m_writer.Align(MeshFormat::kSectionAlignment);
+                m_tableOffset = m_writer.Tell();
+                m_writer.WriteSpan(std::span<const MeshFormat::SectionEntry>(m_sections));
+            }
+
+            [[nodiscard]] u64 GetTableOffset() const { return m_tableOffset; }
+            [[nodiscard]] u32 GetSectionCount() const { return u32(m_sections.size()); }
+
+        private:
+            FileWriter& m_writer;
+            std::vector<MeshFormat::SectionEntry> m_sections;
+            u64 m_sectionStart = 0;
+            u64 m_tableOffset = 0;
+
+            void Begin()
+            {
+                m_writer.Align(MeshFormat::kSectionAlignment);
+                m_sectionStart = m_writer.Tell();
+            }
+
+            void End(MeshFormat::SectionType _type, MeshFormat::ElementFormat _format)
+            {
+                m_sections.push_back({ _type, _format, m_sectionStart, m_writer.Tell() - m_sectionStart });
+            }
+        };
+
+        void CopyBounds(const Aabb& _bounds, f32 (&_min)[3], f32 (&_max)[3])
+        {
+            const Aabb bounds = _bounds.IsValid() ? _bounds : Aabb { {}, {} };
+            _min[0] = bounds.m_min.x;
+            _min[1] = bounds.m_min.y;
+            _min[2] = bounds.m_min.z;
+            _max[0] = bounds.m_max.x;
+            _max[1] = bounds.m_max.y;
+            _max[2] = bounds.m_max.z;
+        }
+    }
+
+    void WriteMesh(const std::filesystem::path& _path, const MeshData& _mesh, const MeshWriteSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("WriteMesh", _path.string());
+        using MeshFormat::ElementFormat;
+        using MeshFormat::SectionType;
+
+        FileWriter writer(_path);
+
+        MeshFormat::Header header {};
+        header.m_magic = MeshFormat::kMagic;
+        header.m_version = MeshFormat::kVersion;
+        header.m_headerSize = sizeof(MeshFormat::Header);
+        header.m_vertexCount = _mesh.m_vertexCount;
+        header.m_indexCount = u32(_mesh.m_indices.size());
+        header.m_submeshCount = u32(_mesh.m_submeshes.size());
+        CopyBounds(_mesh.m_bounds, header.m_boundsMin, header.m_boundsMax);
+        writer.WritePod(header);
+
+        SectionWriter sections(writer);
+
+        const auto addStream = [&](VertexAttribute _attribute, SectionType _type, ElementFormat _format, const auto& _stream)
+        {
+            if (_mesh.HasAttribute(_attribute))
+            {
+                sections.Add(_type, _format, std::span(_stream));
+            }
+        };
+
+        if (_settings.m_quantizeAttributes)
+        {
+            const PositionQuantization quantization = ComputePositionQuantization(_settings.m_quantizationBounds.IsValid() ? _settings.m_quantizationBounds : _mesh.m_bounds);
+            if (_mesh.HasAttribute(VertexAttribute::Position))
+            {
+                sections.AddPacked<std::array<s16, 4>>(SectionType::Positions, ElementFormat::SNorm16x4, std::span(_mesh.m_positions), [&](auto _input, auto _output)
+                {
+                    QuantizePositions(_input, quantization, _output);
+                });
+
+                const MeshFormat::PositionQuantizationRecord record = {
+                    { quantization.m_offset.x, quantization.m_offset.y, quantization.m_offset.z },
+                    { quantization.m_scale.x, quantization.m_scale.y, quantization.m_scale.z },
+                };
+                sections.Add(SectionType::PositionQuantization, ElementFormat::Structured, std::span(&record, 1));
+            }
+            if (_mesh.HasAttribute(VertexAttribute::Normal))
+            {
+                sections.AddPacked<std::array<s16, 2>>(SectionType::Normals, ElementFormat::OctahedralSNorm16x2, std::span(_mesh.m_normals), [](auto _input, auto _output)
+                {
+                    EncodeOctahedral(_input, _output);
+                });
+            }
+            if (_mesh.HasAttribute(VertexAttribute::Tangent))
+            {
+                sections.AddPacked<u32>(SectionType::Tangents, ElementFormat::SNorm10x3_2, std::span(_mesh.m_tangents), [](auto _input, auto _output)
+                {
+                    PackTangents(_input, _output);
+                });
+            }
+            for (u32 set = 0; set < 2; set++)
+            {
+                if (_mesh.HasAttribute(set == 0 ? VertexAttribute::TexCoord0 : VertexAttribute::TexCoord1))
+                {
+                    const SectionType type = set == 0 ? SectionType::TexCoord0 : SectionType::TexCoord1;
+                    sections.AddPacked<std::array<u16, 2>>(type, ElementFormat::Float16x2, std::span(_mesh.m_texCoords[set]), [](auto _input, auto _output)
+                    {
+                        PackHalves(_input, _output);
+                    });
+                }
+            }
+        }
+        else
+        {
+            addStream(VertexAttribute::Position, SectionType::Positions, ElementFormat::Float32x3, _mesh.m_positions);
+            addStream(VertexAttribute::Normal, SectionType::Normals, ElementFormat::Float32x3, _mesh.m_normals);
+            addStream(VertexAttribute::Tangent, SectionType::Tangents, ElementFormat::Float32x4, _mesh.m_tangents);
+            addStream(VertexAttribute::TexCoord0, SectionType::TexCoord0, ElementFormat::Float32x2, _mesh.m_texCoords[0]);
+            addStream(VertexAttribute::TexCoord1, SectionType::TexCoord1, ElementFormat::Float32x2, _mesh.m_texCoords[1]);
+        }
+        addStream(VertexAttribute::Color0, SectionType::Color0, ElementFormat::Float32x4, _mesh.m_colors);
+        addStream(VertexAttribute::Joints0, SectionType::Joints0, ElementFormat::UInt16x4, _mesh.m_joints);
+        addStream(VertexAttribute::Weights0, SectionType::Weights0, ElementFormat::Float32x4, _mesh.m_weights);
+
+        bool narrowIndices = true;
+        for (const Submesh& submesh: _mesh.m_submeshes)
+        {
+            narrowIndices &= submesh.m_vertexCount <= 0x10000;
+        }
+        if (narrowIndices)
+        {
+            sections.AddNarrowed<u16>(SectionType::Indices, ElementFormat::UInt16, std::span(_mesh.m_indices));
+        }
+        else
+        {
+            sections.Add(SectionType::Indices, ElementFormat::UInt32, std::span(_mesh.m_indices));
+        }
+
+        std::vector<MeshFormat::SubmeshRecord> submeshes;
+        submeshes.reserve(_mesh.m_submeshes.size());
+        for (const Submesh& submesh: _mesh.m_submeshes)
+        {
+            MeshFormat::SubmeshRecord& record = submeshes.emplace_back();
+            record.m_vertexOffset = submesh.m_vertexOffset;
+            record.m_vertexCount = submesh.m_vertexCount;
+            record.m_indexOffset = submesh.m_indexOffset;
+            record.m_indexCount = submesh.m_indexCount;
+            record.m_material = submesh.m_materialIndex;
+            CopyBounds(submesh.m_bounds, record.m_boundsMin, record.m_boundsMax);
+        }
+        sections.Add(SectionType::Submeshes, ElementFormat::Structured, std::span<const MeshFormat::SubmeshRecord>(submeshes));
+
+        if (!_mesh.m_lods.empty())
+        {
+            std::vector<MeshFormat::LodRecord> lods;
+            lods.reserve(_mesh.m_lods.size());
+            for (u32 s = 0; s < _mesh.m_submeshes.size(); s++)
+            {
+                const Submesh& submesh = _mesh.m_submeshes[s];
+                for (u32 l = 0; l < submesh.m_lodCount; l++)
+                {
+                    const SubmeshLod& lod = _mesh.m_lods[submesh.m_lodOffset + l];
+                    lods.push_back({ s, lod.m_indexOffset, lod.m_indexCount, lod.m_error });
+                }
+            }
+            sections.Add(SectionType::Lods, ElementFormat::Structured, std::span<const MeshFormat::LodRecord>(lods));
+        }
+
+        if (!_mesh.m_meshlets.IsEmpty())
+        {
+            sections.AddMeshlets(_mesh.m_meshlets, _mesh.m_submeshes);
+        }
+
+        sections.AddStringTable(SectionType::MaterialNames, _mesh.m_materialNames);
+        sections.AddStringTable(SectionType::Name, std::span(&_mesh.m_name, 1));
+
+        sections.WriteTable();
+
+        header.m_sectionCount = sections.GetSectionCount();
+        header.m_sectionTableOffset = sections.GetTableOffset();
+        writer.Seek(0);
+        writer.WritePod(header);
+
+        writer.Commit();
+    }
+}
@@ -0,0 +1,338 @@
+#include "KryneTools/Mesh/MeshletBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include "KryneTools/Common/Arena.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Mesh/MeshData.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kInvalidIndex = ~0u;
+
+        /// Builds the meshlets of one submesh, with vertex indices already made absolute.
+        class SubmeshMeshletBuilder
+        {
+        public:
+            SubmeshMeshletBuilder(const MeshData& _mesh, const Submesh& _submesh, const MeshletSettings& _settings, const ScratchScope& _scratch)
+                : m_settings(_settings)
+                , m_vertexOffset(_submesh.m_vertexOffset)
+                , m_indices(_mesh.m_indices.data() + _submesh.m_indexOffset, _submesh.m_indexCount)
+                , m_positions(_mesh.m_positions.data() + _submesh.m_vertexOffset, _submesh.m_vertexCount)
+                , m_adjacencyOffsets(_scratch)
+                , m_adjacency(_scratch)
+                , m_liveTriangles(_scratch)
+                , m_emitted(_scratch)
+                , m_candidateStamps(_scratch)
+                , m_slots(_submesh.m_vertexCount, kInvalidIndex, _scratch)
+                , m_candidates(_scratch)
+                , m_vertices(_scratch)
+                , m_triangles(_scratch)
+            {
+                const u32 triangleCount = u32(m_indices.size() / 3);
+                m_emitted.resize(triangleCount, 0);
+                m_candidateStamps.resize(triangleCount, kInvalidIndex);
+
+                m_liveTriangles.resize(_submesh.m_vertexCount, 0);
+                for (const u32 index: m_indices)
+                {
+                    m_liveTriangles[index]++;
+                }
+                m_adjacencyOffsets.resize(_submesh.m_vertexCount + 1, 0);
+                for (u32 v = 0; v < _submesh.m_vertexCount; v++)
+                {
+                    m_adjacencyOffsets[v + 1] = m_adjacencyOffsets[v] + m_liveTriangles[v];
+                }
+                m_adjacency.resize(m_indices.size());
+                ArenaVector<u32> cursors(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1, _scratch);
+                for (u32 i = 0; i < m_indices.size(); i++)
+                {
+                    m_adjacency[cursors[m_indices[i]]++] = i / 3;
+                }
+            }
+
+            MeshletData Build()
+            {
+                u32 scanCursor = 0;
+                const u32 triangleCount = u32(m_emitted.size());
+                while (true)
+                {
+                    u32 triangle = PickCandidate();
+                    if (triangle == kInvalidIndex)
+                    {
+                        // No neighbour left: continue with the next triangle in index order, close by after reordering.
+                        while (scanCursor < triangleCount && m_emitted[scanCursor] != 0)
+                        {
+                            scanCursor++;
+                        }
+                        if (scanCursor == triangleCount)
+                        {
+                            break;
+                        }
+                        triangle = scanCursor;
+                    }
+
+                    if (!Fits(triangle))
+                    {
+                        Flush();
+                    }
+                    Add(triangle);
+                }
+                Flush();
+                return std::move(m_output);
+            }
+
+        private:
+            const MeshletSettings& m_settings;
+            u32 m_vertexOffset;
+            std::span<const u32> m_indices;
+            std::span<const Float3> m_positions;
+
+            ArenaVector<u32> m_adjacencyOffsets;
+            ArenaVector<u32> m_adjacency;
+            /// Triangles left to emit around each vertex.
+            ArenaVector<u32> m_liveTriangles;
+            ArenaVector<u8> m_emitted;
+            /// Meshlet for which a triangle was last added to the candidates, to avoid duplicates.
+            ArenaVector<u32> m_candidateStamps;
+            /// Meshlet-local index of each submesh vertex, for the current meshlet.
+            ArenaVector<u32> m_slots;
+
+            ArenaVector<u32> m_candidates;
+            ArenaVector<u32> m_vertices;
+            ArenaVector<u8> m_triangles;
+            Float3 m_centroidSum {};
+            u32 m_meshletIndex = 0;
+
+            MeshletData m_output;
+
+            [[nodiscard]] Float3 GetCentroid(u32 _triangle) const
+            {
+                const u32* triangle = m_indices.data() + _triangle * 3;
+                return (m_positions[triangle[0]] + m_positions[triangle[1]] + m_positions[triangle[2]]) * (1.0f / 3.0f);
+            }
+
+            [[nodiscard]] u32 CountNewVertices(u32 _triangle) const
+            {
+                const u32* triangle = m_indices.data() + _triangle * 3;
+                u32 count = m_slots[triangle[0]] == kInvalidIndex ? 1 : 0;
+                count += m_slots[triangle[1]] == kInvalidIndex && triangle[1] != triangle[0] ? 1 : 0;
+                count += m_slots[triangle[2]] == kInvalidIndex && triangle[2] != triangle[0] && triangle[2] != triangle[1] ? 1 : 0;
+                return count;
+            }
+
+            [[nodiscard]] bool Fits(u32 _triangle) const
+            {
+                return m_triangles.size() / 3 < m_settings.m_maxTriangles
+                    && m_vertices.size() + CountNewVertices(_triangle) <= m_settings.m_maxVertices;
+            }
+
+            /**
+             * Best neighbour of the current meshlet: fewest new vertices first, then closest to its centroid. Triangles
+             * that are the last one around a vertex come first too, as leaving them out would strand them in a later
+             * meshlet of their own.
+             */
+            u32 PickCandidate()
+            {
+                const u32 meshletTriangles = u32(m_triangles.size() / 3);
+                const Float3 centroid = meshletTriangles > 0 ? m_centroidSum * (1.0f / f32(meshletTriangles)) : Float3 {};
+
+                u32 best = kInvalidIndex;
+                u32 bestNewVertices = 4;
+                f32 bestDistance = 0.0f;
+                size_t kept = 0;
+                for (const u32 candidate: m_candidates)
+                {
+                    if (m_emitted[candidate] != 0)
+                    {
+                        continue;
+                    }
+                    m_candidates[kept++] = candidate;
+
+                    const u32* triangle = m_indices.data() + candidate * 3;
+                    const bool isLast = m_liveTriangles[triangle[0]] == 1 || m_liveTriangles[triangle[1]] == 1 || m_liveTriangles[triangle[2]] == 1;
+                    const u32 newVertices = isLast ? 0 : CountNewVertices(candidate);
+                    if (newVertices > bestNewVertices)
+                    {
+                        continue;
+                    }
+                    const Float3 offset = GetCentroid(candidate) - centroid;
+                    const f32 distance = Dot(offset, offset);
+                    if (newVertices < bestNewVertices || distance < bestDistance)
+                    {
+                        best = candidate;
+                        bestNewVertices = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+                m_candidates.resize(kept);
+                return best;
+            }
+
+            void Add(u32 _triangle)
+            {
+                const u32* triangle = m_indices.data() + _triangle * 3;
+                for (u32 k = 0; k < 3; k++)
+                {
+                    const u32 vertex = triangle[k];
+                    if (m_slots[vertex] == kInvalidIndex)
+                    {
+                        m_slots[vertex] = u32(m_vertices.size());
+                        m_vertices.push_back(vertex);
+
+                        for (u32 i = m_adjacencyOffsets[vertex]; i < m_adjacencyOffsets[vertex + 1]; i++)
+                        {
+                            const u32 neighbour = m_adjacency[i];
+                            if (m_emitted[neighbour] == 0 && m_candidateStamps[neighbour] != m_meshletIndex)
+                            {
+                                m_candidateStamps[neighbour] = m_meshletIndex;
+                                m_candidates.push_back(neighbour);
+                            }
+                        }
+                    }
+                    m_triangles.push_back(u8(m_slots[vertex]));
+                }
+                for (u32 k = 0; k < 3; k++)
+                {
+                    m_liveTriangles[triangle[k]]--;
+                }
+                m_emitted[_triangle] = 1;
+                m_centroidSum += GetCentroid(_triangle);
+            }
+
+            void Flush()
+            {
+                if (m_triangles.empty())
+                {
+                    return;
+                }
+
+                Meshlet& meshlet = m_output.m_meshlets.emplace_back();
+                meshlet.m_vertexOffset = u32(m_output.m_vertices.size());
+                meshlet.m_triangleOffset = u32(m_output.m_triangles.size());
+                meshlet.m_vertexCount = u16(m_vertices.size());
+                meshlet.m_triangleCount = u16(m_triangles.size() / 3);
+
+                m_output.m_spheres.push_back(ComputeSphere());
+                m_output.m_cones.push_back(ComputeCone());
+
+                for (const u32 vertex: m_vertices)
+                {
+                    m_output.m_vertices.push_back(m_vertexOffset + vertex);
+                    m_slots[vertex] = kInvalidIndex;
+                }
+                m_output.m_triangles.insert(m_output.m_triangles.end(), m_triangles.begin(), m_triangles.end());
+                m_output.m_triangles.resize(AlignUp(m_output.m_triangles.size(), size_t(4)), 0);
+
+                m_vertices.clear();
+                m_triangles.clear();
+                m_candidates.clear();
+                m_centroidSum = {};
+                m_meshletIndex++;
+            }
+
+            [[nodiscard]] Float4 ComputeSphere() const
+            {
+                Aabb bounds;
+                for (const u32 vertex: m_vertices)
+                {
+                    bounds.Expand(m_positions[vertex]);
+                }
+                const Float3 center = bounds.GetCenter();
+                f32 radiusSquared = 0.0f;
+                for (const u32 vertex: m_vertices)
+                {
+                    const Float3 offset = m_positions[vertex] - center;
+                    radiusSquared = std::max(radiusSquared, Dot(offset, offset));
+                }
+                return { center.x, center.y, center.z, std::sqrt(radiusSquared) };
+            }
+
+            [[nodiscard]] Float4 ComputeCone() const
+            {
+                // Runs once per meshlet, a heap allocation each time would cost more than the cone itself.
+                const ScratchScope scratch;
+                ArenaVector<Float3> normals(scratch);
+                normals.reserve(m_triangles.size() / 3);
+                Float3 axis {};
+                for (size_t i = 0; i < m_triangles.size(); i += 3)
+                {
+                    const Float3& p0 = m_positions[m_vertices[m_triangles[i]]];
+                    const Float3& p1 = m_positions[m_vertices[m_triangles[i + 1]]];
+                    const Float3& p2 = m_positions[m_vertices[m_triangles[i + 2]]];
+                    const Float3 cross = Cross(p1 - p0, p2 - p0);
+                    if (Dot(cross, cross) > 0.0f)
+                    {
+                        normals.push_back(Normalize(cross));
+                        axis += normals.back();
+                    }
+                }
+
+                axis = Normalize(axis);
+                f32 minDot = Dot(axis, axis) > 0.0f ? 1.0f : -1.0f;
+                for (const Float3& normal: normals)
+                {
+                    minDot = std::min(minDot, Dot(axis, normal));
+                }
+
+                // Past ~85 degrees a cone almost never culls, and float error could make it wrong: disable it.
+                if (minDot <= 0.1f)
+                {
+                    return { axis.x, axis.y, axis.z, 1.0f };
+                }
+                return { axis.x, axis.y, axis.z, std::sqrt(1.0f - minDot * minDot) };
+            }
+        };
+    }
+
+    void BuildMeshlets(JobSystem& _jobSystem, MeshData& _mesh, const MeshletSettings& _settings)
+    {
+        KT_TRACE_ZONE("BuildMeshlets");
+        KT_VERIFY(
+            _settings.m_maxVertices > 0 && _settings.m_maxVertices <= 256 && _settings.m_maxTriangles > 0 && _settings.m_maxTriangles <= 0xFFFF,
+            "Invalid meshlet limits %u vertices %u triangles, at most 256 vertices are addressable",
+            _settings.m_maxVertices,
+            _settings.m_maxTriangles);
+        KT_VERIFY(_settings.m_maxVertices >= 3, "Meshlets need at least 3 vertices");
+        KT_VERIFY(_mesh.HasAttribute(VertexAttribute::Position), "Mesh '%s' has no position", _mesh.m_name.c_str());
+
+        std::vector<MeshletData> submeshMeshlets(_mesh.m_submeshes.size());
+        _jobSystem.ParallelFor(_mesh.m_submeshes.size(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 s = _begin; s < _end; s++)
+            {
+                const ScratchScope scratch;
+                submeshMeshlets[s] = SubmeshMeshletBuilder(_mesh, _mesh.m_submeshes[s], _settings, scratch).Build();
+            }
+        });
+
+        MeshletData& meshlets = _mesh.m_meshlets;
+        meshlets = {};
+        meshlets.m_maxVertices = _settings.m_maxVertices;
+        meshlets.m_maxTriangles = _settings.m_maxTriangles;
+        for (size_t s = 0; s < submeshMeshlets.size(); s++)
+        {
+            const MeshletData& source = submeshMeshlets[s];
+            _mesh.m_submeshes[s].m_meshletOffset = u32(meshlets.m_meshlets.size());
+            _mesh.m_submeshes[s].m_meshletCount = u32(source.m_meshlets.size());
+
+            for (Meshlet meshlet: source.m_meshlets)
+            {
+                meshlet.m_vertexOffset += u32(meshlets.m_vertices.size());
+                meshlet.m_triangleOffset += u32(meshlets.m_triangles.size());
+                meshlets.m_meshlets.push_back(meshlet);
+            }
+            meshlets.m_spheres.insert(meshlets.m_spheres.end(), source.m_spheres.begin(), source.m_spheres.end());
+            meshlets.m_cones.insert(meshlets.m_cones.end(), source.m_cones.begin(), source.m_cones.end());
+            meshlets.m_vertices.insert(meshlets.m_vertices.end(), source.m_vertices.begin(), source.m_vertices.end());
+            meshlets.m_triangles.insert(meshlets.m_triangles.end(), source.m_triangles.begin(), source.m_triangles.end());
+        }
+    }
+}
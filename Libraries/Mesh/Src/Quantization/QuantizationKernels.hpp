@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+
+#include "KryneTools/Mesh/VertexQuantization.hpp"
+
+/**
+ * @file
+ * Shared between the kernel translation units, each compiled with its own instruction set flags.
+ *
+ * Everything defined here has internal linkage: an inline function with external linkage would be emitted by every
+ * kernel unit, and the linker could keep an AVX2 copy for the scalar path. For the same reason kernel units must not
+ * instantiate templates of other headers, standard ones included.
+ */
+namespace KryneTools::Quantization
+{
+    extern const QuantizationKernels g_scalarKernels;
+#if defined(KRYNE_TOOLS_HAS_X86_SIMD)
+    extern const QuantizationKernels g_sse42Kernels;
+    extern const QuantizationKernels g_avx2Kernels;
+#endif
+#if defined(KRYNE_TOOLS_HAS_NEON)
+    extern const QuantizationKernels g_neonKernels;
+#endif
+
+    namespace
+    {
+        constexpr f32 kSnorm16Scale = 32767.0f;
+        constexpr f32 kSnorm10Scale = 511.0f;
+
+        /// Half conversion constants (round to nearest even, see `FloatToHalf()`).
+        constexpr u32 kHalfMaxBits = (127 + 16) << 23;
+        constexpr u32 kFloatInfinityBits = 255 << 23;
+        constexpr u32 kHalfDenormalMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+        constexpr u32 kHalfMinNormalBits = 113 << 23;
+        constexpr u32 kHalfRebiasBits = u32(15 - 127) << 23;
+
+        inline u32 FloatBits(f32 _value)
+        {
+            u32 bits;
+            std::memcpy(&bits, &_value, sizeof(bits));
+            return bits;
+        }
+
+        inline f32 BitsFloat(u32 _bits)
+        {
+            f32 value;
+            std::memcpy(&value, &_bits, sizeof(value));
+            return value;
+        }
+
+        /// Same operand order as `maxps`/`minps`, NaN clamps to `_min`.
+        inline f32 Clamp(f32 _value, f32 _min, f32 _max)
+        {
+            const f32 low = _value > _min ? _value : _min;
+            return low < _max ? low : _max;
+        }
+
+        /// Round to nearest even, as `cvtps2dq` and `fcvtns`.
+        inline s32 RoundToInt(f32 _value)
+        {
+            return s32(std::lrint(_value));
+        }
+
+        inline s16 ToSnorm16(f32 _value)
+        {
+            return s16(RoundToInt(Clamp(_value, -1.0f, 1.0f) * kSnorm16Scale));
+        }
+
+        inline void QuantizePosition(const f32* _position, const f32* _offset, const f32* _inverseScale, s16* _output)
+        {
+            for (u32 i = 0; i < 3; i++)
+            {
+                _output[i] = ToSnorm16((_position[i] - _offset[i]) * _inverseScale[i]);
+            }
+            _output[3] = 0;
+        }
+
+        inline void EncodeOctahedral(const f32* _normal, s16* _output)
+        {
+            const f32 sum = (std::fabs(_normal[0]) + std::fabs(_normal[1])) + std::fabs(_normal[2]);
+            const f32 inverse = sum > 0.0f ? 1.0f / sum : 0.0f;
+            f32 u = _normal[0] * inverse;
+            f32 v = _normal[1] * inverse;
+            if (_normal[2] < 0.0f)
+            {
+                // Fold the lower hemisphere over the diagonals.
+                const f32 foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+                const f32 foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+                u = foldedU;
+                v = foldedV;
+            }
+            _output[0] = ToSnorm16(u);
+            _output[1] = ToSnorm16(v);
+        }
+
+        /**
+         * Round to nearest even float to half conversion (after Fabian Giesen's `float_to_half_fast3_rtne`).
+         * Overflows give infinities, and every NaN becomes the canonical quiet NaN `0x7E00`.
+         */
+        inline u16 FloatToHalf(f32 _value)
+        {
+            u32 bits = FloatBits(_value);
+            const u32 sign = bits & 0x80000000u;
+            bits ^= sign;
+
+            u32 half;
+            if (bits >= kHalfMaxBits)
+            {
+                half = bits > kFloatInfinityBits ? 0x7E00 : 0x7C00;
+            }
+            else if (bits < kHalfMinNormalBits)
+            {
+                // The float addition aligns the mantissa to the half denormal precision, rounding it.
+                half = FloatBits(BitsFloat(bits) + BitsFloat(kHalfDenormalMagicBits)) - kHalfDenormalMagicBits;
+            }
+            else
+            {
+                const u32 mantissaOdd = (bits >> 13) & 1;
+                half = (bits + kHalfRebiasBits + 0xFFF + mantissaOdd) >> 13;
+            }
+            return u16(half | (sign >> 16));
+        }
+
+        inline u32 PackTangent(const f32* _tangent)
+        {
+            const u32 x = u32(RoundToInt(Clamp(_tangent[0], -1.0f, 1.0f) * kSnorm10Scale)) & 0x3FF;
+            const u32 y = u32(RoundToInt(Clamp(_tangent[1], -1.0f, 1.0f) * kSnorm10Scale)) & 0x3FF;
+            const u32 z = u32(RoundToInt(Clamp(_tangent[2], -1.0f, 1.0f) * kSnorm10Scale)) & 0x3FF;
+            const u32 w = u32(RoundToInt(Clamp(_tangent[3], -1.0f, 1.0f))) & 0x3;
+            return x | (y << 10) | (z << 20) | (w << 30);
+        }
+    }
+}
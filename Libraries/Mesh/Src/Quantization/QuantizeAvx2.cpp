@@ -0,0 +1,172 @@
+#include "QuantizationKernels.hpp"
+
+#include <immintrin.h>
+
+namespace KryneTools::Quantization
+{
+    namespace
+    {
+        inline __m256 ClampSigned(__m256 _value)
+        {
+            return _mm256_min_ps(_mm256_max_ps(_value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+        }
+
+        inline __m256i ToSnorm16(__m256 _value)
+        {
+            return _mm256_cvtps_epi32(_mm256_mul_ps(ClampSigned(_value), _mm256_set1_ps(kSnorm16Scale)));
+        }
+
+        inline __m256 Abs(__m256 _value)
+        {
+            return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _value);
+        }
+
+        inline __m256 Load2x128(const f32* _low, const f32* _high)
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(_low)), _mm_loadu_ps(_high), 1);
+        }
+
+        /// Eight `xyz` vectors to `x`, `y` and `z` registers: the SSE deinterleave, on both 128 bits lanes at once.
+        inline void LoadXyz(const f32* _data, __m256& _x, __m256& _y, __m256& _z)
+        {
+            const __m256 a = Load2x128(_data, _data + 12);
+            const __m256 b = Load2x128(_data + 4, _data + 16);
+            const __m256 c = Load2x128(_data + 8, _data + 20);
+            _x = _mm256_shuffle_ps(a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            _y = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            _z = _mm256_shuffle_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+
+        inline __m256i FloatToHalf8(__m256 _value)
+        {
+            __m256i bits = _mm256_castps_si256(_value);
+            const __m256i sign = _mm256_and_si256(bits, _mm256_set1_epi32(s32(0x80000000u)));
+            bits = _mm256_xor_si256(bits, sign);
+
+            const __m256i isSpecial = _mm256_cmpgt_epi32(bits, _mm256_set1_epi32(s32(kHalfMaxBits - 1)));
+            const __m256i special = _mm256_blendv_epi8(
+                _mm256_set1_epi32(0x7C00),
+                _mm256_set1_epi32(0x7E00),
+                _mm256_cmpgt_epi32(bits, _mm256_set1_epi32(s32(kFloatInfinityBits))));
+
+            const __m256i isDenormal = _mm256_cmpgt_epi32(_mm256_set1_epi32(s32(kHalfMinNormalBits)), bits);
+            const __m256 magic = _mm256_castsi256_ps(_mm256_set1_epi32(s32(kHalfDenormalMagicBits)));
+            const __m256i denormal = _mm256_sub_epi32(_mm256_castps_si256(_mm256_add_ps(_mm256_castsi256_ps(bits), magic)), _mm256_castps_si256(magic));
+
+            const __m256i mantissaOdd = _mm256_and_si256(_mm256_srli_epi32(bits, 13), _mm256_set1_epi32(1));
+            const __m256i rounded = _mm256_add_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(s32(kHalfRebiasBits + 0xFFF))), mantissaOdd);
+            const __m256i normal = _mm256_srli_epi32(rounded, 13);
+
+            __m256i half = _mm256_blendv_epi8(normal, denormal, isDenormal);
+            half = _mm256_blendv_epi8(half, special, isSpecial);
+            return _mm256_or_si256(half, _mm256_srli_epi32(sign, 16));
+        }
+
+        /// Two `xyzw` tangents to their bit fields, already shifted in place.
+        inline __m256i PackTangentFields(const f32* _tangents)
+        {
+            const __m256 scale = _mm256_setr_ps(kSnorm10Scale, kSnorm10Scale, kSnorm10Scale, 1.0f, kSnorm10Scale, kSnorm10Scale, kSnorm10Scale, 1.0f);
+            const __m256i masks = _mm256_setr_epi32(0x3FF, 0x3FF, 0x3FF, 0x3, 0x3FF, 0x3FF, 0x3FF, 0x3);
+            const __m256i shifts = _mm256_setr_epi32(0, 10, 20, 30, 0, 10, 20, 30);
+            const __m256 scaled = _mm256_mul_ps(ClampSigned(_mm256_loadu_ps(_tangents)), scale);
+            return _mm256_sllv_epi32(_mm256_and_si256(_mm256_cvtps_epi32(scaled), masks), shifts);
+        }
+
+        void QuantizePositionsAvx2(const f32* _positions, u64 _count, const f32* _offset, const f32* _inverseScale, s16* _output)
+        {
+            const __m256 offset = _mm256_setr_ps(_offset[0], _offset[1], _offset[2], 0.0f, _offset[0], _offset[1], _offset[2], 0.0f);
+            const __m256 inverseScale = _mm256_setr_ps(_inverseScale[0], _inverseScale[1], _inverseScale[2], 0.0f, _inverseScale[0], _inverseScale[1], _inverseScale[2], 0.0f);
+
+            // Two positions per register, each loaded with the next float, masked out.
+            u64 i = 0;
+            for (; i + 5 <= _count; i += 4)
+            {
+                const f32* positions = _positions + i * 3;
+                const __m256 a = _mm256_blend_ps(_mm256_mul_ps(_mm256_sub_ps(Load2x128(positions, positions + 3), offset), inverseScale), _mm256_setzero_ps(), 0x88);
+                const __m256 b = _mm256_blend_ps(_mm256_mul_ps(_mm256_sub_ps(Load2x128(positions + 6, positions + 9), offset), inverseScale), _mm256_setzero_ps(), 0x88);
+                // Lane-wise pack gives positions 0, 2, 1, 3.
+                const __m256i packed = _mm256_packs_epi32(ToSnorm16(a), ToSnorm16(b));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output + i * 4), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+            }
+            for (; i < _count; i++)
+            {
+                QuantizePosition(_positions + i * 3, _offset, _inverseScale, _output + i * 4);
+            }
+        }
+
+        void EncodeOctahedralAvx2(const f32* _normals, u64 _count, s16* _output)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 minusOne = _mm256_set1_ps(-1.0f);
+
+            u64 i = 0;
+            for (; i + 8 <= _count; i += 8)
+            {
+                __m256 x, y, z;
+                LoadXyz(_normals + i * 3, x, y, z);
+
+                const __m256 sum = _mm256_add_ps(_mm256_add_ps(Abs(x), Abs(y)), Abs(z));
+                const __m256 inverse = _mm256_and_ps(_mm256_cmp_ps(sum, zero, _CMP_GT_OQ), _mm256_div_ps(one, sum));
+                const __m256 u = _mm256_mul_ps(x, inverse);
+                const __m256 v = _mm256_mul_ps(y, inverse);
+
+                const __m256 foldedU = _mm256_mul_ps(_mm256_sub_ps(one, Abs(v)), _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(u, zero, _CMP_GE_OQ)));
+                const __m256 foldedV = _mm256_mul_ps(_mm256_sub_ps(one, Abs(u)), _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(v, zero, _CMP_GE_OQ)));
+                const __m256 lower = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+                const __m256i qu = ToSnorm16(_mm256_blendv_ps(u, foldedU, lower));
+                const __m256i qv = ToSnorm16(_mm256_blendv_ps(v, foldedV, lower));
+
+                // Lane-wise packs and unpacks keep the normals in order.
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output + i * 2), _mm256_unpacklo_epi16(_mm256_packs_epi32(qu, qu), _mm256_packs_epi32(qv, qv)));
+            }
+            for (; i < _count; i++)
+            {
+                EncodeOctahedral(_normals + i * 3, _output + i * 2);
+            }
+        }
+
+        void PackHalvesAvx2(const f32* _values, u64 _count, u16* _output)
+        {
+            u64 i = 0;
+            for (; i + 16 <= _count; i += 16)
+            {
+                const __m256i low = FloatToHalf8(_mm256_loadu_ps(_values + i));
+                const __m256i high = FloatToHalf8(_mm256_loadu_ps(_values + i + 8));
+                const __m256i packed = _mm256_packus_epi32(low, high);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+            }
+            for (; i < _count; i++)
+            {
+                _output[i] = FloatToHalf(_values[i]);
+            }
+        }
+
+        void PackTangentsAvx2(const f32* _tangents, u64 _count, u32* _output)
+        {
+            const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+            u64 i = 0;
+            for (; i + 8 <= _count; i += 8)
+            {
+                const f32* tangents = _tangents + i * 4;
+                const __m256i t01 = _mm256_hadd_epi32(PackTangentFields(tangents), PackTangentFields(tangents + 8));
+                const __m256i t23 = _mm256_hadd_epi32(PackTangentFields(tangents + 16), PackTangentFields(tangents + 24));
+                // Lanes hold tangents 0, 2, 4, 6 then 1, 3, 5, 7.
+                const __m256i packed = _mm256_hadd_epi32(t01, t23);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(_output + i), _mm256_permutevar8x32_epi32(packed, order));
+            }
+            for (; i < _count; i++)
+            {
+                _output[i] = PackTangent(_tangents + i * 4);
+            }
+        }
+    }
+
+    const QuantizationKernels g_avx2Kernels = {
+        QuantizePositionsAvx2,
+        EncodeOctahedralAvx2,
+        PackHalvesAvx2,
+        PackTangentsAvx2,
+    };
+}
@@ -0,0 +1,139 @@
+#include "QuantizationKernels.hpp"
+
+#include <arm_neon.h>
+
+namespace KryneTools::Quantization
+{
+    namespace
+    {
+        /// `fmax`/`fmin` propagate NaNs, select instead to match the scalar (and SSE) operand order.
+        inline float32x4_t ClampSigned(float32x4_t _value)
+        {
+            const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            const float32x4_t low = vbslq_f32(vcgtq_f32(_value, minusOne), _value, minusOne);
+            return vbslq_f32(vcltq_f32(low, one), low, one);
+        }
+
+        inline int32x4_t ToSnorm(float32x4_t _value, f32 _scale)
+        {
+            return vcvtnq_s32_f32(vmulq_n_f32(ClampSigned(_value), _scale));
+        }
+
+        inline uint32x4_t FloatToHalf4(float32x4_t _value)
+        {
+            uint32x4_t bits = vreinterpretq_u32_f32(_value);
+            const uint32x4_t sign = vandq_u32(bits, vdupq_n_u32(0x80000000u));
+            bits = veorq_u32(bits, sign);
+
+            const uint32x4_t isSpecial = vcgeq_u32(bits, vdupq_n_u32(kHalfMaxBits));
+            const uint32x4_t special = vbslq_u32(vcgtq_u32(bits, vdupq_n_u32(kFloatInfinityBits)), vdupq_n_u32(0x7E00), vdupq_n_u32(0x7C00));
+
+            const uint32x4_t isDenormal = vcltq_u32(bits, vdupq_n_u32(kHalfMinNormalBits));
+            const float32x4_t magic = vreinterpretq_f32_u32(vdupq_n_u32(kHalfDenormalMagicBits));
+            const uint32x4_t denormal = vsubq_u32(vreinterpretq_u32_f32(vaddq_f32(vreinterpretq_f32_u32(bits), magic)), vdupq_n_u32(kHalfDenormalMagicBits));
+
+            const uint32x4_t mantissaOdd = vandq_u32(vshrq_n_u32(bits, 13), vdupq_n_u32(1));
+            const uint32x4_t normal = vshrq_n_u32(vaddq_u32(vaddq_u32(bits, vdupq_n_u32(kHalfRebiasBits + 0xFFF)), mantissaOdd), 13);
+
+            const uint32x4_t half = vbslq_u32(isSpecial, special, vbslq_u32(isDenormal, denormal, normal));
+            return vorrq_u32(half, vshrq_n_u32(sign, 16));
+        }
+
+        void QuantizePositionsNeon(const f32* _positions, u64 _count, const f32* _offset, const f32* _inverseScale, s16* _output)
+        {
+            u64 i = 0;
+            for (; i + 4 <= _count; i += 4)
+            {
+                const float32x4x3_t positions = vld3q_f32(_positions + i * 3);
+                int16x4x4_t quantized;
+                for (u32 c = 0; c < 3; c++)
+                {
+                    const float32x4_t normalized = vmulq_n_f32(vsubq_f32(positions.val[c], vdupq_n_f32(_offset[c])), _inverseScale[c]);
+                    quantized.val[c] = vmovn_s32(ToSnorm(normalized, kSnorm16Scale));
+                }
+                quantized.val[3] = vdup_n_s16(0);
+                vst4_s16(_output + i * 4, quantized);
+            }
+            for (; i < _count; i++)
+            {
+                QuantizePosition(_positions + i * 3, _offset, _inverseScale, _output + i * 4);
+            }
+        }
+
+        void EncodeOctahedralNeon(const f32* _normals, u64 _count, s16* _output)
+        {
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            const float32x4_t minusOne = vdupq_n_f32(-1.0f);
+
+            u64 i = 0;
+            for (; i + 4 <= _count; i += 4)
+            {
+                const float32x4x3_t normals = vld3q_f32(_normals + i * 3);
+                const float32x4_t x = normals.val[0];
+                const float32x4_t y = normals.val[1];
+                const float32x4_t z = normals.val[2];
+
+                const float32x4_t sum = vaddq_f32(vaddq_f32(vabsq_f32(x), vabsq_f32(y)), vabsq_f32(z));
+                const float32x4_t inverse = vbslq_f32(vcgtq_f32(sum, zero), vdivq_f32(one, sum), zero);
+                const float32x4_t u = vmulq_f32(x, inverse);
+                const float32x4_t v = vmulq_f32(y, inverse);
+
+                const float32x4_t foldedU = vmulq_f32(vsubq_f32(one, vabsq_f32(v)), vbslq_f32(vcgeq_f32(u, zero), one, minusOne));
+                const float32x4_t foldedV = vmulq_f32(vsubq_f32(one, vabsq_f32(u)), vbslq_f32(vcgeq_f32(v, zero), one, minusOne));
+                const uint32x4_t lower = vcltq_f32(z, zero);
+
+                int16x4x2_t encoded;
+                encoded.val[0] = vmovn_s32(ToSnorm(vbslq_f32(lower, foldedU, u), kSnorm16Scale));
+                encoded.val[1] = vmovn_s32(ToSnorm(vbslq_f32(lower, foldedV, v), kSnorm16Scale));
+                vst2_s16(_output + i * 2, encoded);
+            }
+            for (; i < _count; i++)
+            {
+                EncodeOctahedral(_normals + i * 3, _output + i * 2);
+            }
+        }
+
+        void PackHalvesNeon(const f32* _values, u64 _count, u16* _output)
+        {
+            u64 i = 0;
+            for (; i + 4 <= _count; i += 4)
+            {
+                vst1_u16(_output + i, vmovn_u32(FloatToHalf4(vld1q_f32(_values + i))));
+            }
+            for (; i < _count; i++)
+            {
+                _output[i] = FloatToHalf(_values[i]);
+            }
+        }
+
+        void PackTangentsNeon(const f32* _tangents, u64 _count, u32* _output)
+        {
+            const uint32x4_t mask10 = vdupq_n_u32(0x3FF);
+
+            u64 i = 0;
+            for (; i + 4 <= _count; i += 4)
+            {
+                const float32x4x4_t tangents = vld4q_f32(_tangents + i * 4);
+                const uint32x4_t x = vandq_u32(vreinterpretq_u32_s32(ToSnorm(tangents.val[0], kSnorm10Scale)), mask10);
+                const uint32x4_t y = vandq_u32(vreinterpretq_u32_s32(ToSnorm(tangents.val[1], kSnorm10Scale)), mask10);
+                const uint32x4_t z = vandq_u32(vreinterpretq_u32_s32(ToSnorm(tangents.val[2], kSnorm10Scale)), mask10);
+                const uint32x4_t w = vreinterpretq_u32_s32(ToSnorm(tangents.val[3], 1.0f));
+                const uint32x4_t packed = vorrq_u32(vorrq_u32(x, vshlq_n_u32(y, 10)), vorrq_u32(vshlq_n_u32(z, 20), vshlq_n_u32(w, 30)));
+                vst1q_u32(_output + i, packed);
+            }
+            for (; i < _count; i++)
+            {
+                _output[i] = PackTangent(_tangents + i * 4);
+            }
+        }
+    }
+
+    const QuantizationKernels g_neonKernels = {
+        QuantizePositionsNeon,
+        EncodeOctahedralNeon,
+        PackHalvesNeon,
+        PackTangentsNeon,
+    };
+}
@@ -0,0 +1,46 @@
+#include "QuantizationKernels.hpp"
+
+namespace KryneTools::Quantization
+{
+    namespace
+    {
+        void QuantizePositionsScalar(const f32* _positions, u64 _count, const f32* _offset, const f32* _inverseScale, s16* _output)
+        {
+            for (u64 i = 0; i < _count; i++)
+            {
+                QuantizePosition(_positions + i * 3, _offset, _inverseScale, _output + i * 4);
+            }
+        }
+
+        void EncodeOctahedralScalar(const f32* _normals, u64 _count, s16* _output)
+        {
+            for (u64 i = 0; i < _count; i++)
+            {
+                EncodeOctahedral(_normals + i * 3, _output + i * 2);
+            }
+        }
+
+        void PackHalvesScalar(const f32* _values, u64 _count, u16* _output)
+        {
+            for (u64 i = 0; i < _count; i++)
+            {
+                _output[i] = FloatToHalf(_values[i]);
+            }
+        }
+
+        void PackTangentsScalar(const f32* _tangents, u64 _count, u32* _output)
+        {
+            for (u64 i = 0; i < _count; i++)
+            {
+                _output[i] = PackTangent(_tangents + i * 4);
+            }
+        }
+    }
+
+    const QuantizationKernels g_scalarKernels = {
+        QuantizePositionsScalar,
+        EncodeOctahedralScalar,
+        PackHalvesScalar,
+        PackTangentsScalar,
+    };
+}
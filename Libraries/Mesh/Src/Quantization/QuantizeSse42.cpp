@@ -0,0 +1,162 @@
+#include "QuantizationKernels.hpp"
+
+#include <immintrin.h>
+
+namespace KryneTools::Quantization
+{
+    namespace
+    {
+        inline __m128 ClampSigned(__m128 _value)
+        {
+            return _mm_min_ps(_mm_max_ps(_value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        }
+
+        inline __m128i ToSnorm16(__m128 _value)
+        {
+            return _mm_cvtps_epi32(_mm_mul_ps(ClampSigned(_value), _mm_set1_ps(kSnorm16Scale)));
+        }
+
+        inline __m128 Abs(__m128 _value)
+        {
+            return _mm_andnot_ps(_mm_set1_ps(-0.0f), _value);
+        }
+
+        /// Four `xyz` vectors to `x`, `y` and `z` registers.
+        inline void LoadXyz(const f32* _data, __m128& _x, __m128& _y, __m128& _z)
+        {
+            const __m128 a = _mm_loadu_ps(_data);
+            const __m128 b = _mm_loadu_ps(_data + 4);
+            const __m128 c = _mm_loadu_ps(_data + 8);
+            _x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            _y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            _z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+
+        inline void EncodeOctahedral4(__m128 _x, __m128 _y, __m128 _z, __m128i& _u, __m128i& _v)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 minusOne = _mm_set1_ps(-1.0f);
+
+            const __m128 sum = _mm_add_ps(_mm_add_ps(Abs(_x), Abs(_y)), Abs(_z));
+            const __m128 inverse = _mm_and_ps(_mm_cmpgt_ps(sum, zero), _mm_div_ps(one, sum));
+            const __m128 u = _mm_mul_ps(_x, inverse);
+            const __m128 v = _mm_mul_ps(_y, inverse);
+
+            const __m128 foldedU = _mm_mul_ps(_mm_sub_ps(one, Abs(v)), _mm_blendv_ps(minusOne, one, _mm_cmpge_ps(u, zero)));
+            const __m128 foldedV = _mm_mul_ps(_mm_sub_ps(one, Abs(u)), _mm_blendv_ps(minusOne, one, _mm_cmpge_ps(v, zero)));
+            const __m128 lower = _mm_cmplt_ps(_z, zero);
+            _u = ToSnorm16(_mm_blendv_ps(u, foldedU, lower));
+            _v = ToSnorm16(_mm_blendv_ps(v, foldedV, lower));
+        }
+
+        /// `FloatToHalf()` on four lanes, results in the low 16 bits of each.
+        inline __m128i FloatToHalf4(__m128 _value)
+        {
+            __m128i bits = _mm_castps_si128(_value);
+            const __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(s32(0x80000000u)));
+            bits = _mm_xor_si128(bits, sign);
+
+            // The sign is cleared, signed comparisons are fine.
+            const __m128i isSpecial = _mm_cmpgt_epi32(bits, _mm_set1_epi32(s32(kHalfMaxBits - 1)));
+            const __m128i special = _mm_blendv_epi8(
+                _mm_set1_epi32(0x7C00),
+                _mm_set1_epi32(0x7E00),
+                _mm_cmpgt_epi32(bits, _mm_set1_epi32(s32(kFloatInfinityBits))));
+
+            const __m128i isDenormal = _mm_cmplt_epi32(bits, _mm_set1_epi32(s32(kHalfMinNormalBits)));
+            const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(s32(kHalfDenormalMagicBits)));
+            const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), magic)), _mm_castps_si128(magic));
+
+            const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+            const __m128i rounded = _mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(s32(kHalfRebiasBits + 0xFFF))), mantissaOdd);
+            const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+            __m128i half = _mm_blendv_epi8(normal, denormal, isDenormal);
+            half = _mm_blendv_epi8(half, special, isSpecial);
+            return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+        }
+
+        /// One `xyzw` tangent to its four bit fields, already shifted in place.
+        inline __m128i PackTangentFields(const f32* _tangent)
+        {
+            const __m128 scaled = _mm_mul_ps(ClampSigned(_mm_loadu_ps(_tangent)), _mm_setr_ps(kSnorm10Scale, kSnorm10Scale, kSnorm10Scale, 1.0f));
+            const __m128i fields = _mm_and_si128(_mm_cvtps_epi32(scaled), _mm_setr_epi32(0x3FF, 0x3FF, 0x3FF, 0x3));
+            return _mm_mullo_epi32(fields, _mm_setr_epi32(1, 1 << 10, 1 << 20, s32(1u << 30)));
+        }
+
+        void QuantizePositionsSse42(const f32* _positions, u64 _count, const f32* _offset, const f32* _inverseScale, s16* _output)
+        {
+            const __m128 offset = _mm_setr_ps(_offset[0], _offset[1], _offset[2], 0.0f);
+            const __m128 inverseScale = _mm_setr_ps(_inverseScale[0], _inverseScale[1], _inverseScale[2], 0.0f);
+
+            // Each position is loaded with the next float, which is masked out: stop early enough not to read past the end.
+            u64 i = 0;
+            for (; i + 3 <= _count; i += 2)
+            {
+                const __m128 a = _mm_blend_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_positions + i * 3), offset), inverseScale), _mm_setzero_ps(), 0x8);
+                const __m128 b = _mm_blend_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_positions + i * 3 + 3), offset), inverseScale), _mm_setzero_ps(), 0x8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + i * 4), _mm_packs_epi32(ToSnorm16(a), ToSnorm16(b)));
+            }
+            for (; i < _count; i++)
+            {
+                QuantizePosition(_positions + i * 3, _offset, _inverseScale, _output + i * 4);
+            }
+        }
+
+        void EncodeOctahedralSse42(const f32* _normals, u64 _count, s16* _output)
+        {
+            u64 i = 0;
+            for (; i + 4 <= _count; i += 4)
+            {
+                __m128 x, y, z;
+                LoadXyz(_normals + i * 3, x, y, z);
+                __m128i u, v;
+                EncodeOctahedral4(x, y, z, u, v);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + i * 2), _mm_unpacklo_epi16(_mm_packs_epi32(u, u), _mm_packs_epi32(v, v)));
+            }
+            for (; i < _count; i++)
+            {
+                EncodeOctahedral(_normals + i * 3, _output + i * 2);
+            }
+        }
+
+        void PackHalvesSse42(const f32* _values, u64 _count, u16* _output)
+        {
+            u64 i = 0;
+            for (; i + 8 <= _count; i += 8)
+            {
+                const __m128i low = FloatToHalf4(_mm_loadu_ps(_values + i));
+                const __m128i high = FloatToHalf4(_mm_loadu_ps(_values + i + 4));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + i), _mm_packus_epi32(low, high));
+            }
+            for (; i < _count; i++)
+            {
+                _output[i] = FloatToHalf(_values[i]);
+            }
+        }
+
+        void PackTangentsSse42(const f32* _tangents, u64 _count, u32* _output)
+        {
+            u64 i = 0;
+            for (; i + 4 <= _count; i += 4)
+            {
+                // Fields do not overlap, horizontal additions merge them.
+                const __m128i t01 = _mm_hadd_epi32(PackTangentFields(_tangents + i * 4), PackTangentFields(_tangents + i * 4 + 4));
+                const __m128i t23 = _mm_hadd_epi32(PackTangentFields(_tangents + i * 4 + 8), PackTangentFields(_tangents + i * 4 + 12));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_output + i), _mm_hadd_epi32(t01, t23));
+            }
+            for (; i < _count; i++)
+            {
+                _output[i] = PackTangent(_tangents + i * 4);
+            }
+        }
+    }
+
+    const QuantizationKernels g_sse42Kernels = {
+        QuantizePositionsSse42,
+        EncodeOctahedralSse42,
+        PackHalvesSse42,
+        PackTangentsSse42,
+    };
+}
@@ -0,0 +1,71 @@
+#include "KryneTools/Mesh/VertexQuantization.hpp"
+
+#include "KryneTools/Common/Error.hpp"
+#include "Quantization/QuantizationKernels.hpp"
+
+namespace KryneTools
+{
+    PositionQuantization ComputePositionQuantization(const Aabb& _bounds)
+    {
+        if (!_bounds.IsValid())
+        {
+            return { {}, { 1.0f, 1.0f, 1.0f } };
+        }
+        return { _bounds.GetCenter(), _bounds.GetExtent() * 0.5f };
+    }
+
+    const QuantizationKernels& GetQuantizationKernels(SimdLevel _level)
+    {
+        KT_VERIFY(IsSimdLevelSupported(_level), "SIMD level %s is not supported by this CPU", GetSimdLevelName(_level));
+
+        switch (_level)
+        {
+#if defined(KRYNE_TOOLS_HAS_X86_SIMD)
+            case SimdLevel::Sse42: return Quantization::g_sse42Kernels;
+            case SimdLevel::Avx2: return Quantization::g_avx2Kernels;
+#endif
+#if defined(KRYNE_TOOLS_HAS_NEON)
+            case SimdLevel::Neon: return Quantization::g_neonKernels;
+#endif
+            default: return Quantization::g_scalarKernels;
+        }
+    }
+
+    const QuantizationKernels& GetQuantizationKernels()
+    {
+        static const QuantizationKernels& kernels = GetQuantizationKernels(GetSimdLevel());
+        return kernels;
+    }
+
+    void QuantizePositions(std::span<const Float3> _positions, const PositionQuantization& _quantization, std::span<std::array<s16, 4>> _output)
+    {
+        KT_VERIFY(_output.size() >= _positions.size(), "Output too small");
+
+        const Float3& scale = _quantization.m_scale;
+        const f32 inverseScale[3] = {
+            scale.x != 0.0f ? 1.0f / scale.x : 0.0f,
+            scale.y != 0.0f ? 1.0f / scale.y : 0.0f,
+            scale.z != 0.0f ? 1.0f / scale.z : 0.0f,
+        };
+        const f32 offset[3] = { _quantization.m_offset.x, _quantization.m_offset.y, _quantization.m_offset.z };
+        GetQuantizationKernels().m_quantizePositions(reinterpret_cast<const f32*>(_positions.data()), _positions.size(), offset, inverseScale, reinterpret_cast<s16*>(_output.data()));
+    }
+
+    void EncodeOctahedral(std::span<const Float3> _normals, std::span<std::array<s16, 2>> _output)
+    {
+        KT_VERIFY(_output.size() >= _normals.size(), "Output too small");
+        GetQuantizationKernels().m_encodeOctahedral(reinterpret_cast<const f32*>(_normals.data()), _normals.size(), reinterpret_cast<s16*>(_output.data()));
+    }
+
+    void PackHalves(std::span<const Float2> _values, std::span<std::array<u16, 2>> _output)
+    {
+        KT_VERIFY(_output.size() >= _values.size(), "Output too small");
+        GetQuantizationKernels().m_packHalves(reinterpret_cast<const f32*>(_values.data()), _values.size() * 2, reinterpret_cast<u16*>(_output.data()));
+    }
+
+    void PackTangents(std::span<const Float4> _tangents, std::span<u32> _output)
+    {
+        KT_VERIFY(_output.size() >= _tangents.size(), "Output too small");
+        GetQuantizationKernels().m_packTangents(reinterpret_cast<const f32*>(_tangents.data()), _tangents.size(), _output.data());
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /// Values are stored in archives, see `PackFormat::EntryRecord::m_compression`.
+    enum class CompressionMethod: u8
+    {
+        None = 0,
+        /// LZ4 block format, decodable by any LZ4 implementation (`LZ4_decompress_safe`).
+        Lz4 = 1,
+        /// Zstandard frame, only available when the tools are built with libzstd.
+        Zstd = 2,
+    };
+
+    [[nodiscard]] const char* GetCompressionMethodName(CompressionMethod _method);
+    [[nodiscard]] std::optional<CompressionMethod> ParseCompressionMethod(std::string_view _name);
+    [[nodiscard]] bool IsCompressionMethodAvailable(CompressionMethod _method);
+
+    /**
+     * @brief Compresses a buffer as a single block.
+     * @param _high Spends more time for a denser output: deep match search for LZ4, level 19 for Zstd.
+     */
+    [[nodiscard]] std::vector<u8> Compress(CompressionMethod _method, std::span<const u8> _input, bool _high = false);
+
+    /// Decompresses a block to exactly `_output.size()` bytes, throws an `Error` on malformed input.
+    void Decompress(CompressionMethod _method, std::span<const u8> _input, std::span<u8> _output);
+}
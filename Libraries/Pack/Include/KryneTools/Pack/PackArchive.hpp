@@ -0,0 +1,43 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Pack/PackFormat.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Memory mapped `.kpak` archive.
+     *
+     * @details
+     * Opening validates the header and index, and lookups are binary searches over the index, so no entry data is
+     * touched until it is read.
+     */
+    class PackArchive
+    {
+    public:
+        /// Throws an `Error` on a malformed archive.
+        [[nodiscard]] static PackArchive Open(const std::filesystem::path& _path);
+
+        [[nodiscard]] std::span<const PackFormat::EntryRecord> GetEntries() const { return m_entries; }
+        [[nodiscard]] std::string_view GetName(const PackFormat::EntryRecord& _entry) const;
+
+        /// @return `nullptr` if the archive has no entry of that name.
+        [[nodiscard]] const PackFormat::EntryRecord* Find(std::string_view _name) const;
+
+        /// Stored bytes of the entry, in place in the mapping. They are the content itself for uncompressed entries.
+        [[nodiscard]] std::span<const u8> GetStoredData(const PackFormat::EntryRecord& _entry) const;
+
+        /// Decompresses the entry and checks its content hash.
+        [[nodiscard]] std::vector<u8> Read(const PackFormat::EntryRecord& _entry) const;
+
+    private:
+        MappedFile m_file;
+        std::span<const PackFormat::EntryRecord> m_entries;
+        std::string_view m_names;
+    };
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Pack/Compression.hpp"
+#include "KryneTools/Pack/PackFormat.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class JobSystem;
+
+    struct PackInput
+    {
+        /// Entry name, a relative path with `/` separators.
+        std::string m_name;
+        std::filesystem::path m_path;
+    };
+
+    struct PackSettings
+    {
+        CompressionMethod m_compression = CompressionMethod::Lz4;
+        /// Slower, denser compression, see `Compress()`.
+        bool m_highCompression = false;
+        /// Extensions (with the dot) of GPU ready files stored uncompressed so the runtime can upload them in place.
+        std::vector<std::string> m_uncompressedExtensions = { ".ktex", ".dds" };
+        /// Compressed entries saving less than this fraction of their size are stored uncompressed.
+        f32 m_minimumSaving = 0.05f;
+        /// Powers of two, entries of at least `m_largeEntrySize` stored bytes use `m_largeAlignment`.
+        u32 m_alignment = 4096;
+        u32 m_largeAlignment = 65536;
+        u32 m_largeEntrySize = 65536;
+        /// Stores byte-identical inputs once, their entries sharing the same data.
+        bool m_deduplicate = true;
+        /// Optional artifact cache of `BuildPack()`, looked up before packing and filled after. `PackWriter` ignores it,
+        /// its producers cache their own outputs.
+        ContentCache* m_cache = nullptr;
+    };
+
+    struct PackStatistics
+    {
+        u32 m_entryCount = 0;
+        u32 m_compressedEntryCount = 0;
+        u64 m_inputSize = 0;
+        u64 m_storedSize = 0;
+        u64 m_fileSize = 0;
+        /// Entries sharing the data of an identical earlier one, and the stored bytes they did not add.
+        u32 m_duplicateEntryCount = 0;
+        u64 m_duplicateSize = 0;
+        /// The archive was restored from the cache, its statistics read back from its index.
+        bool m_cacheHit = false;
+    };
+
+    /// Lists the files under `_directory` recursively as pack inputs named relative to `_root`, in path order.
+    void CollectPackInputs(const std::filesystem::path& _directory, const std::filesystem::path& _root, std::vector<PackInput>& _inputs);
+
+    /**
+     * @brief Writes the inputs as a `.kpak` archive, see `PackFormat` for the layout.
+     *
+     * @details
+     * Entry data keeps the order of `_inputs`, so related assets stay close, while the index is sorted by name hash.
+     * Inputs are read and compressed as jobs, in batches bounded in size so memory stays flat whatever the archive
+     * size, each batch being written while the next one compresses. Throws an `Error` on duplicate names.
+     *
+     * With `PackSettings::m_deduplicate`, every input is hashed first, and inputs byte-identical to an earlier one are
+     * neither compressed nor stored: their record points to the data of the first.
+     *
+     * With a cache, the key covers the name and content of every input, the settings and the tools build ID.
+     */
+    PackStatistics BuildPack(JobSystem& _jobSystem, const std::filesystem::path& _output, std::span<const PackInput> _inputs, const PackSettings& _settings);
+
+    /**
+     * @brief Writes a `.kpak` archive from inputs added one at a time, as the files are produced.
+     *
+     * @details
+     * For producers that do not know their outputs upfront, e.g. a cook streaming each asset once it is done. Entry
+     * data is in `Add()` order, and the index and names are written after the data on `Finish()`, which the format
+     * allows as every table is located through the header. Without a `Finish()` the archive is discarded.
+     *
+     * Deduplicates like `BuildPack()`, against the entries added so far.
+     */
+    class PackWriter
+    {
+    public:
+        /// Throws an `Error` on invalid settings, like `BuildPack()`.
+        PackWriter(const std::filesystem::path& _output, const PackSettings& _settings);
+
+        /**
+         * @brief Reads and compresses an input on the calling thread, then appends it.
+         * @details Thread safe, so every producer job can add its own outputs. Throws an `Error` on duplicate names.
+         */
+        void Add(const PackInput& _input);
+
+        PackStatistics Finish();
+
+    private:
+        struct StoredContent
+        {
+            u64 m_size = 0;
+            size_t m_record = 0;
+            std::filesystem::path m_path;
+        };
+
+        /// Record of an earlier entry byte-identical to `_input`, or `nullptr`. Must be called locked.
+        [[nodiscard]] const PackFormat::EntryRecord* FindStoredContent(const PackInput& _input, u64 _contentHash, u64 _size) const;
+
+        PackSettings m_settings;
+        FileWriter m_writer;
+        std::mutex m_mutex;
+        std::vector<PackFormat::EntryRecord> m_records;
+        std::string m_names;
+        std::unordered_set<std::string> m_nameSet;
+        /// By content hash.
+        std::unordered_multimap<u64, StoredContent> m_storedContents;
+        PackStatistics m_statistics;
+    };
+}
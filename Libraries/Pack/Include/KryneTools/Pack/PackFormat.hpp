@@ -0,0 +1,62 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine asset archives (`.kpak`).
+ *
+ * A file is a fixed header, the entry index, the name table, then the entry data. The index and the names sit at the
+ * front so a loader maps the archive and finds any entry with a binary search over `EntryRecord::m_nameHash`, without
+ * touching the data pages. Archives streamed by `PackWriter` put them after the data instead: loaders must only rely
+ * on the header offsets. Entry data starts on `Header::m_alignment` boundaries, or `Header::m_largeAlignment` ones
+ * for entries of at least `Header::m_largeEntrySize` stored bytes, so uncompressed entries can be referenced in place
+ * or read with unbuffered I/O. Entries of identical content may share the same stored bytes, loaders must not assume
+ * entry data ranges are disjoint.
+ *
+ * All values are little-endian.
+ */
+namespace KryneTools::PackFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'P', 'A', 'K');
+    constexpr u16 kVersion = 1;
+    /// Seed of `EntryRecord::m_nameHash`, the XXH64 of the entry name bytes.
+    constexpr u64 kNameHashSeed = 0;
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u32 m_entryCount;
+        u32 m_alignment;
+        u32 m_largeAlignment;
+        u32 m_largeEntrySize;
+        /// `EntryRecord[m_entryCount]`, sorted by name hash, then by name.
+        u64 m_indexOffset;
+        /// Name characters, referenced by `EntryRecord::m_nameOffset`. Names are relative paths with `/` separators.
+        u64 m_namesOffset;
+        u64 m_namesSize;
+        u64 m_dataOffset;
+        u64 m_fileSize;
+    };
+    static_assert(sizeof(Header) == 64);
+
+    struct EntryRecord
+    {
+        u64 m_nameHash;
+        /// XXH64 of the uncompressed content.
+        u64 m_contentHash;
+        /// Absolute offset of the stored bytes.
+        u64 m_offset;
+        u64 m_storedSize;
+        /// Uncompressed size.
+        u64 m_size;
+        u32 m_nameOffset;
+        u16 m_nameLength;
+        /// A `CompressionMethod`, the whole entry is a single compressed block.
+        u8 m_compression;
+        u8 m_reserved;
+    };
+    static_assert(sizeof(EntryRecord) == 48);
+}
@@ -0,0 +1,102 @@
+#include "KryneTools/Pack/Compression.hpp"
+
+#include "KryneTools/Common/Error.hpp"
+#include "Lz4.hpp"
+
+#if defined(KRYNE_TOOLS_HAS_ZSTD)
+    #include <zstd.h>
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kLz4FastSearchDepth = 1;
+        constexpr u32 kLz4HighSearchDepth = 64;
+#if defined(KRYNE_TOOLS_HAS_ZSTD)
+        constexpr int kZstdFastLevel = 3;
+        constexpr int kZstdHighLevel = 19;
+#endif
+    }
+
+    const char* GetCompressionMethodName(CompressionMethod _method)
+    {
+        switch (_method)
+        {
+        case CompressionMethod::None: return "none";
+        case CompressionMethod::Lz4: return "lz4";
+        case CompressionMethod::Zstd: return "zstd";
+        }
+        return "unknown";
+    }
+
+    std::optional<CompressionMethod> ParseCompressionMethod(std::string_view _name)
+    {
+        for (const CompressionMethod method: { CompressionMethod::None, CompressionMethod::Lz4, CompressionMethod::Zstd })
+        {
+            if (_name == GetCompressionMethodName(method))
+            {
+                return method;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool IsCompressionMethodAvailable(CompressionMethod _method)
+    {
+#if defined(KRYNE_TOOLS_HAS_ZSTD)
+        return _method <= CompressionMethod::Zstd;
+#else
+        return _method <= CompressionMethod::Lz4;
+#endif
+    }
+
+    std::vector<u8> Compress(CompressionMethod _method, std::span<const u8> _input, bool _high)
+    {
+        switch (_method)
+        {
+        case CompressionMethod::None:
+            return { _input.begin(), _input.end() };
+        case CompressionMethod::Lz4:
+            return Lz4::CompressBlock(_input, _high ? kLz4HighSearchDepth : kLz4FastSearchDepth);
+        case CompressionMethod::Zstd:
+#if defined(KRYNE_TOOLS_HAS_ZSTD)
+        {
+            std::vector<u8> output(ZSTD_compressBound(_input.size()));
+            const size_t size = ZSTD_compress(output.data(), output.size(), _input.data(), _input.size(), _high ? kZstdHighLevel : kZstdFastLevel);
+            KT_VERIFY(!ZSTD_isError(size), "Zstd compression failed: %s", ZSTD_getErrorName(size));
+            output.resize(size);
+            return output;
+        }
+#else
+            ThrowError("Zstd compression is not available, the tools were built without libzstd");
+#endif
+        }
+        ThrowError("Unknown compression method %u", u32(_method));
+    }
+
+    void Decompress(CompressionMethod _method, std::span<const u8> _input, std::span<u8> _output)
+    {
+        switch (_method)
+        {
+        case CompressionMethod::None:
+            KT_VERIFY(_input.size() == _output.size(), "Stored size mismatch (%zu bytes, expected %zu)", _input.size(), _output.size());
+            std::copy(_input.begin(), _input.end(), _output.begin());
+            return;
+        case CompressionMethod::Lz4:
+            KT_VERIFY(Lz4::DecompressBlock(_input, _output), "Malformed LZ4 block");
+            return;
+        case CompressionMethod::Zstd:
+#if defined(KRYNE_TOOLS_HAS_ZSTD)
+        {
+            const size_t size = ZSTD_decompress(_output.data(), _output.size(), _input.data(), _input.size());
+            KT_VERIFY(!ZSTD_isError(size) && size == _output.size(), "Malformed Zstd frame");
+            return;
+        }
+#else
+            ThrowError("Zstd decompression is not available, the tools were built without libzstd");
+#endif
+        }
+        ThrowError("Unknown compression method %u", u32(_method));
+    }
+}
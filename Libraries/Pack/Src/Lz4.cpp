@@ -0,0 +1,256 @@
+#include "Lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace KryneTools::Lz4
+{
+    namespace
+    {
+        constexpr u32 kMinMatch = 4;
+        /// The last match must start this many bytes before the end of the block.
+        constexpr u64 kMatchFindLimit = 12;
+        /// The block always ends with this many literals.
+        constexpr u64 kLastLiterals = 5;
+        constexpr u64 kMaxOffset = 65535;
+        constexpr u32 kHashBits = 16;
+        constexpr u32 kWindowMask = 65535;
+        constexpr u32 kNoPosition = ~0u;
+
+        u32 Read32(const u8* _data)
+        {
+            u32 value;
+            std::memcpy(&value, _data, sizeof(value));
+            return value;
+        }
+
+        u32 HashSequence(u32 _sequence)
+        {
+            return (_sequence * 2654435761u) >> (32 - kHashBits);
+        }
+
+        class SequenceWriter
+        {
+        public:
+            explicit SequenceWriter(u64 _inputSize)
+            {
+                m_output.reserve(GetCompressBound(_inputSize));
+            }
+
+            void Write(const u8* _literals, u64 _literalCount, u64 _offset, u64 _matchLength)
+            {
+                const u64 matchCode = _matchLength == 0 ? 0 : _matchLength - kMinMatch;
+                m_output.push_back(u8((std::min<u64>(_literalCount, 15) << 4) | std::min<u64>(matchCode, 15)));
+                if (_literalCount >= 15)
+                {
+                    WriteLength(_literalCount - 15);
+                }
+                m_output.insert(m_output.end(), _literals, _literals + _literalCount);
+                if (_matchLength == 0)
+                {
+                    return;
+                }
+                m_output.push_back(u8(_offset));
+                m_output.push_back(u8(_offset >> 8));
+                if (matchCode >= 15)
+                {
+                    WriteLength(matchCode - 15);
+                }
+            }
+
+            [[nodiscard]] std::vector<u8> Finish() { return std::move(m_output); }
+
+        private:
+            std::vector<u8> m_output;
+
+            void WriteLength(u64 _length)
+            {
+                for (; _length >= 255; _length -= 255)
+                {
+                    m_output.push_back(255);
+                }
+                m_output.push_back(u8(_length));
+            }
+        };
+    }
+
+    std::vector<u8> CompressBlock(std::span<const u8> _input, u32 _searchDepth)
+    {
+        const u8* input = _input.data();
+        const u64 size = _input.size();
+        SequenceWriter writer(size);
+        if (size <= kMatchFindLimit)
+        {
+            writer.Write(input, size, 0, 0);
+            return writer.Finish();
+        }
+
+        // Hash heads and, for deeper searches, chains linking every position of the window to the previous one with
+        // the same hash.
+        std::vector<u32> heads(size_t(1) << kHashBits, kNoPosition);
+        std::vector<u32> chain(_searchDepth > 1 ? kWindowMask + 1 : 0, kNoPosition);
+        u64 inserted = 0;
+        const auto insertUpTo = [&](u64 _position)
+        {
+            for (; inserted < _position; inserted++)
+            {
+                const u32 hash = HashSequence(Read32(input + inserted));
+                if (!chain.empty())
+                {
+                    chain[inserted & kWindowMask] = heads[hash];
+                }
+                heads[hash] = u32(inserted);
+            }
+        };
+
+        const u64 matchLimit = size - kLastLiterals;
+        const u64 searchLimit = size - kMatchFindLimit;
+        u64 anchor = 0;
+        u64 position = 0;
+        u32 missCount = 0;
+        while (position <= searchLimit)
+        {
+            insertUpTo(position);
+            u64 bestLength = 0;
+            u64 bestReference = 0;
+            u32 candidate = heads[HashSequence(Read32(input + position))];
+            for (u32 depth = 0; depth < _searchDepth && candidate != kNoPosition && position - candidate <= kMaxOffset; depth++)
+            {
+                if (Read32(input + candidate) == Read32(input + position))
+                {
+                    u64 length = kMinMatch;
+                    while (position + length < matchLimit && input[candidate + length] == input[position + length])
+                    {
+                        length++;
+                    }
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestReference = candidate;
+                    }
+                }
+                if (chain.empty())
+                {
+                    break;
+                }
+                const u32 previous = chain[candidate & kWindowMask];
+                if (previous == kNoPosition || previous >= candidate)
+                {
+                    break;
+                }
+                candidate = previous;
+            }
+            insertUpTo(position + 1);
+
+            if (bestLength == 0)
+            {
+                // Skip faster through incompressible data, like the reference compressor.
+                position += 1 + (missCount++ >> 6);
+                continue;
+            }
+            missCount = 0;
+
+            // Extend the match backwards over literals.
+            while (position > anchor && bestReference > 0 && input[position - 1] == input[bestReference - 1])
+            {
+                position--;
+                bestReference--;
+                bestLength++;
+            }
+
+            writer.Write(input + anchor, position - anchor, position - bestReference, bestLength);
+            position += bestLength;
+            anchor = position;
+            if (position <= searchLimit)
+            {
+                insertUpTo(position);
+            }
+            else
+            {
+                inserted = position;
+            }
+        }
+        writer.Write(input + anchor, size - anchor, 0, 0);
+        return writer.Finish();
+    }
+
+    bool DecompressBlock(std::span<const u8> _input, std::span<u8> _output)
+    {
+        const u8* input = _input.data();
+        const u64 inputSize = _input.size();
+        u8* output = _output.data();
+        const u64 outputSize = _output.size();
+        u64 in = 0;
+        u64 out = 0;
+
+        const auto readLength = [&](u64& _length) -> bool
+        {
+            u8 byte;
+            do
+            {
+                if (in >= inputSize)
+                {
+                    return false;
+                }
+                byte = input[in++];
+                _length += byte;
+            }
+            while (byte == 255);
+            return true;
+        };
+
+        while (in < inputSize)
+        {
+            const u8 token = input[in++];
+            u64 literalCount = token >> 4;
+            if (literalCount == 15 && !readLength(literalCount))
+            {
+                return false;
+            }
+            if (literalCount > inputSize - in || literalCount > outputSize - out)
+            {
+                return false;
+            }
+            std::memcpy(output + out, input + in, literalCount);
+            in += literalCount;
+            out += literalCount;
+            if (in == inputSize)
+            {
+                // The last sequence has no match.
+                break;
+            }
+
+            if (inputSize - in < 2)
+            {
+                return false;
+            }
+            const u64 offset = u64(input[in]) | (u64(input[in + 1]) << 8);
+            in += 2;
+            u64 matchLength = token & 15;
+            if (matchLength == 15 && !readLength(matchLength))
+            {
+                return false;
+            }
+            matchLength += kMinMatch;
+            if (offset == 0 || offset > out || matchLength > outputSize - out)
+            {
+                return false;
+            }
+            // Matches closer than their length overlap their own output, they repeat the last `offset` bytes.
+            const u8* source = output + out - offset;
+            if (offset >= matchLength)
+            {
+                std::memcpy(output + out, source, matchLength);
+            }
+            else
+            {
+                for (u64 i = 0; i < matchLength; i++)
+                {
+                    output[out + i] = source[i];
+                }
+            }
+            out += matchLength;
+        }
+        return out == outputSize;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools::Lz4
+{
+    /// Worst case size of a compressed block, for incompressible input.
+    [[nodiscard]] constexpr u64 GetCompressBound(u64 _size) { return _size + _size / 255 + 16; }
+
+    /// @param _searchDepth Match candidates visited per position, 1 is the classic single probe compressor.
+    [[nodiscard]] std::vector<u8> CompressBlock(std::span<const u8> _input, u32 _searchDepth);
+
+    /// @return `false` if the block is malformed or does not decode to exactly `_output.size()` bytes.
+    [[nodiscard]] bool DecompressBlock(std::span<const u8> _input, std::span<u8> _output);
+}
@@ -0,0 +1,76 @@
+#include "KryneTools/Pack/PackArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Pack/Compression.hpp"
+
+namespace KryneTools
+{
+    PackArchive PackArchive::Open(const std::filesystem::path& _path)
+    {
+        PackArchive archive;
+        archive.m_file = MappedFile::Open(_path);
+        const std::span<const u8> data = archive.m_file.GetData();
+        const std::string pathString = _path.string();
+        const char* path = pathString.c_str();
+
+        PackFormat::Header header;
+        KT_VERIFY(data.size() >= sizeof(header), "%s: truncated header", path);
+        std::memcpy(&header, data.data(), sizeof(header));
+        KT_VERIFY(header.m_magic == PackFormat::kMagic, "%s: not a kpak archive", path);
+        KT_VERIFY(header.m_version == PackFormat::kVersion, "%s: unsupported version %u", path, u32(header.m_version));
+        KT_VERIFY(header.m_fileSize == data.size(), "%s: size mismatch", path);
+        KT_VERIFY(header.m_indexOffset % alignof(PackFormat::EntryRecord) == 0, "%s: misaligned index", path);
+        KT_VERIFY(
+            header.m_indexOffset <= data.size() && u64(header.m_entryCount) * sizeof(PackFormat::EntryRecord) <= data.size() - header.m_indexOffset,
+            "%s: truncated index",
+            path);
+        KT_VERIFY(header.m_namesOffset <= data.size() && header.m_namesSize <= data.size() - header.m_namesOffset, "%s: truncated names", path);
+
+        // The mapping is page aligned, so are the records.
+        archive.m_entries = { reinterpret_cast<const PackFormat::EntryRecord*>(data.data() + header.m_indexOffset), header.m_entryCount };
+        archive.m_names = { reinterpret_cast<const char*>(data.data() + header.m_namesOffset), header.m_namesSize };
+        for (const PackFormat::EntryRecord& entry: archive.m_entries)
+        {
+            KT_VERIFY(entry.m_offset <= data.size() && entry.m_storedSize <= data.size() - entry.m_offset, "%s: entry data out of bounds", path);
+            KT_VERIFY(u64(entry.m_nameOffset) + entry.m_nameLength <= archive.m_names.size(), "%s: entry name out of bounds", path);
+        }
+        return archive;
+    }
+
+    std::string_view PackArchive::GetName(const PackFormat::EntryRecord& _entry) const
+    {
+        return m_names.substr(_entry.m_nameOffset, _entry.m_nameLength);
+    }
+
+    const PackFormat::EntryRecord* PackArchive::Find(std::string_view _name) const
+    {
+        const u64 hash = Hash64(_name.data(), _name.size(), PackFormat::kNameHashSeed);
+        const auto [first, last] = std::ranges::equal_range(m_entries, hash, {}, &PackFormat::EntryRecord::m_nameHash);
+        for (auto it = first; it != last; ++it)
+        {
+            if (GetName(*it) == _name)
+            {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    std::span<const u8> PackArchive::GetStoredData(const PackFormat::EntryRecord& _entry) const
+    {
+        return m_file.GetData().subspan(_entry.m_offset, _entry.m_storedSize);
+    }
+
+    std::vector<u8> PackArchive::Read(const PackFormat::EntryRecord& _entry) const
+    {
+        std::vector<u8> content(_entry.m_size);
+        Decompress(CompressionMethod(_entry.m_compression), GetStoredData(_entry), content);
+        KT_VERIFY(Hash64(content) == _entry.m_contentHash, "Corrupted pack entry '%.*s'", int(_entry.m_nameLength), GetName(_entry).data());
+        return content;
+    }
+}
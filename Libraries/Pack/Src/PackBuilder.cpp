@@ -0,0 +1,537 @@
+#include "KryneTools/Pack/PackBuilder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Pack/PackArchive.hpp"
+#include "KryneTools/Pack/PackFormat.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Input bytes read and compressed ahead of the writer.
+        constexpr u64 kBatchInputSize = 256ull << 20;
+        constexpr size_t kBatchEntryCount = 4096;
+        constexpr u32 kNotDuplicate = ~0u;
+
+        struct PreparedEntry
+        {
+            /// Source mapping of uncompressed entries, written straight from it.
+            MappedFile m_source;
+            std::vector<u8> m_compressed;
+            CompressionMethod m_method = CompressionMethod::None;
+            u64 m_size = 0;
+            u64 m_contentHash = 0;
+
+            [[nodiscard]] std::span<const u8> GetStoredData() const
+            {
+                return m_method == CompressionMethod::None ? m_source.GetData() : std::span<const u8>(m_compressed);
+            }
+        };
+
+        bool IsUncompressedExtension(const PackSettings& _settings, const std::filesystem::path& _path)
+        {
+            const std::string extension = _path.extension().string();
+            return std::ranges::find(_settings.m_uncompressedExtensions, extension) != _settings.m_uncompressedExtensions.end();
+        }
+
+        /// Maps the source and hashes its content, unless already known.
+        void OpenEntry(const PackInput& _input, std::optional<u64> _contentHash, PreparedEntry& _entry)
+        {
+            _entry.m_source = MappedFile::Open(_input.m_path);
+            const std::span<const u8> data = _entry.m_source.GetData();
+            _entry.m_size = data.size();
+            _entry.m_contentHash = _contentHash.has_value() ? *_contentHash : Hash64(data);
+        }
+
+        void CompressEntry(const PackInput& _input, const PackSettings& _settings, PreparedEntry& _entry)
+        {
+            const std::span<const u8> data = _entry.m_source.GetData();
+            if (_settings.m_compression == CompressionMethod::None || data.empty() || IsUncompressedExtension(_settings, _input.m_path))
+            {
+                return;
+            }
+
+            std::vector<u8> compressed = Compress(_settings.m_compression, data, _settings.m_highCompression);
+            if (f64(compressed.size()) <= f64(data.size()) * (1.0 - _settings.m_minimumSaving))
+            {
+                _entry.m_compressed = std::move(compressed);
+                _entry.m_method = _settings.m_compression;
+                _entry.m_source = {};
+            }
+        }
+
+        void PrepareEntry(const PackInput& _input, const PackSettings& _settings, std::optional<u64> _contentHash, PreparedEntry& _entry)
+        {
+            KT_TRACE_ZONE_DETAIL("PrepareEntry", _input.m_name);
+            OpenEntry(_input, _contentHash, _entry);
+            CompressEntry(_input, _settings, _entry);
+        }
+
+        bool HaveSameContent(const std::filesystem::path& _a, const std::filesystem::path& _b)
+        {
+            const MappedFile a = MappedFile::Open(_a);
+            const MappedFile b = MappedFile::Open(_b);
+            return a.GetSize() == b.GetSize() && (a.GetSize() == 0 || std::memcmp(a.GetData().data(), b.GetData().data(), a.GetSize()) == 0);
+        }
+
+        /**
+         * @brief Hashes every input, and finds those byte-identical to an earlier one.
+         * @details Inputs of equal hash and size are compared in full, so a hash collision never merges two entries.
+         */
+        void FindDuplicates(JobSystem& _jobSystem, std::span<const PackInput> _inputs, std::vector<u64>& _contentHashes, std::vector<u32>& _duplicateOf)
+        {
+            KT_TRACE_ZONE("FindDuplicates");
+            _contentHashes.assign(_inputs.size(), 0);
+            _duplicateOf.assign(_inputs.size(), kNotDuplicate);
+            std::vector<u64> sizes(_inputs.size());
+            _jobSystem.ParallelFor(_inputs.size(), 1, [&](u64 _begin, u64 _end)
+            {
+                for (u64 i = _begin; i < _end; i++)
+                {
+                    const MappedFile source = MappedFile::Open(_inputs[i].m_path);
+                    sizes[i] = source.GetSize();
+                    _contentHashes[i] = Hash64(source.GetData());
+                }
+            });
+
+            std::unordered_map<u64, u32> firstByHash;
+            std::vector<std::pair<u32, u32>> candidates;
+            for (u32 i = 0; i < u32(_inputs.size()); i++)
+            {
+                const auto [first, inserted] = firstByHash.try_emplace(_contentHashes[i], i);
+                if (!inserted && sizes[first->second] == sizes[i])
+                {
+                    candidates.emplace_back(i, first->second);
+                }
+            }
+            _jobSystem.ParallelFor(candidates.size(), 1, [&](u64 _begin, u64 _end)
+            {
+                for (u64 c = _begin; c < _end; c++)
+                {
+                    const auto [duplicate, original] = candidates[c];
+                    if (HaveSameContent(_inputs[original].m_path, _inputs[duplicate].m_path))
+                    {
+                        _duplicateOf[duplicate] = original;
+                    }
+                }
+            });
+        }
+
+        /// Ranges of consecutive inputs, bounded in size and count.
+        std::vector<std::pair<size_t, size_t>> SplitBatches(std::span<const PackInput> _inputs, std::span<const u32> _duplicateOf)
+        {
+            std::vector<std::pair<size_t, size_t>> batches;
+            size_t begin = 0;
+            u64 size = 0;
+            for (size_t i = 0; i < _inputs.size(); i++)
+            {
+                // Duplicates are not read again.
+                size += _duplicateOf.empty() || _duplicateOf[i] == kNotDuplicate ? std::filesystem::file_size(_inputs[i].m_path) : 0;
+                if (size >= kBatchInputSize || i + 1 - begin >= kBatchEntryCount || i + 1 == _inputs.size())
+                {
+                    batches.emplace_back(begin, i + 1);
+                    begin = i + 1;
+                    size = 0;
+                }
+            }
+            return batches;
+        }
+
+        void VerifySettings(const PackSettings& _settings)
+        {
+            KT_VERIFY(
+                std::has_single_bit(_settings.m_alignment) && std::has_single_bit(_settings.m_largeAlignment),
+                "Pack alignments must be powers of two (%u, %u)",
+                _settings.m_alignment,
+                _settings.m_largeAlignment);
+            KT_VERIFY(IsCompressionMethodAvailable(_settings.m_compression), "Compression method %s is not available in this build", GetCompressionMethodName(_settings.m_compression));
+        }
+
+        CacheKey MakeCacheKey(JobSystem& _jobSystem, const std::filesystem::path& _output, std::span<const PackInput> _inputs, const PackSettings& _settings)
+        {
+            CacheKeyBuilder builder("kryne-pack");
+            builder.AddU64(PackFormat::kVersion);
+            builder.AddU64(u64(_settings.m_compression));
+            builder.AddU64(_settings.m_highCompression ? 1 : 0);
+            builder.AddU64(_settings.m_uncompressedExtensions.size());
+            for (const std::string& extension: _settings.m_uncompressedExtensions)
+            {
+                builder.AddString(extension);
+            }
+            builder.AddU64(std::bit_cast<u32>(_settings.m_minimumSaving));
+            builder.AddU64(_settings.m_alignment);
+            builder.AddU64(_settings.m_largeAlignment);
+            builder.AddU64(_settings.m_largeEntrySize);
+            builder.AddU64(_settings.m_deduplicate ? 1 : 0);
+            builder.AddU64(_inputs.size());
+            for (const PackInput& input: _inputs)
+            {
+                builder.AddString(input.m_name);
+                builder.AddFile(_jobSystem, input.m_path);
+            }
+            builder.AddString(_output.filename().generic_string());
+            return builder.Build();
+        }
+
+        /// Statistics of a restored archive, from its index. Entries sharing stored bytes are the duplicates.
+        PackStatistics ReadRestoredStatistics(const std::filesystem::path& _output)
+        {
+            const PackArchive archive = PackArchive::Open(_output);
+            std::vector<PackFormat::EntryRecord> entries(archive.GetEntries().begin(), archive.GetEntries().end());
+            std::ranges::sort(entries, [](const PackFormat::EntryRecord& _a, const PackFormat::EntryRecord& _b) { return _a.m_offset < _b.m_offset; });
+
+            PackStatistics statistics;
+            statistics.m_entryCount = u32(entries.size());
+            statistics.m_fileSize = std::filesystem::file_size(_output);
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                const PackFormat::EntryRecord& entry = entries[i];
+                statistics.m_inputSize += entry.m_size;
+                statistics.m_compressedEntryCount += CompressionMethod(entry.m_compression) != CompressionMethod::None ? 1 : 0;
+                if (i > 0 && entry.m_offset == entries[i - 1].m_offset && entry.m_storedSize > 0)
+                {
+                    statistics.m_duplicateEntryCount++;
+                    statistics.m_duplicateSize += entry.m_storedSize;
+                }
+                else
+                {
+                    statistics.m_storedSize += entry.m_storedSize;
+                }
+            }
+            statistics.m_cacheHit = true;
+            return statistics;
+        }
+
+        PackFormat::Header MakeHeader(const PackSettings& _settings, u32 _entryCount)
+        {
+            PackFormat::Header header {};
+            header.m_magic = PackFormat::kMagic;
+            header.m_version = PackFormat::kVersion;
+            header.m_headerSize = sizeof(PackFormat::Header);
+            header.m_entryCount = _entryCount;
+            header.m_alignment = _settings.m_alignment;
+            header.m_largeAlignment = _settings.m_largeAlignment;
+            header.m_largeEntrySize = _settings.m_largeEntrySize;
+            return header;
+        }
+
+        /// Appends the stored bytes of an entry at its alignment and fills the data fields of its record.
+        void WriteEntry(FileWriter& _writer, const PackSettings& _settings, const std::string& _name, const PreparedEntry& _entry, PackFormat::EntryRecord& _record, PackStatistics& _statistics)
+        {
+            KT_TRACE_ZONE_DETAIL("WriteEntry", _name);
+            const std::span<const u8> stored = _entry.GetStoredData();
+            _writer.Align(stored.size() >= _settings.m_largeEntrySize ? _settings.m_largeAlignment : _settings.m_alignment);
+
+            _record.m_contentHash = _entry.m_contentHash;
+            _record.m_offset = _writer.Tell();
+            _record.m_storedSize = stored.size();
+            _record.m_size = _entry.m_size;
+            _record.m_compression = u8(_entry.m_method);
+            _writer.WriteSpan(stored);
+
+            _statistics.m_inputSize += _entry.m_size;
+            _statistics.m_storedSize += stored.size();
+            _statistics.m_compressedEntryCount += _entry.m_method != CompressionMethod::None ? 1 : 0;
+            Log::Verbose("%s: %s, %llu -> %llu bytes", _name.c_str(), GetCompressionMethodName(_entry.m_method), static_cast<unsigned long long>(_entry.m_size), static_cast<unsigned long long>(stored.size()));
+        }
+
+        /// Points the record of a duplicate to the data of the original entry.
+        void WriteDuplicate(const std::string& _name, const std::string& _originalName, const PackFormat::EntryRecord& _original, PackFormat::EntryRecord& _record, PackStatistics& _statistics)
+        {
+            _record.m_contentHash = _original.m_contentHash;
+            _record.m_offset = _original.m_offset;
+            _record.m_storedSize = _original.m_storedSize;
+            _record.m_size = _original.m_size;
+            _record.m_compression = _original.m_compression;
+
+            _statistics.m_inputSize += _original.m_size;
+            _statistics.m_compressedEntryCount += CompressionMethod(_original.m_compression) != CompressionMethod::None ? 1 : 0;
+            _statistics.m_duplicateEntryCount++;
+            _statistics.m_duplicateSize += _original.m_storedSize;
+            Log::Verbose("%s: duplicate of %s, %llu bytes", _name.c_str(), _originalName.c_str(), static_cast<unsigned long long>(_original.m_size));
+        }
+    }
+
+    void CollectPackInputs(const std::filesystem::path& _directory, const std::filesystem::path& _root, std::vector<PackInput>& _inputs)
+    {
+        std::vector<std::filesystem::path> files;
+        for (const std::filesystem::directory_entry& entry: std::filesystem::recursive_directory_iterator(_directory))
+        {
+            if (entry.is_regular_file())
+            {
+                files.push_back(entry.path());
+            }
+        }
+        std::ranges::sort(files);
+        for (std::filesystem::path& file: files)
+        {
+            std::string name = file.lexically_relative(_root).generic_string();
+            _inputs.push_back({ std::move(name), std::move(file) });
+        }
+    }
+
+    PackStatistics BuildPack(JobSystem& _jobSystem, const std::filesystem::path& _output, std::span<const PackInput> _inputs, const PackSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("BuildPack", _output.string());
+        VerifySettings(_settings);
+        KT_VERIFY(_inputs.size() < ~0u, "Too many pack entries (%zu)", _inputs.size());
+
+        const std::filesystem::path outputDirectory = _output.has_parent_path() ? _output.parent_path() : std::filesystem::path(".");
+        CacheKey cacheKey;
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            cacheKey = MakeCacheKey(_jobSystem, _output, _inputs, _settings);
+            if (_settings.m_cache->Restore(cacheKey, outputDirectory))
+            {
+                Log::Verbose("%s: restored from cache (%s)", _output.string().c_str(), cacheKey.ToString().c_str());
+                return ReadRestoredStatistics(_output);
+            }
+        }
+
+        // Index order: by name hash, then by name for the (unlikely) collisions.
+        std::vector<u64> nameHashes(_inputs.size());
+        for (size_t i = 0; i < _inputs.size(); i++)
+        {
+            const std::string& name = _inputs[i].m_name;
+            KT_VERIFY(!name.empty() && name.size() <= 0xFFFF, "Invalid pack entry name '%s'", name.c_str());
+            nameHashes[i] = Hash64(name.data(), name.size(), PackFormat::kNameHashSeed);
+        }
+        std::vector<u32> order(_inputs.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::sort(order, [&](u32 _a, u32 _b)
+        {
+            return nameHashes[_a] != nameHashes[_b] ? nameHashes[_a] < nameHashes[_b] : _inputs[_a].m_name < _inputs[_b].m_name;
+        });
+
+        std::vector<PackFormat::EntryRecord> records(_inputs.size());
+        std::string names;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const PackInput& input = _inputs[order[i]];
+            KT_VERIFY(i == 0 || input.m_name != _inputs[order[i - 1]].m_name, "Duplicate pack entry '%s'", input.m_name.c_str());
+            PackFormat::EntryRecord& record = records[order[i]];
+            record.m_nameHash = nameHashes[order[i]];
+            record.m_nameOffset = u32(names.size());
+            record.m_nameLength = u16(input.m_name.size());
+            names += input.m_name;
+        }
+        KT_VERIFY(names.size() <= ~0u, "Pack entry names exceed 4 GiB");
+
+        PackFormat::Header header = MakeHeader(_settings, u32(_inputs.size()));
+        header.m_indexOffset = sizeof(PackFormat::Header);
+        header.m_namesOffset = header.m_indexOffset + records.size() * sizeof(PackFormat::EntryRecord);
+        header.m_namesSize = names.size();
+        header.m_dataOffset = AlignUp(header.m_namesOffset + header.m_namesSize, _settings.m_alignment);
+
+        // Archives are large and read by the runtime, not by the tools: unbuffered writes keep them out of the page cache.
+        // The header and index are written again once the data offsets are known.
+        FileWriter writer(_output, true);
+        writer.WritePod(header);
+        writer.WriteSpan(std::span<const PackFormat::EntryRecord>(records));
+        writer.Write(names.data(), names.size());
+        writer.Align(_settings.m_alignment);
+
+        PackStatistics statistics;
+        statistics.m_entryCount = u32(_inputs.size());
+
+        std::vector<u64> contentHashes;
+        std::vector<u32> duplicateOf;
+        if (_settings.m_deduplicate)
+        {
+            FindDuplicates(_jobSystem, _inputs, contentHashes, duplicateOf);
+        }
+        const auto isDuplicate = [&](size_t _index) { return !duplicateOf.empty() && duplicateOf[_index] != kNotDuplicate; };
+
+        // Batch n + 1 is read and compressed on the workers while this thread writes batch n.
+        const std::vector<std::pair<size_t, size_t>> batches = SplitBatches(_inputs, duplicateOf);
+        std::vector<PreparedEntry> prepared[2];
+        JobGroup group;
+        const auto prepareBatch = [&](size_t _batch)
+        {
+            std::vector<PreparedEntry>& entries = prepared[_batch % 2];
+            const auto [begin, end] = batches[_batch];
+            entries.clear();
+            entries.resize(end - begin);
+            for (size_t i = begin; i < end; i++)
+            {
+                if (isDuplicate(i))
+                {
+                    continue;
+                }
+                _jobSystem.Spawn(group, [&, i, target = &entries[i - begin]]
+                {
+                    PrepareEntry(_inputs[i], _settings, contentHashes.empty() ? std::nullopt : std::optional(contentHashes[i]), *target);
+                });
+            }
+        };
+        if (!batches.empty())
+        {
+            prepareBatch(0);
+        }
+        for (size_t b = 0; b < batches.size(); b++)
+        {
+            _jobSystem.Wait(group);
+            if (b + 1 < batches.size())
+            {
+                prepareBatch(b + 1);
+            }
+
+            const auto [begin, end] = batches[b];
+            std::vector<PreparedEntry>& entries = prepared[b % 2];
+            for (size_t i = begin; i < end; i++)
+            {
+                if (isDuplicate(i))
+                {
+                    // The original comes first in data order, so its record is complete.
+                    WriteDuplicate(_inputs[i].m_name, _inputs[duplicateOf[i]].m_name, records[duplicateOf[i]], records[i], statistics);
+                    continue;
+                }
+                PreparedEntry& entry = entries[i - begin];
+                WriteEntry(writer, _settings, _inputs[i].m_name, entry, records[i], statistics);
+                entry = {};
+            }
+        }
+        writer.Align(_settings.m_alignment);
+        header.m_fileSize = writer.Tell();
+        statistics.m_fileSize = header.m_fileSize;
+
+        std::vector<PackFormat::EntryRecord> index(records.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            index[i] = records[order[i]];
+        }
+        writer.Seek(0);
+        writer.WritePod(header);
+        writer.WriteSpan(std::span<const PackFormat::EntryRecord>(index));
+        writer.Commit();
+
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            _settings.m_cache->Store(cacheKey, outputDirectory, std::span(&_output, 1));
+        }
+        return statistics;
+    }
+
+    PackWriter::PackWriter(const std::filesystem::path& _output, const PackSettings& _settings)
+        : m_settings(_settings)
+        , m_writer(_output, true)
+    {
+        VerifySettings(m_settings);
+
+        // The header is rewritten on `Finish()`, entry data starts right after it.
+        const PackFormat::Header header = MakeHeader(m_settings, 0);
+        m_writer.WritePod(header);
+        m_writer.Align(m_settings.m_alignment);
+    }
+
+    void PackWriter::Add(const PackInput& _input)
+    {
+        KT_VERIFY(!_input.m_name.empty() && _input.m_name.size() <= 0xFFFF, "Invalid pack entry name '%s'", _input.m_name.c_str());
+        KT_TRACE_ZONE_DETAIL("PackWriter::Add", _input.m_name);
+        PreparedEntry entry;
+        OpenEntry(_input, std::nullopt, entry);
+
+        const auto addRecord = [&]() -> PackFormat::EntryRecord&
+        {
+            PackFormat::EntryRecord& record = m_records.emplace_back();
+            record.m_nameHash = Hash64(_input.m_name.data(), _input.m_name.size(), PackFormat::kNameHashSeed);
+            record.m_nameOffset = u32(m_names.size());
+            record.m_nameLength = u16(_input.m_name.size());
+            m_names += _input.m_name;
+            m_statistics.m_entryCount++;
+            return record;
+        };
+        // Looked up before compressing, then again before writing, as an identical input may have been added since.
+        const auto addDuplicate = [&]
+        {
+            const PackFormat::EntryRecord* original = m_settings.m_deduplicate ? FindStoredContent(_input, entry.m_contentHash, entry.m_size) : nullptr;
+            if (original == nullptr)
+            {
+                return false;
+            }
+            const PackFormat::EntryRecord copy = *original;
+            const std::string originalName = m_names.substr(copy.m_nameOffset, copy.m_nameLength);
+            WriteDuplicate(_input.m_name, originalName, copy, addRecord(), m_statistics);
+            return true;
+        };
+
+        {
+            const std::lock_guard lock(m_mutex);
+            KT_VERIFY(m_nameSet.insert(_input.m_name).second, "Duplicate pack entry '%s'", _input.m_name.c_str());
+            KT_VERIFY(m_records.size() + 1 < ~0u && m_names.size() + _input.m_name.size() <= ~0u, "Too many pack entries");
+            if (addDuplicate())
+            {
+                return;
+            }
+        }
+
+        CompressEntry(_input, m_settings, entry);
+
+        const std::lock_guard lock(m_mutex);
+        if (addDuplicate())
+        {
+            return;
+        }
+        const size_t recordIndex = m_records.size();
+        WriteEntry(m_writer, m_settings, _input.m_name, entry, addRecord(), m_statistics);
+        if (m_settings.m_deduplicate)
+        {
+            m_storedContents.emplace(entry.m_contentHash, StoredContent { entry.m_size, recordIndex, _input.m_path });
+        }
+    }
+
+    const PackFormat::EntryRecord* PackWriter::FindStoredContent(const PackInput& _input, u64 _contentHash, u64 _size) const
+    {
+        const auto [first, last] = m_storedContents.equal_range(_contentHash);
+        for (auto it = first; it != last; ++it)
+        {
+            if (it->second.m_size == _size && HaveSameContent(it->second.m_path, _input.m_path))
+            {
+                return &m_records[it->second.m_record];
+            }
+        }
+        return nullptr;
+    }
+
+    PackStatistics PackWriter::Finish()
+    {
+        KT_TRACE_ZONE("PackWriter::Finish");
+        const std::lock_guard lock(m_mutex);
+        const auto getName = [this](const PackFormat::EntryRecord& _record) { return std::string_view(m_names).substr(_record.m_nameOffset, _record.m_nameLength); };
+        std::ranges::sort(m_records, [&](const PackFormat::EntryRecord& _a, const PackFormat::EntryRecord& _b)
+        {
+            return _a.m_nameHash != _b.m_nameHash ? _a.m_nameHash < _b.m_nameHash : getName(_a) < getName(_b);
+        });
+
+        PackFormat::Header header = MakeHeader(m_settings, u32(m_records.size()));
+        header.m_dataOffset = AlignUp(u64(sizeof(PackFormat::Header)), u64(m_settings.m_alignment));
+        m_writer.Align(alignof(PackFormat::EntryRecord));
+        header.m_indexOffset = m_writer.Tell();
+        m_writer.WriteSpan(std::span<const PackFormat::EntryRecord>(m_records));
+        header.m_namesOffset = m_writer.Tell();
+        header.m_namesSize = m_names.size();
+        m_writer.Write(m_names.data(), m_names.size());
+        m_writer.Align(m_settings.m_alignment);
+        header.m_fileSize = m_writer.Tell();
+        m_statistics.m_fileSize = header.m_fileSize;
+
+        m_writer.Seek(0);
+        m_writer.WritePod(header);
+        m_writer.Commit();
+        return m_statistics;
+    }
+}
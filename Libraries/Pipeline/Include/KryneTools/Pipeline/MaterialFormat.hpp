@@ -0,0 +1,79 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine runtime material files (`.kmat`), one per manifest material.
+ *
+ * A material references its shaders and textures by pack entry name. Shader permutations are resolved offline: each
+ * shader record holds the module index to use in its `.kshd`, so the runtime never evaluates permutation axes. The
+ * fixed function state uses the values of `MaterialManifest.hpp`, which match the Vulkan enums.
+ *
+ * Every array starts 16 bytes aligned, offsets are absolute. All values are little-endian.
+ */
+namespace KryneTools::MaterialFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'M', 'A', 'T');
+    constexpr u16 kVersion = 1;
+    constexpr u64 kArrayAlignment = 16;
+
+    /// Range of the string table.
+    struct StringReference
+    {
+        u32 m_offset;
+        u32 m_length;
+    };
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u32 m_shaderCount;
+        u32 m_textureCount;
+        /// `ShaderRecord[m_shaderCount]`.
+        u32 m_shadersOffset;
+        /// `TextureRecord[m_textureCount]`.
+        u32 m_texturesOffset;
+        u32 m_stringsOffset;
+        u32 m_stringsSize;
+        StringReference m_name;
+        /// Names of the manifest vertex layout and render target.
+        StringReference m_vertexLayout;
+        StringReference m_renderTarget;
+        /// A `PrimitiveTopology`, `CullMode`, `FrontFace`, `CompareOp` and `BlendMode`.
+        u8 m_topology;
+        u8 m_cullMode;
+        u8 m_frontFace;
+        u8 m_depthCompare;
+        u8 m_blend;
+        u8 m_depthTest;
+        u8 m_depthWrite;
+        u8 m_reserved;
+        u32 m_fileSize;
+        u32 m_reserved2;
+    };
+    static_assert(sizeof(Header) == 72);
+
+    struct ShaderRecord
+    {
+        /// Pack entry name of the `.kshd`.
+        StringReference m_file;
+        u32 m_permutation;
+        /// Module of the permutation in the `.kshd`.
+        u32 m_module;
+        /// A `ShaderStage`.
+        u8 m_stage;
+        u8 m_reserved[3];
+    };
+    static_assert(sizeof(ShaderRecord) == 20);
+
+    struct TextureRecord
+    {
+        StringReference m_slot;
+        /// Pack entry name of the texture.
+        StringReference m_file;
+    };
+    static_assert(sizeof(TextureRecord) == 16);
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+#include "KryneTools/Shader/ShaderPreprocessor.hpp"
+
+namespace KryneTools
+{
+    /// Values match `VkPrimitiveTopology`.
+    enum class PrimitiveTopology: u32
+    {
+        PointList = 0,
+        LineList = 1,
+        LineStrip = 2,
+        TriangleList = 3,
+        TriangleStrip = 4,
+    };
+
+    /// Values match `VkCullModeFlagBits`.
+    enum class CullMode: u32
+    {
+        None = 0,
+        Front = 1,
+        Back = 2,
+    };
+
+    /// Values match `VkFrontFace`.
+    enum class FrontFace: u32
+    {
+        CounterClockwise = 0,
+        Clockwise = 1,
+    };
+
+    /// Values match `VkCompareOp`.
+    enum class CompareOp: u32
+    {
+        Never = 0,
+        Less = 1,
+        Equal = 2,
+        LessOrEqual = 3,
+        Greater = 4,
+        NotEqual = 5,
+        GreaterOrEqual = 6,
+        Always = 7,
+    };
+
+    enum class BlendMode: u8
+    {
+        Opaque,
+        /// `src * a + dst * (1 - a)`.
+        Alpha,
+        /// `src + dst * (1 - a)`.
+        Premultiplied,
+        /// `src + dst`.
+        Additive,
+    };
+
+    struct VertexBindingDescription
+    {
+        u32 m_binding = 0;
+        u32 m_stride = 0;
+        bool m_perInstance = false;
+    };
+
+    struct VertexAttributeDescription
+    {
+        u32 m_location = 0;
+        u32 m_binding = 0;
+        /// Vulkan format name without its prefix, e.g. `r16g16b16a16_snorm`.
+        std::string m_format;
+        u32 m_offset = 0;
+    };
+
+    struct VertexLayout
+    {
+        std::string m_name;
+        std::vector<VertexBindingDescription> m_bindings;
+        std::vector<VertexAttributeDescription> m_attributes;
+    };
+
+    /// Attachment formats of a dynamic rendering pass, Vulkan format names as for vertex attributes.
+    struct RenderTargetLayout
+    {
+        std::string m_name;
+        std::vector<std::string> m_colorFormats;
+        /// Empty for passes without depth.
+        std::string m_depthFormat;
+        u32 m_sampleCount = 1;
+    };
+
+    /// Fixed function state of a material pipeline. Viewport and scissor are always dynamic.
+    struct PipelineState
+    {
+        PrimitiveTopology m_topology = PrimitiveTopology::TriangleList;
+        CullMode m_cullMode = CullMode::Back;
+        FrontFace m_frontFace = FrontFace::CounterClockwise;
+        bool m_depthTest = true;
+        bool m_depthWrite = true;
+        CompareOp m_depthCompare = CompareOp::GreaterOrEqual;
+        BlendMode m_blend = BlendMode::Opaque;
+    };
+
+    /// A `.kshd` shader of the material, and the axis values selecting its permutation.
+    struct MaterialShaderReference
+    {
+        std::string m_shader;
+        std::vector<ShaderDefine> m_permutation;
+    };
+
+    /// Source image bound to a named texture slot of the material.
+    struct MaterialTextureReference
+    {
+        std::string m_slot;
+        /// Resolved against the manifest directory.
+        std::filesystem::path m_source;
+    };
+
+    struct MaterialDescription
+    {
+        std::string m_name;
+        /// Indices in the manifest layouts.
+        u32 m_vertexLayout = 0;
+        u32 m_renderTarget = 0;
+        std::vector<MaterialShaderReference> m_shaders;
+        /// Not used by pipeline creation, only by the cooked material files.
+        std::vector<MaterialTextureReference> m_textures;
+        PipelineState m_state;
+    };
+
+    struct MaterialManifest
+    {
+        /// Directory of the `.kshd` files, resolved against the manifest directory.
+        std::filesystem::path m_shaderDirectory;
+        std::vector<VertexLayout> m_vertexLayouts;
+        std::vector<RenderTargetLayout> m_renderTargets;
+        std::vector<MaterialDescription> m_materials;
+    };
+
+    /**
+     * @brief Loads a JSON material manifest, every material being one graphics pipeline.
+     *
+     * @details
+     * ```json
+     * {
+     *     "shader_directory": "../cooked/shaders",
+     *     "vertex_layouts": {
+     *         "static_mesh": {
+     *             "bindings": [{ "binding": 0, "stride": 8 }, { "binding": 1, "stride": 4 }],
+     *             "attributes": [
+     *                 { "location": 0, "binding": 0, "format": "r16g16b16a16_snorm" },
+     *                 { "location": 1, "binding": 1, "format": "r16g16_snorm" }
+     *             ]
+     *         }
+     *     },
+     *     "render_targets": {
+     *         "gbuffer": { "colors": ["r8g8b8a8_srgb", "a2b10g10r10_unorm_pack32"], "depth": "d32_sfloat", "samples": 1 }
+     *     },
+     *     "materials": [{
+     *         "name": "rock",
+     *         "vertex_layout": "static_mesh",
+     *         "render_target": "gbuffer",
+     *         "shaders": [
+     *             { "shader": "pbr_vs" },
+     *             { "shader": "pbr_fs", "permutation": { "USE_NORMAL_MAP": 1, "ALPHA_MODE": 0 } }
+     *         ],
+     *         "textures": { "albedo": "textures/rock_albedo.png", "normal": "textures/rock_normal.png" },
+     *         "state": { "cull": "back", "depth_compare": "greater_or_equal", "blend": "opaque" }
+     *     }]
+     * }
+     * ```
+     * State keys are `topology`, `cull`, `front_face` (`ccw` or `cw`), `depth_test`, `depth_write`, `depth_compare` and
+     * `blend` (`opaque`, `alpha`, `premultiplied` or `additive`), with the `PipelineState` defaults. Texture sources are
+     * relative to the manifest. Throws an `Error` on malformed manifests or unknown references.
+     */
+    [[nodiscard]] MaterialManifest LoadMaterialManifest(const std::filesystem::path& _path);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Pipeline/MaterialManifest.hpp"
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+namespace KryneTools
+{
+    /// A material shader with its permutation resolved against the cooked `.kshd`.
+    struct CookedMaterialShader
+    {
+        /// Pack entry name of the `.kshd`.
+        std::string m_file;
+        ShaderStage m_stage = ShaderStage::Vertex;
+        u32 m_permutation = 0;
+        u32 m_module = 0;
+    };
+
+    struct CookedMaterialTexture
+    {
+        std::string m_slot;
+        /// Pack entry name of the cooked texture.
+        std::string m_file;
+    };
+
+    struct CookedMaterial
+    {
+        const MaterialManifest* m_manifest = nullptr;
+        const MaterialDescription* m_description = nullptr;
+        std::vector<CookedMaterialShader> m_shaders;
+        std::vector<CookedMaterialTexture> m_textures;
+    };
+
+    /// Writes a cooked material as a `.kmat` file, see `MaterialFormat` for the layout.
+    void WriteMaterialFile(const std::filesystem::path& _path, const CookedMaterial& _material);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Pipeline/MaterialManifest.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    struct PipelineDeviceInfo
+    {
+        /// Index in the Vulkan physical device enumeration.
+        u32 m_index = 0;
+        std::string m_name;
+        u32 m_vendorId = 0;
+        u32 m_deviceId = 0;
+        u32 m_driverVersion = 0;
+        u32 m_apiVersion = 0;
+        bool m_software = false;
+    };
+
+    struct PipelineCacheSettings
+    {
+        std::filesystem::path m_outputDirectory;
+        /// Physical device indices to build for. Every hardware device when empty.
+        std::vector<u32> m_devices;
+        /// Pipelines per `vkCreateGraphicsPipelines()` call, each batch being one job.
+        u32 m_batchSize = 16;
+        /// Replays every pipeline against the written blob on a fresh device.
+        bool m_validate = true;
+    };
+
+    struct PipelineCacheResult
+    {
+        PipelineDeviceInfo m_device;
+        std::filesystem::path m_path;
+        u64 m_size = 0;
+        u32 m_pipelineCount = 0;
+        f64 m_buildSeconds = 0.0;
+        /// The device supports `pipelineCreationCacheControl`, so the replay could detect misses.
+        bool m_validated = false;
+        /// Pipelines the replay could not create from the blob alone, compile hitches left at runtime.
+        u32 m_missCount = 0;
+    };
+
+    /// `<vendor>-<device>.vkpipelinecache`, in lowercase hexadecimal.
+    [[nodiscard]] std::string GetPipelineCacheFileName(u32 _vendorId, u32 _deviceId);
+
+    /// Vulkan 1.3 capable physical devices. Throws an `Error` if no Vulkan instance can be created.
+    [[nodiscard]] std::vector<PipelineDeviceInfo> EnumeratePipelineDevices();
+
+    /**
+     * @brief Creates every material pipeline on each selected device and writes the resulting `VkPipelineCache` data.
+     *
+     * @details
+     * Shader modules and layouts are created once per device, then pipelines are created in batches on the job
+     * system, each batch in its own cache so workers never contend on one, and the batch caches are merged at the end.
+     * Pipeline layouts come from the SPIR-V reflection of the material stages. Devices sharing a vendor and device ID
+     * are built once.
+     */
+    [[nodiscard]] std::vector<PipelineCacheResult> BuildPipelineCaches(JobSystem& _jobSystem, const MaterialManifest& _manifest, const PipelineCacheSettings& _settings);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Layout of the header of `VkPipelineCache` data, as defined by the Vulkan specification
+ * (`VkPipelineCacheHeaderVersionOne`). Every driver's blob starts with it, the rest is opaque.
+ *
+ * Pipeline cache files are written as is, named after the device they were built on (see
+ * `GetPipelineCacheFileName()`). A runtime picks the file of its device and still compares the header with its
+ * `VkPhysicalDeviceProperties`: drivers reject a blob from another driver version, and it must then start empty.
+ */
+namespace KryneTools::PipelineCacheFormat
+{
+    constexpr u32 kHeaderVersionOne = 1;
+    constexpr u32 kUuidSize = 16;
+
+    struct Header
+    {
+        u32 m_headerSize;
+        u32 m_headerVersion;
+        u32 m_vendorId;
+        u32 m_deviceId;
+        u8 m_pipelineCacheUuid[kUuidSize];
+    };
+    static_assert(sizeof(Header) == 32);
+}
@@ -0,0 +1,175 @@
+#include "KryneTools/Pipeline/MaterialManifest.hpp"
+
+#include <utility>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Json/Json.hpp"
+#include "KryneTools/Shader/ShaderManifest.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        template <class T, size_t N>
+        T ParseEnum(const JsonValue& _value, const std::pair<std::string_view, T> (&_names)[N], T _default, const char* _context, const char* _key)
+        {
+            if (_value.IsNull())
+            {
+                return _default;
+            }
+            const std::string_view name = _value.AsString();
+            for (const auto& [candidate, value]: _names)
+            {
+                if (candidate == name)
+                {
+                    return value;
+                }
+            }
+            ThrowError("%s: unknown %s '%.*s'", _context, _key, int(name.size()), name.data());
+        }
+
+        constexpr std::pair<std::string_view, PrimitiveTopology> kTopologies[] = {
+            { "point_list", PrimitiveTopology::PointList },
+            { "line_list", PrimitiveTopology::LineList },
+            { "line_strip", PrimitiveTopology::LineStrip },
+            { "triangle_list", PrimitiveTopology::TriangleList },
+            { "triangle_strip", PrimitiveTopology::TriangleStrip },
+        };
+
+        constexpr std::pair<std::string_view, CullMode> kCullModes[] = {
+            { "none", CullMode::None },
+            { "front", CullMode::Front },
+            { "back", CullMode::Back },
+        };
+
+        constexpr std::pair<std::string_view, FrontFace> kFrontFaces[] = {
+            { "ccw", FrontFace::CounterClockwise },
+            { "cw", FrontFace::Clockwise },
+        };
+
+        constexpr std::pair<std::string_view, CompareOp> kCompareOps[] = {
+            { "never", CompareOp::Never },
+            { "less", CompareOp::Less },
+            { "equal", CompareOp::Equal },
+            { "less_or_equal", CompareOp::LessOrEqual },
+            { "greater", CompareOp::Greater },
+            { "not_equal", CompareOp::NotEqual },
+            { "greater_or_equal", CompareOp::GreaterOrEqual },
+            { "always", CompareOp::Always },
+        };
+
+        constexpr std::pair<std::string_view, BlendMode> kBlendModes[] = {
+            { "opaque", BlendMode::Opaque },
+            { "alpha", BlendMode::Alpha },
+            { "premultiplied", BlendMode::Premultiplied },
+            { "additive", BlendMode::Additive },
+        };
+
+        template <class T>
+        u32 FindByName(const std::vector<T>& _entries, std::string_view _name, const char* _context, const char* _kind)
+        {
+            for (size_t i = 0; i < _entries.size(); i++)
+            {
+                if (_entries[i].m_name == _name)
+                {
+                    return u32(i);
+                }
+            }
+            ThrowError("%s: unknown %s '%.*s'", _context, _kind, int(_name.size()), _name.data());
+        }
+    }
+
+    MaterialManifest LoadMaterialManifest(const std::filesystem::path& _path)
+    {
+        const std::vector<u8> data = FileSystem::ReadFile(_path);
+        const JsonValue document = JsonValue::Parse(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+        const std::filesystem::path directory = _path.parent_path();
+        const std::string manifestName = _path.string();
+
+        MaterialManifest manifest;
+        manifest.m_shaderDirectory = directory / document["shader_directory"].AsString(".");
+
+        for (const auto& [name, entry]: document["vertex_layouts"].AsObject())
+        {
+            const std::string context = manifestName + ": " + name;
+            VertexLayout layout;
+            layout.m_name = name;
+            for (const JsonValue& binding: entry["bindings"].AsArray())
+            {
+                KT_VERIFY(binding["stride"].IsNumber(), "%s: every vertex binding needs a stride", context.c_str());
+                layout.m_bindings.push_back({ binding["binding"].AsU32(), binding["stride"].AsU32(), binding["rate"].AsString("vertex") == "instance" });
+            }
+            for (const JsonValue& attribute: entry["attributes"].AsArray())
+            {
+                KT_VERIFY(attribute["location"].IsNumber() && attribute["format"].IsString(), "%s: every vertex attribute needs a location and a format", context.c_str());
+                const u32 binding = attribute["binding"].AsU32();
+                bool found = false;
+                for (const VertexBindingDescription& candidate: layout.m_bindings)
+                {
+                    found |= candidate.m_binding == binding;
+                }
+                KT_VERIFY(found, "%s: attribute %u uses undeclared binding %u", context.c_str(), attribute["location"].AsU32(), binding);
+                layout.m_attributes.push_back({ attribute["location"].AsU32(), binding, std::string(attribute["format"].AsString()), attribute["offset"].AsU32() });
+            }
+            manifest.m_vertexLayouts.push_back(std::move(layout));
+        }
+
+        for (const auto& [name, entry]: document["render_targets"].AsObject())
+        {
+            RenderTargetLayout target;
+            target.m_name = name;
+            for (const JsonValue& format: entry["colors"].AsArray())
+            {
+                target.m_colorFormats.emplace_back(format.AsString());
+            }
+            target.m_depthFormat = entry["depth"].AsString();
+            target.m_sampleCount = entry["samples"].AsU32(1);
+            const u32 samples = target.m_sampleCount;
+            KT_VERIFY(samples > 0 && samples <= 64 && (samples & (samples - 1)) == 0, "%s: %s: invalid sample count %u", manifestName.c_str(), name.c_str(), samples);
+            manifest.m_renderTargets.push_back(std::move(target));
+        }
+
+        for (const JsonValue& entry: document["materials"].AsArray())
+        {
+            MaterialDescription material;
+            material.m_name = entry["name"].AsString();
+            KT_VERIFY(!material.m_name.empty(), "%s: every material needs a name", manifestName.c_str());
+            const std::string context = manifestName + ": " + material.m_name;
+            const char* contextName = context.c_str();
+
+            material.m_vertexLayout = FindByName(manifest.m_vertexLayouts, entry["vertex_layout"].AsString(), contextName, "vertex layout");
+            material.m_renderTarget = FindByName(manifest.m_renderTargets, entry["render_target"].AsString(), contextName, "render target");
+            for (const JsonValue& shaderEntry: entry["shaders"].AsArray())
+            {
+                MaterialShaderReference shader;
+                shader.m_shader = shaderEntry["shader"].AsString();
+                KT_VERIFY(!shader.m_shader.empty(), "%s: every shader reference needs a shader name", contextName);
+                for (const auto& [axis, value]: shaderEntry["permutation"].AsObject())
+                {
+                    shader.m_permutation.push_back({ axis, GetShaderDefineValue(value, contextName) });
+                }
+                material.m_shaders.push_back(std::move(shader));
+            }
+            KT_VERIFY(!material.m_shaders.empty(), "%s: no shaders", contextName);
+            for (const auto& [slot, source]: entry["textures"].AsObject())
+            {
+                KT_VERIFY(source.IsString(), "%s: texture slot '%s' needs a source path", contextName, slot.c_str());
+                material.m_textures.push_back({ slot, directory / source.AsString() });
+            }
+
+            const JsonValue& state = entry["state"];
+            const PipelineState defaults;
+            material.m_state.m_topology = ParseEnum(state["topology"], kTopologies, defaults.m_topology, contextName, "topology");
+            material.m_state.m_cullMode = ParseEnum(state["cull"], kCullModes, defaults.m_cullMode, contextName, "cull mode");
+            material.m_state.m_frontFace = ParseEnum(state["front_face"], kFrontFaces, defaults.m_frontFace, contextName, "front face");
+            material.m_state.m_depthTest = state["depth_test"].AsBool(defaults.m_depthTest);
+            material.m_state.m_depthWrite = state["depth_write"].AsBool(defaults.m_depthWrite);
+            material.m_state.m_depthCompare = ParseEnum(state["depth_compare"], kCompareOps, defaults.m_depthCompare, contextName, "depth compare");
+            material.m_state.m_blend = ParseEnum(state["blend"], kBlendModes, defaults.m_blend, contextName, "blend mode");
+            manifest.m_materials.push_back(std::move(material));
+        }
+        KT_VERIFY(!manifest.m_materials.empty(), "%s: no materials", manifestName.c_str());
+        return manifest;
+    }
+}
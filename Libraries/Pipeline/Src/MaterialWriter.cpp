@@ -0,0 +1,83 @@
+#include "KryneTools/Pipeline/MaterialWriter.hpp"
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Pipeline/MaterialFormat.hpp"
+
+namespace KryneTools
+{
+    void WriteMaterialFile(const std::filesystem::path& _path, const CookedMaterial& _material)
+    {
+        const MaterialManifest& manifest = *_material.m_manifest;
+        const MaterialDescription& description = *_material.m_description;
+
+        std::string strings;
+        const auto addString = [&strings](std::string_view _text)
+        {
+            const MaterialFormat::StringReference reference { u32(strings.size()), u32(_text.size()) };
+            strings += _text;
+            return reference;
+        };
+
+        MaterialFormat::Header header {};
+        header.m_magic = MaterialFormat::kMagic;
+        header.m_version = MaterialFormat::kVersion;
+        header.m_headerSize = sizeof(MaterialFormat::Header);
+        header.m_name = addString(description.m_name);
+        header.m_vertexLayout = addString(manifest.m_vertexLayouts[description.m_vertexLayout].m_name);
+        header.m_renderTarget = addString(manifest.m_renderTargets[description.m_renderTarget].m_name);
+        header.m_topology = u8(description.m_state.m_topology);
+        header.m_cullMode = u8(description.m_state.m_cullMode);
+        header.m_frontFace = u8(description.m_state.m_frontFace);
+        header.m_depthCompare = u8(description.m_state.m_depthCompare);
+        header.m_blend = u8(description.m_state.m_blend);
+        header.m_depthTest = description.m_state.m_depthTest ? 1 : 0;
+        header.m_depthWrite = description.m_state.m_depthWrite ? 1 : 0;
+
+        std::vector<MaterialFormat::ShaderRecord> shaders;
+        for (const CookedMaterialShader& shader: _material.m_shaders)
+        {
+            MaterialFormat::ShaderRecord& record = shaders.emplace_back();
+            record.m_file = addString(shader.m_file);
+            record.m_permutation = shader.m_permutation;
+            record.m_module = shader.m_module;
+            record.m_stage = u8(shader.m_stage);
+        }
+        std::vector<MaterialFormat::TextureRecord> textures;
+        for (const CookedMaterialTexture& texture: _material.m_textures)
+        {
+            textures.push_back({ addString(texture.m_slot), addString(texture.m_file) });
+        }
+
+        header.m_shaderCount = u32(shaders.size());
+        header.m_textureCount = u32(textures.size());
+
+        u64 offset = sizeof(MaterialFormat::Header);
+        const auto place = [&offset](u64 _size)
+        {
+            offset = AlignUp(offset, MaterialFormat::kArrayAlignment);
+            const u64 start = offset;
+            offset += _size;
+            return u32(start);
+        };
+        header.m_shadersOffset = place(shaders.size() * sizeof(MaterialFormat::ShaderRecord));
+        header.m_texturesOffset = place(textures.size() * sizeof(MaterialFormat::TextureRecord));
+        header.m_stringsOffset = place(strings.size());
+        header.m_stringsSize = u32(strings.size());
+        KT_VERIFY(offset <= ~0u, "%s: material file exceeds 4 GiB", description.m_name.c_str());
+        header.m_fileSize = u32(offset);
+
+        FileWriter writer(_path);
+        writer.WritePod(header);
+        const auto writeArray = [&writer](u32 _offset, const void* _data, u64 _size)
+        {
+            writer.Align(MaterialFormat::kArrayAlignment);
+            KT_VERIFY(writer.Tell() == _offset, "Material file layout mismatch");
+            writer.Write(_data, _size);
+        };
+        writeArray(header.m_shadersOffset, shaders.data(), shaders.size() * sizeof(MaterialFormat::ShaderRecord));
+        writeArray(header.m_texturesOffset, textures.data(), textures.size() * sizeof(MaterialFormat::TextureRecord));
+        writeArray(header.m_stringsOffset, strings.data(), strings.size());
+        writer.Commit();
+    }
+}
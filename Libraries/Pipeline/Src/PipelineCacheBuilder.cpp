@@ -0,0 +1,773 @@
+#include "KryneTools/Pipeline/PipelineCacheBuilder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Pipeline/PipelineCacheFormat.hpp"
+#include "KryneTools/Shader/ShaderReader.hpp"
+#include "KryneTools/Shader/SpirvReflection.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Layout size of runtime sized descriptor arrays, matching the runtime bindless limit.
+        constexpr u32 kRuntimeArrayDescriptorCount = 4096;
+
+        constexpr VkDynamicState kDynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+        void CheckVulkan(VkResult _result, const char* _operation)
+        {
+            if (_result != VK_SUCCESS)
+            {
+                ThrowError("%s failed (VkResult %d)", _operation, int(_result));
+            }
+        }
+
+        struct FormatName
+        {
+            std::string_view m_name;
+            VkFormat m_format;
+        };
+
+#define KT_FORMAT(_name) FormatName { #_name, VK_FORMAT_##_name }
+        constexpr FormatName kFormats[] = {
+            KT_FORMAT(R8_UNORM),
+            KT_FORMAT(R8_SNORM),
+            KT_FORMAT(R8_UINT),
+            KT_FORMAT(R8G8_UNORM),
+            KT_FORMAT(R8G8_SNORM),
+            KT_FORMAT(R8G8_UINT),
+            KT_FORMAT(R8G8B8A8_UNORM),
+            KT_FORMAT(R8G8B8A8_SNORM),
+            KT_FORMAT(R8G8B8A8_UINT),
+            KT_FORMAT(R8G8B8A8_SRGB),
+            KT_FORMAT(B8G8R8A8_UNORM),
+            KT_FORMAT(B8G8R8A8_SRGB),
+            KT_FORMAT(A2B10G10R10_UNORM_PACK32),
+            KT_FORMAT(A2B10G10R10_SNORM_PACK32),
+            KT_FORMAT(A2B10G10R10_UINT_PACK32),
+            KT_FORMAT(B10G11R11_UFLOAT_PACK32),
+            KT_FORMAT(R16_UNORM),
+            KT_FORMAT(R16_SFLOAT),
+            KT_FORMAT(R16_UINT),
+            KT_FORMAT(R16G16_UNORM),
+            KT_FORMAT(R16G16_SNORM),
+            KT_FORMAT(R16G16_SFLOAT),
+            KT_FORMAT(R16G16_UINT),
+            KT_FORMAT(R16G16B16A16_UNORM),
+            KT_FORMAT(R16G16B16A16_SNORM),
+            KT_FORMAT(R16G16B16A16_SFLOAT),
+            KT_FORMAT(R16G16B16A16_UINT),
+            KT_FORMAT(R32_SFLOAT),
+            KT_FORMAT(R32_UINT),
+            KT_FORMAT(R32G32_SFLOAT),
+            KT_FORMAT(R32G32_UINT),
+            KT_FORMAT(R32G32B32_SFLOAT),
+            KT_FORMAT(R32G32B32_UINT),
+            KT_FORMAT(R32G32B32A32_SFLOAT),
+            KT_FORMAT(R32G32B32A32_UINT),
+            KT_FORMAT(D16_UNORM),
+            KT_FORMAT(X8_D24_UNORM_PACK32),
+            KT_FORMAT(D32_SFLOAT),
+            KT_FORMAT(S8_UINT),
+            KT_FORMAT(D16_UNORM_S8_UINT),
+            KT_FORMAT(D24_UNORM_S8_UINT),
+            KT_FORMAT(D32_SFLOAT_S8_UINT),
+        };
+#undef KT_FORMAT
+
+        VkFormat ParseFormat(std::string_view _name, const char* _context)
+        {
+            for (const FormatName& format: kFormats)
+            {
+                const bool equal = std::ranges::equal(format.m_name, _name, [](char _a, char _b) { return _a == std::toupper(static_cast<unsigned char>(_b)); });
+                if (equal)
+                {
+                    return format.m_format;
+                }
+            }
+            ThrowError("%s: unknown or unsupported format '%.*s'", _context, int(_name.size()), _name.data());
+        }
+
+        bool HasDepth(VkFormat _format)
+        {
+            return _format != VK_FORMAT_UNDEFINED && _format != VK_FORMAT_S8_UINT;
+        }
+
+        bool HasStencil(VkFormat _format)
+        {
+            return _format == VK_FORMAT_S8_UINT || _format == VK_FORMAT_D16_UNORM_S8_UINT || _format == VK_FORMAT_D24_UNORM_S8_UINT || _format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+        }
+
+        VkShaderStageFlagBits GetStageFlag(ShaderStage _stage)
+        {
+            switch (_stage)
+            {
+            case ShaderStage::Vertex:
+                return VK_SHADER_STAGE_VERTEX_BIT;
+            case ShaderStage::Fragment:
+                return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case ShaderStage::Compute:
+                return VK_SHADER_STAGE_COMPUTE_BIT;
+            case ShaderStage::Geometry:
+                return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case ShaderStage::TessellationControl:
+                return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case ShaderStage::TessellationEvaluation:
+                return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            }
+            return VK_SHADER_STAGE_ALL;
+        }
+
+        class VulkanInstance
+        {
+        public:
+            VulkanInstance()
+            {
+                VkApplicationInfo application {};
+                application.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+                application.pApplicationName = "kryne-pipecache";
+                application.apiVersion = VK_API_VERSION_1_3;
+                VkInstanceCreateInfo info {};
+                info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+                info.pApplicationInfo = &application;
+                CheckVulkan(vkCreateInstance(&info, nullptr, &m_instance), "vkCreateInstance");
+            }
+
+            ~VulkanInstance()
+            {
+                vkDestroyInstance(m_instance, nullptr);
+            }
+
+            VulkanInstance(const VulkanInstance&) = delete;
+            VulkanInstance& operator=(const VulkanInstance&) = delete;
+
+            [[nodiscard]] std::vector<VkPhysicalDevice> GetPhysicalDevices() const
+            {
+                u32 count = 0;
+                CheckVulkan(vkEnumeratePhysicalDevices(m_instance, &count, nullptr), "vkEnumeratePhysicalDevices");
+                std::vector<VkPhysicalDevice> devices(count);
+                CheckVulkan(vkEnumeratePhysicalDevices(m_instance, &count, devices.data()), "vkEnumeratePhysicalDevices");
+                devices.resize(count);
+                return devices;
+            }
+
+        private:
+            VkInstance m_instance = VK_NULL_HANDLE;
+        };
+
+        PipelineDeviceInfo GetDeviceInfo(VkPhysicalDevice _device, u32 _index)
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(_device, &properties);
+            PipelineDeviceInfo info;
+            info.m_index = _index;
+            info.m_name = properties.deviceName;
+            info.m_vendorId = properties.vendorID;
+            info.m_deviceId = properties.deviceID;
+            info.m_driverVersion = properties.driverVersion;
+            info.m_apiVersion = properties.apiVersion;
+            info.m_software = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+            return info;
+        }
+
+        /// A manifest material with its shaders resolved to `.kshd` modules.
+        struct ResolvedMaterial
+        {
+            const MaterialDescription* m_description = nullptr;
+            std::vector<std::pair<const ShaderFile*, u32>> m_modules;
+        };
+
+        struct ShaderModule
+        {
+            VkShaderModule m_module = VK_NULL_HANDLE;
+            ShaderReflection m_reflection;
+        };
+
+        /// Every create info of a pipeline, linked to each other. Never moved once built.
+        struct GraphicsPipelineInfo
+        {
+            std::vector<VkPipelineShaderStageCreateInfo> m_stages;
+            std::vector<VkVertexInputBindingDescription> m_vertexBindings;
+            std::vector<VkVertexInputAttributeDescription> m_vertexAttributes;
+            VkPipelineVertexInputStateCreateInfo m_vertexInput {};
+            VkPipelineInputAssemblyStateCreateInfo m_inputAssembly {};
+            VkPipelineViewportStateCreateInfo m_viewport {};
+            VkPipelineRasterizationStateCreateInfo m_rasterization {};
+            VkPipelineMultisampleStateCreateInfo m_multisample {};
+            VkPipelineDepthStencilStateCreateInfo m_depthStencil {};
+            std::vector<VkPipelineColorBlendAttachmentState> m_blendAttachments;
+            VkPipelineColorBlendStateCreateInfo m_colorBlend {};
+            VkPipelineDynamicStateCreateInfo m_dynamic {};
+            std::vector<VkFormat> m_colorFormats;
+            VkPipelineRenderingCreateInfo m_rendering {};
+            VkGraphicsPipelineCreateInfo m_info {};
+        };
+
+        VkPipelineColorBlendAttachmentState GetBlendAttachment(BlendMode _mode)
+        {
+            VkPipelineColorBlendAttachmentState attachment {};
+            attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            if (_mode == BlendMode::Opaque)
+            {
+                return attachment;
+            }
+            attachment.blendEnable = VK_TRUE;
+            attachment.colorBlendOp = VK_BLEND_OP_ADD;
+            attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+            attachment.srcColorBlendFactor = _mode == BlendMode::Alpha ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+            attachment.dstColorBlendFactor = _mode == BlendMode::Additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstAlphaBlendFactor = _mode == BlendMode::Additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            return attachment;
+        }
+
+        /**
+         * @brief Logical device with every shader module, layout and pipeline description of the manifest.
+         * @details Built once to fill the cache, then once more on a fresh device to validate it.
+         */
+        class DevicePipelines
+        {
+        public:
+            DevicePipelines(VkPhysicalDevice _physicalDevice, const MaterialManifest& _manifest, std::span<const ResolvedMaterial> _materials)
+            {
+                CreateDevice(_physicalDevice);
+                for (const ResolvedMaterial& material: _materials)
+                {
+                    BuildPipeline(_manifest, material);
+                }
+            }
+
+            ~DevicePipelines()
+            {
+                for (const auto& [key, layout]: m_pipelineLayouts)
+                {
+                    vkDestroyPipelineLayout(m_device, layout, nullptr);
+                }
+                for (const auto& [key, layout]: m_setLayouts)
+                {
+                    vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+                }
+                for (const auto& [hash, module]: m_modules)
+                {
+                    vkDestroyShaderModule(m_device, module.m_module, nullptr);
+                }
+                vkDestroyDevice(m_device, nullptr);
+            }
+
+            DevicePipelines(const DevicePipelines&) = delete;
+            DevicePipelines& operator=(const DevicePipelines&) = delete;
+
+            [[nodiscard]] u32 GetPipelineCount() const { return u32(m_pipelines.size()); }
+            [[nodiscard]] bool SupportsCacheControl() const { return m_cacheControl; }
+
+            /// Creates every pipeline, one cache per batch, and returns the data of the merged cache.
+            [[nodiscard]] std::vector<u8> Build(JobSystem& _jobSystem, u32 _batchSize)
+            {
+                const u32 batchCount = (GetPipelineCount() + _batchSize - 1) / _batchSize;
+                std::vector<VkPipelineCache> caches(batchCount, VK_NULL_HANDLE);
+                const auto destroyCaches = [&]
+                {
+                    for (const VkPipelineCache cache: caches)
+                    {
+                        vkDestroyPipelineCache(m_device, cache, nullptr);
+                    }
+                };
+
+                try
+                {
+                    _jobSystem.ParallelFor(batchCount, 1, [&](u64 _begin, u64 _end)
+                    {
+                        for (u64 b = _begin; b < _end; b++)
+                        {
+                            VkPipelineCacheCreateInfo info {};
+                            info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+                            CheckVulkan(vkCreatePipelineCache(m_device, &info, nullptr, &caches[b]), "vkCreatePipelineCache");
+                            (void)CreateBatch(caches[b], u32(b) * _batchSize, _batchSize, 0);
+                        }
+                    });
+
+                    VkPipelineCache merged = VK_NULL_HANDLE;
+                    VkPipelineCacheCreateInfo info {};
+                    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+                    CheckVulkan(vkCreatePipelineCache(m_device, &info, nullptr, &merged), "vkCreatePipelineCache");
+                    caches.push_back(merged);
+                    CheckVulkan(vkMergePipelineCaches(m_device, merged, batchCount, caches.data()), "vkMergePipelineCaches");
+
+                    size_t size = 0;
+                    CheckVulkan(vkGetPipelineCacheData(m_device, merged, &size, nullptr), "vkGetPipelineCacheData");
+                    std::vector<u8> data(size);
+                    CheckVulkan(vkGetPipelineCacheData(m_device, merged, &size, data.data()), "vkGetPipelineCacheData");
+                    data.resize(size);
+                    destroyCaches();
+                    return data;
+                }
+                catch (...)
+                {
+                    destroyCaches();
+                    throw;
+                }
+            }
+
+            /// Recreates every pipeline from the cache data alone. @return The number of pipelines that needed a compile.
+            [[nodiscard]] u32 CountMisses(JobSystem& _jobSystem, std::span<const u8> _data, u32 _batchSize)
+            {
+                VkPipelineCacheCreateInfo info {};
+                info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+                info.initialDataSize = _data.size();
+                info.pInitialData = _data.data();
+                VkPipelineCache cache = VK_NULL_HANDLE;
+                CheckVulkan(vkCreatePipelineCache(m_device, &info, nullptr, &cache), "vkCreatePipelineCache");
+
+                std::atomic<u32> missCount = 0;
+                const u32 batchCount = (GetPipelineCount() + _batchSize - 1) / _batchSize;
+                try
+                {
+                    _jobSystem.ParallelFor(batchCount, 1, [&](u64 _begin, u64 _end)
+                    {
+                        for (u64 b = _begin; b < _end; b++)
+                        {
+                            missCount += CreateBatch(cache, u32(b) * _batchSize, _batchSize, VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT);
+                        }
+                    });
+                }
+                catch (...)
+                {
+                    vkDestroyPipelineCache(m_device, cache, nullptr);
+                    throw;
+                }
+                vkDestroyPipelineCache(m_device, cache, nullptr);
+                return missCount;
+            }
+
+        private:
+            VkDevice m_device = VK_NULL_HANDLE;
+            bool m_cacheControl = false;
+            std::unordered_map<u64, ShaderModule> m_modules;
+            std::map<std::vector<u32>, VkDescriptorSetLayout> m_setLayouts;
+            std::map<std::vector<u64>, VkPipelineLayout> m_pipelineLayouts;
+            std::vector<const MaterialDescription*> m_materials;
+            std::vector<std::unique_ptr<GraphicsPipelineInfo>> m_pipelines;
+
+            void CreateDevice(VkPhysicalDevice _physicalDevice)
+            {
+                VkPhysicalDeviceVulkan13Features features13 {};
+                features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+                VkPhysicalDeviceVulkan12Features features12 {};
+                features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+                VkPhysicalDeviceVulkan11Features features11 {};
+                features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+                VkPhysicalDeviceFeatures2 features {};
+                features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features.pNext = &features11;
+                features11.pNext = &features12;
+                features12.pNext = &features13;
+                vkGetPhysicalDeviceFeatures2(_physicalDevice, &features);
+                KT_VERIFY(features13.dynamicRendering, "The device does not support dynamic rendering");
+
+                // Everything the device supports is enabled so every shader capability is accepted, except robust
+                // accesses: they change the generated code and the runtime does not enable them.
+                features.features.robustBufferAccess = VK_FALSE;
+                features13.robustImageAccess = VK_FALSE;
+                m_cacheControl = features13.pipelineCreationCacheControl;
+
+                const f32 priority = 1.0f;
+                VkDeviceQueueCreateInfo queue {};
+                queue.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+                queue.queueFamilyIndex = 0;
+                queue.queueCount = 1;
+                queue.pQueuePriorities = &priority;
+                VkDeviceCreateInfo info {};
+                info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+                info.pNext = &features;
+                info.queueCreateInfoCount = 1;
+                info.pQueueCreateInfos = &queue;
+                CheckVulkan(vkCreateDevice(_physicalDevice, &info, nullptr, &m_device), "vkCreateDevice");
+            }
+
+            const ShaderModule& GetModule(const ShaderFile& _file, u32 _module)
+            {
+                const u64 hash = _file.GetModuleRecord(_module).m_hash;
+                const auto [it, inserted] = m_modules.try_emplace(hash);
+                if (inserted)
+                {
+                    const std::span<const u32> words = _file.GetModule(_module);
+                    it->second.m_reflection = ReflectSpirv(words);
+                    VkShaderModuleCreateInfo info {};
+                    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+                    info.codeSize = words.size_bytes();
+                    info.pCode = words.data();
+                    CheckVulkan(vkCreateShaderModule(m_device, &info, nullptr, &it->second.m_module), "vkCreateShaderModule");
+                }
+                return it->second;
+            }
+
+            VkDescriptorSetLayout GetSetLayout(std::span<const VkDescriptorSetLayoutBinding> _bindings)
+            {
+                std::vector<u32> key;
+                for (const VkDescriptorSetLayoutBinding& binding: _bindings)
+                {
+                    key.insert(key.end(), { binding.binding, u32(binding.descriptorType), binding.descriptorCount, u32(binding.stageFlags) });
+                }
+                const auto [it, inserted] = m_setLayouts.try_emplace(std::move(key), VK_NULL_HANDLE);
+                if (inserted)
+                {
+                    VkDescriptorSetLayoutCreateInfo info {};
+                    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+                    info.bindingCount = u32(_bindings.size());
+                    info.pBindings = _bindings.data();
+                    CheckVulkan(vkCreateDescriptorSetLayout(m_device, &info, nullptr, &it->second), "vkCreateDescriptorSetLayout");
+                }
+                return it->second;
+            }
+
+            /// Union of the resources of every stage, which must agree on the type of shared bindings.
+            VkPipelineLayout GetPipelineLayout(std::span<const ShaderModule* const> _stages, const char* _context)
+            {
+                std::map<std::pair<u32, u32>, VkDescriptorSetLayoutBinding> bindings;
+                VkPushConstantRange pushConstants {};
+                for (const ShaderModule* stage: _stages)
+                {
+                    const ShaderReflection& reflection = stage->m_reflection;
+                    const VkShaderStageFlagBits stageFlag = GetStageFlag(reflection.m_stage);
+                    for (const ShaderBinding& binding: reflection.m_bindings)
+                    {
+                        const u32 count = binding.m_count == 0 ? kRuntimeArrayDescriptorCount : binding.m_count;
+                        const auto [it, inserted] = bindings.try_emplace({ binding.m_set, binding.m_binding });
+                        VkDescriptorSetLayoutBinding& layoutBinding = it->second;
+                        if (inserted)
+                        {
+                            layoutBinding = { binding.m_binding, VkDescriptorType(binding.m_type), count, 0, nullptr };
+                        }
+                        KT_VERIFY(
+                            layoutBinding.descriptorType == VkDescriptorType(binding.m_type),
+                            "%s: set %u binding %u is a %s in one stage and a %s in another",
+                            _context,
+                            binding.m_set,
+                            binding.m_binding,
+                            GetDescriptorTypeName(DescriptorType(layoutBinding.descriptorType)),
+                            GetDescriptorTypeName(binding.m_type));
+                        layoutBinding.descriptorCount = std::max(layoutBinding.descriptorCount, count);
+                        layoutBinding.stageFlags |= stageFlag;
+                    }
+                    if (reflection.m_pushConstantSize > 0)
+                    {
+                        pushConstants.size = std::max(pushConstants.size, reflection.m_pushConstantSize);
+                        pushConstants.stageFlags |= stageFlag;
+                    }
+                }
+
+                std::vector<VkDescriptorSetLayout> setLayouts;
+                std::vector<u64> key;
+                for (auto it = bindings.begin(); it != bindings.end();)
+                {
+                    const u32 set = it->first.first;
+                    std::vector<VkDescriptorSetLayoutBinding> setBindings;
+                    for (; it != bindings.end() && it->first.first == set; ++it)
+                    {
+                        const VkDescriptorSetLayoutBinding& binding = it->second;
+                        setBindings.push_back(binding);
+                        key.insert(key.end(), { u64(set) << 32 | binding.binding, u64(binding.descriptorType) << 32 | binding.descriptorCount, binding.stageFlags });
+                    }
+                    // Sets the shaders skip still need a layout, an empty one.
+                    while (setLayouts.size() < set)
+                    {
+                        setLayouts.push_back(GetSetLayout({}));
+                    }
+                    setLayouts.push_back(GetSetLayout(setBindings));
+                }
+                key.push_back(u64(pushConstants.size) << 32 | pushConstants.stageFlags);
+
+                const auto [it, inserted] = m_pipelineLayouts.try_emplace(std::move(key), VK_NULL_HANDLE);
+                if (inserted)
+                {
+                    VkPipelineLayoutCreateInfo info {};
+                    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+                    info.setLayoutCount = u32(setLayouts.size());
+                    info.pSetLayouts = setLayouts.data();
+                    info.pushConstantRangeCount = pushConstants.size > 0 ? 1 : 0;
+                    info.pPushConstantRanges = &pushConstants;
+                    CheckVulkan(vkCreatePipelineLayout(m_device, &info, nullptr, &it->second), "vkCreatePipelineLayout");
+                }
+                return it->second;
+            }
+
+            void BuildPipeline(const MaterialManifest& _manifest, const ResolvedMaterial& _material)
+            {
+                const MaterialDescription& material = *_material.m_description;
+                const char* context = material.m_name.c_str();
+                const VertexLayout& vertexLayout = _manifest.m_vertexLayouts[material.m_vertexLayout];
+                const RenderTargetLayout& renderTarget = _manifest.m_renderTargets[material.m_renderTarget];
+                const PipelineState& state = material.m_state;
+
+                auto pipeline = std::make_unique<GraphicsPipelineInfo>();
+                pipeline->m_vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                pipeline->m_inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+                pipeline->m_viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+                pipeline->m_rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+                pipeline->m_multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+                pipeline->m_depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+                pipeline->m_colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+                pipeline->m_dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+                pipeline->m_rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+                pipeline->m_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                std::vector<const ShaderModule*> modules;
+                for (const auto& [file, index]: _material.m_modules)
+                {
+                    const ShaderModule& module = GetModule(*file, index);
+                    KT_VERIFY(module.m_reflection.m_stage == file->GetStage(), "%s: %.*s module does not match its stage", context, int(file->GetName().size()), file->GetName().data());
+                    modules.push_back(&module);
+
+                    VkPipelineShaderStageCreateInfo stage {};
+                    stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                    stage.stage = GetStageFlag(module.m_reflection.m_stage);
+                    stage.module = module.m_module;
+                    stage.pName = module.m_reflection.m_entryPoint.c_str();
+                    pipeline->m_stages.push_back(stage);
+
+                    for (const ShaderInput& input: module.m_reflection.m_inputs)
+                    {
+                        const bool found = std::ranges::any_of(vertexLayout.m_attributes, [&](const VertexAttributeDescription& _attribute) { return _attribute.m_location == input.m_location; });
+                        KT_VERIFY(found, "%s: vertex input '%s' at location %u is missing from layout %s", context, input.m_name.c_str(), input.m_location, vertexLayout.m_name.c_str());
+                    }
+                }
+
+                for (const VertexBindingDescription& binding: vertexLayout.m_bindings)
+                {
+                    pipeline->m_vertexBindings.push_back({ binding.m_binding, binding.m_stride, binding.m_perInstance ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX });
+                }
+                for (const VertexAttributeDescription& attribute: vertexLayout.m_attributes)
+                {
+                    pipeline->m_vertexAttributes.push_back({ attribute.m_location, attribute.m_binding, ParseFormat(attribute.m_format, context), attribute.m_offset });
+                }
+                pipeline->m_vertexInput.vertexBindingDescriptionCount = u32(pipeline->m_vertexBindings.size());
+                pipeline->m_vertexInput.pVertexBindingDescriptions = pipeline->m_vertexBindings.data();
+                pipeline->m_vertexInput.vertexAttributeDescriptionCount = u32(pipeline->m_vertexAttributes.size());
+                pipeline->m_vertexInput.pVertexAttributeDescriptions = pipeline->m_vertexAttributes.data();
+
+                pipeline->m_inputAssembly.topology = VkPrimitiveTopology(state.m_topology);
+                pipeline->m_viewport.viewportCount = 1;
+                pipeline->m_viewport.scissorCount = 1;
+
+                pipeline->m_rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+                pipeline->m_rasterization.cullMode = VkCullModeFlags(state.m_cullMode);
+                pipeline->m_rasterization.frontFace = VkFrontFace(state.m_frontFace);
+                pipeline->m_rasterization.lineWidth = 1.0f;
+                pipeline->m_multisample.rasterizationSamples = VkSampleCountFlagBits(renderTarget.m_sampleCount);
+
+                const VkFormat depthFormat = renderTarget.m_depthFormat.empty() ? VK_FORMAT_UNDEFINED : ParseFormat(renderTarget.m_depthFormat, context);
+                pipeline->m_depthStencil.depthTestEnable = HasDepth(depthFormat) && state.m_depthTest;
+                pipeline->m_depthStencil.depthWriteEnable = HasDepth(depthFormat) && state.m_depthWrite;
+                pipeline->m_depthStencil.depthCompareOp = VkCompareOp(state.m_depthCompare);
+                pipeline->m_depthStencil.maxDepthBounds = 1.0f;
+
+                for (const std::string& format: renderTarget.m_colorFormats)
+                {
+                    pipeline->m_colorFormats.push_back(ParseFormat(format, context));
+                    pipeline->m_blendAttachments.push_back(GetBlendAttachment(state.m_blend));
+                }
+                pipeline->m_colorBlend.attachmentCount = u32(pipeline->m_blendAttachments.size());
+                pipeline->m_colorBlend.pAttachments = pipeline->m_blendAttachments.data();
+                pipeline->m_dynamic.dynamicStateCount = u32(std::size(kDynamicStates));
+                pipeline->m_dynamic.pDynamicStates = kDynamicStates;
+
+                pipeline->m_rendering.colorAttachmentCount = u32(pipeline->m_colorFormats.size());
+                pipeline->m_rendering.pColorAttachmentFormats = pipeline->m_colorFormats.data();
+                pipeline->m_rendering.depthAttachmentFormat = HasDepth(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+                pipeline->m_rendering.stencilAttachmentFormat = HasStencil(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+
+                VkGraphicsPipelineCreateInfo& info = pipeline->m_info;
+                info.pNext = &pipeline->m_rendering;
+                info.stageCount = u32(pipeline->m_stages.size());
+                info.pStages = pipeline->m_stages.data();
+                info.pVertexInputState = &pipeline->m_vertexInput;
+                info.pInputAssemblyState = &pipeline->m_inputAssembly;
+                info.pViewportState = &pipeline->m_viewport;
+                info.pRasterizationState = &pipeline->m_rasterization;
+                info.pMultisampleState = &pipeline->m_multisample;
+                info.pDepthStencilState = &pipeline->m_depthStencil;
+                info.pColorBlendState = &pipeline->m_colorBlend;
+                info.pDynamicState = &pipeline->m_dynamic;
+                info.layout = GetPipelineLayout(modules, context);
+                info.basePipelineIndex = -1;
+
+                m_materials.push_back(&material);
+                m_pipelines.push_back(std::move(pipeline));
+            }
+
+            /// Creates and destroys a batch of pipelines. @return The number of pipelines that required a compile.
+            u32 CreateBatch(VkPipelineCache _cache, u32 _first, u32 _batchSize, VkPipelineCreateFlags _flags)
+            {
+                const u32 count = std::min(_batchSize, GetPipelineCount() - _first);
+                std::vector<VkGraphicsPipelineCreateInfo> infos;
+                for (u32 p = _first; p < _first + count; p++)
+                {
+                    infos.push_back(m_pipelines[p]->m_info);
+                    infos.back().flags |= _flags;
+                }
+
+                std::vector<VkPipeline> pipelines(count, VK_NULL_HANDLE);
+                const VkResult result = vkCreateGraphicsPipelines(m_device, _cache, count, infos.data(), nullptr, pipelines.data());
+                u32 missCount = 0;
+                for (u32 p = 0; p < count; p++)
+                {
+                    missCount += pipelines[p] == VK_NULL_HANDLE;
+                    vkDestroyPipeline(m_device, pipelines[p], nullptr);
+                }
+                if (result != VK_PIPELINE_COMPILE_REQUIRED)
+                {
+                    CheckVulkan(result, FormatString("vkCreateGraphicsPipelines (materials %s to %s)", m_materials[_first]->m_name.c_str(), m_materials[_first + count - 1]->m_name.c_str()).c_str());
+                }
+                return missCount;
+            }
+        };
+
+        std::vector<ResolvedMaterial> ResolveMaterials(const MaterialManifest& _manifest, std::unordered_map<std::string, ShaderFile>& _shaders)
+        {
+            std::vector<ResolvedMaterial> materials;
+            for (const MaterialDescription& material: _manifest.m_materials)
+            {
+                ResolvedMaterial resolved { &material, {} };
+                for (const MaterialShaderReference& reference: material.m_shaders)
+                {
+                    auto it = _shaders.find(reference.m_shader);
+                    if (it == _shaders.end())
+                    {
+                        it = _shaders.emplace(reference.m_shader, ShaderFile::Open(_manifest.m_shaderDirectory / (reference.m_shader + ".kshd"))).first;
+                    }
+                    const ShaderFile& file = it->second;
+                    try
+                    {
+                        resolved.m_modules.emplace_back(&file, file.GetPermutationModule(file.FindPermutation(reference.m_permutation)));
+                    }
+                    catch (const Error& exception)
+                    {
+                        ThrowError("%s: %s", material.m_name.c_str(), exception.what());
+                    }
+                }
+                materials.push_back(std::move(resolved));
+            }
+            return materials;
+        }
+
+        void VerifyCacheHeader(std::span<const u8> _data, VkPhysicalDevice _device, const char* _path)
+        {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(_device, &properties);
+            PipelineCacheFormat::Header header;
+            KT_VERIFY(_data.size() >= sizeof(header), "%s: truncated pipeline cache header", _path);
+            std::memcpy(&header, _data.data(), sizeof(header));
+            KT_VERIFY(header.m_headerVersion == PipelineCacheFormat::kHeaderVersionOne && header.m_headerSize >= sizeof(header), "%s: unexpected pipeline cache header", _path);
+            KT_VERIFY(header.m_vendorId == properties.vendorID && header.m_deviceId == properties.deviceID, "%s: pipeline cache device mismatch", _path);
+            KT_VERIFY(std::memcmp(header.m_pipelineCacheUuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0, "%s: pipeline cache UUID mismatch", _path);
+        }
+    }
+
+    std::string GetPipelineCacheFileName(u32 _vendorId, u32 _deviceId)
+    {
+        return FormatString("%04x-%04x.vkpipelinecache", _vendorId, _deviceId);
+    }
+
+    std::vector<PipelineDeviceInfo> EnumeratePipelineDevices()
+    {
+        const VulkanInstance instance;
+        std::vector<PipelineDeviceInfo> devices;
+        const std::vector<VkPhysicalDevice> physicalDevices = instance.GetPhysicalDevices();
+        for (u32 d = 0; d < physicalDevices.size(); d++)
+        {
+            const PipelineDeviceInfo info = GetDeviceInfo(physicalDevices[d], d);
+            if (info.m_apiVersion >= VK_API_VERSION_1_3)
+            {
+                devices.push_back(info);
+            }
+        }
+        return devices;
+    }
+
+    std::vector<PipelineCacheResult> BuildPipelineCaches(JobSystem& _jobSystem, const MaterialManifest& _manifest, const PipelineCacheSettings& _settings)
+    {
+        KT_TRACE_ZONE("BuildPipelineCaches");
+        KT_VERIFY(_settings.m_batchSize > 0, "The pipeline batch size can not be 0");
+        std::unordered_map<std::string, ShaderFile> shaders;
+        const std::vector<ResolvedMaterial> materials = ResolveMaterials(_manifest, shaders);
+
+        const VulkanInstance instance;
+        const std::vector<VkPhysicalDevice> physicalDevices = instance.GetPhysicalDevices();
+        std::vector<u32> selected = _settings.m_devices;
+        if (selected.empty())
+        {
+            for (u32 d = 0; d < physicalDevices.size(); d++)
+            {
+                const PipelineDeviceInfo info = GetDeviceInfo(physicalDevices[d], d);
+                if (!info.m_software && info.m_apiVersion >= VK_API_VERSION_1_3)
+                {
+                    selected.push_back(d);
+                }
+            }
+            KT_VERIFY(!selected.empty(), "No Vulkan 1.3 hardware device found, software devices must be selected explicitly");
+        }
+
+        std::vector<PipelineCacheResult> results;
+        for (const u32 index: selected)
+        {
+            KT_VERIFY(index < physicalDevices.size(), "No Vulkan device %u, there are %zu", index, physicalDevices.size());
+            const VkPhysicalDevice physicalDevice = physicalDevices[index];
+            PipelineCacheResult result;
+            result.m_device = GetDeviceInfo(physicalDevice, index);
+            KT_VERIFY(result.m_device.m_apiVersion >= VK_API_VERSION_1_3, "%s does not support Vulkan 1.3", result.m_device.m_name.c_str());
+            const bool duplicate = std::ranges::any_of(results, [&](const PipelineCacheResult& _other)
+            {
+                return _other.m_device.m_vendorId == result.m_device.m_vendorId && _other.m_device.m_deviceId == result.m_device.m_deviceId;
+            });
+            if (duplicate)
+            {
+                Log::Verbose("%s: same device as an earlier one, skipped", result.m_device.m_name.c_str());
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<u8> data;
+            {
+                DevicePipelines pipelines(physicalDevice, _manifest, materials);
+                result.m_pipelineCount = pipelines.GetPipelineCount();
+                data = pipelines.Build(_jobSystem, _settings.m_batchSize);
+            }
+            result.m_buildSeconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+            result.m_path = _settings.m_outputDirectory / GetPipelineCacheFileName(result.m_device.m_vendorId, result.m_device.m_deviceId);
+            const std::string pathString = result.m_path.string();
+            VerifyCacheHeader(data, physicalDevice, pathString.c_str());
+            FileWriter writer(result.m_path);
+            writer.Write(data.data(), data.size());
+            writer.Commit();
+            result.m_size = data.size();
+
+            if (_settings.m_validate)
+            {
+                // A fresh device, so nothing but the blob can provide the pipelines.
+                DevicePipelines replay(physicalDevice, _manifest, materials);
+                result.m_validated = replay.SupportsCacheControl();
+                if (result.m_validated)
+                {
+                    result.m_missCount = replay.CountMisses(_jobSystem, data, _settings.m_batchSize);
+                }
+            }
+            results.push_back(std::move(result));
+        }
+        return results;
+    }
+}
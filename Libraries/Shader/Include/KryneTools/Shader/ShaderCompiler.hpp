@@ -0,0 +1,96 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+#include "KryneTools/Shader/ShaderPreprocessor.hpp"
+
+namespace KryneTools
+{
+    enum class ShaderLanguage: u8
+    {
+        /// Compiled with glslang.
+        Glsl,
+        /// Compiled with DXC.
+        Hlsl,
+    };
+
+    /// Values are stored in `.kshd` files.
+    enum class ShaderStage: u8
+    {
+        Vertex = 0,
+        Fragment = 1,
+        Compute = 2,
+        Geometry = 3,
+        TessellationControl = 4,
+        TessellationEvaluation = 5,
+    };
+
+    [[nodiscard]] const char* GetShaderStageName(ShaderStage _stage);
+    [[nodiscard]] std::optional<ShaderStage> ParseShaderStage(std::string_view _name);
+    [[nodiscard]] const char* GetShaderLanguageName(ShaderLanguage _language);
+    [[nodiscard]] std::optional<ShaderLanguage> ParseShaderLanguage(std::string_view _name);
+
+    struct ShaderCompilerSettings
+    {
+        std::string m_glslangPath = "glslangValidator";
+        std::string m_dxcPath = "dxc";
+        /// Vulkan environment targeted by both compilers, e.g. `vulkan1.2`.
+        std::string m_targetEnvironment = "vulkan1.2";
+        /// DXC shader model, e.g. `6_0`.
+        std::string m_shaderModel = "6_0";
+        /// Keeps debug information in the SPIR-V.
+        bool m_debugInfo = false;
+        /// Scratch directory for the compiler inputs and outputs.
+        std::filesystem::path m_scratchDirectory;
+    };
+
+    struct ShaderCompileRequest
+    {
+        ShaderLanguage m_language = ShaderLanguage::Glsl;
+        ShaderStage m_stage = ShaderStage::Fragment;
+        std::string m_entryPoint = "main";
+        /// Output of `PreprocessShader()`.
+        std::string_view m_source;
+    };
+
+    /**
+     * @brief Runs glslang or DXC as external processes to compile preprocessed shaders to SPIR-V.
+     *
+     * @details
+     * Compilers get fully preprocessed sources, so their own preprocessor and include handling play no part in the
+     * result. The version of each compiler is queried once, on first use, and becomes part of its identity (see
+     * `GetIdentity()`), so artifacts cached with another compiler build are never reused.
+     */
+    class ShaderCompiler
+    {
+    public:
+        explicit ShaderCompiler(ShaderCompilerSettings _settings);
+
+        [[nodiscard]] const ShaderCompilerSettings& GetSettings() const { return m_settings; }
+
+        /// Macros every source of the language is preprocessed with, mirroring those of its compiler.
+        [[nodiscard]] std::vector<ShaderDefine> GetPredefinedMacros(ShaderLanguage _language, ShaderStage _stage) const;
+
+        /// Compiler version and every setting affecting its output. Throws an `Error` if the compiler can not be run.
+        [[nodiscard]] const std::string& GetIdentity(ShaderLanguage _language);
+
+        /**
+         * @brief Compiles to a SPIR-V module, written to `_output`.
+         * @details Throws an `Error` with the compiler output on failure, and keeps the failing source next to it.
+         */
+        void Compile(const ShaderCompileRequest& _request, const std::filesystem::path& _output);
+
+    private:
+        ShaderCompilerSettings m_settings;
+        std::mutex m_identityMutex;
+        std::optional<std::string> m_identities[2];
+
+        [[nodiscard]] std::vector<std::string> GetArguments(const ShaderCompileRequest& _request, const std::filesystem::path& _input, const std::filesystem::path& _output) const;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+#include "KryneTools/Shader/ShaderManifest.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class JobSystem;
+    struct CacheKey;
+
+    /**
+     * @brief Compiles a distinct source elsewhere, e.g. on a remote worker, returning its SPIR-V, or nothing to
+     * compile it locally.
+     * @details `_identity` is that of the local compiler (see `ShaderCompiler::GetIdentity()`), which the remote one
+     * must match for the result to be cacheable under `_key`.
+     */
+    using ShaderCompileFunction = std::function<std::optional<std::vector<u8>>(const ShaderCompileRequest& _request, std::string_view _identity, const CacheKey& _key)>;
+
+    struct ShaderCookSettings
+    {
+        std::filesystem::path m_outputDirectory;
+        /// Searched after the manifest include directories.
+        std::vector<std::filesystem::path> m_includeDirectories;
+        /// `m_scratchDirectory` defaults to a directory under the output one, removed once done.
+        ShaderCompilerSettings m_compiler;
+        /// Directory of the generated C++ reflection headers, none are written when empty.
+        std::filesystem::path m_reflectionDirectory;
+        /// Optional artifact cache of the SPIR-V modules.
+        ContentCache* m_cache = nullptr;
+        /// Optional, tried on cache misses before compiling locally.
+        ShaderCompileFunction m_remoteCompile;
+    };
+
+    struct ShaderCookStatistics
+    {
+        u64 m_permutationCount = 0;
+        /// Distinct preprocessed sources, each compiled or restored once.
+        u64 m_uniqueSourceCount = 0;
+        u64 m_compiledCount = 0;
+        /// Part of `m_compiledCount` compiled by `ShaderCookSettings::m_remoteCompile`.
+        u64 m_remoteCount = 0;
+        u64 m_cacheHitCount = 0;
+        /// Distinct SPIR-V modules written, summed over the shaders.
+        u64 m_moduleCount = 0;
+        std::vector<std::filesystem::path> m_outputs;
+    };
+
+    /**
+     * @brief Expands, compiles and writes every shader of a manifest, one `.kshd` per shader.
+     *
+     * @details
+     * Every permutation is preprocessed as a job. Permutations are then deduplicated on their preprocessed text:
+     * those leading to the same code, with the same stage, entry point and compiler, are compiled once. Each distinct
+     * source is a compile job, or a cache hit, keyed on that text and the compiler identity, never on the defines that
+     * led to it. Throws an `Error` with the compiler output on the first failed compilation.
+     */
+    ShaderCookStatistics CookShaders(JobSystem& _jobSystem, const ShaderManifest& _manifest, const ShaderCookSettings& _settings);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine runtime shader files (`.kshd`), one per manifest shader with all its permutations.
+ *
+ * A permutation is selected by the value index of every axis, combined in a mixed radix index with the first axis the
+ * most significant (see `ShaderDescription::GetPermutationDefines()`). The permutation table maps that index to one of
+ * the SPIR-V modules, which are deduplicated: permutations whose defines do not change the code share a module.
+ *
+ * Every array starts 16 bytes aligned, offsets are absolute. All values are little-endian.
+ */
+namespace KryneTools::ShaderFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'S', 'H', 'D');
+    constexpr u16 kVersion = 1;
+    constexpr u64 kArrayAlignment = 16;
+
+    /// Range of the string table.
+    struct StringReference
+    {
+        u32 m_offset;
+        u32 m_length;
+    };
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        /// A `ShaderStage`.
+        u8 m_stage;
+        /// Source language, 0 for GLSL and 1 for HLSL.
+        u8 m_language;
+        u16 m_reserved;
+        u32 m_axisCount;
+        u32 m_valueCount;
+        u32 m_permutationCount;
+        u32 m_moduleCount;
+        /// `AxisRecord[m_axisCount]`.
+        u32 m_axesOffset;
+        /// `StringReference[m_valueCount]`, the values of every axis.
+        u32 m_valuesOffset;
+        /// `u32[m_permutationCount]` module indices.
+        u32 m_permutationsOffset;
+        /// `ModuleRecord[m_moduleCount]`.
+        u32 m_modulesOffset;
+        u32 m_stringsOffset;
+        u32 m_stringsSize;
+        StringReference m_name;
+        StringReference m_entryPoint;
+        u32 m_fileSize;
+    };
+    static_assert(sizeof(Header) == 72);
+
+    struct AxisRecord
+    {
+        /// Define name.
+        StringReference m_name;
+        u32 m_firstValue;
+        u32 m_valueCount;
+    };
+    static_assert(sizeof(AxisRecord) == 16);
+
+    struct ModuleRecord
+    {
+        /// XXH64 of the SPIR-V words.
+        u64 m_hash;
+        /// 16 bytes aligned SPIR-V words.
+        u32 m_offset;
+        u32 m_size;
+    };
+    static_assert(sizeof(ModuleRecord) == 16);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+namespace KryneTools
+{
+    class JsonValue;
+
+    /// A define taking one of its values in every permutation.
+    struct PermutationAxis
+    {
+        std::string m_name;
+        std::vector<std::string> m_values;
+    };
+
+    struct ShaderDescription
+    {
+        std::string m_name;
+        std::filesystem::path m_source;
+        ShaderLanguage m_language = ShaderLanguage::Glsl;
+        ShaderStage m_stage = ShaderStage::Fragment;
+        std::string m_entryPoint = "main";
+        /// Defines shared by every permutation.
+        std::vector<ShaderDefine> m_defines;
+        std::vector<PermutationAxis> m_axes;
+
+        /// Product of the axis value counts.
+        [[nodiscard]] u64 GetPermutationCount() const;
+
+        /**
+         * @brief Defines of a permutation, shared ones first.
+         * @details Permutation indices are mixed radix numbers over the axes, the first axis being the most significant.
+         */
+        [[nodiscard]] std::vector<ShaderDefine> GetPermutationDefines(u64 _index) const;
+    };
+
+    struct ShaderManifest
+    {
+        std::vector<ShaderDescription> m_shaders;
+        /// Manifest include directories, resolved against its directory.
+        std::vector<std::filesystem::path> m_includeDirectories;
+    };
+
+    /**
+     * @brief Loads a JSON shader manifest.
+     *
+     * @details
+     * ```json
+     * {
+     *     "include_directories": ["include"],
+     *     "shaders": [{
+     *         "name": "pbr_opaque",
+     *         "source": "pbr.frag",
+     *         "stage": "fragment",
+     *         "entry": "main",
+     *         "defines": { "MAX_LIGHTS": 16 },
+     *         "permutations": [
+     *             { "name": "USE_NORMAL_MAP", "values": [0, 1] },
+     *             { "name": "ALPHA_MODE", "values": ["ALPHA_OPAQUE", "ALPHA_MASK", "ALPHA_BLEND"] }
+     *         ]
+     *     }]
+     * }
+     * ```
+     * Sources are relative to the manifest. The language defaults to HLSL for `.hlsl` sources and GLSL otherwise, the
+     * stage to the glslang style extension (`.vert`, `.frag`, `.comp`...). Values may be strings or numbers.
+     */
+    [[nodiscard]] ShaderManifest LoadShaderManifest(const std::filesystem::path& _path);
+
+    /// Define value of a JSON string, number or boolean: strings as is, integral numbers without decimals, `1` or `0`.
+    [[nodiscard]] std::string GetShaderDefineValue(const JsonValue& _value, const char* _context);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace KryneTools
+{
+    struct ShaderDefine
+    {
+        std::string m_name;
+        std::string m_value;
+    };
+
+    struct ShaderSourceFile;
+
+    /**
+     * @brief Thread safe cache of the shader sources and headers, split in logical lines and tokenized once for every
+     * permutation that includes them.
+     */
+    class ShaderSourceCache
+    {
+    public:
+        /// `_includeDirectories` are searched in order, after the directory of the including file for `"name"` forms.
+        explicit ShaderSourceCache(std::vector<std::filesystem::path> _includeDirectories = {});
+        ~ShaderSourceCache();
+
+        /// Throws an `Error` if the file can not be read.
+        [[nodiscard]] const ShaderSourceFile& Load(const std::filesystem::path& _path);
+
+        /// @return An empty path if no candidate exists.
+        [[nodiscard]] std::filesystem::path ResolveInclude(std::string_view _name, const std::filesystem::path& _includer, bool _angled) const;
+
+    private:
+        std::vector<std::filesystem::path> m_includeDirectories;
+        std::mutex m_mutex;
+        std::unordered_map<std::string, std::unique_ptr<ShaderSourceFile>> m_files;
+    };
+
+    /**
+     * @brief Runs the C preprocessor on a shader source, as GLSL and HLSL compilers define it.
+     *
+     * @details
+     * Supports object and function-like macros (variadic, `#` and `##` included), conditionals, `#include` and
+     * `#pragma once`. Every other directive (`#version`, `#extension`, `#pragma`...) is kept, and a `#version` defines
+     * `__VERSION__`.
+     *
+     * The output is normalized: comments are dropped, whitespace runs collapse to a single space and empty lines are
+     * removed, so two permutations whose defines lead to the same code give the same text. Throws an `Error` on
+     * malformed input or `#error`.
+     */
+    [[nodiscard]] std::string PreprocessShader(ShaderSourceCache& _sources, const std::filesystem::path& _path, std::span<const ShaderDefine> _defines);
+}
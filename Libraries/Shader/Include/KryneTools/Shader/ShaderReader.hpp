@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+#include "KryneTools/Shader/ShaderFormat.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Memory mapped `.kshd` file.
+     *
+     * @details
+     * Opening validates the header and every table, modules are then handed out in place from the mapping.
+     */
+    class ShaderFile
+    {
+    public:
+        /// Throws an `Error` on a malformed file.
+        [[nodiscard]] static ShaderFile Open(const std::filesystem::path& _path);
+
+        [[nodiscard]] std::string_view GetName() const { return GetString(m_header.m_name); }
+        [[nodiscard]] std::string_view GetEntryPoint() const { return GetString(m_header.m_entryPoint); }
+        [[nodiscard]] ShaderStage GetStage() const { return ShaderStage(m_header.m_stage); }
+        [[nodiscard]] u32 GetPermutationCount() const { return m_header.m_permutationCount; }
+        [[nodiscard]] u32 GetModuleCount() const { return m_header.m_moduleCount; }
+
+        /**
+         * @brief Permutation index of a set of axis values.
+         * @details Axes missing from `_values` take their first value. Throws an `Error` on an unknown axis or value.
+         */
+        [[nodiscard]] u32 FindPermutation(std::span<const ShaderDefine> _values) const;
+
+        [[nodiscard]] u32 GetPermutationModule(u32 _permutation) const { return m_permutationModules[_permutation]; }
+        [[nodiscard]] const ShaderFormat::ModuleRecord& GetModuleRecord(u32 _module) const { return m_modules[_module]; }
+        /// SPIR-V words of a module, 16 bytes aligned in the mapping.
+        [[nodiscard]] std::span<const u32> GetModule(u32 _module) const;
+
+    private:
+        MappedFile m_file;
+        ShaderFormat::Header m_header {};
+        std::span<const ShaderFormat::AxisRecord> m_axes;
+        std::span<const ShaderFormat::StringReference> m_values;
+        std::span<const u32> m_permutationModules;
+        std::span<const ShaderFormat::ModuleRecord> m_modules;
+        std::string_view m_strings;
+
+        [[nodiscard]] std::string_view GetString(const ShaderFormat::StringReference& _reference) const;
+    };
+}
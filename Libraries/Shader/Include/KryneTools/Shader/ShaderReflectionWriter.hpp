@@ -0,0 +1,28 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+#include "KryneTools/Shader/ShaderManifest.hpp"
+#include "KryneTools/Shader/SpirvReflection.hpp"
+
+namespace KryneTools
+{
+    /// Name of the header with the types shared by every generated reflection header.
+    constexpr const char* kShaderReflectionTypesHeader = "KryneShaderTypes.hpp";
+
+    /// Writes `kShaderReflectionTypesHeader` to a directory, leaving it untouched if it is already up to date.
+    void WriteShaderReflectionTypes(const std::filesystem::path& _directory);
+
+    /**
+     * @brief Writes a C++ header with the resource interface of a shader, as `constexpr` data.
+     *
+     * @details
+     * The header declares the `KryneShaders::<shader>` namespace with a `BindingSlot` per resource, the descriptor set
+     * layouts and a `PushConstants` struct whose member offsets are checked by `static_assert`s. It covers every
+     * permutation: resources some permutations drop are still listed, but a resource must have the same slot and type
+     * in all of them, and so must the push constant layout, or an `Error` is thrown. The file is left untouched if it
+     * is already up to date, so unchanged shaders do not rebuild their includers.
+     */
+    void WriteShaderReflectionHeader(const std::filesystem::path& _path, const ShaderDescription& _shader, std::span<const ShaderReflection> _modules);
+}
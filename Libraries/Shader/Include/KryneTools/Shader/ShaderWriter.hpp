@@ -0,0 +1,21 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "KryneTools/Shader/ShaderManifest.hpp"
+
+namespace KryneTools
+{
+    struct CompiledShader
+    {
+        const ShaderDescription* m_description = nullptr;
+        /// Module index of every permutation.
+        std::vector<u32> m_permutationModules;
+        /// Distinct SPIR-V modules.
+        std::vector<std::vector<u8>> m_modules;
+    };
+
+    /// Writes a compiled shader as a `.kshd` file, see `ShaderFormat` for the layout.
+    void WriteShaderFile(const std::filesystem::path& _path, const CompiledShader& _shader);
+}
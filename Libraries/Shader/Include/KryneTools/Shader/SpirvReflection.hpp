@@ -0,0 +1,99 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+namespace KryneTools
+{
+    /// Values match `VkDescriptorType`.
+    enum class DescriptorType: u32
+    {
+        Sampler = 0,
+        CombinedImageSampler = 1,
+        SampledImage = 2,
+        StorageImage = 3,
+        UniformTexelBuffer = 4,
+        StorageTexelBuffer = 5,
+        UniformBuffer = 6,
+        StorageBuffer = 7,
+        InputAttachment = 10,
+        AccelerationStructure = 1000150000,
+    };
+
+    [[nodiscard]] const char* GetDescriptorTypeName(DescriptorType _type);
+
+    struct ShaderBinding
+    {
+        /// Variable name, or block type name for buffers declared without an instance name.
+        std::string m_name;
+        u32 m_set = 0;
+        u32 m_binding = 0;
+        DescriptorType m_type = DescriptorType::UniformBuffer;
+        /// Array size, 0 for runtime sized arrays.
+        u32 m_count = 1;
+        /// Byte extent of the block of buffer bindings, without its runtime array.
+        u32 m_blockSize = 0;
+    };
+
+    enum class ShaderScalarType: u8
+    {
+        Float,
+        SInt,
+        UInt,
+        Bool,
+        /// Nested structures and multi-dimensional arrays, only described by their size.
+        Opaque,
+    };
+
+    /// Member of an explicitly laid out block.
+    struct ShaderBlockMember
+    {
+        std::string m_name;
+        u32 m_offset = 0;
+        /// Byte extent, arrays included.
+        u32 m_size = 0;
+        ShaderScalarType m_scalarType = ShaderScalarType::Float;
+        /// Scalar width in bits.
+        u32 m_scalarWidth = 32;
+        /// Vector components, or matrix rows.
+        u32 m_componentCount = 1;
+        /// Matrix columns, 1 for scalars and vectors.
+        u32 m_columnCount = 1;
+        u32 m_matrixStride = 0;
+        /// Array size, 0 if the member is not an array.
+        u32 m_arrayCount = 0;
+        u32 m_arrayStride = 0;
+    };
+
+    /// Vertex shader input, built-ins excluded.
+    struct ShaderInput
+    {
+        std::string m_name;
+        u32 m_location = 0;
+    };
+
+    struct ShaderReflection
+    {
+        ShaderStage m_stage = ShaderStage::Vertex;
+        std::string m_entryPoint;
+        /// Sorted by set then binding.
+        std::vector<ShaderBinding> m_bindings;
+        /// Byte extent of the push constant block, 0 if the shader has none.
+        u32 m_pushConstantSize = 0;
+        /// Type name of the push constant block.
+        std::string m_pushConstantName;
+        std::vector<ShaderBlockMember> m_pushConstantMembers;
+        /// Sorted by location.
+        std::vector<ShaderInput> m_inputs;
+    };
+
+    /**
+     * @brief Reads the resource interface of a SPIR-V module: descriptor bindings, push constants (with their member
+     * layout) and vertex inputs.
+     * @details Reflects the first entry point of the module. Throws an `Error` on malformed SPIR-V.
+     */
+    [[nodiscard]] ShaderReflection ReflectSpirv(std::span<const u32> _words);
+}
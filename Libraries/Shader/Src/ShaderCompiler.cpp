@@ -0,0 +1,182 @@
+#include "KryneTools/Shader/ShaderCompiler.hpp"
+
+#include <array>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Process.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        struct StageInfo
+        {
+            const char* m_name;
+            /// glslang `-S` value, also used as the source extension.
+            const char* m_glslangStage;
+            /// DXC profile prefix.
+            const char* m_dxcProfile;
+            /// DXC `__SHADER_TARGET_STAGE` value.
+            u32 m_dxcStage;
+        };
+
+        constexpr std::array<StageInfo, 6> kStages = { {
+            { "vertex", "vert", "vs", 1 },
+            { "fragment", "frag", "ps", 0 },
+            { "compute", "comp", "cs", 5 },
+            { "geometry", "geom", "gs", 2 },
+            { "tess_control", "tesc", "hs", 3 },
+            { "tess_evaluation", "tese", "ds", 4 },
+        } };
+
+        const StageInfo& GetStageInfo(ShaderStage _stage)
+        {
+            return kStages[size_t(_stage)];
+        }
+    }
+
+    const char* GetShaderStageName(ShaderStage _stage)
+    {
+        return GetStageInfo(_stage).m_name;
+    }
+
+    std::optional<ShaderStage> ParseShaderStage(std::string_view _name)
+    {
+        for (size_t i = 0; i < kStages.size(); i++)
+        {
+            if (_name == kStages[i].m_name || _name == kStages[i].m_glslangStage)
+            {
+                return ShaderStage(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    const char* GetShaderLanguageName(ShaderLanguage _language)
+    {
+        return _language == ShaderLanguage::Hlsl ? "hlsl" : "glsl";
+    }
+
+    std::optional<ShaderLanguage> ParseShaderLanguage(std::string_view _name)
+    {
+        if (_name == "glsl")
+        {
+            return ShaderLanguage::Glsl;
+        }
+        if (_name == "hlsl")
+        {
+            return ShaderLanguage::Hlsl;
+        }
+        return std::nullopt;
+    }
+
+    ShaderCompiler::ShaderCompiler(ShaderCompilerSettings _settings)
+        : m_settings(std::move(_settings))
+    {}
+
+    std::vector<ShaderDefine> ShaderCompiler::GetPredefinedMacros(ShaderLanguage _language, ShaderStage _stage) const
+    {
+        if (_language == ShaderLanguage::Glsl)
+        {
+            // glslang -V, `__VERSION__` comes from the #version directive.
+            return { { "VULKAN", "100" }, { "GL_SPIRV", "100" }, { "GL_core_profile", "1" } };
+        }
+
+        const std::string& model = m_settings.m_shaderModel;
+        const size_t separator = model.find('_');
+        return {
+            { "__HLSL_VERSION", "2021" },
+            { "__spirv__", "1" },
+            { "__SHADER_STAGE_PIXEL", "0" },
+            { "__SHADER_STAGE_VERTEX", "1" },
+            { "__SHADER_STAGE_GEOMETRY", "2" },
+            { "__SHADER_STAGE_HULL", "3" },
+            { "__SHADER_STAGE_DOMAIN", "4" },
+            { "__SHADER_STAGE_COMPUTE", "5" },
+            { "__SHADER_TARGET_STAGE", std::to_string(GetStageInfo(_stage).m_dxcStage) },
+            { "__SHADER_TARGET_MAJOR", model.substr(0, separator) },
+            { "__SHADER_TARGET_MINOR", separator == std::string::npos ? "0" : model.substr(separator + 1) },
+        };
+    }
+
+    const std::string& ShaderCompiler::GetIdentity(ShaderLanguage _language)
+    {
+        const std::lock_guard lock(m_identityMutex);
+        std::optional<std::string>& identity = m_identities[size_t(_language)];
+        if (!identity.has_value())
+        {
+            const std::string& compiler = _language == ShaderLanguage::Hlsl ? m_settings.m_dxcPath : m_settings.m_glslangPath;
+            const std::string arguments[] = { compiler, "--version" };
+            const ProcessResult version = RunProcess(arguments);
+            KT_VERIFY(version.m_exitCode == 0, "Unable to run the %s compiler '%s': %s", GetShaderLanguageName(_language), compiler.c_str(), version.m_output.c_str());
+            identity = FormatString(
+                "%s|%s|%s|%d",
+                version.m_output.c_str(),
+                m_settings.m_targetEnvironment.c_str(),
+                _language == ShaderLanguage::Hlsl ? m_settings.m_shaderModel.c_str() : "",
+                m_settings.m_debugInfo ? 1 : 0);
+        }
+        return *identity;
+    }
+
+    std::vector<std::string> ShaderCompiler::GetArguments(const ShaderCompileRequest& _request, const std::filesystem::path& _input, const std::filesystem::path& _output) const
+    {
+        const StageInfo& stage = GetStageInfo(_request.m_stage);
+        if (_request.m_language == ShaderLanguage::Hlsl)
+        {
+            std::vector<std::string> arguments = {
+                m_settings.m_dxcPath,
+                "-spirv",
+                "-fspv-target-env=" + m_settings.m_targetEnvironment,
+                "-T", std::string(stage.m_dxcProfile) + "_" + m_settings.m_shaderModel,
+                "-E", _request.m_entryPoint,
+                "-Fo", _output.string(),
+            };
+            arguments.emplace_back(m_settings.m_debugInfo ? "-Zi" : "-O3");
+            arguments.push_back(_input.string());
+            return arguments;
+        }
+
+        std::vector<std::string> arguments = {
+            m_settings.m_glslangPath,
+            "-V",
+            "--target-env", m_settings.m_targetEnvironment,
+            "-S", stage.m_glslangStage,
+            "-o", _output.string(),
+        };
+        if (_request.m_entryPoint != "main")
+        {
+            arguments.insert(arguments.end(), { "-e", _request.m_entryPoint, "--source-entrypoint", _request.m_entryPoint });
+        }
+        if (m_settings.m_debugInfo)
+        {
+            arguments.emplace_back("-g");
+        }
+        arguments.push_back(_input.string());
+        return arguments;
+    }
+
+    void ShaderCompiler::Compile(const ShaderCompileRequest& _request, const std::filesystem::path& _output)
+    {
+        KT_TRACE_ZONE_DETAIL("CompileShader", _output.string());
+        std::filesystem::path input = _output;
+        input.replace_extension(FormatString(".%s.%s", GetStageInfo(_request.m_stage).m_glslangStage, GetShaderLanguageName(_request.m_language)));
+        FileSystem::WriteFile(input, std::span(reinterpret_cast<const u8*>(_request.m_source.data()), _request.m_source.size()));
+
+        const std::vector<std::string> arguments = GetArguments(_request, input, _output);
+        const ProcessResult result = RunProcess(arguments);
+        KT_VERIFY(result.m_exitCode == 0, "Compilation of '%s' failed:\n%s", input.string().c_str(), result.m_output.c_str());
+
+        std::error_code error;
+        std::filesystem::remove(input, error);
+
+        constexpr u32 kSpirvMagic = 0x07230203;
+        const std::vector<u8> spirv = FileSystem::ReadFile(_output);
+        KT_VERIFY(
+            spirv.size() >= 20 && spirv.size() % 4 == 0 && spirv[0] == u8(kSpirvMagic) && spirv[3] == u8(kSpirvMagic >> 24),
+            "'%s' did not produce a valid SPIR-V module",
+            arguments[0].c_str());
+    }
+}
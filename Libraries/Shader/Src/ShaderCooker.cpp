@@ -0,0 +1,262 @@
+#include "KryneTools/Shader/ShaderCooker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Shader/ShaderReflectionWriter.hpp"
+#include "KryneTools/Shader/ShaderWriter.hpp"
+#include "KryneTools/Shader/SpirvReflection.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        struct CacheKeyHash
+        {
+            size_t operator()(const CacheKey& _key) const { return size_t(_key.m_value); }
+        };
+
+        struct UniqueSource
+        {
+            const ShaderDescription* m_shader = nullptr;
+            /// First permutation leading to this source, for diagnostics.
+            u64 m_permutation = 0;
+            std::string m_text;
+            std::vector<u8> m_spirv;
+        };
+
+        /// Distinct preprocessed sources, filled concurrently by the preprocessing jobs.
+        class SourceTable
+        {
+        public:
+            u32 Insert(const CacheKey& _key, const ShaderDescription& _shader, u64 _permutation, std::string&& _text)
+            {
+                const std::lock_guard lock(m_mutex);
+                const auto [it, inserted] = m_indices.try_emplace(_key, u32(m_sources.size()));
+                if (inserted)
+                {
+                    m_keys.push_back(_key);
+                    m_sources.push_back({ &_shader, _permutation, std::move(_text), {} });
+                }
+                return it->second;
+            }
+
+            [[nodiscard]] size_t GetCount() const { return m_sources.size(); }
+            [[nodiscard]] const CacheKey& GetKey(size_t _index) const { return m_keys[_index]; }
+            [[nodiscard]] UniqueSource& Get(size_t _index) { return m_sources[_index]; }
+
+        private:
+            std::mutex m_mutex;
+            std::unordered_map<CacheKey, u32, CacheKeyHash> m_indices;
+            std::vector<CacheKey> m_keys;
+            std::deque<UniqueSource> m_sources;
+        };
+
+        std::string DescribePermutation(const ShaderDescription& _shader, u64 _permutation)
+        {
+            std::string text = _shader.m_name;
+            const std::vector<ShaderDefine> defines = _shader.GetPermutationDefines(_permutation);
+            for (size_t d = _shader.m_defines.size(); d < defines.size(); d++)
+            {
+                text += FormatString(" %s=%s", defines[d].m_name.c_str(), defines[d].m_value.c_str());
+            }
+            return text;
+        }
+    }
+
+    ShaderCookStatistics CookShaders(JobSystem& _jobSystem, const ShaderManifest& _manifest, const ShaderCookSettings& _settings)
+    {
+        KT_TRACE_ZONE("CookShaders");
+        ShaderCompilerSettings compilerSettings = _settings.m_compiler;
+        if (compilerSettings.m_scratchDirectory.empty())
+        {
+            compilerSettings.m_scratchDirectory = _settings.m_outputDirectory / ".kryne-shaderc";
+        }
+        ShaderCompiler compiler(compilerSettings);
+        const std::filesystem::path& scratchDirectory = compilerSettings.m_scratchDirectory;
+
+        std::vector<std::filesystem::path> includeDirectories = _manifest.m_includeDirectories;
+        includeDirectories.insert(includeDirectories.end(), _settings.m_includeDirectories.begin(), _settings.m_includeDirectories.end());
+        ShaderSourceCache sources(std::move(includeDirectories));
+
+        // Compiler identities first, the preprocessing jobs only read them.
+        for (const ShaderDescription& shader: _manifest.m_shaders)
+        {
+            (void)compiler.GetIdentity(shader.m_language);
+        }
+
+        struct PermutationRange
+        {
+            const ShaderDescription* m_shader;
+            u64 m_first;
+        };
+        std::vector<PermutationRange> ranges;
+        ShaderCookStatistics statistics;
+        for (const ShaderDescription& shader: _manifest.m_shaders)
+        {
+            ranges.push_back({ &shader, statistics.m_permutationCount });
+            statistics.m_permutationCount += shader.GetPermutationCount();
+        }
+
+        // Preprocess every permutation, keeping only distinct sources.
+        SourceTable table;
+        std::vector<u32> permutationSources(statistics.m_permutationCount);
+        _jobSystem.ParallelFor(statistics.m_permutationCount, 16, [&](u64 _begin, u64 _end)
+        {
+            for (u64 p = _begin; p < _end; p++)
+            {
+                const auto range = std::prev(std::upper_bound(ranges.begin(), ranges.end(), p, [](u64 _p, const PermutationRange& _range) { return _p < _range.m_first; }));
+                const ShaderDescription& shader = *range->m_shader;
+                const u64 permutation = p - range->m_first;
+
+                std::vector<ShaderDefine> defines = compiler.GetPredefinedMacros(shader.m_language, shader.m_stage);
+                const std::vector<ShaderDefine> permutationDefines = shader.GetPermutationDefines(permutation);
+                defines.insert(defines.end(), permutationDefines.begin(), permutationDefines.end());
+                std::string text = PreprocessShader(sources, shader.m_source, defines);
+
+                CacheKeyBuilder builder("kryne-shaderc");
+                builder.AddU64(u64(shader.m_language));
+                builder.AddU64(u64(shader.m_stage));
+                builder.AddString(shader.m_entryPoint);
+                builder.AddString(compiler.GetIdentity(shader.m_language));
+                builder.AddString(text);
+                permutationSources[p] = table.Insert(builder.Build(), shader, permutation, std::move(text));
+            }
+        });
+        statistics.m_uniqueSourceCount = table.GetCount();
+
+        // Compile or restore every distinct source.
+        std::atomic<u64> compiledCount = 0;
+        std::atomic<u64> cacheHitCount = 0;
+        std::atomic<u64> remoteCount = 0;
+        const bool useCache = _settings.m_cache != nullptr && _settings.m_cache->IsEnabled();
+        _jobSystem.ParallelFor(table.GetCount(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 s = _begin; s < _end; s++)
+            {
+                UniqueSource& source = table.Get(s);
+                const CacheKey& key = table.GetKey(s);
+                const std::filesystem::path directory = scratchDirectory / key.ToString();
+                const std::filesystem::path output = directory / "module.spv";
+                if (useCache && _settings.m_cache->Restore(key, directory))
+                {
+                    cacheHitCount++;
+                }
+                else
+                {
+                    ShaderCompileRequest request;
+                    request.m_language = source.m_shader->m_language;
+                    request.m_stage = source.m_shader->m_stage;
+                    request.m_entryPoint = source.m_shader->m_entryPoint;
+                    request.m_source = source.m_text;
+                    const std::string permutation = DescribePermutation(*source.m_shader, source.m_permutation);
+                    Log::Verbose("Compiling %s", permutation.c_str());
+                    std::optional<std::vector<u8>> remoteModule;
+                    if (_settings.m_remoteCompile)
+                    {
+                        remoteModule = _settings.m_remoteCompile(request, compiler.GetIdentity(request.m_language), key);
+                    }
+                    if (remoteModule.has_value())
+                    {
+                        FileSystem::WriteFile(output, *remoteModule);
+                        remoteCount++;
+                    }
+                    else
+                    {
+                        try
+                        {
+                            compiler.Compile(request, output);
+                        }
+                        catch (const Error& exception)
+                        {
+                            ThrowError("%s: %s", permutation.c_str(), exception.what());
+                        }
+                    }
+                    if (useCache)
+                    {
+                        _settings.m_cache->Store(key, directory, std::span(&output, 1));
+                    }
+                    compiledCount++;
+                }
+                source.m_spirv = FileSystem::ReadFile(output);
+                source.m_text = {};
+            }
+        });
+        statistics.m_compiledCount = compiledCount;
+        statistics.m_cacheHitCount = cacheHitCount;
+        statistics.m_remoteCount = remoteCount;
+
+        // Distinct sources may still compile to the same module.
+        if (!_settings.m_reflectionDirectory.empty())
+        {
+            WriteShaderReflectionTypes(_settings.m_reflectionDirectory);
+        }
+        for (const PermutationRange& range: ranges)
+        {
+            const ShaderDescription& shader = *range.m_shader;
+            CompiledShader compiled;
+            compiled.m_description = &shader;
+            // Hashes only find candidates, a module is shared once its bytes compare equal.
+            std::unordered_multimap<u64, u32> modulesByHash;
+            for (u64 p = 0; p < shader.GetPermutationCount(); p++)
+            {
+                const std::vector<u8>& spirv = table.Get(permutationSources[range.m_first + p]).m_spirv;
+                const u64 hash = Hash64(spirv);
+                u32 module = ~0u;
+                const auto [first, last] = modulesByHash.equal_range(hash);
+                for (auto candidate = first; candidate != last; ++candidate)
+                {
+                    if (compiled.m_modules[candidate->second] == spirv)
+                    {
+                        module = candidate->second;
+                        break;
+                    }
+                }
+                if (module == ~0u)
+                {
+                    module = u32(compiled.m_modules.size());
+                    compiled.m_modules.push_back(spirv);
+                    modulesByHash.emplace(hash, module);
+                }
+                compiled.m_permutationModules.push_back(module);
+            }
+            statistics.m_moduleCount += compiled.m_modules.size();
+
+            const std::filesystem::path path = _settings.m_outputDirectory / (shader.m_name + ".kshd");
+            WriteShaderFile(path, compiled);
+            if (!_settings.m_reflectionDirectory.empty())
+            {
+                std::vector<ShaderReflection> reflections;
+                for (const std::vector<u8>& module: compiled.m_modules)
+                {
+                    try
+                    {
+                        reflections.push_back(ReflectSpirv({ reinterpret_cast<const u32*>(module.data()), module.size() / sizeof(u32) }));
+                    }
+                    catch (const Error& exception)
+                    {
+                        ThrowError("%s: %s", shader.m_name.c_str(), exception.what());
+                    }
+                }
+                WriteShaderReflectionHeader(_settings.m_reflectionDirectory / (shader.m_name + ".reflection.hpp"), shader, reflections);
+            }
+            Log::Verbose("%s: %llu permutations, %zu modules", path.string().c_str(), static_cast<unsigned long long>(shader.GetPermutationCount()), compiled.m_modules.size());
+            statistics.m_outputs.push_back(path);
+        }
+
+        std::error_code error;
+        std::filesystem::remove_all(scratchDirectory, error);
+        return statistics;
+    }
+}
@@ -0,0 +1,108 @@
+#include "KryneTools/Shader/ShaderManifest.hpp"
+
+#include <cmath>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Json/Json.hpp"
+
+namespace KryneTools
+{
+    std::string GetShaderDefineValue(const JsonValue& _value, const char* _context)
+    {
+        if (_value.IsString())
+        {
+            return std::string(_value.AsString());
+        }
+        if (_value.IsNumber())
+        {
+            const f64 number = _value.AsNumber();
+            return number == std::floor(number) && std::fabs(number) < 1e15 ? std::to_string(s64(number)) : FormatString("%.9g", number);
+        }
+        if (_value.GetType() == JsonValue::Type::Bool)
+        {
+            return _value.AsBool() ? "1" : "0";
+        }
+        ThrowError("%s: define values must be strings, numbers or booleans", _context);
+    }
+
+    u64 ShaderDescription::GetPermutationCount() const
+    {
+        u64 count = 1;
+        for (const PermutationAxis& axis: m_axes)
+        {
+            count *= axis.m_values.size();
+        }
+        return count;
+    }
+
+    std::vector<ShaderDefine> ShaderDescription::GetPermutationDefines(u64 _index) const
+    {
+        std::vector<ShaderDefine> defines = m_defines;
+        defines.resize(m_defines.size() + m_axes.size());
+        for (size_t a = m_axes.size(); a-- > 0;)
+        {
+            const PermutationAxis& axis = m_axes[a];
+            defines[m_defines.size() + a] = { axis.m_name, axis.m_values[_index % axis.m_values.size()] };
+            _index /= axis.m_values.size();
+        }
+        return defines;
+    }
+
+    ShaderManifest LoadShaderManifest(const std::filesystem::path& _path)
+    {
+        const std::vector<u8> data = FileSystem::ReadFile(_path);
+        const JsonValue document = JsonValue::Parse(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+        const std::filesystem::path directory = _path.parent_path();
+        const std::string manifestName = _path.string();
+
+        ShaderManifest manifest;
+        for (const JsonValue& includeDirectory: document["include_directories"].AsArray())
+        {
+            manifest.m_includeDirectories.push_back(directory / includeDirectory.AsString());
+        }
+
+        for (const JsonValue& entry: document["shaders"].AsArray())
+        {
+            ShaderDescription shader;
+            shader.m_name = entry["name"].AsString();
+            KT_VERIFY(!shader.m_name.empty(), "%s: every shader needs a name", manifestName.c_str());
+            const std::string context = manifestName + ": " + shader.m_name;
+            KT_VERIFY(entry["source"].IsString(), "%s: missing source", context.c_str());
+            shader.m_source = directory / entry["source"].AsString();
+
+            const std::string extension = shader.m_source.extension().string();
+            const std::string_view language = entry["language"].AsString(extension == ".hlsl" ? "hlsl" : "glsl");
+            const std::optional<ShaderLanguage> parsedLanguage = ParseShaderLanguage(language);
+            KT_VERIFY(parsedLanguage.has_value(), "%s: unknown language '%.*s'", context.c_str(), int(language.size()), language.data());
+            shader.m_language = *parsedLanguage;
+
+            const std::string_view stage = entry["stage"].AsString(extension.empty() ? std::string_view() : std::string_view(extension).substr(1));
+            const std::optional<ShaderStage> parsedStage = ParseShaderStage(stage);
+            KT_VERIFY(parsedStage.has_value(), "%s: unknown or missing stage '%.*s'", context.c_str(), int(stage.size()), stage.data());
+            shader.m_stage = *parsedStage;
+            shader.m_entryPoint = entry["entry"].AsString("main");
+
+            for (const auto& [name, value]: entry["defines"].AsObject())
+            {
+                shader.m_defines.push_back({ name, GetShaderDefineValue(value, context.c_str()) });
+            }
+            for (const JsonValue& axisEntry: entry["permutations"].AsArray())
+            {
+                PermutationAxis axis;
+                axis.m_name = axisEntry["name"].AsString();
+                KT_VERIFY(!axis.m_name.empty(), "%s: every permutation axis needs a name", context.c_str());
+                for (const JsonValue& value: axisEntry["values"].AsArray())
+                {
+                    axis.m_values.push_back(GetShaderDefineValue(value, context.c_str()));
+                }
+                KT_VERIFY(!axis.m_values.empty() && axis.m_values.size() <= 0xFFFF, "%s: axis %s needs 1 to 65535 values", context.c_str(), axis.m_name.c_str());
+                shader.m_axes.push_back(std::move(axis));
+            }
+            KT_VERIFY(shader.GetPermutationCount() <= (1u << 24), "%s: too many permutations (%llu)", context.c_str(), static_cast<unsigned long long>(shader.GetPermutationCount()));
+            manifest.m_shaders.push_back(std::move(shader));
+        }
+        KT_VERIFY(!manifest.m_shaders.empty(), "%s: no shaders", manifestName.c_str());
+        return manifest;
+    }
+}
@@ -0,0 +1,1195 @@
+#include "KryneTools/Shader/ShaderPreprocessor.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <unordered_set>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        enum class TokenKind: u8
+        {
+            Identifier,
+            Number,
+            String,
+            Punctuator,
+        };
+
+        struct Token
+        {
+            /// Points in the source cache or the preprocessor string arena, both outliving the run.
+            std::string_view m_text;
+            TokenKind m_kind = TokenKind::Punctuator;
+            /// Preceded by whitespace.
+            bool m_space = false;
+            /// Macros this token came out of, which must not expand it again. Index in `HideSets`, 0 is empty.
+            u32 m_hideSet = 0;
+        };
+
+        constexpr std::string_view kPunctuators[] = {
+            "<<=", ">>=", "...",
+            "##", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "++", "--",
+            "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "->", "::",
+        };
+
+        bool IsIdentifierStart(char _c)
+        {
+            return (_c >= 'a' && _c <= 'z') || (_c >= 'A' && _c <= 'Z') || _c == '_';
+        }
+
+        bool IsDigit(char _c)
+        {
+            return _c >= '0' && _c <= '9';
+        }
+
+        bool IsIdentifierChar(char _c)
+        {
+            return IsIdentifierStart(_c) || IsDigit(_c);
+        }
+
+        bool IsSpace(char _c)
+        {
+            return _c == ' ' || _c == '\t' || _c == '\f' || _c == '\v';
+        }
+
+        void Tokenize(std::string_view _text, std::vector<Token>& _tokens)
+        {
+            size_t i = 0;
+            bool space = false;
+            while (i < _text.size())
+            {
+                const char c = _text[i];
+                if (IsSpace(c))
+                {
+                    space = true;
+                    i++;
+                    continue;
+                }
+
+                Token token;
+                token.m_space = space;
+                space = false;
+                const size_t start = i;
+                if (IsIdentifierStart(c))
+                {
+                    while (i < _text.size() && IsIdentifierChar(_text[i]))
+                    {
+                        i++;
+                    }
+                    token.m_kind = TokenKind::Identifier;
+                }
+                else if (IsDigit(c) || (c == '.' && i + 1 < _text.size() && IsDigit(_text[i + 1])))
+                {
+                    // Preprocessing number: digits, letters, dots and signed exponents.
+                    i++;
+                    while (i < _text.size())
+                    {
+                        const char n = _text[i];
+                        if ((n == '+' || n == '-') && (_text[i - 1] == 'e' || _text[i - 1] == 'E' || _text[i - 1] == 'p' || _text[i - 1] == 'P'))
+                        {
+                            i++;
+                        }
+                        else if (IsIdentifierChar(n) || n == '.')
+                        {
+                            i++;
+                        }
+                        else
+                        {
+                            break;
+                        }
+                    }
+                    token.m_kind = TokenKind::Number;
+                }
+                else if (c == '"' || c == '\'')
+                {
+                    i++;
+                    while (i < _text.size() && _text[i] != c)
+                    {
+                        i += _text[i] == '\\' ? 2 : 1;
+                    }
+                    i = std::min(i + 1, _text.size());
+                    token.m_kind = TokenKind::String;
+                }
+                else
+                {
+                    size_t length = 1;
+                    for (const std::string_view punctuator: kPunctuators)
+                    {
+                        if (_text.substr(i, punctuator.size()) == punctuator)
+                        {
+                            length = punctuator.size();
+                            break;
+                        }
+                    }
+                    i += length;
+                    token.m_kind = TokenKind::Punctuator;
+                }
+                token.m_text = _text.substr(start, i - start);
+                _tokens.push_back(token);
+            }
+        }
+
+        /// Two tokens written without a space would read as different tokens.
+        bool NeedsSeparator(std::string_view _previous, std::string_view _next)
+        {
+            const char last = _previous.back();
+            const char first = _next.front();
+            if ((IsIdentifierChar(last) || last == '.') && (IsIdentifierChar(first) || first == '.'))
+            {
+                return true;
+            }
+            if (last == '/' && (first == '/' || first == '*'))
+            {
+                return true;
+            }
+            for (const std::string_view punctuator: kPunctuators)
+            {
+                if (punctuator.size() > _previous.size() && punctuator.starts_with(_previous) && punctuator[_previous.size()] == first)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    struct ShaderSourceLine
+    {
+        u32 m_number = 0;
+        /// Starts with `#`, the directive name is the second token.
+        bool m_directive = false;
+        std::vector<Token> m_tokens;
+    };
+
+    struct ShaderSourceFile
+    {
+        std::filesystem::path m_path;
+        /// Normalized absolute path, identifying the file for `#pragma once`.
+        std::string m_key;
+        /// Logical lines, spliced and without comments, that the tokens point in.
+        std::string m_text;
+        std::vector<ShaderSourceLine> m_lines;
+    };
+
+    namespace
+    {
+        /// Splices continued lines and replaces comments with a space, then tokenizes every logical line.
+        void ParseSource(std::string_view _source, ShaderSourceFile& _file)
+        {
+            struct LineRange
+            {
+                u32 m_number;
+                size_t m_begin;
+                size_t m_end;
+            };
+            std::vector<LineRange> ranges;
+            std::string& text = _file.m_text;
+            text.reserve(_source.size());
+
+            u32 lineNumber = 1;
+            u32 logicalLineNumber = 1;
+            size_t lineBegin = 0;
+            const auto endLine = [&]
+            {
+                ranges.push_back({ logicalLineNumber, lineBegin, text.size() });
+                text += '\n';
+                lineBegin = text.size();
+                logicalLineNumber = lineNumber;
+            };
+
+            size_t i = 0;
+            while (i < _source.size())
+            {
+                const char c = _source[i];
+                const char next = i + 1 < _source.size() ? _source[i + 1] : '\0';
+                if (c == '\\' && (next == '\n' || (next == '\r' && i + 2 < _source.size() && _source[i + 2] == '\n')))
+                {
+                    i += next == '\n' ? 2 : 3;
+                    lineNumber++;
+                }
+                else if (c == '/' && next == '/')
+                {
+                    while (i < _source.size() && _source[i] != '\n')
+                    {
+                        // Continued line comments go on, like in C.
+                        if (_source[i] == '\\' && i + 1 < _source.size() && _source[i + 1] == '\n')
+                        {
+                            lineNumber++;
+                            i++;
+                        }
+                        i++;
+                    }
+                }
+                else if (c == '/' && next == '*')
+                {
+                    i += 2;
+                    while (i < _source.size() && !(_source[i] == '*' && i + 1 < _source.size() && _source[i + 1] == '/'))
+                    {
+                        lineNumber += _source[i] == '\n' ? 1 : 0;
+                        i++;
+                    }
+                    i += 2;
+                    text += ' ';
+                }
+                else if (c == '"')
+                {
+                    text += c;
+                    i++;
+                    while (i < _source.size() && _source[i] != '"' && _source[i] != '\n')
+                    {
+                        if (_source[i] == '\\' && i + 1 < _source.size())
+                        {
+                            text += _source[i++];
+                        }
+                        text += _source[i++];
+                    }
+                    if (i < _source.size() && _source[i] == '"')
+                    {
+                        text += _source[i++];
+                    }
+                }
+                else if (c == '\n')
+                {
+                    i++;
+                    lineNumber++;
+                    endLine();
+                }
+                else
+                {
+                    if (c != '\r')
+                    {
+                        text += c;
+                    }
+                    i++;
+                }
+            }
+            if (lineBegin != text.size())
+            {
+                endLine();
+            }
+
+            // The text does not change any more, tokens can point in it.
+            for (const LineRange& range: ranges)
+            {
+                ShaderSourceLine line;
+                line.m_number = range.m_number;
+                Tokenize(std::string_view(text).substr(range.m_begin, range.m_end - range.m_begin), line.m_tokens);
+                if (line.m_tokens.empty())
+                {
+                    continue;
+                }
+                line.m_directive = line.m_tokens.front().m_text == "#";
+                _file.m_lines.push_back(std::move(line));
+            }
+        }
+    }
+
+    ShaderSourceCache::ShaderSourceCache(std::vector<std::filesystem::path> _includeDirectories)
+        : m_includeDirectories(std::move(_includeDirectories))
+    {}
+
+    ShaderSourceCache::~ShaderSourceCache() = default;
+
+    const ShaderSourceFile& ShaderSourceCache::Load(const std::filesystem::path& _path)
+    {
+        const std::filesystem::path normalized = std::filesystem::absolute(_path).lexically_normal();
+        std::string key = normalized.generic_string();
+
+        const std::lock_guard lock(m_mutex);
+        std::unique_ptr<ShaderSourceFile>& file = m_files[key];
+        if (file == nullptr)
+        {
+            const std::vector<u8> data = FileSystem::ReadFile(_path);
+            auto source = std::make_unique<ShaderSourceFile>();
+            source->m_path = _path;
+            source->m_key = std::move(key);
+            ParseSource(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()), *source);
+            file = std::move(source);
+        }
+        return *file;
+    }
+
+    std::filesystem::path ShaderSourceCache::ResolveInclude(std::string_view _name, const std::filesystem::path& _includer, bool _angled) const
+    {
+        std::error_code error;
+        if (!_angled)
+        {
+            std::filesystem::path candidate = _includer.parent_path() / _name;
+            if (std::filesystem::is_regular_file(candidate, error))
+            {
+                return candidate;
+            }
+        }
+        for (const std::filesystem::path& directory: m_includeDirectories)
+        {
+            std::filesystem::path candidate = directory / _name;
+            if (std::filesystem::is_regular_file(candidate, error))
+            {
+                return candidate;
+            }
+        }
+        return {};
+    }
+
+    namespace
+    {
+        constexpr u32 kMaxIncludeDepth = 64;
+
+        struct Macro
+        {
+            u32 m_id = 0;
+            bool m_function = false;
+            bool m_variadic = false;
+            /// Variadic macros end with `__VA_ARGS__`.
+            std::vector<std::string_view> m_parameters;
+            std::vector<Token> m_body;
+        };
+
+        struct Conditional
+        {
+            /// The enclosing region is active.
+            bool m_parentActive = true;
+            bool m_active = false;
+            /// A previous branch of this conditional was taken.
+            bool m_taken = false;
+            bool m_sawElse = false;
+        };
+
+        /// Interned sets of macro IDs, with memoized insertions.
+        class HideSets
+        {
+        public:
+            HideSets()
+                : m_sets(1)
+            {}
+
+            [[nodiscard]] bool Contains(u32 _set, u32 _id) const
+            {
+                return std::ranges::binary_search(m_sets[_set], _id);
+            }
+
+            [[nodiscard]] u32 Add(u32 _set, u32 _id)
+            {
+                if (Contains(_set, _id))
+                {
+                    return _set;
+                }
+                const auto [it, inserted] = m_additions.try_emplace((u64(_set) << 32) | _id, 0);
+                if (inserted)
+                {
+                    std::vector<u32> ids = m_sets[_set];
+                    ids.insert(std::ranges::upper_bound(ids, _id), _id);
+                    m_sets.push_back(std::move(ids));
+                    it->second = u32(m_sets.size() - 1);
+                }
+                return it->second;
+            }
+
+            [[nodiscard]] u32 Union(u32 _a, u32 _b)
+            {
+                // Copy, `Add()` may reallocate.
+                const std::vector<u32> ids = m_sets[_b];
+                for (const u32 id: ids)
+                {
+                    _a = Add(_a, id);
+                }
+                return _a;
+            }
+
+        private:
+            std::vector<std::vector<u32>> m_sets;
+            std::map<u64, u32> m_additions;
+        };
+
+        class Preprocessor
+        {
+        public:
+            Preprocessor(ShaderSourceCache& _sources, std::span<const ShaderDefine> _defines)
+                : m_sources(_sources)
+            {
+                for (const ShaderDefine& define: _defines)
+                {
+                    std::vector<Token> body;
+                    Tokenize(Intern(define.m_value), body);
+                    Macro macro;
+                    macro.m_body = std::move(body);
+                    DefineMacro(Intern(define.m_name), std::move(macro));
+                }
+            }
+
+            std::string Run(const std::filesystem::path& _path)
+            {
+                ProcessFile(m_sources.Load(_path), 0);
+                return std::move(m_output);
+            }
+
+        private:
+            ShaderSourceCache& m_sources;
+            std::unordered_map<std::string_view, Macro> m_macros;
+            std::unordered_map<std::string_view, u32> m_macroIds;
+            HideSets m_hideSets;
+            std::unordered_set<std::string> m_onceFiles;
+            /// Owns the generated token texts, stable through growth.
+            std::deque<std::string> m_strings;
+            std::string m_output;
+
+            const ShaderSourceFile* m_file = nullptr;
+            const ShaderSourceLine* m_line = nullptr;
+
+            template <class... Args>
+            [[noreturn]] void Fail(const char* _format, Args... _args) const
+            {
+                const std::string message = FormatString(_format, _args...);
+                if (m_file != nullptr && m_line != nullptr)
+                {
+                    ThrowError("%s:%u: %s", m_file->m_path.string().c_str(), m_line->m_number, message.c_str());
+                }
+                ThrowError("%s", message.c_str());
+            }
+
+            std::string_view Intern(std::string _text)
+            {
+                return m_strings.emplace_back(std::move(_text));
+            }
+
+            void DefineMacro(std::string_view _name, Macro _macro)
+            {
+                const auto [it, inserted] = m_macroIds.try_emplace(_name, u32(m_macroIds.size()));
+                _macro.m_id = it->second;
+                m_macros.insert_or_assign(_name, std::move(_macro));
+            }
+
+            [[nodiscard]] const Macro* FindMacro(const Token& _token) const
+            {
+                if (_token.m_kind != TokenKind::Identifier)
+                {
+                    return nullptr;
+                }
+                const auto it = m_macros.find(_token.m_text);
+                return it != m_macros.end() && !m_hideSets.Contains(_token.m_hideSet, it->second.m_id) ? &it->second : nullptr;
+            }
+
+            void ProcessFile(const ShaderSourceFile& _file, u32 _depth)
+            {
+                if (m_onceFiles.contains(_file.m_key))
+                {
+                    return;
+                }
+                const ShaderSourceFile* previousFile = m_file;
+                const ShaderSourceLine* previousLine = m_line;
+                m_file = &_file;
+
+                std::vector<Conditional> conditionals;
+                std::vector<Token> pending;
+                for (const ShaderSourceLine& line: _file.m_lines)
+                {
+                    m_line = &line;
+                    const bool active = conditionals.empty() || conditionals.back().m_active;
+                    if (line.m_directive)
+                    {
+                        if (!pending.empty())
+                        {
+                            Fail("directive inside a macro invocation");
+                        }
+                        ProcessDirective(line, conditionals, active, _depth);
+                        continue;
+                    }
+                    if (!active)
+                    {
+                        continue;
+                    }
+
+                    // Function-like macro invocations may span several lines.
+                    const size_t joined = pending.size();
+                    pending.insert(pending.end(), line.m_tokens.begin(), line.m_tokens.end());
+                    if (joined > 0)
+                    {
+                        pending[joined].m_space = true;
+                    }
+                    if (!HasOpenInvocation(pending))
+                    {
+                        if (NeedsExpansion(pending))
+                        {
+                            EmitLine(Expand(std::move(pending)));
+                        }
+                        else
+                        {
+                            EmitLine(pending);
+                        }
+                        pending.clear();
+                    }
+                }
+                if (!pending.empty())
+                {
+                    Fail("unterminated macro invocation");
+                }
+                if (!conditionals.empty())
+                {
+                    Fail("unterminated conditional directive");
+                }
+
+                m_file = previousFile;
+                m_line = previousLine;
+            }
+
+            void ProcessDirective(const ShaderSourceLine& _line, std::vector<Conditional>& _conditionals, bool _active, u32 _depth)
+            {
+                const std::span<const Token> tokens(_line.m_tokens);
+                if (tokens.size() < 2)
+                {
+                    return;
+                }
+                const std::string_view name = tokens[1].m_text;
+                const std::span<const Token> arguments = tokens.subspan(2);
+
+                if (name == "if" || name == "ifdef" || name == "ifndef")
+                {
+                    Conditional conditional;
+                    conditional.m_parentActive = _active;
+                    if (_active)
+                    {
+                        conditional.m_active = name == "if" ? EvaluateCondition(arguments) : IsDefined(arguments) == (name == "ifdef");
+                    }
+                    conditional.m_taken = conditional.m_active;
+                    _conditionals.push_back(conditional);
+                    return;
+                }
+                if (name == "elif" || name == "else" || name == "endif")
+                {
+                    if (_conditionals.empty())
+                    {
+                        Fail("#%.*s without #if", int(name.size()), name.data());
+                    }
+                    Conditional& conditional = _conditionals.back();
+                    if (name == "endif")
+                    {
+                        _conditionals.pop_back();
+                        return;
+                    }
+                    if (conditional.m_sawElse)
+                    {
+                        Fail("#%.*s after #else", int(name.size()), name.data());
+                    }
+                    conditional.m_sawElse = name == "else";
+                    conditional.m_active = conditional.m_parentActive && !conditional.m_taken && (name == "else" || EvaluateCondition(arguments));
+                    conditional.m_taken |= conditional.m_active;
+                    return;
+                }
+                if (!_active)
+                {
+                    return;
+                }
+
+                if (name == "define")
+                {
+                    ProcessDefine(arguments);
+                }
+                else if (name == "undef")
+                {
+                    if (arguments.empty() || arguments[0].m_kind != TokenKind::Identifier)
+                    {
+                        Fail("#undef expects a macro name");
+                    }
+                    m_macros.erase(arguments[0].m_text);
+                }
+                else if (name == "include")
+                {
+                    ProcessInclude(arguments, _depth);
+                }
+                else if (name == "error")
+                {
+                    std::string message;
+                    AppendTokens(message, arguments);
+                    Fail("#error %s", message.c_str());
+                }
+                else if (name == "pragma" && arguments.size() == 1 && arguments[0].m_text == "once")
+                {
+                    m_onceFiles.insert(m_file->m_key);
+                }
+                else if (name == "line")
+                {
+                    // Line numbers do not survive normalization anyway.
+                }
+                else if (name == "version" || name == "extension" || name == "pragma")
+                {
+                    if (name == "version" && !arguments.empty() && arguments[0].m_kind == TokenKind::Number && !m_macros.contains("__VERSION__"))
+                    {
+                        Macro version;
+                        version.m_body.push_back(arguments[0]);
+                        DefineMacro("__VERSION__", std::move(version));
+                    }
+                    EmitLine(tokens);
+                }
+                else
+                {
+                    Fail("unknown directive #%.*s", int(name.size()), name.data());
+                }
+            }
+
+            void ProcessDefine(std::span<const Token> _arguments)
+            {
+                if (_arguments.empty() || _arguments[0].m_kind != TokenKind::Identifier)
+                {
+                    Fail("#define expects a macro name");
+                }
+                Macro macro;
+                size_t bodyStart = 1;
+                // Function-like only when the parenthesis immediately follows the name.
+                if (_arguments.size() > 1 && _arguments[1].m_text == "(" && !_arguments[1].m_space)
+                {
+                    macro.m_function = true;
+                    size_t i = 2;
+                    while (true)
+                    {
+                        if (i >= _arguments.size())
+                        {
+                            Fail("unterminated macro parameter list");
+                        }
+                        const Token& token = _arguments[i++];
+                        if (token.m_text == ")" && macro.m_parameters.empty())
+                        {
+                            break;
+                        }
+                        if (token.m_text == "...")
+                        {
+                            macro.m_variadic = true;
+                            macro.m_parameters.push_back("__VA_ARGS__");
+                        }
+                        else if (token.m_kind == TokenKind::Identifier && !macro.m_variadic)
+                        {
+                            macro.m_parameters.push_back(token.m_text);
+                        }
+                        else
+                        {
+                            Fail("invalid macro parameter '%.*s'", int(token.m_text.size()), token.m_text.data());
+                        }
+                        if (i >= _arguments.size() || (_arguments[i].m_text != "," && _arguments[i].m_text != ")"))
+                        {
+                            Fail("expected ',' or ')' in macro parameter list");
+                        }
+                        if (_arguments[i++].m_text == ")")
+                        {
+                            break;
+                        }
+                    }
+                    bodyStart = i;
+                }
+                macro.m_body.assign(_arguments.begin() + bodyStart, _arguments.end());
+                if (!macro.m_body.empty())
+                {
+                    macro.m_body.front().m_space = false;
+                }
+                DefineMacro(_arguments[0].m_text, std::move(macro));
+            }
+
+            void ProcessInclude(std::span<const Token> _arguments, u32 _depth)
+            {
+                std::string name;
+                bool angled = false;
+                if (_arguments.size() == 1 && _arguments[0].m_kind == TokenKind::String && _arguments[0].m_text.front() == '"')
+                {
+                    name = _arguments[0].m_text.substr(1, _arguments[0].m_text.size() - 2);
+                }
+                else if (_arguments.size() >= 3 && _arguments.front().m_text == "<" && _arguments.back().m_text == ">")
+                {
+                    angled = true;
+                    for (const Token& token: _arguments.subspan(1, _arguments.size() - 2))
+                    {
+                        name += token.m_text;
+                    }
+                }
+                else
+                {
+                    Fail("#include expects \"file\" or <file>");
+                }
+                if (_depth + 1 >= kMaxIncludeDepth)
+                {
+                    Fail("#include nested too deeply");
+                }
+
+                const std::filesystem::path path = m_sources.ResolveInclude(name, m_file->m_path, angled);
+                if (path.empty())
+                {
+                    Fail("include file '%s' not found", name.c_str());
+                }
+                ProcessFile(m_sources.Load(path), _depth + 1);
+            }
+
+            [[nodiscard]] bool IsDefined(std::span<const Token> _arguments) const
+            {
+                if (_arguments.empty() || _arguments[0].m_kind != TokenKind::Identifier)
+                {
+                    Fail("expected a macro name");
+                }
+                return m_macros.contains(_arguments[0].m_text);
+            }
+
+            [[nodiscard]] bool NeedsExpansion(std::span<const Token> _tokens) const
+            {
+                return std::ranges::any_of(_tokens, [this](const Token& _token) { return FindMacro(_token) != nullptr; });
+            }
+
+            /// A function-like macro name is followed by an unclosed argument list.
+            [[nodiscard]] bool HasOpenInvocation(std::span<const Token> _tokens) const
+            {
+                for (size_t i = 0; i + 1 < _tokens.size(); i++)
+                {
+                    const Macro* macro = FindMacro(_tokens[i]);
+                    if (macro == nullptr || !macro->m_function || _tokens[i + 1].m_text != "(")
+                    {
+                        continue;
+                    }
+                    s32 depth = 0;
+                    size_t j = i + 1;
+                    for (; j < _tokens.size(); j++)
+                    {
+                        depth += _tokens[j].m_text == "(" ? 1 : (_tokens[j].m_text == ")" ? -1 : 0);
+                        if (depth == 0)
+                        {
+                            break;
+                        }
+                    }
+                    if (j == _tokens.size())
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /// Fully expands a token sequence, rescanning every replacement together with the tokens following it.
+            std::vector<Token> Expand(std::vector<Token> _tokens)
+            {
+                std::vector<Token> output;
+                output.reserve(_tokens.size());
+                size_t i = 0;
+                while (i < _tokens.size())
+                {
+                    const Token token = _tokens[i];
+                    const Macro* macro = FindMacro(token);
+                    if (macro == nullptr)
+                    {
+                        output.push_back(token);
+                        i++;
+                        continue;
+                    }
+
+                    size_t end = i + 1;
+                    std::vector<std::vector<Token>> arguments;
+                    if (macro->m_function)
+                    {
+                        if (end >= _tokens.size() || _tokens[end].m_text != "(")
+                        {
+                            // Function-like macro name without arguments, left as is.
+                            output.push_back(token);
+                            i++;
+                            continue;
+                        }
+                        end = CollectArguments(_tokens, end, arguments);
+                        CheckArgumentCount(token, *macro, arguments);
+                    }
+
+                    std::vector<Token> replacement = Substitute(token, *macro, arguments);
+                    _tokens.erase(_tokens.begin() + s64(i), _tokens.begin() + s64(end));
+                    _tokens.insert(_tokens.begin() + s64(i), replacement.begin(), replacement.end());
+                }
+                return output;
+            }
+
+            /// @return The index after the closing parenthesis.
+            size_t CollectArguments(std::span<const Token> _tokens, size_t _open, std::vector<std::vector<Token>>& _arguments) const
+            {
+                _arguments.emplace_back();
+                s32 depth = 0;
+                for (size_t i = _open + 1; i < _tokens.size(); i++)
+                {
+                    const Token& token = _tokens[i];
+                    if (token.m_text == "(")
+                    {
+                        depth++;
+                    }
+                    else if (token.m_text == ")")
+                    {
+                        if (depth-- == 0)
+                        {
+                            return i + 1;
+                        }
+                    }
+                    else if (token.m_text == "," && depth == 0)
+                    {
+                        _arguments.emplace_back();
+                        continue;
+                    }
+                    _arguments.back().push_back(token);
+                }
+                Fail("unterminated macro invocation");
+            }
+
+            void CheckArgumentCount(const Token& _name, const Macro& _macro, std::vector<std::vector<Token>>& _arguments) const
+            {
+                const size_t parameterCount = _macro.m_parameters.size();
+                if (parameterCount == 0 && _arguments.size() == 1 && _arguments[0].empty())
+                {
+                    _arguments.clear();
+                    return;
+                }
+                if (_macro.m_variadic)
+                {
+                    if (_arguments.size() + 1 < parameterCount)
+                    {
+                        Fail("too few arguments to macro '%.*s'", int(_name.m_text.size()), _name.m_text.data());
+                    }
+                    // Extra arguments all go in __VA_ARGS__, with their commas.
+                    std::vector<Token> variadic;
+                    for (size_t a = parameterCount - 1; a < _arguments.size(); a++)
+                    {
+                        if (a > parameterCount - 1)
+                        {
+                            variadic.push_back({ ",", TokenKind::Punctuator });
+                        }
+                        variadic.insert(variadic.end(), _arguments[a].begin(), _arguments[a].end());
+                    }
+                    _arguments.resize(parameterCount - 1);
+                    _arguments.push_back(std::move(variadic));
+                    return;
+                }
+                if (_arguments.size() != parameterCount)
+                {
+                    Fail("macro '%.*s' expects %zu arguments, %zu given", int(_name.m_text.size()), _name.m_text.data(), parameterCount, _arguments.size());
+                }
+            }
+
+            [[nodiscard]] s32 FindParameter(const Macro& _macro, const Token& _token) const
+            {
+                if (!_macro.m_function || _token.m_kind != TokenKind::Identifier)
+                {
+                    return -1;
+                }
+                const auto it = std::ranges::find(_macro.m_parameters, _token.m_text);
+                return it == _macro.m_parameters.end() ? -1 : s32(it - _macro.m_parameters.begin());
+            }
+
+            std::vector<Token> Substitute(const Token& _name, const Macro& _macro, std::span<const std::vector<Token>> _arguments)
+            {
+                const u32 hideSet = m_hideSets.Add(_name.m_hideSet, _macro.m_id);
+                const std::vector<Token>& body = _macro.m_body;
+                std::vector<Token> result;
+                // The last element added came from an empty argument, which `##` then pastes as nothing.
+                bool lastEmpty = false;
+                for (size_t b = 0; b < body.size(); b++)
+                {
+                    const Token& token = body[b];
+                    if (_macro.m_function && token.m_text == "#" && b + 1 < body.size() && FindParameter(_macro, body[b + 1]) >= 0)
+                    {
+                        const std::vector<Token>& argument = _arguments[size_t(FindParameter(_macro, body[++b]))];
+                        result.push_back({ Stringize(argument), TokenKind::String, token.m_space });
+                        lastEmpty = false;
+                        continue;
+                    }
+                    if (token.m_text == "##" && b + 1 < body.size())
+                    {
+                        const Token& operandToken = body[++b];
+                        const s32 parameter = FindParameter(_macro, operandToken);
+                        std::vector<Token> operand = parameter >= 0 ? _arguments[size_t(parameter)] : std::vector<Token> { operandToken };
+                        if (operand.empty())
+                        {
+                            continue;
+                        }
+                        if (result.empty() || lastEmpty)
+                        {
+                            result.insert(result.end(), operand.begin(), operand.end());
+                            lastEmpty = false;
+                            continue;
+                        }
+                        Token& left = result.back();
+                        std::vector<Token> pasted;
+                        Tokenize(Intern(std::string(left.m_text) + std::string(operand.front().m_text)), pasted);
+                        if (pasted.size() != 1)
+                        {
+                            Fail("pasting '%.*s' and '%.*s' does not give a valid token", int(left.m_text.size()), left.m_text.data(), int(operand.front().m_text.size()), operand.front().m_text.data());
+                        }
+                        left.m_text = pasted[0].m_text;
+                        left.m_kind = pasted[0].m_kind;
+                        result.insert(result.end(), operand.begin() + 1, operand.end());
+                        continue;
+                    }
+
+                    const s32 parameter = FindParameter(_macro, token);
+                    if (parameter < 0)
+                    {
+                        result.push_back(token);
+                        lastEmpty = false;
+                        continue;
+                    }
+                    const bool pasted = b + 1 < body.size() && body[b + 1].m_text == "##";
+                    std::vector<Token> argument = pasted ? _arguments[size_t(parameter)] : Expand(_arguments[size_t(parameter)]);
+                    if (!argument.empty())
+                    {
+                        argument.front().m_space = token.m_space;
+                    }
+                    lastEmpty = argument.empty();
+                    result.insert(result.end(), argument.begin(), argument.end());
+                }
+
+                for (Token& token: result)
+                {
+                    token.m_hideSet = m_hideSets.Union(hideSet, token.m_hideSet);
+                }
+                if (!result.empty())
+                {
+                    result.front().m_space = _name.m_space;
+                }
+                return result;
+            }
+
+            std::string_view Stringize(std::span<const Token> _tokens)
+            {
+                std::string text = "\"";
+                for (size_t i = 0; i < _tokens.size(); i++)
+                {
+                    if (i > 0 && _tokens[i].m_space)
+                    {
+                        text += ' ';
+                    }
+                    for (const char c: _tokens[i].m_text)
+                    {
+                        if (_tokens[i].m_kind == TokenKind::String && (c == '"' || c == '\\'))
+                        {
+                            text += '\\';
+                        }
+                        text += c;
+                    }
+                }
+                text += '"';
+                return Intern(std::move(text));
+            }
+
+            bool EvaluateCondition(std::span<const Token> _tokens)
+            {
+                // `defined` is resolved before expansion, every identifier left after it evaluates to 0.
+                std::vector<Token> tokens;
+                for (size_t i = 0; i < _tokens.size(); i++)
+                {
+                    if (_tokens[i].m_text != "defined")
+                    {
+                        tokens.push_back(_tokens[i]);
+                        continue;
+                    }
+                    const bool parenthesized = i + 1 < _tokens.size() && _tokens[i + 1].m_text == "(";
+                    const size_t nameIndex = i + (parenthesized ? 2 : 1);
+                    if (nameIndex >= _tokens.size() || _tokens[nameIndex].m_kind != TokenKind::Identifier || (parenthesized && (nameIndex + 1 >= _tokens.size() || _tokens[nameIndex + 1].m_text != ")")))
+                    {
+                        Fail("invalid 'defined' in condition");
+                    }
+                    tokens.push_back({ m_macros.contains(_tokens[nameIndex].m_text) ? "1" : "0", TokenKind::Number, true });
+                    i = nameIndex + (parenthesized ? 1 : 0);
+                }
+                tokens = Expand(std::move(tokens));
+                if (tokens.empty())
+                {
+                    Fail("empty condition");
+                }
+
+                size_t position = 0;
+                const s64 value = ParseExpression(tokens, position, 0);
+                if (position != tokens.size())
+                {
+                    Fail("unexpected '%.*s' in condition", int(tokens[position].m_text.size()), tokens[position].m_text.data());
+                }
+                return value != 0;
+            }
+
+            [[nodiscard]] static s32 GetBinaryPrecedence(std::string_view _operator)
+            {
+                static const std::pair<std::string_view, s32> kPrecedences[] = {
+                    { "||", 1 }, { "&&", 2 }, { "|", 3 }, { "^", 4 }, { "&", 5 },
+                    { "==", 6 }, { "!=", 6 }, { "<", 7 }, { ">", 7 }, { "<=", 7 }, { ">=", 7 },
+                    { "<<", 8 }, { ">>", 8 }, { "+", 9 }, { "-", 9 }, { "*", 10 }, { "/", 10 }, { "%", 10 },
+                };
+                for (const auto& [text, precedence]: kPrecedences)
+                {
+                    if (text == _operator)
+                    {
+                        return precedence;
+                    }
+                }
+                return -1;
+            }
+
+            s64 ParseExpression(std::span<const Token> _tokens, size_t& _position, s32 _minimumPrecedence) const
+            {
+                s64 value = ParseUnary(_tokens, _position);
+                while (_position < _tokens.size())
+                {
+                    const std::string_view op = _tokens[_position].m_text;
+                    if (op == "?")
+                    {
+                        if (_minimumPrecedence > 0)
+                        {
+                            break;
+                        }
+                        _position++;
+                        const s64 whenTrue = ParseExpression(_tokens, _position, 0);
+                        if (_position >= _tokens.size() || _tokens[_position].m_text != ":")
+                        {
+                            Fail("expected ':' in condition");
+                        }
+                        _position++;
+                        const s64 whenFalse = ParseExpression(_tokens, _position, 0);
+                        value = value != 0 ? whenTrue : whenFalse;
+                        continue;
+                    }
+                    const s32 precedence = GetBinaryPrecedence(op);
+                    if (precedence < 0 || precedence < _minimumPrecedence)
+                    {
+                        break;
+                    }
+                    _position++;
+                    const s64 right = ParseExpression(_tokens, _position, precedence + 1);
+                    value = ApplyBinary(op, value, right);
+                }
+                return value;
+            }
+
+            s64 ApplyBinary(std::string_view _op, s64 _left, s64 _right) const
+            {
+                if (_op == "||") return (_left != 0 || _right != 0) ? 1 : 0;
+                if (_op == "&&") return (_left != 0 && _right != 0) ? 1 : 0;
+                if (_op == "|") return _left | _right;
+                if (_op == "^") return _left ^ _right;
+                if (_op == "&") return _left & _right;
+                if (_op == "==") return _left == _right ? 1 : 0;
+                if (_op == "!=") return _left != _right ? 1 : 0;
+                if (_op == "<") return _left < _right ? 1 : 0;
+                if (_op == ">") return _left > _right ? 1 : 0;
+                if (_op == "<=") return _left <= _right ? 1 : 0;
+                if (_op == ">=") return _left >= _right ? 1 : 0;
+                if (_op == "<<") return s64(u64(_left) << (_right & 63));
+                if (_op == ">>") return _left >> (_right & 63);
+                if (_op == "+") return s64(u64(_left) + u64(_right));
+                if (_op == "-") return s64(u64(_left) - u64(_right));
+                if (_op == "*") return s64(u64(_left) * u64(_right));
+                if (_right == 0)
+                {
+                    Fail("division by zero in condition");
+                }
+                return _op == "/" ? _left / _right : _left % _right;
+            }
+
+            s64 ParseUnary(std::span<const Token> _tokens, size_t& _position) const
+            {
+                if (_position >= _tokens.size())
+                {
+                    Fail("unexpected end of condition");
+                }
+                const Token& token = _tokens[_position++];
+                if (token.m_text == "(")
+                {
+                    const s64 value = ParseExpression(_tokens, _position, 0);
+                    if (_position >= _tokens.size() || _tokens[_position].m_text != ")")
+                    {
+                        Fail("expected ')' in condition");
+                    }
+                    _position++;
+                    return value;
+                }
+                if (token.m_text == "!") return ParseUnary(_tokens, _position) == 0 ? 1 : 0;
+                if (token.m_text == "-") return -ParseUnary(_tokens, _position);
+                if (token.m_text == "+") return ParseUnary(_tokens, _position);
+                if (token.m_text == "~") return ~ParseUnary(_tokens, _position);
+                if (token.m_kind == TokenKind::Identifier)
+                {
+                    return 0;
+                }
+                if (token.m_kind == TokenKind::Number)
+                {
+                    return ParseInteger(token.m_text);
+                }
+                Fail("unexpected '%.*s' in condition", int(token.m_text.size()), token.m_text.data());
+            }
+
+            s64 ParseInteger(std::string_view _text) const
+            {
+                std::string_view digits = _text;
+                while (!digits.empty() && (digits.back() == 'u' || digits.back() == 'U' || digits.back() == 'l' || digits.back() == 'L'))
+                {
+                    digits.remove_suffix(1);
+                }
+                u32 base = 10;
+                if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+                {
+                    base = 16;
+                    digits.remove_prefix(2);
+                }
+                else if (digits.size() > 1 && digits[0] == '0')
+                {
+                    base = 8;
+                    digits.remove_prefix(1);
+                }
+                u64 value = 0;
+                for (const char c: digits)
+                {
+                    u32 digit = 0;
+                    if (IsDigit(c))
+                    {
+                        digit = u32(c - '0');
+                    }
+                    else if (c >= 'a' && c <= 'f')
+                    {
+                        digit = u32(c - 'a' + 10);
+                    }
+                    else if (c >= 'A' && c <= 'F')
+                    {
+                        digit = u32(c - 'A' + 10);
+                    }
+                    else
+                    {
+                        digit = base;
+                    }
+                    if (digit >= base)
+                    {
+                        Fail("invalid integer '%.*s' in condition", int(_text.size()), _text.data());
+                    }
+                    value = value * base + digit;
+                }
+                return s64(value);
+            }
+
+            static void AppendTokens(std::string& _output, std::span<const Token> _tokens)
+            {
+                for (size_t i = 0; i < _tokens.size(); i++)
+                {
+                    if (i > 0 && (_tokens[i].m_space || NeedsSeparator(_tokens[i - 1].m_text, _tokens[i].m_text)))
+                    {
+                        _output += ' ';
+                    }
+                    _output += _tokens[i].m_text;
+                }
+            }
+
+            void EmitLine(std::span<const Token> _tokens)
+            {
+                if (_tokens.empty())
+                {
+                    return;
+                }
+                AppendTokens(m_output, _tokens);
+                m_output += '\n';
+            }
+        };
+    }
+
+    std::string PreprocessShader(ShaderSourceCache& _sources, const std::filesystem::path& _path, std::span<const ShaderDefine> _defines)
+    {
+        KT_TRACE_ZONE_DETAIL("PreprocessShader", _path.string());
+        Preprocessor preprocessor(_sources, _defines);
+        return preprocessor.Run(_path);
+    }
+}
@@ -0,0 +1,129 @@
+#include "KryneTools/Shader/ShaderReader.hpp"
+
+#include <cstring>
+#include <string>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        template <class T>
+        std::span<const T> GetArray(std::span<const u8> _data, u32 _offset, u32 _count, const char* _path, const char* _name)
+        {
+            KT_VERIFY(_offset % alignof(T) == 0, "%s: misaligned %s", _path, _name);
+            KT_VERIFY(_offset <= _data.size() && u64(_count) * sizeof(T) <= _data.size() - _offset, "%s: truncated %s", _path, _name);
+            return { reinterpret_cast<const T*>(_data.data() + _offset), _count };
+        }
+    }
+
+    ShaderFile ShaderFile::Open(const std::filesystem::path& _path)
+    {
+        ShaderFile file;
+        file.m_file = MappedFile::Open(_path);
+        const std::span<const u8> data = file.m_file.GetData();
+        const std::string pathString = _path.string();
+        const char* path = pathString.c_str();
+
+        ShaderFormat::Header& header = file.m_header;
+        KT_VERIFY(data.size() >= sizeof(header), "%s: truncated header", path);
+        std::memcpy(&header, data.data(), sizeof(header));
+        KT_VERIFY(header.m_magic == ShaderFormat::kMagic, "%s: not a kshd file", path);
+        KT_VERIFY(header.m_version == ShaderFormat::kVersion, "%s: unsupported version %u", path, u32(header.m_version));
+        KT_VERIFY(header.m_fileSize == data.size(), "%s: size mismatch", path);
+
+        file.m_axes = GetArray<ShaderFormat::AxisRecord>(data, header.m_axesOffset, header.m_axisCount, path, "axes");
+        file.m_values = GetArray<ShaderFormat::StringReference>(data, header.m_valuesOffset, header.m_valueCount, path, "values");
+        file.m_permutationModules = GetArray<u32>(data, header.m_permutationsOffset, header.m_permutationCount, path, "permutations");
+        file.m_modules = GetArray<ShaderFormat::ModuleRecord>(data, header.m_modulesOffset, header.m_moduleCount, path, "modules");
+        const std::span<const char> strings = GetArray<char>(data, header.m_stringsOffset, header.m_stringsSize, path, "strings");
+        file.m_strings = { strings.data(), strings.size() };
+
+        const auto verifyString = [&](const ShaderFormat::StringReference& _reference)
+        {
+            KT_VERIFY(u64(_reference.m_offset) + _reference.m_length <= file.m_strings.size(), "%s: string out of bounds", path);
+        };
+        verifyString(header.m_name);
+        verifyString(header.m_entryPoint);
+        u64 permutationCount = 1;
+        for (const ShaderFormat::AxisRecord& axis: file.m_axes)
+        {
+            verifyString(axis.m_name);
+            KT_VERIFY(axis.m_valueCount > 0 && u64(axis.m_firstValue) + axis.m_valueCount <= file.m_values.size(), "%s: axis values out of bounds", path);
+            permutationCount *= axis.m_valueCount;
+        }
+        KT_VERIFY(permutationCount == header.m_permutationCount, "%s: permutation count mismatch", path);
+        for (const ShaderFormat::StringReference& value: file.m_values)
+        {
+            verifyString(value);
+        }
+        for (const u32 module: file.m_permutationModules)
+        {
+            KT_VERIFY(module < header.m_moduleCount, "%s: permutation module out of bounds", path);
+        }
+        for (const ShaderFormat::ModuleRecord& module: file.m_modules)
+        {
+            KT_VERIFY(module.m_offset % ShaderFormat::kArrayAlignment == 0 && module.m_size % sizeof(u32) == 0, "%s: misaligned module", path);
+            KT_VERIFY(u64(module.m_offset) + module.m_size <= data.size(), "%s: module out of bounds", path);
+        }
+        return file;
+    }
+
+    u32 ShaderFile::FindPermutation(std::span<const ShaderDefine> _values) const
+    {
+        for (const ShaderDefine& value: _values)
+        {
+            bool found = false;
+            for (const ShaderFormat::AxisRecord& axis: m_axes)
+            {
+                found |= GetString(axis.m_name) == value.m_name;
+            }
+            KT_VERIFY(found, "Shader '%.*s' has no permutation axis '%s'", int(GetName().size()), GetName().data(), value.m_name.c_str());
+        }
+
+        u32 permutation = 0;
+        for (const ShaderFormat::AxisRecord& axis: m_axes)
+        {
+            const std::string_view name = GetString(axis.m_name);
+            u32 valueIndex = 0;
+            for (const ShaderDefine& value: _values)
+            {
+                if (value.m_name != name)
+                {
+                    continue;
+                }
+                valueIndex = axis.m_valueCount;
+                for (u32 v = 0; v < axis.m_valueCount; v++)
+                {
+                    if (GetString(m_values[axis.m_firstValue + v]) == value.m_value)
+                    {
+                        valueIndex = v;
+                        break;
+                    }
+                }
+                KT_VERIFY(
+                    valueIndex < axis.m_valueCount,
+                    "Shader '%.*s' axis '%.*s' has no value '%s'",
+                    int(GetName().size()),
+                    GetName().data(),
+                    int(name.size()),
+                    name.data(),
+                    value.m_value.c_str());
+            }
+            permutation = permutation * axis.m_valueCount + valueIndex;
+        }
+        return permutation;
+    }
+
+    std::span<const u32> ShaderFile::GetModule(u32 _module) const
+    {
+        const ShaderFormat::ModuleRecord& record = m_modules[_module];
+        return { reinterpret_cast<const u32*>(m_file.GetData().data() + record.m_offset), record.m_size / sizeof(u32) };
+    }
+
+    std::string_view ShaderFile::GetString(const ShaderFormat::StringReference& _reference) const
+    {
+        return m_strings.substr(_reference.m_offset, _reference.m_length);
+    }
+}
@@ -0,0 +1,348 @@
+#include "KryneTools/Shader/ShaderReflectionWriter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <string>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr std::string_view kTypesSource = R"(// Generated by kryne-shaderc, do not edit.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace KryneShaders
+{
+    /// Values match VkDescriptorType.
+    enum class DescriptorType: std::uint32_t
+    {
+        Sampler = 0,
+        CombinedImageSampler = 1,
+        SampledImage = 2,
+        StorageImage = 3,
+        UniformTexelBuffer = 4,
+        StorageTexelBuffer = 5,
+        UniformBuffer = 6,
+        StorageBuffer = 7,
+        InputAttachment = 10,
+        AccelerationStructure = 1000150000,
+    };
+
+    /// Values match VkShaderStageFlagBits.
+    enum ShaderStageFlags: std::uint32_t
+    {
+        kStageVertex = 0x01,
+        kStageTessellationControl = 0x02,
+        kStageTessellationEvaluation = 0x04,
+        kStageGeometry = 0x08,
+        kStageFragment = 0x10,
+        kStageCompute = 0x20,
+    };
+
+    struct BindingSlot
+    {
+        std::uint32_t m_set;
+        std::uint32_t m_binding;
+    };
+
+    struct DescriptorBindingLayout
+    {
+        std::uint32_t m_binding;
+        DescriptorType m_type;
+        /// 0 for runtime sized arrays.
+        std::uint32_t m_count;
+        std::uint32_t m_stages;
+    };
+
+    struct DescriptorSetLayout
+    {
+        std::uint32_t m_set;
+        const DescriptorBindingLayout* m_bindings;
+        std::uint32_t m_bindingCount;
+    };
+
+    struct PushConstantRange
+    {
+        std::uint32_t m_offset;
+        std::uint32_t m_size;
+        std::uint32_t m_stages;
+    };
+}
+)";
+
+        const char* GetStageFlagName(ShaderStage _stage)
+        {
+            switch (_stage)
+            {
+            case ShaderStage::Vertex:
+                return "kStageVertex";
+            case ShaderStage::Fragment:
+                return "kStageFragment";
+            case ShaderStage::Compute:
+                return "kStageCompute";
+            case ShaderStage::Geometry:
+                return "kStageGeometry";
+            case ShaderStage::TessellationControl:
+                return "kStageTessellationControl";
+            case ShaderStage::TessellationEvaluation:
+                return "kStageTessellationEvaluation";
+            }
+            return "0";
+        }
+
+        const char* GetDescriptorTypeEnumerator(DescriptorType _type)
+        {
+            switch (_type)
+            {
+            case DescriptorType::Sampler:
+                return "Sampler";
+            case DescriptorType::CombinedImageSampler:
+                return "CombinedImageSampler";
+            case DescriptorType::SampledImage:
+                return "SampledImage";
+            case DescriptorType::StorageImage:
+                return "StorageImage";
+            case DescriptorType::UniformTexelBuffer:
+                return "UniformTexelBuffer";
+            case DescriptorType::StorageTexelBuffer:
+                return "StorageTexelBuffer";
+            case DescriptorType::UniformBuffer:
+                return "UniformBuffer";
+            case DescriptorType::StorageBuffer:
+                return "StorageBuffer";
+            case DescriptorType::InputAttachment:
+                return "InputAttachment";
+            case DescriptorType::AccelerationStructure:
+                return "AccelerationStructure";
+            }
+            return "UniformBuffer";
+        }
+
+        /// Replaces everything but letters, digits and underscores, so any shader or resource name is an identifier.
+        std::string MakeIdentifier(std::string_view _name, std::string_view _fallback)
+        {
+            std::string identifier(_name.empty() ? _fallback : _name);
+            for (char& c: identifier)
+            {
+                if (!std::isalnum(static_cast<unsigned char>(c)))
+                {
+                    c = '_';
+                }
+            }
+            if (std::isdigit(static_cast<unsigned char>(identifier[0])))
+            {
+                identifier.insert(identifier.begin(), '_');
+            }
+            return identifier;
+        }
+
+        const char* GetScalarTypeName(const ShaderBlockMember& _member)
+        {
+            switch (_member.m_scalarType)
+            {
+            case ShaderScalarType::Float:
+                return _member.m_scalarWidth == 64 ? "double" : (_member.m_scalarWidth == 16 ? "std::uint16_t" : "float");
+            case ShaderScalarType::SInt:
+                return _member.m_scalarWidth == 64 ? "std::int64_t" : (_member.m_scalarWidth == 16 ? "std::int16_t" : (_member.m_scalarWidth == 8 ? "std::int8_t" : "std::int32_t"));
+            case ShaderScalarType::UInt:
+                return _member.m_scalarWidth == 64 ? "std::uint64_t" : (_member.m_scalarWidth == 16 ? "std::uint16_t" : (_member.m_scalarWidth == 8 ? "std::uint8_t" : "std::uint32_t"));
+            case ShaderScalarType::Bool:
+                return "std::uint32_t";
+            case ShaderScalarType::Opaque:
+                break;
+            }
+            return "std::uint8_t";
+        }
+
+        /// C++ member declaration reproducing the member layout, or a byte array when the layout has no plain C++ form.
+        std::string DeclareMember(const ShaderBlockMember& _member, const std::string& _name)
+        {
+            const auto bytes = [&] { return FormatString("std::uint8_t %s[%u];", _name.c_str(), _member.m_size); };
+            if (_member.m_scalarType == ShaderScalarType::Opaque)
+            {
+                return bytes();
+            }
+
+            const u32 scalarSize = _member.m_scalarType == ShaderScalarType::Bool ? 4 : _member.m_scalarWidth / 8;
+            std::string dimensions;
+            u32 elementSize = scalarSize * _member.m_componentCount;
+            if (_member.m_columnCount > 1)
+            {
+                // Padded columns (std140 `mat3`) get their padding as extra rows.
+                if (_member.m_matrixStride % scalarSize != 0 || _member.m_matrixStride < elementSize)
+                {
+                    return bytes();
+                }
+                dimensions = FormatString("[%u][%u]", _member.m_columnCount, _member.m_matrixStride / scalarSize);
+                elementSize = _member.m_columnCount * _member.m_matrixStride;
+            }
+            else if (_member.m_componentCount > 1)
+            {
+                dimensions = FormatString("[%u]", _member.m_componentCount);
+            }
+            if (_member.m_arrayCount > 0)
+            {
+                if (_member.m_arrayStride != elementSize)
+                {
+                    return bytes();
+                }
+                dimensions = FormatString("[%u]", _member.m_arrayCount) + dimensions;
+                elementSize *= _member.m_arrayCount;
+            }
+            if (elementSize != _member.m_size)
+            {
+                return bytes();
+            }
+            return FormatString("%s %s%s;", GetScalarTypeName(_member), _name.c_str(), dimensions.c_str());
+        }
+
+        bool SameLayout(std::span<const ShaderBlockMember> _a, std::span<const ShaderBlockMember> _b)
+        {
+            return std::ranges::equal(_a, _b, [](const ShaderBlockMember& _x, const ShaderBlockMember& _y)
+            {
+                return _x.m_name == _y.m_name && _x.m_offset == _y.m_offset && _x.m_size == _y.m_size && _x.m_scalarType == _y.m_scalarType;
+            });
+        }
+
+        /// Writes a generated file only if its content changed.
+        void WriteIfChanged(const std::filesystem::path& _path, std::string_view _content)
+        {
+            std::error_code error;
+            if (std::filesystem::file_size(_path, error) == _content.size() && !error)
+            {
+                const std::vector<u8> existing = FileSystem::ReadFile(_path);
+                if (std::string_view(reinterpret_cast<const char*>(existing.data()), existing.size()) == _content)
+                {
+                    return;
+                }
+            }
+            FileWriter writer(_path);
+            writer.Write(_content.data(), _content.size());
+            writer.Commit();
+        }
+    }
+
+    void WriteShaderReflectionTypes(const std::filesystem::path& _directory)
+    {
+        WriteIfChanged(_directory / kShaderReflectionTypesHeader, kTypesSource);
+    }
+
+    void WriteShaderReflectionHeader(const std::filesystem::path& _path, const ShaderDescription& _shader, std::span<const ShaderReflection> _modules)
+    {
+        const char* shaderName = _shader.m_name.c_str();
+
+        // Union of the resources of every permutation, by slot.
+        std::map<std::pair<u32, u32>, ShaderBinding> bindings;
+        std::map<std::string, std::pair<u32, u32>> slots;
+        const ShaderReflection* pushConstants = nullptr;
+        for (const ShaderReflection& module: _modules)
+        {
+            for (const ShaderBinding& binding: module.m_bindings)
+            {
+                const std::pair slot { binding.m_set, binding.m_binding };
+                const std::string name = MakeIdentifier(binding.m_name, FormatString("binding_%u_%u", binding.m_set, binding.m_binding));
+                const auto [it, inserted] = bindings.try_emplace(slot, binding);
+                it->second.m_name = name;
+                KT_VERIFY(
+                    inserted || (it->second.m_type == binding.m_type && it->second.m_count == binding.m_count),
+                    "%s: set %u binding %u changes type or size between permutations",
+                    shaderName,
+                    binding.m_set,
+                    binding.m_binding);
+                const auto [slotIt, slotInserted] = slots.try_emplace(name, slot);
+                KT_VERIFY(slotInserted || slotIt->second == slot, "%s: resource '%s' changes slot between permutations", shaderName, name.c_str());
+            }
+            if (module.m_pushConstantSize > 0)
+            {
+                KT_VERIFY(
+                    pushConstants == nullptr || SameLayout(pushConstants->m_pushConstantMembers, module.m_pushConstantMembers),
+                    "%s: the push constant layout changes between permutations",
+                    shaderName);
+                pushConstants = &module;
+            }
+        }
+
+        std::string source = FormatString("// Generated by kryne-shaderc from %s, do not edit.\n", _shader.m_source.filename().string().c_str());
+        source += FormatString("#pragma once\n\n#include \"%s\"\n\n", kShaderReflectionTypesHeader);
+        source += FormatString("namespace KryneShaders::%s\n{\n", MakeIdentifier(_shader.m_name, "shader").c_str());
+        source += FormatString("    inline constexpr std::uint32_t kStages = %s;\n", GetStageFlagName(_shader.m_stage));
+        source += FormatString("    inline constexpr const char* kEntryPoint = \"%s\";\n", _modules.empty() ? _shader.m_entryPoint.c_str() : _modules[0].m_entryPoint.c_str());
+
+        if (!bindings.empty())
+        {
+            source += "\n    namespace Bindings\n    {\n";
+            for (const auto& [slot, binding]: bindings)
+            {
+                source += FormatString("        inline constexpr BindingSlot %s { %u, %u };\n", binding.m_name.c_str(), slot.first, slot.second);
+            }
+            source += "    }\n";
+        }
+
+        std::vector<u32> sets;
+        for (const auto& [slot, binding]: bindings)
+        {
+            if (sets.empty() || sets.back() != slot.first)
+            {
+                sets.push_back(slot.first);
+                source += FormatString("\n    inline constexpr DescriptorBindingLayout kSet%uBindings[] = {\n", slot.first);
+            }
+            source += FormatString("        { %u, DescriptorType::%s, %u, kStages },\n", slot.second, GetDescriptorTypeEnumerator(binding.m_type), binding.m_count);
+            const auto next = bindings.upper_bound(slot);
+            if (next == bindings.end() || next->first.first != slot.first)
+            {
+                source += "    };\n";
+            }
+        }
+        source += FormatString("\n    inline constexpr std::uint32_t kSetLayoutCount = %zu;\n", sets.size());
+        if (!sets.empty())
+        {
+            source += "    inline constexpr DescriptorSetLayout kSetLayouts[] = {\n";
+            for (const u32 set: sets)
+            {
+                source += FormatString("        { %u, kSet%uBindings, std::uint32_t(sizeof(kSet%uBindings) / sizeof(kSet%uBindings[0])) },\n", set, set, set, set);
+            }
+            source += "    };\n";
+        }
+
+        if (pushConstants != nullptr)
+        {
+            std::string members;
+            std::string asserts;
+            u32 cursor = 0;
+            u32 paddingIndex = 0;
+            for (size_t m = 0; m < pushConstants->m_pushConstantMembers.size(); m++)
+            {
+                const ShaderBlockMember& member = pushConstants->m_pushConstantMembers[m];
+                if (member.m_offset > cursor)
+                {
+                    members += FormatString("        std::uint8_t m_padding%u[%u];\n", paddingIndex++, member.m_offset - cursor);
+                }
+                const std::string name = MakeIdentifier(member.m_name, FormatString("member%zu", m));
+                members += "        " + DeclareMember(member, name) + "\n";
+                asserts += FormatString("    static_assert(offsetof(PushConstants, %s) == %u);\n", name.c_str(), member.m_offset);
+                cursor = std::max(cursor, member.m_offset + member.m_size);
+            }
+            source += "\n";
+            if (!pushConstants->m_pushConstantName.empty())
+            {
+                source += FormatString("    /// `%s` block.\n", pushConstants->m_pushConstantName.c_str());
+            }
+            source += "    struct PushConstants\n    {\n";
+            source += members;
+            source += "    };\n";
+            source += asserts;
+            source += FormatString("    static_assert(sizeof(PushConstants) >= %u);\n", pushConstants->m_pushConstantSize);
+            source += FormatString("    inline constexpr PushConstantRange kPushConstants { 0, %u, kStages };\n", pushConstants->m_pushConstantSize);
+        }
+        source += "}\n";
+
+        WriteIfChanged(_path, source);
+    }
+}
@@ -0,0 +1,92 @@
+#include "KryneTools/Shader/ShaderWriter.hpp"
+
+#include <string>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Shader/ShaderFormat.hpp"
+
+namespace KryneTools
+{
+    void WriteShaderFile(const std::filesystem::path& _path, const CompiledShader& _shader)
+    {
+        const ShaderDescription& description = *_shader.m_description;
+        KT_VERIFY(_shader.m_permutationModules.size() == description.GetPermutationCount(), "%s: permutation count mismatch", description.m_name.c_str());
+
+        std::string strings;
+        const auto addString = [&strings](std::string_view _text)
+        {
+            const ShaderFormat::StringReference reference { u32(strings.size()), u32(_text.size()) };
+            strings += _text;
+            return reference;
+        };
+
+        ShaderFormat::Header header {};
+        header.m_magic = ShaderFormat::kMagic;
+        header.m_version = ShaderFormat::kVersion;
+        header.m_headerSize = sizeof(ShaderFormat::Header);
+        header.m_stage = u8(description.m_stage);
+        header.m_language = u8(description.m_language);
+        header.m_name = addString(description.m_name);
+        header.m_entryPoint = addString(description.m_entryPoint);
+
+        std::vector<ShaderFormat::AxisRecord> axes;
+        std::vector<ShaderFormat::StringReference> values;
+        for (const PermutationAxis& axis: description.m_axes)
+        {
+            axes.push_back({ addString(axis.m_name), u32(values.size()), u32(axis.m_values.size()) });
+            for (const std::string& value: axis.m_values)
+            {
+                values.push_back(addString(value));
+            }
+        }
+
+        header.m_axisCount = u32(axes.size());
+        header.m_valueCount = u32(values.size());
+        header.m_permutationCount = u32(_shader.m_permutationModules.size());
+        header.m_moduleCount = u32(_shader.m_modules.size());
+
+        u64 offset = sizeof(ShaderFormat::Header);
+        const auto place = [&offset](u64 _size)
+        {
+            offset = AlignUp(offset, ShaderFormat::kArrayAlignment);
+            const u64 start = offset;
+            offset += _size;
+            return u32(start);
+        };
+        header.m_axesOffset = place(axes.size() * sizeof(ShaderFormat::AxisRecord));
+        header.m_valuesOffset = place(values.size() * sizeof(ShaderFormat::StringReference));
+        header.m_permutationsOffset = place(_shader.m_permutationModules.size() * sizeof(u32));
+        header.m_modulesOffset = place(_shader.m_modules.size() * sizeof(ShaderFormat::ModuleRecord));
+        header.m_stringsOffset = place(strings.size());
+        header.m_stringsSize = u32(strings.size());
+
+        std::vector<ShaderFormat::ModuleRecord> modules;
+        for (const std::vector<u8>& module: _shader.m_modules)
+        {
+            modules.push_back({ Hash64(module), place(module.size()), u32(module.size()) });
+        }
+        KT_VERIFY(offset <= ~0u, "%s: shader file exceeds 4 GiB", description.m_name.c_str());
+        header.m_fileSize = u32(offset);
+
+        FileWriter writer(_path);
+        writer.WritePod(header);
+        const auto writeArray = [&writer](u32 _offset, const void* _data, u64 _size)
+        {
+            writer.Align(ShaderFormat::kArrayAlignment);
+            KT_VERIFY(writer.Tell() == _offset, "Shader file layout mismatch");
+            writer.Write(_data, _size);
+        };
+        writeArray(header.m_axesOffset, axes.data(), axes.size() * sizeof(ShaderFormat::AxisRecord));
+        writeArray(header.m_valuesOffset, values.data(), values.size() * sizeof(ShaderFormat::StringReference));
+        writeArray(header.m_permutationsOffset, _shader.m_permutationModules.data(), _shader.m_permutationModules.size() * sizeof(u32));
+        writeArray(header.m_modulesOffset, modules.data(), modules.size() * sizeof(ShaderFormat::ModuleRecord));
+        writeArray(header.m_stringsOffset, strings.data(), strings.size());
+        for (size_t m = 0; m < modules.size(); m++)
+        {
+            writeArray(modules[m].m_offset, _shader.m_modules[m].data(), _shader.m_modules[m].size());
+        }
+        writer.Commit();
+    }
+}
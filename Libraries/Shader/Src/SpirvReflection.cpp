@@ -0,0 +1,557 @@
+#include "KryneTools/Shader/SpirvReflection.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Subset of the SPIR-V enumerants the reflection needs, from the SPIR-V specification.
+        namespace Spv
+        {
+            constexpr u32 kMagic = 0x07230203;
+            constexpr u32 kHeaderWords = 5;
+
+            enum Op: u32
+            {
+                OpName = 5,
+                OpMemberName = 6,
+                OpEntryPoint = 15,
+                OpTypeBool = 20,
+                OpTypeInt = 21,
+                OpTypeFloat = 22,
+                OpTypeVector = 23,
+                OpTypeMatrix = 24,
+                OpTypeImage = 25,
+                OpTypeSampler = 26,
+                OpTypeSampledImage = 27,
+                OpTypeArray = 28,
+                OpTypeRuntimeArray = 29,
+                OpTypeStruct = 30,
+                OpTypePointer = 32,
+                OpConstant = 43,
+                OpSpecConstant = 50,
+                OpVariable = 59,
+                OpDecorate = 71,
+                OpMemberDecorate = 72,
+                OpTypeAccelerationStructureKHR = 5341,
+            };
+
+            enum Decoration: u32
+            {
+                Block = 2,
+                BufferBlock = 3,
+                ArrayStride = 6,
+                MatrixStride = 7,
+                BuiltIn = 11,
+                Location = 30,
+                Binding = 33,
+                DescriptorSet = 34,
+                Offset = 35,
+            };
+
+            enum StorageClass: u32
+            {
+                UniformConstant = 0,
+                Input = 1,
+                Uniform = 2,
+                PushConstant = 9,
+                StorageBuffer = 12,
+            };
+
+            enum Dim: u32
+            {
+                DimBuffer = 5,
+                DimSubpassData = 6,
+            };
+        }
+
+        struct Decorations
+        {
+            u32 m_set = 0;
+            u32 m_binding = ~0u;
+            u32 m_location = ~0u;
+            u32 m_arrayStride = 0;
+            bool m_block = false;
+            bool m_bufferBlock = false;
+            bool m_builtIn = false;
+        };
+
+        struct MemberDecorations
+        {
+            u32 m_offset = 0;
+            u32 m_matrixStride = 0;
+        };
+
+        class SpirvModule
+        {
+        public:
+            explicit SpirvModule(std::span<const u32> _words)
+                : m_words(_words)
+            {
+                KT_VERIFY(_words.size() >= Spv::kHeaderWords && _words[0] == Spv::kMagic, "Not a SPIR-V module");
+                m_definitions.resize(_words[3], 0);
+                for (size_t offset = Spv::kHeaderWords; offset < _words.size(); offset += GetWordCount(offset))
+                {
+                    const u32 wordCount = GetWordCount(offset);
+                    KT_VERIFY(wordCount > 0 && offset + wordCount <= _words.size(), "Truncated SPIR-V instruction");
+                    const std::span<const u32> operands = _words.subspan(offset + 1, wordCount - 1);
+                    switch (_words[offset] & 0xffff)
+                    {
+                    case Spv::OpName:
+                        KT_VERIFY(!operands.empty(), "Malformed OpName");
+                        m_names[operands[0]] = ReadString(operands.subspan(1));
+                        break;
+                    case Spv::OpMemberName:
+                        KT_VERIFY(operands.size() >= 2, "Malformed OpMemberName");
+                        m_memberNames[u64(operands[0]) << 32 | operands[1]] = ReadString(operands.subspan(2));
+                        break;
+                    case Spv::OpEntryPoint:
+                        if (m_entryPoint == 0)
+                        {
+                            m_entryPoint = u32(offset);
+                        }
+                        break;
+                    case Spv::OpDecorate:
+                        AddDecoration(operands);
+                        break;
+                    case Spv::OpMemberDecorate:
+                        AddMemberDecoration(operands);
+                        break;
+                    case Spv::OpTypeBool:
+                    case Spv::OpTypeInt:
+                    case Spv::OpTypeFloat:
+                    case Spv::OpTypeVector:
+                    case Spv::OpTypeMatrix:
+                    case Spv::OpTypeImage:
+                    case Spv::OpTypeSampler:
+                    case Spv::OpTypeSampledImage:
+                    case Spv::OpTypeArray:
+                    case Spv::OpTypeRuntimeArray:
+                    case Spv::OpTypeStruct:
+                    case Spv::OpTypePointer:
+                    case Spv::OpTypeAccelerationStructureKHR:
+                        Define(operands, 0, offset);
+                        break;
+                    case Spv::OpConstant:
+                    case Spv::OpSpecConstant:
+                        Define(operands, 1, offset);
+                        break;
+                    case Spv::OpVariable:
+                        Define(operands, 1, offset);
+                        m_variables.push_back(u32(offset));
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                KT_VERIFY(m_entryPoint != 0, "SPIR-V module has no entry point");
+            }
+
+            [[nodiscard]] u32 GetWordCount(size_t _offset) const { return m_words[_offset] >> 16; }
+            [[nodiscard]] u32 GetOpcode(size_t _offset) const { return m_words[_offset] & 0xffff; }
+
+            /// Operand `_index` of the instruction at `_offset`, checked against its word count.
+            [[nodiscard]] u32 GetOperand(size_t _offset, u32 _index) const
+            {
+                KT_VERIFY(_index + 1 < GetWordCount(_offset), "Malformed SPIR-V instruction %u", GetOpcode(_offset));
+                return m_words[_offset + 1 + _index];
+            }
+
+            /// Offset of the instruction defining an id.
+            [[nodiscard]] size_t GetDefinition(u32 _id) const
+            {
+                KT_VERIFY(_id < m_definitions.size() && m_definitions[_id] != 0, "Undefined SPIR-V id %u", _id);
+                return m_definitions[_id];
+            }
+
+            [[nodiscard]] const Decorations& GetDecorations(u32 _id) const
+            {
+                static const Decorations kNone;
+                const auto it = m_decorations.find(_id);
+                return it != m_decorations.end() ? it->second : kNone;
+            }
+
+            [[nodiscard]] const MemberDecorations& GetMemberDecorations(u32 _struct, u32 _member) const
+            {
+                static const MemberDecorations kNone;
+                const auto it = m_memberDecorations.find(u64(_struct) << 32 | _member);
+                return it != m_memberDecorations.end() ? it->second : kNone;
+            }
+
+            [[nodiscard]] std::string GetName(u32 _id) const
+            {
+                const auto it = m_names.find(_id);
+                return it != m_names.end() ? it->second : std::string();
+            }
+
+            [[nodiscard]] std::string GetMemberName(u32 _struct, u32 _member) const
+            {
+                const auto it = m_memberNames.find(u64(_struct) << 32 | _member);
+                return it != m_memberNames.end() ? it->second : std::string();
+            }
+
+            /// Layout of the members of an explicitly laid out structure.
+            [[nodiscard]] std::vector<ShaderBlockMember> GetMembers(u32 _struct) const
+            {
+                const size_t definition = GetDefinition(_struct);
+                std::vector<ShaderBlockMember> members;
+                for (u32 m = 0; m + 2 < GetWordCount(definition); m++)
+                {
+                    const MemberDecorations& decorations = GetMemberDecorations(_struct, m);
+                    u32 type = GetOperand(definition, m + 1);
+
+                    ShaderBlockMember member;
+                    member.m_name = GetMemberName(_struct, m);
+                    member.m_offset = decorations.m_offset;
+                    member.m_size = GetSize(type, decorations.m_matrixStride);
+                    member.m_matrixStride = decorations.m_matrixStride;
+                    if (GetOpcode(GetDefinition(type)) == Spv::OpTypeArray)
+                    {
+                        member.m_arrayCount = GetConstant(GetOperand(GetDefinition(type), 2));
+                        member.m_arrayStride = GetDecorations(type).m_arrayStride;
+                        type = GetOperand(GetDefinition(type), 1);
+                    }
+
+                    size_t element = GetDefinition(type);
+                    if (GetOpcode(element) == Spv::OpTypeMatrix)
+                    {
+                        member.m_columnCount = GetOperand(element, 2);
+                        element = GetDefinition(GetOperand(element, 1));
+                    }
+                    if (GetOpcode(element) == Spv::OpTypeVector)
+                    {
+                        member.m_componentCount = GetOperand(element, 2);
+                        element = GetDefinition(GetOperand(element, 1));
+                    }
+                    switch (GetOpcode(element))
+                    {
+                    case Spv::OpTypeFloat:
+                        member.m_scalarType = ShaderScalarType::Float;
+                        member.m_scalarWidth = GetOperand(element, 1);
+                        break;
+                    case Spv::OpTypeInt:
+                        member.m_scalarType = GetOperand(element, 2) != 0 ? ShaderScalarType::SInt : ShaderScalarType::UInt;
+                        member.m_scalarWidth = GetOperand(element, 1);
+                        break;
+                    case Spv::OpTypeBool:
+                        member.m_scalarType = ShaderScalarType::Bool;
+                        break;
+                    default:
+                        member = { member.m_name, member.m_offset, member.m_size, ShaderScalarType::Opaque };
+                        break;
+                    }
+                    members.push_back(std::move(member));
+                }
+                std::ranges::sort(members, {}, &ShaderBlockMember::m_offset);
+                return members;
+            }
+
+            /// Byte extent of a type in an explicitly laid out block.
+            [[nodiscard]] u32 GetSize(u32 _type, u32 _matrixStride = 0) const
+            {
+                const size_t definition = GetDefinition(_type);
+                switch (GetOpcode(definition))
+                {
+                case Spv::OpTypeBool:
+                    return 4;
+                case Spv::OpTypeInt:
+                case Spv::OpTypeFloat:
+                    return GetOperand(definition, 1) / 8;
+                case Spv::OpTypeVector:
+                    return GetOperand(definition, 2) * GetSize(GetOperand(definition, 1));
+                case Spv::OpTypeMatrix:
+                    return GetOperand(definition, 2) * (_matrixStride != 0 ? _matrixStride : GetSize(GetOperand(definition, 1)));
+                case Spv::OpTypeArray:
+                    return GetConstant(GetOperand(definition, 2)) * GetDecorations(_type).m_arrayStride;
+                case Spv::OpTypeRuntimeArray:
+                    return 0;
+                case Spv::OpTypeStruct:
+                {
+                    u32 size = 0;
+                    for (u32 m = 0; m + 2 < GetWordCount(definition); m++)
+                    {
+                        const MemberDecorations& member = GetMemberDecorations(_type, m);
+                        size = std::max(size, member.m_offset + GetSize(GetOperand(definition, m + 1), member.m_matrixStride));
+                    }
+                    return size;
+                }
+                default:
+                    ThrowError("Unexpected SPIR-V type in a block (opcode %u)", GetOpcode(definition));
+                }
+            }
+
+            [[nodiscard]] u32 GetConstant(u32 _id) const
+            {
+                const size_t definition = GetDefinition(_id);
+                KT_VERIFY(GetOpcode(definition) == Spv::OpConstant || GetOpcode(definition) == Spv::OpSpecConstant, "Array length is not a constant");
+                return GetOperand(definition, 2);
+            }
+
+            [[nodiscard]] u32 GetEntryPointOffset() const { return m_entryPoint; }
+            [[nodiscard]] std::span<const u32> GetVariables() const { return m_variables; }
+            [[nodiscard]] std::span<const u32> GetWords() const { return m_words; }
+
+            static std::string ReadString(std::span<const u32> _words)
+            {
+                std::string text;
+                for (const u32 word: _words)
+                {
+                    for (u32 shift = 0; shift < 32; shift += 8)
+                    {
+                        const char c = char((word >> shift) & 0xff);
+                        if (c == 0)
+                        {
+                            return text;
+                        }
+                        text += c;
+                    }
+                }
+                return text;
+            }
+
+        private:
+            std::span<const u32> m_words;
+            std::vector<u32> m_definitions;
+            std::vector<u32> m_variables;
+            std::unordered_map<u32, std::string> m_names;
+            std::unordered_map<u64, std::string> m_memberNames;
+            std::unordered_map<u32, Decorations> m_decorations;
+            std::unordered_map<u64, MemberDecorations> m_memberDecorations;
+            u32 m_entryPoint = 0;
+
+            void Define(std::span<const u32> _operands, u32 _resultIndex, size_t _offset)
+            {
+                KT_VERIFY(_resultIndex < _operands.size(), "Malformed SPIR-V instruction");
+                const u32 id = _operands[_resultIndex];
+                KT_VERIFY(id < m_definitions.size(), "SPIR-V id %u out of bounds", id);
+                m_definitions[id] = u32(_offset);
+            }
+
+            void AddDecoration(std::span<const u32> _operands)
+            {
+                KT_VERIFY(_operands.size() >= 2, "Malformed OpDecorate");
+                Decorations& decorations = m_decorations[_operands[0]];
+                const u32 value = _operands.size() > 2 ? _operands[2] : 0;
+                switch (_operands[1])
+                {
+                case Spv::Block:
+                    decorations.m_block = true;
+                    break;
+                case Spv::BufferBlock:
+                    decorations.m_bufferBlock = true;
+                    break;
+                case Spv::ArrayStride:
+                    decorations.m_arrayStride = value;
+                    break;
+                case Spv::BuiltIn:
+                    decorations.m_builtIn = true;
+                    break;
+                case Spv::Location:
+                    decorations.m_location = value;
+                    break;
+                case Spv::Binding:
+                    decorations.m_binding = value;
+                    break;
+                case Spv::DescriptorSet:
+                    decorations.m_set = value;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            void AddMemberDecoration(std::span<const u32> _operands)
+            {
+                KT_VERIFY(_operands.size() >= 3, "Malformed OpMemberDecorate");
+                const u32 value = _operands.size() > 3 ? _operands[3] : 0;
+                if (_operands[2] == Spv::BuiltIn)
+                {
+                    // Built-in blocks such as gl_PerVertex are not part of the resource interface.
+                    m_decorations[_operands[0]].m_builtIn = true;
+                    return;
+                }
+                MemberDecorations& decorations = m_memberDecorations[u64(_operands[0]) << 32 | _operands[1]];
+                if (_operands[2] == Spv::Offset)
+                {
+                    decorations.m_offset = value;
+                }
+                else if (_operands[2] == Spv::MatrixStride)
+                {
+                    decorations.m_matrixStride = value;
+                }
+            }
+        };
+
+        std::optional<ShaderStage> GetExecutionModelStage(u32 _model)
+        {
+            switch (_model)
+            {
+            case 0:
+                return ShaderStage::Vertex;
+            case 1:
+                return ShaderStage::TessellationControl;
+            case 2:
+                return ShaderStage::TessellationEvaluation;
+            case 3:
+                return ShaderStage::Geometry;
+            case 4:
+                return ShaderStage::Fragment;
+            case 5:
+                return ShaderStage::Compute;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        std::optional<DescriptorType> GetUniformConstantType(const SpirvModule& _module, u32 _type)
+        {
+            const size_t definition = _module.GetDefinition(_type);
+            switch (_module.GetOpcode(definition))
+            {
+            case Spv::OpTypeSampler:
+                return DescriptorType::Sampler;
+            case Spv::OpTypeSampledImage:
+                return DescriptorType::CombinedImageSampler;
+            case Spv::OpTypeAccelerationStructureKHR:
+                return DescriptorType::AccelerationStructure;
+            case Spv::OpTypeImage:
+            {
+                const u32 dim = _module.GetOperand(definition, 2);
+                const bool sampled = _module.GetOperand(definition, 6) == 1;
+                if (dim == Spv::DimSubpassData)
+                {
+                    return DescriptorType::InputAttachment;
+                }
+                if (dim == Spv::DimBuffer)
+                {
+                    return sampled ? DescriptorType::UniformTexelBuffer : DescriptorType::StorageTexelBuffer;
+                }
+                return sampled ? DescriptorType::SampledImage : DescriptorType::StorageImage;
+            }
+            default:
+                return std::nullopt;
+            }
+        }
+    }
+
+    const char* GetDescriptorTypeName(DescriptorType _type)
+    {
+        switch (_type)
+        {
+        case DescriptorType::Sampler:
+            return "sampler";
+        case DescriptorType::CombinedImageSampler:
+            return "combined_image_sampler";
+        case DescriptorType::SampledImage:
+            return "sampled_image";
+        case DescriptorType::StorageImage:
+            return "storage_image";
+        case DescriptorType::UniformTexelBuffer:
+            return "uniform_texel_buffer";
+        case DescriptorType::StorageTexelBuffer:
+            return "storage_texel_buffer";
+        case DescriptorType::UniformBuffer:
+            return "uniform_buffer";
+        case DescriptorType::StorageBuffer:
+            return "storage_buffer";
+        case DescriptorType::InputAttachment:
+            return "input_attachment";
+        case DescriptorType::AccelerationStructure:
+            return "acceleration_structure";
+        }
+        return "unknown";
+    }
+
+    ShaderReflection ReflectSpirv(std::span<const u32> _words)
+    {
+        KT_TRACE_ZONE("ReflectSpirv");
+        const SpirvModule module(_words);
+        ShaderReflection reflection;
+
+        const size_t entryPoint = module.GetEntryPointOffset();
+        const std::optional<ShaderStage> stage = GetExecutionModelStage(module.GetOperand(entryPoint, 0));
+        KT_VERIFY(stage.has_value(), "Unsupported SPIR-V execution model %u", module.GetOperand(entryPoint, 0));
+        reflection.m_stage = *stage;
+        reflection.m_entryPoint = SpirvModule::ReadString(_words.subspan(entryPoint + 3, module.GetWordCount(entryPoint) - 3));
+
+        for (const u32 variable: module.GetVariables())
+        {
+            const u32 id = module.GetOperand(variable, 1);
+            const u32 storageClass = module.GetOperand(variable, 2);
+            const Decorations& decorations = module.GetDecorations(id);
+            const size_t pointer = module.GetDefinition(module.GetOperand(variable, 0));
+            KT_VERIFY(module.GetOpcode(pointer) == Spv::OpTypePointer, "SPIR-V variable %u is not a pointer", id);
+            u32 type = module.GetOperand(pointer, 2);
+
+            if (storageClass == Spv::Input)
+            {
+                if (reflection.m_stage == ShaderStage::Vertex && !decorations.m_builtIn && !module.GetDecorations(type).m_builtIn && decorations.m_location != ~0u)
+                {
+                    reflection.m_inputs.push_back({ module.GetName(id), decorations.m_location });
+                }
+                continue;
+            }
+            if (storageClass == Spv::PushConstant)
+            {
+                reflection.m_pushConstantSize = module.GetSize(type);
+                reflection.m_pushConstantName = module.GetName(type);
+                reflection.m_pushConstantMembers = module.GetMembers(type);
+                continue;
+            }
+            if (storageClass != Spv::UniformConstant && storageClass != Spv::Uniform && storageClass != Spv::StorageBuffer)
+            {
+                continue;
+            }
+
+            ShaderBinding binding;
+            binding.m_set = decorations.m_set;
+            binding.m_binding = decorations.m_binding;
+            KT_VERIFY(binding.m_binding != ~0u, "SPIR-V resource %u has no binding", id);
+            for (size_t definition = module.GetDefinition(type);; definition = module.GetDefinition(type))
+            {
+                if (module.GetOpcode(definition) == Spv::OpTypeArray)
+                {
+                    binding.m_count *= module.GetConstant(module.GetOperand(definition, 2));
+                }
+                else if (module.GetOpcode(definition) == Spv::OpTypeRuntimeArray)
+                {
+                    binding.m_count = 0;
+                }
+                else
+                {
+                    break;
+                }
+                type = module.GetOperand(definition, 1);
+            }
+
+            const Decorations& typeDecorations = module.GetDecorations(type);
+            if (storageClass == Spv::UniformConstant)
+            {
+                const std::optional<DescriptorType> descriptorType = GetUniformConstantType(module, type);
+                KT_VERIFY(descriptorType.has_value(), "Unsupported SPIR-V resource type for variable %u", id);
+                binding.m_type = *descriptorType;
+            }
+            else
+            {
+                binding.m_type = storageClass == Spv::StorageBuffer || typeDecorations.m_bufferBlock ? DescriptorType::StorageBuffer : DescriptorType::UniformBuffer;
+                binding.m_blockSize = module.GetSize(type);
+            }
+            binding.m_name = module.GetName(id);
+            if (binding.m_name.empty())
+            {
+                binding.m_name = module.GetName(type);
+            }
+            reflection.m_bindings.push_back(std::move(binding));
+        }
+
+        std::ranges::sort(reflection.m_bindings, {}, [](const ShaderBinding& _binding) { return std::pair(_binding.m_set, _binding.m_binding); });
+        std::ranges::sort(reflection.m_inputs, {}, &ShaderInput::m_location);
+        return reflection;
+    }
+}
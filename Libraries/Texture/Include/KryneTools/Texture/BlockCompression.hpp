@@ -0,0 +1,72 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    /// Block compressed formats of the runtime, all on 4x4 texel blocks.
+    enum class TextureFormat: u8
+    {
+        /// RGB, 1 bit alpha unused. 8 bytes per block.
+        Bc1,
+        /// BC1 color with a BC4 alpha block. 16 bytes per block.
+        Bc3,
+        /// Single channel (R). 8 bytes per block.
+        Bc4,
+        /// Two channels (RG), mostly for normal maps. 16 bytes per block.
+        Bc5,
+        /// High quality RGB(A). 16 bytes per block.
+        Bc7,
+        /// RGB(A) for mobile GPUs. 16 bytes per block.
+        Astc4x4,
+    };
+
+    enum class EncodeQuality: u8
+    {
+        /// Single endpoint fit with few refinement steps, for iteration builds.
+        Fast,
+        /// Searches more modes, partitions and endpoints, for shipping builds.
+        High,
+    };
+
+    inline constexpr u32 kBlockDimension = 4;
+    /// A block of RGBA8 texels, rows top to bottom.
+    inline constexpr u32 kBlockPixelBytes = kBlockDimension * kBlockDimension * 4;
+
+    [[nodiscard]] const char* GetTextureFormatName(TextureFormat _format);
+    [[nodiscard]] std::optional<TextureFormat> ParseTextureFormat(std::string_view _name);
+
+    [[nodiscard]] constexpr u32 GetBlockSize(TextureFormat _format)
+    {
+        return _format == TextureFormat::Bc1 || _format == TextureFormat::Bc4 ? 8 : 16;
+    }
+
+    /// The format stores color, as opposed to data channels (BC4 and BC5), so it has sRGB variants.
+    [[nodiscard]] constexpr bool IsColorFormat(TextureFormat _format)
+    {
+        return _format != TextureFormat::Bc4 && _format != TextureFormat::Bc5;
+    }
+
+    /**
+     * @brief Encodes one block of 16 RGBA8 texels.
+     *
+     * @details
+     * BC7 uses modes 6 (every block) and 1 (opaque blocks, high quality only). ASTC uses single partition blocks with
+     * a full 4x4 weight grid, the endpoint and weight precisions being searched in high quality.
+     *
+     * Encoders are deterministic and thread safe.
+     */
+    void EncodeBlock(TextureFormat _format, EncodeQuality _quality, const u8* _pixels, u8* _output);
+
+    /**
+     * @brief Decodes one block to 16 RGBA8 texels.
+     *
+     * @details
+     * Only covers the block modes `EncodeBlock()` emits, which is enough to measure the encoding error. Channels a
+     * format does not store decode as 0 (missing G and B) and 255 (missing alpha).
+     */
+    void DecodeBlock(TextureFormat _format, const u8* _block, u8* _pixels);
+}
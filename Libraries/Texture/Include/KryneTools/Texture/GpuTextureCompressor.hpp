@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "KryneTools/Texture/TextureCompressor.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Vulkan compute path of the texture cooker: mip generation and fast BC1, BC3, BC4, BC5 and BC7 encoding.
+     *
+     * @details
+     * The texels of the whole chain stay on the device, only the source level goes up and the blocks come back. The
+     * shaders port the CPU box filter and fast encoders, which remain the reference: the GPU blocks are close to them
+     * but not bit identical, float precision differing, so GPU cooks are meant for iteration builds.
+     *
+     * Cooks are serialized on the device, which bounds its memory to one texture. `Cook()` is thread safe.
+     */
+    class GpuTextureCompressor
+    {
+    public:
+        /**
+         * Opens `_device` in the Vulkan physical device enumeration, or the first discrete then integrated GPU.
+         * Software devices are only used when asked for by index. Throws an `Error` when there is no device, or when
+         * the tools are built without Vulkan.
+         */
+        [[nodiscard]] static std::unique_ptr<GpuTextureCompressor> Create(std::optional<u32> _device = {});
+
+        ~GpuTextureCompressor();
+
+        GpuTextureCompressor(const GpuTextureCompressor&) = delete;
+        GpuTextureCompressor& operator=(const GpuTextureCompressor&) = delete;
+
+        [[nodiscard]] const std::string& GetDeviceName() const;
+        /// Identifies the device and driver, for cache keys: GPU blocks differ from the CPU ones and across drivers.
+        [[nodiscard]] const std::string& GetDeviceKey() const;
+
+        /// Formats and quality the shaders cover, others go to the CPU.
+        [[nodiscard]] static bool Supports(TextureFormat _format, EncodeQuality _quality);
+
+        /**
+         * @brief Generates the mips of `_image`, unless `_generateMips` is false, and compresses them.
+         * @details Returns nothing when the chain does not fit a storage buffer of the device, for the CPU to cook it.
+         * Throws an `Error` on device errors. `_settings.m_computeStatistics` is ignored.
+         */
+        [[nodiscard]] std::optional<CompressedTexture> Cook(const Image& _image, bool _generateMips, const MipSettings& _mipSettings, const CompressionSettings& _settings);
+
+    private:
+        struct Device;
+
+        explicit GpuTextureCompressor(std::unique_ptr<Device> _device);
+
+        std::unique_ptr<Device> m_device;
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    /// 8 bits per channel RGBA image, rows top to bottom.
+    struct Image
+    {
+        u32 m_width = 0;
+        u32 m_height = 0;
+        std::vector<u8> m_pixels;
+
+        void Allocate(u32 _width, u32 _height)
+        {
+            m_width = _width;
+            m_height = _height;
+            m_pixels.assign(u64(_width) * _height * 4, 0);
+        }
+
+        [[nodiscard]] u8* GetPixel(u32 _x, u32 _y) { return m_pixels.data() + (u64(_y) * m_width + _x) * 4; }
+        [[nodiscard]] const u8* GetPixel(u32 _x, u32 _y) const { return m_pixels.data() + (u64(_y) * m_width + _x) * 4; }
+    };
+
+    /**
+     * @brief Loads an image as RGBA8, missing channels are expanded (grey to RGB, alpha to opaque).
+     *
+     * @details
+     * Supports TGA (true color and grey, raw or RLE), binary PPM/PGM, and 8 or 16 bits PNG when the tools are built
+     * with libpng. Throws an `Error` on anything else.
+     */
+    [[nodiscard]] Image LoadImage(const std::filesystem::path& _path);
+
+    /// Dimensions of an image read from its header only, for estimates. False if it is not an image `LoadImage()` reads.
+    [[nodiscard]] bool ReadImageSize(const std::filesystem::path& _path, u32& _width, u32& _height);
+
+    struct MipSettings
+    {
+        /// Filters in linear space, color channels being sRGB encoded. Alpha is always linear.
+        bool m_srgb = true;
+        /// Renormalizes the RGB of every texel as a tangent space normal, after filtering.
+        bool m_normalMap = false;
+    };
+
+    /**
+     * @brief Generates the full mip chain of `_image`, level 0 included, down to 1x1.
+     *
+     * @details
+     * Each level is averaged from the previous one with a box filter, weighting source texels by their coverage so odd
+     * sizes are handled exactly. Rows of each level are split across jobs.
+     */
+    [[nodiscard]] std::vector<Image> GenerateMips(JobSystem& _jobSystem, Image _image, const MipSettings& _settings = {});
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <bit>
+
+#include "KryneTools/Texture/Image.hpp"
+#include "KryneTools/Texture/TextureCompressor.hpp"
+
+namespace KryneTools
+{
+    /**
+     * @brief Perceptual signature of an image, equal for images that look the same whatever their size or encoding.
+     *
+     * @details
+     * The hash is a pHash: the luma is averaged down to 32x32, and each of its 8x8 lowest DCT frequencies but the DC
+     * term sets one bit when above their median. Re-exports, resizes and recompressions of an image land within a few bits of each
+     * other. The average color tells apart flat or tinted variants, which the hash alone sees as equal.
+     */
+    struct PerceptualSignature
+    {
+        u64 m_hash = 0;
+        /// Average RGBA.
+        std::array<u8, 4> m_average {};
+    };
+
+    [[nodiscard]] PerceptualSignature ComputePerceptualSignature(const Image& _image);
+
+    /// Of the smallest mip of at least 32x32 texels (or the top one), decoded from its blocks.
+    [[nodiscard]] PerceptualSignature ComputePerceptualSignature(const CompressedTexture& _texture);
+
+    [[nodiscard]] inline u32 GetPerceptualDistance(const PerceptualSignature& _a, const PerceptualSignature& _b)
+    {
+        return u32(std::popcount(_a.m_hash ^ _b.m_hash));
+    }
+
+    /**
+     * @brief Whether two signatures are within `_maxDistance` hash bits, and their average colors within
+     * `_maxAverageDifference` on every channel.
+     */
+    [[nodiscard]] bool IsNearDuplicate(const PerceptualSignature& _a, const PerceptualSignature& _b, u32 _maxDistance, u32 _maxAverageDifference = 8);
+}
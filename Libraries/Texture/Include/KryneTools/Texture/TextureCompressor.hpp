@@ -0,0 +1,64 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "KryneTools/Texture/BlockCompression.hpp"
+#include "KryneTools/Texture/Image.hpp"
+
+namespace KryneTools
+{
+    class JobSystem;
+
+    struct CompressedMip
+    {
+        u32 m_width = 0;
+        u32 m_height = 0;
+        /// Byte range of the mip blocks in `CompressedTexture::m_data`, rows of blocks top to bottom.
+        u64 m_offset = 0;
+        u64 m_size = 0;
+        /// Peak signal to noise ratio of the decoded mip against its source, over the stored channels, in dB. Only set
+        /// when statistics were requested, infinite for lossless mips.
+        f64 m_psnr = 0.0;
+    };
+
+    struct CompressedTexture
+    {
+        TextureFormat m_format = TextureFormat::Bc7;
+        bool m_srgb = false;
+        u32 m_width = 0;
+        u32 m_height = 0;
+        /// Largest first.
+        std::vector<CompressedMip> m_mips;
+        std::vector<u8> m_data;
+    };
+
+    struct CompressionSettings
+    {
+        TextureFormat m_format = TextureFormat::Bc7;
+        EncodeQuality m_quality = EncodeQuality::Fast;
+        /// Only tags the output, encoders fit the sRGB values directly. Ignored by the data formats (BC4 and BC5).
+        bool m_srgb = true;
+        /// Decodes every block back to measure `CompressedMip::m_psnr`.
+        bool m_computeStatistics = false;
+    };
+
+    /**
+     * @brief Block compresses every mip of a chain.
+     *
+     * @details
+     * Mips are cut in tiles of 64x64 texels, and every tile of every mip goes in one flat job range, so small mips do
+     * not serialize behind large ones and the encoder keeps all workers busy down to the last tiles. Tiles write their
+     * blocks straight to their final location, with no merge step.
+     *
+     * Blocks overhanging the right or bottom edge of a mip repeat its last column and row.
+     */
+    [[nodiscard]] CompressedTexture CompressTexture(JobSystem& _jobSystem, std::span<const Image> _mips, const CompressionSettings& _settings);
+
+    /**
+     * @brief Sets `CompressedMip::m_psnr` of every mip of `_texture` against `_mips`, the chain it was compressed from.
+     * @details Decodes the blocks back as `CompressionSettings::m_computeStatistics` does, for textures compressed
+     * elsewhere, e.g. on the GPU. `_mips` must match the mip count and sizes of the texture.
+     */
+    void MeasureCompressionError(JobSystem& _jobSystem, std::span<const Image> _mips, CompressedTexture& _texture);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+
+#include "KryneTools/Texture/TextureCompressor.hpp"
+#include "KryneTools/Texture/TextureWriter.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+    class GpuTextureCompressor;
+    struct TextureCookSettings;
+
+    /// Cooks a texture elsewhere, e.g. on a remote worker, writing `_output`. Returns false to cook it locally.
+    using TextureCookFunction = std::function<bool(const TextureCookSettings& _settings, const std::filesystem::path& _output)>;
+
+    struct TextureCookSettings
+    {
+        std::filesystem::path m_input;
+        /// Defaults to the directory of the input when empty.
+        std::filesystem::path m_outputDirectory;
+        TextureFormat m_format = TextureFormat::Bc7;
+        EncodeQuality m_quality = EncodeQuality::Fast;
+        TextureContainer m_container = TextureContainer::Ktex;
+        /// Color data is sRGB encoded: mips are filtered in linear space and the output is tagged sRGB.
+        bool m_srgb = true;
+        /// Renormalizes mips as tangent space normals, and filters them as linear data.
+        bool m_normalMap = false;
+        bool m_generateMips = true;
+        /// Measures the PSNR of every mip, see `CompressionSettings::m_computeStatistics`.
+        bool m_computeStatistics = false;
+        /// Optional, cooks the formats it supports when no statistics are requested. Textures it cannot take, and GPU
+        /// errors, fall back to the CPU.
+        GpuTextureCompressor* m_gpu = nullptr;
+        /// Optional artifact cache, looked up before cooking and filled after.
+        ContentCache* m_cache = nullptr;
+        /// Optional, tried on cache misses before cooking locally. Its outputs are cached as CPU cooked ones.
+        TextureCookFunction m_remoteCook;
+    };
+
+    struct TextureCookResult
+    {
+        std::filesystem::path m_output;
+        u32 m_width = 0;
+        u32 m_height = 0;
+        /// Compressed mips, with their PSNR when statistics were requested. Empty on cache hits and remote cooks.
+        std::vector<CompressedMip> m_mips;
+        /// The output was restored from the cache.
+        bool m_cacheHit = false;
+        /// The output was cooked by `TextureCookSettings::m_remoteCook`.
+        bool m_remote = false;
+    };
+
+    /**
+     * @brief Cooks an image to a block compressed `.ktex` or `.dds` texture, named after the input.
+     *
+     * @details
+     * Loads the image, generates its mips with `GenerateMips()` and compresses them with `CompressTexture()`, both
+     * spread on the job system, or on `TextureCookSettings::m_gpu`. With a cache, the key covers the content of the
+     * image, the settings, the tools build ID and the GPU device and driver when the output was cooked on the GPU. CPU
+     * fallbacks and remote cooks are stored under the CPU key.
+     */
+    TextureCookResult CookTexture(JobSystem& _jobSystem, const TextureCookSettings& _settings);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "KryneTools/Common/Types.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine runtime texture files (`.ktex`), laid out for partial and asynchronous loading.
+ *
+ * A file starts with its prologue: the header, the `MipEntry` table (indexed by level, largest first) and the resident
+ * mips, the smallest ones whose blocks fit in less than `Header::m_mipAlignment` bytes each. A loader reads the first
+ * `Header::m_prologueSize` bytes in one go and can create the texture with its low mips right away.
+ *
+ * The streamed mips follow, smallest first, each at a `Header::m_mipAlignment` aligned offset and padded up to the next
+ * one, so every level is a single aligned read (suitable for unbuffered I/O) of `AlignUp(m_size, m_mipAlignment)`
+ * bytes, and levels can be read in the order they are needed.
+ *
+ * Mip blocks are rows of blocks, top to bottom. All values are little-endian.
+ */
+namespace KryneTools::TextureFileFormat
+{
+    constexpr u32 kMagic = MakeFourCC('K', 'T', 'E', 'X');
+    constexpr u16 kVersion = 1;
+    constexpr u32 kDefaultMipAlignment = 4096;
+    /// Alignment of the resident mips inside the prologue.
+    constexpr u64 kResidentMipAlignment = 16;
+
+    enum class BlockFormat: u8
+    {
+        Bc1 = 0,
+        Bc3 = 1,
+        Bc4 = 2,
+        Bc5 = 3,
+        Bc7 = 4,
+        Astc4x4 = 5,
+    };
+
+    enum Flags: u8
+    {
+        kFlagSrgb = 1 << 0,
+        /// Tangent space normal map, in the RG channels for BC5 or RGB otherwise.
+        kFlagNormalMap = 1 << 1,
+    };
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u32 m_width;
+        u32 m_height;
+        BlockFormat m_format;
+        u8 m_flags;
+        u8 m_mipCount;
+        /// Smallest mips stored in the prologue. They are the last entries of the mip table.
+        u8 m_residentMipCount;
+        u32 m_mipAlignment;
+        /// Header, mip table and resident mips, padded to `m_mipAlignment`.
+        u32 m_prologueSize;
+        u32 m_reserved;
+        u64 m_fileSize;
+    };
+    static_assert(sizeof(Header) == 40);
+
+    struct MipEntry
+    {
+        u32 m_width;
+        u32 m_height;
+        /// Absolute file offset, `m_mipAlignment` aligned for streamed mips.
+        u64 m_offset;
+        u64 m_size;
+    };
+    static_assert(sizeof(MipEntry) == 24);
+}
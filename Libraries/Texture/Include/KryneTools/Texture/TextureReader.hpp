@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+
+#include "KryneTools/Texture/TextureCompressor.hpp"
+
+namespace KryneTools
+{
+    struct KtexInfo
+    {
+        CompressedTexture m_texture;
+        bool m_normalMap = false;
+        /// Bytes a runtime loader reads before its first frame, see `TextureFileFormat::Header::m_prologueSize`.
+        u64 m_prologueSize = 0;
+        u64 m_fileSize = 0;
+    };
+
+    /**
+     * @brief Reads a whole `.ktex` file back, for inspection and the tools consuming cooked textures.
+     *
+     * @details
+     * Mips are gathered largest first in `CompressedTexture::m_data`, like `CompressTexture()` outputs them. Throws an
+     * `Error` on malformed files.
+     */
+    [[nodiscard]] KtexInfo ReadKtex(const std::filesystem::path& _path);
+}
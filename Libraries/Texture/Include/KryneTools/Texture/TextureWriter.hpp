@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include "KryneTools/Common/Types.hpp"
+
+namespace KryneTools
+{
+    struct CompressedTexture;
+
+    enum class TextureContainer: u8
+    {
+        /// Streaming friendly runtime format, see `TextureFileFormat`.
+        Ktex,
+        Dds,
+    };
+
+    /// File extension of the container, with the leading dot.
+    [[nodiscard]] const char* GetTextureContainerExtension(TextureContainer _container);
+    [[nodiscard]] std::optional<TextureContainer> ParseTextureContainer(std::string_view _name);
+
+    struct KtexWriteSettings
+    {
+        bool m_normalMap = false;
+        /// Alignment of the streamed mips, a power of two of at least 16.
+        u32 m_mipAlignment = 4096;
+    };
+
+    /// Writes a compressed texture as a `.ktex` file, see `TextureFileFormat` for the layout.
+    void WriteKtex(const std::filesystem::path& _path, const CompressedTexture& _texture, const KtexWriteSettings& _settings = {});
+
+    /**
+     * @brief Writes a compressed texture as a DDS file, with the DX10 extended header so every format keeps its sRGB
+     * variant. ASTC uses the Windows 8 era DXGI values, which only some loaders understand.
+     */
+    void WriteDds(const std::filesystem::path& _path, const CompressedTexture& _texture);
+}
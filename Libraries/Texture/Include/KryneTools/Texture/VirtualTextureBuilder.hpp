@@ -0,0 +1,67 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "KryneTools/Texture/TextureCompressor.hpp"
+#include "KryneTools/Texture/VirtualTextureFileFormat.hpp"
+
+namespace KryneTools
+{
+    class ContentCache;
+
+    struct VirtualTextureLayer
+    {
+        std::filesystem::path m_input;
+        TextureFormat m_format = TextureFormat::Bc7;
+        /// Color data is sRGB encoded, see `TextureCookSettings::m_srgb`.
+        bool m_srgb = true;
+        bool m_normalMap = false;
+    };
+
+    struct VirtualTextureSettings
+    {
+        /// Inputs of the same size, paged together: a page holds the same texels of every layer.
+        std::vector<VirtualTextureLayer> m_layers;
+        /// Defaults to the first input with the `.kvt` extension.
+        std::filesystem::path m_output;
+        /// Texels of a page side without borders, a power of two of at least 4.
+        u32 m_pageSize = 128;
+        /// Texels on each side of a page, at most half the page and keeping bordered pages a multiple of 4 texels.
+        u32 m_border = 4;
+        VirtualTextureFileFormat::AddressMode m_addressMode = VirtualTextureFileFormat::AddressMode::Clamp;
+        EncodeQuality m_quality = EncodeQuality::Fast;
+        /// Alignment of the physical pages, a power of two of at least 16.
+        u32 m_pageAlignment = 4096;
+        /// Optional artifact cache, looked up before loading the layers and filled after.
+        ContentCache* m_cache = nullptr;
+    };
+
+    struct VirtualTextureResult
+    {
+        std::filesystem::path m_output;
+        u32 m_width = 0;
+        u32 m_height = 0;
+        u32 m_mipCount = 0;
+        /// Pages covering every mip.
+        u64 m_pageCount = 0;
+        /// Pages stored, identical pages being shared.
+        u32 m_physicalPageCount = 0;
+        u64 m_size = 0;
+        /// The page file was restored from the cache, its statistics read back from its header.
+        bool m_cacheHit = false;
+    };
+
+    /**
+     * @brief Cuts images in bordered, block compressed pages, written as a `.kvt` page file.
+     *
+     * @details
+     * Layers are loaded and their mips generated with `GenerateMips()`. Then every page of a mip is compressed as a
+     * job, its borders read from the neighbouring texels of the same mip. Identical pages, such as uniform areas of a
+     * terrain, are detected by hash and stored once. See `VirtualTextureFileFormat` for the layout.
+     *
+     * With a cache, the key covers the content of every layer, the settings and the tools build ID, so unchanged
+     * sources skip their mips and page compression entirely.
+     */
+    VirtualTextureResult BuildVirtualTexture(JobSystem& _jobSystem, const VirtualTextureSettings& _settings);
+}
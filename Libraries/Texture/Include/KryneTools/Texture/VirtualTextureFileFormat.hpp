@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+
+#include "KryneTools/Texture/TextureFileFormat.hpp"
+
+/**
+ * @file
+ * Binary layout of the engine virtual texture page files (`.kvt`), for textures too large to be resident.
+ *
+ * Every mip is cut in pages of `Header::m_pageSize` texels, each stored with a border of `Header::m_border` texels
+ * copied from its neighbours (or clamped or wrapped at the texture edges), so a runtime placing pages anywhere in a
+ * physical atlas still filters across page seams. Mips go down to the first one fitting a single page.
+ *
+ * A file starts with its prologue: the header, the `LayerEntry` table, the `MipEntry` table (largest first) and the
+ * page table of every mip, padded to `Header::m_pageAlignment`. A runtime reads it once and keeps it resident.
+ *
+ * A page table is a square or rectangle of power of two sides covering the page grid of its mip, indexed in Z-order
+ * (`GetPageTableIndex()`) so neighbouring pages have neighbouring entries. Entries are physical page indices, or
+ * `kNoPage` for the slots past the grid of non power of two textures.
+ *
+ * Physical pages follow the prologue, `Header::m_pageStride` bytes each so a page is one aligned read at
+ * `m_prologueSize + index * m_pageStride`. A page holds every layer (e.g. the albedo and normals of a terrain) back to
+ * back, each as rows of blocks, top to bottom. Pages are ordered smallest mip first then in Z-order, and identical
+ * pages are stored once. All values are little-endian.
+ */
+namespace KryneTools::VirtualTextureFileFormat
+{
+    using TextureFileFormat::BlockFormat;
+
+    constexpr u32 kMagic = MakeFourCC('K', 'V', 'T', 'X');
+    constexpr u16 kVersion = 1;
+    constexpr u32 kNoPage = ~0u;
+
+    enum class AddressMode: u8
+    {
+        /// Borders past the texture edges repeat the edge texels.
+        Clamp = 0,
+        /// Borders past the texture edges come from the opposite edge, for tiling textures.
+        Wrap = 1,
+    };
+
+    struct Header
+    {
+        u32 m_magic;
+        u16 m_version;
+        u16 m_headerSize;
+        u32 m_width;
+        u32 m_height;
+        /// Texels of a page side, without its borders. A power of two.
+        u16 m_pageSize;
+        /// Texels on each side of a page, `m_pageSize + 2 * m_border` being a multiple of the block size.
+        u16 m_border;
+        u8 m_mipCount;
+        u8 m_layerCount;
+        AddressMode m_addressMode;
+        u8 m_reserved;
+        u32 m_pageAlignment;
+        /// Every layer of a page, padded to `m_pageAlignment`.
+        u32 m_pageStride;
+        u32 m_physicalPageCount;
+        /// Header, tables and page tables, padded to `m_pageAlignment`. Offset of the first physical page.
+        u32 m_prologueSize;
+        u64 m_fileSize;
+    };
+    static_assert(sizeof(Header) == 48);
+
+    struct LayerEntry
+    {
+        BlockFormat m_format;
+        /// `TextureFileFormat::Flags`.
+        u8 m_flags;
+        u16 m_reserved;
+        /// Byte range of the layer blocks in a physical page.
+        u32 m_offset;
+        u32 m_size;
+    };
+    static_assert(sizeof(LayerEntry) == 12);
+
+    struct MipEntry
+    {
+        u32 m_width;
+        u32 m_height;
+        u32 m_pagesX;
+        u32 m_pagesY;
+        /// Page table of `1 << (m_tableWidthLog2 + m_tableHeightLog2)` u32 entries.
+        u8 m_tableWidthLog2;
+        u8 m_tableHeightLog2;
+        u16 m_reserved;
+        /// Absolute file offset, inside the prologue.
+        u32 m_tableOffset;
+    };
+    static_assert(sizeof(MipEntry) == 24);
+
+    /**
+     * @brief Z-order index of page `(_x, _y)` in a page table of `1 << _widthLog2` by `1 << _heightLog2` entries.
+     * @details The low bits of both coordinates are interleaved, x first. On rectangular tables the extra high bits of
+     * the longer side come last, so the table is a row or column of Z-ordered squares.
+     */
+    [[nodiscard]] constexpr u32 GetPageTableIndex(u32 _x, u32 _y, u32 _widthLog2, u32 _heightLog2)
+    {
+        const u32 sharedLog2 = std::min(_widthLog2, _heightLog2);
+        u32 index = 0;
+        for (u32 bit = 0; bit < sharedLog2; bit++)
+        {
+            index |= ((_x >> bit) & 1) << (2 * bit);
+            index |= ((_y >> bit) & 1) << (2 * bit + 1);
+        }
+        return index | ((_widthLog2 > sharedLog2 ? _x : _y) >> sharedLog2) << (2 * sharedLog2);
+    }
+}
@@ -0,0 +1,650 @@
+#include "BlockCodecs.hpp"
+
+#include <span>
+#include <string_view>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools::BlockCodecs
+{
+    namespace
+    {
+        /**
+         * Integer sequence encoding of a quantization level: `m_bits` low bits per value, plus a trit (levels of
+         * 3 * 2^bits) or a quint (5 * 2^bits) packed with the ones of neighbouring values.
+         */
+        struct IseLevel
+        {
+            u16 m_levelCount;
+            u8 m_bits;
+            u8 m_trits;
+            u8 m_quints;
+        };
+
+        constexpr IseLevel kIseLevels[21] = {
+            { 2, 1, 0, 0 }, { 3, 0, 1, 0 }, { 4, 2, 0, 0 }, { 5, 0, 0, 1 }, { 6, 1, 1, 0 }, { 8, 3, 0, 0 },
+            { 10, 1, 0, 1 }, { 12, 2, 1, 0 }, { 16, 4, 0, 0 }, { 20, 2, 0, 1 }, { 24, 3, 1, 0 }, { 32, 5, 0, 0 },
+            { 40, 3, 0, 1 }, { 48, 4, 1, 0 }, { 64, 6, 0, 0 }, { 80, 4, 0, 1 }, { 96, 5, 1, 0 }, { 128, 7, 0, 0 },
+            { 160, 5, 0, 1 }, { 192, 6, 1, 0 }, { 256, 8, 0, 0 },
+        };
+
+        /// Weight quantization levels the block mode can express, `kIseLevels` indices.
+        constexpr u32 kWeightLevelCount = 12;
+        /// Endpoints use at least 6 levels, the specification has no unquantization for fewer.
+        constexpr u32 kMinColorLevel = 4;
+
+        constexpr u32 GetIseBitCount(const IseLevel& _level, u32 _count)
+        {
+            return _count * _level.m_bits + (_level.m_trits != 0 ? (8 * _count + 4) / 5 : 0) + (_level.m_quints != 0 ? (7 * _count + 2) / 3 : 0);
+        }
+
+        /// Single partition block: block mode, partition count and endpoint mode come before the color data.
+        constexpr u32 kColorDataOffset = 17;
+        constexpr u32 kCemRgbDirect = 8;
+        constexpr u32 kCemRgbaDirect = 12;
+
+        /// Highest color level whose endpoints fit the bits the weights leave, which is what the decoder infers.
+        u32 SelectColorLevel(u32 _weightLevel, u32 _valueCount)
+        {
+            const s32 available = s32(128 - kColorDataOffset) - s32(GetIseBitCount(kIseLevels[_weightLevel], 16));
+            u32 level = 21;
+            while (--level > kMinColorLevel && s32(GetIseBitCount(kIseLevels[level], _valueCount)) > available)
+            {
+            }
+            return level;
+        }
+
+        void DecodeTrits(u32 _packed, u32 _trits[5])
+        {
+            const auto bit = [_packed](u32 _index) { return (_packed >> _index) & 1; };
+            u32 c;
+            if (((_packed >> 2) & 7) == 7)
+            {
+                c = (((_packed >> 5) & 7) << 2) | (_packed & 3);
+                _trits[4] = 2;
+                _trits[3] = 2;
+            }
+            else
+            {
+                c = _packed & 0x1F;
+                if (((_packed >> 5) & 3) == 3)
+                {
+                    _trits[4] = 2;
+                    _trits[3] = bit(7);
+                }
+                else
+                {
+                    _trits[4] = bit(7);
+                    _trits[3] = (_packed >> 5) & 3;
+                }
+            }
+            const auto cBit = [c](u32 _index) { return (c >> _index) & 1; };
+            if ((c & 3) == 3)
+            {
+                _trits[2] = 2;
+                _trits[1] = cBit(4);
+                _trits[0] = (cBit(3) << 1) | (cBit(2) & ~cBit(3) & 1);
+            }
+            else if (((c >> 2) & 3) == 3)
+            {
+                _trits[2] = 2;
+                _trits[1] = 2;
+                _trits[0] = c & 3;
+            }
+            else
+            {
+                _trits[2] = cBit(4);
+                _trits[1] = (c >> 2) & 3;
+                _trits[0] = (cBit(1) << 1) | (cBit(0) & ~cBit(1) & 1);
+            }
+        }
+
+        void DecodeQuints(u32 _packed, u32 _quints[3])
+        {
+            const auto bit = [_packed](u32 _index) { return (_packed >> _index) & 1; };
+            if (((_packed >> 1) & 3) == 3 && ((_packed >> 5) & 3) == 0)
+            {
+                _quints[2] = (bit(0) << 2) | ((bit(4) & ~bit(0) & 1) << 1) | (bit(3) & ~bit(0) & 1);
+                _quints[1] = 4;
+                _quints[0] = 4;
+                return;
+            }
+            u32 c;
+            if (((_packed >> 1) & 3) == 3)
+            {
+                _quints[2] = 4;
+                c = (((_packed >> 3) & 3) << 3) | ((~(_packed >> 5) & 3) << 1) | bit(0);
+            }
+            else
+            {
+                _quints[2] = (_packed >> 5) & 3;
+                c = _packed & 0x1F;
+            }
+            if ((c & 7) == 5)
+            {
+                _quints[1] = 4;
+                _quints[0] = (c >> 3) & 3;
+            }
+            else
+            {
+                _quints[1] = (c >> 3) & 3;
+                _quints[0] = c & 7;
+            }
+        }
+
+        /// Expands a `b000b0bb0` style specification pattern, letters being bits of `_value` ('a' the lowest).
+        u32 ExpandBitPattern(std::string_view _pattern, u32 _value)
+        {
+            u32 result = 0;
+            for (const char symbol: _pattern)
+            {
+                result = (result << 1) | (symbol == '0' ? 0 : (_value >> (symbol - 'a')) & 1);
+            }
+            return result;
+        }
+
+        /// Scrambled unquantization of trit and quint levels: the high digit selects a step, the low bits a bias.
+        struct UnquantizationRule
+        {
+            u16 m_levelCount;
+            u16 m_c;
+            std::string_view m_b;
+        };
+
+        constexpr UnquantizationRule kColorRules[] = {
+            { 6, 204, "000000000" }, { 10, 113, "000000000" }, { 12, 93, "b000b0bb0" }, { 20, 54, "b0000bb00" },
+            { 24, 44, "cb000cbcb" }, { 40, 26, "cb0000cbc" }, { 48, 22, "dcb000dcb" }, { 80, 13, "dcb0000dc" },
+            { 96, 11, "edcb000ed" }, { 160, 6, "edcb0000e" }, { 192, 5, "fedcb000f" },
+        };
+
+        constexpr UnquantizationRule kWeightRules[] = {
+            { 6, 50, "0000000" }, { 10, 28, "0000000" }, { 12, 23, "b000b0b" }, { 20, 13, "b0000b0" }, { 24, 11, "cb000cb" },
+        };
+
+        u32 UnquantizeValue(const IseLevel& _level, u32 _value, bool _weight)
+        {
+            const u32 targetBits = _weight ? 6 : 8;
+            if (_level.m_trits == 0 && _level.m_quints == 0)
+            {
+                const u32 result = u32(ReplicateBits(s32(_value), _level.m_bits)) >> (8 - targetBits);
+                return _weight && result > 32 ? result + 1 : result;
+            }
+            if (_weight && _level.m_bits == 0)
+            {
+                constexpr u8 kTrits[3] = { 0, 32, 63 };
+                constexpr u8 kQuints[5] = { 0, 16, 32, 47, 63 };
+                const u32 result = _level.m_trits != 0 ? kTrits[_value] : kQuints[_value];
+                return result > 32 ? result + 1 : result;
+            }
+
+            const u32 low = _value & ((1u << _level.m_bits) - 1);
+            const u32 digit = _value >> _level.m_bits;
+            const u32 a = (low & 1) != 0 ? (_weight ? 0x7F : 0x1FF) : 0;
+            for (const UnquantizationRule& rule: _weight ? std::span<const UnquantizationRule>(kWeightRules) : std::span<const UnquantizationRule>(kColorRules))
+            {
+                if (rule.m_levelCount != _level.m_levelCount)
+                {
+                    continue;
+                }
+                u32 t = digit * rule.m_c + ExpandBitPattern(rule.m_b, low);
+                t ^= a;
+                const u32 result = (a & (_weight ? 0x20 : 0x80)) | (t >> 2);
+                return _weight && result > 32 ? result + 1 : result;
+            }
+            ThrowError("No ASTC unquantization rule for %u levels", _level.m_levelCount);
+        }
+
+        /**
+         * Per level lookup tables. Codes handed to the endpoint fit are ranks, sorted by unquantized value, since
+         * trit and quint levels do not unquantize in order.
+         */
+        struct QuantizationTable
+        {
+            u32 m_levelCount = 0;
+            u8 m_rankToValue[256] = {};
+            u8 m_valueToRank[256] = {};
+            u8 m_unquantized[256] = {};
+            /// Nearest rank of every unquantized value (0 to 255 for colors, 0 to 64 for weights).
+            u8 m_nearestRank[256] = {};
+        };
+
+        struct QuantizationTables
+        {
+            QuantizationTable m_colors[21];
+            QuantizationTable m_weights[kWeightLevelCount];
+            u8 m_tritEncoding[243] = {};
+            u8 m_quintEncoding[125] = {};
+
+            QuantizationTables()
+            {
+                for (u32 i = kMinColorLevel; i < 21; i++)
+                {
+                    Build(kIseLevels[i], false, m_colors[i]);
+                }
+                for (u32 i = 0; i < kWeightLevelCount; i++)
+                {
+                    Build(kIseLevels[i], true, m_weights[i]);
+                }
+
+                // Several packings can decode to the same digits, keep the smallest so truncated groups stay valid.
+                bool tritFound[243] = {};
+                for (u32 packed = 0; packed < 256; packed++)
+                {
+                    u32 trits[5];
+                    DecodeTrits(packed, trits);
+                    const u32 index = trits[0] + 3 * trits[1] + 9 * trits[2] + 27 * trits[3] + 81 * trits[4];
+                    if (!tritFound[index])
+                    {
+                        tritFound[index] = true;
+                        m_tritEncoding[index] = u8(packed);
+                    }
+                }
+                bool quintFound[125] = {};
+                for (u32 packed = 0; packed < 128; packed++)
+                {
+                    u32 quints[3];
+                    DecodeQuints(packed, quints);
+                    const u32 index = quints[0] + 5 * quints[1] + 25 * quints[2];
+                    if (!quintFound[index])
+                    {
+                        quintFound[index] = true;
+                        m_quintEncoding[index] = u8(packed);
+                    }
+                }
+                KT_VERIFY(std::all_of(std::begin(tritFound), std::end(tritFound), [](bool _found) { return _found; }), "ASTC trit packing is incomplete");
+                KT_VERIFY(std::all_of(std::begin(quintFound), std::end(quintFound), [](bool _found) { return _found; }), "ASTC quint packing is incomplete");
+            }
+
+            static void Build(const IseLevel& _level, bool _weight, QuantizationTable& _table)
+            {
+                _table.m_levelCount = _level.m_levelCount;
+                std::array<std::pair<u32, u32>, 256> sorted;
+                for (u32 value = 0; value < _level.m_levelCount; value++)
+                {
+                    sorted[value] = { UnquantizeValue(_level, value, _weight), value };
+                }
+                std::sort(sorted.begin(), sorted.begin() + _level.m_levelCount);
+                for (u32 rank = 0; rank < _level.m_levelCount; rank++)
+                {
+                    _table.m_rankToValue[rank] = u8(sorted[rank].second);
+                    _table.m_valueToRank[sorted[rank].second] = u8(rank);
+                    _table.m_unquantized[rank] = u8(sorted[rank].first);
+                }
+                // Endpoint swaps mirror the weights, which relies on the weight levels being symmetric.
+                for (u32 rank = 0; _weight && rank < _level.m_levelCount; rank++)
+                {
+                    KT_VERIFY(
+                        _table.m_unquantized[rank] + _table.m_unquantized[_level.m_levelCount - 1 - rank] == 64,
+                        "ASTC weight level %u is not symmetric",
+                        _level.m_levelCount);
+                }
+
+                const u32 maximum = _weight ? 64 : 255;
+                u32 rank = 0;
+                for (u32 value = 0; value <= maximum; value++)
+                {
+                    while (rank + 1 < _level.m_levelCount
+                        && std::abs(s32(_table.m_unquantized[rank + 1]) - s32(value)) <= std::abs(s32(_table.m_unquantized[rank]) - s32(value)))
+                    {
+                        rank++;
+                    }
+                    _table.m_nearestRank[value] = u8(rank);
+                }
+            }
+        };
+
+        const QuantizationTables& GetTables()
+        {
+            static const QuantizationTables tables;
+            return tables;
+        }
+
+        template <u32 kChannels>
+        struct AstcCodec
+        {
+            static constexpr u32 kChannelCount = kChannels;
+            const QuantizationTable* m_colors;
+            const QuantizationTable* m_weights;
+
+            [[nodiscard]] u32 GetWeightCount() const { return m_weights->m_levelCount; }
+            [[nodiscard]] f32 GetWeight(u32 _index) const { return f32(m_weights->m_unquantized[_index]) / 64.0f; }
+            [[nodiscard]] s32 GetMaxCode(u32) const { return s32(m_colors->m_levelCount) - 1; }
+            [[nodiscard]] s32 Quantize(f32 _value, u32, u32) const { return m_colors->m_nearestRank[u32(_value + 0.5f)]; }
+            [[nodiscard]] s32 Expand(s32 _code, u32, u32) const { return m_colors->m_unquantized[_code]; }
+
+            [[nodiscard]] s32 Interpolate(s32 _a, s32 _b, u32 _index) const
+            {
+                const s32 weight = m_weights->m_unquantized[_index];
+                return ((_a * 257) * (64 - weight) + (_b * 257) * weight + 32) / 64 >> 8;
+            }
+        };
+
+        /// Integer sequence encoding of `_count` values, written to a zeroed scratch stream.
+        void EncodeIse(const IseLevel& _level, const u8* _values, u32 _count, u8 _stream[16])
+        {
+            const QuantizationTables& tables = GetTables();
+            BitWriter writer(_stream, 16);
+            const u32 mask = (1u << _level.m_bits) - 1;
+            const u32 groupSize = _level.m_trits != 0 ? 5 : (_level.m_quints != 0 ? 3 : 1);
+            for (u32 group = 0; group < _count; group += groupSize)
+            {
+                u32 low[5] = {};
+                u32 digits[5] = {};
+                for (u32 i = 0; i < groupSize && group + i < _count; i++)
+                {
+                    low[i] = _values[group + i] & mask;
+                    digits[i] = _values[group + i] >> _level.m_bits;
+                }
+                if (_level.m_trits != 0)
+                {
+                    const u32 packed = tables.m_tritEncoding[digits[0] + 3 * digits[1] + 9 * digits[2] + 27 * digits[3] + 81 * digits[4]];
+                    constexpr u32 kTritBits[5][2] = { { 0, 2 }, { 2, 2 }, { 4, 1 }, { 5, 2 }, { 7, 1 } };
+                    for (u32 i = 0; i < 5; i++)
+                    {
+                        writer.Write(low[i], _level.m_bits);
+                        writer.Write(packed >> kTritBits[i][0], kTritBits[i][1]);
+                    }
+                }
+                else if (_level.m_quints != 0)
+                {
+                    const u32 packed = tables.m_quintEncoding[digits[0] + 5 * digits[1] + 25 * digits[2]];
+                    constexpr u32 kQuintBits[3][2] = { { 0, 3 }, { 3, 2 }, { 5, 2 } };
+                    for (u32 i = 0; i < 3; i++)
+                    {
+                        writer.Write(low[i], _level.m_bits);
+                        writer.Write(packed >> kQuintBits[i][0], kQuintBits[i][1]);
+                    }
+                }
+                else
+                {
+                    writer.Write(low[0], _level.m_bits);
+                }
+            }
+        }
+
+        /// Inverse of `EncodeIse()`, the stream being zero past its encoded length.
+        void DecodeIse(const IseLevel& _level, const u8 _stream[16], u32 _count, u8* _values)
+        {
+            BitReader reader(_stream);
+            const u32 groupSize = _level.m_trits != 0 ? 5 : (_level.m_quints != 0 ? 3 : 1);
+            for (u32 group = 0; group < _count; group += groupSize)
+            {
+                u32 low[5] = {};
+                u32 digits[5] = {};
+                if (_level.m_trits != 0)
+                {
+                    constexpr u32 kTritBits[5][2] = { { 0, 2 }, { 2, 2 }, { 4, 1 }, { 5, 2 }, { 7, 1 } };
+                    u32 packed = 0;
+                    for (u32 i = 0; i < 5; i++)
+                    {
+                        low[i] = reader.Read(_level.m_bits);
+                        packed |= reader.Read(kTritBits[i][1]) << kTritBits[i][0];
+                    }
+                    DecodeTrits(packed, digits);
+                }
+                else if (_level.m_quints != 0)
+                {
+                    constexpr u32 kQuintBits[3][2] = { { 0, 3 }, { 3, 2 }, { 5, 2 } };
+                    u32 packed = 0;
+                    for (u32 i = 0; i < 3; i++)
+                    {
+                        low[i] = reader.Read(_level.m_bits);
+                        packed |= reader.Read(kQuintBits[i][1]) << kQuintBits[i][0];
+                    }
+                    DecodeQuints(packed, digits);
+                }
+                else
+                {
+                    low[0] = reader.Read(_level.m_bits);
+                }
+                for (u32 i = 0; i < groupSize && group + i < _count; i++)
+                {
+                    _values[group + i] = u8((digits[i] << _level.m_bits) | low[i]);
+                }
+            }
+        }
+
+        /// One candidate encoding: endpoint mode and weight level, the color level following.
+        struct AstcConfiguration
+        {
+            u32 m_weightLevel;
+            u32 m_channelCount;
+        };
+
+        constexpr AstcConfiguration kOpaqueConfigurations[] = { { 8, 3 }, { 5, 3 }, { 7, 3 }, { 9, 3 }, { 10, 3 } };
+        constexpr AstcConfiguration kAlphaConfigurations[] = { { 5, 4 }, { 2, 4 }, { 3, 4 }, { 4, 4 }, { 7, 4 }, { 8, 4 } };
+
+        struct AstcBlock
+        {
+            AstcConfiguration m_configuration {};
+            u32 m_colorLevel = 0;
+            EndpointFit m_fit;
+        };
+
+        template <u32 kChannels>
+        AstcCodec<kChannels> MakeCodec(const AstcBlock& _block)
+        {
+            const QuantizationTables& tables = GetTables();
+            return { &tables.m_colors[_block.m_colorLevel], &tables.m_weights[_block.m_configuration.m_weightLevel] };
+        }
+
+        template <u32 kChannels>
+        void FitConfiguration(EncodeQuality _quality, const BlockTexels& _texels, const AstcConfiguration& _configuration, AstcBlock& _best)
+        {
+            AstcBlock candidate;
+            candidate.m_configuration = _configuration;
+            candidate.m_colorLevel = SelectColorLevel(_configuration.m_weightLevel, kChannels * 2);
+            candidate.m_fit = _best.m_fit;
+            const u32 previousError = _best.m_fit.m_error;
+            FitEndpoints(MakeCodec<kChannels>(candidate), _texels, Subset::All(), _quality, candidate.m_fit);
+            if (candidate.m_fit.m_error < previousError)
+            {
+                _best = candidate;
+            }
+        }
+
+        void UnpackEndpoints(const u8* _values, u32 _cem, s32 _endpoints[2][4])
+        {
+            for (u32 c = 0; c < 3; c++)
+            {
+                _endpoints[0][c] = _values[c * 2];
+                _endpoints[1][c] = _values[c * 2 + 1];
+            }
+            _endpoints[0][3] = _cem == kCemRgbaDirect ? _values[6] : 255;
+            _endpoints[1][3] = _cem == kCemRgbaDirect ? _values[7] : 255;
+        }
+    }
+
+    void EncodeAstc(EncodeQuality _quality, const u8* _pixels, u8* _output)
+    {
+        const BlockTexels texels(_pixels);
+        bool opaque = true;
+        for (u32 i = 0; i < 16; i++)
+        {
+            opaque &= _pixels[i * 4 + 3] == 255;
+        }
+
+        // Fast mode only tries the first configuration of each list, the overall best in practice.
+        AstcBlock block;
+        const std::span<const AstcConfiguration> configurations = opaque ? std::span<const AstcConfiguration>(kOpaqueConfigurations) : std::span<const AstcConfiguration>(kAlphaConfigurations);
+        for (const AstcConfiguration& configuration: configurations.first(_quality == EncodeQuality::High ? configurations.size() : 1))
+        {
+            if (opaque)
+            {
+                FitConfiguration<3>(_quality, texels, configuration, block);
+            }
+            else
+            {
+                FitConfiguration<4>(_quality, texels, configuration, block);
+            }
+            if (block.m_fit.m_error == 0)
+            {
+                break;
+            }
+        }
+        if (_quality == EncodeQuality::High)
+        {
+            if (opaque)
+            {
+                SearchEndpoints(MakeCodec<3>(block), texels, Subset::All(), block.m_fit);
+            }
+            else
+            {
+                SearchEndpoints(MakeCodec<4>(block), texels, Subset::All(), block.m_fit);
+            }
+        }
+
+        const QuantizationTables& tables = GetTables();
+        const QuantizationTable& colors = tables.m_colors[block.m_colorLevel];
+        const QuantizationTable& weights = tables.m_weights[block.m_configuration.m_weightLevel];
+        const u32 channelCount = block.m_configuration.m_channelCount;
+        EndpointFit& fit = block.m_fit;
+
+        // Direct endpoint modes blue-contract when the second endpoint is darker, keep it the brighter one.
+        s32 sums[2] = {};
+        for (u32 e = 0; e < 2; e++)
+        {
+            for (u32 c = 0; c < 3; c++)
+            {
+                sums[e] += colors.m_unquantized[fit.m_codes[e][c]];
+            }
+        }
+        if (sums[1] < sums[0])
+        {
+            for (u32 c = 0; c < 4; c++)
+            {
+                std::swap(fit.m_codes[0][c], fit.m_codes[1][c]);
+            }
+            for (u8& index: fit.m_indices)
+            {
+                index = u8(weights.m_levelCount - 1 - index);
+            }
+        }
+
+        const u32 weightLevel = block.m_configuration.m_weightLevel;
+        const u32 range = (weightLevel % 6) + 2;
+        const u32 blockMode = (range >> 1) | ((range & 1) << 4) | (2 << 5) | ((weightLevel / 6) << 9);
+        const u32 cem = channelCount == 4 ? kCemRgbaDirect : kCemRgbDirect;
+
+        u8 colorValues[8];
+        for (u32 c = 0; c < channelCount; c++)
+        {
+            colorValues[c * 2] = colors.m_rankToValue[fit.m_codes[0][c]];
+            colorValues[c * 2 + 1] = colors.m_rankToValue[fit.m_codes[1][c]];
+        }
+        u8 weightValues[16];
+        for (u32 i = 0; i < 16; i++)
+        {
+            weightValues[i] = weights.m_rankToValue[fit.m_indices[i]];
+        }
+
+        u8 colorStream[16];
+        EncodeIse(kIseLevels[block.m_colorLevel], colorValues, channelCount * 2, colorStream);
+        u8 weightStream[16];
+        EncodeIse(kIseLevels[weightLevel], weightValues, 16, weightStream);
+
+        BitWriter writer(_output, 16);
+        writer.Write(blockMode, 11);
+        writer.Write(0, 2);
+        writer.Write(cem, 4);
+        BitReader colorReader(colorStream);
+        for (u32 i = 0; i < GetIseBitCount(kIseLevels[block.m_colorLevel], channelCount * 2); i++)
+        {
+            writer.Write(colorReader.Read(1), 1);
+        }
+        // Weights are stored bit reversed from the end of the block.
+        BitReader weightReader(weightStream);
+        for (u32 i = 0; i < GetIseBitCount(kIseLevels[weightLevel], 16); i++)
+        {
+            const u32 position = 127 - i;
+            _output[position >> 3] |= u8(weightReader.Read(1) << (position & 7));
+        }
+    }
+
+    void DecodeAstc(const u8* _block, u8* _pixels)
+    {
+        BitReader reader(_block);
+        const u32 blockMode = reader.Read(11);
+        const u32 partitionCount = reader.Read(2) + 1;
+        const u32 cem = reader.Read(4);
+
+        const u32 range = ((blockMode & 3) << 1) | ((blockMode >> 4) & 1);
+        const u32 weightLevel = (range - 2) + 6 * ((blockMode >> 9) & 1);
+        const bool supported = (blockMode & 3) != 0
+            && (blockMode & 0x40C) == 0
+            && ((blockMode >> 5) & 3) == 2
+            && ((blockMode >> 7) & 3) == 0
+            && partitionCount == 1
+            && (cem == kCemRgbDirect || cem == kCemRgbaDirect);
+        if (!supported)
+        {
+            // Error color of the specification.
+            for (u32 i = 0; i < 16; i++)
+            {
+                _pixels[i * 4 + 0] = 255;
+                _pixels[i * 4 + 1] = 0;
+                _pixels[i * 4 + 2] = 255;
+                _pixels[i * 4 + 3] = 255;
+            }
+            return;
+        }
+
+        const u32 valueCount = cem == kCemRgbaDirect ? 8 : 6;
+        const u32 colorLevel = SelectColorLevel(weightLevel, valueCount);
+        const u32 colorBits = GetIseBitCount(kIseLevels[colorLevel], valueCount);
+        const u32 weightBits = GetIseBitCount(kIseLevels[weightLevel], 16);
+
+        u8 colorStream[16] = {};
+        BitWriter colorWriter(colorStream, 16);
+        for (u32 i = 0; i < colorBits; i++)
+        {
+            colorWriter.Write(reader.Read(1), 1);
+        }
+        u8 weightStream[16] = {};
+        BitWriter weightWriter(weightStream, 16);
+        for (u32 i = 0; i < weightBits; i++)
+        {
+            const u32 position = 127 - i;
+            weightWriter.Write((_block[position >> 3] >> (position & 7)) & 1, 1);
+        }
+
+        const QuantizationTables& tables = GetTables();
+        u8 colorValues[8];
+        DecodeIse(kIseLevels[colorLevel], colorStream, valueCount, colorValues);
+        for (u32 i = 0; i < valueCount; i++)
+        {
+            const QuantizationTable& table = tables.m_colors[colorLevel];
+            colorValues[i] = table.m_unquantized[table.m_valueToRank[colorValues[i]]];
+        }
+        u8 weightValues[16];
+        DecodeIse(kIseLevels[weightLevel], weightStream, 16, weightValues);
+
+        s32 endpoints[2][4];
+        UnpackEndpoints(colorValues, cem, endpoints);
+        // Only the direct modes without blue contraction are emitted.
+        const s32 sum0 = endpoints[0][0] + endpoints[0][1] + endpoints[0][2];
+        const s32 sum1 = endpoints[1][0] + endpoints[1][1] + endpoints[1][2];
+        if (sum1 < sum0)
+        {
+            for (u32 c = 0; c < 3; c++)
+            {
+                const s32 contracted0 = (endpoints[1][c] + endpoints[1][2]) >> 1;
+                const s32 contracted1 = (endpoints[0][c] + endpoints[0][2]) >> 1;
+                endpoints[0][c] = c == 2 ? endpoints[1][2] : contracted0;
+                endpoints[1][c] = c == 2 ? endpoints[0][2] : contracted1;
+            }
+            std::swap(endpoints[0][3], endpoints[1][3]);
+        }
+
+        const QuantizationTable& weights = tables.m_weights[weightLevel];
+        const AstcCodec<4> codec { &tables.m_colors[colorLevel], &weights };
+        for (u32 i = 0; i < 16; i++)
+        {
+            const u32 rank = weights.m_valueToRank[weightValues[i]];
+            for (u32 c = 0; c < 4; c++)
+            {
+                _pixels[i * 4 + c] = u8(codec.Interpolate(endpoints[0][c], endpoints[1][c], rank));
+            }
+        }
+    }
+}
@@ -0,0 +1,448 @@
+#include "BlockCodecs.hpp"
+
+#include <bit>
+
+namespace KryneTools::BlockCodecs
+{
+    namespace
+    {
+        constexpr u8 kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        constexpr u8 kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+
+        /// Two subset partitions, bit `i` set when pixel `i` belongs to subset 1.
+        constexpr u16 kPartitions[64] = {
+            0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+            0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+            0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+            0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+            0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+            0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+            0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+            0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+        };
+
+        /// Anchor pixel of subset 1, whose index has an implicit zero most significant bit.
+        constexpr u8 kAnchors[64] = {
+            15, 15, 15, 15, 15, 15, 15, 15,
+            15, 15, 15, 15, 15, 15, 15, 15,
+            15, 2, 8, 2, 2, 8, 8, 15,
+            2, 8, 2, 2, 8, 8, 2, 2,
+            15, 15, 6, 8, 2, 8, 15, 15,
+            2, 8, 2, 2, 2, 15, 15, 6,
+            6, 2, 6, 8, 15, 15, 2, 2,
+            15, 15, 15, 15, 15, 2, 2, 15,
+        };
+
+        constexpr bool AnchorsMatchPartitions()
+        {
+            for (u32 i = 0; i < 64; i++)
+            {
+                if ((kPartitions[i] & 1) != 0 || ((kPartitions[i] >> kAnchors[i]) & 1) == 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        static_assert(AnchorsMatchPartitions(), "BC7 partition tables are inconsistent");
+
+        s32 Interpolate(s32 _a, s32 _b, u32 _weight)
+        {
+            return ((64 - s32(_weight)) * _a + s32(_weight) * _b + 32) >> 6;
+        }
+
+        /// Mode 6: RGBA 7 bits endpoints with one p-bit each, 4 bits indices.
+        struct Mode6Codec
+        {
+            static constexpr u32 kChannelCount = 4;
+            u32 m_pBits[2];
+
+            [[nodiscard]] u32 GetWeightCount() const { return 16; }
+            [[nodiscard]] f32 GetWeight(u32 _index) const { return f32(kWeights4[_index]) / 64.0f; }
+            [[nodiscard]] s32 GetMaxCode(u32) const { return 127; }
+
+            [[nodiscard]] s32 Quantize(f32 _value, u32, u32 _endpoint) const
+            {
+                return std::clamp(s32((_value - f32(m_pBits[_endpoint])) * 0.5f + 0.5f), 0, 127);
+            }
+
+            [[nodiscard]] s32 Expand(s32 _code, u32, u32 _endpoint) const { return (_code << 1) | s32(m_pBits[_endpoint]); }
+            [[nodiscard]] s32 Interpolate(s32 _a, s32 _b, u32 _index) const { return BlockCodecs::Interpolate(_a, _b, kWeights4[_index]); }
+        };
+
+        /// Mode 1: RGB 6 bits endpoints with a p-bit shared by the subset, 3 bits indices.
+        struct Mode1Codec
+        {
+            static constexpr u32 kChannelCount = 3;
+            u32 m_pBit;
+
+            [[nodiscard]] u32 GetWeightCount() const { return 8; }
+            [[nodiscard]] f32 GetWeight(u32 _index) const { return f32(kWeights3[_index]) / 64.0f; }
+            [[nodiscard]] s32 GetMaxCode(u32) const { return 63; }
+
+            [[nodiscard]] s32 Quantize(f32 _value, u32, u32) const
+            {
+                const f32 value7 = _value * 127.0f / 255.0f;
+                return std::clamp(s32((value7 - f32(m_pBit)) * 0.5f + 0.5f), 0, 63);
+            }
+
+            [[nodiscard]] s32 Expand(s32 _code, u32, u32) const { return ReplicateBits((_code << 1) | s32(m_pBit), 7); }
+            [[nodiscard]] s32 Interpolate(s32 _a, s32 _b, u32 _index) const { return BlockCodecs::Interpolate(_a, _b, kWeights3[_index]); }
+        };
+
+        struct Mode6Block
+        {
+            EndpointFit m_fit;
+            u32 m_pBits[2] = {};
+        };
+
+        Mode6Block EncodeMode6(EncodeQuality _quality, const BlockTexels& _texels)
+        {
+            const Subset all = Subset::All();
+            Mode6Block best;
+            for (u32 p = 0; p < 4; p++)
+            {
+                const Mode6Codec codec { { p & 1, p >> 1 } };
+                const u32 previousError = best.m_fit.m_error;
+                FitEndpoints(codec, _texels, all, _quality, best.m_fit);
+                if (best.m_fit.m_error < previousError)
+                {
+                    best.m_pBits[0] = codec.m_pBits[0];
+                    best.m_pBits[1] = codec.m_pBits[1];
+                }
+            }
+            if (_quality == EncodeQuality::High)
+            {
+                SearchEndpoints(Mode6Codec { { best.m_pBits[0], best.m_pBits[1] } }, _texels, all, best.m_fit);
+            }
+            return best;
+        }
+
+        void WriteMode6(Mode6Block _block, u8* _output)
+        {
+            EndpointFit& fit = _block.m_fit;
+            // The anchor (pixel 0) index is stored without its most significant bit, mirror the segment if it is set.
+            if (fit.m_indices[0] >= 8)
+            {
+                for (u32 c = 0; c < 4; c++)
+                {
+                    std::swap(fit.m_codes[0][c], fit.m_codes[1][c]);
+                }
+                std::swap(_block.m_pBits[0], _block.m_pBits[1]);
+                for (u8& index: fit.m_indices)
+                {
+                    index = u8(15 - index);
+                }
+            }
+
+            BitWriter writer(_output, 16);
+            writer.Write(1 << 6, 7);
+            for (u32 c = 0; c < 4; c++)
+            {
+                writer.Write(u32(fit.m_codes[0][c]), 7);
+                writer.Write(u32(fit.m_codes[1][c]), 7);
+            }
+            writer.Write(_block.m_pBits[0], 1);
+            writer.Write(_block.m_pBits[1], 1);
+            for (u32 i = 0; i < 16; i++)
+            {
+                writer.Write(fit.m_indices[i], i == 0 ? 3 : 4);
+            }
+        }
+
+        struct Mode1Block
+        {
+            u32 m_partition = 0;
+            EndpointFit m_fits[2];
+            u32 m_pBits[2] = {};
+
+            [[nodiscard]] u32 GetError() const
+            {
+                const u64 error = u64(m_fits[0].m_error) + m_fits[1].m_error;
+                return u32(std::min<u64>(error, std::numeric_limits<u32>::max()));
+            }
+        };
+
+        void SplitPartition(u32 _partition, Subset _subsets[2])
+        {
+            _subsets[0].m_count = 0;
+            _subsets[1].m_count = 0;
+            for (u32 i = 0; i < 16; i++)
+            {
+                Subset& subset = _subsets[(kPartitions[_partition] >> i) & 1];
+                subset.m_pixels[subset.m_count++] = u8(i);
+            }
+        }
+
+        /// Color moments of a set of pixels: count, sums and sums of products, enough to get their covariance.
+        struct Moments
+        {
+            f32 m_count = 0.0f;
+            f32 m_sums[3] = {};
+            /// rr, gg, bb, rg, rb, gb.
+            f32 m_products[6] = {};
+
+            void Add(const s32* _pixel)
+            {
+                const f32 r = f32(_pixel[0]);
+                const f32 g = f32(_pixel[1]);
+                const f32 b = f32(_pixel[2]);
+                m_count += 1.0f;
+                m_sums[0] += r;
+                m_sums[1] += g;
+                m_sums[2] += b;
+                m_products[0] += r * r;
+                m_products[1] += g * g;
+                m_products[2] += b * b;
+                m_products[3] += r * g;
+                m_products[4] += r * b;
+                m_products[5] += g * b;
+            }
+
+            [[nodiscard]] Moments operator-(const Moments& _other) const
+            {
+                Moments result;
+                result.m_count = m_count - _other.m_count;
+                for (u32 i = 0; i < 3; i++)
+                {
+                    result.m_sums[i] = m_sums[i] - _other.m_sums[i];
+                }
+                for (u32 i = 0; i < 6; i++)
+                {
+                    result.m_products[i] = m_products[i] - _other.m_products[i];
+                }
+                return result;
+            }
+
+            /// Squared distance of the colors to their principal line, which is what two endpoints cannot fix.
+            [[nodiscard]] f32 GetLineError() const
+            {
+                if (m_count <= 1.0f)
+                {
+                    return 0.0f;
+                }
+                const f32 inverseCount = 1.0f / m_count;
+                const f32 rr = m_products[0] - m_sums[0] * m_sums[0] * inverseCount;
+                const f32 gg = m_products[1] - m_sums[1] * m_sums[1] * inverseCount;
+                const f32 bb = m_products[2] - m_sums[2] * m_sums[2] * inverseCount;
+                const f32 rg = m_products[3] - m_sums[0] * m_sums[1] * inverseCount;
+                const f32 rb = m_products[4] - m_sums[0] * m_sums[2] * inverseCount;
+                const f32 gb = m_products[5] - m_sums[1] * m_sums[2] * inverseCount;
+                const f32 trace = rr + gg + bb;
+
+                // Largest eigenvalue by power iteration, which converges fast enough for a ranking.
+                f32 vector[3] = { 1.0f, 1.0f, 1.0f };
+                f32 eigenvalue = 0.0f;
+                for (u32 iteration = 0; iteration < 4; iteration++)
+                {
+                    const f32 next[3] = {
+                        rr * vector[0] + rg * vector[1] + rb * vector[2],
+                        rg * vector[0] + gg * vector[1] + gb * vector[2],
+                        rb * vector[0] + gb * vector[1] + bb * vector[2],
+                    };
+                    const f32 lengthSquared = next[0] * next[0] + next[1] * next[1] + next[2] * next[2];
+                    if (lengthSquared <= 0.0f)
+                    {
+                        return 0.0f;
+                    }
+                    const f32 inverseLength = 1.0f / std::sqrt(lengthSquared);
+                    eigenvalue = (next[0] * vector[0] + next[1] * vector[1] + next[2] * vector[2])
+                        / (vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+                    for (u32 c = 0; c < 3; c++)
+                    {
+                        vector[c] = next[c] * inverseLength;
+                    }
+                }
+                return std::max(0.0f, trace - eigenvalue);
+            }
+        };
+
+        Mode1Block EncodeMode1(const BlockTexels& _texels)
+        {
+            // Fully fitting all 64 partitions is too slow even for high quality, rank them on their line error first.
+            constexpr u32 kCandidateCount = 2;
+            Moments total;
+            for (u32 i = 0; i < 16; i++)
+            {
+                total.Add(_texels.m_values[i]);
+            }
+            std::array<std::pair<f32, u32>, 64> ranking;
+            for (u32 partition = 0; partition < 64; partition++)
+            {
+                Moments subset1;
+                for (u32 mask = kPartitions[partition]; mask != 0; mask &= mask - 1)
+                {
+                    subset1.Add(_texels.m_values[std::countr_zero(mask)]);
+                }
+                ranking[partition] = { (total - subset1).GetLineError() + subset1.GetLineError(), partition };
+            }
+            std::partial_sort(ranking.begin(), ranking.begin() + kCandidateCount, ranking.end());
+
+            Mode1Block best;
+            for (u32 candidate = 0; candidate < kCandidateCount; candidate++)
+            {
+                Mode1Block block;
+                block.m_partition = ranking[candidate].second;
+                Subset subsets[2];
+                SplitPartition(block.m_partition, subsets);
+                for (u32 s = 0; s < 2; s++)
+                {
+                    for (u32 p = 0; p < 2; p++)
+                    {
+                        const u32 previousError = block.m_fits[s].m_error;
+                        FitEndpoints(Mode1Codec { p }, _texels, subsets[s], EncodeQuality::High, block.m_fits[s]);
+                        if (block.m_fits[s].m_error < previousError)
+                        {
+                            block.m_pBits[s] = p;
+                        }
+                    }
+                    SearchEndpoints(Mode1Codec { block.m_pBits[s] }, _texels, subsets[s], block.m_fits[s]);
+                }
+                if (block.GetError() < best.GetError())
+                {
+                    best = block;
+                }
+            }
+            return best;
+        }
+
+        void WriteMode1(Mode1Block _block, u8* _output)
+        {
+            const u32 anchors[2] = { 0, kAnchors[_block.m_partition] };
+            Subset subsets[2];
+            SplitPartition(_block.m_partition, subsets);
+            for (u32 s = 0; s < 2; s++)
+            {
+                EndpointFit& fit = _block.m_fits[s];
+                if (fit.m_indices[anchors[s]] < 4)
+                {
+                    continue;
+                }
+                for (u32 c = 0; c < 3; c++)
+                {
+                    std::swap(fit.m_codes[0][c], fit.m_codes[1][c]);
+                }
+                for (u32 p = 0; p < subsets[s].m_count; p++)
+                {
+                    u8& index = fit.m_indices[subsets[s].m_pixels[p]];
+                    index = u8(7 - index);
+                }
+            }
+
+            BitWriter writer(_output, 16);
+            writer.Write(1 << 1, 2);
+            writer.Write(_block.m_partition, 6);
+            for (u32 c = 0; c < 3; c++)
+            {
+                for (u32 s = 0; s < 2; s++)
+                {
+                    writer.Write(u32(_block.m_fits[s].m_codes[0][c]), 6);
+                    writer.Write(u32(_block.m_fits[s].m_codes[1][c]), 6);
+                }
+            }
+            writer.Write(_block.m_pBits[0], 1);
+            writer.Write(_block.m_pBits[1], 1);
+            for (u32 i = 0; i < 16; i++)
+            {
+                const u32 subset = (kPartitions[_block.m_partition] >> i) & 1;
+                const bool anchor = i == anchors[subset];
+                writer.Write(_block.m_fits[subset].m_indices[i], anchor ? 2 : 3);
+            }
+        }
+    }
+
+    void EncodeBc7(EncodeQuality _quality, const u8* _pixels, u8* _output)
+    {
+        const BlockTexels texels(_pixels);
+        const Mode6Block mode6 = EncodeMode6(_quality, texels);
+
+        bool opaque = true;
+        for (u32 i = 0; i < 16; i++)
+        {
+            opaque &= _pixels[i * 4 + 3] == 255;
+        }
+        // Mode 6 fits alpha too, only compare the color error against mode 1, which has no alpha channel.
+        if (_quality == EncodeQuality::High && opaque && mode6.m_fit.m_error != 0)
+        {
+            const Mode1Block mode1 = EncodeMode1(texels);
+            if (mode1.GetError() < mode6.m_fit.m_error)
+            {
+                WriteMode1(mode1, _output);
+                return;
+            }
+        }
+        WriteMode6(mode6, _output);
+    }
+
+    void DecodeBc7(const u8* _block, u8* _pixels)
+    {
+        BitReader reader(_block);
+        u32 mode = 0;
+        while (mode < 8 && reader.Read(1) == 0)
+        {
+            mode++;
+        }
+
+        if (mode == 6)
+        {
+            s32 endpoints[2][4];
+            for (u32 c = 0; c < 4; c++)
+            {
+                endpoints[0][c] = s32(reader.Read(7)) << 1;
+                endpoints[1][c] = s32(reader.Read(7)) << 1;
+            }
+            const u32 p0 = reader.Read(1);
+            const u32 p1 = reader.Read(1);
+            for (u32 c = 0; c < 4; c++)
+            {
+                endpoints[0][c] |= s32(p0);
+                endpoints[1][c] |= s32(p1);
+            }
+            for (u32 i = 0; i < 16; i++)
+            {
+                const u32 index = reader.Read(i == 0 ? 3 : 4);
+                for (u32 c = 0; c < 4; c++)
+                {
+                    _pixels[i * 4 + c] = u8(Interpolate(endpoints[0][c], endpoints[1][c], kWeights4[index]));
+                }
+            }
+            return;
+        }
+
+        if (mode == 1)
+        {
+            const u32 partition = reader.Read(6);
+            s32 endpoints[4][3];
+            for (u32 c = 0; c < 3; c++)
+            {
+                for (u32 e = 0; e < 4; e++)
+                {
+                    endpoints[e][c] = s32(reader.Read(6)) << 1;
+                }
+            }
+            const u32 pBits[2] = { reader.Read(1), reader.Read(1) };
+            for (u32 e = 0; e < 4; e++)
+            {
+                for (u32 c = 0; c < 3; c++)
+                {
+                    endpoints[e][c] = ReplicateBits(endpoints[e][c] | s32(pBits[e / 2]), 7);
+                }
+            }
+            for (u32 i = 0; i < 16; i++)
+            {
+                const u32 subset = (kPartitions[partition] >> i) & 1;
+                const bool anchor = i == 0 || i == kAnchors[partition];
+                const u32 index = reader.Read(anchor ? 2 : 3);
+                for (u32 c = 0; c < 3; c++)
+                {
+                    _pixels[i * 4 + c] = u8(Interpolate(endpoints[subset * 2][c], endpoints[subset * 2 + 1][c], kWeights3[index]));
+                }
+                _pixels[i * 4 + 3] = 255;
+            }
+            return;
+        }
+
+        // Other modes are never emitted, decode as the error color the specification mandates for reserved modes.
+        std::fill_n(_pixels, kBlockPixelBytes, u8(0));
+    }
+}
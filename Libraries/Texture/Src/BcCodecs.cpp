@@ -0,0 +1,214 @@
+#include "BlockCodecs.hpp"
+
+namespace KryneTools::BlockCodecs
+{
+    namespace
+    {
+        /// RGB 565 endpoints, palette entries at 0, 1, 1/3 and 2/3 (four color mode).
+        struct Bc1Codec
+        {
+            static constexpr u32 kChannelCount = 3;
+
+            [[nodiscard]] u32 GetWeightCount() const { return 4; }
+
+            [[nodiscard]] f32 GetWeight(u32 _index) const
+            {
+                constexpr f32 kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+                return kWeights[_index];
+            }
+
+            [[nodiscard]] static u32 GetBits(u32 _channel) { return _channel == 1 ? 6 : 5; }
+            [[nodiscard]] s32 GetMaxCode(u32 _channel) const { return (1 << GetBits(_channel)) - 1; }
+            [[nodiscard]] s32 Quantize(f32 _value, u32 _channel, u32) const { return QuantizeBits(_value, GetBits(_channel)); }
+            [[nodiscard]] s32 Expand(s32 _code, u32 _channel, u32) const { return ReplicateBits(_code, GetBits(_channel)); }
+
+            [[nodiscard]] s32 Interpolate(s32 _a, s32 _b, u32 _index) const
+            {
+                switch (_index)
+                {
+                case 0: return _a;
+                case 1: return _b;
+                case 2: return (2 * _a + _b) / 3;
+                default: return (_a + 2 * _b) / 3;
+                }
+            }
+        };
+
+        /// Single channel endpoints, palette entries at every seventh (eight value mode).
+        struct Bc4Codec
+        {
+            static constexpr u32 kChannelCount = 1;
+
+            [[nodiscard]] u32 GetWeightCount() const { return 8; }
+
+            [[nodiscard]] f32 GetWeight(u32 _index) const
+            {
+                return _index < 2 ? f32(_index) : f32(_index - 1) / 7.0f;
+            }
+
+            [[nodiscard]] s32 GetMaxCode(u32) const { return 255; }
+            [[nodiscard]] s32 Quantize(f32 _value, u32, u32) const { return s32(_value + 0.5f); }
+            [[nodiscard]] s32 Expand(s32 _code, u32, u32) const { return _code; }
+
+            [[nodiscard]] s32 Interpolate(s32 _a, s32 _b, u32 _index) const
+            {
+                if (_index < 2)
+                {
+                    return _index == 0 ? _a : _b;
+                }
+                return (s32(8 - _index) * _a + s32(_index - 1) * _b + 3) / 7;
+            }
+        };
+
+        u16 PackRgb565(const s32 _codes[4])
+        {
+            return u16((_codes[0] << 11) | (_codes[1] << 5) | _codes[2]);
+        }
+    }
+
+    void EncodeBc1(EncodeQuality _quality, const u8* _pixels, u8* _output)
+    {
+        const BlockTexels texels(_pixels);
+        const Bc1Codec codec;
+        EndpointFit fit;
+        FitEndpoints(codec, texels, Subset::All(), _quality, fit);
+        if (_quality == EncodeQuality::High)
+        {
+            SearchEndpoints(codec, texels, Subset::All(), fit);
+        }
+
+        // The four color mode is selected by c0 > c1. Swapping the endpoints mirrors the palette, and equal endpoints
+        // make every four color mode entry the same color, index 0 representing it in both modes.
+        u16 color0 = PackRgb565(fit.m_codes[0]);
+        u16 color1 = PackRgb565(fit.m_codes[1]);
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+            for (u8& index: fit.m_indices)
+            {
+                index ^= 1;
+            }
+        }
+        else if (color0 == color1)
+        {
+            std::fill(std::begin(fit.m_indices), std::end(fit.m_indices), u8(0));
+        }
+
+        BitWriter writer(_output, 8);
+        writer.Write(color0, 16);
+        writer.Write(color1, 16);
+        for (const u8 index: fit.m_indices)
+        {
+            writer.Write(index, 2);
+        }
+    }
+
+    void EncodeBc4(EncodeQuality _quality, const u8* _pixels, u32 _channel, u8* _output)
+    {
+        u8 channel[kBlockPixelBytes] = {};
+        for (u32 i = 0; i < 16; i++)
+        {
+            channel[i * 4] = _pixels[i * 4 + _channel];
+        }
+        const BlockTexels texels(channel);
+        const Bc4Codec codec;
+        EndpointFit fit;
+        FitEndpoints(codec, texels, Subset::All(), _quality, fit);
+        if (_quality == EncodeQuality::High)
+        {
+            SearchEndpoints(codec, texels, Subset::All(), fit);
+        }
+
+        // The eight value mode is selected by e0 > e1, mirror the palette like BC1 does.
+        s32 endpoint0 = fit.m_codes[0][0];
+        s32 endpoint1 = fit.m_codes[1][0];
+        if (endpoint0 < endpoint1)
+        {
+            std::swap(endpoint0, endpoint1);
+            for (u8& index: fit.m_indices)
+            {
+                index = index < 2 ? index ^ 1 : u8(9 - index);
+            }
+        }
+        else if (endpoint0 == endpoint1)
+        {
+            std::fill(std::begin(fit.m_indices), std::end(fit.m_indices), u8(0));
+        }
+
+        BitWriter writer(_output, 8);
+        writer.Write(u32(endpoint0), 8);
+        writer.Write(u32(endpoint1), 8);
+        for (const u8 index: fit.m_indices)
+        {
+            writer.Write(index, 3);
+        }
+    }
+
+    void DecodeBc1(const u8* _block, u8* _pixels)
+    {
+        BitReader reader(_block);
+        const u32 color0 = reader.Read(16);
+        const u32 color1 = reader.Read(16);
+
+        s32 palette[4][4];
+        const u32 colors[2] = { color0, color1 };
+        for (u32 e = 0; e < 2; e++)
+        {
+            palette[e][0] = ReplicateBits(s32(colors[e] >> 11), 5);
+            palette[e][1] = ReplicateBits(s32((colors[e] >> 5) & 0x3F), 6);
+            palette[e][2] = ReplicateBits(s32(colors[e] & 0x1F), 5);
+            palette[e][3] = 255;
+        }
+        const Bc1Codec codec;
+        for (u32 c = 0; c < 3; c++)
+        {
+            if (color0 > color1)
+            {
+                palette[2][c] = codec.Interpolate(palette[0][c], palette[1][c], 2);
+                palette[3][c] = codec.Interpolate(palette[0][c], palette[1][c], 3);
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = color0 > color1 ? 255 : 0;
+
+        for (u32 i = 0; i < 16; i++)
+        {
+            const u32 index = reader.Read(2);
+            for (u32 c = 0; c < 4; c++)
+            {
+                _pixels[i * 4 + c] = u8(palette[index][c]);
+            }
+        }
+    }
+
+    void DecodeBc4(const u8* _block, u32 _channel, u8* _pixels)
+    {
+        BitReader reader(_block);
+        const s32 endpoint0 = s32(reader.Read(8));
+        const s32 endpoint1 = s32(reader.Read(8));
+
+        s32 palette[8] = { endpoint0, endpoint1 };
+        const Bc4Codec codec;
+        for (u32 i = 2; i < 8; i++)
+        {
+            if (endpoint0 > endpoint1)
+            {
+                palette[i] = codec.Interpolate(endpoint0, endpoint1, i);
+            }
+            else
+            {
+                // Six value mode, with explicit 0 and 255 entries.
+                palette[i] = i < 6 ? (s32(6 - i) * endpoint0 + s32(i - 1) * endpoint1 + 2) / 5 : (i == 6 ? 0 : 255);
+            }
+        }
+        for (u32 i = 0; i < 16; i++)
+        {
+            _pixels[i * 4 + _channel] = u8(palette[reader.Read(3)]);
+        }
+    }
+}
@@ -0,0 +1,491 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "KryneTools/Texture/BlockCompression.hpp"
+
+/**
+ * @file
+ * Shared between the block encoders: bit packing, and the endpoint fit every format runs per subset.
+ *
+ * A codec describes the endpoint precision and the palette of a format to `FitEndpoints()`:
+ *
+ *  - `kChannelCount`, the channels fitted (1 to 4).
+ *  - `GetWeightCount()`, the palette entries between the two endpoints, and `GetWeight(index)`, the position of an
+ *    entry along the segment in [0, 1].
+ *  - `Quantize(value, channel, endpoint)` and `Expand(code, channel, endpoint)`, between 8 bits values and the codes
+ *    stored in the block. Codes are ordered like the values they expand to, and `GetMaxCode(channel)` bounds them.
+ *  - `Interpolate(a, b, index)`, the exact palette entry the decoder computes from two expanded values.
+ */
+namespace KryneTools::BlockCodecs
+{
+    /// Little endian bit stream over one block, bit 0 being the least significant bit of byte 0.
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(u8* _output, u32 _byteCount)
+            : m_output(_output)
+        {
+            std::fill_n(_output, _byteCount, u8(0));
+        }
+
+        void Write(u32 _value, u32 _bitCount)
+        {
+            for (u32 i = 0; i < _bitCount; i++, m_position++)
+            {
+                m_output[m_position >> 3] |= u8(((_value >> i) & 1) << (m_position & 7));
+            }
+        }
+
+        [[nodiscard]] u32 GetPosition() const { return m_position; }
+
+    private:
+        u8* m_output;
+        u32 m_position = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        explicit BitReader(const u8* _data)
+            : m_data(_data)
+        {}
+
+        u32 Read(u32 _bitCount)
+        {
+            u32 value = 0;
+            for (u32 i = 0; i < _bitCount; i++, m_position++)
+            {
+                value |= u32((m_data[m_position >> 3] >> (m_position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+        void Seek(u32 _position) { m_position = _position; }
+
+    private:
+        const u8* m_data;
+        u32 m_position = 0;
+    };
+
+    /// Texels of a block widened for the fit arithmetic, in raster order.
+    struct BlockTexels
+    {
+        s32 m_values[16][4];
+
+        explicit BlockTexels(const u8* _pixels)
+        {
+            for (u32 i = 0; i < 16; i++)
+            {
+                for (u32 c = 0; c < 4; c++)
+                {
+                    m_values[i][c] = _pixels[i * 4 + c];
+                }
+            }
+        }
+    };
+
+    /// Pixels of one subset, as indices into the block.
+    struct Subset
+    {
+        u8 m_pixels[16];
+        u32 m_count = 0;
+
+        static Subset All()
+        {
+            Subset subset;
+            for (u32 i = 0; i < 16; i++)
+            {
+                subset.m_pixels[subset.m_count++] = u8(i);
+            }
+            return subset;
+        }
+    };
+
+    struct EndpointFit
+    {
+        s32 m_codes[2][4] = {};
+        /// Palette index of each pixel of the block, only set for the pixels of the fitted subset.
+        u8 m_indices[16] = {};
+        u32 m_error = std::numeric_limits<u32>::max();
+    };
+
+    /**
+     * @brief Picks the palette entry of every pixel of the subset and measures the squared error.
+     * @param _exhaustive Also tests the entries next to the projection of each pixel on the segment, which finds the
+     * best one even when the quantized endpoints drift off the color line. Otherwise only the projection is used.
+     */
+    template <class Codec>
+    void AssignIndices(const Codec& _codec, const BlockTexels& _texels, const Subset& _subset, bool _exhaustive, EndpointFit& _fit)
+    {
+        constexpr u32 kChannels = Codec::kChannelCount;
+        const u32 weightCount = _codec.GetWeightCount();
+
+        s32 expanded[2][kChannels];
+        for (u32 e = 0; e < 2; e++)
+        {
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                expanded[e][c] = _codec.Expand(_fit.m_codes[e][c], c, e);
+            }
+        }
+        s32 palette[32][kChannels];
+        f32 weights[32];
+        for (u32 i = 0; i < weightCount; i++)
+        {
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                palette[i][c] = _codec.Interpolate(expanded[0][c], expanded[1][c], i);
+            }
+            weights[i] = _codec.GetWeight(i);
+        }
+        // Entries sorted along the segment, the codec order is not monotonic for BC1 and BC4.
+        u8 order[32];
+        for (u32 i = 0; i < weightCount; i++)
+        {
+            order[i] = u8(i);
+        }
+        std::sort(order, order + weightCount, [&weights](u8 _a, u8 _b) { return weights[_a] < weights[_b]; });
+
+        const auto distance = [&](const s32* _pixel, u32 _index)
+        {
+            u32 error = 0;
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                const s32 delta = _pixel[c] - palette[_index][c];
+                error += u32(delta * delta);
+            }
+            return error;
+        };
+
+        s32 direction[kChannels];
+        s32 lengthSquared = 0;
+        for (u32 c = 0; c < kChannels; c++)
+        {
+            direction[c] = expanded[1][c] - expanded[0][c];
+            lengthSquared += direction[c] * direction[c];
+        }
+        const f32 inverseLength = lengthSquared == 0 ? 0.0f : 1.0f / f32(lengthSquared);
+
+        u32 error = 0;
+        for (u32 p = 0; p < _subset.m_count; p++)
+        {
+            const u32 pixelIndex = _subset.m_pixels[p];
+            const s32* pixel = _texels.m_values[pixelIndex];
+
+            s32 dot = 0;
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                dot += (pixel[c] - expanded[0][c]) * direction[c];
+            }
+            const f32 t = f32(dot) * inverseLength;
+            u32 nearest = 0;
+            while (nearest + 1 < weightCount && weights[order[nearest + 1]] <= t)
+            {
+                nearest++;
+            }
+            if (nearest + 1 < weightCount && t - weights[order[nearest]] > weights[order[nearest + 1]] - t)
+            {
+                nearest++;
+            }
+
+            u32 bestIndex = order[nearest];
+            u32 bestError = distance(pixel, bestIndex);
+            if (_exhaustive)
+            {
+                const u32 first = nearest == 0 ? 0 : nearest - 1;
+                const u32 last = std::min(weightCount - 1, nearest + 1);
+                for (u32 i = first; i <= last; i++)
+                {
+                    const u32 candidate = distance(pixel, order[i]);
+                    if (candidate < bestError)
+                    {
+                        bestError = candidate;
+                        bestIndex = order[i];
+                    }
+                }
+            }
+            _fit.m_indices[pixelIndex] = u8(bestIndex);
+            error += bestError;
+        }
+        _fit.m_error = error;
+    }
+
+    template <class Codec>
+    void QuantizeEndpoints(const Codec& _codec, const f32 _endpoints[2][4], EndpointFit& _fit)
+    {
+        for (u32 e = 0; e < 2; e++)
+        {
+            for (u32 c = 0; c < Codec::kChannelCount; c++)
+            {
+                _fit.m_codes[e][c] = _codec.Quantize(std::clamp(_endpoints[e][c], 0.0f, 255.0f), c, e);
+            }
+        }
+    }
+
+    /**
+     * @brief Least squares endpoints for the current palette indices.
+     * @return `false` when every pixel uses the same entry, the system being singular.
+     */
+    template <class Codec>
+    bool SolveEndpoints(const Codec& _codec, const BlockTexels& _texels, const Subset& _subset, const EndpointFit& _fit, f32 _endpoints[2][4])
+    {
+        constexpr u32 kChannels = Codec::kChannelCount;
+        f32 a = 0.0f;
+        f32 b = 0.0f;
+        f32 c = 0.0f;
+        f32 d0[kChannels] = {};
+        f32 d1[kChannels] = {};
+        for (u32 p = 0; p < _subset.m_count; p++)
+        {
+            const u32 pixelIndex = _subset.m_pixels[p];
+            const f32 weight = _codec.GetWeight(_fit.m_indices[pixelIndex]);
+            const f32 inverse = 1.0f - weight;
+            a += inverse * inverse;
+            b += inverse * weight;
+            c += weight * weight;
+            for (u32 channel = 0; channel < kChannels; channel++)
+            {
+                const f32 value = f32(_texels.m_values[pixelIndex][channel]);
+                d0[channel] += inverse * value;
+                d1[channel] += weight * value;
+            }
+        }
+        const f32 determinant = a * c - b * b;
+        if (std::abs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        const f32 inverseDeterminant = 1.0f / determinant;
+        for (u32 channel = 0; channel < kChannels; channel++)
+        {
+            _endpoints[0][channel] = (c * d0[channel] - b * d1[channel]) * inverseDeterminant;
+            _endpoints[1][channel] = (a * d1[channel] - b * d0[channel]) * inverseDeterminant;
+        }
+        return true;
+    }
+
+    /// Mean and principal axis (unit length, or zero for a flat subset) of the subset colors.
+    template <u32 kChannels>
+    void ComputePrincipalAxis(const BlockTexels& _texels, const Subset& _subset, f32 _mean[4], f32 _axis[4])
+    {
+        for (u32 c = 0; c < 4; c++)
+        {
+            _mean[c] = 0.0f;
+            _axis[c] = 0.0f;
+        }
+        for (u32 p = 0; p < _subset.m_count; p++)
+        {
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                _mean[c] += f32(_texels.m_values[_subset.m_pixels[p]][c]);
+            }
+        }
+        for (u32 c = 0; c < kChannels; c++)
+        {
+            _mean[c] /= f32(_subset.m_count);
+        }
+
+        f32 covariance[kChannels][kChannels] = {};
+        for (u32 p = 0; p < _subset.m_count; p++)
+        {
+            f32 delta[kChannels];
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                delta[c] = f32(_texels.m_values[_subset.m_pixels[p]][c]) - _mean[c];
+            }
+            for (u32 i = 0; i < kChannels; i++)
+            {
+                for (u32 j = 0; j < kChannels; j++)
+                {
+                    covariance[i][j] += delta[i] * delta[j];
+                }
+            }
+        }
+
+        // Power iteration, seeded with the widest channel so it cannot start orthogonal to the answer.
+        u32 widest = 0;
+        for (u32 c = 1; c < kChannels; c++)
+        {
+            widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+        }
+        if (covariance[widest][widest] <= 0.0f)
+        {
+            return;
+        }
+        f32 vector[kChannels];
+        for (u32 c = 0; c < kChannels; c++)
+        {
+            vector[c] = covariance[widest][c];
+        }
+        for (u32 iteration = 0; iteration < 8; iteration++)
+        {
+            f32 next[kChannels] = {};
+            f32 length = 0.0f;
+            for (u32 i = 0; i < kChannels; i++)
+            {
+                for (u32 j = 0; j < kChannels; j++)
+                {
+                    next[i] += covariance[i][j] * vector[j];
+                }
+                length = std::max(length, std::abs(next[i]));
+            }
+            if (length <= 0.0f)
+            {
+                return;
+            }
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                vector[c] = next[c] / length;
+            }
+        }
+        f32 length = 0.0f;
+        for (u32 c = 0; c < kChannels; c++)
+        {
+            length += vector[c] * vector[c];
+        }
+        length = std::sqrt(length);
+        for (u32 c = 0; c < kChannels; c++)
+        {
+            _axis[c] = vector[c] / length;
+        }
+    }
+
+    /**
+     * @brief Fits two endpoints to the subset and assigns the palette indices, keeping the result in `_fit` if it
+     * beats what `_fit` already holds.
+     *
+     * @details
+     * Starts from the extent of the subset along its principal axis, then alternates least squares endpoint solves and
+     * index assignments while the error decreases. High quality iterates more, and assigns indices exhaustively.
+     */
+    template <class Codec>
+    void FitEndpoints(const Codec& _codec, const BlockTexels& _texels, const Subset& _subset, EncodeQuality _quality, EndpointFit& _fit)
+    {
+        constexpr u32 kChannels = Codec::kChannelCount;
+        const bool high = _quality == EncodeQuality::High;
+
+        f32 mean[4];
+        f32 axis[4];
+        ComputePrincipalAxis<kChannels>(_texels, _subset, mean, axis);
+        f32 minimum = 0.0f;
+        f32 maximum = 0.0f;
+        for (u32 p = 0; p < _subset.m_count; p++)
+        {
+            f32 t = 0.0f;
+            for (u32 c = 0; c < kChannels; c++)
+            {
+                t += (f32(_texels.m_values[_subset.m_pixels[p]][c]) - mean[c]) * axis[c];
+            }
+            minimum = std::min(minimum, t);
+            maximum = std::max(maximum, t);
+        }
+        f32 endpoints[2][4];
+        for (u32 c = 0; c < kChannels; c++)
+        {
+            endpoints[0][c] = mean[c] + minimum * axis[c];
+            endpoints[1][c] = mean[c] + maximum * axis[c];
+        }
+
+        EndpointFit best;
+        QuantizeEndpoints(_codec, endpoints, best);
+        AssignIndices(_codec, _texels, _subset, high, best);
+
+        const u32 refinements = high ? 4 : 1;
+        for (u32 iteration = 0; iteration < refinements && best.m_error != 0; iteration++)
+        {
+            if (!SolveEndpoints(_codec, _texels, _subset, best, endpoints))
+            {
+                break;
+            }
+            EndpointFit candidate = best;
+            QuantizeEndpoints(_codec, endpoints, candidate);
+            AssignIndices(_codec, _texels, _subset, high, candidate);
+            if (candidate.m_error >= best.m_error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+
+        if (best.m_error < _fit.m_error)
+        {
+            for (u32 p = 0; p < _subset.m_count; p++)
+            {
+                _fit.m_indices[_subset.m_pixels[p]] = best.m_indices[_subset.m_pixels[p]];
+            }
+            std::copy_n(&best.m_codes[0][0], 8, &_fit.m_codes[0][0]);
+            _fit.m_error = best.m_error;
+        }
+    }
+
+    /**
+     * @brief Greedy search around a fit of the same codec, moving one endpoint code by one step at a time while it
+     * lowers the error. Too slow to run on every candidate, encoders apply it to their best one in high quality.
+     */
+    template <class Codec>
+    void SearchEndpoints(const Codec& _codec, const BlockTexels& _texels, const Subset& _subset, EndpointFit& _fit)
+    {
+        for (u32 pass = 0; pass < 2 && _fit.m_error != 0; pass++)
+        {
+            bool improved = false;
+            for (u32 e = 0; e < 2; e++)
+            {
+                for (u32 c = 0; c < Codec::kChannelCount; c++)
+                {
+                    for (const s32 step: { -1, 1 })
+                    {
+                        const s32 code = _fit.m_codes[e][c] + step;
+                        if (code < 0 || code > _codec.GetMaxCode(c))
+                        {
+                            continue;
+                        }
+                        EndpointFit candidate = _fit;
+                        candidate.m_codes[e][c] = code;
+                        AssignIndices(_codec, _texels, _subset, true, candidate);
+                        if (candidate.m_error < _fit.m_error)
+                        {
+                            _fit = candidate;
+                            improved = true;
+                        }
+                    }
+                }
+            }
+            if (!improved)
+            {
+                break;
+            }
+        }
+    }
+
+    /// Linear quantization of 8 bits values to `_bits` bits, rounding to nearest.
+    inline s32 QuantizeBits(f32 _value, u32 _bits)
+    {
+        const s32 maximum = (1 << _bits) - 1;
+        return std::clamp(s32(_value * f32(maximum) / 255.0f + 0.5f), 0, maximum);
+    }
+
+    /// Expands `_bits` bits values to 8 bits by replicating their high bits, like the decoders do.
+    inline s32 ReplicateBits(s32 _value, u32 _bits)
+    {
+        s32 result = _value << (8 - _bits);
+        for (u32 shift = _bits; shift < 8; shift += _bits)
+        {
+            result |= result >> shift;
+        }
+        return result;
+    }
+
+    void EncodeBc1(EncodeQuality _quality, const u8* _pixels, u8* _output);
+    void EncodeBc4(EncodeQuality _quality, const u8* _pixels, u32 _channel, u8* _output);
+    void EncodeBc7(EncodeQuality _quality, const u8* _pixels, u8* _output);
+    void EncodeAstc(EncodeQuality _quality, const u8* _pixels, u8* _output);
+
+    void DecodeBc1(const u8* _block, u8* _pixels);
+    void DecodeBc4(const u8* _block, u32 _channel, u8* _pixels);
+    void DecodeBc7(const u8* _block, u8* _pixels);
+    void DecodeAstc(const u8* _block, u8* _pixels);
+}
@@ -0,0 +1,109 @@
+#include "KryneTools/Texture/BlockCompression.hpp"
+
+#include "BlockCodecs.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        struct FormatName
+        {
+            TextureFormat m_format;
+            const char* m_name;
+        };
+
+        constexpr FormatName kFormatNames[] = {
+            { TextureFormat::Bc1, "bc1" },
+            { TextureFormat::Bc3, "bc3" },
+            { TextureFormat::Bc4, "bc4" },
+            { TextureFormat::Bc5, "bc5" },
+            { TextureFormat::Bc7, "bc7" },
+            { TextureFormat::Astc4x4, "astc" },
+        };
+    }
+
+    const char* GetTextureFormatName(TextureFormat _format)
+    {
+        for (const FormatName& entry: kFormatNames)
+        {
+            if (entry.m_format == _format)
+            {
+                return entry.m_name;
+            }
+        }
+        return "unknown";
+    }
+
+    std::optional<TextureFormat> ParseTextureFormat(std::string_view _name)
+    {
+        for (const FormatName& entry: kFormatNames)
+        {
+            if (_name == entry.m_name)
+            {
+                return entry.m_format;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void EncodeBlock(TextureFormat _format, EncodeQuality _quality, const u8* _pixels, u8* _output)
+    {
+        switch (_format)
+        {
+        case TextureFormat::Bc1:
+            BlockCodecs::EncodeBc1(_quality, _pixels, _output);
+            break;
+        case TextureFormat::Bc3:
+            BlockCodecs::EncodeBc4(_quality, _pixels, 3, _output);
+            BlockCodecs::EncodeBc1(_quality, _pixels, _output + 8);
+            break;
+        case TextureFormat::Bc4:
+            BlockCodecs::EncodeBc4(_quality, _pixels, 0, _output);
+            break;
+        case TextureFormat::Bc5:
+            BlockCodecs::EncodeBc4(_quality, _pixels, 0, _output);
+            BlockCodecs::EncodeBc4(_quality, _pixels, 1, _output + 8);
+            break;
+        case TextureFormat::Bc7:
+            BlockCodecs::EncodeBc7(_quality, _pixels, _output);
+            break;
+        case TextureFormat::Astc4x4:
+            BlockCodecs::EncodeAstc(_quality, _pixels, _output);
+            break;
+        }
+    }
+
+    void DecodeBlock(TextureFormat _format, const u8* _block, u8* _pixels)
+    {
+        switch (_format)
+        {
+        case TextureFormat::Bc1:
+            BlockCodecs::DecodeBc1(_block, _pixels);
+            break;
+        case TextureFormat::Bc3:
+            BlockCodecs::DecodeBc1(_block + 8, _pixels);
+            BlockCodecs::DecodeBc4(_block, 3, _pixels);
+            break;
+        case TextureFormat::Bc4:
+        case TextureFormat::Bc5:
+            for (u32 i = 0; i < 16; i++)
+            {
+                _pixels[i * 4 + 1] = 0;
+                _pixels[i * 4 + 2] = 0;
+                _pixels[i * 4 + 3] = 255;
+            }
+            BlockCodecs::DecodeBc4(_block, 0, _pixels);
+            if (_format == TextureFormat::Bc5)
+            {
+                BlockCodecs::DecodeBc4(_block + 8, 1, _pixels);
+            }
+            break;
+        case TextureFormat::Bc7:
+            BlockCodecs::DecodeBc7(_block, _pixels);
+            break;
+        case TextureFormat::Astc4x4:
+            BlockCodecs::DecodeAstc(_block, _pixels);
+            break;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "KryneTools/Texture/TextureWriter.hpp"
+
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Texture/TextureCompressor.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        namespace Dds
+        {
+            constexpr u32 kMagic = MakeFourCC('D', 'D', 'S', ' ');
+
+            constexpr u32 kFlagCaps = 0x1;
+            constexpr u32 kFlagHeight = 0x2;
+            constexpr u32 kFlagWidth = 0x4;
+            constexpr u32 kFlagPixelFormat = 0x1000;
+            constexpr u32 kFlagMipMapCount = 0x20000;
+            constexpr u32 kFlagLinearSize = 0x80000;
+            constexpr u32 kPixelFormatFourCC = 0x4;
+            constexpr u32 kCapsComplex = 0x8;
+            constexpr u32 kCapsTexture = 0x1000;
+            constexpr u32 kCapsMipMap = 0x400000;
+            constexpr u32 kDimensionTexture2D = 3;
+
+            struct PixelFormat
+            {
+                u32 m_size;
+                u32 m_flags;
+                u32 m_fourCC;
+                u32 m_rgbBitCount;
+                u32 m_masks[4];
+            };
+
+            struct Header
+            {
+                u32 m_size;
+                u32 m_flags;
+                u32 m_height;
+                u32 m_width;
+                u32 m_pitchOrLinearSize;
+                u32 m_depth;
+                u32 m_mipMapCount;
+                u32 m_reserved1[11];
+                PixelFormat m_pixelFormat;
+                u32 m_caps[4];
+                u32 m_reserved2;
+            };
+            static_assert(sizeof(Header) == 124);
+
+            struct HeaderDx10
+            {
+                u32 m_dxgiFormat;
+                u32 m_resourceDimension;
+                u32 m_miscFlags;
+                u32 m_arraySize;
+                u32 m_miscFlags2;
+            };
+        }
+
+        u32 GetDxgiFormat(TextureFormat _format, bool _srgb)
+        {
+            switch (_format)
+            {
+            case TextureFormat::Bc1: return _srgb ? 72 : 71;
+            case TextureFormat::Bc3: return _srgb ? 78 : 77;
+            case TextureFormat::Bc4: return 80;
+            case TextureFormat::Bc5: return 83;
+            case TextureFormat::Bc7: return _srgb ? 99 : 98;
+            case TextureFormat::Astc4x4: return _srgb ? 135 : 134;
+            }
+            return 0;
+        }
+    }
+
+    void WriteDds(const std::filesystem::path& _path, const CompressedTexture& _texture)
+    {
+        KT_TRACE_ZONE_DETAIL("WriteDds", _path.string());
+        Dds::Header header {};
+        header.m_size = sizeof(Dds::Header);
+        header.m_flags = Dds::kFlagCaps | Dds::kFlagHeight | Dds::kFlagWidth | Dds::kFlagPixelFormat | Dds::kFlagMipMapCount | Dds::kFlagLinearSize;
+        header.m_height = _texture.m_height;
+        header.m_width = _texture.m_width;
+        header.m_pitchOrLinearSize = _texture.m_mips.empty() ? 0 : u32(_texture.m_mips.front().m_size);
+        header.m_mipMapCount = u32(_texture.m_mips.size());
+        header.m_pixelFormat.m_size = sizeof(Dds::PixelFormat);
+        header.m_pixelFormat.m_flags = Dds::kPixelFormatFourCC;
+        header.m_pixelFormat.m_fourCC = MakeFourCC('D', 'X', '1', '0');
+        header.m_caps[0] = Dds::kCapsTexture | (_texture.m_mips.size() > 1 ? Dds::kCapsComplex | Dds::kCapsMipMap : 0);
+
+        Dds::HeaderDx10 headerDx10 {};
+        headerDx10.m_dxgiFormat = GetDxgiFormat(_texture.m_format, _texture.m_srgb);
+        headerDx10.m_resourceDimension = Dds::kDimensionTexture2D;
+        headerDx10.m_arraySize = 1;
+
+        FileWriter writer(_path);
+        writer.WritePod(Dds::kMagic);
+        writer.WritePod(header);
+        writer.WritePod(headerDx10);
+        writer.WriteSpan(std::span<const u8>(_texture.m_data));
+        writer.Commit();
+    }
+}
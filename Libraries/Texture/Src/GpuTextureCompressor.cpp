@@ -0,0 +1,659 @@
+#include "KryneTools/Texture/GpuTextureCompressor.hpp"
+
+#include "KryneTools/Common/Error.hpp"
+
+#if defined(KRYNE_TOOLS_HAS_VULKAN)
+#   include <algorithm>
+#   include <array>
+#   include <cmath>
+#   include <cstdint>
+#   include <cstring>
+#   include <mutex>
+#   include <span>
+#   include <vector>
+
+#   include <vulkan/vulkan.h>
+
+#   include "KryneTools/Common/Log.hpp"
+#   include "KryneTools/Common/Trace.hpp"
+#   include "Shaders/BlockEncode.spv.h"
+#   include "Shaders/MipDownsample.spv.h"
+#endif
+
+namespace KryneTools
+{
+#if defined(KRYNE_TOOLS_HAS_VULKAN)
+    namespace
+    {
+        /// Encoder pipelines, indexed by `TextureFormat` up to BC7.
+        constexpr TextureFormat kGpuFormats[] = { TextureFormat::Bc1, TextureFormat::Bc3, TextureFormat::Bc4, TextureFormat::Bc5, TextureFormat::Bc7 };
+
+        constexpr u32 kGroupSize = 8;
+        constexpr u32 kMipFlagSrgb = 1;
+        constexpr u32 kMipFlagNormalMap = 2;
+
+        /// Push constants of MipDownsample.comp.
+        struct MipConstants
+        {
+            u32 m_sourceWidth;
+            u32 m_sourceHeight;
+            u32 m_width;
+            u32 m_height;
+            u32 m_sourceOffset;
+            u32 m_offset;
+            u32 m_flags;
+        };
+
+        /// Push constants of BlockEncode.comp.
+        struct EncodeConstants
+        {
+            u32 m_width;
+            u32 m_height;
+            u32 m_blocksX;
+            u32 m_blocksY;
+            u32 m_texelOffset;
+            u32 m_blockOffset;
+        };
+
+        void CheckVulkan(VkResult _result, const char* _operation)
+        {
+            if (_result != VK_SUCCESS)
+            {
+                ThrowError("%s failed (VkResult %d)", _operation, int(_result));
+            }
+        }
+
+        u32 FindMemoryType(const VkPhysicalDeviceMemoryProperties& _properties, u32 _typeBits, VkMemoryPropertyFlags _required, VkMemoryPropertyFlags _preferred)
+        {
+            u32 found = ~0u;
+            for (u32 i = 0; i < _properties.memoryTypeCount; i++)
+            {
+                const VkMemoryPropertyFlags flags = _properties.memoryTypes[i].propertyFlags;
+                if ((_typeBits & (1u << i)) == 0 || (flags & _required) != _required)
+                {
+                    continue;
+                }
+                if ((flags & _preferred) == _preferred)
+                {
+                    return i;
+                }
+                found = found == ~0u ? i : found;
+            }
+            KT_VERIFY(found != ~0u, "No Vulkan memory type with properties 0x%x", u32(_required));
+            return found;
+        }
+
+        /// Buffer with its own allocation, mapped when host visible.
+        class DeviceBuffer
+        {
+        public:
+            DeviceBuffer(
+                VkDevice _device,
+                const VkPhysicalDeviceMemoryProperties& _properties,
+                VkDeviceSize _size,
+                VkBufferUsageFlags _usage,
+                VkMemoryPropertyFlags _required,
+                VkMemoryPropertyFlags _preferred = 0)
+                : m_device(_device)
+            {
+                VkBufferCreateInfo info {};
+                info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+                info.size = _size;
+                info.usage = _usage;
+                info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                CheckVulkan(vkCreateBuffer(m_device, &info, nullptr, &m_buffer), "vkCreateBuffer");
+
+                try
+                {
+                    VkMemoryRequirements requirements;
+                    vkGetBufferMemoryRequirements(m_device, m_buffer, &requirements);
+                    VkMemoryAllocateInfo allocation {};
+                    allocation.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+                    allocation.allocationSize = requirements.size;
+                    allocation.memoryTypeIndex = FindMemoryType(_properties, requirements.memoryTypeBits, _required, _preferred);
+                    CheckVulkan(vkAllocateMemory(m_device, &allocation, nullptr, &m_memory), "vkAllocateMemory");
+                    CheckVulkan(vkBindBufferMemory(m_device, m_buffer, m_memory, 0), "vkBindBufferMemory");
+                    if ((_required & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
+                    {
+                        CheckVulkan(vkMapMemory(m_device, m_memory, 0, VK_WHOLE_SIZE, 0, &m_mapped), "vkMapMemory");
+                    }
+                }
+                catch (...)
+                {
+                    Release();
+                    throw;
+                }
+            }
+
+            ~DeviceBuffer()
+            {
+                Release();
+            }
+
+            DeviceBuffer(const DeviceBuffer&) = delete;
+            DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+
+            [[nodiscard]] VkBuffer Get() const { return m_buffer; }
+            [[nodiscard]] void* GetMapped() const { return m_mapped; }
+
+        private:
+            VkDevice m_device;
+            VkBuffer m_buffer = VK_NULL_HANDLE;
+            VkDeviceMemory m_memory = VK_NULL_HANDLE;
+            void* m_mapped = nullptr;
+
+            void Release()
+            {
+                // Freeing the memory unmaps it.
+                vkDestroyBuffer(m_device, m_buffer, nullptr);
+                vkFreeMemory(m_device, m_memory, nullptr);
+                m_buffer = VK_NULL_HANDLE;
+                m_memory = VK_NULL_HANDLE;
+            }
+        };
+
+        void AddMemoryBarrier(VkCommandBuffer _commands, VkPipelineStageFlags _sourceStage, VkAccessFlags _sourceAccess, VkPipelineStageFlags _destinationStage, VkAccessFlags _destinationAccess)
+        {
+            VkMemoryBarrier barrier {};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = _sourceAccess;
+            barrier.dstAccessMask = _destinationAccess;
+            vkCmdPipelineBarrier(_commands, _sourceStage, _destinationStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+
+        /// Level of the chain in the texel buffer, and its blocks in the output.
+        struct GpuLevel
+        {
+            u32 m_width;
+            u32 m_height;
+            u32 m_blocksX;
+            u32 m_blocksY;
+            u64 m_texelOffset;
+        };
+    }
+
+    struct GpuTextureCompressor::Device
+    {
+        VkInstance m_instance = VK_NULL_HANDLE;
+        VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+        VkPhysicalDeviceProperties m_properties {};
+        VkPhysicalDeviceMemoryProperties m_memoryProperties {};
+        u32 m_queueFamily = 0;
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkQueue m_queue = VK_NULL_HANDLE;
+        VkCommandPool m_commandPool = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkShaderModule m_mipModule = VK_NULL_HANDLE;
+        VkShaderModule m_encodeModule = VK_NULL_HANDLE;
+        VkPipeline m_mipPipeline = VK_NULL_HANDLE;
+        std::array<VkPipeline, std::size(kGpuFormats)> m_encodePipelines {};
+        std::unique_ptr<DeviceBuffer> m_srgbTable;
+        std::string m_name;
+        std::string m_key;
+        /// Serializes cooks, which share the command pool and the queue.
+        std::mutex m_mutex;
+
+        ~Device()
+        {
+            if (m_device != VK_NULL_HANDLE)
+            {
+                vkDeviceWaitIdle(m_device);
+                m_srgbTable.reset();
+                for (const VkPipeline pipeline: m_encodePipelines)
+                {
+                    vkDestroyPipeline(m_device, pipeline, nullptr);
+                }
+                vkDestroyPipeline(m_device, m_mipPipeline, nullptr);
+                vkDestroyShaderModule(m_device, m_encodeModule, nullptr);
+                vkDestroyShaderModule(m_device, m_mipModule, nullptr);
+                vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+                vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+                vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+                vkDestroyDevice(m_device, nullptr);
+            }
+            vkDestroyInstance(m_instance, nullptr);
+        }
+
+        void CreateInstance()
+        {
+            VkApplicationInfo application {};
+            application.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+            application.pApplicationName = "kryne-texcook";
+            application.apiVersion = VK_API_VERSION_1_1;
+            VkInstanceCreateInfo info {};
+            info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+            info.pApplicationInfo = &application;
+            CheckVulkan(vkCreateInstance(&info, nullptr, &m_instance), "vkCreateInstance");
+        }
+
+        void SelectPhysicalDevice(std::optional<u32> _index)
+        {
+            u32 count = 0;
+            CheckVulkan(vkEnumeratePhysicalDevices(m_instance, &count, nullptr), "vkEnumeratePhysicalDevices");
+            std::vector<VkPhysicalDevice> devices(count);
+            CheckVulkan(vkEnumeratePhysicalDevices(m_instance, &count, devices.data()), "vkEnumeratePhysicalDevices");
+            devices.resize(count);
+            KT_VERIFY(!_index.has_value() || *_index < devices.size(), "Vulkan device %u does not exist, %zu found", _index.value_or(0), devices.size());
+
+            // Discrete GPUs first, then integrated and virtual ones. Software devices are slower than the CPU path.
+            const auto getRank = [](VkPhysicalDeviceType _type)
+            {
+                switch (_type)
+                {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 0;
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 1;
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 2;
+                default: return 3;
+                }
+            };
+            s32 bestRank = 4;
+            for (u32 i = 0; i < devices.size(); i++)
+            {
+                if (_index.has_value() && i != *_index)
+                {
+                    continue;
+                }
+                VkPhysicalDeviceProperties properties;
+                vkGetPhysicalDeviceProperties(devices[i], &properties);
+                const s32 rank = _index.has_value() ? 0 : getRank(properties.deviceType);
+                if (rank >= bestRank || (!_index.has_value() && properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU))
+                {
+                    continue;
+                }
+
+                u32 familyCount = 0;
+                vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, nullptr);
+                std::vector<VkQueueFamilyProperties> families(familyCount);
+                vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, families.data());
+                for (u32 f = 0; f < familyCount; f++)
+                {
+                    if ((families[f].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0)
+                    {
+                        bestRank = rank;
+                        m_physicalDevice = devices[i];
+                        m_properties = properties;
+                        m_queueFamily = f;
+                        break;
+                    }
+                }
+            }
+            KT_VERIFY(m_physicalDevice != VK_NULL_HANDLE, "No Vulkan GPU with a compute queue");
+
+            vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
+            m_name = m_properties.deviceName;
+            m_key = FormatString("%s-%04x-%04x-%08x", m_name.c_str(), m_properties.vendorID, m_properties.deviceID, m_properties.driverVersion);
+        }
+
+        void CreateDevice()
+        {
+            const f32 priority = 1.0f;
+            VkDeviceQueueCreateInfo queue {};
+            queue.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queue.queueFamilyIndex = m_queueFamily;
+            queue.queueCount = 1;
+            queue.pQueuePriorities = &priority;
+            VkDeviceCreateInfo info {};
+            info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            info.queueCreateInfoCount = 1;
+            info.pQueueCreateInfos = &queue;
+            CheckVulkan(vkCreateDevice(m_physicalDevice, &info, nullptr, &m_device), "vkCreateDevice");
+            vkGetDeviceQueue(m_device, m_queueFamily, 0, &m_queue);
+
+            VkCommandPoolCreateInfo pool {};
+            pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool.queueFamilyIndex = m_queueFamily;
+            CheckVulkan(vkCreateCommandPool(m_device, &pool, nullptr, &m_commandPool), "vkCreateCommandPool");
+        }
+
+        VkShaderModule CreateModule(std::span<const uint32_t> _words)
+        {
+            VkShaderModuleCreateInfo info {};
+            info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            info.codeSize = _words.size_bytes();
+            info.pCode = _words.data();
+            VkShaderModule module = VK_NULL_HANDLE;
+            CheckVulkan(vkCreateShaderModule(m_device, &info, nullptr, &module), "vkCreateShaderModule");
+            return module;
+        }
+
+        void CreatePipelines()
+        {
+            // Texels, blocks and the sRGB decode table, the same set serving both shaders.
+            VkDescriptorSetLayoutBinding bindings[3] {};
+            for (u32 i = 0; i < 3; i++)
+            {
+                bindings[i].binding = i;
+                bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                bindings[i].descriptorCount = 1;
+                bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            }
+            VkDescriptorSetLayoutCreateInfo setLayout {};
+            setLayout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            setLayout.bindingCount = 3;
+            setLayout.pBindings = bindings;
+            CheckVulkan(vkCreateDescriptorSetLayout(m_device, &setLayout, nullptr, &m_setLayout), "vkCreateDescriptorSetLayout");
+
+            VkPushConstantRange range {};
+            range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            range.size = u32(std::max(sizeof(MipConstants), sizeof(EncodeConstants)));
+            VkPipelineLayoutCreateInfo layout {};
+            layout.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layout.setLayoutCount = 1;
+            layout.pSetLayouts = &m_setLayout;
+            layout.pushConstantRangeCount = 1;
+            layout.pPushConstantRanges = &range;
+            CheckVulkan(vkCreatePipelineLayout(m_device, &layout, nullptr, &m_pipelineLayout), "vkCreatePipelineLayout");
+
+            m_mipModule = CreateModule(kMipDownsampleSpirv);
+            m_encodeModule = CreateModule(kBlockEncodeSpirv);
+
+            // The encoder is specialized on the format, the switch on it is folded by the driver.
+            constexpr u32 kPipelineCount = 1 + std::size(kGpuFormats);
+            u32 formats[std::size(kGpuFormats)];
+            VkSpecializationMapEntry entry { 0, 0, sizeof(u32) };
+            VkSpecializationInfo specializations[std::size(kGpuFormats)] {};
+            VkComputePipelineCreateInfo infos[kPipelineCount] {};
+            for (u32 i = 0; i < kPipelineCount; i++)
+            {
+                infos[i].sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+                infos[i].layout = m_pipelineLayout;
+                infos[i].stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                infos[i].stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+                infos[i].stage.pName = "main";
+                infos[i].stage.module = i == 0 ? m_mipModule : m_encodeModule;
+                if (i > 0)
+                {
+                    formats[i - 1] = u32(kGpuFormats[i - 1]);
+                    specializations[i - 1].mapEntryCount = 1;
+                    specializations[i - 1].pMapEntries = &entry;
+                    specializations[i - 1].dataSize = sizeof(u32);
+                    specializations[i - 1].pData = &formats[i - 1];
+                    infos[i].stage.pSpecializationInfo = &specializations[i - 1];
+                }
+            }
+            VkPipeline pipelines[kPipelineCount] {};
+            CheckVulkan(vkCreateComputePipelines(m_device, VK_NULL_HANDLE, kPipelineCount, infos, nullptr, pipelines), "vkCreateComputePipelines");
+            m_mipPipeline = pipelines[0];
+            std::copy_n(pipelines + 1, m_encodePipelines.size(), m_encodePipelines.begin());
+
+            // Same values as the table of MipGenerator.cpp.
+            m_srgbTable = std::make_unique<DeviceBuffer>(
+                m_device,
+                m_memoryProperties,
+                256 * sizeof(f32),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            f32* table = static_cast<f32*>(m_srgbTable->GetMapped());
+            for (u32 i = 0; i < 256; i++)
+            {
+                const f32 value = f32(i) / 255.0f;
+                table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+
+        /// Records the whole cook in one command buffer, then waits for it.
+        void Run(const Image& _image, std::span<const GpuLevel> _levels, u32 _mipFlags, TextureFormat _format, CompressedTexture& _texture)
+        {
+            const GpuLevel& last = _levels.back();
+            const u64 texelBytes = (last.m_texelOffset + u64(last.m_width) * last.m_height) * 4;
+            const u64 sourceBytes = u64(_image.m_width) * _image.m_height * 4;
+            const u64 blockBytes = _texture.m_data.size();
+
+            const DeviceBuffer upload(m_device, m_memoryProperties, sourceBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            std::memcpy(upload.GetMapped(), _image.m_pixels.data(), sourceBytes);
+            const DeviceBuffer texels(m_device, m_memoryProperties, texelBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            const DeviceBuffer blocks(m_device, m_memoryProperties, blockBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            const DeviceBuffer readback(
+                m_device,
+                m_memoryProperties,
+                blockBytes,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+            VkDescriptorPool pool = VK_NULL_HANDLE;
+            VkCommandBuffer commands = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            const auto release = [&]
+            {
+                vkDestroyFence(m_device, fence, nullptr);
+                if (commands != VK_NULL_HANDLE)
+                {
+                    vkFreeCommandBuffers(m_device, m_commandPool, 1, &commands);
+                }
+                vkDestroyDescriptorPool(m_device, pool, nullptr);
+            };
+
+            try
+            {
+                const VkDescriptorPoolSize poolSize { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 };
+                VkDescriptorPoolCreateInfo poolInfo {};
+                poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+                poolInfo.maxSets = 1;
+                poolInfo.poolSizeCount = 1;
+                poolInfo.pPoolSizes = &poolSize;
+                CheckVulkan(vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &pool), "vkCreateDescriptorPool");
+
+                VkDescriptorSetAllocateInfo setInfo {};
+                setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+                setInfo.descriptorPool = pool;
+                setInfo.descriptorSetCount = 1;
+                setInfo.pSetLayouts = &m_setLayout;
+                VkDescriptorSet set = VK_NULL_HANDLE;
+                CheckVulkan(vkAllocateDescriptorSets(m_device, &setInfo, &set), "vkAllocateDescriptorSets");
+
+                const VkDescriptorBufferInfo bufferInfos[3] = {
+                    { texels.Get(), 0, VK_WHOLE_SIZE },
+                    { blocks.Get(), 0, VK_WHOLE_SIZE },
+                    { m_srgbTable->Get(), 0, VK_WHOLE_SIZE },
+                };
+                VkWriteDescriptorSet writes[3] {};
+                for (u32 i = 0; i < 3; i++)
+                {
+                    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                    writes[i].dstSet = set;
+                    writes[i].dstBinding = i;
+                    writes[i].descriptorCount = 1;
+                    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    writes[i].pBufferInfo = &bufferInfos[i];
+                }
+                vkUpdateDescriptorSets(m_device, 3, writes, 0, nullptr);
+
+                VkCommandBufferAllocateInfo commandInfo {};
+                commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                commandInfo.commandPool = m_commandPool;
+                commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                commandInfo.commandBufferCount = 1;
+                CheckVulkan(vkAllocateCommandBuffers(m_device, &commandInfo, &commands), "vkAllocateCommandBuffers");
+
+                VkCommandBufferBeginInfo begin {};
+                begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                CheckVulkan(vkBeginCommandBuffer(commands, &begin), "vkBeginCommandBuffer");
+
+                const VkBufferCopy sourceCopy { 0, 0, sourceBytes };
+                vkCmdCopyBuffer(commands, upload.Get(), texels.Get(), 1, &sourceCopy);
+                AddMemoryBarrier(
+                    commands,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+                vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &set, 0, nullptr);
+
+                // Each level reads the previous one.
+                vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_COMPUTE, m_mipPipeline);
+                for (size_t l = 1; l < _levels.size(); l++)
+                {
+                    const GpuLevel& source = _levels[l - 1];
+                    const GpuLevel& level = _levels[l];
+                    const MipConstants constants {
+                        source.m_width,
+                        source.m_height,
+                        level.m_width,
+                        level.m_height,
+                        u32(source.m_texelOffset),
+                        u32(level.m_texelOffset),
+                        _mipFlags,
+                    };
+                    vkCmdPushConstants(commands, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+                    vkCmdDispatch(commands, (level.m_width + kGroupSize - 1) / kGroupSize, (level.m_height + kGroupSize - 1) / kGroupSize, 1);
+                    AddMemoryBarrier(
+                        commands,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_SHADER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+                }
+
+                // Every level is encoded at once, small ones overlapping large ones.
+                vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_COMPUTE, m_encodePipelines[u32(_format)]);
+                for (size_t l = 0; l < _levels.size(); l++)
+                {
+                    const GpuLevel& level = _levels[l];
+                    const EncodeConstants constants {
+                        level.m_width,
+                        level.m_height,
+                        level.m_blocksX,
+                        level.m_blocksY,
+                        u32(level.m_texelOffset),
+                        u32(_texture.m_mips[l].m_offset / sizeof(u32)),
+                    };
+                    vkCmdPushConstants(commands, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+                    vkCmdDispatch(commands, (level.m_blocksX + kGroupSize - 1) / kGroupSize, (level.m_blocksY + kGroupSize - 1) / kGroupSize, 1);
+                }
+
+                AddMemoryBarrier(commands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+                const VkBufferCopy blockCopy { 0, 0, blockBytes };
+                vkCmdCopyBuffer(commands, blocks.Get(), readback.Get(), 1, &blockCopy);
+                AddMemoryBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+                CheckVulkan(vkEndCommandBuffer(commands), "vkEndCommandBuffer");
+
+                VkFenceCreateInfo fenceInfo {};
+                fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+                CheckVulkan(vkCreateFence(m_device, &fenceInfo, nullptr, &fence), "vkCreateFence");
+                VkSubmitInfo submit {};
+                submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submit.commandBufferCount = 1;
+                submit.pCommandBuffers = &commands;
+                CheckVulkan(vkQueueSubmit(m_queue, 1, &submit, fence), "vkQueueSubmit");
+                CheckVulkan(vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+
+                std::memcpy(_texture.m_data.data(), readback.GetMapped(), blockBytes);
+            }
+            catch (...)
+            {
+                // A failed submission may still be running, do not free what it uses.
+                vkDeviceWaitIdle(m_device);
+                release();
+                throw;
+            }
+            release();
+        }
+    };
+
+    std::unique_ptr<GpuTextureCompressor> GpuTextureCompressor::Create(std::optional<u32> _device)
+    {
+        KT_TRACE_ZONE("CreateGpuTextureCompressor");
+        auto device = std::make_unique<Device>();
+        device->CreateInstance();
+        device->SelectPhysicalDevice(_device);
+        device->CreateDevice();
+        device->CreatePipelines();
+        return std::unique_ptr<GpuTextureCompressor>(new GpuTextureCompressor(std::move(device)));
+    }
+
+    std::optional<CompressedTexture> GpuTextureCompressor::Cook(const Image& _image, bool _generateMips, const MipSettings& _mipSettings, const CompressionSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("GpuCookTexture", GetTextureFormatName(_settings.m_format));
+        KT_VERIFY(Supports(_settings.m_format, _settings.m_quality), "The GPU does not encode %s", GetTextureFormatName(_settings.m_format));
+
+        CompressedTexture texture;
+        texture.m_format = _settings.m_format;
+        texture.m_srgb = _settings.m_srgb && IsColorFormat(_settings.m_format);
+        texture.m_width = _image.m_width;
+        texture.m_height = _image.m_height;
+
+        // Levels halve like GenerateMips() does, blocks are laid out like CompressTexture() does.
+        const u32 blockSize = GetBlockSize(_settings.m_format);
+        std::vector<GpuLevel> levels;
+        u64 texelCount = 0;
+        u64 blockBytes = 0;
+        u32 width = _image.m_width;
+        u32 height = _image.m_height;
+        while (true)
+        {
+            const u32 blocksX = (width + kBlockDimension - 1) / kBlockDimension;
+            const u32 blocksY = (height + kBlockDimension - 1) / kBlockDimension;
+            levels.push_back({ width, height, blocksX, blocksY, texelCount });
+            texelCount += u64(width) * height;
+
+            CompressedMip& mip = texture.m_mips.emplace_back();
+            mip.m_width = width;
+            mip.m_height = height;
+            mip.m_offset = blockBytes;
+            mip.m_size = u64(blocksX) * blocksY * blockSize;
+            blockBytes += mip.m_size;
+
+            if (!_generateMips || (width == 1 && height == 1))
+            {
+                break;
+            }
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+
+        const u64 limit = m_device->m_properties.limits.maxStorageBufferRange;
+        if (texelCount * 4 > limit || blockBytes > limit)
+        {
+            Log::Verbose("%ux%u texture does not fit a storage buffer of %s, cooking it on the CPU", _image.m_width, _image.m_height, m_device->m_name.c_str());
+            return std::nullopt;
+        }
+        texture.m_data.resize(blockBytes);
+
+        const u32 mipFlags = (_mipSettings.m_srgb && !_mipSettings.m_normalMap ? kMipFlagSrgb : 0) | (_mipSettings.m_normalMap ? kMipFlagNormalMap : 0);
+        const std::lock_guard lock(m_device->m_mutex);
+        m_device->Run(_image, levels, mipFlags, _settings.m_format, texture);
+        return texture;
+    }
+#else
+    struct GpuTextureCompressor::Device
+    {
+        std::string m_name;
+        std::string m_key;
+    };
+
+    std::unique_ptr<GpuTextureCompressor> GpuTextureCompressor::Create(std::optional<u32>)
+    {
+        ThrowError("The tools are built without Vulkan, GPU texture cooking is not available");
+    }
+
+    std::optional<CompressedTexture> GpuTextureCompressor::Cook(const Image&, bool, const MipSettings&, const CompressionSettings&)
+    {
+        return std::nullopt;
+    }
+#endif
+
+    GpuTextureCompressor::GpuTextureCompressor(std::unique_ptr<Device> _device)
+        : m_device(std::move(_device))
+    {}
+
+    GpuTextureCompressor::~GpuTextureCompressor() = default;
+
+    const std::string& GpuTextureCompressor::GetDeviceName() const
+    {
+        return m_device->m_name;
+    }
+
+    const std::string& GpuTextureCompressor::GetDeviceKey() const
+    {
+        return m_device->m_key;
+    }
+
+    bool GpuTextureCompressor::Supports(TextureFormat _format, EncodeQuality _quality)
+    {
+        return _quality == EncodeQuality::Fast && _format != TextureFormat::Astc4x4;
+    }
+}
@@ -0,0 +1,289 @@
+#include "KryneTools/Texture/Image.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Trace.hpp"
+
+#if defined(KRYNE_TOOLS_HAS_PNG)
+#   include <png.h>
+#endif
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Bounds checked cursor over the mapped file.
+        class Reader
+        {
+        public:
+            Reader(std::span<const u8> _data, const std::filesystem::path& _path)
+                : m_data(_data)
+                , m_path(_path)
+            {}
+
+            const u8* Take(u64 _size)
+            {
+                KT_VERIFY(_size <= m_data.size() - m_offset, "'%s': truncated image data", m_path.string().c_str());
+                const u8* data = m_data.data() + m_offset;
+                m_offset += _size;
+                return data;
+            }
+
+            u8 ReadU8() { return *Take(1); }
+
+            u16 ReadU16()
+            {
+                const u8* data = Take(2);
+                return u16(data[0] | (data[1] << 8));
+            }
+
+            void Skip(u64 _size) { Take(_size); }
+
+            [[nodiscard]] u64 GetOffset() const { return m_offset; }
+
+            [[nodiscard]] const std::filesystem::path& GetPath() const { return m_path; }
+
+        private:
+            std::span<const u8> m_data;
+            const std::filesystem::path& m_path;
+            u64 m_offset = 0;
+        };
+
+        void StorePixel(u8* _output, const u8* _source, u32 _channels, bool _bgr)
+        {
+            if (_channels == 1)
+            {
+                _output[0] = _output[1] = _output[2] = _source[0];
+                _output[3] = 255;
+                return;
+            }
+            _output[0] = _source[_bgr ? 2 : 0];
+            _output[1] = _source[1];
+            _output[2] = _source[_bgr ? 0 : 2];
+            _output[3] = _channels == 4 ? _source[3] : 255;
+        }
+
+        void CheckDimensions(u32 _width, u32 _height, const std::filesystem::path& _path)
+        {
+            KT_VERIFY(_width != 0 && _height != 0, "'%s': empty image", _path.string().c_str());
+            KT_VERIFY(_width <= 65536 && _height <= 65536, "'%s': image of %ux%u is too large", _path.string().c_str(), _width, _height);
+        }
+
+        Image LoadTga(std::span<const u8> _data, const std::filesystem::path& _path)
+        {
+            Reader reader(_data, _path);
+            const u8 idLength = reader.ReadU8();
+            const u8 colorMapType = reader.ReadU8();
+            const u8 imageType = reader.ReadU8();
+            reader.Skip(5 + 4);
+            const u32 width = reader.ReadU16();
+            const u32 height = reader.ReadU16();
+            const u8 bitsPerPixel = reader.ReadU8();
+            const u8 descriptor = reader.ReadU8();
+            reader.Skip(idLength);
+
+            const bool rle = imageType >= 8;
+            const u8 baseType = rle ? imageType - 8 : imageType;
+            KT_VERIFY(colorMapType == 0 && (baseType == 2 || baseType == 3), "'%s': only true color and grey TGA images are supported", _path.string().c_str());
+            const u32 channels = bitsPerPixel / 8;
+            KT_VERIFY(
+                (baseType == 2 && (channels == 3 || channels == 4)) || (baseType == 3 && channels == 1),
+                "'%s': unsupported TGA pixel size of %u bits",
+                _path.string().c_str(),
+                bitsPerPixel);
+            CheckDimensions(width, height, _path);
+
+            Image image;
+            image.Allocate(width, height);
+            // Bottom-up unless the descriptor says otherwise, right-to-left orders are not supported.
+            const bool topDown = (descriptor & 0x20) != 0;
+            const u64 pixelCount = u64(width) * height;
+
+            u64 pixel = 0;
+            const auto store = [&](const u8* _source)
+            {
+                const u32 x = u32(pixel % width);
+                const u32 y = u32(pixel / width);
+                StorePixel(image.GetPixel(x, topDown ? y : height - 1 - y), _source, channels, true);
+                pixel++;
+            };
+            while (pixel < pixelCount)
+            {
+                if (!rle)
+                {
+                    store(reader.Take(channels));
+                    continue;
+                }
+                const u8 packet = reader.ReadU8();
+                const u32 count = (packet & 0x7F) + 1;
+                KT_VERIFY(pixel + count <= pixelCount, "'%s': RLE packet overflows the image", _path.string().c_str());
+                if ((packet & 0x80) != 0)
+                {
+                    const u8* value = reader.Take(channels);
+                    for (u32 i = 0; i < count; i++)
+                    {
+                        store(value);
+                    }
+                }
+                else
+                {
+                    for (u32 i = 0; i < count; i++)
+                    {
+                        store(reader.Take(channels));
+                    }
+                }
+            }
+            return image;
+        }
+
+        bool IsPng(std::span<const u8> _data)
+        {
+            constexpr u8 kPngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            return _data.size() >= sizeof(kPngSignature) && std::memcmp(_data.data(), kPngSignature, sizeof(kPngSignature)) == 0;
+        }
+
+        /// TGA has no magic number, go by the extension.
+        bool IsTga(const std::filesystem::path& _path)
+        {
+            std::string extension = _path.extension().string();
+            for (char& c: extension)
+            {
+                c = char(std::tolower(u8(c)));
+            }
+            return extension == ".tga";
+        }
+
+        /// Netpbm header token, skipping whitespace and comments.
+        u32 ReadPnmValue(Reader& _reader)
+        {
+            u8 c = _reader.ReadU8();
+            while (std::isspace(c) || c == '#')
+            {
+                if (c == '#')
+                {
+                    while (c != '\n')
+                    {
+                        c = _reader.ReadU8();
+                    }
+                }
+                c = _reader.ReadU8();
+            }
+            u32 value = 0;
+            KT_VERIFY(std::isdigit(c), "'%s': malformed PNM header", _reader.GetPath().string().c_str());
+            while (std::isdigit(c))
+            {
+                value = value * 10 + u32(c - '0');
+                KT_VERIFY(value <= 0xFFFFFF, "'%s': malformed PNM header", _reader.GetPath().string().c_str());
+                c = _reader.ReadU8();
+            }
+            return value;
+        }
+
+        Image LoadPnm(std::span<const u8> _data, const std::filesystem::path& _path)
+        {
+            Reader reader(_data, _path);
+            reader.Skip(1);
+            const u8 type = reader.ReadU8();
+            KT_VERIFY(type == '5' || type == '6', "'%s': only binary PGM (P5) and PPM (P6) are supported", _path.string().c_str());
+            const u32 width = ReadPnmValue(reader);
+            const u32 height = ReadPnmValue(reader);
+            const u32 maxValue = ReadPnmValue(reader);
+            KT_VERIFY(maxValue == 255, "'%s': only 8 bits PNM images are supported", _path.string().c_str());
+            CheckDimensions(width, height, _path);
+
+            const u32 channels = type == '5' ? 1 : 3;
+            Image image;
+            image.Allocate(width, height);
+            const u8* source = reader.Take(u64(width) * height * channels);
+            for (u64 i = 0; i < u64(width) * height; i++)
+            {
+                StorePixel(image.m_pixels.data() + i * 4, source + i * channels, channels, false);
+            }
+            return image;
+        }
+
+#if defined(KRYNE_TOOLS_HAS_PNG)
+        Image LoadPng(std::span<const u8> _data, const std::filesystem::path& _path)
+        {
+            png_image png {};
+            png.version = PNG_IMAGE_VERSION;
+            KT_VERIFY(png_image_begin_read_from_memory(&png, _data.data(), _data.size()) != 0, "'%s': %s", _path.string().c_str(), png.message);
+            CheckDimensions(png.width, png.height, _path);
+
+            // The simplified API converts every layout to RGBA8, 16 bits channels included.
+            png.format = PNG_FORMAT_RGBA;
+            Image image;
+            image.Allocate(png.width, png.height);
+            const bool success = png_image_finish_read(&png, nullptr, image.m_pixels.data(), 0, nullptr) != 0;
+            const std::string message = png.message;
+            png_image_free(&png);
+            KT_VERIFY(success, "'%s': %s", _path.string().c_str(), message.c_str());
+            return image;
+        }
+#endif
+    }
+
+    Image LoadImage(const std::filesystem::path& _path)
+    {
+        KT_TRACE_ZONE_DETAIL("LoadImage", _path.string());
+        const MappedFile file = MappedFile::Open(_path);
+        const std::span<const u8> data = file.GetData();
+
+        if (IsPng(data))
+        {
+#if defined(KRYNE_TOOLS_HAS_PNG)
+            return LoadPng(data, _path);
+#else
+            ThrowError("'%s': PNG support was not built in, libpng was not found", _path.string().c_str());
+#endif
+        }
+        if (data.size() >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6'))
+        {
+            return LoadPnm(data, _path);
+        }
+        KT_VERIFY(IsTga(_path), "'%s': unsupported image format", _path.string().c_str());
+        return LoadTga(data, _path);
+    }
+
+    bool ReadImageSize(const std::filesystem::path& _path, u32& _width, u32& _height)
+    {
+        try
+        {
+            const MappedFile file = MappedFile::Open(_path);
+            const std::span<const u8> data = file.GetData();
+            Reader reader(data, _path);
+            if (IsPng(data))
+            {
+                // The IHDR chunk comes first, with big endian dimensions.
+                const u8* header = reader.Take(24) + 16;
+                _width = u32(header[0]) << 24 | u32(header[1]) << 16 | u32(header[2]) << 8 | header[3];
+                _height = u32(header[4]) << 24 | u32(header[5]) << 16 | u32(header[6]) << 8 | header[7];
+            }
+            else if (data.size() >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6'))
+            {
+                reader.Skip(2);
+                _width = ReadPnmValue(reader);
+                _height = ReadPnmValue(reader);
+            }
+            else if (IsTga(_path))
+            {
+                reader.Skip(12);
+                _width = reader.ReadU16();
+                _height = reader.ReadU16();
+            }
+            else
+            {
+                return false;
+            }
+            return _width != 0 && _height != 0;
+        }
+        catch (const Error&)
+        {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include "KryneTools/Texture/TextureReader.hpp"
+
+#include <cstring>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Texture/TextureFileFormat.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        TextureFormat GetTextureFormat(TextureFileFormat::BlockFormat _format)
+        {
+            switch (_format)
+            {
+            case TextureFileFormat::BlockFormat::Bc1: return TextureFormat::Bc1;
+            case TextureFileFormat::BlockFormat::Bc3: return TextureFormat::Bc3;
+            case TextureFileFormat::BlockFormat::Bc4: return TextureFormat::Bc4;
+            case TextureFileFormat::BlockFormat::Bc5: return TextureFormat::Bc5;
+            case TextureFileFormat::BlockFormat::Bc7: return TextureFormat::Bc7;
+            case TextureFileFormat::BlockFormat::Astc4x4: return TextureFormat::Astc4x4;
+            }
+            ThrowError("Unknown block format %u", u32(_format));
+        }
+    }
+
+    KtexInfo ReadKtex(const std::filesystem::path& _path)
+    {
+        const MappedFile file = MappedFile::Open(_path);
+        const std::span<const u8> data = file.GetData();
+        const std::string pathString = _path.string();
+        const char* path = pathString.c_str();
+
+        TextureFileFormat::Header header;
+        KT_VERIFY(data.size() >= sizeof(header), "%s: truncated header", path);
+        std::memcpy(&header, data.data(), sizeof(header));
+        KT_VERIFY(header.m_magic == TextureFileFormat::kMagic, "%s: not a ktex file", path);
+        KT_VERIFY(header.m_version == TextureFileFormat::kVersion, "%s: unsupported version %u", path, u32(header.m_version));
+        KT_VERIFY(header.m_fileSize == data.size(), "%s: size mismatch", path);
+
+        KT_VERIFY(header.m_headerSize >= sizeof(header), "%s: invalid header size", path);
+
+        const u64 tableOffset = header.m_headerSize;
+        KT_VERIFY(tableOffset + u64(header.m_mipCount) * sizeof(TextureFileFormat::MipEntry) <= data.size(), "%s: truncated mip table", path);
+
+        KtexInfo info;
+        info.m_normalMap = (header.m_flags & TextureFileFormat::kFlagNormalMap) != 0;
+        info.m_prologueSize = header.m_prologueSize;
+        info.m_fileSize = header.m_fileSize;
+        CompressedTexture& texture = info.m_texture;
+        texture.m_format = GetTextureFormat(header.m_format);
+        texture.m_srgb = (header.m_flags & TextureFileFormat::kFlagSrgb) != 0;
+        texture.m_width = header.m_width;
+        texture.m_height = header.m_height;
+        texture.m_mips.resize(header.m_mipCount);
+
+        u64 dataSize = 0;
+        std::vector<TextureFileFormat::MipEntry> entries(header.m_mipCount);
+        std::memcpy(entries.data(), data.data() + tableOffset, entries.size() * sizeof(TextureFileFormat::MipEntry));
+        for (const TextureFileFormat::MipEntry& entry: entries)
+        {
+            KT_VERIFY(entry.m_offset <= data.size() && entry.m_size <= data.size() - entry.m_offset, "%s: mip out of bounds", path);
+            dataSize += entry.m_size;
+        }
+        texture.m_data.resize(dataSize);
+
+        u64 offset = 0;
+        for (size_t m = 0; m < entries.size(); m++)
+        {
+            const TextureFileFormat::MipEntry& entry = entries[m];
+            texture.m_mips[m] = { entry.m_width, entry.m_height, offset, entry.m_size };
+            std::memcpy(texture.m_data.data() + offset, data.data() + entry.m_offset, entry.m_size);
+            offset += entry.m_size;
+        }
+        return info;
+    }
+}
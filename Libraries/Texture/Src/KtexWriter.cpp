@@ -0,0 +1,105 @@
+#include "KryneTools/Texture/TextureWriter.hpp"
+
+#include <bit>
+#include <vector>
+
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Texture/TextureCompressor.hpp"
+#include "KryneTools/Texture/TextureFileFormat.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        TextureFileFormat::BlockFormat GetBlockFormat(TextureFormat _format)
+        {
+            switch (_format)
+            {
+            case TextureFormat::Bc1: return TextureFileFormat::BlockFormat::Bc1;
+            case TextureFormat::Bc3: return TextureFileFormat::BlockFormat::Bc3;
+            case TextureFormat::Bc4: return TextureFileFormat::BlockFormat::Bc4;
+            case TextureFormat::Bc5: return TextureFileFormat::BlockFormat::Bc5;
+            case TextureFormat::Bc7: return TextureFileFormat::BlockFormat::Bc7;
+            case TextureFormat::Astc4x4: return TextureFileFormat::BlockFormat::Astc4x4;
+            }
+            ThrowError("Unsupported texture format %u", u32(_format));
+        }
+    }
+
+    const char* GetTextureContainerExtension(TextureContainer _container)
+    {
+        return _container == TextureContainer::Dds ? ".dds" : ".ktex";
+    }
+
+    std::optional<TextureContainer> ParseTextureContainer(std::string_view _name)
+    {
+        if (_name == "ktex")
+        {
+            return TextureContainer::Ktex;
+        }
+        if (_name == "dds")
+        {
+            return TextureContainer::Dds;
+        }
+        return std::nullopt;
+    }
+
+    void WriteKtex(const std::filesystem::path& _path, const CompressedTexture& _texture, const KtexWriteSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("WriteKtex", _path.string());
+        KT_VERIFY(
+            std::has_single_bit(_settings.m_mipAlignment) && _settings.m_mipAlignment >= TextureFileFormat::kResidentMipAlignment,
+            "Invalid mip alignment %u",
+            _settings.m_mipAlignment);
+        KT_VERIFY(_texture.m_mips.size() <= 255, "Too many mips (%zu)", _texture.m_mips.size());
+
+        const u32 mipCount = u32(_texture.m_mips.size());
+        const u64 alignment = _settings.m_mipAlignment;
+
+        // Mips are largest first, the resident ones are the tail of the chain.
+        u32 firstResident = mipCount;
+        while (firstResident > 0 && _texture.m_mips[firstResident - 1].m_size < alignment)
+        {
+            firstResident--;
+        }
+
+        std::vector<TextureFileFormat::MipEntry> entries(mipCount);
+        u64 offset = sizeof(TextureFileFormat::Header) + mipCount * sizeof(TextureFileFormat::MipEntry);
+        for (u32 m = mipCount; m-- > 0;)
+        {
+            const CompressedMip& mip = _texture.m_mips[m];
+            offset = AlignUp(offset, m >= firstResident ? TextureFileFormat::kResidentMipAlignment : alignment);
+            entries[m] = { mip.m_width, mip.m_height, offset, mip.m_size };
+            offset += mip.m_size;
+        }
+        const u64 fileSize = AlignUp(offset, alignment);
+
+        TextureFileFormat::Header header {};
+        header.m_magic = TextureFileFormat::kMagic;
+        header.m_version = TextureFileFormat::kVersion;
+        header.m_headerSize = sizeof(TextureFileFormat::Header);
+        header.m_width = _texture.m_width;
+        header.m_height = _texture.m_height;
+        header.m_format = GetBlockFormat(_texture.m_format);
+        header.m_flags = u8((_texture.m_srgb ? TextureFileFormat::kFlagSrgb : 0) | (_settings.m_normalMap ? TextureFileFormat::kFlagNormalMap : 0));
+        header.m_mipCount = u8(mipCount);
+        header.m_residentMipCount = u8(mipCount - firstResident);
+        header.m_mipAlignment = _settings.m_mipAlignment;
+        header.m_prologueSize = u32(firstResident == 0 ? fileSize : entries[firstResident - 1].m_offset);
+        header.m_fileSize = fileSize;
+
+        FileWriter writer(_path);
+        writer.WritePod(header);
+        writer.WriteSpan(std::span<const TextureFileFormat::MipEntry>(entries));
+        for (u32 m = mipCount; m-- > 0;)
+        {
+            const CompressedMip& mip = _texture.m_mips[m];
+            writer.Align(m >= firstResident ? TextureFileFormat::kResidentMipAlignment : alignment);
+            writer.Write(_texture.m_data.data() + mip.m_offset, mip.m_size);
+        }
+        writer.Align(alignment);
+        writer.Commit();
+    }
+}
@@ -0,0 +1,154 @@
+#include "KryneTools/Texture/Image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        f32 SrgbToLinear(f32 _value)
+        {
+            return _value <= 0.04045f ? _value / 12.92f : std::pow((_value + 0.055f) / 1.055f, 2.4f);
+        }
+
+        f32 LinearToSrgb(f32 _value)
+        {
+            return _value <= 0.0031308f ? _value * 12.92f : 1.055f * std::pow(_value, 1.0f / 2.4f) - 0.055f;
+        }
+
+        const std::array<f32, 256>& GetSrgbDecodeTable()
+        {
+            static const std::array<f32, 256> table = []
+            {
+                std::array<f32, 256> values {};
+                for (u32 i = 0; i < 256; i++)
+                {
+                    values[i] = SrgbToLinear(f32(i) / 255.0f);
+                }
+                return values;
+            }();
+            return table;
+        }
+
+        u8 ToUnorm8(f32 _value)
+        {
+            return u8(std::clamp(_value, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        /// Source texels a destination texel covers along one axis, with the covered fraction of each.
+        struct Footprint
+        {
+            u32 m_begin = 0;
+            u32 m_count = 0;
+            std::array<f32, 3> m_weights {};
+        };
+
+        Footprint ComputeFootprint(u32 _destination, u32 _sourceSize, u32 _destinationSize)
+        {
+            // Halving never covers more than three source texels (odd sizes), nor less than one.
+            const f32 scale = f32(_sourceSize) / f32(_destinationSize);
+            const f32 begin = f32(_destination) * scale;
+            const f32 end = f32(_destination + 1) * scale;
+
+            Footprint footprint;
+            footprint.m_begin = u32(begin);
+            const u32 last = std::min(_sourceSize - 1, u32(std::ceil(end)) - 1);
+            footprint.m_count = last - footprint.m_begin + 1;
+            for (u32 i = 0; i < footprint.m_count; i++)
+            {
+                const f32 texelBegin = f32(footprint.m_begin + i);
+                const f32 overlap = std::min(end, texelBegin + 1.0f) - std::max(begin, texelBegin);
+                footprint.m_weights[i] = overlap / scale;
+            }
+            return footprint;
+        }
+
+        void FilterRow(const Image& _source, Image& _destination, u32 _y, const MipSettings& _settings)
+        {
+            const std::array<f32, 256>& decode = GetSrgbDecodeTable();
+            const bool srgb = _settings.m_srgb && !_settings.m_normalMap;
+            const Footprint rows = ComputeFootprint(_y, _source.m_height, _destination.m_height);
+
+            for (u32 x = 0; x < _destination.m_width; x++)
+            {
+                const Footprint columns = ComputeFootprint(x, _source.m_width, _destination.m_width);
+
+                f32 sum[4] = {};
+                for (u32 j = 0; j < rows.m_count; j++)
+                {
+                    for (u32 i = 0; i < columns.m_count; i++)
+                    {
+                        const f32 weight = rows.m_weights[j] * columns.m_weights[i];
+                        const u8* texel = _source.GetPixel(columns.m_begin + i, rows.m_begin + j);
+                        for (u32 c = 0; c < 3; c++)
+                        {
+                            sum[c] += weight * (srgb ? decode[texel[c]] : f32(texel[c]) / 255.0f);
+                        }
+                        sum[3] += weight * f32(texel[3]) / 255.0f;
+                    }
+                }
+
+                u8* output = _destination.GetPixel(x, _y);
+                if (_settings.m_normalMap)
+                {
+                    f32 normal[3];
+                    for (u32 c = 0; c < 3; c++)
+                    {
+                        normal[c] = sum[c] * 2.0f - 1.0f;
+                    }
+                    const f32 length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                    // Opposite normals may cancel out completely, fall back to the surface normal.
+                    const f32 inverseLength = length > 1e-6f ? 1.0f / length : 0.0f;
+                    if (inverseLength == 0.0f)
+                    {
+                        normal[0] = normal[1] = 0.0f;
+                        normal[2] = 1.0f;
+                    }
+                    for (u32 c = 0; c < 3; c++)
+                    {
+                        const f32 value = inverseLength == 0.0f ? normal[c] : normal[c] * inverseLength;
+                        output[c] = ToUnorm8(value * 0.5f + 0.5f);
+                    }
+                }
+                else
+                {
+                    for (u32 c = 0; c < 3; c++)
+                    {
+                        output[c] = ToUnorm8(srgb ? LinearToSrgb(sum[c]) : sum[c]);
+                    }
+                }
+                output[3] = ToUnorm8(sum[3]);
+            }
+        }
+    }
+
+    std::vector<Image> GenerateMips(JobSystem& _jobSystem, Image _image, const MipSettings& _settings)
+    {
+        KT_TRACE_ZONE("GenerateMips");
+        std::vector<Image> mips;
+        mips.push_back(std::move(_image));
+        while (mips.back().m_width > 1 || mips.back().m_height > 1)
+        {
+            const Image& source = mips.back();
+            Image destination;
+            destination.Allocate(std::max(1u, source.m_width / 2), std::max(1u, source.m_height / 2));
+
+            // Small levels are not worth a job each, keep at least 64K texels per range.
+            const u64 grain = std::max<u64>(1, (64 * 1024) / destination.m_width);
+            _jobSystem.ParallelFor(destination.m_height, grain, [&](u64 _begin, u64 _end)
+            {
+                for (u64 y = _begin; y < _end; y++)
+                {
+                    FilterRow(source, destination, u32(y), _settings);
+                }
+            });
+            mips.push_back(std::move(destination));
+        }
+        return mips;
+    }
+}
@@ -0,0 +1,181 @@
+#include "KryneTools/Texture/PerceptualHash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include "KryneTools/Common/Error.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        constexpr u32 kLumaSize = 32;
+        constexpr u32 kFrequencyCount = 8;
+
+        /// `cos((2x + 1) u pi / 64)`, the DCT-II basis of the lowest frequencies.
+        const std::array<f32, kFrequencyCount * kLumaSize>& GetDctBasis()
+        {
+            static const std::array<f32, kFrequencyCount * kLumaSize> basis = []
+            {
+                std::array<f32, kFrequencyCount * kLumaSize> values {};
+                for (u32 u = 0; u < kFrequencyCount; u++)
+                {
+                    for (u32 x = 0; x < kLumaSize; x++)
+                    {
+                        values[u * kLumaSize + x] = f32(std::cos(f64(2 * x + 1) * f64(u) * std::numbers::pi / f64(2 * kLumaSize)));
+                    }
+                }
+                return values;
+            }();
+            return basis;
+        }
+
+        /// Image decoded from one mip of its blocks.
+        Image DecodeMip(const CompressedTexture& _texture, const CompressedMip& _mip)
+        {
+            const u32 blocksX = (_mip.m_width + kBlockDimension - 1) / kBlockDimension;
+            const u32 blocksY = (_mip.m_height + kBlockDimension - 1) / kBlockDimension;
+            const u32 blockSize = GetBlockSize(_texture.m_format);
+            KT_VERIFY(
+                _mip.m_offset + u64(blocksX) * blocksY * blockSize <= _texture.m_data.size(),
+                "Truncated %ux%u mip",
+                _mip.m_width,
+                _mip.m_height);
+
+            Image image;
+            image.Allocate(_mip.m_width, _mip.m_height);
+            u8 texels[kBlockPixelBytes];
+            for (u32 by = 0; by < blocksY; by++)
+            {
+                for (u32 bx = 0; bx < blocksX; bx++)
+                {
+                    DecodeBlock(_texture.m_format, _texture.m_data.data() + _mip.m_offset + (u64(by) * blocksX + bx) * blockSize, texels);
+                    // Overhanging texels repeat the edge, they are dropped.
+                    const u32 width = std::min(kBlockDimension, _mip.m_width - bx * kBlockDimension);
+                    const u32 height = std::min(kBlockDimension, _mip.m_height - by * kBlockDimension);
+                    for (u32 y = 0; y < height; y++)
+                    {
+                        std::memcpy(image.GetPixel(bx * kBlockDimension, by * kBlockDimension + y), texels + y * kBlockDimension * 4, width * 4);
+                    }
+                }
+            }
+            return image;
+        }
+    }
+
+    PerceptualSignature ComputePerceptualSignature(const Image& _image)
+    {
+        KT_VERIFY(_image.m_width > 0 && _image.m_height > 0, "Cannot hash an empty image");
+
+        // Box average down to 32x32 cells, images smaller than that are point sampled.
+        f32 luma[kLumaSize * kLumaSize];
+        f64 sums[4] {};
+        for (u32 cy = 0; cy < kLumaSize; cy++)
+        {
+            const u32 y0 = cy * _image.m_height / kLumaSize;
+            const u32 y1 = std::max(y0 + 1, (cy + 1) * _image.m_height / kLumaSize);
+            for (u32 cx = 0; cx < kLumaSize; cx++)
+            {
+                const u32 x0 = cx * _image.m_width / kLumaSize;
+                const u32 x1 = std::max(x0 + 1, (cx + 1) * _image.m_width / kLumaSize);
+                f64 cell[4] {};
+                for (u32 y = y0; y < y1; y++)
+                {
+                    for (u32 x = x0; x < x1; x++)
+                    {
+                        const u8* pixel = _image.GetPixel(x, y);
+                        for (u32 c = 0; c < 4; c++)
+                        {
+                            cell[c] += pixel[c];
+                        }
+                    }
+                }
+                const f64 count = f64((y1 - y0) * (x1 - x0));
+                for (u32 c = 0; c < 4; c++)
+                {
+                    cell[c] /= count;
+                    sums[c] += cell[c];
+                }
+                luma[cy * kLumaSize + cx] = f32(0.299 * cell[0] + 0.587 * cell[1] + 0.114 * cell[2]);
+            }
+        }
+
+        // Separable DCT, only the lowest frequencies are needed.
+        const std::array<f32, kFrequencyCount * kLumaSize>& basis = GetDctBasis();
+        f32 rows[kLumaSize * kFrequencyCount];
+        for (u32 y = 0; y < kLumaSize; y++)
+        {
+            for (u32 u = 0; u < kFrequencyCount; u++)
+            {
+                f32 sum = 0.f;
+                for (u32 x = 0; x < kLumaSize; x++)
+                {
+                    sum += luma[y * kLumaSize + x] * basis[u * kLumaSize + x];
+                }
+                rows[y * kFrequencyCount + u] = sum;
+            }
+        }
+        f32 coefficients[kFrequencyCount * kFrequencyCount];
+        for (u32 v = 0; v < kFrequencyCount; v++)
+        {
+            for (u32 u = 0; u < kFrequencyCount; u++)
+            {
+                f32 sum = 0.f;
+                for (u32 y = 0; y < kLumaSize; y++)
+                {
+                    sum += rows[y * kFrequencyCount + u] * basis[v * kLumaSize + y];
+                }
+                coefficients[v * kFrequencyCount + u] = sum;
+            }
+        }
+
+        // The median leaves out the DC term, which only carries the brightness.
+        f32 sorted[kFrequencyCount * kFrequencyCount - 1];
+        std::copy(coefficients + 1, coefficients + kFrequencyCount * kFrequencyCount, sorted);
+        std::nth_element(sorted, sorted + std::size(sorted) / 2, std::end(sorted));
+        const f32 median = sorted[std::size(sorted) / 2];
+
+        PerceptualSignature signature;
+        for (u32 i = 1; i < kFrequencyCount * kFrequencyCount; i++)
+        {
+            signature.m_hash |= coefficients[i] > median ? u64(1) << i : 0;
+        }
+        for (u32 c = 0; c < 4; c++)
+        {
+            signature.m_average[c] = u8(std::lround(sums[c] / f64(kLumaSize * kLumaSize)));
+        }
+        return signature;
+    }
+
+    PerceptualSignature ComputePerceptualSignature(const CompressedTexture& _texture)
+    {
+        KT_VERIFY(!_texture.m_mips.empty(), "Cannot hash a texture without mips");
+        const CompressedMip* source = &_texture.m_mips.front();
+        for (const CompressedMip& mip: _texture.m_mips)
+        {
+            if (mip.m_width >= kLumaSize && mip.m_height >= kLumaSize)
+            {
+                source = &mip;
+            }
+        }
+        return ComputePerceptualSignature(DecodeMip(_texture, *source));
+    }
+
+    bool IsNearDuplicate(const PerceptualSignature& _a, const PerceptualSignature& _b, u32 _maxDistance, u32 _maxAverageDifference)
+    {
+        if (GetPerceptualDistance(_a, _b) > _maxDistance)
+        {
+            return false;
+        }
+        for (u32 c = 0; c < 4; c++)
+        {
+            if (u32(std::abs(s32(_a.m_average[c]) - s32(_b.m_average[c]))) > _maxAverageDifference)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,208 @@
+#include "KryneTools/Texture/TextureCompressor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "KryneTools/Common/Arena.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        /// Tile edge in blocks, 64x64 texels: big enough to amortize the job, small enough to balance a single mip.
+        constexpr u32 kTileBlocks = 16;
+
+        struct Tile
+        {
+            u32 m_mip;
+            u32 m_blockX;
+            u32 m_blockY;
+        };
+
+        /// Channels of the comparison, the ones the format stores.
+        u32 GetStoredChannelMask(TextureFormat _format)
+        {
+            switch (_format)
+            {
+            case TextureFormat::Bc1: return 0x7;
+            case TextureFormat::Bc4: return 0x1;
+            case TextureFormat::Bc5: return 0x3;
+            default: return 0xF;
+            }
+        }
+
+        void LoadBlock(const Image& _image, u32 _blockX, u32 _blockY, u8* _pixels)
+        {
+            for (u32 y = 0; y < kBlockDimension; y++)
+            {
+                const u32 sourceY = std::min(_blockY * kBlockDimension + y, _image.m_height - 1);
+                for (u32 x = 0; x < kBlockDimension; x++)
+                {
+                    const u32 sourceX = std::min(_blockX * kBlockDimension + x, _image.m_width - 1);
+                    std::copy_n(_image.GetPixel(sourceX, sourceY), 4, _pixels + (y * kBlockDimension + x) * 4);
+                }
+            }
+        }
+
+        /// Squared error over the texels of the block inside the image.
+        u64 MeasureBlockError(const Image& _image, u32 _blockX, u32 _blockY, const u8* _source, const u8* _decoded, u32 _channelMask)
+        {
+            u64 error = 0;
+            for (u32 y = 0; y < kBlockDimension && _blockY * kBlockDimension + y < _image.m_height; y++)
+            {
+                for (u32 x = 0; x < kBlockDimension && _blockX * kBlockDimension + x < _image.m_width; x++)
+                {
+                    for (u32 c = 0; c < 4; c++)
+                    {
+                        if ((_channelMask >> c) & 1)
+                        {
+                            const s32 delta = s32(_source[(y * kBlockDimension + x) * 4 + c]) - s32(_decoded[(y * kBlockDimension + x) * 4 + c]);
+                            error += u64(delta * delta);
+                        }
+                    }
+                }
+            }
+            return error;
+        }
+
+        /// Over the stored channels of every texel of the mip, infinite when lossless.
+        f64 GetPsnr(u64 _error, const CompressedMip& _mip, u32 _channelMask)
+        {
+            const f64 meanError = f64(_error) / (f64(_mip.m_width) * _mip.m_height * std::popcount(_channelMask));
+            return meanError == 0.0 ? std::numeric_limits<f64>::infinity() : 10.0 * std::log10(255.0 * 255.0 / meanError);
+        }
+    }
+
+    CompressedTexture CompressTexture(JobSystem& _jobSystem, std::span<const Image> _mips, const CompressionSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("CompressTexture", GetTextureFormatName(_settings.m_format));
+        CompressedTexture texture;
+        texture.m_format = _settings.m_format;
+        texture.m_srgb = _settings.m_srgb && IsColorFormat(_settings.m_format);
+        if (_mips.empty())
+        {
+            return texture;
+        }
+        texture.m_width = _mips.front().m_width;
+        texture.m_height = _mips.front().m_height;
+
+        const ScratchScope scratch;
+        const u32 blockSize = GetBlockSize(_settings.m_format);
+        ArenaVector<Tile> tiles(scratch);
+        u64 offset = 0;
+        for (u32 m = 0; m < _mips.size(); m++)
+        {
+            CompressedMip& mip = texture.m_mips.emplace_back();
+            mip.m_width = _mips[m].m_width;
+            mip.m_height = _mips[m].m_height;
+            const u32 blocksX = (mip.m_width + kBlockDimension - 1) / kBlockDimension;
+            const u32 blocksY = (mip.m_height + kBlockDimension - 1) / kBlockDimension;
+            mip.m_offset = offset;
+            mip.m_size = u64(blocksX) * blocksY * blockSize;
+            offset += mip.m_size;
+
+            for (u32 y = 0; y < blocksY; y += kTileBlocks)
+            {
+                for (u32 x = 0; x < blocksX; x += kTileBlocks)
+                {
+                    tiles.push_back({ m, x, y });
+                }
+            }
+        }
+        texture.m_data.resize(offset);
+
+        const u32 channelMask = GetStoredChannelMask(_settings.m_format);
+        ArenaVector<u64> tileErrors(_settings.m_computeStatistics ? tiles.size() : 0, 0, scratch);
+        _jobSystem.ParallelFor(tiles.size(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 t = _begin; t < _end; t++)
+            {
+                const Tile& tile = tiles[t];
+                const Image& image = _mips[tile.m_mip];
+                const CompressedMip& mip = texture.m_mips[tile.m_mip];
+                const u32 blocksX = (mip.m_width + kBlockDimension - 1) / kBlockDimension;
+                const u32 blocksY = (mip.m_height + kBlockDimension - 1) / kBlockDimension;
+
+                for (u32 y = tile.m_blockY; y < std::min(blocksY, tile.m_blockY + kTileBlocks); y++)
+                {
+                    for (u32 x = tile.m_blockX; x < std::min(blocksX, tile.m_blockX + kTileBlocks); x++)
+                    {
+                        u8 pixels[kBlockPixelBytes];
+                        LoadBlock(image, x, y, pixels);
+                        u8* block = texture.m_data.data() + mip.m_offset + (u64(y) * blocksX + x) * blockSize;
+                        EncodeBlock(_settings.m_format, _settings.m_quality, pixels, block);
+                        if (_settings.m_computeStatistics)
+                        {
+                            u8 decoded[kBlockPixelBytes];
+                            DecodeBlock(_settings.m_format, block, decoded);
+                            tileErrors[t] += MeasureBlockError(image, x, y, pixels, decoded, channelMask);
+                        }
+                    }
+                }
+            }
+        });
+
+        if (_settings.m_computeStatistics)
+        {
+            ArenaVector<u64> mipErrors(texture.m_mips.size(), 0, scratch);
+            for (size_t t = 0; t < tiles.size(); t++)
+            {
+                mipErrors[tiles[t].m_mip] += tileErrors[t];
+            }
+            for (size_t m = 0; m < texture.m_mips.size(); m++)
+            {
+                texture.m_mips[m].m_psnr = GetPsnr(mipErrors[m], texture.m_mips[m], channelMask);
+            }
+        }
+        return texture;
+    }
+
+    void MeasureCompressionError(JobSystem& _jobSystem, std::span<const Image> _mips, CompressedTexture& _texture)
+    {
+        KT_TRACE_ZONE_DETAIL("MeasureCompressionError", GetTextureFormatName(_texture.m_format));
+        KT_VERIFY(_mips.size() == _texture.m_mips.size(), "%zu source mips for %zu compressed ones", _mips.size(), _texture.m_mips.size());
+        const u32 blockSize = GetBlockSize(_texture.m_format);
+        const u32 channelMask = GetStoredChannelMask(_texture.m_format);
+        for (size_t m = 0; m < _mips.size(); m++)
+        {
+            const Image& image = _mips[m];
+            CompressedMip& mip = _texture.m_mips[m];
+            KT_VERIFY(
+                image.m_width == mip.m_width && image.m_height == mip.m_height,
+                "Mip %zu is %ux%u, its source %ux%u",
+                m,
+                mip.m_width,
+                mip.m_height,
+                image.m_width,
+                image.m_height);
+            const u32 blocksX = (mip.m_width + kBlockDimension - 1) / kBlockDimension;
+            const u32 blocksY = (mip.m_height + kBlockDimension - 1) / kBlockDimension;
+            KT_VERIFY(mip.m_offset + u64(blocksX) * blocksY * blockSize <= _texture.m_data.size(), "Mip %zu overruns the texture data", m);
+
+            std::atomic<u64> error = 0;
+            _jobSystem.ParallelFor(blocksY, 1, [&](u64 _begin, u64 _end)
+            {
+                u64 rowsError = 0;
+                for (u64 y = _begin; y < _end; y++)
+                {
+                    for (u32 x = 0; x < blocksX; x++)
+                    {
+                        u8 pixels[kBlockPixelBytes];
+                        u8 decoded[kBlockPixelBytes];
+                        LoadBlock(image, x, u32(y), pixels);
+                        DecodeBlock(_texture.m_format, _texture.m_data.data() + mip.m_offset + (y * blocksX + x) * blockSize, decoded);
+                        rowsError += MeasureBlockError(image, x, u32(y), pixels, decoded, channelMask);
+                    }
+                }
+                error += rowsError;
+            });
+            mip.m_psnr = GetPsnr(error, mip, channelMask);
+        }
+    }
+}
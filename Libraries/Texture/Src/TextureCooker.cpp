@@ -0,0 +1,144 @@
+#include "KryneTools/Texture/TextureCooker.hpp"
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Texture/GpuTextureCompressor.hpp"
+#include "KryneTools/Texture/TextureWriter.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        bool UsesGpu(const TextureCookSettings& _settings)
+        {
+            return _settings.m_gpu != nullptr
+                && !_settings.m_computeStatistics
+                && GpuTextureCompressor::Supports(_settings.m_format, _settings.m_quality);
+        }
+
+        /// @param _gpu The output comes from `TextureCookSettings::m_gpu`, rather than the CPU encoders.
+        CacheKey MakeCacheKey(JobSystem& _jobSystem, const TextureCookSettings& _settings, const std::filesystem::path& _output, bool _gpu)
+        {
+            CacheKeyBuilder builder("kryne-texcook");
+            builder.AddU64(u64(_settings.m_format));
+            builder.AddU64(u64(_settings.m_quality));
+            builder.AddU64(u64(_settings.m_container));
+            builder.AddU64(_settings.m_srgb ? 1 : 0);
+            builder.AddU64(_settings.m_normalMap ? 1 : 0);
+            builder.AddU64(_settings.m_generateMips ? 1 : 0);
+            // GPU blocks are not bit identical to CPU ones, nor across drivers.
+            if (_gpu)
+            {
+                builder.AddString("gpu");
+                builder.AddString(_settings.m_gpu->GetDeviceKey());
+            }
+            builder.AddFile(_jobSystem, _settings.m_input);
+            // The file name derives from the input name, which is not part of its content.
+            builder.AddString(_output.filename().generic_string());
+            return builder.Build();
+        }
+    }
+
+    TextureCookResult CookTexture(JobSystem& _jobSystem, const TextureCookSettings& _settings)
+    {
+        KT_TRACE_ZONE_DETAIL("CookTexture", _settings.m_input.string());
+        const std::filesystem::path directory = _settings.m_outputDirectory.empty() ? _settings.m_input.parent_path() : _settings.m_outputDirectory;
+        TextureCookResult result;
+        result.m_output = directory / _settings.m_input.filename().replace_extension(GetTextureContainerExtension(_settings.m_container));
+        const std::filesystem::path outputDirectory = directory.empty() ? std::filesystem::path(".") : directory;
+
+        CacheKey cacheKey;
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            cacheKey = MakeCacheKey(_jobSystem, _settings, result.m_output, UsesGpu(_settings));
+            if (_settings.m_cache->Restore(cacheKey, outputDirectory))
+            {
+                Log::Verbose("%s: restored from cache (%s)", _settings.m_input.string().c_str(), cacheKey.ToString().c_str());
+                result.m_cacheHit = true;
+                return result;
+            }
+        }
+
+        if (_settings.m_remoteCook && !_settings.m_computeStatistics && _settings.m_remoteCook(_settings, result.m_output))
+        {
+            result.m_remote = true;
+            if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+            {
+                // Workers have no GPU compressor, whatever the local settings.
+                const CacheKey cpuKey = UsesGpu(_settings) ? MakeCacheKey(_jobSystem, _settings, result.m_output, false) : cacheKey;
+                _settings.m_cache->Store(cpuKey, outputDirectory, std::span(&result.m_output, 1));
+            }
+            return result;
+        }
+
+        Image image = LoadImage(_settings.m_input);
+        result.m_width = image.m_width;
+        result.m_height = image.m_height;
+
+        MipSettings mipSettings;
+        mipSettings.m_srgb = _settings.m_srgb && IsColorFormat(_settings.m_format);
+        mipSettings.m_normalMap = _settings.m_normalMap;
+        CompressionSettings compressionSettings;
+        compressionSettings.m_format = _settings.m_format;
+        compressionSettings.m_quality = _settings.m_quality;
+        compressionSettings.m_srgb = _settings.m_srgb && !_settings.m_normalMap;
+        compressionSettings.m_computeStatistics = _settings.m_computeStatistics;
+
+        std::optional<CompressedTexture> gpuTexture;
+        if (UsesGpu(_settings))
+        {
+            try
+            {
+                gpuTexture = _settings.m_gpu->Cook(image, _settings.m_generateMips, mipSettings, compressionSettings);
+            }
+            catch (const Error& exception)
+            {
+                Log::Warning("%s: GPU cook failed, cooking on the CPU: %s", _settings.m_input.string().c_str(), exception.what());
+            }
+        }
+
+        CompressedTexture texture;
+        if (gpuTexture.has_value())
+        {
+            texture = std::move(*gpuTexture);
+        }
+        else
+        {
+            std::vector<Image> mips;
+            if (_settings.m_generateMips)
+            {
+                mips = GenerateMips(_jobSystem, std::move(image), mipSettings);
+            }
+            else
+            {
+                mips.push_back(std::move(image));
+            }
+            texture = CompressTexture(_jobSystem, mips, compressionSettings);
+        }
+
+        if (_settings.m_container == TextureContainer::Dds)
+        {
+            WriteDds(result.m_output, texture);
+        }
+        else
+        {
+            KtexWriteSettings writeSettings;
+            writeSettings.m_normalMap = _settings.m_normalMap;
+            WriteKtex(result.m_output, texture, writeSettings);
+        }
+        result.m_mips = texture.m_mips;
+
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            // A GPU fallback produced CPU blocks, which must not answer later GPU cooks.
+            if (UsesGpu(_settings) && !gpuTexture.has_value())
+            {
+                cacheKey = MakeCacheKey(_jobSystem, _settings, result.m_output, false);
+            }
+            _settings.m_cache->Store(cacheKey, outputDirectory, std::span(&result.m_output, 1));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,375 @@
+#include "KryneTools/Texture/VirtualTextureBuilder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <unordered_map>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+namespace KryneTools
+{
+    namespace
+    {
+        using VirtualTextureFileFormat::AddressMode;
+
+        VirtualTextureFileFormat::BlockFormat GetBlockFormat(TextureFormat _format)
+        {
+            switch (_format)
+            {
+            case TextureFormat::Bc1: return VirtualTextureFileFormat::BlockFormat::Bc1;
+            case TextureFormat::Bc3: return VirtualTextureFileFormat::BlockFormat::Bc3;
+            case TextureFormat::Bc4: return VirtualTextureFileFormat::BlockFormat::Bc4;
+            case TextureFormat::Bc5: return VirtualTextureFileFormat::BlockFormat::Bc5;
+            case TextureFormat::Bc7: return VirtualTextureFileFormat::BlockFormat::Bc7;
+            case TextureFormat::Astc4x4: return VirtualTextureFileFormat::BlockFormat::Astc4x4;
+            }
+            ThrowError("Unsupported texture format %u", u32(_format));
+        }
+
+        struct PagedMip
+        {
+            u32 m_width = 0;
+            u32 m_height = 0;
+            u32 m_pagesX = 0;
+            u32 m_pagesY = 0;
+            u32 m_tableWidthLog2 = 0;
+            u32 m_tableHeightLog2 = 0;
+            std::vector<u32> m_table;
+        };
+
+        struct Page
+        {
+            u32 m_tableIndex;
+            u32 m_x;
+            u32 m_y;
+        };
+
+        u32 AddressTexel(s64 _coordinate, u32 _size, AddressMode _mode)
+        {
+            if (_mode == AddressMode::Wrap)
+            {
+                const s64 wrapped = _coordinate % s64(_size);
+                return u32(wrapped < 0 ? wrapped + _size : wrapped);
+            }
+            return u32(std::clamp<s64>(_coordinate, 0, s64(_size) - 1));
+        }
+
+        /// Compresses one layer of a page with its borders, texels past the mip edges being clamped or wrapped.
+        void EncodePage(const Image& _mip, const VirtualTextureSettings& _settings, TextureFormat _format, u32 _pageX, u32 _pageY, u8* _output)
+        {
+            const u32 extent = _settings.m_pageSize + 2 * _settings.m_border;
+            const u32 blockCount = extent / kBlockDimension;
+            const u32 blockSize = GetBlockSize(_format);
+
+            // Addressing is resolved once per column and row, not per texel.
+            std::vector<u32> columns(extent);
+            std::vector<u32> rows(extent);
+            const s64 originX = s64(_pageX) * _settings.m_pageSize - _settings.m_border;
+            const s64 originY = s64(_pageY) * _settings.m_pageSize - _settings.m_border;
+            for (u32 i = 0; i < extent; i++)
+            {
+                columns[i] = AddressTexel(originX + i, _mip.m_width, _settings.m_addressMode);
+                rows[i] = AddressTexel(originY + i, _mip.m_height, _settings.m_addressMode);
+            }
+
+            u8 pixels[kBlockPixelBytes];
+            for (u32 blockY = 0; blockY < blockCount; blockY++)
+            {
+                for (u32 blockX = 0; blockX < blockCount; blockX++)
+                {
+                    for (u32 y = 0; y < kBlockDimension; y++)
+                    {
+                        for (u32 x = 0; x < kBlockDimension; x++)
+                        {
+                            const u8* texel = _mip.GetPixel(columns[blockX * kBlockDimension + x], rows[blockY * kBlockDimension + y]);
+                            std::copy_n(texel, 4, pixels + (y * kBlockDimension + x) * 4);
+                        }
+                    }
+                    EncodeBlock(_format, _settings.m_quality, pixels, _output + (u64(blockY) * blockCount + blockX) * blockSize);
+                }
+            }
+        }
+
+        CacheKey MakeCacheKey(JobSystem& _jobSystem, const VirtualTextureSettings& _settings, const std::filesystem::path& _output)
+        {
+            CacheKeyBuilder builder("kryne-vtex");
+            builder.AddU64(VirtualTextureFileFormat::kVersion);
+            builder.AddU64(_settings.m_pageSize);
+            builder.AddU64(_settings.m_border);
+            builder.AddU64(u64(_settings.m_addressMode));
+            builder.AddU64(u64(_settings.m_quality));
+            builder.AddU64(_settings.m_pageAlignment);
+            for (const VirtualTextureLayer& layer: _settings.m_layers)
+            {
+                builder.AddU64(u64(layer.m_format));
+                builder.AddU64(layer.m_srgb ? 1 : 0);
+                builder.AddU64(layer.m_normalMap ? 1 : 0);
+                builder.AddFile(_jobSystem, layer.m_input);
+            }
+            builder.AddString(_output.filename().generic_string());
+            return builder.Build();
+        }
+
+        /// Fills the statistics of a restored page file from its prologue.
+        void ReadRestoredStatistics(VirtualTextureResult& _result)
+        {
+            const MappedFile file = MappedFile::Open(_result.m_output);
+            const std::span<const u8> data = file.GetData();
+            VirtualTextureFileFormat::Header header;
+            KT_VERIFY(data.size() >= sizeof(header), "'%s': truncated page file header", _result.m_output.string().c_str());
+            std::memcpy(&header, data.data(), sizeof(header));
+            KT_VERIFY(header.m_magic == VirtualTextureFileFormat::kMagic, "'%s': not a page file", _result.m_output.string().c_str());
+
+            const u64 mipsOffset = sizeof(header) + u64(header.m_layerCount) * sizeof(VirtualTextureFileFormat::LayerEntry);
+            KT_VERIFY(
+                mipsOffset + u64(header.m_mipCount) * sizeof(VirtualTextureFileFormat::MipEntry) <= data.size(),
+                "'%s': truncated mip table",
+                _result.m_output.string().c_str());
+            _result.m_width = header.m_width;
+            _result.m_height = header.m_height;
+            _result.m_mipCount = header.m_mipCount;
+            for (u32 m = 0; m < header.m_mipCount; m++)
+            {
+                VirtualTextureFileFormat::MipEntry mip;
+                std::memcpy(&mip, data.data() + mipsOffset + m * sizeof(mip), sizeof(mip));
+                _result.m_pageCount += u64(mip.m_pagesX) * mip.m_pagesY;
+            }
+            _result.m_physicalPageCount = header.m_physicalPageCount;
+            _result.m_size = header.m_fileSize;
+            _result.m_cacheHit = true;
+        }
+    }
+
+    VirtualTextureResult BuildVirtualTexture(JobSystem& _jobSystem, const VirtualTextureSettings& _settings)
+    {
+        KT_VERIFY(!_settings.m_layers.empty(), "A virtual texture needs at least one layer");
+        KT_TRACE_ZONE_DETAIL("BuildVirtualTexture", _settings.m_layers.front().m_input.string());
+        KT_VERIFY(_settings.m_layers.size() <= 255, "Too many virtual texture layers (%zu)", _settings.m_layers.size());
+        KT_VERIFY(
+            std::has_single_bit(_settings.m_pageSize) && _settings.m_pageSize >= kBlockDimension && _settings.m_pageSize <= 4096,
+            "Invalid page size %u, expected a power of two from 4 to 4096",
+            _settings.m_pageSize);
+        KT_VERIFY(
+            _settings.m_border * 2 <= _settings.m_pageSize && (2 * _settings.m_border) % kBlockDimension == 0,
+            "Invalid page border %u, expected an even value up to half the page size",
+            _settings.m_border);
+        KT_VERIFY(
+            std::has_single_bit(_settings.m_pageAlignment) && _settings.m_pageAlignment >= 16,
+            "Invalid page alignment %u",
+            _settings.m_pageAlignment);
+
+        VirtualTextureResult result;
+        result.m_output = _settings.m_output.empty() ? std::filesystem::path(_settings.m_layers.front().m_input).replace_extension(".kvt") : _settings.m_output;
+        const std::filesystem::path outputDirectory = result.m_output.has_parent_path() ? result.m_output.parent_path() : std::filesystem::path(".");
+
+        CacheKey cacheKey;
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            cacheKey = MakeCacheKey(_jobSystem, _settings, result.m_output);
+            if (_settings.m_cache->Restore(cacheKey, outputDirectory))
+            {
+                Log::Verbose("%s: restored from cache (%s)", result.m_output.string().c_str(), cacheKey.ToString().c_str());
+                ReadRestoredStatistics(result);
+                return result;
+            }
+        }
+
+        // Layers load and filter concurrently, each mip chain spreading on the pool too.
+        std::vector<std::vector<Image>> layerMips(_settings.m_layers.size());
+        JobGroup group;
+        for (size_t l = 0; l < _settings.m_layers.size(); l++)
+        {
+            _jobSystem.Spawn(group, [&, l]
+            {
+                const VirtualTextureLayer& layer = _settings.m_layers[l];
+                MipSettings mipSettings;
+                mipSettings.m_srgb = layer.m_srgb && IsColorFormat(layer.m_format);
+                mipSettings.m_normalMap = layer.m_normalMap;
+                layerMips[l] = GenerateMips(_jobSystem, LoadImage(layer.m_input), mipSettings);
+            });
+        }
+        _jobSystem.Wait(group);
+
+        const Image& top = layerMips.front().front();
+        for (size_t l = 1; l < layerMips.size(); l++)
+        {
+            const Image& image = layerMips[l].front();
+            KT_VERIFY(
+                image.m_width == top.m_width && image.m_height == top.m_height,
+                "%s: %ux%u, all layers must match the %ux%u of the first one",
+                _settings.m_layers[l].m_input.string().c_str(),
+                image.m_width,
+                image.m_height,
+                top.m_width,
+                top.m_height);
+        }
+        result.m_width = top.m_width;
+        result.m_height = top.m_height;
+
+        // Down to the first mip fitting a single page, coarser ones are the business of regular textures.
+        u32 mipCount = 1;
+        while (mipCount < layerMips.front().size() && (layerMips.front()[mipCount - 1].m_width > _settings.m_pageSize || layerMips.front()[mipCount - 1].m_height > _settings.m_pageSize))
+        {
+            mipCount++;
+        }
+        result.m_mipCount = mipCount;
+
+        const u32 extent = _settings.m_pageSize + 2 * _settings.m_border;
+        const u64 pageBlockCount = u64(extent / kBlockDimension) * (extent / kBlockDimension);
+        std::vector<VirtualTextureFileFormat::LayerEntry> layerEntries(_settings.m_layers.size());
+        u64 pageSize = 0;
+        for (size_t l = 0; l < _settings.m_layers.size(); l++)
+        {
+            const VirtualTextureLayer& layer = _settings.m_layers[l];
+            VirtualTextureFileFormat::LayerEntry& entry = layerEntries[l];
+            entry.m_format = GetBlockFormat(layer.m_format);
+            entry.m_flags = u8(
+                (layer.m_srgb && !layer.m_normalMap && IsColorFormat(layer.m_format) ? TextureFileFormat::kFlagSrgb : 0)
+                | (layer.m_normalMap ? TextureFileFormat::kFlagNormalMap : 0));
+            entry.m_offset = u32(pageSize);
+            entry.m_size = u32(pageBlockCount * GetBlockSize(layer.m_format));
+            pageSize += entry.m_size;
+        }
+        const u64 pageStride = AlignUp(pageSize, _settings.m_pageAlignment);
+        KT_VERIFY(pageStride <= ~0u, "Pages of %llu bytes are too large", static_cast<unsigned long long>(pageStride));
+
+        std::vector<PagedMip> mips(mipCount);
+        u64 prologueSize = sizeof(VirtualTextureFileFormat::Header)
+            + layerEntries.size() * sizeof(VirtualTextureFileFormat::LayerEntry)
+            + mipCount * sizeof(VirtualTextureFileFormat::MipEntry);
+        std::vector<VirtualTextureFileFormat::MipEntry> mipEntries(mipCount);
+        for (u32 m = 0; m < mipCount; m++)
+        {
+            PagedMip& mip = mips[m];
+            mip.m_width = layerMips.front()[m].m_width;
+            mip.m_height = layerMips.front()[m].m_height;
+            mip.m_pagesX = (mip.m_width + _settings.m_pageSize - 1) / _settings.m_pageSize;
+            mip.m_pagesY = (mip.m_height + _settings.m_pageSize - 1) / _settings.m_pageSize;
+            mip.m_tableWidthLog2 = u32(std::bit_width(mip.m_pagesX - 1));
+            mip.m_tableHeightLog2 = u32(std::bit_width(mip.m_pagesY - 1));
+            mip.m_table.assign(size_t(1) << (mip.m_tableWidthLog2 + mip.m_tableHeightLog2), VirtualTextureFileFormat::kNoPage);
+            result.m_pageCount += u64(mip.m_pagesX) * mip.m_pagesY;
+
+            mipEntries[m] = {
+                mip.m_width,
+                mip.m_height,
+                mip.m_pagesX,
+                mip.m_pagesY,
+                u8(mip.m_tableWidthLog2),
+                u8(mip.m_tableHeightLog2),
+                0,
+                u32(prologueSize),
+            };
+            prologueSize += mip.m_table.size() * sizeof(u32);
+        }
+        prologueSize = AlignUp(prologueSize, _settings.m_pageAlignment);
+        KT_VERIFY(prologueSize <= ~0u, "Page tables of %llu bytes are too large", static_cast<unsigned long long>(prologueSize));
+
+        // Smallest mip first, the ones a runtime streams first. Identical pages are searched serially in file order,
+        // so the output does not depend on the worker count.
+        std::vector<u8> physicalPages;
+        std::unordered_multimap<u64, u32> pagesByHash;
+        u32 physicalPageCount = 0;
+        for (u32 m = mipCount; m-- > 0;)
+        {
+            KT_TRACE_ZONE("EncodeMipPages");
+            PagedMip& mip = mips[m];
+            std::vector<Page> pages;
+            pages.reserve(size_t(mip.m_pagesX) * mip.m_pagesY);
+            for (u32 y = 0; y < mip.m_pagesY; y++)
+            {
+                for (u32 x = 0; x < mip.m_pagesX; x++)
+                {
+                    pages.push_back({ VirtualTextureFileFormat::GetPageTableIndex(x, y, mip.m_tableWidthLog2, mip.m_tableHeightLog2), x, y });
+                }
+            }
+            std::sort(pages.begin(), pages.end(), [](const Page& _a, const Page& _b) { return _a.m_tableIndex < _b.m_tableIndex; });
+
+            std::vector<u8> encoded(pages.size() * pageSize);
+            std::vector<u64> hashes(pages.size());
+            _jobSystem.ParallelFor(pages.size(), 1, [&](u64 _begin, u64 _end)
+            {
+                for (u64 p = _begin; p < _end; p++)
+                {
+                    u8* page = encoded.data() + p * pageSize;
+                    for (size_t l = 0; l < _settings.m_layers.size(); l++)
+                    {
+                        EncodePage(layerMips[l][m], _settings, _settings.m_layers[l].m_format, pages[p].m_x, pages[p].m_y, page + layerEntries[l].m_offset);
+                    }
+                    hashes[p] = Hash64(page, pageSize);
+                }
+            });
+
+            for (size_t p = 0; p < pages.size(); p++)
+            {
+                const u8* page = encoded.data() + p * pageSize;
+                u32 physicalPage = VirtualTextureFileFormat::kNoPage;
+                const auto [first, last] = pagesByHash.equal_range(hashes[p]);
+                for (auto candidate = first; candidate != last; ++candidate)
+                {
+                    if (std::memcmp(physicalPages.data() + u64(candidate->second) * pageSize, page, pageSize) == 0)
+                    {
+                        physicalPage = candidate->second;
+                        break;
+                    }
+                }
+                if (physicalPage == VirtualTextureFileFormat::kNoPage)
+                {
+                    physicalPage = physicalPageCount++;
+                    physicalPages.insert(physicalPages.end(), page, page + pageSize);
+                    pagesByHash.emplace(hashes[p], physicalPage);
+                }
+                mip.m_table[pages[p].m_tableIndex] = physicalPage;
+            }
+        }
+        result.m_physicalPageCount = physicalPageCount;
+        result.m_size = prologueSize + u64(physicalPageCount) * pageStride;
+
+        VirtualTextureFileFormat::Header header {};
+        header.m_magic = VirtualTextureFileFormat::kMagic;
+        header.m_version = VirtualTextureFileFormat::kVersion;
+        header.m_headerSize = sizeof(VirtualTextureFileFormat::Header);
+        header.m_width = result.m_width;
+        header.m_height = result.m_height;
+        header.m_pageSize = u16(_settings.m_pageSize);
+        header.m_border = u16(_settings.m_border);
+        header.m_mipCount = u8(mipCount);
+        header.m_layerCount = u8(layerEntries.size());
+        header.m_addressMode = _settings.m_addressMode;
+        header.m_pageAlignment = _settings.m_pageAlignment;
+        header.m_pageStride = u32(pageStride);
+        header.m_physicalPageCount = physicalPageCount;
+        header.m_prologueSize = u32(prologueSize);
+        header.m_fileSize = result.m_size;
+
+        FileWriter writer(result.m_output);
+        writer.WritePod(header);
+        writer.WriteSpan(std::span<const VirtualTextureFileFormat::LayerEntry>(layerEntries));
+        writer.WriteSpan(std::span<const VirtualTextureFileFormat::MipEntry>(mipEntries));
+        for (const PagedMip& mip: mips)
+        {
+            writer.WriteSpan(std::span<const u32>(mip.m_table));
+        }
+        for (u32 p = 0; p < physicalPageCount; p++)
+        {
+            writer.Align(_settings.m_pageAlignment);
+            writer.Write(physicalPages.data() + u64(p) * pageSize, pageSize);
+        }
+        writer.Align(_settings.m_pageAlignment);
+        writer.Commit();
+
+        if (_settings.m_cache != nullptr && _settings.m_cache->IsEnabled())
+        {
+            _settings.m_cache->Store(cacheKey, outputDirectory, std::span(&result.m_output, 1));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,314 @@
+#include "RegressionCorpus.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "BenchmarkCorpus.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+
+namespace KryneTools::RegressionCorpus
+{
+    namespace
+    {
+        constexpr u32 kTerrainResolution = 64;
+        constexpr u32 kInstanceGrid = 8;
+        constexpr u32 kImageSize = 512;
+        constexpr u32 kBoneCount = 24;
+        constexpr u32 kKeyCount = 121;
+        constexpr f32 kSampleRate = 30.f;
+        constexpr f32 kTwoPi = 2.f * std::numbers::pi_v<f32>;
+
+        /// Binary buffer of a glTF asset, with one buffer view per appended array.
+        struct GltfBuffer
+        {
+            std::vector<u8> m_data;
+            std::string m_views;
+
+            template <class T>
+            u32 Append(const std::vector<T>& _values)
+            {
+                const u64 offset = m_data.size();
+                m_data.resize(offset + _values.size() * sizeof(T));
+                std::memcpy(m_data.data() + offset, _values.data(), _values.size() * sizeof(T));
+                const u32 index = u32(std::count(m_views.begin(), m_views.end(), '{'));
+                m_views += FormatString(
+                    R"(%s{"buffer":0,"byteOffset":%llu,"byteLength":%llu})",
+                    m_views.empty() ? "" : ",",
+                    static_cast<unsigned long long>(offset),
+                    static_cast<unsigned long long>(_values.size() * sizeof(T)));
+                return index;
+            }
+        };
+
+        void WriteText(const std::filesystem::path& _path, const std::string& _text)
+        {
+            FileSystem::WriteFile(_path, { reinterpret_cast<const u8*>(_text.data()), _text.size() });
+        }
+
+        /// Uncompressed 32 bits TGA, top-down.
+        void WriteTga(const std::filesystem::path& _path, const Image& _image)
+        {
+            std::vector<u8> data(18 + _image.m_pixels.size());
+            data[2] = 2;
+            data[12] = u8(_image.m_width);
+            data[13] = u8(_image.m_width >> 8);
+            data[14] = u8(_image.m_height);
+            data[15] = u8(_image.m_height >> 8);
+            data[16] = 32;
+            data[17] = 0x28;
+            for (u64 i = 0; i < _image.m_pixels.size(); i += 4)
+            {
+                data[18 + i + 0] = _image.m_pixels[i + 2];
+                data[18 + i + 1] = _image.m_pixels[i + 1];
+                data[18 + i + 2] = _image.m_pixels[i + 0];
+                data[18 + i + 3] = _image.m_pixels[i + 3];
+            }
+            FileSystem::WriteFile(_path, data);
+        }
+
+        void WriteScene(const std::filesystem::path& _directory)
+        {
+            const BenchmarkCorpus::Terrain terrain = BenchmarkCorpus::MakeTerrain(kTerrainResolution);
+            Aabb bounds;
+            for (const Float3& position: terrain.m_positions)
+            {
+                bounds.Expand(position);
+            }
+
+            GltfBuffer buffer;
+            const u32 positions = buffer.Append(terrain.m_positions);
+            const u32 normals = buffer.Append(terrain.m_normals);
+            const u32 uvs = buffer.Append(terrain.m_uvs);
+            const u32 indices = buffer.Append(terrain.m_indices);
+            FileSystem::WriteFile(_directory / "scene.bin", buffer.m_data);
+
+            // A grid of instances turning and growing along the diagonal, so the level BVH has something to sort.
+            std::string nodes;
+            std::string roots;
+            for (u32 i = 0; i < kInstanceGrid * kInstanceGrid; i++)
+            {
+                const f32 angle = kTwoPi * f32(i) / f32(kInstanceGrid * kInstanceGrid);
+                const f32 scale = 0.5f + f32(i % 5) * 0.25f;
+                nodes += FormatString(
+                    R"(%s{"name":"Tile%u","mesh":0,"translation":[%.1f,%.1f,%.1f],"rotation":[0,%.9g,0,%.9g],"scale":[%.9g,%.9g,%.9g]})",
+                    i == 0 ? "" : ",",
+                    i,
+                    f32(i % kInstanceGrid) * 120.f,
+                    f32(i % 3) * 4.f,
+                    f32(i / kInstanceGrid) * 120.f,
+                    std::sin(angle * 0.5f),
+                    std::cos(angle * 0.5f),
+                    scale,
+                    scale,
+                    scale);
+                roots += FormatString("%s%u", i == 0 ? "" : ",", i);
+            }
+
+            WriteText(_directory / "scene.gltf", FormatString(
+                R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[%s]}],"nodes":[%s],)"
+                R"("buffers":[{"uri":"scene.bin","byteLength":%llu}],"bufferViews":[%s],)"
+                R"("accessors":[{"bufferView":%u,"componentType":5126,"count":%zu,"type":"VEC3","min":[%.9g,%.9g,%.9g],"max":[%.9g,%.9g,%.9g]},)"
+                R"({"bufferView":%u,"componentType":5126,"count":%zu,"type":"VEC3"},)"
+                R"({"bufferView":%u,"componentType":5126,"count":%zu,"type":"VEC2"},)"
+                R"({"bufferView":%u,"componentType":5125,"count":%zu,"type":"SCALAR"}],)"
+                R"("meshes":[{"name":"Terrain","primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":3}]}]})",
+                roots.c_str(),
+                nodes.c_str(),
+                static_cast<unsigned long long>(buffer.m_data.size()),
+                buffer.m_views.c_str(),
+                positions,
+                terrain.m_positions.size(),
+                bounds.m_min.x, bounds.m_min.y, bounds.m_min.z,
+                bounds.m_max.x, bounds.m_max.y, bounds.m_max.z,
+                normals,
+                terrain.m_normals.size(),
+                uvs,
+                terrain.m_uvs.size(),
+                indices,
+                terrain.m_indices.size()));
+        }
+
+        void WriteRig(const std::filesystem::path& _directory)
+        {
+            GltfBuffer buffer;
+            std::vector<f32> times(kKeyCount);
+            for (u32 k = 0; k < kKeyCount; k++)
+            {
+                times[k] = f32(k) / kSampleRate;
+            }
+            std::string accessors = FormatString(
+                R"({"bufferView":%u,"componentType":5126,"count":%u,"type":"SCALAR","min":[0],"max":[%.9g]})",
+                buffer.Append(times),
+                kKeyCount,
+                times.back());
+            u32 accessorCount = 1;
+
+            // Every bone sways about two axes with its own phase, a few are left static.
+            std::string samplers;
+            std::string channels;
+            u32 samplerCount = 0;
+            for (u32 b = 0; b < kBoneCount; b++)
+            {
+                if (b % 7 == 3)
+                {
+                    continue;
+                }
+                std::vector<f32> rotations;
+                for (const f32 time: times)
+                {
+                    const f32 a = 0.3f * std::sin(kTwoPi * 0.5f * time + f32(b) * 0.2f) * 0.5f;
+                    const f32 c = 0.15f * std::sin(kTwoPi * 1.3f * time + f32(b) * 0.5f) * 0.5f;
+                    // Rotation about z by 2a, then about x by 2c.
+                    rotations.insert(rotations.end(), {
+                        std::cos(a) * std::sin(c),
+                        std::sin(a) * std::sin(c),
+                        std::sin(a) * std::cos(c),
+                        std::cos(a) * std::cos(c),
+                    });
+                }
+                accessors += FormatString(R"(,{"bufferView":%u,"componentType":5126,"count":%u,"type":"VEC4"})", buffer.Append(rotations), kKeyCount);
+                samplers += FormatString(R"(%s{"input":0,"output":%u})", samplerCount == 0 ? "" : ",", accessorCount++);
+                channels += FormatString(R"(%s{"sampler":%u,"target":{"node":%u,"path":"rotation"}})", samplerCount == 0 ? "" : ",", samplerCount, b);
+                samplerCount++;
+            }
+
+            std::vector<f32> translations;
+            for (const f32 time: times)
+            {
+                translations.insert(translations.end(), { std::sin(time) * 2.f, 0.f, time * 0.5f });
+            }
+            accessors += FormatString(R"(,{"bufferView":%u,"componentType":5126,"count":%u,"type":"VEC3"})", buffer.Append(translations), kKeyCount);
+            samplers += FormatString(R"(,{"input":0,"output":%u})", accessorCount++);
+            channels += FormatString(R"(,{"sampler":%u,"target":{"node":0,"path":"translation"}})", samplerCount);
+            FileSystem::WriteFile(_directory / "rig.bin", buffer.m_data);
+
+            std::string nodes;
+            std::string joints;
+            for (u32 b = 0; b < kBoneCount; b++)
+            {
+                nodes += FormatString(R"(%s{"name":"Bone%u","translation":[0,%s,0])", b == 0 ? "" : ",", b, b == 0 ? "0" : "0.1");
+                nodes += b + 1 < kBoneCount ? FormatString(R"(,"children":[%u]})", b + 1) : std::string("}");
+                joints += FormatString("%s%u", b == 0 ? "" : ",", b);
+            }
+
+            WriteText(_directory / "rig.gltf", FormatString(
+                R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],"nodes":[%s],"skins":[{"joints":[%s]}],)"
+                R"("animations":[{"name":"Sway","samplers":[%s],"channels":[%s]},)"
+                R"({"name":"Step","samplers":[{"input":0,"output":1,"interpolation":"STEP"}],"channels":[{"sampler":0,"target":{"node":5,"path":"rotation"}}]}],)"
+                R"("accessors":[%s],"bufferViews":[%s],"buffers":[{"uri":"rig.bin","byteLength":%zu}]})",
+                nodes.c_str(),
+                joints.c_str(),
+                samplers.c_str(),
+                channels.c_str(),
+                accessors.c_str(),
+                buffer.m_views.c_str(),
+                buffer.m_data.size()));
+        }
+
+        void WriteImages(const std::filesystem::path& _directory)
+        {
+            WriteTga(_directory / "albedo.tga", BenchmarkCorpus::MakeImage(kImageSize, kImageSize));
+
+            // One terrain vertex per texel.
+            const BenchmarkCorpus::Terrain terrain = BenchmarkCorpus::MakeTerrain(kImageSize - 1);
+            Image normals;
+            normals.Allocate(kImageSize, kImageSize);
+            for (u32 i = 0; i < kImageSize * kImageSize; i++)
+            {
+                // Heightfield normals are y up, tangent space ones z up.
+                const Float3& normal = terrain.m_normals[i];
+                const f32 values[3] = { normal.x, -normal.z, normal.y };
+                for (u32 c = 0; c < 3; c++)
+                {
+                    normals.m_pixels[u64(i) * 4 + c] = u8(std::lround((values[c] * 0.5f + 0.5f) * 255.f));
+                }
+                normals.m_pixels[u64(i) * 4 + 3] = 255;
+            }
+            WriteTga(_directory / "normal.tga", normals);
+        }
+
+        /// Position, normal and uv, interleaved: the vertex layout of the materials.
+        constexpr const char* kVertexShader = R"(#version 450
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec3 a_normal;
+layout(location = 2) in vec2 a_uv;
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 u_viewProjection;
+} pc;
+
+layout(location = 0) out vec3 v_normal;
+layout(location = 1) out vec2 v_uv;
+
+void main()
+{
+    v_normal = a_normal;
+    v_uv = a_uv;
+    gl_Position = pc.u_viewProjection * vec4(a_position, 1.0);
+}
+)";
+
+        constexpr const char* kFragmentShader = R"(#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D u_albedo;
+
+layout(location = 0) in vec3 v_normal;
+layout(location = 1) in vec2 v_uv;
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+    vec4 albedo = texture(u_albedo, v_uv);
+#if ALPHA_TEST
+    if (albedo.a < 0.5)
+    {
+        discard;
+    }
+#endif
+    o_color = vec4(albedo.rgb * (normalize(v_normal).y * 0.5 + 0.5), albedo.a);
+}
+)";
+    }
+
+    void Write(const std::filesystem::path& _directory)
+    {
+        std::filesystem::create_directories(_directory);
+        WriteScene(_directory);
+        WriteRig(_directory);
+        WriteImages(_directory);
+        WriteText(
+            _directory / "cook.json",
+            R"({"textures":[{"source":"albedo.tga","format":"bc7"},{"source":"normal.tga","format":"bc5","normal_map":true}],"meshes":["scene.gltf"]})");
+    }
+
+    void WritePipelines(const std::filesystem::path& _directory)
+    {
+        std::filesystem::create_directories(_directory);
+        WriteText(_directory / "mesh.vert.glsl", kVertexShader);
+        WriteText(_directory / "mesh.frag.glsl", kFragmentShader);
+        WriteText(
+            _directory / "shaders.json",
+            R"({"shaders":[{"name":"mesh_vs","source":"mesh.vert.glsl","stage":"vertex"},)"
+            R"({"name":"mesh_fs","source":"mesh.frag.glsl","stage":"fragment","permutations":[{"name":"ALPHA_TEST","values":["0","1"]}]}]})");
+        // Every fixed function state the runtime varies between materials: cull, depth and blend.
+        WriteText(
+            _directory / "materials.json",
+            R"({"vertex_layouts":{"mesh":{"bindings":[{"binding":0,"stride":32}],"attributes":[)"
+            R"({"location":0,"binding":0,"format":"r32g32b32_sfloat","offset":0},)"
+            R"({"location":1,"binding":0,"format":"r32g32b32_sfloat","offset":12},)"
+            R"({"location":2,"binding":0,"format":"r32g32_sfloat","offset":24}]}},)"
+            R"("render_targets":{"forward":{"colors":["r8g8b8a8_srgb"],"depth":"d32_sfloat"}},"materials":[)"
+            R"({"name":"opaque","vertex_layout":"mesh","render_target":"forward","shaders":[{"shader":"mesh_vs"},{"shader":"mesh_fs","permutation":{"ALPHA_TEST":0}}]},)"
+            R"({"name":"foliage","vertex_layout":"mesh","render_target":"forward","shaders":[{"shader":"mesh_vs"},{"shader":"mesh_fs","permutation":{"ALPHA_TEST":1}}],"state":{"cull":"none"}},)"
+            R"({"name":"glass","vertex_layout":"mesh","render_target":"forward","shaders":[{"shader":"mesh_vs"},{"shader":"mesh_fs","permutation":{"ALPHA_TEST":0}}],)"
+            R"("state":{"depth_write":false,"blend":"alpha"}}]})");
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+
+/**
+ * @brief Fixed inputs of the regression runner, one of each kind the tools consume.
+ *
+ * @details
+ * Built on the generators of the benchmark corpus, every file is deterministic so output hashes can be compared with
+ * the golden ones across commits and machines.
+ */
+namespace KryneTools::RegressionCorpus
+{
+    /**
+     * @brief Writes the corpus to `_directory`:
+     * - `scene.gltf`: a terrain mesh instanced by a grid of rotated and scaled nodes,
+     * - `rig.gltf`: a skinned bone chain with a looping clip and a stepped one,
+     * - `albedo.tga` and `normal.tga`: 512x512 color with alpha, and the tangent space normals of a terrain,
+     * - `cook.json`: a project cooking the scene meshes and both textures.
+     */
+    void Write(const std::filesystem::path& _directory);
+
+    /**
+     * @brief Writes the pipeline corpus to `_directory`, apart from the other inputs as its outputs are not hashed:
+     * - `shaders.json`: a GLSL vertex shader and a fragment shader with an alpha test permutation,
+     * - `materials.json`: three materials of these shaders, differing in permutation and fixed function state.
+     */
+    void WritePipelines(const std::filesystem::path& _directory);
+}
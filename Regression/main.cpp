@@ -0,0 +1,708 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/CpuFeatures.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Process.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Texture/GpuTextureCompressor.hpp"
+#include "RegressionCorpus.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    /// Least slack on top of the relative threshold, for the shortest stages, whose spread rounds to nothing.
+    constexpr f64 kMinNoiseSeconds = 0.005;
+    /// Spreads of slack, an outlier median past that is a slowdown rather than noise.
+    constexpr f64 kNoiseSpreads = 4.0;
+    constexpr const char* kOutputToken = "{output}";
+    /// PSNR the GPU encoders may lose against the CPU reference on a mip, their blocks are close but not identical.
+    constexpr f64 kGpuPsnrToleranceDb = 1.0;
+
+    using FileHashes = std::vector<std::pair<std::string, u64>>;
+
+    /// Tool invocations of a stage, `kOutputToken` standing for the output directory of the run.
+    struct Stage
+    {
+        const char* m_name;
+        const char* m_tool;
+        std::vector<std::vector<std::string>> m_commands;
+        /// Also runs the stage under `KRYNE_SIMD` forced to every level the CPU supports, the outputs must not change.
+        bool m_compareSimdLevels = false;
+    };
+
+    /// Sets an environment variable of the runner, which the tools it starts inherit, until the end of the scope.
+    class ScopedEnvironment
+    {
+    public:
+        ScopedEnvironment(const char* _name, const char* _value)
+            : m_name(_name)
+        {
+            if (const char* previous = std::getenv(_name))
+            {
+                m_previous = previous;
+            }
+            Set(_value);
+        }
+
+        ~ScopedEnvironment()
+        {
+            Set(m_previous.has_value() ? m_previous->c_str() : nullptr);
+        }
+
+        ScopedEnvironment(const ScopedEnvironment&) = delete;
+        ScopedEnvironment& operator=(const ScopedEnvironment&) = delete;
+
+    private:
+        std::string m_name;
+        std::optional<std::string> m_previous;
+
+        /// Null removes the variable.
+        void Set(const char* _value)
+        {
+#if defined(_WIN32)
+            _putenv_s(m_name.c_str(), _value != nullptr ? _value : "");
+#else
+            if (_value != nullptr)
+            {
+                setenv(m_name.c_str(), _value, 1);
+            }
+            else
+            {
+                unsetenv(m_name.c_str());
+            }
+#endif
+        }
+    };
+
+    struct StageResult
+    {
+        std::string m_name;
+        FileHashes m_hashes;
+        std::vector<f64> m_runSeconds;
+        std::vector<std::string> m_failures;
+    };
+
+    struct Timing
+    {
+        f64 m_seconds = 0.0;
+        /// Median absolute deviation of the runs, scaled to estimate a standard deviation.
+        f64 m_spread = 0.0;
+    };
+
+    f64 GetMedian(std::vector<f64> _values)
+    {
+        std::sort(_values.begin(), _values.end());
+        const size_t middle = _values.size() / 2;
+        return _values.size() % 2 != 0 ? _values[middle] : (_values[middle - 1] + _values[middle]) * 0.5;
+    }
+
+    /// Median rather than fastest run: a single lucky run no longer sets a reference the others cannot meet.
+    Timing MeasureTiming(const std::vector<f64>& _runSeconds)
+    {
+        Timing timing;
+        timing.m_seconds = GetMedian(_runSeconds);
+        std::vector<f64> deviations;
+        for (const f64 seconds: _runSeconds)
+        {
+            deviations.push_back(std::abs(seconds - timing.m_seconds));
+        }
+        timing.m_spread = GetMedian(std::move(deviations)) * 1.4826;
+        return timing;
+    }
+
+    std::vector<Stage> MakeStages(const std::filesystem::path& _corpus)
+    {
+        const auto input = [&](const char* _name) { return (_corpus / _name).string(); };
+        return {
+            // Vertex packing has a kernel per SIMD level, the scalar one being the reference.
+            { "import", "import", { { "--no-cache", "--o", kOutputToken, input("scene.gltf") } }, true },
+            { "level", "level", { { "--no-cache", "--o", kOutputToken, "--mesh-directory", "meshes", input("scene.gltf") } } },
+            { "anim", "anim", { { "--no-cache", "--o", kOutputToken, input("rig.gltf") } } },
+            {
+                "texcook",
+                "texcook",
+                {
+                    { "--no-cache", "--o", kOutputToken, "--format", "bc7", input("albedo.tga") },
+                    { "--no-cache", "--o", kOutputToken, "--format", "bc5", "--normal-map", input("normal.tga") },
+                    { "--no-cache", "--o", kOutputToken, "--format", "bc1", "--quality", "high", "--container", "dds", input("albedo.tga") },
+                },
+            },
+            {
+                "vtex",
+                "vtex",
+                { { "--no-cache", "--o", std::string(kOutputToken) + "/terrain.kvt", "--page-size", "64", input("albedo.tga") + ":bc7", input("normal.tga") + ":bc5:normal-map" } },
+            },
+            { "pack", "pack", { { "--no-cache", "--o", std::string(kOutputToken) + "/corpus.kpak", _corpus.string() } } },
+            // Without --pack: streamed archives are in completion order by design, the pack stage covers archives.
+            { "cook", "cook", { { "--no-cache", "--o", kOutputToken, input("cook.json") } } },
+        };
+    }
+
+    FileHashes HashOutputs(const std::filesystem::path& _directory)
+    {
+        FileHashes hashes;
+        for (const std::filesystem::directory_entry& entry: std::filesystem::recursive_directory_iterator(_directory))
+        {
+            if (entry.is_regular_file())
+            {
+                const std::vector<u8> data = FileSystem::ReadFile(entry.path());
+                hashes.emplace_back(entry.path().lexically_relative(_directory).generic_string(), Hash64(data));
+            }
+        }
+        std::sort(hashes.begin(), hashes.end());
+        return hashes;
+    }
+
+    /// Runs every command of the stage to `_output`, returns the wall time or records why it failed.
+    f64 RunStage(const Stage& _stage, const std::string& _tool, const std::filesystem::path& _output, std::span<const std::string> _extraArguments, StageResult& _result)
+    {
+        std::filesystem::remove_all(_output);
+        std::filesystem::create_directories(_output);
+        const std::string outputString = _output.string();
+
+        f64 seconds = 0.0;
+        for (const std::vector<std::string>& command: _stage.m_commands)
+        {
+            std::vector<std::string> arguments { _tool };
+            for (const std::string& argument: command)
+            {
+                const size_t token = argument.find(kOutputToken);
+                arguments.push_back(token == std::string::npos ? argument : std::string(argument).replace(token, std::strlen(kOutputToken), outputString));
+            }
+            arguments.insert(arguments.end(), _extraArguments.begin(), _extraArguments.end());
+
+            const auto start = std::chrono::steady_clock::now();
+            const ProcessResult process = RunProcess(arguments);
+            seconds += std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+            if (process.m_exitCode != 0)
+            {
+                _result.m_failures.push_back(FormatString("%s exited with %d:\n%s", _tool.c_str(), process.m_exitCode, process.m_output.c_str()));
+                return seconds;
+            }
+        }
+        return seconds;
+    }
+
+    /// Lines of `stage path hash` in the golden file.
+    std::map<std::string, FileHashes> ReadGolden(const std::filesystem::path& _path)
+    {
+        std::map<std::string, FileHashes> golden;
+        std::ifstream file(_path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            std::string stage;
+            std::string path;
+            std::string hash;
+            if (line.empty() || line.front() == '#' || !(stream >> stage >> path >> hash))
+            {
+                continue;
+            }
+            golden[stage].emplace_back(path, std::stoull(hash, nullptr, 16));
+        }
+        return golden;
+    }
+
+    struct Baseline
+    {
+        std::string m_machine;
+        std::map<std::string, Timing> m_timings;
+    };
+
+    /// A `# machine: <key>` line, then lines of `stage seconds spread`.
+    Baseline ReadBaseline(const std::filesystem::path& _path)
+    {
+        constexpr std::string_view kMachinePrefix = "# machine: ";
+        Baseline baseline;
+        std::ifstream file(_path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.starts_with(kMachinePrefix))
+            {
+                baseline.m_machine = line.substr(kMachinePrefix.size());
+                continue;
+            }
+            std::istringstream stream(line);
+            std::string stage;
+            Timing timing;
+            if (!line.empty() && line.front() != '#' && stream >> stage >> timing.m_seconds)
+            {
+                stream >> timing.m_spread;
+                baseline.m_timings[stage] = timing;
+            }
+        }
+        return baseline;
+    }
+
+    void WriteText(const std::filesystem::path& _path, const std::string& _text)
+    {
+        FileSystem::WriteFile(_path, { reinterpret_cast<const u8*>(_text.data()), _text.size() });
+    }
+
+    struct GpuTextureCase
+    {
+        const char* m_image;
+        TextureFormat m_format;
+        bool m_normalMap = false;
+    };
+
+    /**
+     * Cooks corpus textures on the GPU and on the CPU, which is the reference, and fails on any mip the GPU encodes
+     * more than `kGpuPsnrToleranceDb` worse. Both are measured against the CPU mips, so the GPU downsampling is
+     * checked too. Returns a line per texture for the report.
+     */
+    std::vector<std::string> CheckGpuTextures(const std::filesystem::path& _corpus, std::optional<u32> _device, std::vector<std::string>& _failures)
+    {
+        std::vector<std::string> lines;
+        std::unique_ptr<GpuTextureCompressor> gpu;
+        try
+        {
+            gpu = GpuTextureCompressor::Create(_device);
+        }
+        catch (const Error& exception)
+        {
+            _failures.push_back(FormatString("no GPU texture cook: %s", exception.what()));
+            return lines;
+        }
+        lines.push_back(FormatString("on %s", gpu->GetDeviceName().c_str()));
+
+        JobSystem jobSystem;
+        const GpuTextureCase cases[] = {
+            { "albedo.tga", TextureFormat::Bc1 },
+            { "albedo.tga", TextureFormat::Bc3 },
+            { "albedo.tga", TextureFormat::Bc7 },
+            { "albedo.tga", TextureFormat::Bc4 },
+            { "normal.tga", TextureFormat::Bc5, true },
+        };
+        for (const GpuTextureCase& textureCase: cases)
+        {
+            const char* formatName = GetTextureFormatName(textureCase.m_format);
+            if (!GpuTextureCompressor::Supports(textureCase.m_format, EncodeQuality::Fast))
+            {
+                _failures.push_back(FormatString("%s %s: not supported on the GPU", textureCase.m_image, formatName));
+                continue;
+            }
+
+            const Image image = LoadImage(_corpus / textureCase.m_image);
+            MipSettings mipSettings;
+            mipSettings.m_srgb = !textureCase.m_normalMap && IsColorFormat(textureCase.m_format);
+            mipSettings.m_normalMap = textureCase.m_normalMap;
+            CompressionSettings settings;
+            settings.m_format = textureCase.m_format;
+            settings.m_quality = EncodeQuality::Fast;
+            settings.m_srgb = mipSettings.m_srgb;
+            settings.m_computeStatistics = true;
+
+            const std::vector<Image> mips = GenerateMips(jobSystem, image, mipSettings);
+            const CompressedTexture cpu = CompressTexture(jobSystem, mips, settings);
+            std::optional<CompressedTexture> cooked = gpu->Cook(image, true, mipSettings, settings);
+            if (!cooked.has_value())
+            {
+                _failures.push_back(FormatString("%s %s: the GPU left the texture to the CPU", textureCase.m_image, formatName));
+                continue;
+            }
+            if (cooked->m_mips.size() != cpu.m_mips.size())
+            {
+                _failures.push_back(FormatString("%s %s: %zu GPU mips instead of %zu", textureCase.m_image, formatName, cooked->m_mips.size(), cpu.m_mips.size()));
+                continue;
+            }
+            MeasureCompressionError(jobSystem, mips, *cooked);
+
+            f64 worstLoss = 0.0;
+            for (size_t m = 0; m < cpu.m_mips.size(); m++)
+            {
+                const f64 loss = cpu.m_mips[m].m_psnr - cooked->m_mips[m].m_psnr;
+                if (std::isfinite(cpu.m_mips[m].m_psnr) && loss > kGpuPsnrToleranceDb)
+                {
+                    _failures.push_back(FormatString(
+                        "%s %s: mip %zu at %.2f dB on the GPU, %.2f dB on the CPU",
+                        textureCase.m_image,
+                        formatName,
+                        m,
+                        cooked->m_mips[m].m_psnr,
+                        cpu.m_mips[m].m_psnr));
+                }
+                worstLoss = std::isfinite(loss) ? std::max(worstLoss, loss) : worstLoss;
+            }
+            lines.push_back(FormatString(
+                "%s %s: %.2f dB on the GPU, %.2f dB on the CPU, worst mip %.2f dB lower",
+                textureCase.m_image,
+                formatName,
+                cooked->m_mips.front().m_psnr,
+                cpu.m_mips.front().m_psnr,
+                worstLoss));
+        }
+        return lines;
+    }
+
+    /**
+     * Compiles the pipeline corpus with kryne-shaderc, then builds its caches with kryne-pipecache, which recreates
+     * every pipeline from the blob alone and fails on any that still needs a compile. `--require-validation` fails
+     * devices that cannot tell, rather than passing them unchecked. Returns the device lines of the tool.
+     */
+    std::vector<std::string> CheckPipelineCaches(
+        const std::filesystem::path& _corpus,
+        const std::filesystem::path& _output,
+        const std::string& _shaderc,
+        const std::string& _pipecache,
+        const std::string& _glslang,
+        std::vector<std::string>& _failures)
+    {
+        std::vector<std::string> lines;
+        std::filesystem::remove_all(_output);
+        const std::string shaders = (_output / "shaders").string();
+
+        std::vector<std::string> compile { _shaderc, "--no-cache", "--o", shaders, (_corpus / "shaders.json").string() };
+        if (!_glslang.empty())
+        {
+            compile.insert(compile.end() - 1, { "--glslang", _glslang });
+        }
+        const ProcessResult compiled = RunProcess(compile);
+        if (compiled.m_exitCode != 0)
+        {
+            _failures.push_back(FormatString("%s exited with %d:\n%s", _shaderc.c_str(), compiled.m_exitCode, compiled.m_output.c_str()));
+            return lines;
+        }
+
+        const std::vector<std::string> build { _pipecache, "--require-validation", "--shaders", shaders, "--o", _output.string(), (_corpus / "materials.json").string() };
+        const ProcessResult built = RunProcess(build);
+        if (built.m_exitCode != 0)
+        {
+            _failures.push_back(FormatString("%s exited with %d:\n%s", _pipecache.c_str(), built.m_exitCode, built.m_output.c_str()));
+            return lines;
+        }
+        std::istringstream output(built.m_output);
+        std::string line;
+        while (std::getline(output, line))
+        {
+            if (line.find(" pipelines, ") != std::string::npos)
+            {
+                lines.push_back(line);
+            }
+        }
+        if (lines.empty())
+        {
+            _failures.push_back("no device built a pipeline cache");
+        }
+        return lines;
+    }
+
+    void CompareHashes(const FileHashes& _expected, const FileHashes& _actual, const char* _what, std::vector<std::string>& _failures)
+    {
+        std::map<std::string, u64> expected(_expected.begin(), _expected.end());
+        for (const auto& [path, hash]: _actual)
+        {
+            const auto found = expected.find(path);
+            if (found == expected.end())
+            {
+                _failures.push_back(FormatString("%s: unexpected output %s", _what, path.c_str()));
+            }
+            else
+            {
+                if (found->second != hash)
+                {
+                    _failures.push_back(FormatString("%s: %s hashes %016llx instead of %016llx", _what, path.c_str(), static_cast<unsigned long long>(hash), static_cast<unsigned long long>(found->second)));
+                }
+                expected.erase(found);
+            }
+        }
+        for (const auto& [path, hash]: expected)
+        {
+            _failures.push_back(FormatString("%s: missing output %s", _what, path.c_str()));
+        }
+    }
+}
+
+/**
+ * Runs every tool on the regression corpus, checks that outputs are deterministic across runs and worker counts and
+ * match the golden hashes and, with `--performance`, that no stage got slower than its baseline. With `--gpu`, also
+ * checks the Vulkan texture cook against the CPU one, and with the shaderc and pipecache tools, that every corpus
+ * pipeline replays from its cache. The report goes to `test_output.txt` at the
+ * root of the source tree when run by CTest.
+ */
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-regress", [&]
+    {
+        std::vector<std::string> tools;
+        std::string goldenPath;
+        std::string baselinePath;
+        std::string outputPath = "test_output.txt";
+        std::string config;
+        f32 threshold = 25.f;
+        u32 runCount = 5;
+        bool performance = false;
+        bool update = false;
+        bool keep = false;
+        bool gpu = false;
+        u32 gpuDevice = ~0u;
+
+        CommandLine commandLine("kryne-regress", "--golden <file> --baseline <file> --tool <stage>=<path>... [options]");
+        commandLine.AddOption("tool", "Executable of a stage, e.g. texcook=build/Tools/TexCook/kryne-texcook, or glslang for shaderc (repeatable)", &tools);
+        commandLine.AddOption("golden", "Expected output hashes of every stage", &goldenPath);
+        commandLine.AddOption("baseline", "Reference stage timings, only compared on the machine that recorded them", &baselinePath);
+        commandLine.AddOption("o", "Report file, test_output.txt by default", &outputPath);
+        commandLine.AddFlag("performance", "Fail stages slower than the baseline, timings are only reported otherwise", &performance);
+        commandLine.AddOption("threshold", "Slowdown of the median over the baseline, in percent, failing a stage. 25 by default", &threshold);
+        commandLine.AddOption("runs", "Timed runs of every stage, their median is compared. 5 by default", &runCount);
+        commandLine.AddOption("config", "Build configuration, part of the machine the baseline belongs to", &config);
+        commandLine.AddFlag("update", "Record the current hashes and timings as the golden and baseline files", &update);
+        commandLine.AddFlag("keep", "Keep the corpus and outputs in the temporary directory", &keep);
+        commandLine.AddFlag("gpu", "Check the Vulkan texture cook against the CPU one, fails without a device", &gpu);
+        commandLine.AddOption("gpu-device", "Vulkan device index for --gpu, defaults to the first discrete GPU", &gpuDevice);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        KT_VERIFY(!goldenPath.empty() && !baselinePath.empty(), "--golden and --baseline are required");
+        KT_VERIFY(runCount >= 2, "--runs must be at least 2, to compare the outputs of two runs");
+
+        std::map<std::string, std::string> toolPaths;
+        for (const std::string& tool: tools)
+        {
+            const size_t separator = tool.find('=');
+            KT_VERIFY(separator != std::string::npos, "Invalid --tool '%s', expected <stage>=<path>", tool.c_str());
+            toolPaths[tool.substr(0, separator)] = tool.substr(separator + 1);
+        }
+
+        const u32 threadCount = std::max(1u, std::thread::hardware_concurrency());
+        const std::string machine = FormatString("%u threads, %s, %s", threadCount, GetSimdLevelName(GetSimdLevel()), config.empty() ? "default config" : config.c_str());
+        // Another worker count than the timed runs, which use one per hardware thread, so work splits differently.
+        const std::vector<std::string> checkArguments { "--j", threadCount == 1 ? "4" : "1" };
+
+        const std::filesystem::path workDirectory = std::filesystem::temp_directory_path()
+            / FormatString("kryne-regress-%llx", static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count()));
+        const std::filesystem::path corpus = workDirectory / "corpus";
+        RegressionCorpus::Write(corpus);
+
+        const std::map<std::string, FileHashes> golden = ReadGolden(goldenPath);
+        const Baseline baseline = ReadBaseline(baselinePath);
+        const bool comparePerformance = performance && baseline.m_machine == machine;
+
+        std::string report = FormatString("kryne-regress on %s\n", machine.c_str());
+        if (!update && performance && !comparePerformance)
+        {
+            report += FormatString(
+                "Timings not compared, the baseline was recorded on %s\n",
+                baseline.m_machine.empty() ? "no machine" : baseline.m_machine.c_str());
+        }
+
+        std::vector<StageResult> results;
+        for (const Stage& stage: MakeStages(corpus))
+        {
+            const auto tool = toolPaths.find(stage.m_tool);
+            if (tool == toolPaths.end())
+            {
+                report += FormatString("%-8s SKIP  no --tool %s\n", stage.m_name, stage.m_tool);
+                continue;
+            }
+
+            StageResult& result = results.emplace_back();
+            result.m_name = stage.m_name;
+            for (u32 run = 0; run < runCount && result.m_failures.empty(); run++)
+            {
+                const std::filesystem::path output = workDirectory / stage.m_name / FormatString("run%u", run);
+                result.m_runSeconds.push_back(RunStage(stage, tool->second, output, {}, result));
+                if (result.m_failures.empty())
+                {
+                    const FileHashes hashes = HashOutputs(output);
+                    if (run == 0)
+                    {
+                        result.m_hashes = hashes;
+                    }
+                    else if (hashes != result.m_hashes)
+                    {
+                        CompareHashes(result.m_hashes, hashes, FormatString("run %u", run).c_str(), result.m_failures);
+                    }
+                }
+            }
+            if (result.m_failures.empty())
+            {
+                const std::filesystem::path output = workDirectory / stage.m_name / "check";
+                RunStage(stage, tool->second, output, checkArguments, result);
+                if (result.m_failures.empty())
+                {
+                    const FileHashes hashes = HashOutputs(output);
+                    CompareHashes(result.m_hashes, hashes, FormatString("--j %s", checkArguments[1].c_str()).c_str(), result.m_failures);
+                }
+            }
+            std::string simdLevels;
+            for (const SimdLevel level: { SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2, SimdLevel::Neon })
+            {
+                if (!stage.m_compareSimdLevels || !result.m_failures.empty() || !IsSimdLevelSupported(level))
+                {
+                    continue;
+                }
+                const ScopedEnvironment simd("KRYNE_SIMD", GetSimdLevelName(level));
+                const std::filesystem::path output = workDirectory / stage.m_name / GetSimdLevelName(level);
+                RunStage(stage, tool->second, output, {}, result);
+                if (result.m_failures.empty())
+                {
+                    const FileHashes hashes = HashOutputs(output);
+                    CompareHashes(result.m_hashes, hashes, FormatString("KRYNE_SIMD=%s", GetSimdLevelName(level)).c_str(), result.m_failures);
+                }
+                simdLevels += simdLevels.empty() ? GetSimdLevelName(level) : FormatString(", %s", GetSimdLevelName(level));
+            }
+
+            const bool ran = result.m_failures.empty();
+            if (ran && !update)
+            {
+                const auto expected = golden.find(result.m_name);
+                if (expected == golden.end())
+                {
+                    result.m_failures.push_back("no golden hashes, record them with --update");
+                }
+                else
+                {
+                    CompareHashes(expected->second, result.m_hashes, "golden", result.m_failures);
+                }
+            }
+
+            const Timing measured = ran ? MeasureTiming(result.m_runSeconds) : Timing();
+            std::string timing = ran ? FormatString("%.3fs +-%.3fs", measured.m_seconds, measured.m_spread) : std::string("-");
+            const auto reference = baseline.m_timings.find(result.m_name);
+            if (ran && !update && comparePerformance && reference != baseline.m_timings.end())
+            {
+                // Noisy stages get as much slack as their spread, on this run or when the baseline was recorded.
+                const Timing& expected = reference->second;
+                const f64 noise = std::max(kMinNoiseSeconds, kNoiseSpreads * std::max(expected.m_spread, measured.m_spread));
+                const f64 limit = expected.m_seconds * (1.0 + threshold / 100.0) + noise;
+                const f64 change = (measured.m_seconds / expected.m_seconds - 1.0) * 100.0;
+                timing += FormatString(" (baseline %.3fs, %+.1f%%, limit %.3fs)", expected.m_seconds, change, limit);
+                if (measured.m_seconds > limit)
+                {
+                    result.m_failures.push_back(FormatString(
+                        "%.1f%% slower than the baseline, over the %.1f%% threshold and %.3fs of noise",
+                        change,
+                        f64(threshold),
+                        noise));
+                }
+            }
+
+            report += FormatString(
+                "%-8s %s  %s, %zu files\n",
+                result.m_name.c_str(),
+                result.m_failures.empty() ? "PASS" : "FAIL",
+                timing.c_str(),
+                result.m_hashes.size());
+            if (!simdLevels.empty() && result.m_failures.empty())
+            {
+                report += FormatString("    same outputs with KRYNE_SIMD=%s\n", simdLevels.c_str());
+            }
+            for (const std::string& failure: result.m_failures)
+            {
+                report += "    " + failure + "\n";
+            }
+        }
+
+        // Not a tool stage: GPU blocks depend on the driver, there is nothing to hash or time.
+        std::vector<std::string> gpuFailures;
+        if (gpu || gpuDevice != ~0u)
+        {
+            const std::vector<std::string> lines = CheckGpuTextures(corpus, gpuDevice != ~0u ? std::optional(gpuDevice) : std::nullopt, gpuFailures);
+            report += FormatString("%-8s %s\n", "texgpu", gpuFailures.empty() ? "PASS" : "FAIL");
+            for (const std::string& line: lines)
+            {
+                report += "    " + line + "\n";
+            }
+            for (const std::string& failure: gpuFailures)
+            {
+                report += "    " + failure + "\n";
+            }
+        }
+        else
+        {
+            report += FormatString("%-8s SKIP  no --gpu\n", "texgpu");
+        }
+
+        // Not a tool stage either: SPIR-V depends on the compiler version and the caches on the driver.
+        std::vector<std::string> pipelineFailures;
+        const auto shaderc = toolPaths.find("shaderc");
+        const auto pipecache = toolPaths.find("pipecache");
+        if (shaderc != toolPaths.end() && pipecache != toolPaths.end())
+        {
+            const std::filesystem::path pipelineCorpus = workDirectory / "pipelines";
+            RegressionCorpus::WritePipelines(pipelineCorpus);
+            const auto glslang = toolPaths.find("glslang");
+            const std::vector<std::string> lines = CheckPipelineCaches(
+                pipelineCorpus,
+                workDirectory / "pipecache",
+                shaderc->second,
+                pipecache->second,
+                glslang != toolPaths.end() ? glslang->second : std::string(),
+                pipelineFailures);
+            report += FormatString("%-8s %s\n", "pipecache", pipelineFailures.empty() ? "PASS" : "FAIL");
+            for (const std::string& line: lines)
+            {
+                report += "    " + line + "\n";
+            }
+            for (const std::string& failure: pipelineFailures)
+            {
+                report += "    " + failure + "\n";
+            }
+        }
+        else
+        {
+            report += FormatString("%-8s SKIP  no --tool %s\n", "pipecache", shaderc == toolPaths.end() ? "shaderc" : "pipecache");
+        }
+
+        const bool passed = gpuFailures.empty() && pipelineFailures.empty()
+            && std::all_of(results.begin(), results.end(), [](const StageResult& _result) { return _result.m_failures.empty(); });
+        if (update && !passed)
+        {
+            // A failing stage must not become the reference, nor silently drop out of it.
+            report += "Nothing recorded, fix the failing stages first\n";
+        }
+        else if (update)
+        {
+            std::string goldenText = "# Generated by kryne-regress --update: stage, output path, XXH64 of its content.\n";
+            std::string baselineText = FormatString(
+                "# Generated by kryne-regress --update: stage, median wall time and its spread in seconds.\n# machine: %s\n",
+                machine.c_str());
+            for (const StageResult& result: results)
+            {
+                for (const auto& [path, hash]: result.m_hashes)
+                {
+                    goldenText += FormatString("%s %s %016llx\n", result.m_name.c_str(), path.c_str(), static_cast<unsigned long long>(hash));
+                }
+                const Timing timing = MeasureTiming(result.m_runSeconds);
+                baselineText += FormatString("%s %.4f %.4f\n", result.m_name.c_str(), timing.m_seconds, timing.m_spread);
+            }
+            WriteText(goldenPath, goldenText);
+            WriteText(baselinePath, baselineText);
+            report += FormatString("Recorded %s and %s\n", goldenPath.c_str(), baselinePath.c_str());
+        }
+        report += passed ? "PASSED\n" : "FAILED\n";
+
+        WriteText(outputPath, report);
+        Log::Info("%s", report.c_str());
+        if (!keep)
+        {
+            std::error_code error;
+            std::filesystem::remove_all(workDirectory, error);
+        }
+        return passed ? 0 : 1;
+    });
+}
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+
+#include "KryneTools/Animation/AnimationCompressor.hpp"
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+using namespace KryneTools;
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-anim", [&]
+    {
+        std::string outputDirectory;
+        u32 jobCount = 0;
+        u32 skin = ~0u;
+        AnimationSettings defaults;
+        f32 sampleRate = defaults.m_sampleRate;
+        f32 maxError = defaults.m_maxError;
+        f32 shellDistance = defaults.m_shellDistance;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-anim", "[options] <input.gltf|input.glb>...");
+        commandLine.AddOption("o", "Output directory, defaults to the directory of each input", &outputDirectory);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("sample-rate", "Samples per second of the clips, 30 by default", &sampleRate);
+        commandLine.AddOption("max-error", "Maximum object space error, in scene units, 0.0001 by default", &maxError);
+        commandLine.AddOption("shell-distance", "Distance from the bones the error is measured at, 0.03 by default", &shellDistance);
+        commandLine.AddOption("skin", "Index of the skin defining the skeleton, defaults to the first one", &skin);
+        commandLine.AddFlag("verbose", "Print per clip statistics", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty())
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        cacheSettings.ResolveOptions();
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+
+        std::atomic<u64> cacheHitCount = 0;
+        std::atomic<u64> clipCount = 0;
+        std::atomic<u64> rawSize = 0;
+        std::atomic<u64> size = 0;
+        JobGroup group;
+        for (const std::string& input: commandLine.GetPositionals())
+        {
+            jobSystem.Spawn(group, [&, input]
+            {
+                AnimationSettings settings;
+                settings.m_input = input;
+                settings.m_outputDirectory = outputDirectory;
+                settings.m_sampleRate = sampleRate;
+                settings.m_maxError = maxError;
+                settings.m_shellDistance = shellDistance;
+                settings.m_cache = &cache;
+                if (skin != ~0u)
+                {
+                    settings.m_skin = skin;
+                }
+
+                const AnimationResult result = CompressAnimations(jobSystem, settings);
+                cacheHitCount += result.m_cacheHit ? 1 : 0;
+                for (const ClipResult& clip: result.m_clips)
+                {
+                    clipCount++;
+                    rawSize += clip.m_rawSize;
+                    size += clip.m_size;
+                    Log::Verbose(
+                        "%s: %u bones, %u samples, %llu -> %llu bytes (%.1fx), %s, tracks %u default / %u constant / %u quantized / %u raw",
+                        clip.m_output.string().c_str(),
+                        clip.m_boneCount,
+                        clip.m_sampleCount,
+                        static_cast<unsigned long long>(clip.m_rawSize),
+                        static_cast<unsigned long long>(clip.m_size),
+                        f64(clip.m_rawSize) / f64(std::max<u64>(1, clip.m_size)),
+                        result.m_cacheHit ? "from cache" : FormatString("max error %.3g", f64(clip.m_maxError)).c_str(),
+                        clip.m_trackCounts[0],
+                        clip.m_trackCounts[1],
+                        clip.m_trackCounts[2],
+                        clip.m_trackCounts[3]);
+                }
+            });
+        }
+        jobSystem.Wait(group);
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Compressed %llu clips (%.2f MiB -> %.2f MiB, %llu/%zu inputs from cache) in %.3fs on %u workers",
+            static_cast<unsigned long long>(clipCount.load()),
+            f64(rawSize.load()) / (1024.0 * 1024.0),
+            f64(size.load()) / (1024.0 * 1024.0),
+            static_cast<unsigned long long>(cacheHitCount.load()),
+            commandLine.GetPositionals().size(),
+            seconds,
+            jobSystem.GetWorkerCount());
+        return 0;
+    });
+}
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileWatcher.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Memory.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Cook/AssetCooker.hpp"
+#include "KryneTools/Distributed/CookCoordinator.hpp"
+#include "KryneTools/Distributed/CookWorker.hpp"
+#include "KryneTools/Distributed/LiveLink.hpp"
+#include "KryneTools/Distributed/Socket.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    constexpr auto kReconnectDelay = std::chrono::seconds(5);
+
+    int RunWorker(JobSystem& _jobSystem, const std::string& _address, CookWorkerSettings _settings, bool _once)
+    {
+        std::string host;
+        u16 port = 0;
+        ParseSocketAddress(_address, RemoteProtocol::kDefaultPort, host, port);
+        CookWorker worker(_jobSystem, std::move(_settings));
+        while (true)
+        {
+            bool served = false;
+            try
+            {
+                if (!worker.Serve(host, port))
+                {
+                    return 1;
+                }
+                served = true;
+            }
+            catch (const Error& exception)
+            {
+                Log::Warning("%s", exception.what());
+            }
+            if (_once)
+            {
+                return served ? 0 : 1;
+            }
+            std::this_thread::sleep_for(kReconnectDelay);
+        }
+    }
+
+    /// Logs failed and skipped assets, and the schedule of the others when verbose.
+    void LogAssets(const CookResult& _result, u32& _cacheHitCount, u32& _remoteCount)
+    {
+        for (const CookAssetRecord& asset: _result.m_assets)
+        {
+            const TaskRecord& task = asset.m_task;
+            _cacheHitCount += asset.m_cacheHit ? 1 : 0;
+            _remoteCount += asset.m_remote ? 1 : 0;
+            switch (task.m_status)
+            {
+            case TaskStatus::Failed:
+                Log::Error("%s: %s", task.m_name.c_str(), task.m_error.c_str());
+                break;
+            case TaskStatus::Skipped:
+                Log::Warning("%s: skipped, as %s failed", task.m_name.c_str(), task.m_error.c_str());
+                break;
+            default:
+                Log::Verbose(
+                    "%s: %.3fs -> %.3fs (estimated %.3fs), %zu outputs%s, peak heap %.2f MiB",
+                    task.m_name.c_str(),
+                    task.m_startSeconds,
+                    task.m_endSeconds,
+                    asset.m_cost,
+                    asset.m_outputs.size(),
+                    asset.m_cacheHit ? " (cache)" : asset.m_remote ? " (remote)" : "",
+                    f64(task.m_memory.m_peakHeapBytes) / f64(1 << 20));
+                break;
+            }
+        }
+    }
+
+    /// Memory of each stage, the assets of a kind, and of the whole cook.
+    void LogMemory(const CookResult& _result)
+    {
+        struct Stage
+        {
+            u32 m_taskCount = 0;
+            MemoryStatistics m_memory;
+        };
+        std::map<std::string, Stage> stages;
+        for (const CookAssetRecord& asset: _result.m_assets)
+        {
+            const std::string& name = asset.m_task.m_name;
+            Stage& stage = stages[name.substr(0, name.find(' '))];
+            const MemoryStatistics& memory = asset.m_task.m_memory;
+            stage.m_taskCount++;
+            stage.m_memory.m_allocationCount += memory.m_allocationCount;
+            stage.m_memory.m_allocatedBytes += memory.m_allocatedBytes;
+            stage.m_memory.m_peakHeapBytes = std::max(stage.m_memory.m_peakHeapBytes, memory.m_peakHeapBytes);
+            stage.m_memory.m_peakArenaBytes = std::max(stage.m_memory.m_peakArenaBytes, memory.m_peakArenaBytes);
+        }
+
+        Log::Info("%-10s %6s %12s %14s %14s %12s", "Stage", "Tasks", "Peak heap", "Allocations", "Allocated", "Peak arena");
+        for (const auto& [name, stage]: stages)
+        {
+            Log::Info(
+                "%-10s %6u %8.2f MiB %14llu %10.2f MiB %8.2f MiB",
+                name.c_str(),
+                stage.m_taskCount,
+                f64(stage.m_memory.m_peakHeapBytes) / f64(1 << 20),
+                static_cast<unsigned long long>(stage.m_memory.m_allocationCount),
+                f64(stage.m_memory.m_allocatedBytes) / f64(1 << 20),
+                f64(stage.m_memory.m_peakArenaBytes) / f64(1 << 20));
+        }
+        if (!Memory::IsTrackingAllocations())
+        {
+            Log::Info("Heap allocations are not counted, the tools were built with KRYNE_TOOLS_MEMORY_TRACKING=OFF");
+        }
+        Log::Info(
+            "Peak resident size %.2f MiB (%.2f MiB over the process lifetime), %u assets waited for the memory budget",
+            f64(_result.m_schedule.m_peakResidentBytes) / f64(1 << 20),
+            f64(Memory::GetResidentSize().m_peakBytes) / f64(1 << 20),
+            _result.m_schedule.m_memoryDeferredCount);
+    }
+
+    /**
+     * Cooks the manifest, then keeps its session resident and recooks what each batch of source changes affects,
+     * pushing the new outputs to the engines on the live link. Manifest edits rebuild the session. Never returns:
+     * the daemon runs until killed.
+     */
+    [[noreturn]] void RunWatch(JobSystem& _jobSystem, const std::filesystem::path& _manifestPath, const CookSettings& _settings, LiveLinkServer& _liveLink)
+    {
+        const std::filesystem::path manifestKey = std::filesystem::weakly_canonical(std::filesystem::absolute(_manifestPath));
+        while (true)
+        {
+            std::unique_ptr<CookSession> session;
+            std::set<std::filesystem::path> directories { manifestKey.parent_path() };
+            try
+            {
+                session = std::make_unique<CookSession>(_jobSystem, LoadCookManifest(_manifestPath), _settings);
+                const CookResult result = session->Cook();
+                u32 cacheHitCount = 0;
+                u32 remoteCount = 0;
+                LogAssets(result, cacheHitCount, remoteCount);
+                LogMemory(result);
+                Log::Info(
+                    "Cooked %u assets (%u from cache) in %.3fs, watching for changes",
+                    result.m_schedule.m_doneCount,
+                    cacheHitCount,
+                    result.m_schedule.m_seconds);
+                for (const std::filesystem::path& directory: session->GetSourceDirectories())
+                {
+                    directories.insert(directory);
+                }
+            }
+            catch (const Error& exception)
+            {
+                // Waits for the manifest to be fixed.
+                Log::Error("%s", exception.what());
+                session.reset();
+            }
+
+            const std::vector<std::filesystem::path> watched(directories.begin(), directories.end());
+            FileWatcher watcher(watched);
+            while (true)
+            {
+                const std::vector<std::filesystem::path> changes = watcher.Wait();
+                const bool manifestChanged = std::find(changes.begin(), changes.end(), manifestKey) != changes.end();
+                if (session == nullptr || manifestChanged || session->RequiresRebuild(changes))
+                {
+                    Log::Info("Manifest changed, rebuilding the cook graph");
+                    break;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                const CookResult result = session->Recook(changes);
+                if (result.m_assets.empty())
+                {
+                    continue;
+                }
+                u32 cacheHitCount = 0;
+                u32 remoteCount = 0;
+                LogAssets(result, cacheHitCount, remoteCount);
+
+                std::vector<LiveAsset> assets;
+                for (const CookAssetRecord& asset: result.m_assets)
+                {
+                    if (asset.m_task.m_status == TaskStatus::Done)
+                    {
+                        for (const std::filesystem::path& output: asset.m_outputs)
+                        {
+                            assets.push_back({ output.lexically_relative(session->GetOutputDirectory()).generic_string(), output });
+                        }
+                    }
+                }
+                try
+                {
+                    _liveLink.Publish(assets);
+                }
+                catch (const Error& exception)
+                {
+                    Log::Error("%s", exception.what());
+                }
+                Log::Info(
+                    "Recooked %u assets in %.3fs, pushed %zu outputs to %u engines",
+                    result.m_schedule.m_doneCount,
+                    std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count(),
+                    assets.size(),
+                    _liveLink.GetClientCount());
+            }
+        }
+    }
+}
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-cook", [&]
+    {
+        std::string outputDirectory;
+        std::string packPath;
+        u32 jobCount = 0;
+        std::vector<std::string> includeDirectories;
+        std::string compressionName = "lz4";
+        CookSettings settings;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+        std::string listenAddress;
+        u32 waitWorkerCount = 0;
+        f32 waitTimeout = 30.0f;
+        std::string workerAddress;
+        CookWorkerSettings workerSettings;
+        std::string storeDirectory;
+        u32 storeLimitMiB = 8192;
+        bool once = false;
+        bool watch = false;
+        std::string liveLinkAddress = "127.0.0.1";
+        u32 memoryBudgetMiB = ~0u;
+
+        CommandLine commandLine("kryne-cook", "[options] <cook.json> | --worker <host[:port]> [options]");
+        commandLine.AddOption("o", "Output directory of the loose files, defaults to a cooked directory next to the manifest", &outputDirectory);
+        commandLine.AddOption("pack", "Also stream every output to this .kpak archive", &packPath);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("I", "Shader include directory, searched after those of the shader manifest (repeatable)", &includeDirectories);
+        commandLine.AddOption("glslang", "glslang executable, glslangValidator by default", &settings.m_compiler.m_glslangPath);
+        commandLine.AddOption("dxc", "DXC executable, dxc by default", &settings.m_compiler.m_dxcPath);
+        commandLine.AddOption("target-env", "Vulkan target environment, vulkan1.2 by default", &settings.m_compiler.m_targetEnvironment);
+        commandLine.AddOption("compression", "Archive entry compression: lz4 (default), zstd or none", &compressionName);
+        commandLine.AddFlag("verbose", "Print the schedule of every asset", &verbose);
+        commandLine.AddOption("memory-budget", "MiB the estimated heap of the assets in flight may add up to, 0 for no limit, 3/4 of the physical memory by default", &memoryBudgetMiB);
+        commandLine.AddOption("listen", "Offer texture and shader jobs to remote workers connecting to this [address:]port", &listenAddress);
+        commandLine.AddOption("wait-workers", "Wait for this many workers before cooking", &waitWorkerCount);
+        commandLine.AddOption("wait-timeout", "Seconds to wait for them, 30 by default", &waitTimeout);
+        commandLine.AddOption("worker", "Run as a remote worker of the coordinator at host[:port] instead of cooking", &workerAddress);
+        commandLine.AddOption("name", "Worker name shown by the coordinator", &workerSettings.m_name);
+        commandLine.AddOption("store-dir", "Worker store of the received inputs, kept across sessions", &storeDirectory);
+        commandLine.AddOption("store-limit", "Worker store size limit in MiB, 8192 by default", &storeLimitMiB);
+        commandLine.AddFlag("once", "Worker: exit when the coordinator disconnects instead of reconnecting", &once);
+        commandLine.AddFlag("watch", "Stay resident, recooking what source changes affect and pushing it to running engines", &watch);
+        commandLine.AddOption("live-link", "Watch: address[:port] engines connect to, 127.0.0.1:7421 by default", &liveLinkAddress);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().size() != (workerAddress.empty() ? 1 : 0))
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+        cacheSettings.ResolveOptions();
+
+        if (!workerAddress.empty())
+        {
+            JobSystem jobSystem(jobCount);
+            ContentCache cache(cacheSettings);
+            workerSettings.m_storeDirectory = storeDirectory.empty() ? std::filesystem::temp_directory_path() / "kryne-worker" : std::filesystem::path(storeDirectory);
+            workerSettings.m_storeLimit = u64(storeLimitMiB) << 20;
+            workerSettings.m_glslangPath = settings.m_compiler.m_glslangPath;
+            workerSettings.m_dxcPath = settings.m_compiler.m_dxcPath;
+            workerSettings.m_cache = &cache;
+            return RunWorker(jobSystem, workerAddress, std::move(workerSettings), once);
+        }
+
+        const std::optional<CompressionMethod> compression = ParseCompressionMethod(compressionName);
+        KT_VERIFY(compression.has_value(), "Unknown compression '%s', expected lz4, zstd or none", compressionName.c_str());
+        settings.m_pack.m_compression = *compression;
+
+        const std::filesystem::path manifestPath = commandLine.GetPositionals()[0];
+        const CookManifest manifest = LoadCookManifest(manifestPath);
+        settings.m_outputDirectory = outputDirectory.empty() ? manifestPath.parent_path() / "cooked" : std::filesystem::path(outputDirectory);
+        settings.m_packPath = packPath;
+        settings.m_includeDirectories.assign(includeDirectories.begin(), includeDirectories.end());
+        settings.m_memoryBudget = memoryBudgetMiB == ~0u ? Memory::GetPhysicalMemorySize() / 4 * 3 : u64(memoryBudgetMiB) << 20;
+
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+        settings.m_cache = &cache;
+
+        std::unique_ptr<CookCoordinator> coordinator;
+        if (!listenAddress.empty())
+        {
+            std::string host;
+            u16 port = 0;
+            ParseSocketAddress(listenAddress, RemoteProtocol::kDefaultPort, host, port);
+            coordinator = std::make_unique<CookCoordinator>(jobSystem, host, port);
+            Log::Info("Waiting for remote workers on port %u", u32(coordinator->GetPort()));
+            if (waitWorkerCount > 0 && !coordinator->WaitForWorkers(waitWorkerCount, f64(waitTimeout)))
+            {
+                Log::Warning("Fewer than %u workers connected, cooking with those available", waitWorkerCount);
+            }
+            settings.m_coordinator = coordinator.get();
+        }
+        if (watch)
+        {
+            std::string host;
+            u16 port = 0;
+            ParseSocketAddress(liveLinkAddress, RemoteProtocol::kDefaultLivePort, host, port);
+            LiveLinkServer liveLink(host, port);
+            Log::Info("Live link listening on port %u", u32(liveLink.GetPort()));
+            RunWatch(jobSystem, manifestPath, settings, liveLink);
+        }
+        const CookResult result = CookAssets(jobSystem, manifest, settings);
+
+        u32 cacheHitCount = 0;
+        u32 remoteCount = 0;
+        LogAssets(result, cacheHitCount, remoteCount);
+
+        const TaskGraphStatistics& schedule = result.m_schedule;
+        KT_VERIFY(schedule.m_failedCount == 0 && schedule.m_skippedCount == 0, "%u assets failed, %u skipped", schedule.m_failedCount, schedule.m_skippedCount);
+        Log::Info(
+            "Cooked %u assets (%u from cache) in %.3fs on %u workers: longest chain %.3fs, %.2f tasks in flight on average",
+            schedule.m_doneCount,
+            cacheHitCount,
+            schedule.m_seconds,
+            jobSystem.GetWorkerCount(),
+            schedule.m_criticalPathSeconds,
+            schedule.m_parallelism);
+        LogMemory(result);
+        if (coordinator != nullptr)
+        {
+            const CookCoordinatorStatistics remote = coordinator->GetStatistics();
+            Log::Info(
+                "%u assets used remote workers: %llu remote jobs, %llu run locally, %.2f MiB of inputs sent, %.2f MiB already on the workers",
+                remoteCount,
+                static_cast<unsigned long long>(remote.m_remoteJobCount),
+                static_cast<unsigned long long>(remote.m_localFallbackCount),
+                f64(remote.m_sentInputBytes) / f64(1 << 20),
+                f64(remote.m_residentInputBytes) / f64(1 << 20));
+        }
+        if (!packPath.empty())
+        {
+            Log::Info(
+                "Packed %u entries (%u compressed) to %s: %.2f MiB -> %.2f MiB stored",
+                result.m_pack.m_entryCount,
+                result.m_pack.m_compressedEntryCount,
+                packPath.c_str(),
+                f64(result.m_pack.m_inputSize) / f64(1 << 20),
+                f64(result.m_pack.m_storedSize) / f64(1 << 20));
+            if (result.m_pack.m_duplicateEntryCount > 0)
+            {
+                Log::Info(
+                    "%u entries share the data of an identical one, saving %.2f MiB",
+                    result.m_pack.m_duplicateEntryCount,
+                    f64(result.m_pack.m_duplicateSize) / f64(1 << 20));
+            }
+        }
+        return 0;
+    });
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/CpuFeatures.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/FileSystem.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Import/GltfImporter.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    struct OptimizedOutput
+    {
+        std::filesystem::path m_path;
+        MeshOptimizationReport m_report;
+    };
+
+    void WriteOptimizationReport(const std::filesystem::path& _path, std::vector<OptimizedOutput> _outputs)
+    {
+        std::sort(_outputs.begin(), _outputs.end(), [](const OptimizedOutput& _a, const OptimizedOutput& _b) { return _a.m_path < _b.m_path; });
+
+        std::string text = FormatString(
+            "# kryne-import mesh optimization, FIFO cache of %u vertices\n%-40s %12s %12s %12s %12s %12s\n",
+            kDefaultAnalysisCacheSize,
+            "mesh", "triangles", "acmr_before", "acmr_after", "atvr_before", "atvr_after");
+
+        MeshOptimizationReport total;
+        const auto appendLine = [&text](const std::string& _name, const MeshOptimizationReport& _report)
+        {
+            text += FormatString(
+                "%-40s %12llu %12.4f %12.4f %12.4f %12.4f\n",
+                _name.c_str(),
+                static_cast<unsigned long long>(_report.m_after.m_triangleCount),
+                _report.m_before.GetAcmr(),
+                _report.m_after.GetAcmr(),
+                _report.m_before.GetAtvr(),
+                _report.m_after.GetAtvr());
+        };
+        for (const OptimizedOutput& output: _outputs)
+        {
+            appendLine(output.m_path.filename().string(), output.m_report);
+            total.m_before += output.m_report.m_before;
+            total.m_after += output.m_report.m_after;
+        }
+        appendLine("total", total);
+
+        FileSystem::WriteFile(_path, std::span(reinterpret_cast<const u8*>(text.data()), text.size()));
+    }
+}
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-import", [&]
+    {
+        std::string outputDirectory;
+        u32 jobCount = 0;
+        std::string benchOutput;
+        bool noOptimize = false;
+        bool noMeshlets = false;
+        bool noLods = false;
+        LodSettings lodSettings;
+        bool noQuantize = false;
+        MeshletSettings meshletSettings;
+        u32 memoryLimitMiB = 0;
+        u32 brickTriangleCount = ImportSettings().m_brickTriangleCount;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-import", "[options] <input.gltf|input.glb>...");
+        commandLine.AddOption("o", "Output directory, defaults to the directory of each input", &outputDirectory);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddFlag("no-lods", "Skip LOD chain generation", &noLods);
+        commandLine.AddOption("lod-levels", "Maximum simplified levels per submesh, 4 by default", &lodSettings.m_levelCount);
+        commandLine.AddOption("lod-ratio", "Triangle count of each level relative to the previous one, 0.5 by default", &lodSettings.m_triangleRatio);
+        commandLine.AddOption("lod-error", "Maximum deviation of any level, relative to the submesh extent, 0.05 by default", &lodSettings.m_maxError);
+        commandLine.AddFlag("no-optimize", "Skip the vertex cache, overdraw and vertex fetch optimization stage", &noOptimize);
+        commandLine.AddFlag("no-meshlets", "Skip meshlet building", &noMeshlets);
+        commandLine.AddOption("meshlet-vertices", "Maximum vertices per meshlet, 64 by default", &meshletSettings.m_maxVertices);
+        commandLine.AddOption("meshlet-triangles", "Maximum triangles per meshlet, 124 by default", &meshletSettings.m_maxTriangles);
+        commandLine.AddFlag("no-quantize", "Keep full precision vertex attributes", &noQuantize);
+        commandLine.AddOption("memory-limit", "Memory per mesh in MiB, larger meshes are streamed by bricks, 0 (default) never streams", &memoryLimitMiB);
+        commandLine.AddOption("brick-triangles", "Maximum triangles per brick of streamed meshes, at least 16384, 1048576 by default", &brickTriangleCount);
+        commandLine.AddOption("bench-output", "Write the ACMR/ATVR before and after optimization to this file, imports bypass the cache", &benchOutput);
+        commandLine.AddFlag("verbose", "Print per mesh statistics", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty())
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        cacheSettings.ResolveOptions();
+
+        if (brickTriangleCount < kMinBrickTriangleCount)
+        {
+            Log::Warning("--brick-triangles %u is below the minimum brick size, using %u", brickTriangleCount, kMinBrickTriangleCount);
+        }
+        if (!benchOutput.empty() && noOptimize)
+        {
+            Log::Warning("--bench-output reports the optimization stage, which --no-optimize skips: %s will only hold a zero total", benchOutput.c_str());
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+
+        std::atomic<u64> meshCount = 0;
+        std::atomic<u64> triangleCount = 0;
+        std::atomic<u64> cacheHitCount = 0;
+        std::mutex outputsMutex;
+        std::vector<OptimizedOutput> optimizedOutputs;
+
+        // Inputs are jobs as well, so small assets fill the gaps left by the primitives of large ones.
+        JobGroup group;
+        for (const std::string& input: commandLine.GetPositionals())
+        {
+            jobSystem.Spawn(group, [&, input]
+            {
+                ImportSettings settings;
+                settings.m_input = input;
+                settings.m_outputDirectory = outputDirectory;
+                settings.m_cache = &cache;
+                settings.m_generateLods = !noLods;
+                settings.m_lodSettings = lodSettings;
+                settings.m_optimize = !noOptimize;
+                settings.m_buildMeshlets = !noMeshlets;
+                settings.m_meshletSettings = meshletSettings;
+                settings.m_quantize = !noQuantize;
+                settings.m_memoryLimit = u64(memoryLimitMiB) << 20;
+                settings.m_brickTriangleCount = brickTriangleCount;
+                settings.m_collectReports = !benchOutput.empty();
+
+                const ImportResult result = ImportGltf(jobSystem, settings);
+                meshCount += result.m_outputs.size();
+                triangleCount += result.m_triangleCount;
+                cacheHitCount += result.m_cacheHit ? 1 : 0;
+
+                std::lock_guard lock(outputsMutex);
+                for (size_t i = 0; i < result.m_optimizationReports.size(); i++)
+                {
+                    optimizedOutputs.push_back({ result.m_outputs[i], result.m_optimizationReports[i] });
+                }
+            });
+        }
+        jobSystem.Wait(group);
+
+        if (!benchOutput.empty())
+        {
+            WriteOptimizationReport(benchOutput, std::move(optimizedOutputs));
+        }
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Imported %llu meshes (%llu triangles, %llu/%zu inputs from cache) in %.3fs on %u workers (%s)",
+            static_cast<unsigned long long>(meshCount.load()),
+            static_cast<unsigned long long>(triangleCount.load()),
+            static_cast<unsigned long long>(cacheHitCount.load()),
+            commandLine.GetPositionals().size(),
+            seconds,
+            jobSystem.GetWorkerCount(),
+            GetSimdLevelName(GetSimdLevel()));
+        return 0;
+    });
+}
@@ -0,0 +1,124 @@
+#include <atomic>
+#include <chrono>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Level/LevelBaker.hpp"
+
+using namespace KryneTools;
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-level", [&]
+    {
+        std::string outputDirectory;
+        std::string meshDirectory;
+        u32 jobCount = 0;
+        u32 scene = ~0u;
+        BvhSettings bvhSettings;
+        bool verify = false;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-level", "[options] <input.gltf|input.glb>...");
+        commandLine.AddOption("o", "Output directory, defaults to the directory of each input", &outputDirectory);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("mesh-directory", "Directory of the imported meshes, relative to the level files", &meshDirectory);
+        commandLine.AddOption("scene", "Index of the scene to bake, defaults to the scene of each asset", &scene);
+        commandLine.AddOption("leaf-size", "Maximum instances per BVH leaf, 4 by default", &bvhSettings.m_maxLeafSize);
+        commandLine.AddFlag("verify", "Load every output in place and validate it", &verify);
+        commandLine.AddFlag("verbose", "Print per level statistics", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty())
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        cacheSettings.ResolveOptions();
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+
+        std::atomic<u64> cacheHitCount = 0;
+        std::atomic<u64> instanceCount = 0;
+        std::atomic<u64> size = 0;
+        JobGroup group;
+        for (const std::string& input: commandLine.GetPositionals())
+        {
+            jobSystem.Spawn(group, [&, input]
+            {
+                LevelSettings settings;
+                settings.m_input = input;
+                if (!outputDirectory.empty())
+                {
+                    settings.m_output = std::filesystem::path(outputDirectory) / settings.m_input.filename().replace_extension(".klvl");
+                }
+                settings.m_meshDirectory = meshDirectory;
+                if (scene != ~0u)
+                {
+                    settings.m_scene = scene;
+                }
+                settings.m_bvhSettings = bvhSettings;
+                settings.m_cache = &cache;
+
+                const LevelResult result = BakeLevel(jobSystem, settings);
+                instanceCount += result.m_instanceCount;
+                size += result.m_size;
+                cacheHitCount += result.m_cacheHit ? 1 : 0;
+                Log::Verbose(
+                    "%s: %u instances of %u meshes, %u materials, %u BVH nodes (%s), %llu bytes",
+                    result.m_output.string().c_str(),
+                    result.m_instanceCount,
+                    result.m_meshCount,
+                    result.m_materialCount,
+                    result.m_bvhNodeCount,
+                    result.m_cacheHit ? "from cache" : FormatString("depth %u, SAH cost %.2f", result.m_bvhDepth, f64(result.m_bvhCost)).c_str(),
+                    static_cast<unsigned long long>(result.m_size));
+
+                if (verify)
+                {
+                    const auto loadStart = std::chrono::steady_clock::now();
+                    const MappedFile file = MappedFile::Open(result.m_output);
+                    const LevelFormat::Header& header = OpenLevel(file.GetData());
+                    KT_VERIFY(header.m_transforms.m_count == result.m_instanceCount, "%s: instance count mismatch", result.m_output.string().c_str());
+                    Log::Verbose(
+                        "%s: loaded in place in %.3fms",
+                        result.m_output.string().c_str(),
+                        std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - loadStart).count());
+                }
+            });
+        }
+        jobSystem.Wait(group);
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Baked %zu levels (%llu instances, %.2f MiB, %llu from cache) in %.3fs on %u workers",
+            commandLine.GetPositionals().size(),
+            static_cast<unsigned long long>(instanceCount.load()),
+            f64(size.load()) / (1024.0 * 1024.0),
+            static_cast<unsigned long long>(cacheHitCount.load()),
+            seconds,
+            jobSystem.GetWorkerCount());
+        return 0;
+    });
+}
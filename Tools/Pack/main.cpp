@@ -0,0 +1,238 @@
+#include <chrono>
+#include <optional>
+#include <unordered_set>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Hash.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/MappedFile.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Pack/PackArchive.hpp"
+#include "KryneTools/Pack/PackBuilder.hpp"
+#include "KryneTools/Texture/PerceptualHash.hpp"
+#include "KryneTools/Texture/TextureReader.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    void ListArchive(const std::filesystem::path& _path, bool _verify)
+    {
+        const PackArchive archive = PackArchive::Open(_path);
+        for (const PackFormat::EntryRecord& entry: archive.GetEntries())
+        {
+            if (_verify)
+            {
+                (void)archive.Read(entry);
+            }
+            const std::string_view name = archive.GetName(entry);
+            Log::Info(
+                "%12llu %12llu %-4s %10llx %.*s",
+                static_cast<unsigned long long>(entry.m_size),
+                static_cast<unsigned long long>(entry.m_storedSize),
+                GetCompressionMethodName(CompressionMethod(entry.m_compression)),
+                static_cast<unsigned long long>(entry.m_offset),
+                int(name.size()),
+                name.data());
+        }
+        Log::Info("%s: %zu entries%s", _path.string().c_str(), archive.GetEntries().size(), _verify ? ", all verified" : "");
+    }
+
+    struct TextureSignature
+    {
+        const PackInput* m_input = nullptr;
+        u64 m_contentHash = 0;
+        std::optional<PerceptualSignature> m_signature;
+    };
+
+    /// Logs the `.ktex` inputs that look alike without being identical, which the pack stores twice.
+    void ReportNearDuplicateTextures(JobSystem& _jobSystem, std::span<const PackInput> _inputs, u32 _maxDistance)
+    {
+        constexpr size_t kMaxReportedPairs = 20;
+
+        std::vector<TextureSignature> textures;
+        for (const PackInput& input: _inputs)
+        {
+            if (input.m_path.extension() == ".ktex")
+            {
+                textures.emplace_back().m_input = &input;
+            }
+        }
+        _jobSystem.ParallelFor(textures.size(), 1, [&](u64 _begin, u64 _end)
+        {
+            for (u64 i = _begin; i < _end; i++)
+            {
+                TextureSignature& texture = textures[i];
+                try
+                {
+                    texture.m_contentHash = Hash64(MappedFile::Open(texture.m_input->m_path).GetData());
+                    texture.m_signature = ComputePerceptualSignature(ReadKtex(texture.m_input->m_path).m_texture);
+                }
+                catch (const Error& exception)
+                {
+                    Log::Warning("Skipping the near-duplicate check of %s: %s", texture.m_input->m_name.c_str(), exception.what());
+                }
+            }
+        });
+
+        // Byte-identical textures are merged by the pack already, only the first of each is compared.
+        std::unordered_set<u64> contentHashes;
+        std::erase_if(textures, [&](const TextureSignature& _texture)
+        {
+            return !_texture.m_signature.has_value() || !contentHashes.insert(_texture.m_contentHash).second;
+        });
+
+        size_t pairCount = 0;
+        for (size_t a = 0; a < textures.size(); a++)
+        {
+            for (size_t b = a + 1; b < textures.size(); b++)
+            {
+                if (!IsNearDuplicate(*textures[a].m_signature, *textures[b].m_signature, _maxDistance))
+                {
+                    continue;
+                }
+                const std::string message = FormatString(
+                    "Near-duplicate textures: %s and %s (%u bits apart)",
+                    textures[a].m_input->m_name.c_str(),
+                    textures[b].m_input->m_name.c_str(),
+                    GetPerceptualDistance(*textures[a].m_signature, *textures[b].m_signature));
+                if (pairCount++ < kMaxReportedPairs)
+                {
+                    Log::Info("%s", message.c_str());
+                }
+                else
+                {
+                    Log::Verbose("%s", message.c_str());
+                }
+            }
+        }
+        if (pairCount > kMaxReportedPairs)
+        {
+            Log::Info("... %zu near-duplicate texture pairs in total, --verbose lists them all", pairCount);
+        }
+    }
+}
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-pack", [&]
+    {
+        std::string output;
+        std::string root;
+        u32 jobCount = 0;
+        std::string compressionName = "lz4";
+        bool high = false;
+        bool compressGpuData = false;
+        PackSettings settings;
+        bool list = false;
+        bool verify = false;
+        bool verbose = false;
+        bool noDeduplication = false;
+        u32 nearDuplicateDistance = 10;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-pack", "[options] <file|directory>... | --list <archive.kpak>");
+        commandLine.AddOption("o", "Output archive", &output);
+        commandLine.AddOption("root", "Entry names are relative to this directory, instead of each directory input", &root);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("compression", "Entry compression: lz4 (default), zstd or none", &compressionName);
+        commandLine.AddFlag("high", "Slower, denser compression", &high);
+        commandLine.AddFlag("compress-gpu-data", "Also compress .ktex and .dds entries, stored uncompressed by default", &compressGpuData);
+        commandLine.AddOption("alignment", "Entry alignment, 4096 by default", &settings.m_alignment);
+        commandLine.AddOption("large-alignment", "Alignment of entries of 64 KiB or more, 65536 by default", &settings.m_largeAlignment);
+        commandLine.AddFlag("no-dedup", "Store every input, even byte-identical ones, and skip the near-duplicate texture report", &noDeduplication);
+        commandLine.AddOption("near-duplicate-distance", "Hash bits two textures may differ by to be reported alike, 10 by default", &nearDuplicateDistance);
+        commandLine.AddFlag("list", "List the entries of archives", &list);
+        commandLine.AddFlag("verify", "With --list, decompress every entry and check its content hash", &verify);
+        commandLine.AddFlag("verbose", "Print per entry details", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty() || (!list && output.empty()))
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        if (list)
+        {
+            for (const std::string& archive: commandLine.GetPositionals())
+            {
+                ListArchive(archive, verify);
+            }
+            return 0;
+        }
+
+        const std::optional<CompressionMethod> compression = ParseCompressionMethod(compressionName);
+        KT_VERIFY(compression.has_value(), "Unknown compression '%s', expected lz4, zstd or none", compressionName.c_str());
+        settings.m_compression = *compression;
+        settings.m_highCompression = high;
+        settings.m_deduplicate = !noDeduplication;
+        if (compressGpuData)
+        {
+            settings.m_uncompressedExtensions.clear();
+        }
+
+        std::vector<PackInput> inputs;
+        for (const std::filesystem::path input: commandLine.GetPositionals())
+        {
+            if (std::filesystem::is_directory(input))
+            {
+                CollectPackInputs(input, root.empty() ? input : std::filesystem::path(root), inputs);
+            }
+            else
+            {
+                KT_VERIFY(std::filesystem::is_regular_file(input), "No such file or directory '%s'", input.string().c_str());
+                const std::filesystem::path name = root.empty() ? input.filename() : input.lexically_relative(root);
+                inputs.push_back({ name.generic_string(), input });
+            }
+        }
+
+        cacheSettings.ResolveOptions();
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+        settings.m_cache = &cache;
+        const PackStatistics statistics = BuildPack(jobSystem, output, inputs, settings);
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Packed %u entries (%u compressed) to %s: %.2f MiB -> %.2f MiB stored, %.2f MiB file%s, in %.3fs on %u workers",
+            statistics.m_entryCount,
+            statistics.m_compressedEntryCount,
+            output.c_str(),
+            f64(statistics.m_inputSize) / f64(1 << 20),
+            f64(statistics.m_storedSize) / f64(1 << 20),
+            f64(statistics.m_fileSize) / f64(1 << 20),
+            statistics.m_cacheHit ? " from cache" : "",
+            seconds,
+            jobSystem.GetWorkerCount());
+        if (statistics.m_duplicateEntryCount > 0)
+        {
+            Log::Info(
+                "%u entries share the data of an identical one, saving %.2f MiB",
+                statistics.m_duplicateEntryCount,
+                f64(statistics.m_duplicateSize) / f64(1 << 20));
+        }
+        if (settings.m_deduplicate)
+        {
+            ReportNearDuplicateTextures(jobSystem, inputs, nearDuplicateDistance);
+        }
+        return 0;
+    });
+}
@@ -0,0 +1,125 @@
+#include <charconv>
+
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Pipeline/PipelineCacheBuilder.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    void ListDevices()
+    {
+        for (const PipelineDeviceInfo& device: EnumeratePipelineDevices())
+        {
+            Log::Info(
+                "%u: %s (%04x:%04x, driver %08x)%s -> %s",
+                device.m_index,
+                device.m_name.c_str(),
+                device.m_vendorId,
+                device.m_deviceId,
+                device.m_driverVersion,
+                device.m_software ? ", software" : "",
+                GetPipelineCacheFileName(device.m_vendorId, device.m_deviceId).c_str());
+        }
+    }
+}
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-pipecache", [&]
+    {
+        std::string outputDirectory;
+        std::string shaderDirectory;
+        u32 jobCount = 0;
+        std::vector<std::string> devices;
+        PipelineCacheSettings settings;
+        bool noValidate = false;
+        bool requireValidation = false;
+        bool listDevices = false;
+        bool verbose = false;
+        TraceSettings traceSettings;
+
+        CommandLine commandLine("kryne-pipecache", "[options] <materials.json> | --list-devices");
+        commandLine.AddOption("o", "Output directory, defaults to the directory of the manifest", &outputDirectory);
+        commandLine.AddOption("shaders", "Directory of the .kshd files, overrides the manifest shader_directory", &shaderDirectory);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("device", "Vulkan device index (repeatable), every hardware device by default", &devices);
+        commandLine.AddOption("batch-size", "Pipelines per creation call, 16 by default", &settings.m_batchSize);
+        commandLine.AddFlag("no-validate", "Skip the replay of the pipelines against the written caches", &noValidate);
+        commandLine.AddFlag("require-validation", "Fail on devices whose replay cannot detect misses, they pass unchecked otherwise", &requireValidation);
+        commandLine.AddFlag("list-devices", "List the Vulkan 1.3 devices and their cache file names", &listDevices);
+        commandLine.AddFlag("verbose", "Print per device details", &verbose);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (listDevices)
+        {
+            ListDevices();
+            return 0;
+        }
+        if (commandLine.GetPositionals().size() != 1)
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        for (const std::string& device: devices)
+        {
+            u32 index = 0;
+            const auto [end, error] = std::from_chars(device.data(), device.data() + device.size(), index);
+            KT_VERIFY(error == std::errc() && end == device.data() + device.size(), "Invalid device index '%s'", device.c_str());
+            settings.m_devices.push_back(index);
+        }
+        KT_VERIFY(!(noValidate && requireValidation), "--no-validate and --require-validation are exclusive");
+        settings.m_validate = !noValidate;
+
+        const std::filesystem::path manifestPath = commandLine.GetPositionals()[0];
+        MaterialManifest manifest = LoadMaterialManifest(manifestPath);
+        if (!shaderDirectory.empty())
+        {
+            manifest.m_shaderDirectory = shaderDirectory;
+        }
+        settings.m_outputDirectory = outputDirectory.empty() ? manifestPath.parent_path() : std::filesystem::path(outputDirectory);
+
+        JobSystem jobSystem(jobCount);
+        const std::vector<PipelineCacheResult> results = BuildPipelineCaches(jobSystem, manifest, settings);
+
+        u32 missCount = 0;
+        u32 uncheckedCount = 0;
+        for (const PipelineCacheResult& result: results)
+        {
+            const char* validation = !settings.m_validate ? "not validated" : (result.m_validated ? (result.m_missCount == 0 ? "validated" : "INCOMPLETE") : "replay check unsupported");
+            Log::Info(
+                "%s: %u pipelines, %.2f KiB in %.3fs on %u workers, %s -> %s",
+                result.m_device.m_name.c_str(),
+                result.m_pipelineCount,
+                f64(result.m_size) / 1024.0,
+                result.m_buildSeconds,
+                jobSystem.GetWorkerCount(),
+                validation,
+                result.m_path.string().c_str());
+            if (result.m_missCount > 0)
+            {
+                Log::Warning("%s: %u pipelines still need a compile with the cache", result.m_device.m_name.c_str(), result.m_missCount);
+            }
+            missCount += result.m_missCount;
+            uncheckedCount += settings.m_validate && !result.m_validated ? 1 : 0;
+        }
+        KT_VERIFY(missCount == 0, "Pipeline cache validation failed");
+        KT_VERIFY(!requireValidation || uncheckedCount == 0, "%u devices cannot replay the pipelines to check the caches", uncheckedCount);
+        return 0;
+    });
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Shader/ShaderCooker.hpp"
+
+using namespace KryneTools;
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-shaderc", [&]
+    {
+        std::string outputDirectory;
+        u32 jobCount = 0;
+        std::vector<std::string> includeDirectories;
+        std::string reflectionDirectory;
+        ShaderCookSettings settings;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-shaderc", "[options] <manifest.json>...");
+        commandLine.AddOption("o", "Output directory, defaults to the directory of each manifest", &outputDirectory);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("I", "Include directory, searched after those of the manifest (repeatable)", &includeDirectories);
+        commandLine.AddOption("reflection", "Also write C++ headers with the constexpr resource layouts of each shader to this directory", &reflectionDirectory);
+        commandLine.AddOption("glslang", "glslang executable, glslangValidator by default", &settings.m_compiler.m_glslangPath);
+        commandLine.AddOption("dxc", "DXC executable, dxc by default", &settings.m_compiler.m_dxcPath);
+        commandLine.AddOption("target-env", "Vulkan target environment, vulkan1.2 by default", &settings.m_compiler.m_targetEnvironment);
+        commandLine.AddOption("shader-model", "HLSL shader model, 6_0 by default", &settings.m_compiler.m_shaderModel);
+        commandLine.AddFlag("debug", "Keep debug information in the SPIR-V", &settings.m_compiler.m_debugInfo);
+        commandLine.AddFlag("verbose", "Print every compiled permutation", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty())
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+        cacheSettings.ResolveOptions();
+        settings.m_includeDirectories.assign(includeDirectories.begin(), includeDirectories.end());
+        settings.m_reflectionDirectory = reflectionDirectory;
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+        settings.m_cache = &cache;
+
+        ShaderCookStatistics total;
+        for (const std::filesystem::path manifestPath: commandLine.GetPositionals())
+        {
+            const ShaderManifest manifest = LoadShaderManifest(manifestPath);
+            ShaderCookSettings manifestSettings = settings;
+            manifestSettings.m_outputDirectory = outputDirectory.empty() ? manifestPath.parent_path() : std::filesystem::path(outputDirectory);
+            const ShaderCookStatistics statistics = CookShaders(jobSystem, manifest, manifestSettings);
+            total.m_permutationCount += statistics.m_permutationCount;
+            total.m_uniqueSourceCount += statistics.m_uniqueSourceCount;
+            total.m_compiledCount += statistics.m_compiledCount;
+            total.m_cacheHitCount += statistics.m_cacheHitCount;
+            total.m_moduleCount += statistics.m_moduleCount;
+            total.m_outputs.insert(total.m_outputs.end(), statistics.m_outputs.begin(), statistics.m_outputs.end());
+        }
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Cooked %zu shaders: %llu permutations, %llu distinct sources (%llu compiled, %llu from cache), %llu modules in %.3fs on %u workers",
+            total.m_outputs.size(),
+            static_cast<unsigned long long>(total.m_permutationCount),
+            static_cast<unsigned long long>(total.m_uniqueSourceCount),
+            static_cast<unsigned long long>(total.m_compiledCount),
+            static_cast<unsigned long long>(total.m_cacheHitCount),
+            static_cast<unsigned long long>(total.m_moduleCount),
+            seconds,
+            jobSystem.GetWorkerCount());
+        return 0;
+    });
+}
@@ -0,0 +1,149 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Texture/GpuTextureCompressor.hpp"
+#include "KryneTools/Texture/TextureCooker.hpp"
+
+using namespace KryneTools;
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-texcook", [&]
+    {
+        std::string outputDirectory;
+        u32 jobCount = 0;
+        std::string formatName = "bc7";
+        std::string qualityName = "fast";
+        std::string containerName = "ktex";
+        bool linear = false;
+        bool normalMap = false;
+        bool noMips = false;
+        bool statistics = false;
+        bool gpu = false;
+        u32 gpuDevice = ~0u;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-texcook", "[options] <input.png|input.tga|input.ppm>...");
+        commandLine.AddOption("o", "Output directory, defaults to the directory of each input", &outputDirectory);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("format", "Block format: bc1, bc3, bc4, bc5, bc7 (default) or astc (4x4)", &formatName);
+        commandLine.AddOption("quality", "Encoder effort: fast (default) or high", &qualityName);
+        commandLine.AddOption("container", "Output file: ktex (default, streamable) or dds", &containerName);
+        commandLine.AddFlag("linear", "Treat color as linear data instead of sRGB", &linear);
+        commandLine.AddFlag("normal-map", "Input is a tangent space normal map, implies --linear", &normalMap);
+        commandLine.AddFlag("no-mips", "Only compress the top level", &noMips);
+        commandLine.AddFlag("stats", "Print the PSNR of every mip, bypassing the cache", &statistics);
+        commandLine.AddFlag("gpu", "Generate mips and encode BC formats at fast quality with Vulkan compute, if available", &gpu);
+        commandLine.AddOption("gpu-device", "Vulkan device index for --gpu, defaults to the first discrete GPU", &gpuDevice);
+        commandLine.AddFlag("verbose", "Print per texture details", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty())
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        const std::optional<TextureFormat> format = ParseTextureFormat(formatName);
+        KT_VERIFY(format.has_value(), "Unknown texture format '%s'", formatName.c_str());
+        const std::optional<TextureContainer> container = ParseTextureContainer(containerName);
+        KT_VERIFY(container.has_value(), "Unknown container '%s', expected ktex or dds", containerName.c_str());
+        KT_VERIFY(qualityName == "fast" || qualityName == "high", "Unknown quality '%s', expected fast or high", qualityName.c_str());
+        cacheSettings.ResolveOptions();
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+
+        // A missing device is not fatal, the CPU encoders produce the reference output anyway.
+        std::unique_ptr<GpuTextureCompressor> gpuCompressor;
+        if (gpu || gpuDevice != ~0u)
+        {
+            try
+            {
+                gpuCompressor = GpuTextureCompressor::Create(gpuDevice != ~0u ? std::optional(gpuDevice) : std::nullopt);
+                Log::Info("Cooking on %s", gpuCompressor->GetDeviceName().c_str());
+            }
+            catch (const Error& exception)
+            {
+                Log::Warning("GPU cooking unavailable, cooking on the CPU: %s", exception.what());
+            }
+        }
+
+        std::atomic<u64> texelCount = 0;
+        std::atomic<u64> cacheHitCount = 0;
+
+        // Inputs are jobs too, their tiles fill the pool together.
+        JobGroup group;
+        for (const std::string& input: commandLine.GetPositionals())
+        {
+            jobSystem.Spawn(group, [&, input]
+            {
+                TextureCookSettings settings;
+                settings.m_input = input;
+                settings.m_outputDirectory = outputDirectory;
+                settings.m_format = *format;
+                settings.m_quality = qualityName == "high" ? EncodeQuality::High : EncodeQuality::Fast;
+                settings.m_container = *container;
+                settings.m_srgb = !linear && !normalMap;
+                settings.m_normalMap = normalMap;
+                settings.m_generateMips = !noMips;
+                settings.m_computeStatistics = statistics;
+                settings.m_gpu = gpuCompressor.get();
+                settings.m_cache = statistics ? nullptr : &cache;
+
+                const TextureCookResult result = CookTexture(jobSystem, settings);
+                cacheHitCount += result.m_cacheHit ? 1 : 0;
+                Log::Verbose(
+                    "%s: %ux%u, %zu mips, %s%s",
+                    result.m_output.string().c_str(),
+                    result.m_width,
+                    result.m_height,
+                    result.m_mips.size(),
+                    GetTextureFormatName(*format),
+                    result.m_cacheHit ? " (cache)" : "");
+                for (size_t m = 0; m < result.m_mips.size(); m++)
+                {
+                    const CompressedMip& mip = result.m_mips[m];
+                    texelCount += u64(mip.m_width) * mip.m_height;
+                    if (statistics)
+                    {
+                        Log::Info("%s: mip %zu %ux%u PSNR %.2f dB", result.m_output.string().c_str(), m, mip.m_width, mip.m_height, mip.m_psnr);
+                    }
+                }
+            });
+        }
+        jobSystem.Wait(group);
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Cooked %zu textures (%.2f Mtexels, %llu from cache) to %s in %.3fs on %u workers",
+            commandLine.GetPositionals().size(),
+            f64(texelCount.load()) / 1e6,
+            static_cast<unsigned long long>(cacheHitCount.load()),
+            GetTextureFormatName(*format),
+            seconds,
+            jobSystem.GetWorkerCount());
+        return 0;
+    });
+}
@@ -0,0 +1,142 @@
+#include <chrono>
+#include <string_view>
+
+#include "KryneTools/Cache/ContentCache.hpp"
+#include "KryneTools/Common/CommandLine.hpp"
+#include "KryneTools/Common/Error.hpp"
+#include "KryneTools/Common/Log.hpp"
+#include "KryneTools/Common/Tool.hpp"
+#include "KryneTools/Common/Trace.hpp"
+#include "KryneTools/Jobs/JobSystem.hpp"
+#include "KryneTools/Texture/VirtualTextureBuilder.hpp"
+
+using namespace KryneTools;
+
+namespace
+{
+    /// `path[:format][:normal-map|:linear]`, options are taken from the end so paths may contain colons.
+    VirtualTextureLayer ParseLayer(std::string_view _argument, TextureFormat _defaultFormat)
+    {
+        VirtualTextureLayer layer;
+        layer.m_format = _defaultFormat;
+        bool formatSet = false;
+        while (true)
+        {
+            const size_t colon = _argument.rfind(':');
+            if (colon == std::string_view::npos)
+            {
+                break;
+            }
+            const std::string_view option = _argument.substr(colon + 1);
+            const std::optional<TextureFormat> format = ParseTextureFormat(option);
+            if (format.has_value() && !formatSet)
+            {
+                layer.m_format = *format;
+                formatSet = true;
+            }
+            else if (option == "normal-map")
+            {
+                layer.m_normalMap = true;
+                layer.m_srgb = false;
+            }
+            else if (option == "linear")
+            {
+                layer.m_srgb = false;
+            }
+            else
+            {
+                break;
+            }
+            _argument = _argument.substr(0, colon);
+        }
+        layer.m_input = _argument;
+        return layer;
+    }
+}
+
+int main(int _argc, char** _argv)
+{
+    return RunTool("kryne-vtex", [&]
+    {
+        std::string output;
+        u32 jobCount = 0;
+        std::string formatName = "bc7";
+        std::string qualityName = "fast";
+        VirtualTextureSettings settings;
+        bool wrap = false;
+        bool verbose = false;
+        TraceSettings traceSettings;
+        ContentCacheSettings cacheSettings;
+
+        CommandLine commandLine("kryne-vtex", "[options] <layer.png|layer.tga|layer.ppm>[:format][:normal-map|:linear]...");
+        commandLine.AddOption("o", "Output page file, defaults to the first layer with the .kvt extension", &output);
+        commandLine.AddOption("j", "Worker thread count, defaults to the hardware thread count", &jobCount);
+        commandLine.AddOption("format", "Block format of the layers not naming one: bc1, bc3, bc4, bc5, bc7 (default) or astc", &formatName);
+        commandLine.AddOption("quality", "Encoder effort: fast (default) or high", &qualityName);
+        commandLine.AddOption("page-size", "Page side in texels without borders, a power of two, 128 by default", &settings.m_pageSize);
+        commandLine.AddOption("border", "Border texels on each side of a page, 4 by default", &settings.m_border);
+        commandLine.AddOption("page-alignment", "Alignment of the pages in the file, 4096 by default", &settings.m_pageAlignment);
+        commandLine.AddFlag("wrap", "Wrap borders around the texture edges, for tiling textures, instead of clamping", &wrap);
+        commandLine.AddFlag("verbose", "Print page statistics", &verbose);
+        cacheSettings.RegisterOptions(commandLine);
+        traceSettings.RegisterOptions(commandLine);
+        if (!commandLine.Parse(_argc, _argv))
+        {
+            return commandLine.GetExitCode();
+        }
+        if (commandLine.GetPositionals().empty())
+        {
+            commandLine.PrintUsage();
+            return 2;
+        }
+        if (verbose)
+        {
+            Log::SetLevel(Log::Level::Verbose);
+        }
+        traceSettings.ResolveOptions();
+        const TraceSession traceSession(traceSettings);
+
+        cacheSettings.ResolveOptions();
+
+        const std::optional<TextureFormat> format = ParseTextureFormat(formatName);
+        KT_VERIFY(format.has_value(), "Unknown texture format '%s'", formatName.c_str());
+        KT_VERIFY(qualityName == "fast" || qualityName == "high", "Unknown quality '%s', expected fast or high", qualityName.c_str());
+        for (const std::string& argument: commandLine.GetPositionals())
+        {
+            settings.m_layers.push_back(ParseLayer(argument, *format));
+        }
+        settings.m_output = output;
+        settings.m_addressMode = wrap ? VirtualTextureFileFormat::AddressMode::Wrap : VirtualTextureFileFormat::AddressMode::Clamp;
+        settings.m_quality = qualityName == "high" ? EncodeQuality::High : EncodeQuality::Fast;
+
+        const auto start = std::chrono::steady_clock::now();
+        JobSystem jobSystem(jobCount);
+        ContentCache cache(cacheSettings);
+        settings.m_cache = &cache;
+        const VirtualTextureResult result = BuildVirtualTexture(jobSystem, settings);
+        for (const VirtualTextureLayer& layer: settings.m_layers)
+        {
+            Log::Verbose(
+                "%s: %s%s",
+                layer.m_input.string().c_str(),
+                GetTextureFormatName(layer.m_format),
+                layer.m_normalMap ? " normal map" : layer.m_srgb ? " sRGB" : "");
+        }
+
+        const f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        Log::Info(
+            "Paged %ux%u (%u mips, %zu layers) to %s: %llu pages, %u stored, %.2f MiB%s in %.3fs on %u workers",
+            result.m_width,
+            result.m_height,
+            result.m_mipCount,
+            settings.m_layers.size(),
+            result.m_output.string().c_str(),
+            static_cast<unsigned long long>(result.m_pageCount),
+            result.m_physicalPageCount,
+            f64(result.m_size) / (1024.0 * 1024.0),
+            result.m_cacheHit ? " from cache" : "",
+            seconds,
+            jobSystem.GetWorkerCount());
+        return 0;
+    });
+}
@@ -0,0 +1,42 @@
+# Script mode: cmake -DSOURCE_DIR=<dir> -DOUTPUT=<file> -DVERSION=<version> -P GenerateBuildId.cmake
+#
+# Writes the translation unit defining the tools build ID, used to key the content cache. The ID is the project version
+# followed by the git revision and, on modified working trees, a digest of the local changes. The file is only
+# rewritten when the ID changes, so it does not trigger needless rebuilds.
+
+set(BUILD_ID "${VERSION}")
+
+find_package(Git QUIET)
+if (GIT_FOUND)
+    execute_process(
+        COMMAND "${GIT_EXECUTABLE}" rev-parse HEAD
+        WORKING_DIRECTORY "${SOURCE_DIR}"
+        OUTPUT_VARIABLE GIT_REVISION
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET
+        RESULT_VARIABLE GIT_RESULT)
+
+    if (GIT_RESULT EQUAL 0)
+        string(APPEND BUILD_ID "-${GIT_REVISION}")
+
+        execute_process(
+            COMMAND "${GIT_EXECUTABLE}" diff HEAD --no-ext-diff
+            WORKING_DIRECTORY "${SOURCE_DIR}"
+            OUTPUT_VARIABLE GIT_DIFF
+            ERROR_QUIET)
+        if (NOT GIT_DIFF STREQUAL "")
+            string(SHA1 GIT_DIFF_HASH "${GIT_DIFF}")
+            string(SUBSTRING "${GIT_DIFF_HASH}" 0 12 GIT_DIFF_HASH)
+            string(APPEND BUILD_ID "-dirty.${GIT_DIFF_HASH}")
+        endif()
+    endif()
+endif()
+
+set(CONTENT "// Generated by cmake/GenerateBuildId.cmake, do not edit.\n#include \"KryneTools/Common/BuildId.hpp\"\n\nconst char* KryneTools::GetBuildId()\n{\n    return \"${BUILD_ID}\";\n}\n")
+
+if (EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" PREVIOUS_CONTENT)
+endif()
+if (NOT "${CONTENT}" STREQUAL "${PREVIOUS_CONTENT}")
+    file(WRITE "${OUTPUT}" "${CONTENT}")
+endif()
@@ -0,0 +1,33 @@
+# Shared helpers for every library and tool target of the repository.
+
+function(kryne_tools_configure_target target)
+    if (MSVC)
+        target_compile_options(${target} PRIVATE /W4 /permissive-)
+        target_compile_definitions(${target} PRIVATE _CRT_SECURE_NO_WARNINGS NOMINMAX WIN32_LEAN_AND_MEAN)
+    else()
+        target_compile_options(${target} PRIVATE -Wall -Wextra -Wpedantic)
+    endif()
+endfunction()
+
+# kryne_tools_add_library(<name> SOURCES <files...> [DEPENDENCIES <targets...>])
+#
+# Libraries follow the Include/KryneTools/<Module> + Src layout, and are exposed as KryneTools::<name>.
+function(kryne_tools_add_library name)
+    cmake_parse_arguments(ARG "" "" "SOURCES;DEPENDENCIES;PRIVATE_DEPENDENCIES" ${ARGN})
+
+    add_library(KryneTools${name} STATIC ${ARG_SOURCES})
+    add_library(KryneTools::${name} ALIAS KryneTools${name})
+
+    target_include_directories(KryneTools${name} PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/Include")
+    target_link_libraries(KryneTools${name} PUBLIC ${ARG_DEPENDENCIES} PRIVATE ${ARG_PRIVATE_DEPENDENCIES})
+    kryne_tools_configure_target(KryneTools${name})
+endfunction()
+
+# kryne_tools_add_executable(<name> SOURCES <files...> [DEPENDENCIES <targets...>])
+function(kryne_tools_add_executable name)
+    cmake_parse_arguments(ARG "" "" "SOURCES;DEPENDENCIES" ${ARGN})
+
+    add_executable(${name} ${ARG_SOURCES})
+    target_link_libraries(${name} PRIVATE ${ARG_DEPENDENCIES})
+    kryne_tools_configure_target(${name})
+endfunction()